@@ -71,6 +71,10 @@ declare -i argc=$#
 # | egressif bypass rules | olsrif bypass rules | sgwsrvtun rule  | egressif rules  | sgwtun rules  |
 # +-----------------------+---------------------+-----------------+-----------------+---------------+
 # Example:  84 85               86 87 88 89             90               91 92            93 94 ...
+#
+# olsrd sets up the ip rules itself. The script only sets up the iptables
+# connection marking that the fwmark ip rules rely on, it is required in
+# multi-gateway mode and olsrd does not start when it fails.
 
 
 ###############################################################################
@@ -192,10 +196,8 @@ function generic() {
 }
 
 function olsrif() {
-  local interfaceName="$1"
-  local bypassRuleNr="$2"
-
-  "$IP"       $IP_ARGS        rule      "$ADDMODE_IP" iif    "$interfaceName" table main       priority "$bypassRuleNr"
+  # the bypass ip rule is setup by olsrd
+  :
 }
 
 function egressif() {
@@ -206,8 +208,6 @@ function egressif() {
 
   "$IPTABLES" $IPTABLES_ARGS -t mangle "$ADDMODE_IPTABLES" POSTROUTING -m conntrack --ctstate NEW -o "$interfaceName" -j CONNMARK --set-mark "$ruleNr"
   "$IPTABLES" $IPTABLES_ARGS -t mangle "$ADDMODE_IPTABLES" INPUT       -m conntrack --ctstate NEW -i "$interfaceName" -j CONNMARK --set-mark "$ruleNr"
-  "$IP"       $IP_ARGS       rule      "$ADDMODE_IP" fwmark "$ruleNr"        table "$tableNr" priority "$ruleNr"
-  "$IP"       $IP_ARGS       rule      "$ADDMODE_IP" iif    "$interfaceName" table main       priority "$bypassRuleNr"
 }
 
 function sgwsrvtun() {
@@ -216,8 +216,6 @@ function sgwsrvtun() {
   local ruleNr="$3"
 
   "$IPTABLES" $IPTABLES_ARGS -t mangle "$ADDMODE_IPTABLES" PREROUTING  -m conntrack --ctstate NEW -i "$interfaceName" -j CONNMARK --set-mark "$ruleNr"
-  "$IP"       $IP_ARGS       rule      "$ADDMODE_IP" iif    "$interfaceName" table "$tableNr" priority "$ruleNr"
-  "$IP"       $IP_ARGS       rule      "$ADDMODE_IP" fwmark "$ruleNr"        table "$tableNr" priority "$ruleNr"
 }
 
 function sgwtun() {
@@ -226,7 +224,6 @@ function sgwtun() {
   local ruleNr="$3"
 
   "$IPTABLES" $IPTABLES_ARGS -t mangle "$ADDMODE_IPTABLES" POSTROUTING -m conntrack --ctstate NEW -o "$interfaceName" -j CONNMARK --set-mark "$ruleNr"
-  "$IP"       $IP_ARGS       rule      "$ADDMODE_IP" fwmark "$ruleNr" table "$tableNr" priority "$ruleNr"
 }
 
 
@@ -315,18 +312,13 @@ fi
 # process ipVersion argument
 declare IPTABLES="iptables"
 declare IPTABLES_ARGS="-w"
-declare IP="ip"
-declare IP_ARGS="-4"
 if [ "$ipVersion" = "$IPVERSION_6" ]; then
   IPTABLES="ip6tables"
   IPTABLES_ARGS="-w"
-  IP="ip"
-  IP_ARGS="-6"
 fi
 
 # process addMode argument
 declare ADDMODE_IPTABLES="-D"
-declare ADDMODE_IP="delete"
 if [ "$addMode" = "$ADDMODE_ADD" ]; then
   # first call the delete mode to remove any left-over rules
   set +e
@@ -334,7 +326,6 @@ if [ "$addMode" = "$ADDMODE_ADD" ]; then
   set -e
 
   ADDMODE_IPTABLES="-I"
-  ADDMODE_IP="add"
 fi
 
 # call the mode
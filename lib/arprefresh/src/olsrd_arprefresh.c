@@ -46,17 +46,21 @@
 /*
  * Plugin to refresh the local ARP cache from received OLSR broadcasts.
  *
+ * The packet socket is drained from the scheduler as packets arrive. The
+ * senders are collected in a table, so a sender that is seen many times is
+ * refreshed only once, and the table is written to the kernel neighbour
+ * table with batches of RTM_NEWNEIGH netlink messages.
+ *
  * Note: this code does not work with IPv6 and not with VLANs (on IPv4 or IPv6)
  */
 
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <errno.h>
 #include <fcntl.h>
-#include <sys/ioctl.h>
 #include <sys/socket.h>
 #include <net/if.h>
-#include <net/if_arp.h>
 #ifndef __ANDROID__
 #include <net/ethernet.h>
 #endif /* __ANDROID__ */
@@ -65,6 +69,9 @@
 #include <netpacket/packet.h>
 #include <linux/types.h>
 #include <linux/filter.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/neighbour.h>
 #include <unistd.h>
 
 #include "olsrd_arprefresh.h"
@@ -72,6 +79,7 @@
 #include "scheduler.h"
 #include "olsr.h"
 #include "builddata.h"
+#include "compiler.h"
 
 #undef ARPREFRESH_DEBUG
 
@@ -109,60 +117,263 @@ typedef struct {
 } __attribute__ ((packed)) arprefresh_buf;
 
 static int arprefresh_sockfd = -1;
+static int arprefresh_nlsockfd = -1;
 static const int arprefresh_portnum = 698;
 
+/* The number of packets that are received with a single recvmmsg call */
+#define ARPREFRESH_RECV_BATCH 32
+
+/* The size of the table of senders, a power of 2 */
+#define ARPREFRESH_TABLE_SIZE 512
+
+/* The table is written to the kernel early when it is this full */
+#define ARPREFRESH_TABLE_FLUSH (ARPREFRESH_TABLE_SIZE / 4 * 3)
+
+/* The number of neighbour messages in a single netlink datagram */
+#define ARPREFRESH_NL_BATCH   64
+
+/* The size of a neighbour message: header, IPv4 address and MAC address */
+#define ARPREFRESH_NL_MSG_SIZE (NLMSG_ALIGN(NLMSG_LENGTH(sizeof(struct ndmsg))) + RTA_SPACE(sizeof(uint32_t)) + RTA_SPACE(ETH_ALEN))
+
+/* A sender seen since the last refresh */
+struct arprefresh_entry {
+  int ifindex;
+  uint32_t addr;
+  unsigned char mac[ETH_ALEN];
+};
+
+/* Open addressing hash table of the senders, ifindex 0 marks a free slot */
+static struct arprefresh_entry arprefresh_table[ARPREFRESH_TABLE_SIZE];
+static unsigned int arprefresh_count = 0;
+
+static void
+arprefresh_addattr(struct nlmsghdr *n, int type, const void *data, int len)
+{
+  struct rtattr *rta = (struct rtattr *)ARM_NOWARN_ALIGN(((char *)n) + NLMSG_ALIGN(n->nlmsg_len));
+  n->nlmsg_len = NLMSG_ALIGN(n->nlmsg_len) + RTA_LENGTH(len);
+  rta->rta_type = type;
+  rta->rta_len = RTA_LENGTH(len);
+  memcpy(RTA_DATA(rta), data, len);
+}
+
 /**
- * Scheduled event to fetch gathered packets and update the ARP cache
- * called from olsrd main thread
+ * Send a batch of neighbour messages and wait for their acknowledgements
+ *
+ * @param buf the messages
+ * @param len the length of the messages
+ * @param count the number of messages
+ * @return false when the netlink socket failed
+ */
+static bool
+arprefresh_send_batch(char *buf, size_t len, unsigned int count)
+{
+  char rcvbuf[4096];
+  struct sockaddr_nl nladdr;
+  struct iovec iov;
+  struct msghdr msg;
+  unsigned int acked = 0;
+
+  memset(&nladdr, 0, sizeof(nladdr));
+  memset(&msg, 0, sizeof(msg));
+  nladdr.nl_family = AF_NETLINK;
+
+  msg.msg_name = &nladdr;
+  msg.msg_namelen = sizeof(nladdr);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  iov.iov_base = buf;
+  iov.iov_len = len;
+  if (sendmsg(arprefresh_nlsockfd, &msg, 0) <= 0) {
+    OLSR_PRINTF(1, "*** ARPREFRESH: RTM_NEWNEIGH: %s\n", strerror(errno));
+    return false;
+  }
+
+  while (acked < count) {
+    struct nlmsghdr *h;
+    int ret;
+
+    iov.iov_base = rcvbuf;
+    iov.iov_len = sizeof(rcvbuf);
+    ret = recvmsg(arprefresh_nlsockfd, &msg, 0);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      OLSR_PRINTF(1, "*** ARPREFRESH: RTM_NEWNEIGH acknowledgement: %s\n", strerror(errno));
+      return false;
+    }
+
+    for (h = (struct nlmsghdr *)ARM_NOWARN_ALIGN(rcvbuf); NLMSG_OK(h, (unsigned int)ret); h = NLMSG_NEXT(h, ret)) {
+      struct nlmsgerr *l_err;
+
+      if (h->nlmsg_type != NLMSG_ERROR || h->nlmsg_len < NLMSG_LENGTH(sizeof(struct nlmsgerr))) {
+        continue;
+      }
+      acked++;
+
+      l_err = (struct nlmsgerr *)NLMSG_DATA(h);
+      if (l_err->error) {
+        OLSR_PRINTF(1, "*** ARPREFRESH: RTM_NEWNEIGH: %s\n", strerror(-l_err->error));
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Write all senders in the table to the kernel neighbour table
+ * and empty the table
  */
 static void
-olsr_arp_event(void *foo __attribute__ ((unused)))
+arprefresh_flush(void)
 {
-  if (0 <= arprefresh_sockfd) {
-    arprefresh_buf buf;
-    struct sockaddr_ll from;
-    socklen_t fromlen = sizeof(from);
-
-    /*
-     * Grab a single snapshot on the packet socket. This only works
-     * if not too much IP traffic is currently flowing through.
-     */
-    ssize_t size = recvfrom(arprefresh_sockfd, &buf, sizeof(buf),
-                            MSG_TRUNC, (struct sockaddr *)&from,
-                            &fromlen);
-
-    if (0 <= size && size >= (ssize_t) sizeof(buf)) {
-      union {
-        struct arpreq arp;
-        struct sockaddr_in in_pa;
-        struct sockaddr_in6 in_pa6;
-      } req;
-
-      memset(&req, 0, sizeof(req));
-      req.in_pa.sin_family = AF_INET;
-      memcpy(&req.in_pa.sin_addr, &buf.ip.saddr, sizeof(buf.ip.saddr));
-      req.arp.arp_ha.sa_family = AF_LOCAL;
-      memcpy(&req.arp.arp_ha.sa_data, &buf.eth.h_source, sizeof(buf.eth.h_source));
-      req.arp.arp_flags = ATF_COM;
-      if_indextoname(from.sll_ifindex, req.arp.arp_dev);
+  char buf[ARPREFRESH_NL_BATCH * ARPREFRESH_NL_MSG_SIZE];
+  size_t len = 0;
+  unsigned int i, batch = 0;
+  bool ok = true;
+
+  if (arprefresh_count == 0) {
+    return;
+  }
+
+  memset(buf, 0, sizeof(buf));
+  for (i = 0; i < ARPREFRESH_TABLE_SIZE && ok; i++) {
+    const struct arprefresh_entry *entry = &arprefresh_table[i];
+    struct nlmsghdr *n;
+    struct ndmsg *ndm;
+
+    if (entry->ifindex == 0) {
+      continue;
+    }
+
 #ifdef ARPREFRESH_DEBUG
-      {
-        int i;
-        OLSR_PRINTF(0, "Refresh on %s, %s=", req.arp.arp_dev, inet_ntoa(*((struct in_addr *)&buf.ip.saddr)));
-        for (i = 0; i < (ssize_t) sizeof(buf.eth.h_source); i++) {
-          OLSR_PRINTF(0, "%02x%s", ((unsigned char *)&buf.eth.h_source)[i],
-                      i < (ssize_t) sizeof(buf.eth.h_source) - 1 ? ":" : "\n");
-        }
+    {
+      char ifname[IF_NAMESIZE];
+      struct in_addr addr;
+      int j;
+
+      addr.s_addr = entry->addr;
+      OLSR_PRINTF(0, "Refresh on %s, %s=", if_indextoname(entry->ifindex, ifname), inet_ntoa(addr));
+      for (j = 0; j < ETH_ALEN; j++) {
+        OLSR_PRINTF(0, "%02x%s", entry->mac[j], j < ETH_ALEN - 1 ? ":" : "\n");
       }
+    }
 #endif /* ARPREFRESH_DEBUG */
-      if (ioctl(arprefresh_sockfd, SIOCSARP, &req) < 0) {
-        OLSR_PRINTF(1, "*** ARPREFRESH: SIOCSARP: %s\n", strerror(errno));
-        close(arprefresh_sockfd);
-        arprefresh_sockfd = -1;
-        return;
-      }
+
+    n = (struct nlmsghdr *)ARM_NOWARN_ALIGN(buf + len);
+    n->nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
+    n->nlmsg_type = RTM_NEWNEIGH;
+    n->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_REPLACE;
+    n->nlmsg_seq = batch;
+
+    /* same as SIOCSARP with ATF_COM, arp_req_set() makes such an entry stale */
+    ndm = NLMSG_DATA(n);
+    ndm->ndm_family = AF_INET;
+    ndm->ndm_ifindex = entry->ifindex;
+    ndm->ndm_state = NUD_STALE;
+
+    arprefresh_addattr(n, NDA_DST, &entry->addr, sizeof(entry->addr));
+    arprefresh_addattr(n, NDA_LLADDR, entry->mac, ETH_ALEN);
+    len += NLMSG_ALIGN(n->nlmsg_len);
+
+    if (++batch == ARPREFRESH_NL_BATCH) {
+      ok = arprefresh_send_batch(buf, len, batch);
+      memset(buf, 0, sizeof(buf));
+      len = 0;
+      batch = 0;
+    }
+  }
+  if (ok && batch > 0) {
+    arprefresh_send_batch(buf, len, batch);
+  }
+
+  memset(arprefresh_table, 0, sizeof(arprefresh_table));
+  arprefresh_count = 0;
+}
+
+/**
+ * Remember the sender of a packet, a sender that is already in
+ * the table gets its MAC address updated
+ */
+static void
+arprefresh_remember(int ifindex, const arprefresh_buf * buf)
+{
+  uint32_t hash = (ntohl(buf->ip.saddr) ^ (uint32_t)ifindex) * 2654435761U;
+  unsigned int i = (hash >> 16) & (ARPREFRESH_TABLE_SIZE - 1);
+
+  for (;;) {
+    struct arprefresh_entry *entry = &arprefresh_table[i];
+
+    if (entry->ifindex == 0) {
+      entry->ifindex = ifindex;
+      entry->addr = buf->ip.saddr;
+      arprefresh_count++;
+    } else if (entry->ifindex != ifindex || entry->addr != buf->ip.saddr) {
+      i = (i + 1) & (ARPREFRESH_TABLE_SIZE - 1);
+      continue;
     }
+    memcpy(entry->mac, buf->eth.h_source, ETH_ALEN);
+    break;
   }
+
+  if (arprefresh_count >= ARPREFRESH_TABLE_FLUSH) {
+    arprefresh_flush();
+  }
+}
+
+/**
+ * Socket handler: drain the packet socket and remember the senders
+ */
+static void
+arprefresh_receive(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  arprefresh_buf bufs[ARPREFRESH_RECV_BATCH];
+  struct sockaddr_ll from[ARPREFRESH_RECV_BATCH];
+  struct iovec iov[ARPREFRESH_RECV_BATCH];
+  struct mmsghdr msgs[ARPREFRESH_RECV_BATCH];
+  int i, n;
+
+  do {
+    memset(msgs, 0, sizeof(msgs));
+    for (i = 0; i < ARPREFRESH_RECV_BATCH; i++) {
+      iov[i].iov_base = &bufs[i];
+      iov[i].iov_len = sizeof(bufs[i]);
+      msgs[i].msg_hdr.msg_name = &from[i];
+      msgs[i].msg_hdr.msg_namelen = sizeof(from[i]);
+      msgs[i].msg_hdr.msg_iov = &iov[i];
+      msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    n = recvmmsg(fd, msgs, ARPREFRESH_RECV_BATCH, MSG_TRUNC | MSG_DONTWAIT, NULL);
+    if (n < 0) {
+#if EWOULDBLOCK == EAGAIN
+      if (errno != EWOULDBLOCK && errno != EINTR) {
+#else /* EWOULDBLOCK == EAGAIN */
+      if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR) {
+#endif /* EWOULDBLOCK == EAGAIN */
+        OLSR_PRINTF(1, "*** ARPREFRESH: recvmmsg: %s\n", strerror(errno));
+      }
+      return;
+    }
+
+    for (i = 0; i < n; i++) {
+      /* MSG_TRUNC: msg_len is the length of the packet */
+      if (msgs[i].msg_len >= sizeof(arprefresh_buf)) {
+        arprefresh_remember(from[i].sll_ifindex, &bufs[i]);
+      }
+    }
+  } while (n == ARPREFRESH_RECV_BATCH);
+}
+
+/**
+ * Scheduled event to update the ARP cache from the gathered senders
+ * called from olsrd main thread
+ */
+static void
+olsr_arp_event(void *foo __attribute__ ((unused)))
+{
+  arprefresh_flush();
 }
 
 /**
@@ -204,9 +415,16 @@ olsrd_plugin_init(void)
         && 0 <= (flags = fcntl(arprefresh_sockfd, F_GETFL))
         && 0 <= fcntl(arprefresh_sockfd, F_SETFL, flags | O_NONBLOCK)
         && 0 <= setsockopt(arprefresh_sockfd, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter))) {
-      /* Register the ARP refresh event */
-      olsr_start_timer(2 * MSEC_PER_SEC, 0, OLSR_TIMER_PERIODIC, &olsr_arp_event, NULL, 0);
-      ret = 1;
+      if (0 <= (arprefresh_nlsockfd = socket(PF_NETLINK, SOCK_DGRAM, NETLINK_ROUTE))) {
+        /* Drain the packet socket as packets arrive */
+        add_olsr_socket(arprefresh_sockfd, &arprefresh_receive, NULL, NULL, SP_PR_READ);
+
+        /* Register the ARP refresh event */
+        olsr_start_timer(2 * MSEC_PER_SEC, 0, OLSR_TIMER_PERIODIC, &olsr_arp_event, NULL, 0);
+        ret = 1;
+      } else {
+        OLSR_PRINTF(1, "*** ARPREFRESH: Cannot create netlink socket: %s\n", strerror(errno));
+      }
     } else {
       OLSR_PRINTF(1, "*** ARPREFRESH: Cannot create non-blocking filtering packet socket: %s\n", strerror(errno));
     }
@@ -237,9 +455,14 @@ static void
 my_fini(void)
 {
   if (0 <= arprefresh_sockfd) {
+    remove_olsr_socket(arprefresh_sockfd, &arprefresh_receive, NULL);
     close(arprefresh_sockfd);
     arprefresh_sockfd = -1;
   }
+  if (0 <= arprefresh_nlsockfd) {
+    close(arprefresh_nlsockfd);
+    arprefresh_nlsockfd = -1;
+  }
 }
 
 /*
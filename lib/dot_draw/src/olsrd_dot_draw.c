@@ -65,6 +65,7 @@
 #include <unistd.h>
 #include <errno.h>
 #include <stdarg.h>
+#include <fcntl.h>
 #endif /* _WRS_KERNEL */
 
 #include "olsr.h"
@@ -79,6 +80,8 @@
 #include "net_olsr.h"
 #include "lq_plugin.h"
 #include "common/autobuf.h"
+#include "common/avl.h"
+#include "common/string_handling.h"
 
 #include "olsrd_dot_draw.h"
 #include "olsrd_plugin.h"
@@ -87,18 +90,55 @@
 #define close(x) closesocket(x)
 #endif /* _WIN32 */
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif /* MSG_NOSIGNAL */
+
 #ifdef _WRS_KERNEL
 static int ipc_open;
 static int ipc_socket_up;
 #define DOT_DRAW_PORT 2004
 #endif /* _WRS_KERNEL */
 
+/*
+ * The graph that was last sent to the front end. Every frame the tables
+ * of olsrd are compared against it, so a frame only carries the edges
+ * that were added, removed or changed their cost.
+ */
+enum dot_edge_type {
+  DOT_EDGE_NEIGH,
+  DOT_EDGE_TC,
+  DOT_EDGE_HNA
+};
+
+struct dot_edge_key {
+  uint8_t type;
+  uint8_t prefix_len;                  /* of an HNA network */
+  union olsr_ip_addr from;
+  union olsr_ip_addr to;
+};
+
+struct dot_edge {
+  struct avl_node node;
+  struct dot_edge_key key;
+  char label[sizeof(struct lqtextbuffer)];
+  bool dashed;                         /* non symmetric neighbor */
+  bool mpr;                            /* neighbor is our MPR */
+  uint32_t frame;                      /* last frame the edge was seen in */
+};
+
+AVLNODE2STRUCT(node2edge, struct dot_edge, node);
+
 static int ipc_socket = -1;
 
 struct autobuf outbuffer;
 static int outbuffer_socket = -1;
 
-static struct timer_entry *writetimer_entry = NULL;
+static struct timer_entry *frametimer_entry = NULL;
+
+static struct avl_tree edge_tree;
+static uint32_t edge_frame;
+static bool frame_dirty;
 
 /* IPC initialization function */
 static int plugin_ipc_init(void);
@@ -108,11 +148,21 @@ static int pcf_event(int, int, int);
 
 static void ipc_action(int, void *, unsigned int);
 
-static void ipc_print_neigh_link(struct autobuf *abuf, const struct neighbor_entry *neighbor);
+static void dotdraw_write_data(int, void *, unsigned int);
 
-static void ipc_print_tc_link(struct autobuf *abuf, const struct tc_entry *, const struct tc_edge_entry *);
+static void dotdraw_frame(void *);
 
-static void ipc_print_net(struct autobuf *abuf, const union olsr_ip_addr *, const union olsr_ip_addr *, uint8_t);
+static void dotdraw_close(void);
+
+static unsigned int dotdraw_collect(bool);
+
+static void ipc_print_edge(struct autobuf *abuf, const char *prefix, const struct dot_edge *);
+
+static int
+edge_comp(const void *a, const void *b)
+{
+  return memcmp(a, b, sizeof(struct dot_edge_key));
+}
 
 /**
  *Do initialization here
@@ -128,6 +178,11 @@ int
 olsrd_plugin_init(void)
 #endif /* _WRS_KERNEL */
 {
+  avl_init(&edge_tree, &edge_comp);
+  if (dot_frame_interval < 10) {
+    dot_frame_interval = 10;
+  }
+
   /* Initial IPC */
   plugin_ipc_init();
 
@@ -148,45 +203,216 @@ void
 olsr_plugin_exit(void)
 #endif /* _WRS_KERNEL */
 {
-  if (writetimer_entry) {
-    close(outbuffer_socket);
-    abuf_free(&outbuffer);
-    olsr_stop_timer(writetimer_entry);
-    writetimer_entry = NULL;
+  if (outbuffer_socket != -1) {
+    dotdraw_close();
   }
   if (ipc_socket != -1) {
     CLOSE(ipc_socket);
   }
 }
 
+/* add the edge to the graph, or update it; returns the edge when it changed */
+static struct dot_edge *
+dotdraw_edge(const struct dot_edge_key *key, const char *label, bool dashed, bool mpr)
+{
+  struct avl_node *node;
+  struct dot_edge *edge;
+
+  node = avl_find(&edge_tree, key);
+  if (node) {
+    edge = node2edge(node);
+    if (edge->frame == edge_frame) {
+      return NULL;              /* listed twice */
+    }
+    edge->frame = edge_frame;
+    if (edge->dashed == dashed && edge->mpr == mpr && strcmp(edge->label, label) == 0) {
+      return NULL;
+    }
+  } else {
+    edge = olsr_malloc(sizeof(*edge), "DOT DRAW edge");
+    memcpy(&edge->key, key, sizeof(edge->key));
+    edge->node.key = &edge->key;
+    edge->frame = edge_frame;
+    avl_insert(&edge_tree, &edge->node, AVL_DUP_NO);
+  }
+
+  strscpy(edge->label, label, sizeof(edge->label));
+  edge->dashed = dashed;
+  edge->mpr = mpr;
+  return edge;
+}
+
 static void
-ipc_print_neigh_link(struct autobuf *abuf, const struct neighbor_entry *neighbor)
+dotdraw_edge_key(struct dot_edge_key *key, enum dot_edge_type type, const union olsr_ip_addr *from, const union olsr_ip_addr *to, uint8_t prefix_len)
 {
-  static const char DASHED[] = "dashed";
-  static const char SOLID[] = "solid";
+  /* compared with memcmp, the padding must be cleared too */
+  memset(key, 0, sizeof(*key));
+  key->type = type;
+  key->prefix_len = prefix_len;
+  key->from = *from;
+  key->to = *to;
+}
 
-  struct ipaddr_str mainaddrstrbuf, strbuf;
-  olsr_linkcost etx = 0.0;
-  const char *style;
-  const char *adr = olsr_ip_to_string(&mainaddrstrbuf, &olsr_cnf->main_addr);
+/**
+ * Bring the graph up to date with the tables of olsrd. With delta the
+ * changed edges are appended to the output buffer.
+ * Returns the number of changed edges.
+ */
+static unsigned int
+dotdraw_collect(bool delta)
+{
+  struct neighbor_entry *neighbor_table_tmp;
+  struct tc_entry *tc;
+  struct tc_edge_entry *tc_edge;
+  struct hna_entry *tmp_hna;
+  struct hna_net *tmp_net;
+  struct ip_prefix_list *hna;
   struct link_entry *the_link;
   struct lqtextbuffer lqbuffer;
+  struct dot_edge_key key;
+  struct avl_node *node, *next;
+  struct dot_edge *edge;
+  unsigned int changes = 0;
+  olsr_linkcost etx;
+
+  edge_frame++;
+
+#define DOT_EDGE(label, dashed, mpr) \
+  if ((edge = dotdraw_edge(&key, (label), (dashed), (mpr))) != NULL) { \
+    changes++; \
+    if (delta) { \
+      ipc_print_edge(&outbuffer, "+ ", edge); \
+    } \
+  }
 
-  if (neighbor->status == 0) {  /* non SYM */
-    style = DASHED;
+  /* Neighbors */
+  OLSR_FOR_ALL_NBR_ENTRIES(neighbor_table_tmp) {
+    etx = 0;
+    if (neighbor_table_tmp->status != 0) {
+      the_link = get_best_link_to_neighbor(&neighbor_table_tmp->neighbor_main_addr);
+      if (the_link) {
+        etx = the_link->linkcost;
+      }
+    }
+    dotdraw_edge_key(&key, DOT_EDGE_NEIGH, &olsr_cnf->main_addr, &neighbor_table_tmp->neighbor_main_addr, 0);
+    DOT_EDGE(get_linkcost_text(etx, false, &lqbuffer), neighbor_table_tmp->status == 0, neighbor_table_tmp->is_mpr);
+  }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(neighbor_table_tmp);
+
+  /* Topology */
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
+      if (tc_edge->edge_inv) {
+        dotdraw_edge_key(&key, DOT_EDGE_TC, &tc->addr, &tc_edge->T_dest_addr, 0);
+        DOT_EDGE(get_linkcost_text(tc_edge->cost, false, &lqbuffer), false, false);
+      }
+    }
+    OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
+  }
+  OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+
+  /* HNA entries */
+  OLSR_FOR_ALL_HNA_ENTRIES(tmp_hna) {
+
+    /* Check all networks */
+    for (tmp_net = tmp_hna->networks.next; tmp_net != &tmp_hna->networks; tmp_net = tmp_net->next) {
+      dotdraw_edge_key(&key, DOT_EDGE_HNA, &tmp_hna->A_gateway_addr, &tmp_net->hna_prefix.prefix, tmp_net->hna_prefix.prefix_len);
+      DOT_EDGE("HNA", false, false);
+    }
+  }
+  OLSR_FOR_ALL_HNA_ENTRIES_END(tmp_hna);
+
+  /* Local HNA entries */
+  for (hna = olsr_cnf->hna_entries; hna != NULL; hna = hna->next) {
+    dotdraw_edge_key(&key, DOT_EDGE_HNA, &olsr_cnf->main_addr, &hna->net.prefix, hna->net.prefix_len);
+    DOT_EDGE("HNA", false, false);
+  }
+
+#undef DOT_EDGE
+
+  /* edges that are gone */
+  for (node = avl_walk_first(&edge_tree); node; node = next) {
+    next = avl_walk_next(node);
+    edge = node2edge(node);
+    if (edge->frame == edge_frame) {
+      continue;
+    }
+
+    changes++;
+    if (delta) {
+      ipc_print_edge(&outbuffer, "- ", edge);
+    }
+    avl_delete(&edge_tree, node);
+    free(edge);
+  }
+
+  return changes;
+}
+
+/**
+ * Append a frame to the output buffer: the whole graph, or with delta
+ * only the edges that changed since the last frame.
+ */
+static void
+dotdraw_render(bool full)
+{
+  struct avl_node *node;
+
+  if (full || !dot_delta) {
+    if (dotdraw_collect(false) == 0 && !full) {
+      return;
+    }
+
+    /* Print tables to IPC socket */
+    abuf_puts(&outbuffer, "digraph topology\n{\n");
+    for (node = avl_walk_first(&edge_tree); node; node = avl_walk_next(node)) {
+      ipc_print_edge(&outbuffer, "", node2edge(node));
+    }
+    abuf_puts(&outbuffer, "}\n\n");
   } else {
-    the_link = get_best_link_to_neighbor(&neighbor->neighbor_main_addr);
-    if (the_link) {
-      etx = the_link->linkcost;
+    abuf_puts(&outbuffer, "delta\n");
+    if (dotdraw_collect(true) == 0) {
+      /* only called with an empty buffer */
+      abuf_pull(&outbuffer, outbuffer.len);
+      return;
     }
-    style = SOLID;
+    abuf_puts(&outbuffer, "end\n\n");
   }
 
-  abuf_appendf(abuf, "\"%s\" -> \"%s\"[label=\"%s\", style=%s];\n", adr, olsr_ip_to_string(&strbuf, &neighbor->neighbor_main_addr),
-               get_linkcost_text(etx, false, &lqbuffer), style);
+  enable_olsr_socket(outbuffer_socket, NULL, &dotdraw_write_data, SP_IMM_WRITE);
+}
 
-  if (neighbor->is_mpr) {
-    abuf_appendf(abuf, "\"%s\"[shape=box];\n", adr);
+static void
+ipc_print_edge(struct autobuf *abuf, const char *prefix, const struct dot_edge *edge)
+{
+  struct ipaddr_str frombuf, tobuf;
+  const char *from = olsr_ip_to_string(&frombuf, &edge->key.from);
+  const char *to = olsr_ip_to_string(&tobuf, &edge->key.to);
+
+  /* a removed edge */
+  if (prefix[0] == '-') {
+    if (edge->key.type == DOT_EDGE_HNA) {
+      abuf_appendf(abuf, "%s\"%s\" -> \"%s/%d\";\n", prefix, from, to, edge->key.prefix_len);
+    } else {
+      abuf_appendf(abuf, "%s\"%s\" -> \"%s\";\n", prefix, from, to);
+    }
+    return;
+  }
+
+  switch (edge->key.type) {
+  case DOT_EDGE_NEIGH:
+    abuf_appendf(abuf, "%s\"%s\" -> \"%s\"[label=\"%s\", style=%s];\n", prefix, from, to, edge->label, edge->dashed ? "dashed" : "solid");
+    if (edge->mpr) {
+      abuf_appendf(abuf, "%s\"%s\"[shape=box];\n", prefix, from);
+    }
+    break;
+  case DOT_EDGE_TC:
+    abuf_appendf(abuf, "%s\"%s\" -> \"%s\"[label=\"%s\"];\n", prefix, from, to, edge->label);
+    break;
+  default:
+    abuf_appendf(abuf, "%s\"%s\" -> \"%s/%d\"[label=\"HNA\"];\n", prefix, from, to, edge->key.prefix_len);
+    abuf_appendf(abuf, "%s\"%s/%d\"[shape=diamond];\n", prefix, to, edge->key.prefix_len);
+    break;
   }
 }
 
@@ -275,44 +501,89 @@ ipc_action(int fd __attribute__ ((unused)), void *data __attribute__ ((unused)),
 #endif /* _WRS_KERNEL */
   olsr_printf(1, "(DOT DRAW)IPC: Connection from %s\n", inet_ntoa(pin.sin_addr));
 
+  /* a slow front end must never block olsrd */
+#ifdef _WIN32
+  {
+    u_long iMode = 1;
+    ioctlsocket(ipc_connection, FIONBIO, &iMode);
+  }
+#elif !defined _WRS_KERNEL
+  fcntl(ipc_connection, F_SETFL, fcntl(ipc_connection, F_GETFL) | O_NONBLOCK);
+#endif /* _WIN32 */
+
   abuf_init(&outbuffer, AUTOBUFCHUNK);
   outbuffer_socket = ipc_connection;
+  add_olsr_socket(outbuffer_socket, NULL, &dotdraw_write_data, NULL, 0);
+
+  frametimer_entry = olsr_start_timer(dot_frame_interval, 0, OLSR_TIMER_PERIODIC, &dotdraw_frame, NULL, 0);
 
-  pcf_event(1, 1, 1);
+  /* a new front end starts with the whole graph */
+  frame_dirty = false;
+  dotdraw_render(true);
 }
 
 static void
-dotdraw_write_data(void *foo __attribute__ ((unused))) {
-  fd_set set;
-  int result;
-  struct timeval tv;
-
-  FD_ZERO(&set);
-  /* prevent warning on WIN32 */
-  FD_SET((unsigned int)outbuffer_socket, &set);
-
-  tv.tv_sec = 0;
-  tv.tv_usec = 0;
-
-  result = select(outbuffer_socket + 1, NULL, &set, NULL, &tv);
-  if (result <= 0) {
-    return;
+dotdraw_close(void)
+{
+  struct avl_node *node;
+
+  remove_olsr_socket(outbuffer_socket, NULL, &dotdraw_write_data);
+  close(outbuffer_socket);
+  outbuffer_socket = -1;
+  abuf_free(&outbuffer);
+  olsr_stop_timer(frametimer_entry);
+  frametimer_entry = NULL;
+
+  while ((node = avl_walk_first(&edge_tree)) != NULL) {
+    avl_delete(&edge_tree, node);
+    free(node2edge(node));
   }
+}
+
+static void
+dotdraw_write_data(int fd __attribute__ ((unused)), void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  int result;
 
-  if (FD_ISSET(outbuffer_socket, &set)) {
-    result = send(outbuffer_socket, outbuffer.buf, outbuffer.len, 0);
-    if (result > 0)
+  if (outbuffer.len > 0) {
+    result = send(outbuffer_socket, outbuffer.buf, outbuffer.len, MSG_NOSIGNAL);
+    if (result > 0) {
       abuf_pull(&outbuffer, result);
+    } else if (result < 0) {
+#if EWOULDBLOCK == EAGAIN
+      if (errno == EAGAIN || errno == EINTR) {
+#else /* EWOULDBLOCK == EAGAIN */
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+#endif /* EWOULDBLOCK == EAGAIN */
+        return;
+      }
 
-    if (result < 0) {
       /* close this socket and cleanup*/
-      close(outbuffer_socket);
-      abuf_free(&outbuffer);
-      olsr_stop_timer(writetimer_entry);
-      writetimer_entry = NULL;
-      outbuffer_socket = -1;
+      olsr_printf(1, "(DOT DRAW)IPC connection lost!\n");
+      dotdraw_close();
+      return;
     }
   }
+
+  if (outbuffer.len == 0) {
+    disable_olsr_socket(outbuffer_socket, NULL, &dotdraw_write_data, SP_IMM_WRITE);
+  }
+}
+
+/**
+ * Send the changes of the topology at most once per frame interval, and
+ * only after the front end took the previous frame: the changes of a
+ * slow front end add up to the next frame.
+ */
+static void
+dotdraw_frame(void *foo __attribute__ ((unused)))
+{
+  if (!frame_dirty || outbuffer.len > 0) {
+    return;
+  }
+
+  frame_dirty = false;
+  dotdraw_render(false);
 }
 
 /**
@@ -321,85 +592,18 @@ dotdraw_write_data(void *foo __attribute__ ((unused))) {
 static int
 pcf_event(int my_changes_neighborhood, int my_changes_topology, int my_changes_hna)
 {
-  struct neighbor_entry *neighbor_table_tmp;
-  struct tc_entry *tc;
-  struct tc_edge_entry *tc_edge;
-  struct hna_entry *tmp_hna;
-  struct hna_net *tmp_net;
-  struct ip_prefix_list *hna;
-  int res = 0;
-
   /* nothing to do */
   if (outbuffer_socket == -1) {
     return 1;
   }
 
   if (my_changes_neighborhood || my_changes_topology || my_changes_hna) {
-    /* Print tables to IPC socket */
-    abuf_puts(&outbuffer, "digraph topology\n{\n");
-
-    /* Neighbors */
-    OLSR_FOR_ALL_NBR_ENTRIES(neighbor_table_tmp) {
-      ipc_print_neigh_link(&outbuffer, neighbor_table_tmp);
-    }
-    OLSR_FOR_ALL_NBR_ENTRIES_END(neighbor_table_tmp);
-
-    /* Topology */
-    OLSR_FOR_ALL_TC_ENTRIES(tc) {
-      OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
-        if (tc_edge->edge_inv) {
-          ipc_print_tc_link(&outbuffer, tc, tc_edge);
-        }
-      }
-      OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
-    }
-    OLSR_FOR_ALL_TC_ENTRIES_END(tc);
-
-    /* HNA entries */
-    OLSR_FOR_ALL_HNA_ENTRIES(tmp_hna) {
-
-      /* Check all networks */
-      for (tmp_net = tmp_hna->networks.next; tmp_net != &tmp_hna->networks; tmp_net = tmp_net->next) {
-        ipc_print_net(&outbuffer, &tmp_hna->A_gateway_addr,
-            &tmp_net->hna_prefix.prefix, tmp_net->hna_prefix.prefix_len);
-      }
-    }
-    OLSR_FOR_ALL_HNA_ENTRIES_END(tmp_hna);
-
-    /* Local HNA entries */
-    for (hna = olsr_cnf->hna_entries; hna != NULL; hna = hna->next) {
-      ipc_print_net(&outbuffer, &olsr_cnf->main_addr, &hna->net.prefix, hna->net.prefix_len);
-    }
-    abuf_puts(&outbuffer, "}\n\n");
-
-    res = 1;
-  }
-
-  if (writetimer_entry == NULL) {
-    writetimer_entry = olsr_start_timer(100, 0, OLSR_TIMER_PERIODIC, &dotdraw_write_data, NULL, 0);
+    /* sent with the next frame */
+    frame_dirty = true;
+    return 1;
   }
 
-  return res;
-}
-
-static void
-ipc_print_tc_link(struct autobuf *abuf, const struct tc_entry *entry, const struct tc_edge_entry *dst_entry)
-{
-  struct ipaddr_str strbuf1, strbuf2;
-  struct lqtextbuffer lqbuffer;
-
-  abuf_appendf(abuf, "\"%s\" -> \"%s\"[label=\"%s\"];\n", olsr_ip_to_string(&strbuf1, &entry->addr),
-               olsr_ip_to_string(&strbuf2, &dst_entry->T_dest_addr), get_linkcost_text(dst_entry->cost, false, &lqbuffer));
-}
-
-static void
-ipc_print_net(struct autobuf *abuf, const union olsr_ip_addr *gw, const union olsr_ip_addr *net, uint8_t prefixlen)
-{
-  struct ipaddr_str gwbuf, netbuf;
-
-  abuf_appendf(abuf, "\"%s\" -> \"%s/%d\"[label=\"HNA\"];\n", olsr_ip_to_string(&gwbuf, gw), olsr_ip_to_string(&netbuf, net), prefixlen);
-
-  abuf_appendf(abuf, "\"%s/%d\"[shape=diamond];\n", olsr_ip_to_string(&netbuf, net), prefixlen);
+  return 0;
 }
 
 /*
@@ -56,6 +56,8 @@
 extern union olsr_ip_addr ipc_accept_ip;
 extern union olsr_ip_addr ipc_listen_ip;
 extern int ipc_port;
+extern int dot_frame_interval;
+extern bool dot_delta;
 
 int olsrd_plugin_interface_version(void);
 int olsrd_plugin_init(void);
@@ -64,6 +64,8 @@
 union olsr_ip_addr ipc_accept_ip;
 union olsr_ip_addr ipc_listen_ip;
 int ipc_port;
+int dot_frame_interval;
+bool dot_delta;
 
 static void my_init(void) __attribute__ ((constructor));
 static void my_fini(void) __attribute__ ((destructor));
@@ -81,6 +83,8 @@ my_init(void)
   ipc_port = 2004;
   ipc_accept_ip.v4.s_addr = htonl(INADDR_LOOPBACK);
   ipc_listen_ip.v4.s_addr = htonl(INADDR_ANY);
+  dot_frame_interval = 1000;
+  dot_delta = false;
 }
 
 /**
@@ -108,6 +112,8 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
   {.name = "port",.set_plugin_parameter = &set_plugin_port,.data = &ipc_port},
   {.name = "accept",.set_plugin_parameter = &set_plugin_ipaddress,.data = &ipc_accept_ip},
   {.name = "listen",.set_plugin_parameter = &set_plugin_ipaddress,.data = &ipc_listen_ip},
+  {.name = "frameinterval",.set_plugin_parameter = &set_plugin_int,.data = &dot_frame_interval},
+  {.name = "delta",.set_plugin_parameter = &set_plugin_boolean,.data = &dot_delta},
 };
 
 void
@@ -44,7 +44,7 @@
  */
 
 /*
- * -Threaded ping code added by Jens Nachtigall
+ * -Ping code added by Jens Nachtigall
  * -HNA4 checking by bjoern riemer
  */
 
@@ -52,6 +52,7 @@
 
 #include "olsr_types.h"
 #include "olsrd_dyn_gw.h"
+#include "probe.h"
 #include "olsr.h"
 #include "defs.h"
 #include "ipcalc.h"
@@ -68,37 +69,19 @@
 #include <unistd.h>
 #include <errno.h>
 #include <time.h>
-#ifndef _WIN32
-#include <pthread.h>
-#else /* _WIN32 */
-#define WIN32_LEAN_AND_MEAN
-#include <windows.h>
-#undef interface
-
-#define close(x) closesocket(x)
-
-typedef HANDLE pthread_mutex_t;
-typedef HANDLE pthread_t;
-
-int pthread_create(HANDLE * Hand, void *Attr, void *(*Func) (void *), void *Arg);
-int pthread_kill(HANDLE Hand, int Sig);
-int pthread_mutex_init(HANDLE * Hand, void *Attr);
-int pthread_mutex_lock(HANDLE * Hand);
-int pthread_mutex_unlock(HANDLE * Hand);
-
-struct ThreadPara {
-  void *(*Func) (void *);
-  void *Arg;
-};
-#endif /* _WIN32 */
 
 static int hna_check_interval	= DEFAULT_HNA_CHECK_INTERVAL;
 /* set default interval, in case none is given in the config file */
 static int ping_check_interval = DEFAULT_PING_CHECK_INTERVAL;
+/* consecutive replies after which a ping host is reachable */
+static int ping_replies = DEFAULT_PING_REPLIES;
+/* consecutive lost pings after which a ping host is unreachable */
+static int ping_losses = DEFAULT_PING_LOSSES;
 
 /* list to store the Ping IP addresses given in the config file */
 struct ping_list {
   char *ping_address;
+  struct probe_target *target;
   struct ping_list *next;
 };
 
@@ -127,17 +110,13 @@ static struct hna_group * hna_groups = NULL;
 
 static struct hna_group *add_to_hna_group(struct hna_group *);
 
-static void *looped_checks(void *);
-
-static bool check_gw(union olsr_ip_addr *, uint8_t, struct ping_list *);
-
-static int ping_is_possible(struct ping_list *);
-
-static char ping_cmd[PING_CMD_MAX_LEN] = { DEFAULT_PING_CMD };
+static void ping_host_changed(struct probe_target *);
 
 /* Event function to register with the scheduler */
 static void olsr_event_doing_hna(void *);
 
+static void update_hna(void);
+
 struct hna_list* find_hna(uint32_t src_addr, uint32_t src_mask);
 
 char *get_ip_str(uint32_t address, char *s, size_t maxlen);
@@ -213,17 +192,11 @@ set_plugin_hna(const char *value, void *data __attribute__ ((unused)), set_plugi
 }
 
 static int
-set_plugin_cmd(const char *value, void *data __attribute__ ((unused)), set_plugin_parameter_addon addon __attribute__ ((unused)))
+set_plugin_cmd(const char *value __attribute__ ((unused)), void *data __attribute__ ((unused)), set_plugin_parameter_addon addon __attribute__ ((unused)))
 {
-  size_t len = strlen(value);
-
-  if (len < PING_CMD_MAX_LEN) {
-    strncpy(ping_cmd, value, PING_CMD_MAX_LEN - 1);
-    ping_cmd[PING_CMD_MAX_LEN - 1] = '\0';
-    return 0;
-  }
-
-  return 1;
+  /* hosts are pinged by the plugin itself now, accept old configurations */
+  OLSR_PRINTF(0, "DYN GW: the \"pingcmd\" parameter is obsolete and ignored\n");
+  return 0;
 }
 
 static const struct olsrd_plugin_parameters plugin_parameters[] = {
@@ -232,7 +205,9 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
   {.name = "checkinterval", .set_plugin_parameter = &set_plugin_int,  .data = &hna_check_interval   },
   {.name = "ping",          .set_plugin_parameter = &set_plugin_ping, .data = NULL                  },
   {.name = "hna",           .set_plugin_parameter = &set_plugin_hna,  .data = NULL                  },
-  {.name = "pingcmd",       .set_plugin_parameter = &set_plugin_cmd,  .data = &ping_cmd             },
+  {.name = "pingreplies",   .set_plugin_parameter = &set_plugin_int,  .data = &ping_replies         },
+  {.name = "pinglosses",    .set_plugin_parameter = &set_plugin_int,  .data = &ping_losses          },
+  {.name = "pingcmd",       .set_plugin_parameter = &set_plugin_cmd,  .data = NULL                  },
 };
 
 void
@@ -253,8 +228,6 @@ olsrd_get_plugin_parameters(const struct olsrd_plugin_parameters **params, int *
 int
 olsrd_plugin_init(void)
 {
-  pthread_t ping_thread;
-
   if (hna_groups == NULL) {
     hna_groups = add_to_hna_group(hna_groups);
     if (hna_groups == NULL)
@@ -278,7 +251,15 @@ olsrd_plugin_init(void)
   update_routing();
   
   if (hna_ping_check) {
-    pthread_create(&ping_thread, NULL, looped_checks, NULL);
+    struct hna_group *grp;
+
+    /* groups without ping hosts only depend on the routing table */
+    for (grp = hna_groups; grp; grp = grp->next) {
+      grp->probe_ok = grp->ping_hosts == NULL;
+    }
+    if (!probe_start(ping_check_interval * MSEC_PER_SEC, ping_replies, ping_losses, &ping_host_changed)) {
+      return 0;
+    }
   } else {
     struct hna_group *grp;
     for (grp = hna_groups; grp; grp = grp->next) {
@@ -311,6 +292,8 @@ olsrd_plugin_init(void)
 }
 
 void olsrd_plugin_fini(void) {
+  probe_stop();
+
   if (!hna_groups) {
     return;
   }
@@ -334,17 +317,25 @@ void olsrd_plugin_fini(void) {
 
 
 /**
- * Scheduled event to update the hna table,
- * called from olsrd main thread to keep the hna table thread-safe
+ * Scheduled event to update the hna table
  */
 static void
 olsr_event_doing_hna(void *foo __attribute__ ((unused)))
+{
+  update_routing();
+  update_hna();
+}
+
+/**
+ * Add the HNAs of groups that passed their ping check and that are
+ * found in the routing table, remove all others
+ */
+static void
+update_hna(void)
 {
   struct hna_group* grp;
   struct hna_list *li;
 
-  update_routing();
-  
   for (grp = hna_groups; grp; grp = grp->next) {
     for (li = grp->hna_list; li; li = li->next) {
       if (!li->hna_added) {
@@ -366,39 +357,32 @@ olsr_event_doing_hna(void *foo __attribute__ ((unused)))
 }
 
 /**
- * the threaded function which happens within an endless loop,
- * reiterated every "Interval" sec (as given in the config or
- * the default value)
+ * Called by the prober when a ping host becomes reachable or
+ * unreachable: a group passes its ping check when any of its
+ * ping hosts is reachable. The HNAs are updated right away.
  */
 static void
-*looped_checks(void *foo __attribute__ ((unused)))
+ping_host_changed(struct probe_target *target __attribute__ ((unused)))
 {
-  for (;;) {
-    struct hna_group *grp;
-    struct hna_list *li;
-    struct timespec remainder_spec;
-    /* the time to wait in "Interval" sec (see connfig), default=5sec */
-    struct timespec sleeptime_spec = { ping_check_interval, 0L };
+  struct hna_group *grp;
 
-    for (grp = hna_groups; grp; grp = grp->next) {
-      for (li = grp->hna_list; li; li = li->next) {
-      
-    		// If this HNA is not active skip to the next one
-        if (!li->active)
-          continue;
-          
-        /* check for gw in table entry and if Ping IPs are given also do pings */
-        grp->probe_ok = check_gw(&li->hna_addr, li->hna_prefixlen, grp->ping_hosts);
-        if (grp->probe_ok)
-          break;	// Valid host found so we can bail out of the inner loop here
-      }
+  for (grp = hna_groups; grp; grp = grp->next) {
+    struct ping_list *png;
+
+    if (!grp->ping_hosts) {
+      continue;
     }
 
-    while (nanosleep(&sleeptime_spec, &remainder_spec) < 0)
-      sleeptime_spec = remainder_spec;
+    grp->probe_ok = false;
+    for (png = grp->ping_hosts; png; png = png->next) {
+      if (png->target && png->target->up) {
+        grp->probe_ok = true;
+        break;
+      }
+    }
   }
 
-  return NULL;
+  update_hna();
 }
 
 /* -------------------------------------------------------------------------
@@ -532,68 +516,6 @@ update_routing(void)
   return 0;
 }
 
-/* -------------------------------------------------------------------------
- * Function   : check_gw
- * Description: Check the specified gateway(s) by sending a ping
- * Input      : addr      - the address of the HNA to which the ping is related
- *              prefixlen - the length of the prefix for this HNA 
- *              the_ping_list - list with related ping hosts
- * Output     : none
- * Return     : true if the ping host could be reached, false otherwise
- * Data Used  : none
- * ------------------------------------------------------------------------- */
-static bool
-check_gw(union olsr_ip_addr *addr, uint8_t prefixlen, struct ping_list *the_ping_list)
-{
-  bool retval = false;
-  union olsr_ip_addr mask;
-
-  olsr_prefix_to_netmask(&mask, prefixlen);
-  
-  /* don't ping, if there was no "Ping" IP addr in the config file */
-  if (the_ping_list != NULL) {
-    /*validate the found inet gw by pinging */
-    if (ping_is_possible(the_ping_list)) {
-      olsr_printf(1, "HNA[%08x/%08x](ping is possible) detected in routing table.\n", addr->v4.s_addr, mask.v4.s_addr);
-      retval = true;
-    }
-  } else {
-    olsr_printf(1, "HNA[%08x/%08x] detected in routing table.\n", addr->v4.s_addr, mask.v4.s_addr);
-    retval = true;
-  }
-
-  if (retval == false) {
-    /* And we cast here since we get warnings on Win32 */
-    olsr_printf(1, "HNA[%08x/%08x] is invalid\n", (unsigned int)addr->v4.s_addr, (unsigned int)mask.v4.s_addr);
-  }
-  return retval;
-}
-
-/* -------------------------------------------------------------------------
- * Function   : ping_is_possible
- * Description: Ping the specified host(s)
- * Input      : the_ping_list - the list of hosts to ping
- * Output     : none
- * Return     : 1 if any host responded, 0 otherwise
- * Data Used  : none
- * ------------------------------------------------------------------------- */
-static int
-ping_is_possible(struct ping_list *the_ping_list)
-{
-  struct ping_list *list;
-  for (list = the_ping_list; list; list = list->next) {
-    char ping_command[sizeof(ping_cmd) + INET6_ADDRSTRLEN];
-    snprintf(ping_command, sizeof(ping_command), ping_cmd, list->ping_address);
-    olsr_printf(1, "\nDo ping on (%s) %s ...\n", ping_cmd, list->ping_address);
-    if (system(ping_command) == 0) {
-      olsr_printf(1, "...OK\n\n");
-      return 1;
-    }
-    olsr_printf(1, "...FAILED\n\n");
-  }
-  return 0;
-}
-
 /* -------------------------------------------------------------------------
  * Function   : add_to_ping_list
  * Description: Add a new ping host to the list of ping hosts
@@ -612,6 +534,7 @@ add_to_ping_list(const char *ping_address, struct ping_list *the_ping_list)
     olsr_exit("DYN GW: Out of memory", EXIT_FAILURE);
   }
   new->ping_address = strdup(ping_address);
+  new->target = probe_add_target(ping_address);
   new->next = the_ping_list;
   return new;
 }
@@ -662,92 +585,6 @@ add_to_hna_group(struct hna_group *list_root)
 }
 
 
-#ifdef _WIN32
-
-/*
- * Windows pthread compat stuff
- */
-static unsigned long __stdcall
-ThreadWrapper(void *Para)
-{
-  struct ThreadPara *Cast;
-  void *(*Func) (void *);
-  void *Arg;
-
-  Cast = (struct ThreadPara *)Para;
-
-  Func = Cast->Func;
-  Arg = Cast->Arg;
-
-  HeapFree(GetProcessHeap(), 0, Para);
-
-  Func(Arg);
-
-  return 0;
-}
-
-int
-pthread_create(HANDLE * Hand, void *Attr __attribute__ ((unused)), void *(*Func) (void *), void *Arg)
-{
-  struct ThreadPara *Para;
-  unsigned long ThreadId;
-
-  Para = HeapAlloc(GetProcessHeap(), 0, sizeof(struct ThreadPara));
-
-  if (Para == NULL)
-    return -1;
-
-  Para->Func = Func;
-  Para->Arg = Arg;
-
-  *Hand = CreateThread(NULL, 0, ThreadWrapper, Para, 0, &ThreadId);
-
-  if (*Hand == NULL)
-    return -1;
-
-  return 0;
-}
-
-int
-pthread_kill(HANDLE Hand, int Sig __attribute__ ((unused)))
-{
-  if (!TerminateThread(Hand, 0))
-    return -1;
-
-  return 0;
-}
-
-int
-pthread_mutex_init(HANDLE * Hand, void *Attr __attribute__ ((unused)))
-{
-  *Hand = CreateMutex(NULL, FALSE, NULL);
-
-  if (*Hand == NULL)
-    return -1;
-
-  return 0;
-}
-
-int
-pthread_mutex_lock(HANDLE * Hand)
-{
-  if (WaitForSingleObject(*Hand, INFINITE) == WAIT_FAILED)
-    return -1;
-
-  return 0;
-}
-
-int
-pthread_mutex_unlock(HANDLE * Hand)
-{
-  if (!ReleaseMutex(*Hand))
-    return -1;
-
-  return 0;
-}
-
-#endif /* _WIN32 */
-
 /*
  * Local Variables:
  * c-basic-offset: 2
@@ -0,0 +1,377 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Asynchronous ICMP echo prober
+ *
+ * All targets are probed at the same time from the scheduler, every probe
+ * interval. A probe that is not answered before the next interval is lost.
+ * A target is considered up after a number of consecutive replies and down
+ * after a number of consecutive lost probes.
+ */
+
+#include "probe.h"
+
+#include "olsr.h"
+#include "defs.h"
+#include "scheduler.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+
+#ifdef _WIN32
+#define close(x) closesocket(x)
+#undef EWOULDBLOCK
+#define EWOULDBLOCK WSAEWOULDBLOCK
+#else /* _WIN32 */
+#include <fcntl.h>
+#include <sys/socket.h>
+#endif /* _WIN32 */
+
+#define ICMP_TYPE_ECHO_REPLY   0
+#define ICMP_TYPE_ECHO_REQUEST 8
+
+/* The number of payload bytes in a probe */
+#define PROBE_PAYLOAD_SIZE     8
+
+/* ICMP echo request/reply header */
+struct probe_echo {
+  uint8_t type;
+  uint8_t code;
+  uint16_t checksum;
+  uint16_t id;
+  uint16_t seq;
+};
+
+static int probe_sock = -1;
+
+/* true when the socket is a raw socket: replies then include the IP header
+ * and the replies to other processes are received as well */
+static bool probe_raw = false;
+
+static uint16_t probe_id = 0;
+static uint16_t probe_seq = 0;
+
+static unsigned int probe_replies = 1;
+static unsigned int probe_losses = 1;
+
+static struct probe_target *probe_targets = NULL;
+static probe_change_func probe_change = NULL;
+static struct timer_entry *probe_timer = NULL;
+
+/**
+ * Add a host to probe
+ *
+ * @param address the IPv4 address of the host
+ * @return the target, or NULL when the address is invalid
+ */
+struct probe_target *
+probe_add_target(const char *address)
+{
+  struct probe_target *target;
+  struct in_addr addr;
+
+  if (inet_pton(AF_INET, address, &addr) <= 0) {
+    return NULL;
+  }
+
+  target = olsr_malloc(sizeof(*target), "DYN GW probe target");
+  target->addr = addr;
+  target->next = probe_targets;
+  probe_targets = target;
+  return target;
+}
+
+/* Internet checksum (RFC 1071) */
+static uint16_t
+probe_checksum(const uint8_t * data, size_t len)
+{
+  uint32_t sum = 0;
+  size_t i;
+
+  for (i = 0; i + 1 < len; i += 2) {
+    sum += (uint32_t)((data[i] << 8) | data[i + 1]);
+  }
+  if (i < len) {
+    sum += (uint32_t)(data[i] << 8);
+  }
+  while (sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return htons((uint16_t)~sum);
+}
+
+static void
+probe_set_state(struct probe_target *target, bool up)
+{
+  char addr[INET_ADDRSTRLEN];
+
+  if (target->up == up) {
+    return;
+  }
+
+  target->up = up;
+  olsr_printf(1, "DYN GW: ping host %s is %s (sent %lu, received %lu, rtt %u.%03u ms)\n",
+              inet_ntop(AF_INET, &target->addr, addr, sizeof(addr)), up ? "up" : "down",
+              target->sent, target->received, target->rtt_avg / 1000, target->rtt_avg % 1000);
+
+  if (probe_change) {
+    probe_change(target);
+  }
+}
+
+static void
+probe_reply(struct probe_target *target, const struct timeval *now)
+{
+  long rtt = (now->tv_sec - target->sent_time.tv_sec) * 1000000L + (now->tv_usec - target->sent_time.tv_usec);
+
+  if (rtt < 0) {
+    rtt = 0;
+  }
+
+  target->outstanding = false;
+  target->received++;
+  target->rtt_last = rtt;
+  target->rtt_avg = target->received > 1 ? (7 * target->rtt_avg + target->rtt_last) / 8 : target->rtt_last;
+  target->losses_in_row = 0;
+  target->replies_in_row++;
+
+  if (target->replies_in_row >= probe_replies) {
+    probe_set_state(target, true);
+  }
+}
+
+static void
+probe_loss(struct probe_target *target)
+{
+  target->outstanding = false;
+  target->replies_in_row = 0;
+  target->losses_in_row++;
+
+  if (target->losses_in_row >= probe_losses) {
+    probe_set_state(target, false);
+  }
+}
+
+static void
+probe_send(struct probe_target *target)
+{
+  uint8_t packet[sizeof(struct probe_echo) + PROBE_PAYLOAD_SIZE];
+  struct probe_echo *echo = (struct probe_echo *)packet;
+  struct sockaddr_in to;
+
+  memset(packet, 0, sizeof(packet));
+  echo->type = ICMP_TYPE_ECHO_REQUEST;
+  echo->id = htons(probe_id);
+  echo->seq = htons(++probe_seq);
+  echo->checksum = probe_checksum(packet, sizeof(packet));
+
+  memset(&to, 0, sizeof(to));
+  to.sin_family = AF_INET;
+  to.sin_addr = target->addr;
+
+  target->seq = probe_seq;
+  target->outstanding = true;
+  target->sent++;
+  gettimeofday(&target->sent_time, NULL);
+
+  if (sendto(probe_sock, (const void *)packet, sizeof(packet), 0, (struct sockaddr *)&to, sizeof(to)) < 0) {
+    char addr[INET_ADDRSTRLEN];
+
+    /* the probe is accounted as lost on the next interval */
+    OLSR_PRINTF(2, "DYN GW: could not send ping to %s: %s\n", inet_ntop(AF_INET, &target->addr, addr, sizeof(addr)),
+                strerror(errno));
+  }
+}
+
+/* Scheduled every probe interval: account the unanswered probes and probe all targets */
+static void
+probe_interval(void *foo __attribute__ ((unused)))
+{
+  struct probe_target *target;
+
+  for (target = probe_targets; target; target = target->next) {
+    if (target->outstanding) {
+      probe_loss(target);
+    }
+    probe_send(target);
+  }
+}
+
+/* Socket handler: match the received echo replies with the outstanding probes */
+static void
+probe_receive(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  for (;;) {
+    uint8_t packet[1500];
+    struct sockaddr_in from;
+    socklen_t fromlen = sizeof(from);
+    const struct probe_echo *echo;
+    struct probe_target *target;
+    struct timeval now;
+    ssize_t len;
+    size_t offset = 0;
+
+    len = recvfrom(fd, (void *)packet, sizeof(packet), 0, (struct sockaddr *)&from, &fromlen);
+    if (len < 0) {
+#if EWOULDBLOCK == EAGAIN
+      if (errno != EWOULDBLOCK && errno != EINTR) {
+#else /* EWOULDBLOCK == EAGAIN */
+      if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR) {
+#endif /* EWOULDBLOCK == EAGAIN */
+        OLSR_PRINTF(1, "DYN GW: ping receive error: %s\n", strerror(errno));
+      }
+      return;
+    }
+
+    if (probe_raw) {
+      /* skip the IP header */
+      if (len < 1) {
+        continue;
+      }
+      offset = (packet[0] & 0x0f) * 4;
+    }
+    if ((size_t)len < offset + sizeof(struct probe_echo)) {
+      continue;
+    }
+
+    echo = (const struct probe_echo *)CONST_ARM_NOWARN_ALIGN(&packet[offset]);
+    if (echo->type != ICMP_TYPE_ECHO_REPLY || (probe_raw && ntohs(echo->id) != probe_id)) {
+      continue;
+    }
+
+    gettimeofday(&now, NULL);
+    for (target = probe_targets; target; target = target->next) {
+      if (target->outstanding && target->seq == ntohs(echo->seq) && target->addr.s_addr == from.sin_addr.s_addr) {
+        probe_reply(target, &now);
+        break;
+      }
+    }
+  }
+}
+
+/**
+ * Start probing all targets
+ *
+ * @param interval the probe interval in milliseconds
+ * @param replies the number of consecutive replies after which a target is up
+ * @param losses the number of consecutive lost probes after which a target is down
+ * @param change_func called when a target changes between up and down
+ * @return true on success, false when no ICMP socket could be opened
+ */
+bool
+probe_start(unsigned int interval, unsigned int replies, unsigned int losses, probe_change_func change_func)
+{
+  probe_replies = replies ? replies : 1;
+  probe_losses = losses ? losses : 1;
+  probe_change = change_func;
+
+#ifdef __linux__
+  /* unprivileged ICMP socket, the kernel filters the replies for us */
+  probe_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_ICMP);
+  probe_raw = false;
+#endif /* __linux__ */
+  if (probe_sock < 0) {
+    probe_sock = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+    probe_raw = true;
+  }
+  if (probe_sock < 0) {
+    olsr_printf(0, "DYN GW: could not open an ICMP socket: %s\n", strerror(errno));
+    return false;
+  }
+
+#ifdef _WIN32
+  {
+    u_long iMode = 1;
+    ioctlsocket(probe_sock, FIONBIO, &iMode);
+  }
+#else /* _WIN32 */
+  fcntl(probe_sock, F_SETFL, fcntl(probe_sock, F_GETFL) | O_NONBLOCK);
+#endif /* _WIN32 */
+
+  probe_id = (uint16_t)getpid();
+  add_olsr_socket(probe_sock, &probe_receive, NULL, NULL, SP_PR_READ);
+
+  probe_timer = olsr_start_timer(interval, 0, OLSR_TIMER_PERIODIC, &probe_interval, NULL, 0);
+
+  /* probe right away */
+  probe_interval(NULL);
+  return true;
+}
+
+/**
+ * Stop probing and free all targets
+ */
+void
+probe_stop(void)
+{
+  if (probe_timer) {
+    olsr_stop_timer(probe_timer);
+    probe_timer = NULL;
+  }
+
+  if (probe_sock >= 0) {
+    remove_olsr_socket(probe_sock, &probe_receive, NULL);
+    close(probe_sock);
+    probe_sock = -1;
+  }
+
+  while (probe_targets) {
+    struct probe_target *next = probe_targets->next;
+    free(probe_targets);
+    probe_targets = next;
+  }
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,91 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#ifndef _OLSRD_DYNGW_PROBE_H
+#define _OLSRD_DYNGW_PROBE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <netinet/in.h>
+#include <sys/time.h>
+
+/* A host that is probed with ICMP echo requests */
+struct probe_target {
+  struct in_addr addr;                 /* the address of the host */
+  bool up;                             /* true when the host is considered reachable */
+
+  bool outstanding;                    /* true while waiting for the reply to the last probe */
+  uint16_t seq;                        /* the sequence number of the last probe */
+  struct timeval sent_time;            /* the time at which the last probe was sent */
+
+  unsigned int replies_in_row;         /* the number of consecutive replies */
+  unsigned int losses_in_row;          /* the number of consecutive lost probes */
+
+  unsigned long sent;                  /* the number of probes sent */
+  unsigned long received;              /* the number of replies received */
+  unsigned int rtt_last;               /* the round trip time of the last reply (usec) */
+  unsigned int rtt_avg;                /* the smoothed round trip time (usec) */
+
+  struct probe_target *next;
+};
+
+/* Called when a target changes between up and down */
+typedef void (*probe_change_func) (struct probe_target *);
+
+struct probe_target *probe_add_target(const char *address);
+
+bool probe_start(unsigned int interval, unsigned int replies, unsigned int losses, probe_change_func change_func);
+
+void probe_stop(void);
+
+#endif /* _OLSRD_DYNGW_PROBE_H */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -57,7 +57,7 @@ void http_header_build_result(unsigned int status, struct autobuf *abuf) {
   abuf_puts(abuf, "\r\n");
 }
 
-void http_header_build(const char *plugin_name, unsigned int status, const char *mime, struct autobuf *abuf, int *contentLengthIndex) {
+void http_header_build(const char *plugin_name, unsigned int status, const char *mime, bool keep_alive, struct autobuf *abuf, int *contentLengthIndex) {
   assert(plugin_name);
   assert(abuf);
   assert(contentLengthIndex);
@@ -80,7 +80,7 @@ void http_header_build(const char *plugin_name, unsigned int status, const char
   abuf_appendf(abuf, "Server: OLSRD %s\r\n", plugin_name);
 
   /* connection-type */
-  abuf_puts(abuf, "Connection: close\r\n");
+  abuf_puts(abuf, keep_alive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
 
   /* MIME type */
   if (mime != NULL) {
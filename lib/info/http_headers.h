@@ -46,6 +46,8 @@
 #ifndef _OLSRD_LIB_INFO_HTTP_HEADERS_H_
 #define _OLSRD_LIB_INFO_HTTP_HEADERS_H_
 
+#include <stdbool.h>
+
 #include "common/autobuf.h"
 
 #define INFO_HTTP_VERSION "HTTP/1.1"
@@ -62,7 +64,7 @@
 
 void http_header_build_result(unsigned int status, struct autobuf *abuf);
 
-void http_header_build(const char * plugin_name, unsigned int status, const char *mime, struct autobuf *abuf, int *contentLengthIndex);
+void http_header_build(const char * plugin_name, unsigned int status, const char *mime, bool keep_alive, struct autobuf *abuf, int *contentLengthIndex);
 
 void http_header_adjust_content_length(struct autobuf *abuf, int contentLengthIndex, int contentLength);
 
@@ -0,0 +1,633 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include "info_server.h"
+
+#ifndef _WIN32
+
+#include <pthread.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/socket.h>
+
+#include "olsr.h"
+#include "scheduler.h"
+
+#define INFO_SERVER_MAX_THREADS 16
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+enum info_connection_state {
+  INFO_CONN_FREE,
+  INFO_CONN_READING,
+  INFO_CONN_RENDERING, /* handed to the main thread */
+  INFO_CONN_WRITING
+};
+
+struct info_connection {
+  enum info_connection_state state;
+  int fd;
+  union olsr_sockaddr peer;
+
+  /* absolute time (ms) after which a reading connection times out */
+  long long deadline;
+
+  /* false until the first request was answered */
+  bool kept_alive;
+
+  char request[INFO_SERVER_REQUEST_SIZE];
+  size_t request_len;
+
+  struct autobuf response;
+  size_t written;
+  bool keep_alive;
+};
+
+struct info_server_thread;
+
+/* a request that has to be rendered on the main thread */
+struct info_server_job {
+  struct info_server_job *next;
+  struct info_server_thread *thread;
+  struct info_connection *connection;
+  char request[INFO_SERVER_REQUEST_SIZE];
+  size_t request_len;
+  bool timeout;
+  struct autobuf response;
+  bool keep_alive;
+};
+
+struct info_server_thread {
+  pthread_t thread;
+  bool started;
+
+  /* wakes the thread up, written by the main thread */
+  int wakeup[2];
+
+  /* rendered jobs, protected by server_mutex */
+  struct info_server_job *done;
+
+  struct info_connection connections[INFO_SERVER_MAX_CONNECTIONS];
+};
+
+static const char *server_name = NULL;
+static int server_socket = -1;
+static long server_request_timeout = 0;
+static long server_keepalive_timeout = 0;
+static info_server_handler server_handler = NULL;
+static bool server_running = false;
+
+static struct info_server_thread server_threads[INFO_SERVER_MAX_THREADS];
+static int server_thread_count = 0;
+
+/* jobs for the main thread, protected by server_mutex */
+static pthread_mutex_t server_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct info_server_job *server_jobs = NULL;
+
+/* wakes the main thread up */
+static int server_main_pipe[2] = { -1, -1 };
+
+static long long info_server_now(void) {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/* @return true when a failed recv() or send() should be retried later */
+static bool info_server_retry(void) {
+#if EWOULDBLOCK == EAGAIN
+  return (errno == EAGAIN) || (errno == EINTR);
+#else
+  return (errno == EAGAIN) || (errno == EWOULDBLOCK) || (errno == EINTR);
+#endif
+}
+
+static void info_server_notify(int fd) {
+  char c = 0;
+
+  /* a full pipe already guarantees a wakeup */
+  if (write(fd, &c, 1) < 0) {
+    return;
+  }
+}
+
+static void info_server_drain(int fd) {
+  char buffer[64];
+
+  while (read(fd, buffer, sizeof(buffer)) > 0) {
+    /* nothing */
+  }
+}
+
+static bool info_server_pipe(int fds[2]) {
+  if (pipe(fds) < 0) {
+    return false;
+  }
+  fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+  fcntl(fds[1], F_SETFL, fcntl(fds[1], F_GETFL) | O_NONBLOCK);
+  return true;
+}
+
+static void info_server_close_pipe(int fds[2]) {
+  if (fds[0] >= 0) {
+    close(fds[0]);
+    fds[0] = -1;
+  }
+  if (fds[1] >= 0) {
+    close(fds[1]);
+    fds[1] = -1;
+  }
+}
+
+static void connection_close(struct info_connection *conn) {
+  close(conn->fd);
+  conn->fd = -1;
+  abuf_free(&conn->response);
+  conn->state = INFO_CONN_FREE;
+}
+
+static void connection_read_next(struct info_connection *conn, long long now) {
+  conn->state = INFO_CONN_READING;
+  conn->request_len = 0;
+  conn->request[0] = '\0';
+  conn->deadline = now + (conn->kept_alive ? server_keepalive_timeout : server_request_timeout);
+}
+
+static void connection_respond(struct info_connection *conn, struct autobuf *response, bool keep_alive) {
+  /* take over the buffer of the response */
+  abuf_free(&conn->response);
+  conn->response = *response;
+  memset(response, 0, sizeof(*response));
+
+  conn->written = 0;
+  conn->keep_alive = keep_alive;
+  conn->state = INFO_CONN_WRITING;
+}
+
+/**
+ * @return true when the request in the buffer is complete: the empty line
+ *   after the headers of a HTTP request, or the end of the first line of
+ *   a plain request
+ */
+static bool request_complete(const struct info_connection *conn) {
+  const char *r = conn->request;
+
+  if (conn->request_len >= sizeof(conn->request) - 1) {
+    /* too large, the handler will reject it */
+    return true;
+  }
+
+  if ((conn->request_len >= 4) && !strncasecmp(r, "GET", 3) && ((r[3] == ' ') || (r[3] == '\t'))) {
+    return strstr(r, "\r\n\r\n") || strstr(r, "\n\n");
+  }
+
+  return strchr(r, '\n') || strchr(r, '\r');
+}
+
+static void connection_process(struct info_server_thread *thread, struct info_connection *conn, bool timeout) {
+  struct info_server_job *job;
+  struct autobuf response;
+  char request[INFO_SERVER_REQUEST_SIZE];
+  bool keep_alive = false;
+
+  memcpy(request, conn->request, conn->request_len + 1);
+
+  abuf_init(&response, AUTOBUFCHUNK);
+  if (server_handler(request, conn->request_len, &conn->peer, timeout, true, &response, &keep_alive)) {
+    connection_respond(conn, &response, keep_alive);
+    return;
+  }
+  abuf_free(&response);
+
+  /* hand the request over to the main thread */
+  job = calloc(1, sizeof(*job));
+  if (!job) {
+    connection_close(conn);
+    return;
+  }
+
+  job->thread = thread;
+  job->connection = conn;
+  memcpy(job->request, conn->request, conn->request_len + 1);
+  job->request_len = conn->request_len;
+  job->timeout = timeout;
+
+  conn->state = INFO_CONN_RENDERING;
+
+  pthread_mutex_lock(&server_mutex);
+  job->next = server_jobs;
+  server_jobs = job;
+  pthread_mutex_unlock(&server_mutex);
+
+  info_server_notify(server_main_pipe[1]);
+}
+
+static void connection_read(struct info_server_thread *thread, struct info_connection *conn) {
+  ssize_t r;
+
+  r = recv(conn->fd, conn->request + conn->request_len, sizeof(conn->request) - 1 - conn->request_len, MSG_DONTWAIT);
+  if (r < 0) {
+    if (!info_server_retry()) {
+      connection_close(conn);
+    }
+    return;
+  }
+
+  if (r == 0) {
+    /* orderly shutdown by the client */
+    if (!conn->request_len) {
+      connection_close(conn);
+    } else {
+      connection_process(thread, conn, false);
+    }
+    return;
+  }
+
+  conn->request_len += r;
+  conn->request[conn->request_len] = '\0';
+
+  if (request_complete(conn)) {
+    connection_process(thread, conn, false);
+  }
+}
+
+static void connection_write(struct info_connection *conn, long long now) {
+  ssize_t r;
+
+  r = send(conn->fd, conn->response.buf + conn->written, conn->response.len - conn->written, MSG_DONTWAIT | MSG_NOSIGNAL);
+  if (r < 0) {
+    if (!info_server_retry()) {
+      connection_close(conn);
+    }
+    return;
+  }
+
+  conn->written += r;
+  if (conn->written < (size_t) conn->response.len) {
+    return;
+  }
+
+  if (!conn->keep_alive) {
+    connection_close(conn);
+    return;
+  }
+
+  abuf_free(&conn->response);
+  conn->kept_alive = true;
+  connection_read_next(conn, now);
+}
+
+static void thread_accept(struct info_server_thread *thread, long long now) {
+  struct info_connection *conn = NULL;
+  socklen_t addrlen;
+  int fd, i;
+
+  for (i = 0; i < INFO_SERVER_MAX_CONNECTIONS; i++) {
+    if (thread->connections[i].state == INFO_CONN_FREE) {
+      conn = &thread->connections[i];
+      break;
+    }
+  }
+  if (!conn) {
+    return;
+  }
+
+  addrlen = sizeof(conn->peer);
+  fd = accept(server_socket, &conn->peer.in, &addrlen);
+  if (fd < 0) {
+    /* another thread was faster */
+    return;
+  }
+
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+  conn->fd = fd;
+  conn->kept_alive = false;
+  memset(&conn->response, 0, sizeof(conn->response));
+  connection_read_next(conn, now);
+}
+
+static void thread_collect_done(struct info_server_thread *thread) {
+  struct info_server_job *job;
+
+  pthread_mutex_lock(&server_mutex);
+  job = thread->done;
+  thread->done = NULL;
+  pthread_mutex_unlock(&server_mutex);
+
+  while (job) {
+    struct info_server_job *next = job->next;
+
+    connection_respond(job->connection, &job->response, job->keep_alive);
+    free(job);
+    job = next;
+  }
+}
+
+static void *info_server_thread_main(void *arg) {
+  struct info_server_thread *thread = arg;
+  struct pollfd fds[INFO_SERVER_MAX_CONNECTIONS + 2];
+  struct info_connection *polled[INFO_SERVER_MAX_CONNECTIONS + 2];
+
+  while (__atomic_load_n(&server_running, __ATOMIC_SEQ_CST)) {
+    long long now = info_server_now();
+    long long next_deadline = now + 1000;
+    bool room = false;
+    int count = 0, i;
+
+    fds[count].fd = thread->wakeup[0];
+    fds[count].events = POLLIN;
+    polled[count++] = NULL;
+
+    for (i = 0; i < INFO_SERVER_MAX_CONNECTIONS; i++) {
+      struct info_connection *conn = &thread->connections[i];
+
+      switch (conn->state) {
+        case INFO_CONN_FREE:
+          room = true;
+          break;
+
+        case INFO_CONN_READING:
+          if (conn->deadline <= now) {
+            if (conn->kept_alive && !conn->request_len) {
+              /* idle keep-alive connection */
+              connection_close(conn);
+            } else {
+              connection_process(thread, conn, !conn->request_len);
+
+              /* a rendered response is polled in the next round */
+              next_deadline = now;
+            }
+            break;
+          }
+          if (conn->deadline < next_deadline) {
+            next_deadline = conn->deadline;
+          }
+          fds[count].fd = conn->fd;
+          fds[count].events = POLLIN;
+          polled[count++] = conn;
+          break;
+
+        case INFO_CONN_WRITING:
+          fds[count].fd = conn->fd;
+          fds[count].events = POLLOUT;
+          polled[count++] = conn;
+          break;
+
+        case INFO_CONN_RENDERING:
+        default:
+          break;
+      }
+    }
+
+    if (room) {
+      fds[count].fd = server_socket;
+      fds[count].events = POLLIN;
+      polled[count++] = NULL;
+    }
+
+    if (poll(fds, count, (int) (next_deadline - now)) <= 0) {
+      continue;
+    }
+
+    now = info_server_now();
+    for (i = 0; i < count; i++) {
+      struct info_connection *conn = polled[i];
+
+      if (!fds[i].revents) {
+        continue;
+      }
+
+      if (fds[i].fd == thread->wakeup[0]) {
+        info_server_drain(thread->wakeup[0]);
+        thread_collect_done(thread);
+      } else if (!conn) {
+        thread_accept(thread, now);
+      } else if (conn->state == INFO_CONN_READING) {
+        connection_read(thread, conn);
+      } else if (conn->state == INFO_CONN_WRITING) {
+        connection_write(conn, now);
+      }
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * Render the requests of the I/O threads that need the main thread.
+ */
+static void info_server_main_action(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused))) {
+  struct info_server_job *job;
+
+  info_server_drain(fd);
+
+  pthread_mutex_lock(&server_mutex);
+  job = server_jobs;
+  server_jobs = NULL;
+  pthread_mutex_unlock(&server_mutex);
+
+  while (job) {
+    struct info_server_job *next = job->next;
+    struct info_server_thread *thread = job->thread;
+
+    abuf_init(&job->response, AUTOBUFCHUNK);
+    server_handler(job->request, job->request_len, &job->connection->peer, job->timeout, false, &job->response, &job->keep_alive);
+
+    pthread_mutex_lock(&server_mutex);
+    job->next = thread->done;
+    thread->done = job;
+    pthread_mutex_unlock(&server_mutex);
+
+    info_server_notify(thread->wakeup[1]);
+    job = next;
+  }
+}
+
+/**
+ * Start the I/O threads.
+ *
+ * @param plugin_name the name of the plugin, for logging
+ * @param listen_socket the listening socket, it will be made non-blocking
+ * @param threads the number of I/O threads
+ * @param request_timeout the time (ms) to wait for the first request
+ * @param keepalive_timeout the time (ms) to keep an idle connection open
+ * @param handler the request handler
+ * @return true on success
+ */
+bool info_server_start(const char *plugin_name, int listen_socket, int threads, long request_timeout, long keepalive_timeout,
+    info_server_handler handler) {
+  int i;
+
+  server_name = plugin_name;
+  server_socket = listen_socket;
+  server_request_timeout = request_timeout;
+  server_keepalive_timeout = keepalive_timeout;
+  server_handler = handler;
+  server_thread_count = 0;
+  server_jobs = NULL;
+
+  if (threads > INFO_SERVER_MAX_THREADS) {
+    threads = INFO_SERVER_MAX_THREADS;
+  }
+
+  fcntl(server_socket, F_SETFL, fcntl(server_socket, F_GETFL) | O_NONBLOCK);
+
+  if (!info_server_pipe(server_main_pipe)) {
+    olsr_printf(1, "(%s) pipe()=%s\n", server_name, strerror(errno));
+    return false;
+  }
+  add_olsr_socket(server_main_pipe[0], &info_server_main_action, NULL, NULL, SP_PR_READ);
+
+  server_running = true;
+
+  for (i = 0; i < threads; i++) {
+    struct info_server_thread *thread = &server_threads[i];
+    int j;
+
+    memset(thread, 0, sizeof(*thread));
+    for (j = 0; j < INFO_SERVER_MAX_CONNECTIONS; j++) {
+      thread->connections[j].fd = -1;
+    }
+
+    if (!info_server_pipe(thread->wakeup)) {
+      olsr_printf(1, "(%s) pipe()=%s\n", server_name, strerror(errno));
+      break;
+    }
+    server_thread_count++;
+
+    if (pthread_create(&thread->thread, NULL, &info_server_thread_main, thread)) {
+      olsr_printf(1, "(%s) pthread_create()=%s\n", server_name, strerror(errno));
+      break;
+    }
+    thread->started = true;
+  }
+
+  if (i < threads) {
+    info_server_stop();
+    return false;
+  }
+
+  olsr_printf(1, "(%s) serving with %d thread(s)\n", server_name, threads);
+  return true;
+}
+
+/**
+ * Stop the I/O threads and close all connections. The listening socket
+ * is not closed.
+ */
+void info_server_stop(void) {
+  struct info_server_job *job;
+  int i, j;
+
+  __atomic_store_n(&server_running, false, __ATOMIC_SEQ_CST);
+
+  for (i = 0; i < server_thread_count; i++) {
+    struct info_server_thread *thread = &server_threads[i];
+
+    if (thread->started) {
+      info_server_notify(thread->wakeup[1]);
+      pthread_join(thread->thread, NULL);
+      thread->started = false;
+    }
+  }
+
+  if (server_main_pipe[0] >= 0) {
+    remove_olsr_socket(server_main_pipe[0], &info_server_main_action, NULL);
+  }
+  info_server_close_pipe(server_main_pipe);
+
+  /* all threads are gone, no locking needed anymore */
+  job = server_jobs;
+  server_jobs = NULL;
+  while (job) {
+    struct info_server_job *next = job->next;
+    free(job);
+    job = next;
+  }
+
+  for (i = 0; i < server_thread_count; i++) {
+    struct info_server_thread *thread = &server_threads[i];
+
+    job = thread->done;
+    thread->done = NULL;
+    while (job) {
+      struct info_server_job *next = job->next;
+      abuf_free(&job->response);
+      free(job);
+      job = next;
+    }
+
+    for (j = 0; j < INFO_SERVER_MAX_CONNECTIONS; j++) {
+      if (thread->connections[j].state != INFO_CONN_FREE) {
+        connection_close(&thread->connections[j]);
+      }
+    }
+    info_server_close_pipe(thread->wakeup);
+  }
+  server_thread_count = 0;
+}
+
+#else /* _WIN32 */
+
+bool info_server_start(const char *plugin_name __attribute__ ((unused)), int listen_socket __attribute__ ((unused)),
+    int threads __attribute__ ((unused)), long request_timeout __attribute__ ((unused)),
+    long keepalive_timeout __attribute__ ((unused)), info_server_handler handler __attribute__ ((unused))) {
+  return false;
+}
+
+void info_server_stop(void) {
+}
+
+#endif /* _WIN32 */
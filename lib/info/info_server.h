@@ -0,0 +1,90 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _OLSRD_LIB_INFO_INFO_SERVER_H_
+#define _OLSRD_LIB_INFO_INFO_SERVER_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "olsr_types.h"
+#include "common/autobuf.h"
+
+/* maximum size of a request, same as in the non-threaded mode */
+#define INFO_SERVER_REQUEST_SIZE 1024
+
+/* maximum number of connections per thread */
+#define INFO_SERVER_MAX_CONNECTIONS 64
+
+/*
+ * Threaded server for the info plugins.
+ *
+ * Connections are accepted, read and written by dedicated I/O threads,
+ * the main loop of olsrd is never blocked by a client. Requests are
+ * rendered by the handler on the I/O thread when possible, otherwise
+ * they are handed to the main thread and the response is handed back.
+ */
+
+/**
+ * Render the response for a request.
+ *
+ * @param request the request (modifiable, 0-terminated)
+ * @param len the length of the request
+ * @param peer the address of the client
+ * @param timeout true when no request arrived in time
+ * @param in_thread true when called on an I/O thread
+ * @param response the buffer for the response
+ * @param keep_alive set to true when the connection should be kept open
+ * @return false when the request can only be rendered on the main thread
+ *   (only allowed when in_thread is true)
+ */
+typedef bool (*info_server_handler)(char *request, size_t len, const union olsr_sockaddr *peer, bool timeout, bool in_thread,
+    struct autobuf *response, bool *keep_alive);
+
+bool info_server_start(const char *plugin_name, int listen_socket, int threads, long request_timeout, long keepalive_timeout,
+    info_server_handler handler);
+void info_server_stop(void);
+
+#endif /* _OLSRD_LIB_INFO_INFO_SERVER_H_ */
@@ -54,6 +54,7 @@
 
 #define CACHE_TIMEOUT_DEFAULT 1000
 #define REQUEST_TIMEOUT_DEFAULT 20
+#define KEEPALIVE_TIMEOUT_DEFAULT 5000
 
 typedef struct {
     union olsr_ip_addr accept_ip;
@@ -66,6 +67,8 @@ typedef struct {
     long request_timeout;
     long request_timeout_sec; /* derived */
     long request_timeout_usec; /* derived */
+    int threads;
+    long keepalive_timeout;
 } info_plugin_config_t;
 
 #define INFO_PLUGIN_CONFIG_PLUGIN_PARAMETERS(config) \
@@ -76,7 +79,9 @@ typedef struct {
   { .name = "allowlocalhost", .set_plugin_parameter = &set_plugin_boolean, .data = &config.allow_localhost }, \
   { .name = "ipv6only", .set_plugin_parameter = &set_plugin_boolean, .data = &config.ipv6_only },\
   { .name = "cachetimeout", .set_plugin_parameter = &set_plugin_long, .data = &config.cache_timeout },\
-  { .name = "requesttimeout", .set_plugin_parameter = &set_plugin_long, .data = &config.request_timeout }
+  { .name = "requesttimeout", .set_plugin_parameter = &set_plugin_long, .data = &config.request_timeout },\
+  { .name = "threads", .set_plugin_parameter = &set_plugin_int, .data = &config.threads },\
+  { .name = "keepalivetimeout", .set_plugin_parameter = &set_plugin_long, .data = &config.keepalive_timeout }
 
 /* these provide all of the runtime status info */
 #define SIW_NEIGHBORS                    (1ULL <<  0)
@@ -120,8 +125,11 @@ typedef struct {
 #define SIW_POPROUTING_TC_MULT           (1ULL << 23)
 #define SIW_POPROUTING                   (SIW_POPROUTING_HELLO | SIW_POPROUTING_TC | SIW_POPROUTING_HELLO_MULT | SIW_POPROUTING_TC_MULT)
 
+/* latency histograms and counters of the hot paths */
+#define SIW_METRICS                      (1ULL << 24)
+
 /* everything */
-#define SIW_EVERYTHING                   ((SIW_POPROUTING_TC_MULT << 1) - 1)
+#define SIW_EVERYTHING                   ((SIW_METRICS << 1) - 1)
 
 /* command prefixes */
 #define SIW_PREFIX_HTTP                  "/http"
@@ -140,6 +148,10 @@ typedef void (*printer_generic)(struct autobuf *abuf);
 
 typedef struct {
     bool supportsCompositeCommands;
+
+    /* commands whose printers only read the routing state through info_snapshot() */
+    unsigned long long snapshot_commands;
+
     init_plugin init;
     supported_commands_mask_func supported_commands_mask;
     command_matcher is_command;
@@ -175,6 +187,8 @@ typedef struct {
     printer_generic helloTimer;
     printer_generic tcTimerMult;
     printer_generic helloTimerMult;
+
+    printer_generic metrics;
 } info_plugin_functions_t;
 
 struct info_cache_entry_t {
@@ -315,6 +329,8 @@ static INLINE void info_plugin_config_init(info_plugin_config_t *config, unsigne
   config->ipv6_only = false;
   config->cache_timeout = CACHE_TIMEOUT_DEFAULT;
   config->request_timeout = REQUEST_TIMEOUT_DEFAULT;
+  config->threads = 0;
+  config->keepalive_timeout = KEEPALIVE_TIMEOUT_DEFAULT;
 }
 
 #endif /* _OLSRD_LIB_INFO_INFO_TYPES_H_ */
@@ -54,6 +54,8 @@
 #include "scheduler.h"
 #include "ipcalc.h"
 #include "http_headers.h"
+#include "info_server.h"
+#include "olsr_snapshot.h"
 
 #ifdef _WIN32
 #define close(x) closesocket(x)
@@ -96,6 +98,12 @@ static struct timer_entry *writetimer_entry = NULL;
 
 static struct info_cache_t info_cache;
 
+/* snapshot the printers of the current thread read from, see info_snapshot() */
+static __thread struct olsr_snapshot *info_current_snapshot = NULL;
+
+/* true when info_current_snapshot is a published one that is shared between threads */
+static __thread bool info_current_snapshot_shared = false;
+
 #define ARRAY_SIZE(x) (sizeof(x) / sizeof(x[0]))
 
 static char * skipMultipleSlashes(char * requ, size_t* len) {
@@ -153,7 +161,9 @@ static unsigned long long SIW_ENTRIES_ALL[] = {
     SIW_POPROUTING_HELLO,
     SIW_POPROUTING_TC, //
     SIW_POPROUTING_HELLO_MULT,
-    SIW_POPROUTING_TC_MULT //
+    SIW_POPROUTING_TC_MULT, //
+    //
+    SIW_METRICS //
     };
 
 long cache_timeout_generic(info_plugin_config_t *plugin_config, unsigned long long siw) {
@@ -442,7 +452,8 @@ static void send_info_from_table(struct autobuf *abuf, unsigned int send_what, S
         long cache_timeout = 0;
         struct info_cache_entry_t *cache_entry = NULL;
 
-        if (cache_timeout_f) {
+        /* the cache belongs to the main thread */
+        if (cache_timeout_f && !info_current_snapshot_shared) {
           cache_timeout = cache_timeout_f(config, siw);
           cache_entry = (cache_timeout <= 0) ? NULL : info_cache_get_entry(&info_cache, siw);
         }
@@ -479,22 +490,43 @@ static void send_info_from_table(struct autobuf *abuf, unsigned int send_what, S
   }
 }
 
-static void send_info(const char * req, bool add_headers, unsigned int send_what, int the_socket, unsigned int status) {
-  struct autobuf abuf;
+/**
+ * @param sections the OLSR_SNAPSHOT_* parts the printer reads
+ * @return the snapshot of the routing state the printers must read from.
+ * On the main thread a private snapshot with only the requested parts of
+ * the live state is created on first use, and extended by later printers
+ * of the same request. On the I/O threads the published snapshot is used.
+ */
+struct olsr_snapshot *info_snapshot(unsigned int sections) {
+  if (!info_current_snapshot) {
+    assert(!info_current_snapshot_shared);
+    info_current_snapshot = olsr_snapshot_create(sections);
+  } else if (!info_current_snapshot_shared) {
+    olsr_snapshot_add(info_current_snapshot, sections);
+  }
+  return info_current_snapshot;
+}
+
+static void info_snapshot_done(void) {
+  if (info_current_snapshot_shared) {
+    olsr_snapshot_release(info_current_snapshot);
+  } else {
+    olsr_snapshot_destroy(info_current_snapshot);
+  }
+  info_current_snapshot = NULL;
+  info_current_snapshot_shared = false;
+}
+
+static void build_response(const char * req, bool add_headers, bool keep_alive, unsigned int send_what, unsigned int status, struct autobuf *response) {
+  struct autobuf abuf = *response;
   unsigned int outputLength = 0;
-  unsigned int send_index = 0;
-  bool first_reply = false;
 
   const char *content_type = functions->determine_mime_type ? functions->determine_mime_type(send_what) : "text/plain; charset=utf-8";
   int contentLengthIndex = 0;
   int headerLength = 0;
 
-  assert(outbuffer.count <= MAX_CLIENTS);
-
-  abuf_init(&abuf, AUTOBUFCHUNK);
-
   if (add_headers) {
-    http_header_build(name, status, content_type, &abuf, &contentLengthIndex);
+    http_header_build(name, status, content_type, keep_alive, &abuf, &contentLengthIndex);
     headerLength = abuf.len;
   }
 
@@ -540,6 +572,12 @@ static void send_info(const char * req, bool add_headers, unsigned int send_what
         { SIW_POPROUTING_HELLO_MULT       , functions->helloTimerMult    } //
       };
       
+      send_info_from_table(&abuf, send_what, funcs, ARRAY_SIZE(funcs), &outputLength);
+    } else if (send_what & SIW_METRICS) {
+      SiwLookupTableEntry funcs[] = {
+        { SIW_METRICS                     , functions->metrics           } //
+      };
+
       send_info_from_table(&abuf, send_what, funcs, ARRAY_SIZE(funcs), &outputLength);
     } else if ((send_what & SIW_OLSRD_CONF) && functions->olsrd_conf) {
       /* this outputs the olsrd.conf text directly, not normal format */
@@ -553,7 +591,7 @@ static void send_info(const char * req, bool add_headers, unsigned int send_what
       abuf.buf[0] = '\0';
       abuf.len = 0;
       if (add_headers) {
-        http_header_build(name, status, content_type, &abuf, &contentLengthIndex);
+        http_header_build(name, status, content_type, keep_alive, &abuf, &contentLengthIndex);
         headerLength = abuf.len;
       }
     }
@@ -572,6 +610,21 @@ static void send_info(const char * req, bool add_headers, unsigned int send_what
     http_header_adjust_content_length(&abuf, contentLengthIndex, abuf.len - headerLength);
   }
 
+  info_snapshot_done();
+
+  *response = abuf;
+}
+
+static void send_info(const char * req, bool add_headers, unsigned int send_what, int the_socket, unsigned int status) {
+  struct autobuf abuf;
+  unsigned int send_index = 0;
+  bool first_reply = false;
+
+  assert(outbuffer.count <= MAX_CLIENTS);
+
+  abuf_init(&abuf, AUTOBUFCHUNK);
+  build_response(req, add_headers, false, send_what, status, &abuf);
+
   /*
    * Determine the last available outbuffer slot.
    * Search from the end towards the start to avoid starvation of
@@ -743,6 +796,43 @@ static char * checkCommandPrefixes(char * req, size_t *len, bool *add_headers) {
   return req;
 }
 
+static char * sanitiseRequest(char * req, size_t *len, bool *add_headers) {
+  req = cutAtFirstEOL(req, len);
+
+  req = stripTrailingWhitespace(req, len);
+  req = skipLeadingWhitespace(req, len);
+
+  /* detect http requests */
+  req = parseRequest(req, len, add_headers);
+
+  req = stripTrailingWhitespace(req, len);
+  req = stripTrailingSlashes(req, len);
+  req = skipLeadingWhitespace(req, len);
+  req = skipMultipleSlashes(req, len);
+
+  req = checkCommandPrefixes(req, len, add_headers);
+
+  req = skipMultipleSlashes(req, len);
+
+  return req;
+}
+
+static bool isHostDenied(const union olsr_sockaddr *sock_addr) {
+  if (olsr_cnf->ip_version == AF_INET) {
+    return //
+        (ntohl(config->accept_ip.v4.s_addr) != INADDR_ANY) //
+        && !ip4equal(&sock_addr->in4.sin_addr, &config->accept_ip.v4) //
+        && (!config->allow_localhost //
+            || (ntohl(sock_addr->in4.sin_addr.s_addr) != INADDR_LOOPBACK));
+  }
+
+  return //
+      !ip6equal(&config->accept_ip.v6, &in6addr_any) //
+      && !ip6equal(&sock_addr->in6.sin6_addr, &config->accept_ip.v6) //
+      && (!config->allow_localhost //
+          || !ip6equal(&config->accept_ip.v6, &in6addr_loopback));
+}
+
 static void drain_request(int ipc_connection) {
   static char drain_buffer[AUTOBUFCHUNK];
 
@@ -870,22 +960,7 @@ static void ipc_action(int fd, void *data __attribute__ ((unused)), unsigned int
 
   /* sanitise the request */
   if (rx_count > 0) {
-    req = cutAtFirstEOL(req, (size_t*) &rx_count);
-
-    req = stripTrailingWhitespace(req, (size_t*) &rx_count);
-    req = skipLeadingWhitespace(req, (size_t*) &rx_count);
-
-    /* detect http requests */
-    req = parseRequest(req, (size_t*) &rx_count, &add_headers);
-
-    req = stripTrailingWhitespace(req, (size_t*) &rx_count);
-    req = stripTrailingSlashes(req, (size_t*) &rx_count);
-    req = skipLeadingWhitespace(req, (size_t*) &rx_count);
-    req = skipMultipleSlashes(req, (size_t*) &rx_count);
-
-    req = checkCommandPrefixes(req, (size_t*) &rx_count, &add_headers);
-
-    req = skipMultipleSlashes(req, (size_t*) &rx_count);
+    req = sanitiseRequest(req, (size_t*) &rx_count, &add_headers);
   }
 
   if (outbuffer.count >= MAX_CLIENTS) {
@@ -895,19 +970,7 @@ static void ipc_action(int fd, void *data __attribute__ ((unused)), unsigned int
     return;
   }
 
-  if (olsr_cnf->ip_version == AF_INET) {
-    hostDenied = //
-        (ntohl(config->accept_ip.v4.s_addr) != INADDR_ANY) //
-        && !ip4equal(&sock_addr.in4.sin_addr, &config->accept_ip.v4) //
-        && (!config->allow_localhost //
-            || (ntohl(sock_addr.in4.sin_addr.s_addr) != INADDR_LOOPBACK));
-  } else {
-    hostDenied = //
-        !ip6equal(&config->accept_ip.v6, &in6addr_any) //
-        && !ip6equal(&sock_addr.in6.sin6_addr, &config->accept_ip.v6) //
-        && (!config->allow_localhost //
-            || !ip6equal(&config->accept_ip.v6, &in6addr_loopback));
-  }
+  hostDenied = isHostDenied(&sock_addr);
 
 #ifndef NODEBUG
   if (!inet_ntop( //
@@ -980,11 +1043,104 @@ static void ipc_action(int fd, void *data __attribute__ ((unused)), unsigned int
 
   if (!send_what) {
     http_status = INFO_HTTP_NOTFOUND;
+  } else if (send_what & SIW_METRICS) {
+    /* Prometheus only understands an HTTP response, whatever the httpheaders setting */
+    add_headers = true;
   }
 
   send_info(req, add_headers, send_what, ipc_connection, http_status);
 }
 
+/**
+ * @return true when a HTTP request asks to keep the connection open:
+ * HTTP/1.1 unless 'Connection: close' is sent, or 'Connection: keep-alive'
+ */
+static bool requestKeepAlive(const char * req) {
+  const char * eol = strpbrk(req, "\r\n");
+  size_t first = eol ? (size_t) (eol - req) : strlen(req);
+  bool keep_alive;
+
+  if (first < 8) {
+    return false;
+  }
+
+  keep_alive = !strncasecmp(&req[first - 8], "HTTP/1.1", 8);
+
+  while (eol && *eol) {
+    eol += strspn(eol, "\r\n");
+    if (!strncasecmp(eol, "Connection:", 11)) {
+      const char * value = eol + 11;
+      value += strspn(value, " \t");
+      if (!strncasecmp(value, "close", 5)) {
+        keep_alive = false;
+      } else if (!strncasecmp(value, "keep-alive", 10)) {
+        keep_alive = true;
+      }
+    }
+    eol = strpbrk(eol, "\r\n");
+  }
+
+  return keep_alive;
+}
+
+/* request handler of the threaded server, see info_server_handler */
+static bool info_server_request(char *request, size_t len, const union olsr_sockaddr *peer, bool timeout, bool in_thread,
+    struct autobuf *response, bool *keep_alive) {
+  char * req = request;
+  size_t rx_count = len;
+  unsigned int send_what = 0;
+  unsigned int http_status = INFO_HTTP_OK;
+  bool add_headers = config->http_headers;
+  bool wants_keep_alive = false;
+
+  if (timeout) {
+    http_status = INFO_HTTP_REQUEST_TIMEOUT;
+  } else {
+    wants_keep_alive = requestKeepAlive(req);
+    req = sanitiseRequest(req, &rx_count, &add_headers);
+
+    if (isHostDenied(peer)) {
+      http_status = INFO_HTTP_FORBIDDEN;
+    } else if (len >= INFO_SERVER_REQUEST_SIZE - 1) {
+      http_status = INFO_HTTP_REQUEST_ENTITY_TOO_LARGE;
+    } else {
+      if (!rx_count //
+          || ((rx_count == 1) && (*req == '/'))) {
+        /* empty or '/' */
+        send_what = SIW_EVERYTHING;
+      } else {
+        send_what = determine_action(req);
+      }
+
+      if (!send_what) {
+        http_status = INFO_HTTP_NOTFOUND;
+      } else if (send_what & SIW_METRICS) {
+        /* Prometheus only understands an HTTP response, whatever the httpheaders setting */
+        add_headers = true;
+      }
+    }
+  }
+
+  if (in_thread && (http_status == INFO_HTTP_OK)) {
+    /* only commands that can be served from the published snapshot */
+    if (send_what & ~functions->snapshot_commands) {
+      return false;
+    }
+
+    info_current_snapshot = olsr_snapshot_acquire();
+    if (!info_current_snapshot) {
+      return false;
+    }
+    info_current_snapshot_shared = true;
+  }
+
+  /* only HTTP responses have a length, errors close the connection */
+  *keep_alive = add_headers && wants_keep_alive && ((http_status == INFO_HTTP_OK) || (http_status == INFO_HTTP_NOTFOUND));
+
+  build_response(req, add_headers, *keep_alive, send_what, http_status, response);
+  return true;
+}
+
 static int plugin_ipc_init(void) {
   union olsr_sockaddr sock_addr;
   uint32_t yes = 1;
@@ -1048,16 +1204,28 @@ static int plugin_ipc_init(void) {
     goto error_out;
   }
 
-  /* show that we are willing to listen */
-  if (listen(ipc_socket, 1) == -1) {
+  /* show that we are willing to listen, the main loop serves up to MAX_CLIENTS at once */
+  if (listen(ipc_socket, (config->threads > 0) ? INFO_SERVER_MAX_CONNECTIONS : MAX_CLIENTS) == -1) {
 #ifndef NODEBUG
     olsr_printf(1, "(%s) listen()=%s\n", name, strerror(errno));
 #endif /* NODEBUG */
     goto error_out;
   }
 
-  /* Register with olsrd */
-  add_olsr_socket(ipc_socket, &ipc_action, NULL, NULL, SP_PR_READ);
+  if (config->threads > 0) {
+    /* serve from I/O threads, using the published snapshots */
+    olsr_snapshot_enable();
+    if (!info_server_start(name, ipc_socket, config->threads, config->request_timeout, config->keepalive_timeout, &info_server_request)) {
+      olsr_snapshot_disable();
+#ifndef NODEBUG
+      olsr_printf(1, "(%s) could not start the server threads\n", name);
+#endif /* NODEBUG */
+      goto error_out;
+    }
+  } else {
+    /* Register with olsrd */
+    add_olsr_socket(ipc_socket, &ipc_action, NULL, NULL, SP_PR_READ);
+  }
 
 #ifndef NODEBUG
   olsr_printf(1, "(%s) listening on port %d\n", name, config->ipc_port);
@@ -1082,6 +1250,14 @@ static void info_sanitise_config(info_plugin_config_t *cfg) {
     cfg->request_timeout = 0;
   }
 
+  if (cfg->threads < 0) {
+    cfg->threads = 0;
+  }
+
+  if (cfg->keepalive_timeout < 0) {
+    cfg->keepalive_timeout = 0;
+  }
+
   cfg->request_timeout_sec = cfg->request_timeout / 1000;
   cfg->request_timeout_usec = (cfg->request_timeout % 1000) * 1000;
 }
@@ -1112,12 +1288,37 @@ int info_plugin_init(const char * plugin_name, info_plugin_functions_t *plugin_f
 
   info_plugin_cache_init(true);
 
-  return plugin_ipc_init();
+  if (!plugin_ipc_init()) {
+    return 0;
+  }
+
+  return 1;
+}
+
+/**
+ * Undo info_plugin_init while olsrd keeps running, so that the plugin can be
+ * initialised again with new parameters
+ */
+void info_plugin_reconfigure(void) {
+  if (config && (config->threads <= 0) && (ipc_socket != -1)) {
+    remove_olsr_socket(ipc_socket, &ipc_action, NULL);
+  }
+  if (writetimer_entry) {
+    olsr_stop_timer(writetimer_entry);
+    writetimer_entry = NULL;
+  }
+
+  info_plugin_exit();
 }
 
 void info_plugin_exit(void) {
   int i;
 
+  if (config && (config->threads > 0) && (ipc_socket != -1)) {
+    info_server_stop();
+    olsr_snapshot_disable();
+  }
+
   if (ipc_socket != -1) {
     close(ipc_socket);
     ipc_socket = -1;
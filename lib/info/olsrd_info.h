@@ -50,6 +50,10 @@
 
 int info_plugin_init(const char * plugin_name, info_plugin_functions_t *plugin_functions, info_plugin_config_t *plugin_config);
 void info_plugin_exit(void);
+void info_plugin_reconfigure(void);
 long cache_timeout_generic(info_plugin_config_t *plugin_config, unsigned long long siw);
 
+struct olsr_snapshot;
+struct olsr_snapshot *info_snapshot(unsigned int sections);
+
 #endif /* _OLSRD_LIB_INFO_OLSRD_INFO_H_ */
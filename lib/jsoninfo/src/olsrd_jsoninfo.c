@@ -63,6 +63,9 @@
 #include "info/info_types.h"
 #include "info/http_headers.h"
 #include "info/json_helpers.h"
+#include "info/olsrd_info.h"
+#include "olsr_snapshot.h"
+#include "olsr_metrics.h"
 #include "gateway_default_handler.h"
 #include "egressTypes.h"
 #include "nmealib/info.h"
@@ -71,7 +74,8 @@
 #define UUIDLEN 256
 char uuid[UUIDLEN];
 
-static struct json_session json_session;
+/* per thread, the info plugin can render requests on its I/O threads */
+static __thread struct json_session json_session;
 
 struct timeval start_time;
 
@@ -121,7 +125,7 @@ void plugin_init(const char *plugin_name) {
 }
 
 unsigned long long get_supported_commands_mask(void) {
-  return SIW_ALL | SIW_OLSRD_CONF;
+  return SIW_ALL | SIW_OLSRD_CONF | SIW_METRICS;
 }
 
 bool isCommand(const char *str, unsigned long long siw) {
@@ -203,6 +207,10 @@ bool isCommand(const char *str, unsigned long long siw) {
       cmd = "/neighbours";
       break;
 
+    case SIW_METRICS:
+      cmd = "/metrics";
+      break;
+
     default:
       return false;
   }
@@ -375,10 +383,10 @@ static void print_interface_olsr(struct json_session *session, struct autobuf *a
 
 
   abuf_json_mark_object(session, true, false, abuf, "messageTimes");
-  abuf_json_int(session, abuf, "hello", rifs->hello_gen_timer ? (long) (rifs->hello_gen_timer->timer_clock - now_times) : 0);
-  abuf_json_int(session, abuf, "tc", rifs->tc_gen_timer ? (long) (rifs->tc_gen_timer->timer_clock - now_times) : 0);
-  abuf_json_int(session, abuf, "mid", rifs->mid_gen_timer ? (long) (rifs->mid_gen_timer->timer_clock - now_times) : 0);
-  abuf_json_int(session, abuf, "hna", rifs->hna_gen_timer ? (long) (rifs->hna_gen_timer->timer_clock - now_times) : 0);
+  abuf_json_int(session, abuf, "hello", rifs->hello_gen_timer ? (long) olsr_getTimeLeft(rifs->hello_gen_timer->timer_clock) : 0);
+  abuf_json_int(session, abuf, "tc", rifs->tc_gen_timer ? (long) olsr_getTimeLeft(rifs->tc_gen_timer->timer_clock) : 0);
+  abuf_json_int(session, abuf, "mid", rifs->mid_gen_timer ? (long) olsr_getTimeLeft(rifs->mid_gen_timer->timer_clock) : 0);
+  abuf_json_int(session, abuf, "hna", rifs->hna_gen_timer ? (long) olsr_getTimeLeft(rifs->hna_gen_timer->timer_clock) : 0);
   abuf_json_mark_object(session, false, false, abuf, NULL);
 
 #ifdef __linux__
@@ -441,8 +449,8 @@ static void ipc_print_gateway_entry(struct json_session *session, struct autobuf
   abuf_json_boolean(session, abuf, "IPv4", gw->ipv4);
   abuf_json_boolean(session, abuf, "IPv4-NAT", gw->ipv4nat);
   abuf_json_boolean(session, abuf, "IPv6", gw->ipv6);
-  abuf_json_int(session, abuf, "expireTime", gw->expire_timer ? (gw->expire_timer->timer_clock - now_times) : 0);
-  abuf_json_int(session, abuf, "cleanupTime", gw->cleanup_timer ? (gw->cleanup_timer->timer_clock - now_times) : 0);
+  abuf_json_int(session, abuf, "expireTime", gw->expire_timer ? (long) olsr_getTimeLeft(gw->expire_timer->timer_clock) : 0);
+  abuf_json_int(session, abuf, "cleanupTime", gw->cleanup_timer ? (long) olsr_getTimeLeft(gw->cleanup_timer->timer_clock) : 0);
 
   abuf_json_float(session, abuf, "pathcost", get_linkcost_scaled(!tc ? ROUTE_COST_BROKEN : tc->path_cost, true));
   abuf_json_int(session, abuf, "hops", !tc ? 0 : tc->hops);
@@ -450,7 +458,8 @@ static void ipc_print_gateway_entry(struct json_session *session, struct autobuf
 #endif /* __linux__ */
 
 static void ipc_print_neighbors_internal(struct json_session *session, struct autobuf *abuf, bool list_2hop) {
-  struct neighbor_entry *neigh;
+  struct olsr_snapshot *snapshot = info_snapshot(OLSR_SNAPSHOT_NEIGHBORS);
+  uint32_t i;
 
   assert(abuf);
 
@@ -461,9 +470,8 @@ static void ipc_print_neighbors_internal(struct json_session *session, struct au
   }
 
   /* Neighbors */
-  OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
-    struct neighbor_2_list_entry *list_2;
-    int thop_cnt = 0;
+  for (i = 0; i < snapshot->neighbor_count; i++) {
+    struct olsr_snapshot_neighbor *neigh = &snapshot->neighbors[i];
 
     abuf_json_mark_array_entry(session, true, abuf);
 
@@ -472,30 +480,24 @@ static void ipc_print_neighbors_internal(struct json_session *session, struct au
     abuf_json_int(session, abuf, "willingness", neigh->willingness);
     abuf_json_boolean(session, abuf, "isMultiPointRelay", neigh->is_mpr);
     abuf_json_boolean(session, abuf, "wasMultiPointRelay", neigh->was_mpr);
-    abuf_json_boolean(session, abuf, "multiPointRelaySelector", olsr_lookup_mprs_set(&neigh->neighbor_main_addr) != NULL);
+    abuf_json_boolean(session, abuf, "multiPointRelaySelector", neigh->is_mpr_selector);
     abuf_json_boolean(session, abuf, "skip", neigh->skip);
     abuf_json_int(session, abuf, "neighbor2nocov", neigh->neighbor_2_nocov);
     abuf_json_int(session, abuf, "linkcount", neigh->linkcount);
 
     if (list_2hop) {
-      abuf_json_mark_object(session, true, true, abuf, "twoHopNeighbors");
-    }
+      uint32_t j;
 
-    thop_cnt = 0;
-    for (list_2 = neigh->neighbor_2_list.next; list_2 != &neigh->neighbor_2_list; list_2 = list_2->next) {
-      if (list_2hop && list_2->neighbor_2) {
-        abuf_json_ip_address(session, abuf, NULL, &list_2->neighbor_2->neighbor_2_addr);
+      abuf_json_mark_object(session, true, true, abuf, "twoHopNeighbors");
+      for (j = 0; j < neigh->two_hop_count; j++) {
+        abuf_json_ip_address(session, abuf, NULL, &snapshot->two_hop[neigh->two_hop_first + j]);
       }
-      thop_cnt++;
-    }
-
-    if (list_2hop) {
       abuf_json_mark_object(session, false, true, abuf, NULL);
     }
-    abuf_json_int(session, abuf, "twoHopNeighborCount", thop_cnt);
+    abuf_json_int(session, abuf, "twoHopNeighborCount", neigh->two_hop_count);
 
     abuf_json_mark_array_entry(session, false, abuf);
-  } OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
+  }
   abuf_json_mark_object(session, false, true, abuf, NULL);
 }
 
@@ -504,13 +506,15 @@ void ipc_print_neighbors(struct autobuf *abuf) {
 }
 
 void ipc_print_links(struct autobuf *abuf) {
-  struct link_entry *my_link;
+  struct olsr_snapshot *snapshot = info_snapshot(OLSR_SNAPSHOT_LINKS);
+  uint32_t i;
 
   abuf_json_mark_object(&json_session, true, true, abuf, "links");
 
-  OLSR_FOR_ALL_LINK_ENTRIES(my_link) {
-    struct lqtextbuffer lqBuffer;
-    const char* lqString = get_link_entry_text(my_link, '\t', &lqBuffer);
+  for (i = 0; i < snapshot->link_count; i++) {
+    struct olsr_snapshot_link *my_link = &snapshot->links[i];
+    struct lqtextbuffer lqBuffer = my_link->lq;
+    const char* lqString = lqBuffer.buf;
     char * nlqString = strrchr(lqString, '\t');
 
     if (nlqString) {
@@ -522,26 +526,26 @@ void ipc_print_links(struct autobuf *abuf) {
 
     abuf_json_ip_address(&json_session, abuf, "localIP", &my_link->local_iface_addr);
     abuf_json_ip_address(&json_session, abuf, "remoteIP", &my_link->neighbor_iface_addr);
-    abuf_json_string(&json_session, abuf, "olsrInterface", (my_link->inter && my_link->inter->int_name) ? my_link->inter->int_name : "");
-    abuf_json_string(&json_session, abuf, "ifName", my_link->if_name ? my_link->if_name : "");
-    abuf_json_int(&json_session, abuf, "validityTime", my_link->link_timer ? (long) (my_link->link_timer->timer_clock - now_times) : 0);
-    abuf_json_int(&json_session, abuf, "symmetryTime", my_link->link_sym_timer ? (long) (my_link->link_sym_timer->timer_clock - now_times) : 0);
+    abuf_json_string(&json_session, abuf, "olsrInterface", my_link->olsr_if_name);
+    abuf_json_string(&json_session, abuf, "ifName", my_link->if_name);
+    abuf_json_int(&json_session, abuf, "validityTime", (long) olsr_getTimeLeft(my_link->link_timer));
+    abuf_json_int(&json_session, abuf, "symmetryTime", (long) olsr_getTimeLeft(my_link->link_sym_timer));
     abuf_json_int(&json_session, abuf, "asymmetryTime", my_link->ASYM_time);
     abuf_json_int(&json_session, abuf, "vtime", (long) my_link->vtime);
     // neighbor (no need to print, can be looked up via neighbours)
-    abuf_json_string(&json_session, abuf, "currentLinkStatus", linkTypeToString(lookup_link_status(my_link)));
+    abuf_json_string(&json_session, abuf, "currentLinkStatus", linkTypeToString(my_link->status));
     abuf_json_string(&json_session, abuf, "previousLinkStatus", linkTypeToString(my_link->prev_status));
 
     abuf_json_float(&json_session, abuf, "hysteresis", my_link->L_link_quality);
-    abuf_json_boolean(&json_session, abuf, "pending", my_link->L_link_pending != 0);
+    abuf_json_boolean(&json_session, abuf, "pending", my_link->L_link_pending);
     abuf_json_int(&json_session, abuf, "lostLinkTime", (long) my_link->L_LOST_LINK_time);
-    abuf_json_int(&json_session, abuf, "helloTime", my_link->link_hello_timer ? (long) (my_link->link_hello_timer->timer_clock - now_times) : 0);
+    abuf_json_int(&json_session, abuf, "helloTime", (long) olsr_getTimeLeft(my_link->link_hello_timer));
     abuf_json_int(&json_session, abuf, "lastHelloTime", (long) my_link->last_htime);
     abuf_json_boolean(&json_session, abuf, "seqnoValid", my_link->olsr_seqno_valid);
     abuf_json_int(&json_session, abuf, "seqno", my_link->olsr_seqno);
 
     abuf_json_int(&json_session, abuf, "lossHelloInterval", (long) my_link->loss_helloint);
-    abuf_json_int(&json_session, abuf, "lossTime", my_link->link_loss_timer ? (long) (my_link->link_loss_timer->timer_clock - now_times) : 0);
+    abuf_json_int(&json_session, abuf, "lossTime", (long) olsr_getTimeLeft(my_link->link_loss_timer));
 
     abuf_json_int(&json_session, abuf, "lossMultiplier", (long) my_link->loss_link_multiplier);
 
@@ -551,160 +555,145 @@ void ipc_print_links(struct autobuf *abuf) {
     abuf_json_float(&json_session, abuf, "neighborLinkQuality", nlqString ? atof(nlqString) : 0.0);
 
     abuf_json_mark_array_entry(&json_session, false, abuf);
-  } OLSR_FOR_ALL_LINK_ENTRIES_END(my_link);
+  }
   abuf_json_mark_object(&json_session, false, true, abuf, NULL);
 }
 
 void ipc_print_routes(struct autobuf *abuf) {
-  struct rt_entry *rt;
+  struct olsr_snapshot *snapshot = info_snapshot(OLSR_SNAPSHOT_ROUTES);
+  uint32_t i;
 
   abuf_json_mark_object(&json_session, true, true, abuf, "routes");
 
   /* Walk the route table */
-  OLSR_FOR_ALL_RT_ENTRIES(rt) {
-    if (rt->rt_best) {
-      abuf_json_mark_array_entry(&json_session, true, abuf);
-      abuf_json_ip_address(&json_session, abuf, "destination", &rt->rt_dst.prefix);
-      abuf_json_int(&json_session, abuf, "genmask", rt->rt_dst.prefix_len);
-      abuf_json_ip_address(&json_session, abuf, "gateway", &rt->rt_best->rtp_nexthop.gateway);
-      abuf_json_int(&json_session, abuf, "metric", rt->rt_best->rtp_metric.hops);
-      abuf_json_float(&json_session, abuf, "etx", get_linkcost_scaled(rt->rt_best->rtp_metric.cost, true));
-      abuf_json_float(&json_session, abuf, "rtpMetricCost", get_linkcost_scaled(rt->rt_best->rtp_metric.cost, true));
-      abuf_json_string(&json_session, abuf, "networkInterface", if_ifwithindex_name(rt->rt_best->rtp_nexthop.iif_index));
-      abuf_json_mark_array_entry(&json_session, false, abuf);
-    }
-  } OLSR_FOR_ALL_RT_ENTRIES_END(rt);
+  for (i = 0; i < snapshot->route_count; i++) {
+    struct olsr_snapshot_route *rt = &snapshot->routes[i];
+
+    abuf_json_mark_array_entry(&json_session, true, abuf);
+    abuf_json_ip_address(&json_session, abuf, "destination", &rt->rt_dst.prefix);
+    abuf_json_int(&json_session, abuf, "genmask", rt->rt_dst.prefix_len);
+    abuf_json_ip_address(&json_session, abuf, "gateway", &rt->gateway);
+    abuf_json_int(&json_session, abuf, "metric", rt->hops);
+    abuf_json_float(&json_session, abuf, "etx", get_linkcost_scaled(rt->cost, true));
+    abuf_json_float(&json_session, abuf, "rtpMetricCost", get_linkcost_scaled(rt->cost, true));
+    abuf_json_string(&json_session, abuf, "networkInterface", rt->if_name);
+    abuf_json_mark_array_entry(&json_session, false, abuf);
+  }
 
   abuf_json_mark_object(&json_session, false, true, abuf, NULL);
 }
 
 void ipc_print_topology(struct autobuf *abuf) {
-  struct tc_entry *tc;
+  struct olsr_snapshot *snapshot = info_snapshot(OLSR_SNAPSHOT_TOPOLOGY);
+  uint32_t i;
 
   abuf_json_mark_object(&json_session, true, true, abuf, "topology");
 
   /* Topology */
-  OLSR_FOR_ALL_TC_ENTRIES(tc) {
-    struct tc_edge_entry *tc_edge;
-    OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
-      if (tc_edge->edge_inv) {
-        struct lqtextbuffer lqbuffer;
-        const char* lqString = get_tc_edge_entry_text(tc_edge, '\t', &lqbuffer);
-        char * nlqString = strrchr(lqString, '\t');
-
-        if (nlqString) {
-          *nlqString = '\0';
-          nlqString++;
-        }
+  for (i = 0; i < snapshot->tc_count; i++) {
+    struct olsr_snapshot_tc *tc = &snapshot->tcs[i];
+    uint32_t j;
+
+    for (j = 0; j < tc->edge_count; j++) {
+      struct olsr_snapshot_edge *tc_edge = &snapshot->edges[tc->edge_first + j];
+      struct lqtextbuffer lqbuffer = tc_edge->lq;
+      const char* lqString = lqbuffer.buf;
+      char * nlqString = strrchr(lqString, '\t');
+
+      if (nlqString) {
+        *nlqString = '\0';
+        nlqString++;
+      }
 
-        abuf_json_mark_array_entry(&json_session, true, abuf);
+      abuf_json_mark_array_entry(&json_session, true, abuf);
 
-        // vertex_node
-        abuf_json_ip_address(&json_session, abuf, "lastHopIP", &tc->addr);
-        // cand_tree_node
-        abuf_json_float(&json_session, abuf, "pathCost", get_linkcost_scaled(tc->path_cost, true));
-        // path_list_node
-        // edge_tree
-        // prefix_tree
-        // next_hop
-        // edge_gc_timer
-        abuf_json_int(&json_session, abuf, "validityTime", tc->validity_timer ? (tc->validity_timer->timer_clock - now_times) : 0);
-        abuf_json_int(&json_session, abuf, "refCount", tc->refcount);
-        abuf_json_int(&json_session, abuf, "msgSeq", tc->msg_seq);
-        abuf_json_int(&json_session, abuf, "msgHops", tc->msg_hops);
-        abuf_json_int(&json_session, abuf, "hops", tc->hops);
-        abuf_json_int(&json_session, abuf, "ansn", tc->ansn);
-        abuf_json_int(&json_session, abuf, "tcIgnored", tc->ignored);
-
-        abuf_json_int(&json_session, abuf, "errSeq", tc->err_seq);
-        abuf_json_boolean(&json_session, abuf, "errSeqValid", tc->err_seq_valid);
-
-        // edge_node
-        abuf_json_ip_address(&json_session, abuf, "destinationIP", &tc_edge->T_dest_addr);
-        // tc
-        abuf_json_float(&json_session, abuf, "tcEdgeCost", get_linkcost_scaled(tc_edge->cost, true));
-        abuf_json_int(&json_session, abuf, "ansnEdge", tc_edge->ansn);
-        abuf_json_float(&json_session, abuf, "linkQuality", atof(lqString));
-        abuf_json_float(&json_session, abuf, "neighborLinkQuality", nlqString ? atof(nlqString) : 0.0);
+      // vertex_node
+      abuf_json_ip_address(&json_session, abuf, "lastHopIP", &tc->addr);
+      // cand_tree_node
+      abuf_json_float(&json_session, abuf, "pathCost", get_linkcost_scaled(tc->path_cost, true));
+      // path_list_node
+      // edge_tree
+      // prefix_tree
+      // next_hop
+      // edge_gc_timer
+      abuf_json_int(&json_session, abuf, "validityTime", (long) olsr_getTimeLeft(tc->validity_timer));
+      abuf_json_int(&json_session, abuf, "refCount", tc->refcount);
+      abuf_json_int(&json_session, abuf, "msgSeq", tc->msg_seq);
+      abuf_json_int(&json_session, abuf, "msgHops", tc->msg_hops);
+      abuf_json_int(&json_session, abuf, "hops", tc->hops);
+      abuf_json_int(&json_session, abuf, "ansn", tc->ansn);
+      abuf_json_int(&json_session, abuf, "tcIgnored", tc->ignored);
+
+      abuf_json_int(&json_session, abuf, "errSeq", tc->err_seq);
+      abuf_json_boolean(&json_session, abuf, "errSeqValid", tc->err_seq_valid);
+
+      // edge_node
+      abuf_json_ip_address(&json_session, abuf, "destinationIP", &tc_edge->T_dest_addr);
+      // tc
+      abuf_json_float(&json_session, abuf, "tcEdgeCost", get_linkcost_scaled(tc_edge->cost, true));
+      abuf_json_int(&json_session, abuf, "ansnEdge", tc_edge->ansn);
+      abuf_json_float(&json_session, abuf, "linkQuality", atof(lqString));
+      abuf_json_float(&json_session, abuf, "neighborLinkQuality", nlqString ? atof(nlqString) : 0.0);
 
-        abuf_json_mark_array_entry(&json_session, false, abuf);
-      }
-    } OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
-  } OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+      abuf_json_mark_array_entry(&json_session, false, abuf);
+    }
+  }
 
   abuf_json_mark_object(&json_session, false, true, abuf, NULL);
 }
 
 void ipc_print_hna(struct autobuf *abuf) {
-  struct ip_prefix_list *hna;
-  struct hna_entry *tmp_hna;
+  struct olsr_snapshot *snapshot = info_snapshot(OLSR_SNAPSHOT_HNA);
+  uint32_t i;
 
   abuf_json_mark_object(&json_session, true, true, abuf, "hna");
 
-  /* Announced HNA entries */
-  for (hna = olsr_cnf->hna_entries; hna != NULL ; hna = hna->next) {
+  /* Announced HNA entries come first */
+  for (i = 0; i < snapshot->hna_count; i++) {
+    struct olsr_snapshot_hna *hna = &snapshot->hnas[i];
+
     print_hna_array_entry( //
         &json_session, //
         abuf, //
-        &olsr_cnf->main_addr, //
+        &hna->gateway, //
         &hna->net.prefix, //
         hna->net.prefix_len, //
-        0);
+        (long) olsr_getTimeLeft(hna->hna_net_timer));
   }
 
-  OLSR_FOR_ALL_HNA_ENTRIES(tmp_hna) {
-    struct hna_net *tmp_net;
-
-    /* Check all networks */
-    for (tmp_net = tmp_hna->networks.next; tmp_net != &tmp_hna->networks; tmp_net = tmp_net->next) {
-      print_hna_array_entry( //
-          &json_session, //
-          abuf, //
-          &tmp_hna->A_gateway_addr, //
-          &tmp_net->hna_prefix.prefix, //
-          tmp_net->hna_prefix.prefix_len, //
-          tmp_net->hna_net_timer ? (tmp_net->hna_net_timer->timer_clock - now_times) : 0);
-    }
-  } OLSR_FOR_ALL_HNA_ENTRIES_END(tmp_hna);
-
   abuf_json_mark_object(&json_session, false, true, abuf, NULL);
 }
 
 void ipc_print_mid(struct autobuf *abuf) {
-  int idx;
+  struct olsr_snapshot *snapshot = info_snapshot(OLSR_SNAPSHOT_MID);
+  uint32_t i;
 
   abuf_json_mark_object(&json_session, true, true, abuf, "mid");
 
   /* MID */
-  for (idx = 0; idx < HASHSIZE; idx++) {
-    struct mid_entry * entry = mid_set[idx].next;
-
-    while (entry != &mid_set[idx]) {
-      abuf_json_mark_array_entry(&json_session, true, abuf);
+  for (i = 0; i < snapshot->mid_count; i++) {
+    struct olsr_snapshot_mid *entry = &snapshot->mids[i];
+    uint32_t j;
 
-      abuf_json_mark_object(&json_session, true, false, abuf, "main");
-      abuf_json_ip_address(&json_session, abuf, "ipAddress", &entry->main_addr);
-      abuf_json_int(&json_session, abuf, "validityTime", entry->mid_timer ? (entry->mid_timer->timer_clock - now_times) : 0);
-      abuf_json_mark_object(&json_session, false, false, abuf, NULL); // main
+    abuf_json_mark_array_entry(&json_session, true, abuf);
 
-      {
-        struct mid_address * alias = entry->aliases;
+    abuf_json_mark_object(&json_session, true, false, abuf, "main");
+    abuf_json_ip_address(&json_session, abuf, "ipAddress", &entry->main_addr);
+    abuf_json_int(&json_session, abuf, "validityTime", (long) olsr_getTimeLeft(entry->mid_timer));
+    abuf_json_mark_object(&json_session, false, false, abuf, NULL); // main
 
-        abuf_json_mark_object(&json_session, true, true, abuf, "aliases");
-        while (alias) {
-          abuf_json_mark_array_entry(&json_session, true, abuf);
-          abuf_json_ip_address(&json_session, abuf, "ipAddress", &alias->alias);
-          abuf_json_int(&json_session, abuf, "validityTime", alias->vtime - now_times);
-          abuf_json_mark_array_entry(&json_session, false, abuf);
+    abuf_json_mark_object(&json_session, true, true, abuf, "aliases");
+    for (j = 0; j < entry->alias_count; j++) {
+      struct olsr_snapshot_alias *alias = &snapshot->aliases[entry->alias_first + j];
 
-          alias = alias->next_alias;
-        }
-        abuf_json_mark_object(&json_session, false, true, abuf, NULL); // aliases
-      }
-      abuf_json_mark_array_entry(&json_session, false, abuf); // entry
-
-      entry = entry->next;
+      abuf_json_mark_array_entry(&json_session, true, abuf);
+      abuf_json_ip_address(&json_session, abuf, "ipAddress", &alias->alias);
+      abuf_json_int(&json_session, abuf, "validityTime", (long) olsr_getTimeLeft(alias->vtime));
+      abuf_json_mark_array_entry(&json_session, false, abuf);
     }
+    abuf_json_mark_object(&json_session, false, true, abuf, NULL); // aliases
+
+    abuf_json_mark_array_entry(&json_session, false, abuf); // entry
   }
   abuf_json_mark_object(&json_session, false, true, abuf, NULL); // mid
 }
@@ -1392,3 +1381,52 @@ void ipc_print_plugins(struct autobuf *abuf) {
   }
   abuf_json_mark_object(&json_session, false, true, abuf, NULL);
 }
+
+void ipc_print_metrics(struct autobuf *abuf) {
+  struct olsr_metric_values values;
+  struct olsr_metric *metric;
+
+  abuf_json_boolean(&json_session, abuf, "metricsRecording", olsr_metrics_users > 0);
+
+  abuf_json_mark_object(&json_session, true, true, abuf, "metrics");
+  OLSR_FOR_ALL_METRICS(metric) {
+    olsr_metric_read(metric, &values);
+
+    abuf_json_mark_array_entry(&json_session, true, abuf);
+    abuf_json_string(&json_session, abuf, "name", metric->name);
+    abuf_json_string(&json_session, abuf, "type", (metric->type == OLSR_METRIC_LATENCY) ? "latency" : "counter");
+    if (metric->label_name) {
+      abuf_json_string(&json_session, abuf, "labelName", metric->label_name);
+      abuf_json_string(&json_session, abuf, "label", metric->label);
+    }
+    abuf_json_int(&json_session, abuf, "count", (long long) values.count);
+
+    if (metric->type == OLSR_METRIC_LATENCY) {
+      unsigned int i;
+
+      abuf_json_float(&json_session, abuf, "sumUsec", (double) values.sum / 1000.0);
+      abuf_json_float(&json_session, abuf, "meanUsec", values.count ? (double) values.sum / (double) values.count / 1000.0 : 0.0);
+      abuf_json_float(&json_session, abuf, "maxUsec", (double) values.max / 1000.0);
+      abuf_json_float(&json_session, abuf, "p50Usec", olsr_metric_quantile(&values, 0.5) / 1000.0);
+      abuf_json_float(&json_session, abuf, "p90Usec", olsr_metric_quantile(&values, 0.9) / 1000.0);
+      abuf_json_float(&json_session, abuf, "p99Usec", olsr_metric_quantile(&values, 0.99) / 1000.0);
+      abuf_json_float(&json_session, abuf, "p999Usec", olsr_metric_quantile(&values, 0.999) / 1000.0);
+
+      /* the non-empty buckets, bounds in nanoseconds */
+      abuf_json_mark_object(&json_session, true, true, abuf, "buckets");
+      for (i = 0; i < OLSR_METRIC_BUCKETS; i++) {
+        if (!values.buckets[i]) {
+          continue;
+        }
+        abuf_json_mark_array_entry(&json_session, true, abuf);
+        abuf_json_int(&json_session, abuf, "lowerNsec", (long long) olsr_metric_bucket_lower(i));
+        abuf_json_int(&json_session, abuf, "upperNsec", (long long) olsr_metric_bucket_upper(i));
+        abuf_json_int(&json_session, abuf, "count", (long long) values.buckets[i]);
+        abuf_json_mark_array_entry(&json_session, false, abuf);
+      }
+      abuf_json_mark_object(&json_session, false, true, abuf, NULL);
+    }
+    abuf_json_mark_array_entry(&json_session, false, abuf);
+  }
+  abuf_json_mark_object(&json_session, false, true, abuf, NULL);
+}
@@ -79,5 +79,6 @@ void ipc_print_interfaces(struct autobuf *abuf);
 void ipc_print_twohop(struct autobuf *abuf);
 void ipc_print_config(struct autobuf *abuf);
 void ipc_print_plugins(struct autobuf *abuf);
+void ipc_print_metrics(struct autobuf *abuf);
 
 #endif /* LIB_JSONINFO_SRC_OLSRD_JSONINFO_H_ */
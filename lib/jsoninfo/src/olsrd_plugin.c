@@ -99,6 +99,7 @@ int olsrd_plugin_init(void) {
   memset(&functions, 0, sizeof(functions));
 
   functions.supportsCompositeCommands = true;
+  functions.snapshot_commands = SIW_NEIGHBORS | SIW_LINKS | SIW_ROUTES | SIW_HNA | SIW_MID | SIW_TOPOLOGY | SIW_2HOP;
   functions.init = plugin_init;
   functions.supported_commands_mask = get_supported_commands_mask;
   functions.is_command = isCommand;
@@ -123,6 +124,7 @@ int olsrd_plugin_init(void) {
   functions.twohop = ipc_print_twohop;
   functions.config = ipc_print_config;
   functions.plugins = ipc_print_plugins;
+  functions.metrics = ipc_print_metrics;
 
   return info_plugin_init(PLUGIN_NAME, &functions, &config);
 }
@@ -134,6 +136,18 @@ void olsr_plugin_exit(void) {
   info_plugin_exit();
 }
 
+/**
+ * reconfiguration - restore the parameter defaults, olsrd_plugin_init is called again
+ */
+int olsrd_plugin_reconfigure(void) {
+  info_plugin_reconfigure();
+
+  info_plugin_config_init(&config, 9090);
+  memset(uuidfile, 0, sizeof(uuidfile));
+  pretty = false;
+  return 0;
+}
+
 int olsrd_plugin_interface_version(void) {
   return PLUGIN_INTERFACE_VERSION;
 }
@@ -71,6 +71,9 @@
 #include "mid_set.h"            /* mid_lookup_main_addr() */
 #include "link_set.h"           /* get_best_link_to_neighbor() */
 #include "net_olsr.h"           /* ipequal */
+#include "hashing.h"            /* olsr_ip_hashing() */
+#include "scheduler.h"          /* olsr_start_timer() */
+#include "olsr_cookie.h"        /* olsr_alloc_cookie() */
 
 /* plugin includes */
 #include "NetworkInterfaces.h"  /* TBmfInterface, CreateBmfNetworkInterfaces(), CloseBmfNetworkInterfaces() */
@@ -80,28 +83,56 @@
 #include "RouterElection.h"
 #include "list_backport.h"
 
-#define OLSR_FOR_ALL_FILTEREDNODES_ENTRIES(n, iterator) listbackport_for_each_element_safe(&ListOfFilteredHosts, n, list, iterator)
+#define OLSR_FOR_ALL_FILTEREDNODES_ENTRIES(n, iterator, bucket) listbackport_for_each_element_safe(&FilteredHosts[bucket], n, list, iterator)
 
-#define IPH_HL(hdr) (((hdr)->ip_hl)*4)
+/* The size of the cache of recently relayed packets, a power of 2 */
+#define DUPLICATE_CACHE_SIZE 1024
 
-struct list_entity ListOfFilteredHosts;
-int FHListInit = 0;
+/* Hash table of the filtered hosts, indexed by olsr_ip_hashing() */
+static struct list_entity FilteredHosts[HASHSIZE];
+static unsigned int FilteredHostCount = 0;
+static int FHListInit = 0;
 
-static uint16_t ip_checksum(char* data, int len)
+/* The time (ms) in which a repeated packet is not relayed again, 0 to relay all */
+int my_DuplicateWindow = MDNS_DUPLICATE_WINDOW;
+
+/* The time (ms) to collect captured packets into one OLSR message, 0 to send each packet right away */
+int my_AggregationInterval = 0;
+
+/* Content hashes of the recently relayed packets */
+struct DuplicateEntry {
+  uint32_t hash;
+  uint32_t expires;
+};
+
+static struct DuplicateEntry DuplicateCache[DUPLICATE_CACHE_SIZE];
+
+/* Captured packets waiting to be sent in one OLSR message, each one padded to 4 bytes */
+static unsigned char AggregatedPackets[MDNS_AGGREGATION_MAX];
+static int AggregatedLength = 0;
+static int AggregatedCount = 0;
+
+static struct timer_entry *AggregationTimer = NULL;
+static struct olsr_cookie_info *AggregationTimerCookie = NULL;
+
+/* Update an IP header checksum for a changed 16 bit word (RFC 1624, eqn. 3) */
+static uint16_t ip_checksum_update(uint16_t check, uint16_t oldWord, uint16_t newWord)
 {
-    uint sum = 0;
-    if ((len & 1) == 0)
-        len = len >> 1;
-    else
-        len = (len >> 1) + 1;
-    while (len > 0) {
-        sum += *((unsigned short int*)(void *)data);
-        data += sizeof(unsigned short int);
-        len--;
-    }
-    sum = (sum >> 16) + (sum & 0xffff);
-    sum += (sum >> 16);
-    return(~sum);
+  uint32_t sum = (uint16_t)~check + (uint16_t)~oldWord + newWord;
+
+  sum = (sum >> 16) + (sum & 0xffff);
+  sum += (sum >> 16);
+  return (uint16_t)~sum;
+}
+
+/* FNV-1a */
+static uint32_t content_hash(uint32_t hash, const unsigned char *data, int len)
+{
+  while (len-- > 0) {
+    hash ^= *data++;
+    hash *= 16777619U;
+  }
+  return hash;
 }
 
 
@@ -122,7 +153,7 @@ PacketReceivedFromOLSR(unsigned char *encapsulationUdpData, int len)
   //union olsr_ip_addr mcDst;            /* Multicast destination of the encapsulated packet */
   struct TBmfInterface *walker;
   int stripped_len = 0;
-  uint16_t csum_ip;
+  uint16_t protocol = 0;
   ipHeader = (struct ip *)ARM_NOWARN_ALIGN(encapsulationUdpData);
   ip6Header = (struct ip6_hdr *)ARM_NOWARN_ALIGN(encapsulationUdpData);
 
@@ -130,6 +161,32 @@ PacketReceivedFromOLSR(unsigned char *encapsulationUdpData, int len)
   //mcDst.v4 = ipHeader->ip_dst;
   //OLSR_DEBUG(LOG_PLUGINS, "MDNS PLUGIN got packet from OLSR message\n");
 
+  if ((encapsulationUdpData[0] & 0xf0) == 0x40) {
+    protocol = htons(ETH_P_IP);
+    stripped_len = ntohs(ipHeader->ip_len);
+    if (my_TTL_Check && ipHeader->ip_ttl != 1) {
+      /* TTL and protocol form one 16 bit word of the header, only update the checksum for it */
+      uint16_t oldWord, newWord;
+
+      memcpy(&oldWord, &ipHeader->ip_ttl, sizeof(oldWord));
+      ipHeader->ip_ttl = (u_int8_t) 1; //setting up TTL to 1 to avoid mdns packets flood
+      memcpy(&newWord, &ipHeader->ip_ttl, sizeof(newWord));
+      ipHeader->ip_sum = ip_checksum_update(ipHeader->ip_sum, oldWord, newWord);
+    }
+  } else if ((encapsulationUdpData[0] & 0xf0) == 0x60) {
+    protocol = htons(ETH_P_IPV6);
+    stripped_len = 40 + ntohs(ip6Header->ip6_plen); //IPv6 Header size (40) + payload_len
+    if (my_TTL_Check)
+      ip6Header->ip6_hops = (uint8_t) 1; //setting up Hop Limit to 1 to avoid mdns packets flood
+  }
+  // Sven-Ola: Don't know how to handle the "stripped_len is uninitialized" condition, maybe olsr_exit is better...?
+  if (0 == stripped_len) return;
+  //TODO: if packet is not IP die here
+
+  if (stripped_len > len) {
+    //OLSR_DEBUG(LOG_PLUGINS, "MDNS: Stripped len bigger than len ??\n");
+    return;
+  }
 
   /* Check with each network interface what needs to be done on it */
   for (walker = BmfInterfaces; walker != NULL; walker = walker->next) {
@@ -140,30 +197,7 @@ PacketReceivedFromOLSR(unsigned char *encapsulationUdpData, int len)
 
       memset(&dest, 0, sizeof(dest));
       dest.sll_family = AF_PACKET;
-      if ((encapsulationUdpData[0] & 0xf0) == 0x40) {
-        dest.sll_protocol = htons(ETH_P_IP);
-	stripped_len = ntohs(ipHeader->ip_len);
-	if(my_TTL_Check)
-		ipHeader->ip_ttl = (u_int8_t) 1; //setting up TTL to 1 to avoid mdns packets flood 
-	}
-	//Recalculate IP Checksum
-	ipHeader->ip_sum=0x0000;
-	csum_ip = ip_checksum((char*)ipHeader, IPH_HL(ipHeader));
-	ipHeader->ip_sum=csum_ip;
-
-      if ((encapsulationUdpData[0] & 0xf0) == 0x60) {
-        dest.sll_protocol = htons(ETH_P_IPV6);
-        stripped_len = 40 + ntohs(ip6Header->ip6_plen); //IPv6 Header size (40) + payload_len 
-        if(my_TTL_Check)
-		ip6Header->ip6_hops = (uint8_t) 1; //setting up Hop Limit to 1 to avoid mdns packets flood
-        }
-      // Sven-Ola: Don't know how to handle the "stripped_len is uninitialized" condition, maybe olsr_exit is better...?
-      if (0 == stripped_len) return;
-      //TODO: if packet is not IP die here
-      
-      if (stripped_len > len) {
-	//OLSR_DEBUG(LOG_PLUGINS, "MDNS: Stripped len bigger than len ??\n");
-	}
+      dest.sll_protocol = protocol;
       dest.sll_ifindex = if_nametoindex(walker->ifName);
       dest.sll_halen = IFHWADDRLEN;
 
@@ -194,20 +228,67 @@ PacketReceivedFromOLSR(unsigned char *encapsulationUdpData, int len)
   }
 }                               /* PacketReceivedFromOLSR */
 
+/* -------------------------------------------------------------------------
+ * Function   : AggregatedPacketsReceivedFromOLSR
+ * Description: Handle the packets of a received aggregated OLSR message
+ * Input      : data - the packets, each one padded to 4 bytes
+ *              len - the length of the packets
+ * Output     : none
+ * Return     : none
+ * Data Used  : none
+ * ------------------------------------------------------------------------- */
+static void
+AggregatedPacketsReceivedFromOLSR(unsigned char *data, int len)
+{
+  while (len >= (int)sizeof(struct ip)) {
+    int packetLen;
+
+    if ((data[0] & 0xf0) == 0x40) {
+      packetLen = ntohs(((struct ip *)ARM_NOWARN_ALIGN(data))->ip_len);
+    } else if ((data[0] & 0xf0) == 0x60 && len >= (int)sizeof(struct ip6_hdr)) {
+      packetLen = 40 + ntohs(((struct ip6_hdr *)ARM_NOWARN_ALIGN(data))->ip6_plen);
+    } else {
+      return;
+    }
+    if (packetLen < (int)sizeof(struct ip) || packetLen > len) {
+      return;
+    }
+
+    PacketReceivedFromOLSR(data, packetLen);
+
+    packetLen = (packetLen + 3) & ~3;
+    data += packetLen;
+    len -= packetLen;
+  }
+}                               /* AggregatedPacketsReceivedFromOLSR */
+
+/* The size of the OLSR message header */
+static int
+olsr_mdns_header_size(void)
+{
+  union olsr_message *m = NULL;
+
+  return olsr_cnf->ip_version == AF_INET
+    ? (int)((char *)&m->v4.message - (char *)m)
+    : (int)((char *)&m->v6.message - (char *)m);
+}
 
 bool
 olsr_parser(union olsr_message *m, struct interface_olsr *in_if __attribute__ ((unused)), union olsr_ip_addr *ipaddr)
 {
   union olsr_ip_addr originator;
+  unsigned char *data;
   int size;
   //OLSR_DEBUG(LOG_PLUGINS, "MDNS PLUGIN: Received msg in parser\n");
   /* Fetch the originator of the messsage */
   if (olsr_cnf->ip_version == AF_INET) {
     memcpy(&originator, &m->v4.originator, olsr_cnf->ipsize);
     size = ntohs(m->v4.olsr_msgsize);
+    data = (unsigned char *)&m->v4.message;
   } else {
     memcpy(&originator, &m->v6.originator, olsr_cnf->ipsize);
     size = ntohs(m->v6.olsr_msgsize);
+    data = (unsigned char *)&m->v6.message;
   }
 
   /* Check if message originated from this node.
@@ -223,18 +304,19 @@ olsr_parser(union olsr_message *m, struct interface_olsr *in_if __attribute__ ((
     return false;
   }
 
-  if (olsr_cnf->ip_version == AF_INET) {
-    PacketReceivedFromOLSR((unsigned char *)&m->v4.message, size - 12);
+  /* the message type is at the same place for IPv4 and IPv6 */
+  if (m->v4.olsr_msgtype == MESSAGE_TYPE_AGGREGATED) {
+    AggregatedPacketsReceivedFromOLSR(data, size - olsr_mdns_header_size());
   } else {
-    PacketReceivedFromOLSR((unsigned char *)&m->v6.message, size - 12 - 96);
+    PacketReceivedFromOLSR(data, size - olsr_mdns_header_size());
   }
 //forward the message
 return true;
 }
 
-//Sends a packet in the OLSR network
-void
-olsr_mdns_gen(unsigned char *packet, int len)
+//Sends packets in the OLSR network, in a message of the given type
+static void
+olsr_mdns_gen_type(uint8_t type, unsigned char *packet, int len)
 {
   /* send buffer: huge */
   char buffer[10240];
@@ -251,7 +333,7 @@ if ((aligned_size % 4) != 0) {
   /* fill message */
   if (olsr_cnf->ip_version == AF_INET) {
     /* IPv4 */
-    message->v4.olsr_msgtype = MESSAGE_TYPE;
+    message->v4.olsr_msgtype = type;
     message->v4.olsr_vtime = reltime_to_me(MDNS_VALID_TIME * MSEC_PER_SEC);
     memcpy(&message->v4.originator, &olsr_cnf->main_addr, olsr_cnf->ipsize);
     //message->v4.ttl = MAX_TTL;
@@ -260,14 +342,11 @@ if ((aligned_size % 4) != 0) {
     message->v4.hopcnt = 0;
     message->v4.seqno = htons(get_msg_seqno());
 
-    message->v4.olsr_msgsize = htons(aligned_size + 12);
-
     memset(&message->v4.message, 0, aligned_size);
     memcpy(&message->v4.message, packet, len);
-    aligned_size = aligned_size + 12;
   } else {
     /* IPv6 */
-    message->v6.olsr_msgtype = MESSAGE_TYPE;
+    message->v6.olsr_msgtype = type;
     message->v6.olsr_vtime = reltime_to_me(MDNS_VALID_TIME * MSEC_PER_SEC);
     memcpy(&message->v6.originator, &olsr_cnf->main_addr, olsr_cnf->ipsize);
     //message->v6.ttl = MAX_TTL;
@@ -276,12 +355,14 @@ if ((aligned_size % 4) != 0) {
     message->v6.hopcnt = 0;
     message->v6.seqno = htons(get_msg_seqno());
 
-    message->v6.olsr_msgsize = htons(aligned_size + 12 + 96);
     memset(&message->v6.message, 0, aligned_size);
     memcpy(&message->v6.message, packet, len);
-    aligned_size = aligned_size + 12 + 96;
   }
 
+  /* the message size is at the same place for IPv4 and IPv6 */
+  aligned_size += olsr_mdns_header_size();
+  message->v4.olsr_msgsize = htons(aligned_size);
+
   /* looping trough interfaces */
  for (ifn = ifnet; ifn; ifn = ifn->int_next) {
     //OLSR_PRINTF(1, "MDNS PLUGIN: Generating packet - [%s]\n", ifn->int_name);
@@ -296,6 +377,111 @@ if ((aligned_size % 4) != 0) {
   }
 }
 
+//Sends a packet in the OLSR network
+void
+olsr_mdns_gen(unsigned char *packet, int len)
+{
+  olsr_mdns_gen_type(MESSAGE_TYPE, packet, len);
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : FlushAggregatedPackets
+ * Description: Send the captured packets that wait to be aggregated. A
+ *              single packet is sent in a normal message.
+ * Input      : none
+ * Output     : none
+ * Return     : none
+ * Data Used  : AggregatedPackets
+ * ------------------------------------------------------------------------- */
+static void
+FlushAggregatedPackets(void)
+{
+  if (AggregationTimer) {
+    olsr_stop_timer(AggregationTimer);
+    AggregationTimer = NULL;
+  }
+
+  if (AggregatedCount == 1) {
+    olsr_mdns_gen_type(MESSAGE_TYPE, AggregatedPackets, AggregatedLength);
+  } else if (AggregatedCount > 1) {
+    olsr_mdns_gen_type(MESSAGE_TYPE_AGGREGATED, AggregatedPackets, AggregatedLength);
+  }
+
+  AggregatedLength = 0;
+  AggregatedCount = 0;
+}                               /* FlushAggregatedPackets */
+
+static void
+AggregationTimerCallback(void *context __attribute__ ((unused)))
+{
+  /* a one-shot timer is gone after it fired */
+  AggregationTimer = NULL;
+  FlushAggregatedPackets();
+}
+
+/* -------------------------------------------------------------------------
+ * Function   : IsRecentlyRelayed
+ * Description: Check whether a packet with the same content was relayed
+ *              within the duplicate window, and remember the packet if not
+ * Input      : hash - the content hash of the packet
+ * Output     : none
+ * Return     : true when the packet was relayed recently
+ * Data Used  : DuplicateCache
+ * ------------------------------------------------------------------------- */
+static bool
+IsRecentlyRelayed(uint32_t hash)
+{
+  struct DuplicateEntry *entry = &DuplicateCache[hash & (DUPLICATE_CACHE_SIZE - 1)];
+
+  if (entry->hash == hash && !TIMED_OUT(entry->expires)) {
+    return true;
+  }
+
+  /* the window starts at the first relay, so a repeated packet is relayed once per window */
+  entry->hash = hash;
+  entry->expires = GET_TIMESTAMP(my_DuplicateWindow);
+  return false;
+}                               /* IsRecentlyRelayed */
+
+/* -------------------------------------------------------------------------
+ * Function   : RelayPacket
+ * Description: Send a captured packet in the OLSR network, right away or
+ *              aggregated with other captured packets
+ * Input      : ipPacket - the captured IP packet
+ *              len - the length of the IP packet
+ * Output     : none
+ * Return     : none
+ * Data Used  : AggregatedPackets
+ * ------------------------------------------------------------------------- */
+static void
+RelayPacket(unsigned char *ipPacket, int len)
+{
+  int aligned = (len + 3) & ~3;
+
+  if (my_AggregationInterval <= 0 || aligned > MDNS_AGGREGATION_MAX) {
+    FlushAggregatedPackets();
+    olsr_mdns_gen(ipPacket, len);
+    return;
+  }
+
+  if (AggregatedLength + aligned > MDNS_AGGREGATION_MAX) {
+    FlushAggregatedPackets();
+  }
+
+  memcpy(&AggregatedPackets[AggregatedLength], ipPacket, len);
+  memset(&AggregatedPackets[AggregatedLength + len], 0, aligned - len);
+  AggregatedLength += aligned;
+  AggregatedCount++;
+
+  if (!AggregationTimer) {
+    AggregationTimer = olsr_start_timer(my_AggregationInterval, 0, OLSR_TIMER_ONESHOT, &AggregationTimerCallback, NULL,
+                                        AggregationTimerCookie);
+    if (!AggregationTimer) {
+      FlushAggregatedPackets();
+    }
+  }
+}                               /* RelayPacket */
+
 /* -------------------------------------------------------------------------
  * Function   : BmfPError
  * Description: Prints an error message at OLSR debug level 1.
@@ -354,36 +540,45 @@ MainAddressOf(union olsr_ip_addr *ip)
   return result;
 }                               /* MainAddressOf */
 
+static void
+InitFilteredHosts(void)
+{
+  int i;
+
+  if (FHListInit) {
+    return;
+  }
+  for (i = 0; i < HASHSIZE; i++) {
+    listbackport_init_head(&FilteredHosts[i]);
+  }
+  FHListInit = 1;
+}
+
 int
 AddFilteredHost(const char *FilteredHost, void *data __attribute__ ((unused)), 
 		set_plugin_parameter_addon addon __attribute__ ((unused))){
 
   int res = 0;
   struct FilteredHost *tmp;
-  tmp = (struct FilteredHost *) malloc(sizeof(struct FilteredHost));
+  tmp = (struct FilteredHost *) calloc(1, sizeof(struct FilteredHost));
   listbackport_init_node(&tmp->list);
 
-  if(FHListInit == 0){
-    listbackport_init_head(&ListOfFilteredHosts);
-    FHListInit = 1;
-  }
+  InitFilteredHosts();
 
   if(olsr_cnf->ip_version == AF_INET){
     res = inet_pton(AF_INET, FilteredHost, &tmp->host.v4);
-    if(res > 0){
-      listbackport_add_tail(&ListOfFilteredHosts, &tmp->list);
-    }
-    else
-      free(tmp);
   }
   else{
     res = inet_pton(AF_INET6, FilteredHost, &tmp->host.v6);
-    if(res > 0)
-      listbackport_add_tail(&ListOfFilteredHosts, &tmp->list);
-    else
-      free(tmp);
   }
 
+  if(res > 0){
+    listbackport_add_tail(&FilteredHosts[olsr_ip_hashing(&tmp->host)], &tmp->list);
+    FilteredHostCount++;
+  }
+  else
+    free(tmp);
+
   return 0;
 }
 
@@ -393,28 +588,16 @@ isInFilteredList(union olsr_ip_addr *src){
   struct FilteredHost *tmp, *iterator;
   struct ipaddr_str buf1;
   struct ipaddr_str buf2;
-  
-  if(FHListInit == 0){
-    listbackport_init_head(&ListOfFilteredHosts);
-    FHListInit = 1;
-  }
-
 
-  if(listbackport_is_empty(&ListOfFilteredHosts)) {
+  if(FilteredHostCount == 0) {
     OLSR_PRINTF(2,"Accept packet captured because of filtered hosts ACL: List Empty\n");
     return 0;
   }
 
-  OLSR_FOR_ALL_FILTEREDNODES_ENTRIES(tmp, iterator){
+  OLSR_FOR_ALL_FILTEREDNODES_ENTRIES(tmp, iterator, olsr_ip_hashing(src)){
     OLSR_PRINTF(2, "Checking host: %s against list entry: %s\n", olsr_ip_to_string(&buf1, src), olsr_ip_to_string(&buf2, &tmp->host) );
-    if(olsr_cnf->ip_version == AF_INET){
-      if(memcmp(&tmp->host.v4, &src->v4, sizeof(struct in_addr)) == 0)
-        return 1;
-    }
-    else{
-      if(memcmp(&tmp->host.v6, &src->v6, sizeof(struct in6_addr)) == 0)
-        return 1;
-    }
+    if(ipequal(&tmp->host, src))
+      return 1;
   }
 
   OLSR_PRINTF(2,"Accept packet captured because of filtered hosts ACL: Did not find any match in list\n");
@@ -447,11 +630,18 @@ BmfPacketCaptured(
   struct ip6_hdr *ipHeader6;           /* The IP header inside the captured IP packet */
   struct udphdr *udpHeader;
   u_int16_t destPort;
+  int ipLen;
+  uint32_t hash;
 
   if ((encapsulationUdpData[0] & 0xf0) == 0x40) {       //IPV4
 
     ipHeader = (struct ip *)ARM_NOWARN_ALIGN(encapsulationUdpData);
 
+    ipLen = ntohs(ipHeader->ip_len);
+    if (ipLen > nBytes || (int)GetIpHeaderLength(encapsulationUdpData) + (int)sizeof(struct udphdr) > ipLen) {
+      return;
+    }
+
     dst.v4 = ipHeader->ip_dst;
     src.v4 = ipHeader->ip_src;
 
@@ -487,13 +677,19 @@ BmfPacketCaptured(
       return;
     }
 
+    hash = content_hash(2166136261U, (unsigned char *)&src.v4, sizeof(src.v4));
   }                             //END IPV4
 
   else if ((encapsulationUdpData[0] & 0xf0) == 0x60) {  //IPv6
 
     ipHeader6 = (struct ip6_hdr *)ARM_NOWARN_ALIGN(encapsulationUdpData);
 
-    //TODO: mettere dentro src.v6 l'indirizzo IPv6
+    ipLen = 40 + ntohs(ipHeader6->ip6_plen);
+    if (ipLen > nBytes || 40 + (int)sizeof(struct udphdr) > ipLen) {
+      return;
+    }
+
+    src.v6 = ipHeader6->ip6_src;
 
     if (ipHeader6->ip6_dst.s6_addr[0] == 0xff)  //Multicast
     {
@@ -527,6 +723,7 @@ BmfPacketCaptured(
       return;
     }
 
+    hash = content_hash(2166136261U, (unsigned char *)&src.v6, sizeof(src.v6));
   }                             //END IPV6
   else
     return;                     //Is not IP packet
@@ -534,8 +731,20 @@ BmfPacketCaptured(
   /* Check if the frame is captured on an OLSR-enabled interface */
   //isFromOlsrIntf = (intf->olsrIntf != NULL); TODO: put again this check
 
+  /* The content of the packet: the UDP header and payload, the IP header
+   * changes every time the packet is sent */
+  if (my_DuplicateWindow > 0) {
+    unsigned char *udp = (unsigned char *)udpHeader;
+
+    hash = content_hash(hash, udp, ipLen - (udp - encapsulationUdpData));
+    if (IsRecentlyRelayed(hash)) {
+      OLSR_PRINTF(2,"Discarding packet captured because it was relayed recently\n");
+      return;
+    }
+  }
+
   // send the packet to OLSR forward mechanism
-  olsr_mdns_gen(encapsulationUdpData, nBytes);
+  RelayPacket(encapsulationUdpData, ipLen);
 }                               /* BmfPacketCaptured */
 
 
@@ -615,6 +824,9 @@ InitMDNS(struct interface_olsr *skipThisIntf)
 {
   //Tells OLSR to launch olsr_parser when the packets for this plugin arrive
   olsr_parser_add_function(&olsr_parser, PARSER_TYPE);
+  olsr_parser_add_function(&olsr_parser, MESSAGE_TYPE_AGGREGATED);
+  InitFilteredHosts();
+  AggregationTimerCookie = olsr_alloc_cookie("MDNS: Aggregation", OLSR_COOKIE_TYPE_TIMER);
   //Creates captures sockets and register them to the OLSR scheduler
   CreateBmfNetworkInterfaces(skipThisIntf);
   InitRouterList(NULL);
@@ -633,6 +845,17 @@ InitMDNS(struct interface_olsr *skipThisIntf)
 void
 CloseMDNS(void)
 {
+  if (AggregationTimer) {
+    olsr_stop_timer(AggregationTimer);
+    AggregationTimer = NULL;
+  }
+  AggregatedLength = 0;
+  AggregatedCount = 0;
+  if (AggregationTimerCookie) {
+    olsr_free_cookie(AggregationTimerCookie);
+    AggregationTimerCookie = NULL;
+  }
+
   CloseBmfNetworkInterfaces();
 }
 
@@ -55,9 +55,13 @@
 
 #define MESSAGE_TYPE 132
 #define PARSER_TYPE		MESSAGE_TYPE
+/* several captured packets in one message */
+#define MESSAGE_TYPE_AGGREGATED 133
 #define EMISSION_INTERVAL       10      /* seconds */
 #define EMISSION_JITTER         25      /* percent */
 #define MDNS_VALID_TIME          1800   /* seconds */
+#define MDNS_DUPLICATE_WINDOW    1000   /* milliseconds */
+#define MDNS_AGGREGATION_MAX     1024   /* bytes of packets in an aggregated message */
 
 /* BMF plugin data */
 #define PLUGIN_NAME              "OLSRD mdns plugin"
@@ -76,6 +80,9 @@ struct FilteredHost{
   struct list_entity list;
 };
 
+extern int my_DuplicateWindow;
+extern int my_AggregationInterval;
+
 //extern int FanOutLimit;
 //extern int BroadcastRetransmitCount;
 
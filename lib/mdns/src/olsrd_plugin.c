@@ -135,6 +135,8 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
   {.name = "FilteredHost", .set_plugin_parameter = &AddFilteredHost, .data = NULL },
   {.name = "TTL_Check", .set_plugin_parameter = &set_TTL_Check, .data = NULL},
   {.name = "Network_ID", .set_plugin_parameter = &set_Network_ID, .data = NULL},
+  {.name = "DuplicateWindow", .set_plugin_parameter = &set_plugin_int, .data = &my_DuplicateWindow},
+  {.name = "AggregationInterval", .set_plugin_parameter = &set_plugin_int, .data = &my_AggregationInterval},
   //{ .name = "DoLocalBroadcast", .set_plugin_parameter = &DoLocalBroadcast, .data = NULL },
   //{ .name = "BmfInterface", .set_plugin_parameter = &SetBmfInterfaceName, .data = NULL },
   //{ .name = "BmfInterfaceIp", .set_plugin_parameter = &SetBmfInterfaceIp, .data = NULL },
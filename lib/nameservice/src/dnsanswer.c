@@ -0,0 +1,298 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <ctype.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+
+#include "defs.h"
+#include "olsr.h"
+#include "ipcalc.h"
+#include "scheduler.h"
+#include "nameservice.h"
+
+#include "dnsanswer.h"
+
+/*
+ * A minimal DNS server that answers A and AAAA queries for the names in
+ * the name index straight from memory, so a resolver that forwards the
+ * olsr names to it does not have to reload the hosts file. Everything
+ * else is answered with NXDOMAIN, REFUSED or an empty answer.
+ */
+
+#define DNS_HEADER_SIZE 12
+#define DNS_MAX_UDP     512
+
+#define DNS_FLAG_QR     0x8000
+#define DNS_FLAG_AA     0x0400
+#define DNS_FLAG_RD     0x0100
+#define DNS_OPCODE_MASK 0x7800
+
+#define DNS_RCODE_FORMERR  1
+#define DNS_RCODE_NXDOMAIN 3
+#define DNS_RCODE_NOTIMP   4
+#define DNS_RCODE_REFUSED  5
+
+#define DNS_TYPE_A      1
+#define DNS_TYPE_AAAA   28
+#define DNS_TYPE_ANY    255
+#define DNS_CLASS_IN    1
+
+static int dns_socket = -1;
+static uint32_t dns_ttl;
+
+static uint16_t
+dns_get16(const unsigned char *p)
+{
+  return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static unsigned char *
+dns_put16(unsigned char *p, uint16_t v)
+{
+  p[0] = v >> 8;
+  p[1] = v & 0xff;
+  return p + 2;
+}
+
+static unsigned char *
+dns_put32(unsigned char *p, uint32_t v)
+{
+  p = dns_put16(p, v >> 16);
+  return dns_put16(p, v & 0xffff);
+}
+
+/**
+ * Read the name of the question into a dotted string.
+ * Returns the length of the name in the packet, or 0 if it is malformed.
+ */
+static size_t
+dns_read_qname(const unsigned char *pkt, size_t len, char *name, size_t name_size)
+{
+  size_t pos = DNS_HEADER_SIZE, out = 0;
+  unsigned int label, i;
+
+  while (pos < len) {
+    label = pkt[pos++];
+    if (label == 0) {
+      if (out == 0) {
+        name[out++] = '.';
+      }
+      name[out - 1] = '\0';
+      return pos - DNS_HEADER_SIZE;
+    }
+    /* no compression in the question */
+    if (label > 63 || pos + label > len || out + label + 1 > name_size) {
+      return 0;
+    }
+    for (i = 0; i < label; i++) {
+      name[out++] = tolower(pkt[pos++]);
+    }
+    name[out++] = '.';
+  }
+  return 0;
+}
+
+/**
+ * Build the answer for a query into ans.
+ * Returns the length of the answer, 0 if no answer should be sent.
+ */
+static size_t
+dns_answer(const unsigned char *pkt, size_t len, unsigned char *ans)
+{
+  const struct name_index_entry *entry;
+  const struct name_index_addr *addr;
+  char name[256];
+  size_t qlen, anslen;
+  uint16_t flags, qtype, qclass, rtype, count = 0, rcode = 0;
+  unsigned char *p;
+
+  if (len < DNS_HEADER_SIZE) {
+    return 0;
+  }
+
+  flags = dns_get16(pkt + 2);
+  if (flags & DNS_FLAG_QR) {
+    return 0;                   /* not a query */
+  }
+
+  qlen = 0;
+  if ((flags & DNS_OPCODE_MASK) != 0) {
+    rcode = DNS_RCODE_NOTIMP;
+  } else if (dns_get16(pkt + 4) != 1 || (qlen = dns_read_qname(pkt, len, name, sizeof(name))) == 0
+             || DNS_HEADER_SIZE + qlen + 4 > len) {
+    rcode = DNS_RCODE_FORMERR;
+    qlen = 0;
+  } else {
+    qlen += 4;
+  }
+
+  /* header and question of the query */
+  memcpy(ans, pkt, 4);
+  dns_put16(ans + 2, DNS_FLAG_QR | DNS_FLAG_AA | (flags & (DNS_OPCODE_MASK | DNS_FLAG_RD)));
+  dns_put16(ans + 4, qlen ? 1 : 0);
+  memset(ans + 6, 0, 6);
+  memcpy(ans + DNS_HEADER_SIZE, pkt + DNS_HEADER_SIZE, qlen);
+  anslen = DNS_HEADER_SIZE + qlen;
+
+  if (rcode == 0) {
+    qtype = dns_get16(pkt + DNS_HEADER_SIZE + qlen - 4);
+    qclass = dns_get16(pkt + DNS_HEADER_SIZE + qlen - 2);
+    rtype = olsr_cnf->ip_version == AF_INET ? DNS_TYPE_A : DNS_TYPE_AAAA;
+
+    entry = name_index_lookup(name);
+    if (qclass != DNS_CLASS_IN) {
+      rcode = DNS_RCODE_REFUSED;
+    } else if (entry == NULL) {
+      rcode = DNS_RCODE_NXDOMAIN;
+    } else if (qtype == rtype || qtype == DNS_TYPE_ANY) {
+      for (addr = entry->addrs; addr; addr = addr->next) {
+        if (anslen + 12 + olsr_cnf->ipsize > DNS_MAX_UDP) {
+          break;
+        }
+        /* the name of the question */
+        p = dns_put16(ans + anslen, 0xc000 | DNS_HEADER_SIZE);
+        p = dns_put16(p, rtype);
+        p = dns_put16(p, DNS_CLASS_IN);
+        p = dns_put32(p, dns_ttl);
+        p = dns_put16(p, olsr_cnf->ipsize);
+        memcpy(p, &addr->ip, olsr_cnf->ipsize);
+        anslen = p + olsr_cnf->ipsize - ans;
+        count++;
+      }
+    }
+  }
+
+  ans[3] |= rcode;
+  dns_put16(ans + 6, count);
+  return anslen;
+}
+
+static void
+dns_action(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  unsigned char pkt[DNS_MAX_UDP], ans[DNS_MAX_UDP];
+  union olsr_sockaddr from;
+  socklen_t fromlen = sizeof(from);
+  ssize_t len;
+  size_t anslen;
+
+  len = recvfrom(fd, pkt, sizeof(pkt), 0, &from.in, &fromlen);
+  if (len <= 0) {
+    return;
+  }
+
+  anslen = dns_answer(pkt, len, ans);
+  if (anslen > 0 && sendto(fd, ans, anslen, 0, &from.in, fromlen) < 0) {
+    OLSR_PRINTF(3, "NAME PLUGIN: can't send DNS answer: %s\n", strerror(errno));
+  }
+}
+
+/**
+ * Open the UDP socket for DNS queries.
+ */
+int
+dnsanswer_init(const union olsr_ip_addr *listen_ip, int port, uint32_t ttl)
+{
+  union olsr_sockaddr addr;
+  socklen_t addrlen;
+  int yes = 1;
+
+  dns_ttl = ttl;
+
+  memset(&addr, 0, sizeof(addr));
+  if (olsr_cnf->ip_version == AF_INET) {
+    addr.in4.sin_family = AF_INET;
+    addr.in4.sin_port = htons(port);
+    addr.in4.sin_addr = listen_ip->v4;
+    addrlen = sizeof(addr.in4);
+  } else {
+    addr.in6.sin6_family = AF_INET6;
+    addr.in6.sin6_port = htons(port);
+    addr.in6.sin6_addr = listen_ip->v6;
+    addrlen = sizeof(addr.in6);
+  }
+
+  dns_socket = socket(olsr_cnf->ip_version, SOCK_DGRAM, 0);
+  if (dns_socket < 0) {
+    OLSR_PRINTF(1, "NAME PLUGIN: can't open DNS socket: %s\n", strerror(errno));
+    return 0;
+  }
+  if (setsockopt(dns_socket, SOL_SOCKET, SO_REUSEADDR, (char *)&yes, sizeof(yes)) < 0
+      || bind(dns_socket, &addr.in, addrlen) < 0) {
+    OLSR_PRINTF(1, "NAME PLUGIN: can't bind DNS socket to port %d: %s\n", port, strerror(errno));
+    close(dns_socket);
+    dns_socket = -1;
+    return 0;
+  }
+
+  add_olsr_socket(dns_socket, &dns_action, NULL, NULL, SP_PR_READ);
+  return 1;
+}
+
+void
+dnsanswer_exit(void)
+{
+  if (dns_socket < 0) {
+    return;
+  }
+
+  remove_olsr_socket(dns_socket, &dns_action, NULL);
+  close(dns_socket);
+  dns_socket = -1;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -74,8 +74,10 @@
 #include "link_set.h"
 
 #include "plugin_util.h"
+#include "common/autobuf.h"
 #include "nameservice.h"
 #include "mapwrite.h"
+#include "dnsanswer.h"
 #include "compat.h"
 
 /* true if plugin has been configured */
@@ -98,6 +100,9 @@ static char my_services_change_script[MAX_FILE + 1];
 static char my_macs_change_script[MAX_FILE + 1];
 static char latlon_in_file[MAX_FILE + 1];
 static char my_latlon_file[MAX_FILE + 1];
+static int my_reload_holdoff = 10;
+static int my_dns_port = 0;
+static union olsr_ip_addr my_dns_listen;
 float my_lat = 0.0, my_lon = 0.0;
 
 /* the databases (using hashing)
@@ -126,9 +131,34 @@ static bool forwarder_table_changed = true;
 struct list_node latlon_list[HASHSIZE];
 static bool latlon_table_changed = true;
 
+/* sorted index of all host names */
+static struct avl_tree name_index;
+static struct name_index_addr *my_names_index = NULL;
+
 /* backoff timer for writing changes into a file */
 struct timer_entry *write_file_timer = NULL;
 
+/* the content of a file as it was written last, without the time stamp */
+struct name_file {
+  struct autobuf content;
+  bool written;
+};
+
+static struct name_file hosts_file_written;
+static struct name_file services_file_written;
+static struct name_file macs_file_written;
+static struct name_file resolv_file_written;
+
+/* files that changed but whose readers were not told yet */
+#define NAME_RELOAD_HOSTS    1
+#define NAME_RELOAD_SERVICES 2
+#define NAME_RELOAD_MACS     4
+
+static unsigned int reload_pending;
+
+/* holdoff after telling the readers of the files */
+static struct timer_entry *reload_timer = NULL;
+
 /* periodic message generation */
 struct timer_entry *msg_gen_timer = NULL;
 
@@ -141,6 +171,19 @@ static regex_t regex_t_service;
 static int pmatch_service = 10;
 static regmatch_t regmatch_t_service[10];
 
+static void name_index_remove(struct name_index_addr **);
+static void name_index_update(struct name_index_addr **, const struct name_entry *, const union olsr_ip_addr *);
+#ifdef MID_ENTRIES
+static bool name_index_mid_changed(const struct name_index_addr *, const struct name_entry *);
+#endif /* MID_ENTRIES */
+static void olsr_expire_reload_timer(void *);
+
+static int
+name_index_comp(const void *a, const void *b)
+{
+  return strcasecmp(a, b);
+}
+
 /**
  * do initialization
  */
@@ -201,6 +244,7 @@ name_constructor(void)
     list_head_init(&latlon_list[i]);
   }
 
+  avl_init(&name_index, &name_index_comp);
 }
 
 static int
@@ -270,6 +314,9 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
   { .name = "timeout",                .set_plugin_parameter = &set_nameservice_float,  .data = &my_timeout },
   { .name = "sighup-pid-file",        .set_plugin_parameter = &set_plugin_string,      .data = &my_sighup_pid_file,        .addon = {sizeof(my_sighup_pid_file)} },
   { .name = "filewrite-interval",     .set_plugin_parameter = &set_plugin_int,         .data = &my_filewrite_interval },
+  { .name = "reload-holdoff",         .set_plugin_parameter = &set_plugin_int,         .data = &my_reload_holdoff },
+  { .name = "dns-port",               .set_plugin_parameter = &set_plugin_int,         .data = &my_dns_port },
+  { .name = "dns-listen",             .set_plugin_parameter = &set_plugin_ipaddress,   .data = &my_dns_listen },
   { .name = "hosts-file",             .set_plugin_parameter = &set_plugin_string,      .data = &my_hosts_file,             .addon = {sizeof(my_hosts_file)} },
   { .name = "name-change-script",     .set_plugin_parameter = &set_plugin_string,      .data = &my_name_change_script,     .addon = {sizeof(my_name_change_script)} },
   { .name = "services-change-script", .set_plugin_parameter = &set_plugin_string,      .data = &my_services_change_script, .addon = {sizeof(my_services_change_script)} },
@@ -341,6 +388,18 @@ name_init(void)
   /* periodic message generation */
   msg_gen_timer = olsr_start_timer(my_interval * MSEC_PER_SEC, EMISSION_JITTER, OLSR_TIMER_PERIODIC, &olsr_namesvc_gen, NULL, 0);
 
+  /* answer queries for the names from memory */
+  if (my_dns_port > 0) {
+    if (ipequal(&my_dns_listen, &olsr_ip_zero)) {
+      if (olsr_cnf->ip_version == AF_INET) {
+        my_dns_listen.v4.s_addr = htonl(INADDR_LOOPBACK);
+      } else {
+        my_dns_listen.v6 = in6addr_loopback;
+      }
+    }
+    dnsanswer_init(&my_dns_listen, my_dns_port, my_filewrite_interval);
+  }
+
   return 1;
 }
 
@@ -431,6 +490,8 @@ static void name_lazy_init(void) {
   my_services = remove_nonvalid_names_from_list(my_services, NAME_SERVICE);
   my_macs = remove_nonvalid_names_from_list(my_macs, NAME_MACADDR);
 
+  name_index_update(&my_names_index, my_names, &olsr_cnf->main_addr);
+
   mapwrite_init(my_latlon_file);
 
   return;
@@ -507,8 +568,17 @@ name_destructor(void)
 
   olsr_stop_timer(write_file_timer);
   olsr_stop_timer(msg_gen_timer);
+  olsr_stop_timer(reload_timer);
   write_file_timer = NULL;
   msg_gen_timer = NULL;
+  reload_timer = NULL;
+
+  dnsanswer_exit();
+  name_index_remove(&my_names_index);
+  abuf_free(&hosts_file_written.content);
+  abuf_free(&services_file_written.content);
+  abuf_free(&macs_file_written.content);
+  abuf_free(&resolv_file_written.content);
 
   regfree(&regex_t_name);
   regfree(&regex_t_service);
@@ -584,6 +654,7 @@ olsr_namesvc_delete_db_entry(struct db_entry *db)
   db->db_timer = NULL;
 
   /* Delete */
+  name_index_remove(&db->index);
   free_name_entry_list(&db->names);
   list_remove(&db->db_list);
   free(db);
@@ -966,6 +1037,7 @@ insert_new_name_in_list(union olsr_ip_addr *originator, struct list_node *this_l
   struct list_node *list_head, *list_node;
 
   bool entry_found = false;
+  bool changed = false;
 
   hash = olsr_ip_hashing(originator);
 
@@ -981,12 +1053,13 @@ insert_new_name_in_list(union olsr_ip_addr *originator, struct list_node *this_l
       OLSR_PRINTF(4, "NAME PLUGIN: found entry for (%s) in its hash table\n", olsr_ip_to_string(&strbuf, originator));
 
       //delegate to function for parsing the packet and linking it to entry->names
-      decap_namemsg(from_packet, &entry->names, this_table_changed);
+      decap_namemsg(from_packet, &entry->names, &changed);
 
       olsr_set_timer(&entry->db_timer, vtime, OLSR_NAMESVC_DB_JITTER, OLSR_TIMER_ONESHOT, &olsr_nameservice_expire_db_timer, entry,
                      0);
 
       entry_found = true;
+      break;
     }
   }
 
@@ -1008,7 +1081,24 @@ insert_new_name_in_list(union olsr_ip_addr *originator, struct list_node *this_l
     list_add_before(&this_list[hash], &entry->db_list);
 
     //delegate to function for parsing the packet and linking it to entry->names
-    decap_namemsg(from_packet, &entry->names, this_table_changed);
+    decap_namemsg(from_packet, &entry->names, &changed);
+  }
+
+#ifdef MID_ENTRIES
+  /* the MID aliases may have changed without the names */
+  if (!changed && this_list == name_list && name_index_mid_changed(entry->index, entry->names)) {
+    changed = true;
+    olsr_start_write_file_timer();
+  }
+#endif /* MID_ENTRIES */
+
+  if (changed) {
+    *this_table_changed = true;
+
+    /* only the names of this originator are indexed again */
+    if (this_list == name_list) {
+      name_index_update(&entry->index, entry->names, &entry->originator);
+    }
   }
 }
 
@@ -1064,121 +1154,359 @@ send_sighup_to_pidfile(char *pid_file)
 #endif /* _WIN32 */
 
 /**
- * write names to a file in /etc/hosts compatible format
+ * Tell the readers of the files that changed: send the SIGHUP and run
+ * the change scripts. After that they are told again at the earliest
+ * when the holdoff is over, about everything that changed meanwhile.
  */
-void
-write_hosts_file(void)
+static void
+name_reload(unsigned int changed)
 {
-  int hash;
-  struct name_entry *name;
-  struct db_entry *entry;
-  struct list_node *list_head, *list_node;
-  FILE *hosts;
-  FILE *add_hosts;
-  int c = 0;
+  unsigned int what;
+
+  reload_pending |= changed;
+  if (reload_timer || !reload_pending) {
+    return;
+  }
+
+  what = reload_pending;
+  reload_pending = 0;
+
+  if (what & NAME_RELOAD_HOSTS) {
+#ifndef _WIN32
+    if (*my_sighup_pid_file)
+      send_sighup_to_pidfile(my_sighup_pid_file);
+#endif /* _WIN32 */
+
+    // Executes my_name_change_script after writing the hosts file
+    if (my_name_change_script[0] != '\0') {
+      if (system(my_name_change_script) != -1) {
+        OLSR_PRINTF(2, "NAME PLUGIN: Name changed, %s executed\n", my_name_change_script);
+      } else {
+        OLSR_PRINTF(2, "NAME PLUGIN: WARNING! Failed to execute %s on hosts change\n", my_name_change_script);
+      }
+    }
+  }
+
+  if (what & NAME_RELOAD_SERVICES) {
+    // Executes my_services_change_script after writing the services file
+    if (my_services_change_script[0] != '\0') {
+      if (system(my_services_change_script) != -1) {
+        OLSR_PRINTF(2, "NAME PLUGIN: Service changed, %s executed\n", my_services_change_script);
+      } else {
+        OLSR_PRINTF(2, "NAME PLUGIN: WARNING! Failed to execute %s on service change\n", my_services_change_script);
+      }
+    }
+  }
+
+  if (what & NAME_RELOAD_MACS) {
+    // Executes my_macs_change_script after writing the macs file
+    if (my_macs_change_script[0] != '\0') {
+      if (system(my_macs_change_script) != -1) {
+        OLSR_PRINTF(2, "NAME PLUGIN: Service changed, %s executed\n", my_macs_change_script);
+      } else {
+        OLSR_PRINTF(2, "NAME PLUGIN: WARNING! Failed to execute %s on mac change\n", my_macs_change_script);
+      }
+    }
+  }
+
+  if (my_reload_holdoff > 0) {
+    reload_timer = olsr_start_timer(my_reload_holdoff * MSEC_PER_SEC, 0, OLSR_TIMER_ONESHOT, &olsr_expire_reload_timer, NULL, 0);
+  }
+}
+
+/**
+ * The reload holdoff timer has fired.
+ */
+static void
+olsr_expire_reload_timer(void *context __attribute__ ((unused)))
+{
+  reload_timer = NULL;
+
+  name_reload(0);
+}
+
+/**
+ * Replace file with the content of abuf, followed by a time stamp, unless
+ * the file was last written with the same content. A temporary file is
+ * renamed over the file, so readers never see a partially written one.
+ *
+ * Returns 1 if the file was written, 0 if it did not change and -1 on
+ * error.
+ */
+static int
+name_write_file(const char *file, struct name_file *written, struct autobuf *abuf)
+{
+  char tmp_file[MAX_FILE + 5];
+  struct autobuf swap;
   time_t currtime;
+  FILE *f;
+  bool ok;
 
-#ifdef MID_ENTRIES
-  struct mid_address *alias;
-#endif /* MID_ENTRIES */
+  if (written->written && written->content.len == abuf->len && memcmp(written->content.buf, abuf->buf, abuf->len) == 0) {
+    OLSR_PRINTF(3, "NAME PLUGIN: %s did not change\n", file);
+    return 0;
+  }
 
-  if (!name_table_changed)
-    return;
+  snprintf(tmp_file, sizeof(tmp_file), "%s.tmp", file);
+  f = fopen(tmp_file, "w");
+  if (f == NULL) {
+    OLSR_PRINTF(2, "NAME PLUGIN: can't write %s\n", tmp_file);
+    return -1;
+  }
 
-  OLSR_PRINTF(2, "NAME PLUGIN: writing hosts file\n");
+  ok = fwrite(abuf->buf, 1, abuf->len, f) == (size_t)abuf->len;
+  if (time(&currtime)) {
+    ok = fprintf(f, "\n### written by olsrd at %s", ctime(&currtime)) > 0 && ok;
+  }
+  ok = fclose(f) == 0 && ok;
 
-  hosts = fopen(my_hosts_file, "w");
-  if (hosts == NULL) {
-    OLSR_PRINTF(2, "NAME PLUGIN: cant write hosts file\n");
-    return;
+  if (!ok || rename(tmp_file, file) < 0) {
+    OLSR_PRINTF(2, "NAME PLUGIN: can't write %s\n", file);
+    unlink(tmp_file);
+    return -1;
   }
 
-  fprintf(hosts, "### this /etc/hosts file is overwritten regularly by olsrd\n");
-  fprintf(hosts, "### do not edit\n\n");
+  /* keep the content, the caller frees the old one */
+  swap = written->content;
+  written->content = *abuf;
+  *abuf = swap;
+  written->written = true;
+  return 1;
+}
 
-  fprintf(hosts, "127.0.0.1\tlocalhost\n");
-  fprintf(hosts, "::1\t\tlocalhost\n\n");
+/**
+ * Remove all addresses of one originator from the index, and the names
+ * that are left without an address.
+ */
+static void
+name_index_remove(struct name_index_addr **owned)
+{
+  struct name_index_entry *entry;
+  struct name_index_addr *addr, **pos;
 
-  // copy content from additional hosts filename
-  if (my_add_hosts[0] != '\0') {
-    add_hosts = fopen(my_add_hosts, "r");
-    if (add_hosts == NULL) {
-      OLSR_PRINTF(2, "NAME PLUGIN: cant open additional hosts file\n");
-    } else {
-      fprintf(hosts, "### contents from '%s' ###\n\n", my_add_hosts);
-      while ((c = getc(add_hosts)) != EOF)
-        putc(c, hosts);
-      fclose(add_hosts);
+  while ((addr = *owned) != NULL) {
+    *owned = addr->owner_next;
+
+    entry = addr->entry;
+    for (pos = &entry->addrs; *pos != addr; pos = &(*pos)->next);
+    *pos = addr->next;
+    free(addr);
+
+    if (entry->addrs == NULL) {
+      avl_delete(&name_index, &entry->node);
+      free(entry->name);
+      free(entry);
     }
-    fprintf(hosts, "\n### olsr names ###\n\n");
   }
-  // write own names
-  for (name = my_names; name != NULL; name = name->next) {
-    struct ipaddr_str strbuf;
-    fprintf(hosts, "%s\t%s%s\t# myself\n", olsr_ip_to_string(&strbuf, &name->ip), name->name, my_suffix);
+}
+
+static void
+name_index_add(struct name_index_addr **owned, const char *prefix, const char *name, const union olsr_ip_addr *ip,
+               const union olsr_ip_addr *originator, int mid)
+{
+  char fullname[MID_MAXLEN + MAX_NAME + MAX_SUFFIX + 1];
+  struct name_index_entry *entry;
+  struct name_index_addr *addr, **pos;
+  struct avl_node *node;
+
+  snprintf(fullname, sizeof(fullname), "%s%s%s", prefix, name, my_suffix);
+
+  node = avl_find(&name_index, fullname);
+  if (node) {
+    entry = node2nameindex(node);
+  } else {
+    entry = olsr_malloc(sizeof(*entry), "NAME PLUGIN: index entry");
+    entry->name = olsr_malloc(strlen(fullname) + 1, "NAME PLUGIN: index name");
+    strcpy(entry->name, fullname);
+    entry->node.key = entry->name;
+    entry->addrs = NULL;
+    avl_insert(&name_index, &entry->node, AVL_DUP_NO);
+  }
+
+  /* sorted, so the hosts file is the same for the same names */
+  for (pos = &entry->addrs; *pos; pos = &(*pos)->next) {
+    int cmp = memcmp(&(*pos)->ip, ip, olsr_cnf->ipsize);
+    if (cmp == 0) {
+      cmp = memcmp(&(*pos)->originator, originator, olsr_cnf->ipsize);
+    }
+    if (cmp == 0) {
+      return;
+    }
+    if (cmp > 0) {
+      break;
+    }
   }
 
-  // write received names
-  for (hash = 0; hash < HASHSIZE; hash++) {
-    list_head = &name_list[hash];
-    for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
+  addr = olsr_malloc(sizeof(*addr), "NAME PLUGIN: index addr");
+  addr->ip = *ip;
+  addr->originator = *originator;
+  addr->mid = mid;
+  addr->next = *pos;
+  *pos = addr;
 
-      entry = list2db(list_node);
-      if (entry) {
-        for (name = entry->names; name != NULL; name = name->next) {
-          struct ipaddr_str strbuf1, strbuf2;
-          OLSR_PRINTF(6, "%s\t%s%s\t#%s\n", olsr_ip_to_string(&strbuf1, &name->ip), name->name, my_suffix,
-                      olsr_ip_to_string(&strbuf2, &entry->originator));
+  addr->entry = entry;
+  addr->owner_next = *owned;
+  *owned = addr;
+}
 
-          fprintf(hosts, "%s\t%s%s\t# %s\n", olsr_ip_to_string(&strbuf1, &name->ip), name->name, my_suffix,
-                  olsr_ip_to_string(&strbuf2, &entry->originator));
+/**
+ * Replace the indexed names of one originator (and their MID aliases)
+ * with its current names.
+ */
+static void
+name_index_update(struct name_index_addr **owned, const struct name_entry *names, const union olsr_ip_addr *originator)
+{
+  const struct name_entry *name;
 
 #ifdef MID_ENTRIES
-          // write mid entries
-          if ((alias = mid_lookup_aliases(&name->ip)) != NULL) {
-            unsigned short mid_num = 1;
-            char mid_prefix[MID_MAXLEN];
+  bool myself = originator == &olsr_cnf->main_addr;
+  struct mid_address *alias;
+#endif /* MID_ENTRIES */
 
-            while (alias != NULL) {
-              // generate mid prefix
-              sprintf(mid_prefix, MID_PREFIX, mid_num);
+  name_index_remove(owned);
 
-              OLSR_PRINTF(6, "%s\t%s%s%s\t# %s (mid #%i)\n", olsr_ip_to_string(&strbuf1, &alias->alias), mid_prefix, name->name,
-                          my_suffix, olsr_ip_to_string(&strbuf2, &entry->originator), mid_num);
+  for (name = names; name != NULL; name = name->next) {
+    name_index_add(owned, "", name->name, &name->ip, originator, 0);
 
-              fprintf(hosts, "%s\t%s%s%s\t# %s (mid #%i)\n", olsr_ip_to_string(&strbuf1, &alias->alias), mid_prefix, name->name,
-                      my_suffix, olsr_ip_to_string(&strbuf2, &entry->originator), mid_num);
+#ifdef MID_ENTRIES
+    // add mid entries
+    if (!myself && (alias = mid_lookup_aliases(&name->ip)) != NULL) {
+      unsigned short mid_num = 1;
+      char mid_prefix[MID_MAXLEN];
+
+      while (alias != NULL) {
+        // generate mid prefix
+        sprintf(mid_prefix, MID_PREFIX, mid_num);
 
-              alias = alias->next_alias;
-              mid_num++;
-            }
-          }
+        name_index_add(owned, mid_prefix, name->name, &alias->alias, originator, mid_num);
+
+        alias = alias->next_alias;
+        mid_num++;
+      }
+    }
 #endif /* MID_ENTRIES */
+  }
+}
+
+#ifdef MID_ENTRIES
+/**
+ * Check whether the MID aliases of the names of one originator differ
+ * from the indexed ones.
+ */
+static bool
+name_index_mid_changed(const struct name_index_addr *owned, const struct name_entry *names)
+{
+  const struct name_index_addr *addr;
+  const struct name_entry *name;
+  struct mid_address *alias;
+  int indexed = 0, expected = 0;
+
+  for (addr = owned; addr != NULL; addr = addr->owner_next) {
+    if (addr->mid) {
+      indexed++;
+    }
+  }
+
+  for (name = names; name != NULL; name = name->next) {
+    int mid_num = 1;
+
+    for (alias = mid_lookup_aliases(&name->ip); alias != NULL; alias = alias->next_alias, mid_num++) {
+      for (addr = owned; addr != NULL; addr = addr->owner_next) {
+        if (addr->mid == mid_num && ipequal(&addr->ip, &alias->alias)) {
+          break;
         }
       }
+      if (addr == NULL) {
+        return true;
+      }
+      expected++;
     }
   }
+  return indexed > expected;
+}
+#endif /* MID_ENTRIES */
 
-  if (time(&currtime)) {
-    fprintf(hosts, "\n### written by olsrd at %s", ctime(&currtime));
-  }
+/**
+ * Look up a host name (with the suffix) in the index.
+ */
+const struct name_index_entry *
+name_index_lookup(const char *name)
+{
+  struct avl_node *node = avl_find(&name_index, name);
 
-  fclose(hosts);
+  return node ? node2nameindex(node) : NULL;
+}
 
-#ifndef _WIN32
-  if (*my_sighup_pid_file)
-    send_sighup_to_pidfile(my_sighup_pid_file);
-#endif /* _WIN32 */
-  name_table_changed = false;
+/**
+ * write names to a file in /etc/hosts compatible format
+ */
+void
+write_hosts_file(void)
+{
+  struct avl_node *node;
+  struct name_index_entry *entry;
+  struct name_index_addr *addr;
+  struct autobuf abuf;
+  FILE *add_hosts;
+  char buf[4096];
+  size_t len;
+
+  if (!name_table_changed)
+    return;
 
-  // Executes my_name_change_script after writing the hosts file
-  if (my_name_change_script[0] != '\0') {
-    if (system(my_name_change_script) != -1) {
-      OLSR_PRINTF(2, "NAME PLUGIN: Name changed, %s executed\n", my_name_change_script);
+  abuf_init(&abuf, 4096);
+
+  abuf_puts(&abuf, "### this /etc/hosts file is overwritten regularly by olsrd\n");
+  abuf_puts(&abuf, "### do not edit\n\n");
+
+  abuf_puts(&abuf, "127.0.0.1\tlocalhost\n");
+  abuf_puts(&abuf, "::1\t\tlocalhost\n\n");
+
+  // copy content from additional hosts filename
+  if (my_add_hosts[0] != '\0') {
+    add_hosts = fopen(my_add_hosts, "r");
+    if (add_hosts == NULL) {
+      OLSR_PRINTF(2, "NAME PLUGIN: cant open additional hosts file\n");
     } else {
-      OLSR_PRINTF(2, "NAME PLUGIN: WARNING! Failed to execute %s on hosts change\n", my_name_change_script);
+      abuf_appendf(&abuf, "### contents from '%s' ###\n\n", my_add_hosts);
+      while ((len = fread(buf, 1, sizeof(buf), add_hosts)) > 0)
+        abuf_memcpy(&abuf, buf, len);
+      fclose(add_hosts);
     }
+    abuf_puts(&abuf, "\n### olsr names ###\n\n");
   }
+
+  // write own and received names, sorted by name
+  for (node = avl_walk_first(&name_index); node; node = avl_walk_next(node)) {
+    entry = node2nameindex(node);
+    for (addr = entry->addrs; addr; addr = addr->next) {
+      struct ipaddr_str strbuf1, strbuf2;
+
+      if (ipequal(&addr->originator, &olsr_cnf->main_addr)) {
+        abuf_appendf(&abuf, "%s\t%s\t# myself\n", olsr_ip_to_string(&strbuf1, &addr->ip), entry->name);
+      } else if (addr->mid) {
+        abuf_appendf(&abuf, "%s\t%s\t# %s (mid #%i)\n", olsr_ip_to_string(&strbuf1, &addr->ip), entry->name,
+                     olsr_ip_to_string(&strbuf2, &addr->originator), addr->mid);
+      } else {
+        abuf_appendf(&abuf, "%s\t%s\t# %s\n", olsr_ip_to_string(&strbuf1, &addr->ip), entry->name,
+                     olsr_ip_to_string(&strbuf2, &addr->originator));
+      }
+    }
+  }
+
+  switch (name_write_file(my_hosts_file, &hosts_file_written, &abuf)) {
+  case 1:
+    OLSR_PRINTF(2, "NAME PLUGIN: wrote hosts file\n");
+    name_reload(NAME_RELOAD_HOSTS);
+    /* fall through */
+  case 0:
+    name_table_changed = false;
+    break;
+  default:
+    break;
+  }
+
+  abuf_free(&abuf);
 }
 
 /**
@@ -1198,26 +1526,19 @@ write_services_file(bool writemacs)
   struct name_entry *name;
   struct db_entry *entry;
   struct list_node *list_head, *list_node;
-  FILE *file;
-  time_t currtime;
+  struct autobuf abuf;
 
   if ((writemacs && !mac_table_changed) || (!writemacs && !service_table_changed))
     return;
 
-  OLSR_PRINTF(2, "NAME PLUGIN: writing %s file\n", writemacs ? "macs" : "services");
-
-  file = fopen(writemacs ? my_macs_file : my_services_file, "w");
-  if (file == NULL) {
-    OLSR_PRINTF(2, "NAME PLUGIN: cant write %s\n", writemacs ? my_macs_file : my_services_file);
-    return;
-  }
+  abuf_init(&abuf, 4096);
 
-  fprintf(file, "### this file is overwritten regularly by olsrd\n");
-  fprintf(file, "### do not edit\n\n");
+  abuf_puts(&abuf, "### this file is overwritten regularly by olsrd\n");
+  abuf_puts(&abuf, "### do not edit\n\n");
 
   // write own services or macs
   for (name = writemacs ? my_macs : my_services; name != NULL; name = name->next) {
-    fprintf(file, "%s\t# my own %s\n", name->name, writemacs ? "mac" : "service");
+    abuf_appendf(&abuf, "%s\t# my own %s\n", name->name, writemacs ? "mac" : "service");
   }
 
   // write received services or macs
@@ -1232,40 +1553,29 @@ write_services_file(bool writemacs)
           OLSR_PRINTF(6, "%s\t", name->name);
           OLSR_PRINTF(6, "\t#%s\n", olsr_ip_to_string(&strbuf, &entry->originator));
 
-          fprintf(file, "%s\t", name->name);
-          fprintf(file, "\t#%s\n", olsr_ip_to_string(&strbuf, &entry->originator));
+          abuf_appendf(&abuf, "%s\t\t#%s\n", name->name, olsr_ip_to_string(&strbuf, &entry->originator));
         }
       }
     }
   }
 
-  if (time(&currtime)) {
-    fprintf(file, "\n### written by olsrd at %s", ctime(&currtime));
-  }
-
-  fclose(file);
-  if (writemacs) {
-    // Executes my_macs_change_script after writing the macs file
-    if (my_macs_change_script[0] != '\0') {
-      if (system(my_macs_change_script) != -1) {
-        OLSR_PRINTF(2, "NAME PLUGIN: Service changed, %s executed\n", my_macs_change_script);
-      } else {
-        OLSR_PRINTF(2, "NAME PLUGIN: WARNING! Failed to execute %s on mac change\n", my_macs_change_script);
-      }
-    }
-    mac_table_changed = false;
-  }
-  else {
-    // Executes my_services_change_script after writing the services file
-    if (my_services_change_script[0] != '\0') {
-      if (system(my_services_change_script) != -1) {
-        OLSR_PRINTF(2, "NAME PLUGIN: Service changed, %s executed\n", my_services_change_script);
-      } else {
-        OLSR_PRINTF(2, "NAME PLUGIN: WARNING! Failed to execute %s on service change\n", my_services_change_script);
-      }
+  switch (name_write_file(writemacs ? my_macs_file : my_services_file, writemacs ? &macs_file_written : &services_file_written, &abuf)) {
+  case 1:
+    OLSR_PRINTF(2, "NAME PLUGIN: wrote %s file\n", writemacs ? "macs" : "services");
+    name_reload(writemacs ? NAME_RELOAD_MACS : NAME_RELOAD_SERVICES);
+    /* fall through */
+  case 0:
+    if (writemacs) {
+      mac_table_changed = false;
+    } else {
+      service_table_changed = false;
     }
-    service_table_changed = false;
+    break;
+  default:
+    break;
   }
+
+  abuf_free(&abuf);
 }
 
 /**
@@ -1319,9 +1629,8 @@ write_resolv_file(void)
   struct list_node *list_head, *list_node;
   struct rt_entry *route;
   static struct rt_entry *nameserver_routes[NAMESERVER_COUNT + 1];
-  FILE *resolv;
+  struct autobuf abuf;
   int i = 0;
-  time_t currtime;
 
   if (!forwarder_table_changed || my_forwarders != NULL || my_resolv_file[0] == '\0')
     return;
@@ -1365,14 +1674,9 @@ write_resolv_file(void)
     return;
 
   /* write to file */
-  OLSR_PRINTF(2, "NAME PLUGIN: try to write to resolv file\n");
-  resolv = fopen(my_resolv_file, "w");
-  if (resolv == NULL) {
-    OLSR_PRINTF(2, "NAME PLUGIN: can't write resolv file\n");
-    return;
-  }
-  fprintf(resolv, "### this file is overwritten regularly by olsrd\n");
-  fprintf(resolv, "### do not edit\n\n");
+  abuf_init(&abuf, 256);
+  abuf_puts(&abuf, "### this file is overwritten regularly by olsrd\n");
+  abuf_puts(&abuf, "### do not edit\n\n");
 
   for (i = NAMESERVER_COUNT; i >= 0; i--) {
     struct ipaddr_str strbuf;
@@ -1386,13 +1690,13 @@ write_resolv_file(void)
     }
 
     OLSR_PRINTF(2, "NAME PLUGIN: nameserver %s\n", olsr_ip_to_string(&strbuf, &route->rt_dst.prefix));
-    fprintf(resolv, "nameserver %s\n", olsr_ip_to_string(&strbuf, &route->rt_dst.prefix));
+    abuf_appendf(&abuf, "nameserver %s\n", olsr_ip_to_string(&strbuf, &route->rt_dst.prefix));
   }
-  if (time(&currtime)) {
-    fprintf(resolv, "\n### written by olsrd at %s", ctime(&currtime));
+
+  if (name_write_file(my_resolv_file, &resolv_file_written, &abuf) >= 0) {
+    forwarder_table_changed = false;
   }
-  fclose(resolv);
-  forwarder_table_changed = false;
+  abuf_free(&abuf);
 }
 
 /**
@@ -57,6 +57,7 @@
 #include "interfaces.h"
 #include "olsr_protocol.h"
 #include "common/list.h"
+#include "common/avl.h"
 
 #include "olsrd_plugin.h"
 #include "nameservice_msg.h"
@@ -119,11 +120,34 @@ struct db_entry {
   struct timer_entry *db_timer;        /* Validity time */
   struct name_entry *names;            /* list of names this originator declares */
   struct list_node db_list;            /* linked list of db entries per hash container */
+  struct name_index_addr *index;       /* host names of this entry in the name index */
 };
 
 /* INLINE to recast from db_list back to db_entry */
 LISTNODE2STRUCT(list2db, struct db_entry, db_list);
 
+/*
+ * the host names of all nodes sorted by name (with the suffix), each
+ * with the addresses it resolves to; the names of an originator are
+ * updated in place when they change or expire
+ */
+struct name_index_addr {
+  union olsr_ip_addr ip;
+  union olsr_ip_addr originator;       /* node that declared the name */
+  int mid;                             /* number of the MID alias, or 0 */
+  struct name_index_addr *next;        /* sorted by ip */
+  struct name_index_entry *entry;      /* name this address belongs to */
+  struct name_index_addr *owner_next;  /* other addresses of the same originator */
+};
+
+struct name_index_entry {
+  struct avl_node node;
+  char *name;
+  struct name_index_addr *addrs;
+};
+
+AVLNODE2STRUCT(node2nameindex, struct name_index_entry, node);
+
 #define OLSR_NAMESVC_DB_JITTER 5        /* percent */
 
 extern struct name_entry *my_names;
@@ -161,6 +185,8 @@ void write_services_file(bool writemacs);
 
 void write_resolv_file(void);
 
+const struct name_index_entry *name_index_lookup(const char *name);
+
 int register_olsr_param(char *key, char *value);
 
 void free_name_entry_list(struct name_entry **list);
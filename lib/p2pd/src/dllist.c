@@ -98,23 +98,18 @@ void remove_node(struct node ** head, struct node **tail, struct node * node, bo
       if (free_data)
         free(curr->data);
 
+      // A node can be both the head and the tail
       if (curr == *head) {
-        // Head node
         *head = curr->next;
-      } else if (curr == *tail) {
-        // Tail node
-        *tail = curr->prev;
       } else {
-        // Middle node
         curr->prev->next = curr->next;
-        curr->next->prev = curr->prev;
       }
 
-      if (*head != NULL)
-        (*head)->prev = NULL;
-
-      if (*tail != NULL)
-        (*tail)->next = NULL;
+      if (curr == *tail) {
+        *tail = curr->prev;
+      } else {
+        curr->next->prev = curr->prev;
+      }
 
       if (curr != NULL) {
         curr->next = curr->prev = NULL;
@@ -76,6 +76,7 @@
 #include "link_set.h"           /* get_best_link_to_neighbor() */
 #include "net_olsr.h"           /* ipequal */
 #include "parser.h"
+#include "hashing.h"            /* olsr_ip_hashing() */
 
 /* plugin includes */
 #include "NetworkInterfaces.h"  /* NonOlsrInterface,
@@ -96,10 +97,14 @@ int P2pdDuplicateTimeout           = P2PD_VALID_TIME;
 /* List of UDP destination address and port information */
 struct UdpDestPort *                 UdpDestPortList = NULL;
 
-/* List of filter entries to check for duplicate messages
+/* Lists of filter entries to check for duplicate messages, hashed on
+ * originator and sequence number. Each list is in order of creation time.
  */
-struct node *                        dupFilterHead = NULL;
-struct node *                        dupFilterTail = NULL;
+struct node *                        dupFilterHead[HASHSIZE];
+struct node *                        dupFilterTail[HASHSIZE];
+
+/* The list that is checked next for aged entries */
+static unsigned int                  dupFilterSweep = 0;
 
 bool is_broadcast(const struct sockaddr_in addr);
 bool is_multicast(const struct sockaddr_in addr);
@@ -300,6 +305,20 @@ fd_set InputSet;
  * Return     : true if message was found, false otherwise
  * Data Used  : P2pdDuplicateTimeout
  * ------------------------------------------------------------------------- */
+static void
+p2pd_expire_messages(struct node **head, struct node **tail, time_t now)
+{
+  // The oldest entries are at the head of the list
+  while (*head) {
+    struct DupFilterEntry *filter = (struct DupFilterEntry*)(*head)->data;
+
+    if ((filter->creationtime + P2pdDuplicateTimeout) >= now)
+      break;
+
+    remove_node(head, tail, *head, true);
+  }
+}
+
 bool
 p2pd_message_seen(struct node **head, struct node **tail, union olsr_message *m)
 {
@@ -309,20 +328,7 @@ p2pd_message_seen(struct node **head, struct node **tail, union olsr_message *m)
   now = time(NULL);
 
   // Check whether any entries have aged
-  curr = *head;
-  while (curr) {
-    struct DupFilterEntry *filter;
-    struct node * next = curr->next; // Save the current pointer since curr may
-                                     // be destroyed
-
-    filter = (struct DupFilterEntry*)curr->data;
-
-    if ((filter->creationtime + P2pdDuplicateTimeout) < now)
-      remove_node(head, tail, curr, true);
-
-    // Skip to the next element
-    curr = next;
-  }
+  p2pd_expire_messages(head, tail, now);
 
   // Now check whether there are any duplicates
   for (curr = *head; curr; curr = curr->next) {
@@ -400,11 +406,28 @@ p2pd_store_message(struct node **head, struct node **tail, union olsr_message *m
 bool
 p2pd_is_duplicate_message(union olsr_message *msg)
 {
-  if(p2pd_message_seen(&dupFilterHead, &dupFilterTail, msg)) {
+  union olsr_ip_addr originator;
+  uint16_t seqno;
+  uint32_t idx;
+
+  if (olsr_cnf->ip_version == AF_INET) {
+    originator.v4.s_addr = msg->v4.originator;
+    seqno = msg->v4.seqno;
+  } else /* if (olsr_cnf->ip_version == AF_INET6) */ {
+    originator.v6 = msg->v6.originator;
+    seqno = msg->v6.seqno;
+  }
+  idx = (olsr_ip_hashing(&originator) + seqno) & (HASHSIZE - 1);
+
+  // Age one of the other lists as well, so lists that are not used anymore get emptied
+  dupFilterSweep = (dupFilterSweep + 1) & (HASHSIZE - 1);
+  p2pd_expire_messages(&dupFilterHead[dupFilterSweep], &dupFilterTail[dupFilterSweep], time(NULL));
+
+  if(p2pd_message_seen(&dupFilterHead[idx], &dupFilterTail[idx], msg)) {
     return true;
   }
 
-  p2pd_store_message(&dupFilterHead, &dupFilterTail, msg);
+  p2pd_store_message(&dupFilterHead[idx], &dupFilterTail[idx], msg);
 
   return false;
 }
@@ -618,43 +641,16 @@ InUdpDestPortList(int ip_version, union olsr_ip_addr *addr, uint16_t port)
 }
 
 /*
- * Function for checksum calculation.
- * From the RFC, the checksum algorithm is:
- *   "The checksum field is the 16 bit one's complement of the one's
- *   complement sum of all 16 bit words in the header. For purposes of
- *   computing the checksum, the value of the checksum field is zero."
- *
- * For example, consider Hex 4500003044224000800600008c7c19acae241e2b (20 bytes IP header):
- * - Step 1) 4500 + 0030 + 4422 + 4000 + 8006 + 0000 + 8c7c + 19ac + ae24 + 1e2b = 0002`BBCF (16-bit sum)
- * - Step 2) 0002 + BBCF = BBD1 = 1011101111010001 (1's complement 16-bit sum)
- * - Step 3) ~BBD1 = 0100010000101110 = 442E (1's complement of 1's complement 16-bit sum)
+ * Update the header checksum of an IPv4 packet of which the TTL was just
+ * decremented by one, without summing the whole header (RFC 1141, RFC 1624).
+ * The TTL is the high byte of a 16 bit header word, so that word decreased by
+ * 0x0100 and the one's complement checksum increases by 0x0100. Like a full
+ * recomputation, this never yields 0xffff.
  */
-static void recomputeIPv4HeaderChecksum(struct ip *header) {
-  uint32_t sum;
-  uint32_t nwords;
-  u_short *headerWords;
-
-  if (!header) {
-    return;
-  }
-
-  header->ip_sum = 0;
-  nwords = header->ip_hl << 1;
-  headerWords = (u_short *) header;
+static void updateIPv4HeaderChecksumForTtlDecrement(struct ip *header) {
+  uint32_t sum = ntohs(header->ip_sum) + 0x0100;
 
-  /* step 1 */
-  for (sum = 0; nwords > 0; nwords--) {
-    sum += ntohs(*headerWords);
-    headerWords++;
-  }
-
-  /* step 2 */
-  sum = (sum >> 16) + (sum & 0xffff);
-
-  /* step 3 */
-  sum = ~sum & 0xffff;
-
-  header->ip_sum = htons((u_short)sum);
+  header->ip_sum = htons((u_short)(sum + (sum >= 0xffff)));
 }
 
 /* -------------------------------------------------------------------------
@@ -789,7 +785,7 @@ P2pdPacketCaptured(unsigned char *encapsulationUdpData, int nBytes)
     }
 
     if (recomputeChecksum) {
-      recomputeIPv4HeaderChecksum(ipHeader);
+      updateIPv4HeaderChecksumForTtlDecrement(ipHeader);
     }
   }
 
@@ -903,7 +899,13 @@ InitP2pd(struct interface_olsr *skipThisIntf)
 void
 CloseP2pd(void)
 {
+  int i;
+
   CloseNonOlsrNetworkInterfaces();
+
+  for (i = 0; i < HASHSIZE; i++) {
+    clear_list(&dupFilterHead[i], &dupFilterTail[i], true);
+  }
 }
 
 /* -------------------------------------------------------------------------
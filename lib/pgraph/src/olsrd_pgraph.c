@@ -54,6 +54,9 @@
 #include "net_olsr.h"
 #include "olsr.h"
 #include "builddata.h"
+#include "scheduler.h"
+#include "common/autobuf.h"
+#include "common/avl.h"
 
 #include <stdio.h>
 #include <string.h>
@@ -61,15 +64,22 @@
 #include <unistd.h>
 #include <errno.h>
 #include <signal.h>
+#include <fcntl.h>
 #ifdef _WIN32
 #define close(x) closesocket(x)
 #endif /* _WIN32 */
 
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif /* MSG_NOSIGNAL */
+
 #define PLUGIN_NAME              "OLSRD pgraph plugin"
 #define PLUGIN_INTERFACE_VERSION 5
 
 static union olsr_ip_addr ipc_accept_ip;
 static int ipc_port;
+static int frame_interval;
+static bool delta;
 
 static int ipc_socket;
 static int ipc_connection;
@@ -78,6 +88,8 @@ void my_init(void) __attribute__ ((constructor));
 
 void my_fini(void) __attribute__ ((destructor));
 
+static void ipc_close(void);
+
 /*
  * Defines the version of the plugin interface that is used
  * THIS IS NOT THE VERSION OF YOUR PLUGIN!
@@ -105,6 +117,8 @@ my_init(void)
   } else {
     ipc_accept_ip.v6 = in6addr_loopback;
   }
+  frame_interval = 1000;
+  delta = false;
   ipc_socket = -1;
   ipc_connection = -1;
 }
@@ -120,8 +134,7 @@ my_fini(void)
     ipc_socket = -1;
   }
   if (ipc_connection >= 0) {
-    close(ipc_connection);
-    ipc_connection = -1;
+    ipc_close();
   }
 
 }
@@ -129,6 +142,8 @@ my_fini(void)
 static const struct olsrd_plugin_parameters plugin_parameters[] = {
   {.name = "port",.set_plugin_parameter = &set_plugin_port,.data = &ipc_port},
   {.name = "accept",.set_plugin_parameter = &set_plugin_ipaddress,.data = &ipc_accept_ip},
+  {.name = "frameinterval",.set_plugin_parameter = &set_plugin_int,.data = &frame_interval},
+  {.name = "delta",.set_plugin_parameter = &set_plugin_boolean,.data = &delta},
 };
 
 void
@@ -138,60 +153,160 @@ olsrd_get_plugin_parameters(const struct olsrd_plugin_parameters **params, int *
   *size = sizeof(plugin_parameters) / sizeof(*plugin_parameters);
 }
 
+/*
+ * The links that were last sent to the front end, so that only new and
+ * removed links have to be sent.
+ */
+struct pgraph_link_key {
+  union olsr_ip_addr from;
+  union olsr_ip_addr to;
+};
+
+struct pgraph_link {
+  struct avl_node node;
+  struct pgraph_link_key key;
+  uint32_t frame;                      /* last frame the link was seen in */
+};
+
+AVLNODE2STRUCT(node2link, struct pgraph_link, node);
+
+static struct autobuf outbuffer;
+static struct timer_entry *frametimer_entry;
+static struct avl_tree link_tree;
+static uint32_t link_frame;
+static bool frame_dirty;
+
 /* Event function to register with the sceduler */
 static int pcf_event(int, int, int);
 
 static void ipc_action(int, void *, unsigned int);
 
-static void ipc_print_neigh_link(struct neighbor_entry *neighbor);
+static void ipc_write_data(int, void *, unsigned int);
 
-static void ipc_print_tc_link(struct tc_entry *entry, struct tc_edge_entry *dst_entry);
+static void ipc_frame(void *);
 
-static int ipc_send(const char *, int);
-
-static void ipc_print_neigh_link(struct neighbor_entry *);
+static unsigned int ipc_collect_links(bool);
 
 static int plugin_ipc_init(void);
 
+static int
+link_comp(const void *a, const void *b)
+{
+  return memcmp(a, b, sizeof(struct pgraph_link_key));
+}
+
 static void
-ipc_print_neigh_link(struct neighbor_entry *neighbor)
+ipc_print_link(const char *cmd, const struct pgraph_link *link)
 {
-  char buf[256];
-  int len;
-  struct ipaddr_str main_adr, adr;
-//  double etx=0.0;
-//  char* style = "solid";
-//  struct link_entry* link;
-
-  len =
-    sprintf(buf, "add link %s %s\n", olsr_ip_to_string(&main_adr, &olsr_cnf->main_addr),
-            olsr_ip_to_string(&adr, &neighbor->neighbor_main_addr));
-  ipc_send(buf, len);
-
-//  if (neighbor->status == 0) { // non SYM
-//      style = "dashed";
-//  }
-//  else {
-  /* find best link to neighbor for the ETX */
-  //? why cant i just get it one time at fetch_olsrd_data??? (br1)
-//    if(olsr_plugin_io(GETD__LINK_SET, &link, sizeof(link)) && link)
-//    {
-//      link_set = link; // for olsr_neighbor_best_link
-//      link = olsr_neighbor_best_link(&neighbor->neighbor_main_addr);
-//      if (link) {
-//        etx = olsr_calc_etx(link);
-//      }
-//    }
-//  }
+  struct ipaddr_str from, to;
+
+  abuf_appendf(&outbuffer, "%s link %s %s\n", cmd, olsr_ip_to_string(&from, &link->key.from), olsr_ip_to_string(&to, &link->key.to));
+}
+
+static unsigned int
+ipc_link(const union olsr_ip_addr *from, const union olsr_ip_addr *to, bool print)
+{
+  struct pgraph_link_key key;
+  struct pgraph_link *link;
+  struct avl_node *node;
+
+  memset(&key, 0, sizeof(key));
+  key.from = *from;
+  key.to = *to;
+
+  node = avl_find(&link_tree, &key);
+  if (node) {
+    node2link(node)->frame = link_frame;
+    return 0;
+  }
+
+  link = olsr_malloc(sizeof(*link), "PGRAPH link");
+  memcpy(&link->key, &key, sizeof(link->key));
+  link->node.key = &link->key;
+  link->frame = link_frame;
+  avl_insert(&link_tree, &link->node, AVL_DUP_NO);
+
+  if (print) {
+    ipc_print_link("add", link);
+  }
+  return 1;
+}
 
-  //len = sprintf( buf, "\"%s\"[label=\"%.2f\", style=%s];\n", adr, etx, style );
-  //len = sprintf( buf, "%s\n", adr );
-  //ipc_send(buf, len);
+/**
+ * Bring the links up to date with the tables of olsrd. With print the
+ * new and removed links are appended to the output buffer.
+ * Returns the number of changed links.
+ */
+static unsigned int
+ipc_collect_links(bool print)
+{
+  struct neighbor_entry *neighbor_table_tmp;
+  struct tc_entry *tc;
+  struct tc_edge_entry *tc_edge;
+  struct avl_node *node, *next;
+  struct pgraph_link *link;
+  unsigned int changes = 0;
 
-  //if (neighbor->is_mpr) {
-  //   len = sprintf( buf, "\"%s\"[shape=box];\n", adr );
-  //   ipc_send(buf, len);
-  //}
+  link_frame++;
+
+  /* Neighbors */
+  OLSR_FOR_ALL_NBR_ENTRIES(neighbor_table_tmp) {
+    changes += ipc_link(&olsr_cnf->main_addr, &neighbor_table_tmp->neighbor_main_addr, print);
+  }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(neighbor_table_tmp);
+
+  /* Topology */
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
+      changes += ipc_link(&tc->addr, &tc_edge->T_dest_addr, print);
+    }
+    OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
+  }
+  OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+
+  /* links that are gone */
+  for (node = avl_walk_first(&link_tree); node; node = next) {
+    next = avl_walk_next(node);
+    link = node2link(node);
+    if (link->frame == link_frame) {
+      continue;
+    }
+
+    changes++;
+    if (print) {
+      ipc_print_link("del", link);
+    }
+    avl_delete(&link_tree, node);
+    free(link);
+  }
+
+  return changes;
+}
+
+/**
+ * Append a frame to the output buffer: with delta only the links that
+ * changed since the last frame, otherwise all of them.
+ */
+static void
+ipc_render(bool full)
+{
+  struct avl_node *node;
+  unsigned int changes;
+
+  changes = ipc_collect_links(delta && !full);
+  if (full || !delta) {
+    if (changes == 0 && !full) {
+      return;
+    }
+    for (node = avl_walk_first(&link_tree); node; node = avl_walk_next(node)) {
+      ipc_print_link("add", node2link(node));
+    }
+  } else if (changes == 0) {
+    return;
+  }
+
+  abuf_puts(&outbuffer, " end ");
+  enable_olsr_socket(ipc_connection, NULL, &ipc_write_data, SP_IMM_WRITE);
 }
 
 /**
@@ -207,6 +322,11 @@ olsrd_plugin_init(void)
   /* Initial IPC value */
   ipc_socket = -1;
 
+  avl_init(&link_tree, &link_comp);
+  if (frame_interval < 10) {
+    frame_interval = 10;
+  }
+
   /* Register the "ProcessChanges" function */
   register_pcf(&pcf_event);
 
@@ -268,12 +388,11 @@ ipc_action(int fd __attribute__ ((unused)), void *data __attribute__ ((unused)),
   struct sockaddr_in pin;
   socklen_t addrlen;
   char *addr;
-  char buf[256];
-  int len;
+  int connection;
 
   addrlen = sizeof(struct sockaddr_in);
 
-  if ((ipc_connection = accept(ipc_socket, (struct sockaddr *)&pin, &addrlen)) == -1) {
+  if ((connection = accept(ipc_socket, (struct sockaddr *)&pin, &addrlen)) == -1) {
     char buf2[1024];
     snprintf(buf2, sizeof(buf2), "(DOT DRAW)IPC accept error: %s", strerror(errno));
     olsr_exit(buf2, EXIT_FAILURE);
@@ -281,6 +400,12 @@ ipc_action(int fd __attribute__ ((unused)), void *data __attribute__ ((unused)),
     struct ipaddr_str main_addr;
     addr = inet_ntoa(pin.sin_addr);
 
+    if (ipc_connection != -1) {
+      olsr_printf(1, "(DOT DRAW)Only one connection at once allowed.\n");
+      close(connection);
+      return;
+    }
+
 /*
       if(ntohl(pin.sin_addr.s_addr) != ntohl(ipc_accept_ip.s_addr))
 	{
@@ -292,115 +417,114 @@ ipc_action(int fd __attribute__ ((unused)), void *data __attribute__ ((unused)),
 	{
 */
     olsr_printf(1, "(DOT DRAW)IPC: Connection from %s\n", addr);
-    len = sprintf(buf, "add node %s\n", olsr_ip_to_string(&main_addr, &olsr_cnf->main_addr));
-    ipc_send(buf, len);
-    pcf_event(1, 1, 1);
+
+    /* a slow front end must never block olsrd */
+#ifdef _WIN32
+    {
+      u_long iMode = 1;
+      ioctlsocket(connection, FIONBIO, &iMode);
+    }
+#else /* _WIN32 */
+    fcntl(connection, F_SETFL, fcntl(connection, F_GETFL) | O_NONBLOCK);
+#endif /* _WIN32 */
+
+    ipc_connection = connection;
+    abuf_init(&outbuffer, AUTOBUFCHUNK);
+    add_olsr_socket(ipc_connection, NULL, &ipc_write_data, NULL, 0);
+    frametimer_entry = olsr_start_timer(frame_interval, 0, OLSR_TIMER_PERIODIC, &ipc_frame, NULL, 0);
+
+    /* a new front end starts with all links */
+    abuf_appendf(&outbuffer, "add node %s\n", olsr_ip_to_string(&main_addr, &olsr_cnf->main_addr));
+    frame_dirty = false;
+    ipc_render(true);
 //      }
   }
 
 }
 
-/**
- *Scheduled event
- */
-static int
-pcf_event(int my_changes_neighborhood, int my_changes_topology, int my_changes_hna __attribute__ ((unused)))
+static void
+ipc_close(void)
 {
-  int res;
-  struct neighbor_entry *neighbor_table_tmp;
-  struct tc_entry *tc;
-  struct tc_edge_entry *tc_edge;
-
-  res = 0;
-
-  if (my_changes_neighborhood || my_changes_topology) {
-    /* Print tables to IPC socket */
+  struct avl_node *node;
 
-    //ipc_send("start ", strlen("start "));
+  remove_olsr_socket(ipc_connection, NULL, &ipc_write_data);
+  close(ipc_connection);
+  ipc_connection = -1;
+  abuf_free(&outbuffer);
+  olsr_stop_timer(frametimer_entry);
+  frametimer_entry = NULL;
 
-    /* Neighbors */
-    OLSR_FOR_ALL_NBR_ENTRIES(neighbor_table_tmp) {
-      ipc_print_neigh_link(neighbor_table_tmp);
-    }
-    OLSR_FOR_ALL_NBR_ENTRIES_END(neighbor_table_tmp);
+  while ((node = avl_walk_first(&link_tree)) != NULL) {
+    avl_delete(&link_tree, node);
+    free(node2link(node));
+  }
+}
 
-    /* Topology */
-    OLSR_FOR_ALL_TC_ENTRIES(tc) {
-      OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
-        ipc_print_tc_link(tc, tc_edge);
+static void
+ipc_write_data(int fd __attribute__ ((unused)), void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  int result;
+
+  if (outbuffer.len > 0) {
+    result = send(ipc_connection, outbuffer.buf, outbuffer.len, MSG_NOSIGNAL);
+    if (result > 0) {
+      abuf_pull(&outbuffer, result);
+    } else if (result < 0) {
+#if EWOULDBLOCK == EAGAIN
+      if (errno == EAGAIN || errno == EINTR) {
+#else /* EWOULDBLOCK == EAGAIN */
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+#endif /* EWOULDBLOCK == EAGAIN */
+        return;
       }
-      OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
-    }
-    OLSR_FOR_ALL_TC_ENTRIES_END(tc);
-
-    ipc_send(" end ", strlen(" end "));
-
-    /* HNA entries */
-//      for(index=0;index<HASHSIZE;index++)
-//      {
-//        tmp_hna = hna_set[index].next;
-//        /* Check all entrys */
-//        while(tmp_hna != &hna_set[index])
-//          {
-//            /* Check all networks */
-//            tmp_net = tmp_hna->networks.next;
-//
-//            while(tmp_net != &tmp_hna->networks)
-//              {
-//                ipc_print_net(&tmp_hna->A_gateway_addr,
-//                              &tmp_net->A_network_addr,
-//                              &tmp_net->A_netmask);
-//                tmp_net = tmp_net->next;
-//              }
-//
-//            tmp_hna = tmp_hna->next;
-//          }
-//      }
-
-//      ipc_send("}\n\n", strlen("}\n\n"));
 
-    res = 1;
+      olsr_printf(1, "(DOT DRAW)IPC connection lost!\n");
+      ipc_close();
+      return;
+    }
   }
 
-  if (ipc_socket == -1) {
-    plugin_ipc_init();
+  if (outbuffer.len == 0) {
+    disable_olsr_socket(ipc_connection, NULL, &ipc_write_data, SP_IMM_WRITE);
   }
-
-  return res;
 }
 
+/**
+ * Send the changed links at most once per frame interval, and only after
+ * the front end took the previous frame.
+ */
 static void
-ipc_print_tc_link(struct tc_entry *entry, struct tc_edge_entry *dst_entry)
+ipc_frame(void *foo __attribute__ ((unused)))
 {
-  char buf[256];
-  int len;
-  struct ipaddr_str main_adr, adr;
-//  double etx = olsr_calc_tc_etx(dst_entry);
-
-  len =
-    sprintf(buf, "add link %s %s\n", olsr_ip_to_string(&main_adr, &entry->addr), olsr_ip_to_string(&adr, &dst_entry->T_dest_addr));
-  ipc_send(buf, len);
+  if (!frame_dirty || outbuffer.len > 0) {
+    return;
+  }
+
+  frame_dirty = false;
+  ipc_render(false);
 }
 
+/**
+ *Scheduled event
+ */
 static int
-ipc_send(const char *data, int size)
+pcf_event(int my_changes_neighborhood, int my_changes_topology, int my_changes_hna __attribute__ ((unused)))
 {
-  if (ipc_connection == -1)
-    return 0;
+  int res;
+
+  res = 0;
+
+  if (my_changes_neighborhood || my_changes_topology) {
+    /* sent with the next frame */
+    frame_dirty = true;
+    res = 1;
+  }
 
-#if defined __FreeBSD__ || defined __FreeBSD_kernel__ || defined __APPLE__ || defined __OpenBSD__
-#define FLAG 0
-#else /* defined __FreeBSD__ || defined __FreeBSD_kernel__ || defined __APPLE__ || defined __OpenBSD__ */
-#define FLAG MSG_NOSIGNAL
-#endif /* defined __FreeBSD__ || defined __FreeBSD_kernel__ || defined __APPLE__ || defined __OpenBSD__ */
-  if (send(ipc_connection, data, size, FLAG) < 0) {
-    olsr_printf(1, "(DOT DRAW)IPC connection lost!\n");
-    close(ipc_connection);
-    ipc_connection = -1;
-    return -1;
+  if (ipc_socket == -1) {
+    plugin_ipc_init();
   }
 
-  return 1;
+  return res;
 }
 
 /*
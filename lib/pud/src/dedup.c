@@ -60,6 +60,57 @@
 #define WRAPINDEX(x, i)		((i) % LISTSIZE(x)) /* always valid for i>=0 */
 #define INCOMINGINDEX(x)	WRAPINDEX(x, (NEWESTINDEX(x) + LISTSIZE(x) - 1)) /* always valid */
 
+/** marks the end of a hash bucket */
+#define DEDUP_NONE			(~0ULL)
+
+/**
+ Get the originator and the seqno of a message as a de-duplication entry
+
+ @param olsrMessage
+ The message
+ @param entry
+ The entry to fill (its hashNext is not touched)
+ */
+static void getDeDupKey(union olsr_message *olsrMessage, DeDupEntry * entry) {
+	memset(&entry->originator, 0, sizeof(entry->originator));
+	if (olsr_cnf->ip_version == AF_INET) {
+		entry->seqno = olsrMessage->v4.seqno;
+		entry->originator.v4.s_addr = olsrMessage->v4.originator;
+	} else {
+		entry->seqno = olsrMessage->v6.seqno;
+		entry->originator.v6 = olsrMessage->v6.originator;
+	}
+}
+
+/**
+ Calculate the hash bucket of a de-duplication entry (FNV-1a)
+
+ @param deDupList
+ The de-duplication list
+ @param entry
+ The entry
+
+ @return
+ The index of the hash bucket
+ */
+static unsigned long long getDeDupBucket(DeDupList * deDupList, DeDupEntry * entry) {
+	const unsigned char * p = (const unsigned char *) &entry->originator;
+	uint32_t hash = 2166136261u;
+	unsigned int i;
+
+	for (i = 0; i < olsr_cnf->ipsize; i++) {
+		hash = (hash ^ p[i]) * 16777619u;
+	}
+	hash = (hash ^ (entry->seqno & 0xff)) * 16777619u;
+	hash = (hash ^ (entry->seqno >> 8)) * 16777619u;
+
+	return hash & deDupList->bucketsMask;
+}
+
+static bool isSameDeDupEntry(DeDupEntry * a, DeDupEntry * b) {
+	return (a->seqno == b->seqno) && (memcmp(&a->originator, &b->originator, olsr_cnf->ipsize) == 0);
+}
+
 /**
  Initialise the de-duplication list: allocate memory for the entries and
  reset fields.
@@ -76,6 +127,8 @@
  */
 bool initDeDupList(DeDupList * deDupList, unsigned long long maxEntries) {
 	void * p;
+	unsigned long long bucketCount;
+	unsigned long long i;
 
 	if (deDupList == NULL) {
 		return false;
@@ -90,6 +143,23 @@ bool initDeDupList(DeDupList * deDupList, unsigned long long maxEntries) {
 		return false;
 	}
 
+	/* at least as many buckets as entries, as a power of 2 */
+	bucketCount = 1;
+	while (bucketCount < maxEntries) {
+		bucketCount <<= 1;
+	}
+
+	deDupList->buckets = olsr_malloc(bucketCount * sizeof(unsigned long long),
+			"DeDupList hash buckets (PUD)");
+	if (deDupList->buckets == NULL) {
+		free(p);
+		return false;
+	}
+	for (i = 0; i < bucketCount; i++) {
+		deDupList->buckets[i] = DEDUP_NONE;
+	}
+	deDupList->bucketsMask = bucketCount - 1;
+
 	deDupList->entriesMaxCount = maxEntries;
 	deDupList->entries = p;
 
@@ -112,8 +182,13 @@ void destroyDeDupList(DeDupList * deDupList) {
 		free(deDupList->entries);
 		deDupList->entries = NULL;
 	}
+	if (deDupList->buckets != NULL) {
+		free(deDupList->buckets);
+		deDupList->buckets = NULL;
+	}
 
 	deDupList->entriesMaxCount = 0;
+	deDupList->bucketsMask = 0;
 
 	deDupList->entriesCount = 0;
 	deDupList->newestEntryIndex = 0;
@@ -129,6 +204,7 @@ void destroyDeDupList(DeDupList * deDupList) {
  */
 void addToDeDup(DeDupList * deDupList, union olsr_message *olsrMessage) {
 	unsigned long long incomingIndex;
+	unsigned long long bucket;
 	DeDupEntry * newEntry;
 
 	assert (deDupList != NULL);
@@ -136,15 +212,21 @@ void addToDeDup(DeDupList * deDupList, union olsr_message *olsrMessage) {
 	incomingIndex = INCOMINGINDEX(deDupList);
 	newEntry = &deDupList->entries[incomingIndex];
 
-	memset(newEntry, 0, sizeof(DeDupEntry));
-	if (olsr_cnf->ip_version == AF_INET) {
-		newEntry->seqno = olsrMessage->v4.seqno;
-		newEntry->originator.v4.s_addr = olsrMessage->v4.originator;
-	} else {
-		newEntry->seqno = olsrMessage->v6.seqno;
-		newEntry->originator.v6 = olsrMessage->v6.originator;
+	/* the oldest entry is overwritten: remove it from its bucket */
+	if (deDupList->entriesCount == deDupList->entriesMaxCount) {
+		unsigned long long * link = &deDupList->buckets[getDeDupBucket(deDupList, newEntry)];
+		while (*link != incomingIndex) {
+			assert(*link != DEDUP_NONE);
+			link = &deDupList->entries[*link].hashNext;
+		}
+		*link = newEntry->hashNext;
 	}
 
+	getDeDupKey(olsrMessage, newEntry);
+	bucket = getDeDupBucket(deDupList, newEntry);
+	newEntry->hashNext = deDupList->buckets[bucket];
+	deDupList->buckets[bucket] = incomingIndex;
+
 	deDupList->newestEntryIndex = incomingIndex;
 	if (deDupList->entriesCount < deDupList->entriesMaxCount) {
 		deDupList ->entriesCount++;
@@ -165,37 +247,21 @@ void addToDeDup(DeDupList * deDupList, union olsr_message *olsrMessage) {
  - false otherwise
  */
 bool isInDeDupList(DeDupList * deDupList, union olsr_message *olsrMessage) {
-	bool retval = false;
+	DeDupEntry key;
 	unsigned long long iteratedIndex;
-	unsigned long long count;
 
-	iteratedIndex = NEWESTINDEX(deDupList);
-	count = deDupList->entriesCount;
+	getDeDupKey(olsrMessage, &key);
 
-	/* we iterate from newest until oldest: we have a higher probability to
-	 * match on the newest entries */
-
-	while (count > 0) {
+	/* new entries are at the start of a bucket: we have a higher probability
+	 * to match on the newest entries */
+	iteratedIndex = deDupList->buckets[getDeDupBucket(deDupList, &key)];
+	while (iteratedIndex != DEDUP_NONE) {
 		DeDupEntry * iteratedEntry = &deDupList->entries[iteratedIndex];
-		if (olsr_cnf->ip_version == AF_INET) {
-			if ((iteratedEntry->seqno == olsrMessage->v4.seqno) && (memcmp(
-					&iteratedEntry->originator.v4, &olsrMessage->v4.originator,
-					sizeof(iteratedEntry->originator.v4))) == 0) {
-				retval = true;
-				break;
-			}
-		} else {
-			if ((iteratedEntry->seqno == olsrMessage->v6.seqno) && (memcmp(
-					&iteratedEntry->originator.v6, &olsrMessage->v6.originator,
-					sizeof(iteratedEntry->originator.v6)) == 0)) {
-				retval = true;
-				break;
-			}
+		if (isSameDeDupEntry(iteratedEntry, &key)) {
+			return true;
 		}
-
-		iteratedIndex = WRAPINDEX(deDupList, iteratedIndex + 1); /* go the the next older entry */
-		count--;
+		iteratedIndex = iteratedEntry->hashNext;
 	}
 
-	return retval;
+	return false;
 }
@@ -60,18 +60,25 @@
 typedef struct _DeDupEntry {
 		uint16_t seqno;
 		union olsr_ip_addr originator;
+		unsigned long long hashNext; /**< index of the next entry in the same hash bucket */
 } DeDupEntry;
 
 /**
  A list of de-duplication entries that are used to determine whether a received
  OLSR message was already seen.
 
- The list is a circular list.
+ The list is a circular list. The entries are also chained into the buckets
+ of a hash table on (originator, seqno), so that a lookup does not have to
+ scan the whole list. An entry is removed from its bucket when it is
+ overwritten by a new entry.
  */
 typedef struct _DeDupList {
 	unsigned long long entriesMaxCount; /**< the maximum number of entries in the list */
 	DeDupEntry * entries; /**< the list entries */
 
+	unsigned long long bucketsMask; /**< the number of hash buckets minus one */
+	unsigned long long * buckets; /**< index of the first entry of each hash bucket */
+
 	unsigned long long entriesCount; /**< the number of entries in the list */
 	unsigned long long newestEntryIndex; /**< index of the newest entry in the list (zero-based) */
 } DeDupList;
@@ -238,6 +238,50 @@ unsigned int gpsFromOlsr(union olsr_message *olsrMessage,
  * External --> OLSR
  * ************************************************************************ */
 
+/** The size of the buffer in which the last converted OLSR message is kept */
+#define POSITION_UPDATE_CACHE_SIZE 512
+
+/**
+ The inputs from which an OLSR position update message is converted. The
+ position is kept as it is quantized on the wire, so that inputs that only
+ differ below the resolution of the wire format give the same message.
+ */
+typedef struct _PositionUpdateCacheKey {
+		int ipVersion; /**< the IP version of the message */
+		union olsr_ip_addr originator; /**< the originator of the message */
+		uint8_t ttl; /**< the TTL of the message */
+		uint8_t vtime; /**< the OLSR validity time of the message */
+		unsigned int size; /**< the space for the message, a DNS node id is truncated to it */
+		unsigned char wire[PUD_OLSRWIREFORMATSIZE]; /**< the wire format, without the node information */
+} PositionUpdateCacheKey;
+
+/**
+ The last converted OLSR position update message. A stationary node transmits
+ the same position (with the same timestamp) on every update interval, so the
+ message is only converted again when one of its inputs changed.
+ */
+static struct {
+		bool valid; /**< true when the cache holds a message */
+		PositionUpdateCacheKey key; /**< the inputs of the cached message */
+		unsigned int size; /**< the aligned size of the cached message */
+		unsigned char message[POSITION_UPDATE_CACHE_SIZE]; /**< the cached message */
+} positionUpdateCache;
+
+/**
+ Set the message sequence number of an OLSR message to the next OLSR
+ message sequence number
+
+ @param olsrMessage
+ A pointer to the OLSR message
+ */
+static void setNextSeqno(union olsr_message *olsrMessage) {
+	if (olsr_cnf->ip_version == AF_INET) {
+		olsrMessage->v4.seqno = htons(get_msg_seqno());
+	} else {
+		olsrMessage->v6.seqno = htons(get_msg_seqno());
+	}
+}
+
 /**
  Convert a nmeaINFO structure into an OLSR message.
 
@@ -260,6 +304,8 @@ unsigned int gpsToOlsr(NmeaInfo *nmeaInfo, union olsr_message *olsrMessage,
 	unsigned int aligned_size_remainder;
 	size_t nodeLength;
 	nodeIdBinaryType * nodeIdBinary = NULL;
+	PositionUpdateCacheKey key;
+	PudOlsrPositionUpdate * wire;
 
 	PudOlsrPositionUpdate * olsrGpsMessage =
 			getOlsrMessagePayload(olsr_cnf->ip_version, olsrMessage);
@@ -267,52 +313,71 @@ unsigned int gpsToOlsr(NmeaInfo *nmeaInfo, union olsr_message *olsrMessage,
 	/*
 	 * Compose message contents
 	 */
-	memset(olsrGpsMessage, 0, sizeof (PudOlsrPositionUpdate));
-
-	setPositionUpdateVersion(olsrGpsMessage, PUD_WIRE_FORMAT_VERSION);
-	setValidityTime(&olsrGpsMessage->validityTime, validityTime);
-	setPositionUpdatePresent(olsrGpsMessage, nmeaInfo->present & ~PUD_PRESENT_GATEWAY);
+	memset(&key, 0, sizeof(key));
+	key.ipVersion = olsr_cnf->ip_version;
+	key.originator = olsr_cnf->main_addr;
+	key.ttl = getOlsrTtl();
+	key.vtime = reltime_to_me(validityTime * 1000);
+	key.size = olsrMessageSize;
+
+	wire = (PudOlsrPositionUpdate *) &key.wire[0];
+	setPositionUpdateVersion(wire, PUD_WIRE_FORMAT_VERSION);
+	setValidityTime(&wire->validityTime, validityTime);
+	setPositionUpdatePresent(wire, nmeaInfo->present & ~PUD_PRESENT_GATEWAY);
 
 	/* utc is always present, we make sure of that elsewhere, so just use it */
-	setPositionUpdateTime(olsrGpsMessage, nmeaInfo->utc.hour, nmeaInfo->utc.min,
+	setPositionUpdateTime(wire, nmeaInfo->utc.hour, nmeaInfo->utc.min,
 			nmeaInfo->utc.sec);
 
 	if (likely(nmeaInfoIsPresentAll(nmeaInfo->present, NMEALIB_PRESENT_LAT))) {
-		setPositionUpdateLatitude(olsrGpsMessage, nmeaInfo->latitude);
+		setPositionUpdateLatitude(wire, nmeaInfo->latitude);
 	} else {
-		setPositionUpdateLatitude(olsrGpsMessage, 0.0);
+		setPositionUpdateLatitude(wire, 0.0);
 	}
 
 	if (likely(nmeaInfoIsPresentAll(nmeaInfo->present, NMEALIB_PRESENT_LON))) {
-		setPositionUpdateLongitude(olsrGpsMessage, nmeaInfo->longitude);
+		setPositionUpdateLongitude(wire, nmeaInfo->longitude);
 	} else {
-		setPositionUpdateLongitude(olsrGpsMessage, 0.0);
+		setPositionUpdateLongitude(wire, 0.0);
 	}
 
 	if (likely(nmeaInfoIsPresentAll(nmeaInfo->present, NMEALIB_PRESENT_ELV))) {
-		setPositionUpdateAltitude(olsrGpsMessage, nmeaInfo->elevation);
+		setPositionUpdateAltitude(wire, nmeaInfo->elevation);
 	} else {
-		setPositionUpdateAltitude(olsrGpsMessage, 0.0);
+		setPositionUpdateAltitude(wire, 0.0);
 	}
 
 	if (likely(nmeaInfoIsPresentAll(nmeaInfo->present, NMEALIB_PRESENT_SPEED))) {
-		setPositionUpdateSpeed(olsrGpsMessage, nmeaInfo->speed);
+		setPositionUpdateSpeed(wire, nmeaInfo->speed);
 	} else {
-		setPositionUpdateSpeed(olsrGpsMessage, 0.0);
+		setPositionUpdateSpeed(wire, 0.0);
 	}
 
 	if (likely(nmeaInfoIsPresentAll(nmeaInfo->present, NMEALIB_PRESENT_TRACK))) {
-		setPositionUpdateTrack(olsrGpsMessage, nmeaInfo->track);
+		setPositionUpdateTrack(wire, nmeaInfo->track);
 	} else {
-		setPositionUpdateTrack(olsrGpsMessage, 0);
+		setPositionUpdateTrack(wire, 0);
 	}
 
 	if (likely(nmeaInfoIsPresentAll(nmeaInfo->present, NMEALIB_PRESENT_HDOP))) {
-		setPositionUpdateHdop(olsrGpsMessage, nmeaInfo->hdop);
+		setPositionUpdateHdop(wire, nmeaInfo->hdop);
 	} else {
-		setPositionUpdateHdop(olsrGpsMessage, PUD_HDOP_MAX);
+		setPositionUpdateHdop(wire, PUD_HDOP_MAX);
+	}
+
+	/*
+	 * Reuse the previously converted message when its contents did not change,
+	 * only the sequence number needs to be renewed
+	 */
+	if (positionUpdateCache.valid && !memcmp(&positionUpdateCache.key, &key, sizeof(key))) {
+		memcpy(olsrMessage, &positionUpdateCache.message[0], positionUpdateCache.size);
+		setNextSeqno(olsrMessage);
+		return positionUpdateCache.size;
 	}
 
+	memset(olsrGpsMessage, 0, sizeof (PudOlsrPositionUpdate));
+	memcpy(olsrGpsMessage, wire, PUD_OLSRWIREFORMATSIZE);
+
 	nodeIdBinary = getNodeIdBinary();
 	nodeLength = setPositionUpdateNodeInfo(olsr_cnf->ip_version, olsrGpsMessage,
 			olsrMessageSize, getNodeIdTypeNumber(),
@@ -338,12 +403,11 @@ unsigned int gpsToOlsr(NmeaInfo *nmeaInfo, union olsr_message *olsrMessage,
 		/* IPv4 */
 
 		olsrMessage->v4.olsr_msgtype = PUD_OLSR_MSG_TYPE;
-		olsrMessage->v4.olsr_vtime = reltime_to_me(validityTime * 1000);
+		olsrMessage->v4.olsr_vtime = key.vtime;
 		/* message->v4.olsr_msgsize at the end */
 		olsrMessage->v4.originator = olsr_cnf->main_addr.v4.s_addr;
 		olsrMessage->v4.ttl = getOlsrTtl();
 		olsrMessage->v4.hopcnt = 0;
-		olsrMessage->v4.seqno = htons(get_msg_seqno());
 
 		/* add length of message->v4 fields */
 		aligned_size += (sizeof(olsrMessage->v4)
@@ -353,12 +417,11 @@ unsigned int gpsToOlsr(NmeaInfo *nmeaInfo, union olsr_message *olsrMessage,
 		/* IPv6 */
 
 		olsrMessage->v6.olsr_msgtype = PUD_OLSR_MSG_TYPE;
-		olsrMessage->v6.olsr_vtime = reltime_to_me(validityTime * 1000);
+		olsrMessage->v6.olsr_vtime = key.vtime;
 		/* message->v6.olsr_msgsize at the end */
 		olsrMessage->v6.originator = olsr_cnf->main_addr.v6;
 		olsrMessage->v6.ttl = getOlsrTtl();
 		olsrMessage->v6.hopcnt = 0;
-		olsrMessage->v6.seqno = htons(get_msg_seqno());
 
 		/* add length of message->v6 fields */
 		aligned_size += (sizeof(olsrMessage->v6)
@@ -372,5 +435,15 @@ unsigned int gpsToOlsr(NmeaInfo *nmeaInfo, union olsr_message *olsrMessage,
 				0, (4 - aligned_size_remainder));
 	}
 
+	setNextSeqno(olsrMessage);
+
+	/* remember the message for the next conversion */
+	positionUpdateCache.valid = (aligned_size <= sizeof(positionUpdateCache.message));
+	if (positionUpdateCache.valid) {
+		positionUpdateCache.key = key;
+		memcpy(&positionUpdateCache.message[0], olsrMessage, aligned_size);
+		positionUpdateCache.size = aligned_size;
+	}
+
 	return aligned_size;
 }
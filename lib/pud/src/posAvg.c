@@ -548,8 +548,8 @@ static void addAngleComponents(AngleComponents * dst, AngleComponents * src, boo
 
 /**
  Add/remove a position update entry to/from the average position list, updates
- the counters, adjusts the entriesCount and redetermines the cumulative
- smask, sig and fix.
+ the counters and adjusts the entriesCount. The caller must redetermine the
+ cumulative smask, sig and fix afterwards.
 
  @param positionAverageList
  The position average list
@@ -628,7 +628,6 @@ static void addOrRemoveEntryToFromCumulativeAverage(
 	positionAverageList->entriesCount += (add ? 1 : -1);
 
 	updateCounters(positionAverageList, entry, add);
-	determineCumulativePresentSmaskSigFix(positionAverageList);
 }
 
 /**
@@ -698,6 +697,7 @@ void addNewPositionToAverage(PositionAverageList * positionAverageList,
 
 	/* now just add the new position */
 	addOrRemoveEntryToFromCumulativeAverage(positionAverageList, newEntry, true);
+	determineCumulativePresentSmaskSigFix(positionAverageList);
 
 	/* update the place where the new entry is stored */
 	positionAverageList->newestEntryIndex
@@ -63,6 +63,7 @@
 #include "log.h"
 
 /* System includes */
+#include <sys/socket.h>
 
 /** The size of the buffer in which the received downlink message is stored */
 #define BUFFER_SIZE_RX_DOWNLINK	2048
@@ -71,6 +72,28 @@
  * transmission over OSLR */
 #define BUFFER_SIZE_TX_OLSR 	512
 
+/** The maximum number of NMEA strings that are queued for transmission over
+ * the transmit interfaces before the queue is flushed */
+#define TX_QUEUE_SIZE 32
+
+/** An NMEA string that is queued for transmission */
+typedef struct _TxQueueEntry {
+		unsigned char buffer[BUFFER_SIZE_TX_OLSR]; /**< the NMEA string */
+		unsigned int length; /**< the length of the NMEA string */
+} TxQueueEntry;
+
+/** The transmit queue */
+static TxQueueEntry txQueue[TX_QUEUE_SIZE];
+
+/** The number of entries in the transmit queue */
+static unsigned int txQueueCount = 0;
+
+/** The transmit queue timer cookie, used to trace back the originator in debug */
+static struct olsr_cookie_info *pud_tx_queue_timer_cookie = NULL;
+
+/** The transmit queue timer */
+static struct timer_entry * pud_tx_queue_timer = NULL;
+
 /** The de-duplication list */
 static DeDupList deDupList;
 
@@ -124,19 +147,24 @@ void pudError(bool useErrno, const char *format, ...) {
 }
 
 /**
- Sends a buffer out on all transmit interfaces
-
- @param buffer
- the buffer
- @param bufferLength
- the number of bytes in the buffer
+ Sends all queued NMEA strings out on all transmit interfaces. On Linux all
+ queued strings are handed to the kernel with a single sendmmsg call per
+ interface, elsewhere they are sent one by one.
  */
-static void sendToAllTxInterfaces(unsigned char *buffer,
-		unsigned int bufferLength) {
+static void flushTxQueue(void) {
 	union olsr_sockaddr * txAddress = getTxMcAddr();
 	void * addr;
 	socklen_t addrSize;
 	TRxTxNetworkInterface *txNetworkInterfaces = getTxNetworkInterfaces();
+#ifdef __linux__
+	struct mmsghdr msgs[TX_QUEUE_SIZE];
+	struct iovec iovs[TX_QUEUE_SIZE];
+#endif /* __linux__ */
+	unsigned int i;
+
+	if (!txQueueCount) {
+		return;
+	}
 
 	if (txAddress->in.sa_family == AF_INET) {
 		addr = &txAddress->in4;
@@ -146,14 +174,82 @@ static void sendToAllTxInterfaces(unsigned char *buffer,
 		addrSize = sizeof(struct sockaddr_in6);
 	}
 
+#ifdef __linux__
+	memset(msgs, 0, txQueueCount * sizeof(msgs[0]));
+	for (i = 0; i < txQueueCount; i++) {
+		iovs[i].iov_base = &txQueue[i].buffer[0];
+		iovs[i].iov_len = txQueue[i].length;
+		msgs[i].msg_hdr.msg_name = addr;
+		msgs[i].msg_hdr.msg_namelen = addrSize;
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+#endif /* __linux__ */
+
 	while (txNetworkInterfaces != NULL) {
 		TRxTxNetworkInterface *networkInterface = txNetworkInterfaces;
-		errno = 0;
-		if (sendto(networkInterface->socketFd, buffer, bufferLength, 0, addr, addrSize) < 0) {
-			pudError(true, "Transmit error on interface %s", &networkInterface->name[0]);
+#ifdef __linux__
+		i = 0;
+		while (i < txQueueCount) {
+			int sent;
+
+			errno = 0;
+			sent = sendmmsg(networkInterface->socketFd, &msgs[i], txQueueCount - i, 0);
+			if (sent <= 0) {
+				/* skip the message that could not be sent */
+				pudError(true, "Transmit error on interface %s", &networkInterface->name[0]);
+				sent = 1;
+			}
+			i += sent;
+		}
+#else /* __linux__ */
+		for (i = 0; i < txQueueCount; i++) {
+			errno = 0;
+			if (sendto(networkInterface->socketFd, &txQueue[i].buffer[0], txQueue[i].length, 0, addr, addrSize) < 0) {
+				pudError(true, "Transmit error on interface %s", &networkInterface->name[0]);
+			}
 		}
+#endif /* __linux__ */
 		txNetworkInterfaces = networkInterface->next;
 	}
+
+	txQueueCount = 0;
+}
+
+/**
+ Timer callback that flushes the transmit queue
+ */
+static void pud_tx_queue_timer_callback(void *context __attribute__ ((unused))) {
+	pud_tx_queue_timer = NULL;
+	flushTxQueue();
+}
+
+/**
+ Account for an NMEA string that was placed in the next free transmit queue
+ entry. The queue is flushed when it is full, otherwise a flush is scheduled
+ for the next scheduler tick so that all position updates that are received
+ in one tick are transmitted together.
+ */
+static void queueForAllTxInterfaces(void) {
+	txQueueCount++;
+
+	if (txQueueCount >= TX_QUEUE_SIZE) {
+		if (pud_tx_queue_timer != NULL) {
+			olsr_stop_timer(pud_tx_queue_timer);
+			pud_tx_queue_timer = NULL;
+		}
+		flushTxQueue();
+		return;
+	}
+
+	if (pud_tx_queue_timer == NULL) {
+		pud_tx_queue_timer = olsr_start_timer(0, 0, OLSR_TIMER_ONESHOT, &pud_tx_queue_timer_callback, NULL,
+				pud_tx_queue_timer_cookie);
+		if (pud_tx_queue_timer == NULL) {
+			/* can't defer, send right away */
+			flushTxQueue();
+		}
+	}
 }
 
 /**
@@ -177,7 +273,7 @@ bool packetReceivedFromOlsr(union olsr_message *olsrMessage,
 	const union olsr_ip_addr * originator = getOlsrMessageOriginator(
 			olsr_cnf->ip_version, olsrMessage);
 	unsigned int transmitStringLength;
-	unsigned char buffer[BUFFER_SIZE_TX_OLSR];
+	TxQueueEntry * entry = &txQueue[txQueueCount];
 
 	/* when we do not loopback then check if the message originated from this
 	 * node: back off */
@@ -195,13 +291,14 @@ bool packetReceivedFromOlsr(union olsr_message *olsrMessage,
 		addToDeDup(&deDupList, olsrMessage);
 	}
 
-	transmitStringLength = gpsFromOlsr(olsrMessage, &buffer[0], sizeof(buffer));
-	assert(transmitStringLength <= sizeof(buffer));
+	transmitStringLength = gpsFromOlsr(olsrMessage, &entry->buffer[0], sizeof(entry->buffer));
+	assert(transmitStringLength <= sizeof(entry->buffer));
 	if (unlikely(transmitStringLength == 0)) {
 		return false;
 	}
 
-	sendToAllTxInterfaces(&buffer[0], transmitStringLength);
+	entry->length = transmitStringLength;
+	queueForAllTxInterfaces();
 
 	return true;
 }
@@ -271,7 +368,9 @@ static void packetReceivedFromDownlink(int skfd, void *data __attribute__ ((unus
 			/* we now have a position update (olsrMessage) of a certain length
 			 * (olsrMessageLength). this needs to be transmitted over OLSR and on the LAN */
 
-			/* send out over OLSR interfaces (only when the smart gateway system is enabled) */
+			/* send out over OLSR interfaces (only when the smart gateway system is enabled),
+			 * the messages of the whole downlink packet end up in the same pending OLSR
+			 * packet of each interface */
 			if (olsr_cnf->smart_gw_active)
 			{
 				int r;
@@ -371,6 +470,14 @@ bool initPud(void) {
 	/* switch to syslog logging, load was succesful */
 	pudErrorUseSysLog = !olsr_cnf->no_fork;
 
+	if (pud_tx_queue_timer_cookie == NULL) {
+		pud_tx_queue_timer_cookie = olsr_alloc_cookie("pud tx queue", OLSR_COOKIE_TYPE_TIMER);
+		if (pud_tx_queue_timer_cookie == NULL) {
+			pudError(false, "Could not allocate pud tx queue cookie");
+			return false;
+		}
+	}
+
 	positionFilePeriod = getPositionFilePeriod();
 	if (getPositionFile() && positionFilePeriod) {
 		if (pud_position_file_timer_cookie == NULL) {
@@ -401,6 +508,15 @@ bool initPud(void) {
  the NMEA parser.
  */
 void closePud(void) {
+	if (pud_tx_queue_timer != NULL) {
+		olsr_stop_timer(pud_tx_queue_timer);
+		pud_tx_queue_timer = NULL;
+	}
+	flushTxQueue();
+	if (pud_tx_queue_timer_cookie != NULL) {
+		olsr_free_cookie(pud_tx_queue_timer_cookie);
+		pud_tx_queue_timer_cookie = NULL;
+	}
 	if (pud_position_file_timer != NULL) {
 		olsr_stop_timer(pud_position_file_timer);
 		pud_position_file_timer = NULL;
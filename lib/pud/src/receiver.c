@@ -216,6 +216,10 @@ static void txToAllOlsrInterfaces(TimedTxInterface interfaces) {
 	if (((interfaces & TX_INTERFACE_OLSR) != 0) && getOlsrTtl() && (pu_size > 0)) {
 		int r;
 		struct interface_olsr *ifn;
+
+		/* the message is appended to the pending OLSR packet of each interface,
+		 * the core sends that packet once per scheduler tick (or right away when it
+		 * is full), together with the other messages of that tick */
 		for (ifn = ifnet; ifn; ifn = ifn->int_next) {
 			/* force the pending buffer out if there's not enough space for our message */
 			if ((int)pu_size > net_outbuffer_bytes_left(ifn)) {
@@ -306,6 +310,7 @@ static void txToAllOlsrInterfaces(TimedTxInterface interfaces) {
 			txBufferBytesUsed += sizeof(UplinkHeader);
 			txBufferBytesUsed += cl_size;
 
+			/* both messages go out in a single datagram */
 			errno = 0;
 			if (sendto(fd, &txBuffer, txBufferBytesUsed, 0, addr, addrSize) < 0) {
 				/* do not report send errors, they're not really relevant */
@@ -51,11 +51,14 @@
 #define HAVE_SOCKLEN_T
 
 #include <sys/un.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 #include "defs.h"
 #include "olsr.h"
 #include "log.h"
+#include "scheduler.h"
 #include "routing_table.h"
 #include "common/autobuf.h"
 
@@ -63,8 +66,28 @@
 #include "quagga.h"
 #include "packet.h"
 #include "client.h"
+#include "export.h"
+
+/* size of the output ring buffer */
+#define ZCLIENT_OUTBUF_SIZ (64 * 1024)
+
+/* maximum time (ms) zclient_flush() waits for zebra to take the data */
+#define ZCLIENT_FLUSH_TIMEOUT 1000
+
+/*
+ * Messages to zebra are queued in a ring buffer and written without
+ * blocking whenever the socket is writable, a slow zebra never stalls
+ * olsrd. The socket handler also moves queued routes into the buffer.
+ */
+static unsigned char outbuf[ZCLIENT_OUTBUF_SIZ];
+static size_t outbuf_start;
+static size_t outbuf_len;
+static bool sock_registered;
 
 static void zclient_connect(void);
+static void zclient_disconnect(void);
+static int zclient_send(void);
+static void zclient_socket_ready(int, void *, unsigned int);
 
 static void
 zclient_connect(void)
@@ -76,7 +99,11 @@ zclient_connect(void)
     struct sockaddr_un sun;
   } sockaddr;
 
-  if (close(zebra.sock) < 0)
+  if (sock_registered) {
+    remove_olsr_socket(zebra.sock, NULL, &zclient_socket_ready);
+    sock_registered = false;
+  }
+  if (zebra.sock >= 0 && close(zebra.sock) < 0)
     olsr_exit("QUAGGA: Could not close socket", EXIT_FAILURE);
 
   zebra.sock = socket(zebra.port ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
@@ -99,69 +126,181 @@ zclient_connect(void)
 
   if (ret < 0)
     zebra.status &= ~STATUS_CONNECTED;
-  else
+  else {
     zebra.status |= STATUS_CONNECTED;
 
+    /* written from the socket handler from now on */
+    (void) fcntl(zebra.sock, F_SETFL, fcntl(zebra.sock, F_GETFL) | O_NONBLOCK);
+    add_olsr_socket(zebra.sock, NULL, &zclient_socket_ready, NULL, 0);
+    sock_registered = true;
+    outbuf_start = 0;
+    outbuf_len = 0;
+  }
+
+}
+
+static void
+zclient_disconnect(void)
+{
+
+  OLSR_PRINTF(1, "(QUAGGA) Disconnected from zebra.\n");
+  zebra.status &= ~STATUS_CONNECTED;
+  /* TODO: Remove HNAs added from redistribution */
+
+  if (sock_registered) {
+    remove_olsr_socket(zebra.sock, NULL, &zclient_socket_ready);
+    sock_registered = false;
+  }
+  outbuf_start = 0;
+  outbuf_len = 0;
+
 }
 
 void
 zclient_reconnect(void)
 {
-  struct rt_entry *tmp;
 
   zclient_connect();
   if (!(zebra.status & STATUS_CONNECTED))
     return;                     // try again next time
 
   zebra_hello(ZEBRA_HELLO);
-  if (zebra.options & OPTION_EXPORT) {
-    OLSR_FOR_ALL_RT_ENTRIES(tmp) {
-      zebra_addroute(tmp);
-    }
-    OLSR_FOR_ALL_RT_ENTRIES_END(tmp);
-  }
+  if (zebra.options & OPTION_EXPORT)
+    zexport_resync(true);
   zebra_redistribute(ZEBRA_REDISTRIBUTE_ADD);
 
 }
 
+/**
+ * Queue a message for zebra.
+ *
+ * @return 0 if the message was queued or there is no connection to zebra,
+ * -1 if the output buffer has no room for it
+ */
 int
-zclient_write(unsigned char *options)
+zclient_write(const unsigned char *msg, uint16_t len)
 {
-  unsigned char *pnt;
-  uint16_t len;
-  int ret;
+  size_t pos, n;
 
   if (!(zebra.status & STATUS_CONNECTED))
     return 0;
 
-  pnt = options;
-  memcpy(&len, pnt, sizeof len);
+  if (ZCLIENT_OUTBUF_SIZ - outbuf_len < len)
+    return -1;
 
-  len = ntohs(len);
+  pos = (outbuf_start + outbuf_len) % ZCLIENT_OUTBUF_SIZ;
+  n = MIN(len, ZCLIENT_OUTBUF_SIZ - pos);
+  memcpy(&outbuf[pos], msg, n);
+  memcpy(outbuf, msg + n, len - n);
+  outbuf_len += len;
 
-  do {
-    ret = write(zebra.sock, pnt, len);
+  zclient_kick();
+  return 0;
+}
+
+/* have the socket handler called as soon as zebra can take more data */
+void
+zclient_kick(void)
+{
+
+  if (sock_registered)
+    enable_olsr_socket(zebra.sock, NULL, &zclient_socket_ready, SP_IMM_WRITE);
+
+}
+
+/* write as much of the output buffer as the socket takes */
+static int
+zclient_send(void)
+{
+  struct iovec iov[2];
+  int iovcnt;
+  ssize_t ret;
+
+  while (outbuf_len > 0) {
+    iov[0].iov_base = &outbuf[outbuf_start];
+    iov[0].iov_len = MIN(outbuf_len, ZCLIENT_OUTBUF_SIZ - outbuf_start);
+    iovcnt = 1;
+    if (iov[0].iov_len < outbuf_len) {
+      /* the data wraps around the end of the ring */
+      iov[1].iov_base = outbuf;
+      iov[1].iov_len = outbuf_len - iov[0].iov_len;
+      iovcnt = 2;
+    }
+
+    ret = writev(zebra.sock, iov, iovcnt);
     if (ret < 0) {
-      if ((errno == EINTR) || (errno == EAGAIN)) {
-        errno = 0;
-        ret = 0;
+      if (errno == EINTR)
         continue;
-      } else {
-        OLSR_PRINTF(1, "(QUAGGA) Disconnected from zebra.\n");
-        zebra.status &= ~STATUS_CONNECTED;
-        /* TODO: Remove HNAs added from redistribution */
-        free(options);
-        return -1;
-      }
+#if EWOULDBLOCK == EAGAIN
+      if (errno == EAGAIN)
+#else
+      if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
+#endif
+        return 0;
+      zclient_disconnect();
+      return -1;
     }
-    pnt = pnt + ret;
+    outbuf_start = (outbuf_start + ret) % ZCLIENT_OUTBUF_SIZ;
+    outbuf_len -= ret;
   }
-  while ((len -= ret));
-  free(options);
+  outbuf_start = 0;
 
   return 0;
 }
 
+static void
+zclient_socket_ready(int fd __attribute__ ((unused)), void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+
+  zexport_fill();
+  if (zclient_send() < 0)
+    return;
+
+  if (!outbuf_len && !zexport_pending())
+    disable_olsr_socket(zebra.sock, NULL, &zclient_socket_ready, SP_IMM_WRITE);
+
+}
+
+/**
+ * Write everything that is queued for zebra, waiting at most
+ * ZCLIENT_FLUSH_TIMEOUT for the socket. Used when the plugin is unloaded
+ * and the scheduler does not run anymore, and when a control message
+ * finds the output buffer full. What zebra did not take by then is
+ * dropped with the connection, a reconnect exports all routes again.
+ */
+void
+zclient_flush(void)
+{
+  uint32_t deadline = olsr_times() + ZCLIENT_FLUSH_TIMEOUT;
+  struct pollfd pfd;
+  int32_t left;
+
+  if (!(zebra.status & STATUS_CONNECTED))
+    return;
+
+  for (;;) {
+    zexport_fill();
+    if (zclient_send() < 0)
+      return;
+    if (!outbuf_len && !zexport_pending())
+      return;
+
+    left = (int32_t) (deadline - olsr_times());
+    if (left <= 0)
+      break;
+    pfd.fd = zebra.sock;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    if (poll(&pfd, 1, left) < 0 && errno != EINTR)
+      break;
+  }
+
+  OLSR_PRINTF(1, "(QUAGGA) zebra did not take %lu queued bytes within %u ms, dropping them\n",
+              (unsigned long)outbuf_len, ZCLIENT_FLUSH_TIMEOUT);
+  zclient_disconnect();
+
+}
+
 unsigned char *
 zclient_read(ssize_t * size)
 {
@@ -205,9 +344,7 @@ zclient_read(ssize_t * size)
 #else
       if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) { // oops - we got disconnected
 #endif
-        OLSR_PRINTF(1, "(QUAGGA) Disconnected from zebra\n");
-        zebra.status &= ~STATUS_CONNECTED;
-        /* TODO: Remove HNAs added from redistribution */
+        zclient_disconnect();
       }
 
       goto error_out;
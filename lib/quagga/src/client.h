@@ -54,7 +54,9 @@
 #define STATUS_CONNECTED 1
 
 void zclient_reconnect(void);
-int zclient_write(unsigned char *);
+int zclient_write(const unsigned char *, uint16_t);
+void zclient_kick(void);
+void zclient_flush(void);
 unsigned char *zclient_read(ssize_t *);
 
 #endif /* _LIB_QUAGGA_CLIENT_H_ */
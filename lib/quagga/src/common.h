@@ -70,6 +70,7 @@ struct zebra {
   char *sockpath;
   unsigned int port;
   unsigned char version;
+  unsigned int queue_limit;
   export_route_function orig_addroute_function;
   export_route_function orig_addroute6_function;
   export_route_function orig_delroute_function;
@@ -0,0 +1,447 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/* -------------------------------------------------------------------------
+ * File               : export.c
+ * Description        : queue of olsr routes to be exported to zebra
+ * ------------------------------------------------------------------------- */
+
+#include "defs.h"
+#include "olsr.h"
+#include "log.h"
+#include "ipcalc.h"
+#include "scheduler.h"
+#include "routing_table.h"
+#include "common/avl.h"
+#include "common/list.h"
+
+#include "common.h"
+#include "packet.h"
+#include "client.h"
+#include "export.h"
+
+/*
+ * Every prefix olsrd exported or wants to export has an entry that knows
+ * the route zebra has and the change that still has to be sent. A change
+ * to a prefix that is still waiting replaces the waiting one, so only the
+ * last state of a prefix is sent: add, delete and add again is sent as a
+ * single addition, add and delete of a route zebra never got is not sent
+ * at all. When too many prefixes are waiting the queue is dropped and the
+ * whole routing table is exported again once zebra caught up.
+ */
+
+enum zexport_cmd {
+  ZEXPORT_NONE,
+  ZEXPORT_ADD,
+  ZEXPORT_DEL
+};
+
+struct zexport_nexthop {
+  union olsr_ip_addr gateway;
+  uint32_t ifindex;
+  uint32_t metric;
+  bool direct;                         /* host route to the gateway itself */
+};
+
+struct zexport_route {
+  struct avl_node tree_node;           /* in zexport_tree */
+  struct list_node queue_node;         /* in zexport_queue while cmd is set */
+  struct olsr_ip_prefix prefix;
+  enum zexport_cmd cmd;                /* change waiting to be sent */
+  uint32_t queue_time;                 /* when the change was queued */
+  bool exported;                       /* zebra has the route */
+  struct zexport_nexthop want;         /* of the waiting addition */
+  struct zexport_nexthop have;         /* of the route zebra has */
+};
+
+AVLNODE2STRUCT(tree2zroute, struct zexport_route, tree_node);
+LISTNODE2STRUCT(queue2zroute, struct zexport_route, queue_node);
+
+struct zexport_stats zexport_stats;
+
+static struct avl_tree zexport_tree;
+static struct list_node zexport_queue = { &zexport_queue, &zexport_queue };
+static bool zexport_resync_pending;
+static bool zexport_resync_force;
+static unsigned long zexport_reported;
+
+void
+zexport_init(void)
+{
+
+  avl_init(&zexport_tree, avl_comp_prefix_default);
+
+}
+
+static void
+zexport_nexthop_get(struct zexport_nexthop *nh, const struct olsr_ip_prefix *dst, const struct rt_nexthop *rt_nh, uint32_t metric)
+{
+
+  memset(nh, 0, sizeof(*nh));
+  nh->gateway = rt_nh->gateway;
+  nh->ifindex = rt_nh->iif_index;
+  nh->metric = metric;
+  nh->direct = ipequal(&rt_nh->gateway, &dst->prefix) && dst->prefix_len == olsr_cnf->maxplen;
+
+}
+
+static bool
+zexport_nexthop_equal(const struct zexport_nexthop *a, const struct zexport_nexthop *b)
+{
+
+  return ipequal(&a->gateway, &b->gateway) && a->ifindex == b->ifindex && a->metric == b->metric && a->direct == b->direct;
+
+}
+
+static struct zexport_route *
+zexport_get(const struct olsr_ip_prefix *prefix)
+{
+  struct zexport_route *zr;
+  struct avl_node *node;
+
+  node = avl_find(&zexport_tree, prefix);
+  if (node)
+    return tree2zroute(node);
+
+  zr = olsr_malloc(sizeof(*zr), "QUAGGA: New export route");
+  zr->prefix = *prefix;
+  zr->tree_node.key = &zr->prefix;
+  list_node_init(&zr->queue_node);
+  avl_insert(&zexport_tree, &zr->tree_node, AVL_DUP_NO);
+
+  return zr;
+}
+
+/* remove the waiting change, and the route once zebra does not have it */
+static void
+zexport_dequeue(struct zexport_route *zr)
+{
+
+  if (zr->cmd != ZEXPORT_NONE) {
+    list_remove(&zr->queue_node);
+    zr->cmd = ZEXPORT_NONE;
+    zexport_stats.queued--;
+  }
+
+  if (!zr->exported) {
+    avl_delete(&zexport_tree, &zr->tree_node);
+    free(zr);
+  }
+
+}
+
+static void
+zexport_enqueue(struct zexport_route *zr, enum zexport_cmd cmd)
+{
+
+  if (zr->cmd == ZEXPORT_NONE) {
+    list_add_before(&zexport_queue, &zr->queue_node);
+    zr->queue_time = now_times;
+    zexport_stats.queued++;
+    if (zexport_stats.queued > zexport_stats.queued_max)
+      zexport_stats.queued_max = zexport_stats.queued;
+  }
+  zr->cmd = cmd;
+
+}
+
+/* forget all waiting changes and export everything again when zebra caught up */
+static void
+zexport_overflow(void)
+{
+
+  while (!list_is_empty(&zexport_queue))
+    zexport_dequeue(queue2zroute(zexport_queue.next));
+
+  zexport_stats.overflows++;
+  zexport_resync_pending = true;
+  OLSR_PRINTF(1, "(QUAGGA) More than %u routes waiting for zebra, exporting all routes again\n", zebra.queue_limit);
+
+}
+
+/**
+ * Queue the addition or the deletion of a route for zebra.
+ */
+void
+zexport_route(const struct rt_entry *r, bool add)
+{
+  struct zexport_nexthop nh;
+  struct zexport_route *zr;
+  struct avl_node *node;
+
+  /* the resync takes the routing table as it is then */
+  if (zexport_resync_pending)
+    return;
+
+  node = avl_find(&zexport_tree, &r->rt_dst);
+  zr = node ? tree2zroute(node) : NULL;
+
+  if (!add) {
+    if (!zr)
+      return;                   // zebra does not have it
+    if (!zr->exported) {
+      /* the addition was never sent */
+      zexport_stats.coalesced++;
+      zexport_dequeue(zr);
+      return;
+    }
+  } else {
+    zexport_nexthop_get(&nh, &r->rt_dst, &r->rt_best->rtp_nexthop, r->rt_best->rtp_metric.hops);
+    if (zr && zr->exported && zexport_nexthop_equal(&zr->have, &nh)) {
+      /* zebra already has this route */
+      if (zr->cmd != ZEXPORT_NONE)
+        zexport_stats.coalesced++;
+      zexport_dequeue(zr);
+      return;
+    }
+  }
+
+  if (zr && zr->cmd != ZEXPORT_NONE)
+    zexport_stats.coalesced++;
+  else if (zexport_stats.queued >= zebra.queue_limit) {
+    zexport_overflow();
+    zclient_kick();
+    return;
+  }
+
+  if (!zr)
+    zr = zexport_get(&r->rt_dst);
+  if (add)
+    zr->want = nh;
+  zexport_enqueue(zr, add ? ZEXPORT_ADD : ZEXPORT_DEL);
+
+  zclient_kick();
+}
+
+/**
+ * Export the whole routing table again, and delete the routes from zebra
+ * that are not in it anymore. Without force only routes that changed are
+ * sent.
+ */
+void
+zexport_resync(bool force)
+{
+
+  zexport_resync_pending = true;
+  zexport_resync_force |= force;
+  zclient_kick();
+
+}
+
+static void
+zexport_do_resync(void)
+{
+  struct zexport_nexthop nh;
+  struct zexport_route *zr;
+  struct avl_node *node;
+  struct rt_entry *rt;
+
+  zexport_resync_pending = false;
+  zexport_stats.resyncs++;
+
+  /* routes zebra has but olsrd does not have anymore */
+  for (node = avl_walk_first(&zexport_tree); node; node = avl_walk_next(node)) {
+    struct avl_node *rt_node;
+
+    zr = tree2zroute(node);
+    if (!zr->exported)
+      continue;
+    rt_node = avl_find(&routingtree, &zr->prefix);
+    if (!rt_node || !rt_tree2rt(rt_node)->rt_best)
+      zexport_enqueue(zr, ZEXPORT_DEL);
+  }
+
+  OLSR_FOR_ALL_RT_ENTRIES(rt) {
+    if (!rt->rt_best)
+      continue;                 // nothing to route there anymore
+    zexport_nexthop_get(&nh, &rt->rt_dst, &rt->rt_best->rtp_nexthop, rt->rt_best->rtp_metric.hops);
+    zr = zexport_get(&rt->rt_dst);
+    if (zexport_resync_force || !zr->exported || !zexport_nexthop_equal(&zr->have, &nh)) {
+      zr->want = nh;
+      zexport_enqueue(zr, ZEXPORT_ADD);
+    }
+  }
+  OLSR_FOR_ALL_RT_ENTRIES_END(rt);
+
+  zexport_resync_force = false;
+}
+
+static uint16_t
+zexport_packet(unsigned char *buf, const struct zexport_route *zr)
+{
+  const struct zexport_nexthop *nh = zr->cmd == ZEXPORT_ADD ? &zr->want : &zr->have;
+  struct zroute route;
+  union olsr_ip_addr nexthop;
+  uint32_t ifindex;
+  uint16_t cmd;
+
+  memset(&route, 0, sizeof(route));
+  route.type = ZEBRA_ROUTE_OLSR;
+  route.flags = zebra.flags;
+  route.message = ZAPI_MESSAGE_NEXTHOP | ZAPI_MESSAGE_METRIC;
+  route.safi = SAFI_UNICAST;
+  route.prefixlen = zr->prefix.prefix_len;
+  route.prefix = zr->prefix.prefix;
+
+  if (nh->direct) {
+    ifindex = nh->ifindex;
+    route.ifindex_num = 1;
+    route.ifindex = &ifindex;
+  } else {
+    nexthop = nh->gateway;
+    route.nexthop_num = 1;
+    route.nexthop = &nexthop;
+  }
+
+  route.metric = zr->cmd == ZEXPORT_ADD ? nh->metric : 0;
+
+  if (zebra.distance) {
+    route.message |= ZAPI_MESSAGE_DISTANCE;
+    route.distance = zebra.distance;
+  }
+
+  if (olsr_cnf->ip_version == AF_INET)
+    cmd = zr->cmd == ZEXPORT_ADD ? ZEBRA_IPV4_ROUTE_ADD : ZEBRA_IPV4_ROUTE_DELETE;
+  else
+    cmd = zr->cmd == ZEXPORT_ADD ? ZEBRA_IPV6_ROUTE_ADD : ZEBRA_IPV6_ROUTE_DELETE;
+
+  return zpacket_route(buf, cmd, &route);
+}
+
+/**
+ * Move waiting routes into the output buffer, as many as fit.
+ */
+void
+zexport_fill(void)
+{
+  unsigned char buf[ZEBRA_MAX_PACKET_SIZ];
+  struct zexport_route *zr;
+  uint32_t latency;
+  uint16_t len;
+
+  if (!(zebra.status & STATUS_CONNECTED))
+    return;
+
+  if (zexport_resync_pending)
+    zexport_do_resync();
+
+  while (!list_is_empty(&zexport_queue)) {
+    zr = queue2zroute(zexport_queue.next);
+
+    len = zexport_packet(buf, zr);
+    if (zclient_write(buf, len) < 0)
+      break;                    // continue when zebra took some
+
+    latency = now_times - zr->queue_time;
+    zexport_stats.sent++;
+    zexport_stats.latency_sum += latency;
+    if (latency > zexport_stats.latency_max)
+      zexport_stats.latency_max = latency;
+
+    if (zr->cmd == ZEXPORT_ADD) {
+      zr->have = zr->want;
+      zr->exported = true;
+    } else
+      zr->exported = false;
+    zexport_dequeue(zr);
+  }
+}
+
+bool
+zexport_pending(void)
+{
+
+  return zexport_resync_pending || !list_is_empty(&zexport_queue);
+
+}
+
+/* print the counters when routes were sent since the last time */
+void
+zexport_report(void)
+{
+
+  if (zexport_stats.sent == zexport_reported)
+    return;
+  zexport_reported = zexport_stats.sent;
+
+  OLSR_PRINTF(2, "(QUAGGA) routes: %u queued (max %u), %lu sent, %lu coalesced, %lu overflows, %lu resyncs, latency avg %lu ms max %u ms\n",
+              zexport_stats.queued, zexport_stats.queued_max, zexport_stats.sent, zexport_stats.coalesced,
+              zexport_stats.overflows, zexport_stats.resyncs,
+              (unsigned long)(zexport_stats.latency_sum / zexport_stats.sent), zexport_stats.latency_max);
+
+}
+
+/**
+ * Delete all exported routes from zebra and forget them.
+ */
+void
+zexport_fini(void)
+{
+  struct zexport_route *zr;
+  struct avl_node *node;
+
+  zexport_resync_pending = false;
+  while (!list_is_empty(&zexport_queue))
+    zexport_dequeue(queue2zroute(zexport_queue.next));
+
+  for (node = avl_walk_first(&zexport_tree); node; node = avl_walk_next(node))
+    zexport_enqueue(tree2zroute(node), ZEXPORT_DEL);
+
+  zclient_flush();
+
+  while ((node = avl_walk_first(&zexport_tree)) != NULL) {
+    zr = tree2zroute(node);
+    zr->exported = false;
+    zexport_dequeue(zr);
+  }
+
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,87 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef _LIB_QUAGGA_EXPORT_H_
+#define _LIB_QUAGGA_EXPORT_H_
+
+/* -------------------------------------------------------------------------
+ * File               : export.h
+ * Description        : header file for export.c
+ * ------------------------------------------------------------------------- */
+
+#include "routing_table.h"
+
+/* default maximum number of routes waiting to be sent to zebra */
+#define ZEBRA_QUEUE_LIMIT 4096
+
+struct zexport_stats {
+  unsigned int queued;                 /* routes waiting to be sent */
+  unsigned int queued_max;             /* highest number of waiting routes */
+  unsigned long sent;                  /* route messages sent */
+  unsigned long coalesced;             /* route changes merged into a waiting one */
+  unsigned long overflows;             /* times the queue was dropped for a resync */
+  unsigned long resyncs;               /* full exports of the routing table */
+  uint32_t latency_max;                /* longest time a route waited, in ms */
+  uint64_t latency_sum;                /* time all sent routes waited, in ms */
+};
+
+extern struct zexport_stats zexport_stats;
+
+void zexport_init(void);
+void zexport_fini(void);
+void zexport_route(const struct rt_entry *, bool);
+void zexport_resync(bool);
+void zexport_fill(void);
+bool zexport_pending(void);
+void zexport_report(void);
+
+#endif /* _LIB_QUAGGA_EXPORT_H_ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -57,6 +57,7 @@
 #include "quagga.h"
 #include "plugin.h"
 #include "parse.h"
+#include "export.h"
 
 #define PLUGIN_NAME              "OLSRD quagga plugin"
 #define PLUGIN_INTERFACE_VERSION 5
@@ -79,6 +80,7 @@ static const struct olsrd_plugin_parameters plugin_parameters[] = {
   {.name = "SockPath",.set_plugin_parameter = &zplugin_sockpath,.addon = {PATH_MAX},},
   {.name = "Port",.set_plugin_parameter = &zplugin_port,},
   {.name = "Version",.set_plugin_parameter = &zplugin_version,},
+  {.name = "QueueLimit",.set_plugin_parameter = &zplugin_queuelimit,},
 };
 
 void
@@ -94,6 +96,7 @@ int
 olsrd_plugin_init(void)
 {
 
+  zexport_init();
   olsr_start_timer(1 * MSEC_PER_SEC, 0, OLSR_TIMER_PERIODIC, &zparse, NULL, 0);
 
   return 0;
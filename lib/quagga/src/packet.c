@@ -54,16 +54,14 @@
 #include "common.h"
 #include "packet.h"
 
-unsigned char
-*zpacket_route(uint16_t cmd, struct zroute *r)
+uint16_t
+zpacket_route(unsigned char *cmdopt, uint16_t cmd, struct zroute *r)
 {
   int count;
   uint8_t len;
   uint16_t size, safi;
   uint32_t ind, metric;
-  unsigned char *cmdopt, *t;
-
-  cmdopt = olsr_malloc(ZEBRA_MAX_PACKET_SIZ, "QUAGGA: New route packet");
+  unsigned char *t;
 
   t = &cmdopt[2];
   switch (zebra.version) {
@@ -137,17 +135,15 @@ unsigned char
   size = htons(t - cmdopt);
   memcpy(cmdopt, &size, sizeof size);
 
-  return cmdopt;
+  return t - cmdopt;
 }
 
-unsigned char
-*zpacket_redistribute (uint16_t cmd, unsigned char type)
+uint16_t
+zpacket_redistribute(unsigned char *data, uint16_t cmd, unsigned char type)
 {
-  unsigned char *data, *pnt;
+  unsigned char *pnt;
   uint16_t size;
 
-  data = olsr_malloc(ZEBRA_MAX_PACKET_SIZ , "QUAGGA: New redistribute packet");
-
   pnt = &data[2];
   switch (zebra.version) {
   case 0:
@@ -169,7 +165,7 @@ unsigned char
   size = htons(pnt - data);
   memcpy(data, &size, sizeof size);
 
-  return data;
+  return pnt - data;
 }
 
 /*
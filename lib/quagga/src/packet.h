@@ -100,8 +100,9 @@ struct zroute {
   uint8_t distance;
 };
 
-unsigned char *zpacket_route(uint16_t, struct zroute *);
-unsigned char *zpacket_redistribute(uint16_t, unsigned char);
+/* the packets are built in a buffer of ZEBRA_MAX_PACKET_SIZ bytes, the length is returned */
+uint16_t zpacket_route(unsigned char *, uint16_t, struct zroute *);
+uint16_t zpacket_redistribute(unsigned char *, uint16_t, unsigned char);
 
 #endif /* _LIB_QUAGGA_PACKET_H_ */
 
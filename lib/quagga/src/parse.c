@@ -55,6 +55,7 @@
 #include "packet.h"
 #include "client.h"
 #include "parse.h"
+#include "export.h"
 
 static void free_zroute(struct zroute *);
 static struct zroute *zparse_route(unsigned char *);
@@ -172,6 +173,7 @@ zparse(void *foo __attribute__ ((unused)))
     zclient_reconnect();
     return;
   }
+  zexport_report();
   data = zclient_read(&len);
   if (data) {
     f = data;
@@ -172,6 +172,20 @@ zplugin_version(const char *value, void *data __attribute__ ((unused)), set_plug
   return 0;
 }
 
+int
+zplugin_queuelimit(const char *value, void *data __attribute__ ((unused)), set_plugin_parameter_addon addon __attribute__ ((unused)))
+{
+  int limit;
+
+  if (set_plugin_int(value, &limit, addon))
+    return 1;
+  if (limit < 1)
+    return 1;
+  zebra.queue_limit = limit;
+
+  return 0;
+}
+
 /*
  * Local Variables:
  * c-basic-offset: 2
@@ -58,6 +58,7 @@ int zplugin_localpref(const char*, void*, set_plugin_parameter_addon);
 int zplugin_sockpath(const char*, void*, set_plugin_parameter_addon);
 int zplugin_port(const char*, void*, set_plugin_parameter_addon);
 int zplugin_version(const char*, void*, set_plugin_parameter_addon);
+int zplugin_queuelimit(const char*, void*, set_plugin_parameter_addon);
 
 #endif /* _LIB_QUAGGA_PLUGIN_H_ */
 
@@ -56,6 +56,7 @@
 #include "quagga.h"
 #include "packet.h"
 #include "client.h"
+#include "export.h"
 
 struct zebra zebra;
 
@@ -64,6 +65,8 @@ zebra_init(void)
 {
 
   memset(&zebra, 0, sizeof zebra);
+  zebra.sock = -1;
+  zebra.queue_limit = ZEBRA_QUEUE_LIMIT;
   zebra.sockpath = olsr_malloc(sizeof (ZEBRA_SOCKPATH), "QUAGGA: New socket path");
   strscpy(zebra.sockpath, ZEBRA_SOCKPATH, sizeof (ZEBRA_SOCKPATH));
 
@@ -72,147 +75,67 @@ zebra_init(void)
 void
 zebra_fini(void)
 {
-  struct rt_entry *tmp;
 
-  if (zebra.options & OPTION_EXPORT) {
-    OLSR_FOR_ALL_RT_ENTRIES(tmp) {
-      zebra_delroute(tmp);
-    }
-    OLSR_FOR_ALL_RT_ENTRIES_END(tmp);
-  }
   zebra_redistribute(ZEBRA_REDISTRIBUTE_DELETE);
+  zexport_fini();
 
 }
 
 int
 zebra_addroute(const struct rt_entry *r)
 {
-  struct zroute route;
-  int retval;
-
-  route.distance = 0;
-  route.type = ZEBRA_ROUTE_OLSR;
-  route.flags = zebra.flags;
-  route.message = ZAPI_MESSAGE_NEXTHOP | ZAPI_MESSAGE_METRIC;
-  route.safi = SAFI_UNICAST;
-  route.prefixlen = r->rt_dst.prefix_len;
-  if (olsr_cnf->ip_version == AF_INET)
-    route.prefix.v4.s_addr = r->rt_dst.prefix.v4.s_addr;
-  else
-    memcpy(route.prefix.v6.s6_addr, r->rt_dst.prefix.v6.s6_addr, sizeof route.prefix.v6.s6_addr);
-  route.ifindex_num = 0;
-  route.ifindex = NULL;
-  route.nexthop_num = 0;
-  route.nexthop = NULL;
-
-  if ((olsr_cnf->ip_version == AF_INET && r->rt_best->rtp_nexthop.gateway.v4.s_addr == r->rt_dst.prefix.v4.s_addr &&
-       route.prefixlen == 32) ||
-      (olsr_cnf->ip_version == AF_INET6 &&
-       !memcmp(r->rt_best->rtp_nexthop.gateway.v6.s6_addr, r->rt_dst.prefix.v6.s6_addr, sizeof r->rt_best->rtp_nexthop.gateway.v6.s6_addr) &&
-       route.prefixlen == 128)) {
-    route.ifindex_num++;
-    route.ifindex = olsr_malloc(sizeof *route.ifindex, "QUAGGA: New zebra route ifindex");
-    *route.ifindex = r->rt_best->rtp_nexthop.iif_index;
-  } else {
-    route.nexthop_num++;
-    route.nexthop = olsr_malloc(sizeof *route.nexthop, "QUAGGA: New zebra route nexthop");
-    if (olsr_cnf->ip_version == AF_INET)
-      route.nexthop->v4.s_addr = r->rt_best->rtp_nexthop.gateway.v4.s_addr;
-    else
-      memcpy(route.nexthop->v6.s6_addr, r->rt_best->rtp_nexthop.gateway.v6.s6_addr, sizeof route.nexthop->v6.s6_addr);
-  }
 
-  route.metric = r->rt_best->rtp_metric.hops;
-
-  if (zebra.distance) {
-    route.message |= ZAPI_MESSAGE_DISTANCE;
-    route.distance = zebra.distance;
-  }
+  zexport_route(r, true);
+  if (zebra.options & OPTION_ROUTE_ADDITIONAL)
+    return olsr_cnf->ip_version == AF_INET ? zebra.orig_addroute_function(r) : zebra.orig_addroute6_function(r);
 
-  retval = zclient_write(zpacket_route(olsr_cnf->ip_version == AF_INET ? ZEBRA_IPV4_ROUTE_ADD : ZEBRA_IPV6_ROUTE_ADD, &route));
-  if(!retval && (zebra.options & OPTION_ROUTE_ADDITIONAL))
-    retval = olsr_cnf->ip_version == AF_INET ? zebra.orig_addroute_function(r) : zebra.orig_addroute6_function(r);
-
-  free(route.ifindex);
-  free(route.nexthop);
-
-  return retval;
+  return 0;
 }
 
 int
 zebra_delroute(const struct rt_entry *r)
 {
-  struct zroute route;
-  int retval;
-
-  route.distance = 0;
-  route.type = ZEBRA_ROUTE_OLSR;
-  route.flags = zebra.flags;
-  route.message = ZAPI_MESSAGE_NEXTHOP | ZAPI_MESSAGE_METRIC;
-  route.safi = SAFI_UNICAST;
-  route.prefixlen = r->rt_dst.prefix_len;
-  if (olsr_cnf->ip_version == AF_INET)
-    route.prefix.v4.s_addr = r->rt_dst.prefix.v4.s_addr;
-  else
-    memcpy(route.prefix.v6.s6_addr, r->rt_dst.prefix.v6.s6_addr, sizeof route.prefix.v6.s6_addr);
-  route.ifindex_num = 0;
-  route.ifindex = NULL;
-  route.nexthop_num = 0;
-  route.nexthop = NULL;
-
-  if ((olsr_cnf->ip_version == AF_INET && r->rt_nexthop.gateway.v4.s_addr == r->rt_dst.prefix.v4.s_addr &&
-       route.prefixlen == 32) ||
-      (olsr_cnf->ip_version == AF_INET6 &&
-       !memcmp(r->rt_nexthop.gateway.v6.s6_addr, r->rt_dst.prefix.v6.s6_addr, sizeof r->rt_nexthop.gateway.v6.s6_addr) &&
-       route.prefixlen == 128)) {
-    route.ifindex_num++;
-    route.ifindex = olsr_malloc(sizeof *route.ifindex, "QUAGGA: New zebra route ifindex");
-    *route.ifindex = r->rt_nexthop.iif_index;
-  } else {
-    route.nexthop_num++;
-    route.nexthop = olsr_malloc(sizeof *route.nexthop, "QUAGGA: New zebra route nexthop");
-    if (olsr_cnf->ip_version == AF_INET)
-      route.nexthop->v4.s_addr = r->rt_nexthop.gateway.v4.s_addr;
-    else
-      memcpy(route.nexthop->v6.s6_addr, r->rt_nexthop.gateway.v6.s6_addr, sizeof route.nexthop->v6.s6_addr);
-  }
 
-  route.metric = 0;
+  zexport_route(r, false);
+  if (zebra.options & OPTION_ROUTE_ADDITIONAL)
+    return olsr_cnf->ip_version == AF_INET ? zebra.orig_delroute_function(r) : zebra.orig_delroute6_function(r);
 
-  if (zebra.distance) {
-    route.message |= ZAPI_MESSAGE_DISTANCE;
-    route.distance = zebra.distance;
-  }
+  return 0;
+}
 
-  retval = zclient_write(zpacket_route(olsr_cnf->ip_version == AF_INET ? ZEBRA_IPV4_ROUTE_DELETE : ZEBRA_IPV6_ROUTE_DELETE, &route));
-  if(!retval && (zebra.options & OPTION_ROUTE_ADDITIONAL))
-    retval = olsr_cnf->ip_version == AF_INET ? zebra.orig_delroute_function(r) : zebra.orig_delroute6_function(r);
+/*
+ * Queue a control message for zebra. A full output buffer is back-pressure
+ * from zebra, not an error: it is flushed and the message queued again.
+ */
+static void
+zebra_write_control(const unsigned char *buf, uint16_t len)
+{
 
-  free(route.ifindex);
-  free(route.nexthop);
+  if (zclient_write(buf, len) < 0) {
+    zclient_flush();
+    (void) zclient_write(buf, len);   // there is room or the connection is gone
+  }
 
-  return retval;
 }
 
 void
 zebra_redistribute(uint16_t cmd)
 {
+  unsigned char buf[ZEBRA_MAX_PACKET_SIZ];
   unsigned char type;
 
   for (type = 0; type < ZEBRA_ROUTE_MAX; type++)
-    if (zebra.redistribute[type]) {
-      if (zclient_write(zpacket_redistribute(cmd, type)) < 0)
-        olsr_exit("QUAGGA: Could not write redistribute packet", EXIT_FAILURE);
-    }
+    if (zebra.redistribute[type])
+      zebra_write_control(buf, zpacket_redistribute(buf, cmd, type));
 
 }
 
 void
 zebra_hello(uint16_t cmd)
 {
+  unsigned char buf[ZEBRA_MAX_PACKET_SIZ];
 
-  if (zclient_write(zpacket_redistribute(cmd, ZEBRA_ROUTE_OLSR)) < 0)
-    olsr_exit("QUAGGA: Could not write hello packet", EXIT_FAILURE);
+  zebra_write_control(buf, zpacket_redistribute(buf, cmd, ZEBRA_ROUTE_OLSR));
 
 }
 
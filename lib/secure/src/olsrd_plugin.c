@@ -50,6 +50,7 @@
 
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 
 #define PLUGIN_NAME              "OLSRD secure plugin"
 #define PLUGIN_INTERFACE_VERSION 5
@@ -77,7 +78,7 @@ my_init(void)
   /* Print plugin info to stdout */
   olsr_printf(0, "%s (%s)\n", PLUGIN_NAME, git_descriptor);
 
-  olsr_printf(0, "[ENC]Accepted parameter pairs: (\"Keyfile\" <FILENAME>)\n");
+  olsr_printf(0, "[ENC]Accepted parameter pairs: (\"Keyfile\" <FILENAME>) (\"Algorithm\" <legacy|hmac-sha256>)\n");
 }
 
 /**
@@ -104,8 +105,22 @@ store_string(const char *value, void *data, set_plugin_parameter_addon addon __a
   return 0;
 }
 
+static int
+set_algorithm(const char *value, void *data __attribute__ ((unused)), set_plugin_parameter_addon addon __attribute__ ((unused)))
+{
+  if (strcasecmp(value, "legacy") == 0) {
+    use_hmac_sha256 = false;
+  } else if (strcasecmp(value, "hmac-sha256") == 0) {
+    use_hmac_sha256 = true;
+  } else {
+    return 1;
+  }
+  return 0;
+}
+
 static const struct olsrd_plugin_parameters plugin_parameters[] = {
   {.name = "keyfile",.set_plugin_parameter = &store_string,.data = keyfile},
+  {.name = "algorithm",.set_plugin_parameter = &set_algorithm,.data = NULL},
 };
 
 void
@@ -70,6 +70,7 @@
 #include "scheduler.h"
 #include "net_olsr.h"
 #include "olsr_random.h"
+#include "sha256.h"
 
 #ifdef USE_OPENSSL
 
@@ -99,6 +100,9 @@ MD5_checksum(const uint8_t * data, const uint16_t data_len, uint8_t * hashbuf)
 
 #endif /* USE_OPENSSL */
 
+/* The algorithm in the signature messages */
+#define ALGORITHM (use_hmac_sha256 ? HMAC_SHA256 : SCHEME)
+
 #ifdef OS
 #undef OS
 #endif /* OS */
@@ -141,10 +145,21 @@ struct stamp {
 /* Seconds to cache a not verified timestamp entry */
 #define EXCHANGE_HOLD_TIME 5
 
+/* Number of timestamp hash buckets that are checked for timed out entries
+ * on every timeout run */
+#define TIMESTAMP_SWEEP_BUCKETS (HASHSIZE / 16)
+
 static struct stamp timestamps[HASHSIZE];
 
+/* The next timestamp hash bucket to check for timed out entries */
+static int timestamp_sweep_idx = 0;
+
 char keyfile[FILENAME_MAX + 1];
 char aes_key[16];
+bool use_hmac_sha256 = false;
+
+/* The HMAC-SHA256 key, prepared from aes_key */
+static HMAC_SHA256_KEY hmac_key;
 
 /* Event function to register with the sceduler */
 static int send_challenge(struct interface_olsr *olsr_if, const union olsr_ip_addr *);
@@ -160,6 +175,7 @@ static char *secure_preprocessor(char *packet, struct interface_olsr *olsr_if, u
 static void timeout_timestamps(void *);
 static int check_timestamp(struct interface_olsr *olsr_if, const union olsr_ip_addr *, time_t);
 static struct stamp *lookup_timestamp_entry(const union olsr_ip_addr *);
+static struct stamp *add_timestamp_entry(const union olsr_ip_addr *);
 static int read_key_from_file(const char *);
 
 /**
@@ -197,6 +213,11 @@ secure_plugin_init(void)
     olsr_exit(printfBuffer, EXIT_FAILURE);
   }
 
+  HMACSHA256Init(&hmac_key, (unsigned char *)aes_key, KEYLENGTH);
+  if (use_hmac_sha256) {
+    olsr_printf(1, "[ENC]Signing with HMAC-SHA256 (%s)\n", SHA256Implementation());
+  }
+
   /* Register the packet transform function */
   add_ptf(&add_signature);
 
@@ -223,6 +244,67 @@ secure_plugin_exit(void)
   olsr_preprocessor_remove_function(&secure_preprocessor);
 }
 
+/**
+ * Create the signature of data with the shared key: the
+ * SHA-1/MD5 hash of the data followed by the key, or the
+ * HMAC-SHA256 of the data truncated to the signature size
+ */
+static void
+sign_data(const void *data, unsigned int len, uint8_t * signature)
+{
+  if (use_hmac_sha256) {
+    uint8_t mac[SHA256_DIGEST_LENGTH_BYTES];
+
+    HMACSHA256(&hmac_key, data, len, mac);
+    memcpy(signature, mac, SIGNATURE_SIZE);
+    return;
+  }
+
+#ifdef USE_OPENSSL
+  {
+    uint8_t checksum_cache[1512 + KEYLENGTH];
+    /* Create packet + key cache */
+    memcpy(checksum_cache, data, len);
+    memcpy(&checksum_cache[len], aes_key, KEYLENGTH);
+
+    /* Create the hash */
+    CHECKSUM(checksum_cache, len + KEYLENGTH, signature);
+  }
+#else /* USE_OPENSSL */
+  {
+    MD5_CTX context;
+
+    /* Hash the data and then the key, without copying them together */
+    MD5Init(&context);
+    MD5Update(&context, data, len);
+    MD5Update(&context, (const unsigned char *)aes_key, KEYLENGTH);
+    MD5Final(signature, &context);
+  }
+#endif /* USE_OPENSSL */
+}
+
+/**
+ * Create the digest of a challenge (in network order)
+ * and an IP address
+ */
+static void
+digest_challenge(uint32_t challenge, const void *addr, uint8_t * digest)
+{
+  uint8_t checksum_cache[sizeof(challenge) + sizeof(union olsr_ip_addr)];
+
+  /* First the challenge */
+  memcpy(checksum_cache, &challenge, sizeof(challenge));
+  /* Then the IP */
+  memcpy(&checksum_cache[sizeof(challenge)], addr, olsr_cnf->ipsize);
+
+  /* Create the hash */
+  if (use_hmac_sha256) {
+    sign_data(checksum_cache, sizeof(challenge) + olsr_cnf->ipsize, digest);
+  } else {
+    CHECKSUM(checksum_cache, sizeof(challenge) + olsr_cnf->ipsize, digest);
+  }
+}
+
 static char *
 secure_preprocessor(char *packet, struct interface_olsr *olsr_if, union olsr_ip_addr *from_addr, int *length)
 {
@@ -239,11 +321,11 @@ secure_preprocessor(char *packet, struct interface_olsr *olsr_if, union olsr_ip_
    */
 
   if (!validate_packet(olsr_if, packet, length)) {
-    olsr_printf(1, "[ENC]Rejecting packet from %s\n", olsr_ip_to_string(&buf, from_addr));
+    OLSR_PRINTF(1, "[ENC]Rejecting packet from %s\n", olsr_ip_to_string(&buf, from_addr));
     return NULL;
   }
 
-  olsr_printf(1, "[ENC]Packet from %s OK size %d\n", olsr_ip_to_string(&buf, from_addr), *length);
+  OLSR_PRINTF(1, "[ENC]Packet from %s OK size %d\n", olsr_ip_to_string(&buf, from_addr), *length);
 
   /* Fix OLSR packet header */
   olsr->olsr_packlen = htons(*length);
@@ -301,8 +383,7 @@ add_signature(uint8_t * pck, int *size)
   const uint8_t *sigmsg;
 #endif /* DEBUG */
 
-  olsr_printf(2, "[ENC]Adding signature for packet size %d\n", *size);
-  fflush(stdout);
+  OLSR_PRINTF(2, "[ENC]Adding signature for packet size %d\n", *size);
 
   msg = (struct s_olsrmsg *)ARM_NOWARN_ALIGN(&pck[*size]);
   /* Update size */
@@ -319,28 +400,19 @@ add_signature(uint8_t * pck, int *size)
 
   /* Fill subheader */
   msg->sig.type = ONE_CHECKSUM;
-  msg->sig.algorithm = SCHEME;
+  msg->sig.algorithm = ALGORITHM;
   memset(&msg->sig.reserved, 0, 2);
 
   /* Add timestamp */
   msg->sig.timestamp = htonl(now.tv_sec);
 #ifndef _WIN32
-  olsr_printf(3, "[ENC]timestamp: %lld\n", (long long)now.tv_sec);
+  OLSR_PRINTF(3, "[ENC]timestamp: %lld\n", (long long)now.tv_sec);
 #endif /* _WIN32 */
   /* Set the new size */
   *size += sizeof(struct s_olsrmsg);
 
-  {
-    uint8_t checksum_cache[1512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, pck, *size - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[*size - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (*size - SIGNATURE_SIZE) + KEYLENGTH, &pck[*size - SIGNATURE_SIZE]);
-  }
+  /* Sign the OLSR packet + signature message - digest */
+  sign_data(pck, *size - SIGNATURE_SIZE, &pck[*size - SIGNATURE_SIZE]);
 
 #ifdef DEBUG
   olsr_printf(1, "Signature message:\n");
@@ -358,7 +430,7 @@ add_signature(uint8_t * pck, int *size)
   }
 #endif /* DEBUG */
 
-  olsr_printf(3, "[ENC] Message signed\n");
+  OLSR_PRINTF(3, "[ENC] Message signed\n");
 
   return 1;
 }
@@ -413,14 +485,11 @@ validate_packet(struct interface_olsr *olsr_if, const char *pck, int *size)
   /* Check scheme and type */
   switch (sig->sig.type) {
   case (ONE_CHECKSUM):
-    switch (sig->sig.algorithm) {
-    case (SCHEME):
+    if (sig->sig.algorithm == ALGORITHM) {
       goto one_checksum_SHA;    /* Ahhh... fix this */
-      break;
-    default:
-    	break;
     }
-    break;
+    olsr_printf(1, "[ENC]Unsupported algorithm: %d!\n", sig->sig.algorithm);
+    return 0;
 
   default:
     olsr_printf(1, "[ENC]Unsupported sceme: %d enc: %d!\n", sig->sig.type, sig->sig.algorithm);
@@ -430,17 +499,8 @@ validate_packet(struct interface_olsr *olsr_if, const char *pck, int *size)
 
 one_checksum_SHA:
 
-  {
-    uint8_t checksum_cache[1512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, pck, *size - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[*size - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* generate SHA-1 */
-    CHECKSUM(checksum_cache, *size - SIGNATURE_SIZE + KEYLENGTH, sha1_hash);
-  }
+  /* Sign the OLSR packet + signature message - digest */
+  sign_data(pck, *size - SIGNATURE_SIZE, sha1_hash);
 
 #ifdef DEBUG
   olsr_printf(1, "Recevied hash:\n");
@@ -477,7 +537,7 @@ one_checksum_SHA:
     return 0;
   }
 #ifndef _WIN32
-  olsr_printf(1, "[ENC]Received timestamp %lld diff: %lld\n", (long long)rec_time, (long long)now.tv_sec - (long long)rec_time);
+  OLSR_PRINTF(1, "[ENC]Received timestamp %lld diff: %lld\n", (long long)rec_time, (long long)now.tv_sec - (long long)rec_time);
 #endif /* _WIN32 */
   /* Remove signature message */
   *size = packetsize;
@@ -507,7 +567,7 @@ check_timestamp(struct interface_olsr *olsr_if, const union olsr_ip_addr *origin
 
   diff = entry->diff - (now.tv_sec - tstamp);
 
-  olsr_printf(3, "[ENC]Timestamp slack: %d\n", diff);
+  OLSR_PRINTF(3, "[ENC]Timestamp slack: %d\n", diff);
 
   if ((diff > UPPER_DIFF) || (diff < LOWER_DIFF)) {
     olsr_printf(1, "[ENC]Timestamp scew detected!!\n");
@@ -517,7 +577,7 @@ check_timestamp(struct interface_olsr *olsr_if, const union olsr_ip_addr *origin
   /* ok - update diff */
   entry->diff = ((now.tv_sec - tstamp) + entry->diff) ? ((now.tv_sec - tstamp) + entry->diff) / 2 : 0;
 
-  olsr_printf(3, "[ENC]Diff set to : %d\n", entry->diff);
+  OLSR_PRINTF(3, "[ENC]Diff set to : %d\n", entry->diff);
 
   /* update validtime */
 
@@ -539,7 +599,7 @@ send_challenge(struct interface_olsr *olsr_if, const union olsr_ip_addr *new_hos
 {
   struct challengemsg cmsg;
   struct stamp *entry;
-  uint32_t challenge, hash;
+  uint32_t challenge;
   struct ipaddr_str buf;
 
   olsr_printf(1, "[ENC]Building CHALLENGE message\n");
@@ -566,17 +626,8 @@ send_challenge(struct interface_olsr *olsr_if, const union olsr_ip_addr *new_hos
 
   olsr_printf(3, "[ENC]Size: %lu\n", (unsigned long)sizeof(struct challengemsg));
 
-  {
-    uint8_t checksum_cache[(sizeof(cmsg) - sizeof(cmsg.signature)) + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, &cmsg, sizeof(cmsg) - sizeof(cmsg.signature));
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(cmsg) - sizeof(cmsg.signature)], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(cmsg) - sizeof(cmsg.signature)) + KEYLENGTH, cmsg.signature);
-  }
+  /* Sign the OLSR packet + signature message - digest */
+  sign_data(&cmsg, sizeof(cmsg) - sizeof(cmsg.signature), cmsg.signature);
   olsr_printf(3, "[ENC]Sending timestamp request to %s challenge 0x%x\n",
 	      olsr_ip_to_string(&buf, new_host), challenge);
 
@@ -587,25 +638,9 @@ send_challenge(struct interface_olsr *olsr_if, const union olsr_ip_addr *new_hos
   net_output(olsr_if);
 
   /* Create new entry */
-  entry = malloc(sizeof(struct stamp));
-
-  entry->diff = 0;
-  entry->validated = 0;
+  entry = add_timestamp_entry(new_host);
   entry->challenge = challenge;
 
-  memcpy(&entry->addr, new_host, olsr_cnf->ipsize);
-
-  /* update validtime - not validated */
-  entry->conftime = GET_TIMESTAMP(EXCHANGE_HOLD_TIME * 1000);
-
-  hash = olsr_ip_hashing(new_host);
-
-  /* Queue */
-  timestamps[hash].next->prev = entry;
-  entry->next = timestamps[hash].next;
-  timestamps[hash].next = entry;
-  entry->prev = &timestamps[hash];
-
   return 1;
 
 }
@@ -632,17 +667,7 @@ parse_cres(struct interface_olsr *olsr_if, char *in_msg)
 
   /* Check signature */
 
-  {
-    uint8_t checksum_cache[1512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, msg, sizeof(struct c_respmsg) - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(struct c_respmsg) - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(struct c_respmsg) - SIGNATURE_SIZE) + KEYLENGTH, sha1_hash);
-  }
+  sign_data(msg, sizeof(struct c_respmsg) - SIGNATURE_SIZE, sha1_hash);
 
   if (memcmp(sha1_hash, &msg->signature, SIGNATURE_SIZE) != 0) {
     olsr_printf(1, "[ENC]Signature missmatch in challenge-response!\n");
@@ -661,23 +686,9 @@ parse_cres(struct interface_olsr *olsr_if, char *in_msg)
   /* Generate the digest */
   olsr_printf(3, "[ENC]Entry-challenge 0x%x\n", entry->challenge);
 
-  {
-    uint8_t checksum_cache[1512 + KEYLENGTH];
-    uint32_t netorder_challenge;
-
-    /* First the challenge received */
-    /* But we have to calculate our hash with the challenge in
-     * network order just like the remote host did!  6-Jun-2011 AE5AE */
-    netorder_challenge = htonl(entry->challenge);
-    memcpy(checksum_cache, &netorder_challenge, sizeof(uint32_t));
-/*     memcpy(checksum_cache, &entry->challenge, 4); */
-
-    /* Then the local IP */
-    memcpy(&checksum_cache[sizeof(uint32_t)], &msg->originator, olsr_cnf->ipsize);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, sizeof(uint32_t) + olsr_cnf->ipsize, sha1_hash);
-  }
+  /* We have to calculate our hash with the challenge in
+   * network order just like the remote host did!  6-Jun-2011 AE5AE */
+  digest_challenge(htonl(entry->challenge), &msg->originator, sha1_hash);
 
   if (memcmp(msg->res_sig, sha1_hash, SIGNATURE_SIZE) != 0) {
     olsr_printf(1, "[ENC]Error in challenge signature from %s!\n",
@@ -733,17 +744,7 @@ parse_rres(char *in_msg)
 
   /* Check signature */
 
-  {
-    uint8_t checksum_cache[1512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, msg, sizeof(struct r_respmsg) - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(struct r_respmsg) - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(struct r_respmsg) - SIGNATURE_SIZE) + KEYLENGTH, sha1_hash);
-  }
+  sign_data(msg, sizeof(struct r_respmsg) - SIGNATURE_SIZE, sha1_hash);
 
   if (memcmp(sha1_hash, &msg->signature, SIGNATURE_SIZE) != 0) {
     olsr_printf(1, "[ENC]Signature missmatch in response-response!\n");
@@ -762,22 +763,8 @@ parse_rres(char *in_msg)
   /* Generate the digest */
   olsr_printf(3, "[ENC]Entry-challenge 0x%x\n", entry->challenge);
 
-  {
-    uint8_t checksum_cache[1512 + KEYLENGTH];
-    uint32_t netorder_challenge;
-
-    /* First the challenge received */
-    /* But we have to calculate our hash with the challenge in network order!  6-Jun-2011 AE5AE */
-    netorder_challenge = htonl(entry->challenge);
-    memcpy(checksum_cache, &netorder_challenge, sizeof(uint32_t));
-/*     memcpy(checksum_cache, &entry->challenge, 4); */
-
-    /* Then the local IP */
-    memcpy(&checksum_cache[sizeof(uint32_t)], &msg->originator, olsr_cnf->ipsize);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, sizeof(uint32_t) + olsr_cnf->ipsize, sha1_hash);
-  }
+  /* We have to calculate our hash with the challenge in network order!  6-Jun-2011 AE5AE */
+  digest_challenge(htonl(entry->challenge), &msg->originator, sha1_hash);
 
   if (memcmp(msg->res_sig, sha1_hash, SIGNATURE_SIZE) != 0) {
     olsr_printf(1, "[ENC]Error in response signature from %s!\n", olsr_ip_to_string(&buf, (union olsr_ip_addr *)&msg->originator));
@@ -811,7 +798,6 @@ parse_challenge(struct interface_olsr *olsr_if, char *in_msg)
   struct challengemsg *msg;
   uint8_t sha1_hash[SIGNATURE_SIZE];
   struct stamp *entry;
-  uint32_t hash;
   struct ipaddr_str buf;
 
   msg = (struct challengemsg *)ARM_NOWARN_ALIGN(in_msg);
@@ -826,16 +812,7 @@ parse_challenge(struct interface_olsr *olsr_if, char *in_msg)
 
   /* Create entry if not registered */
   if ((entry = lookup_timestamp_entry((const union olsr_ip_addr *)&msg->originator)) == NULL) {
-    entry = malloc(sizeof(struct stamp));
-    memcpy(&entry->addr, &msg->originator, olsr_cnf->ipsize);
-
-    hash = olsr_ip_hashing((union olsr_ip_addr *)&msg->originator);
-
-    /* Queue */
-    timestamps[hash].next->prev = entry;
-    entry->next = timestamps[hash].next;
-    timestamps[hash].next = entry;
-    entry->prev = &timestamps[hash];
+    entry = add_timestamp_entry((const union olsr_ip_addr *)&msg->originator);
   } else {
     /* Check configuration timeout */
     if (!TIMED_OUT(entry->conftime)) {
@@ -851,17 +828,7 @@ parse_challenge(struct interface_olsr *olsr_if, char *in_msg)
 
   /* Check signature */
 
-  {
-    uint8_t checksum_cache[1512 + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, msg, sizeof(struct challengemsg) - SIGNATURE_SIZE);
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(struct challengemsg) - SIGNATURE_SIZE], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(struct challengemsg) - SIGNATURE_SIZE) + KEYLENGTH, sha1_hash);
-  }
+  sign_data(msg, sizeof(struct challengemsg) - SIGNATURE_SIZE, sha1_hash);
   if (memcmp(sha1_hash, &msg->signature, SIGNATURE_SIZE) != 0) {
     olsr_printf(1, "[ENC]Signature missmatch in challenge!\n");
     return 0;
@@ -933,31 +900,10 @@ send_cres(struct interface_olsr *olsr_if, union olsr_ip_addr *to, union olsr_ip_
 
   /* Create digest of received challenge + IP */
 
-  {
-    uint8_t checksum_cache[sizeof(chal_in) + olsr_cnf->ipsize];
-    /* Create packet + key cache */
-    /* First the challenge received */
-    memcpy(checksum_cache, &chal_in, sizeof(chal_in));
-    /* Then the local IP */
-    memcpy(&checksum_cache[sizeof(chal_in)], from, olsr_cnf->ipsize);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, sizeof(chal_in) + olsr_cnf->ipsize, crmsg.res_sig);
-  }
+  digest_challenge(chal_in, from, crmsg.res_sig);
 
   /* Now create the digest of the message and the key */
-
-  {
-    uint8_t checksum_cache[(sizeof(crmsg) - sizeof(crmsg.signature)) + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, &crmsg, sizeof(crmsg) - sizeof(crmsg.signature));
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(crmsg) - sizeof(crmsg.signature)], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(crmsg) - sizeof(crmsg.signature)) + KEYLENGTH, crmsg.signature);
-  }
+  sign_data(&crmsg, sizeof(crmsg) - sizeof(crmsg.signature), crmsg.signature);
 
   olsr_printf(3, "[ENC]Sending challenge response to %s challenge 0x%x\n", olsr_ip_to_string(&buf, to), challenge);
 
@@ -1007,31 +953,10 @@ send_rres(struct interface_olsr *olsr_if, union olsr_ip_addr *to, union olsr_ip_
 
   /* Create digest of received challenge + IP */
 
-  {
-    uint8_t checksum_cache[sizeof(chal_in) + sizeof(union olsr_ip_addr)];
-    /* Create packet + key cache */
-    /* First the challenge received */
-    memcpy(checksum_cache, &chal_in, sizeof(chal_in));
-    /* Then the local IP */
-    memcpy(&checksum_cache[sizeof(chal_in)], from, olsr_cnf->ipsize);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, sizeof(chal_in) + olsr_cnf->ipsize, rrmsg.res_sig);
-  }
+  digest_challenge(chal_in, from, rrmsg.res_sig);
 
   /* Now create the digest of the message and the key */
-
-  {
-    uint8_t checksum_cache[(sizeof(rrmsg) - sizeof(rrmsg.signature)) + KEYLENGTH];
-    /* Create packet + key cache */
-    /* First the OLSR packet + signature message - digest */
-    memcpy(checksum_cache, &rrmsg, sizeof(rrmsg) - sizeof(rrmsg.signature));
-    /* Then the key */
-    memcpy(&checksum_cache[sizeof(rrmsg) - sizeof(rrmsg.signature)], aes_key, KEYLENGTH);
-
-    /* Create the hash */
-    CHECKSUM(checksum_cache, (sizeof(rrmsg) - sizeof(rrmsg.signature)) + KEYLENGTH, rrmsg.signature);
-  }
+  sign_data(&rrmsg, sizeof(rrmsg) - sizeof(rrmsg.signature), rrmsg.signature);
 
   olsr_printf(3, "[ENC]Sending response response to %s\n", olsr_ip_to_string(&buf, to));
 
@@ -1044,6 +969,26 @@ send_rres(struct interface_olsr *olsr_if, union olsr_ip_addr *to, union olsr_ip_
   return 1;
 }
 
+/**
+ * Remove a timestamp entry from its hash bucket and free it
+ */
+static void
+delete_timestamp_entry(struct stamp *entry)
+{
+  struct ipaddr_str buf;
+
+  OLSR_PRINTF(1, "[ENC]timestamp info for %s timed out.. deleting it\n", olsr_ip_to_string(&buf, &entry->addr));
+
+  entry->next->prev = entry->prev;
+  entry->prev->next = entry->next;
+
+  free(entry);
+}
+
+/**
+ * Find the timestamp entry of a host. Timed out entries
+ * that are encountered on the way are deleted.
+ */
 static struct stamp *
 lookup_timestamp_entry(const union olsr_ip_addr *adr)
 {
@@ -1053,57 +998,84 @@ lookup_timestamp_entry(const union olsr_ip_addr *adr)
 
   hash = olsr_ip_hashing(adr);
 
-  for (entry = timestamps[hash].next; entry != &timestamps[hash]; entry = entry->next) {
-    if (memcmp(&entry->addr, adr, olsr_cnf->ipsize) == 0) {
-      olsr_printf(3, "[ENC]Match for %s\n", olsr_ip_to_string(&buf, adr));
+  for (entry = timestamps[hash].next; entry != &timestamps[hash];) {
+    struct stamp *next = entry->next;
+
+    if (TIMED_OUT(entry->valtime) && TIMED_OUT(entry->conftime)) {
+      delete_timestamp_entry(entry);
+    } else if (memcmp(&entry->addr, adr, olsr_cnf->ipsize) == 0) {
+      OLSR_PRINTF(3, "[ENC]Match for %s\n", olsr_ip_to_string(&buf, adr));
       return entry;
     }
+    entry = next;
   }
 
-  olsr_printf(1, "[ENC]No match for %s\n", olsr_ip_to_string(&buf, adr));
+  OLSR_PRINTF(1, "[ENC]No match for %s\n", olsr_ip_to_string(&buf, adr));
 
   return NULL;
 }
 
 /**
- *Find timed out entries and delete them
+ * Create a new, not validated, timestamp entry for a host
+ */
+static struct stamp *
+add_timestamp_entry(const union olsr_ip_addr *adr)
+{
+  struct stamp *entry;
+  uint32_t hash;
+
+  entry = olsr_malloc(sizeof(struct stamp), "SECURE timestamp");
+
+  memcpy(&entry->addr, adr, olsr_cnf->ipsize);
+  entry->diff = 0;
+  entry->challenge = 0;
+  entry->validated = 0;
+  entry->valtime = GET_TIMESTAMP(0);
+
+  /* update validtime - not validated */
+  entry->conftime = GET_TIMESTAMP(EXCHANGE_HOLD_TIME * 1000);
+
+  hash = olsr_ip_hashing(adr);
+
+  /* Queue */
+  timestamps[hash].next->prev = entry;
+  entry->next = timestamps[hash].next;
+  timestamps[hash].next = entry;
+  entry->prev = &timestamps[hash];
+
+  return entry;
+}
+
+/**
+ *Find timed out entries and delete them. Lookups
+ *already delete the timed out entries they encounter,
+ *so only a few buckets are checked on every run.
  *
  *@return nada
  */
 void
 timeout_timestamps(void *foo __attribute__ ((unused)))
 {
-  struct stamp *tmp_list;
-  struct stamp *entry_to_delete;
-  int idx;
+  int i;
 
   /* Update our local timestamp */
   gettimeofday(&now, NULL);
 
-  for (idx = 0; idx < HASHSIZE; idx++) {
-    tmp_list = timestamps[idx].next;
-    /*Traverse MID list */
-    while (tmp_list != &timestamps[idx]) {
-      /*Check if the entry is timed out */
-      if ((TIMED_OUT(tmp_list->valtime)) && (TIMED_OUT(tmp_list->conftime))) {
-        struct ipaddr_str buf;
-        entry_to_delete = tmp_list;
-        tmp_list = tmp_list->next;
-
-        olsr_printf(1, "[ENC]timestamp info for %s timed out.. deleting it\n",
-		    olsr_ip_to_string(&buf, &entry_to_delete->addr));
+  for (i = 0; i < TIMESTAMP_SWEEP_BUCKETS; i++) {
+    struct stamp *tmp_list = timestamps[timestamp_sweep_idx].next;
 
-        /*Delete it */
-        entry_to_delete->next->prev = entry_to_delete->prev;
-        entry_to_delete->prev->next = entry_to_delete->next;
+    while (tmp_list != &timestamps[timestamp_sweep_idx]) {
+      struct stamp *next = tmp_list->next;
 
-        free(entry_to_delete);
-      } else
-        tmp_list = tmp_list->next;
+      /*Check if the entry is timed out */
+      if ((TIMED_OUT(tmp_list->valtime)) && (TIMED_OUT(tmp_list->conftime))) {
+        delete_timestamp_entry(tmp_list);
+      }
+      tmp_list = next;
     }
-  }
 
-  return;
+    timestamp_sweep_idx = (timestamp_sweep_idx + 1) % HASHSIZE;
+  }
 }
 
 static int
@@ -62,6 +62,7 @@
 /* Algorithm definitions */
 #define SHA1_INCLUDING_KEY   1
 #define MD5_INCLUDING_KEY   2
+#define HMAC_SHA256         3
 
 #ifdef USE_OPENSSL
 #define SIGNATURE_SIZE 20
@@ -76,6 +77,9 @@
 
 extern char aes_key[16];
 
+/* Sign with HMAC-SHA256 instead of the digest of the packet and the key */
+extern bool use_hmac_sha256;
+
 /* Seconds of slack allowed */
 #define SLACK 3
 
@@ -0,0 +1,420 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * SHA-256 (FIPS 180-4) and HMAC-SHA256 (RFC 2104)
+ *
+ * The block transform uses the SHA extensions of the CPU when they are
+ * available: on x86 they are detected at runtime, on ARMv8 they are used
+ * when the plugin is compiled for a target with the SHA2 crypto extension.
+ */
+
+#include "sha256.h"
+
+#include <string.h>
+
+#if defined __aarch64__ && (defined __ARM_FEATURE_SHA2 || defined __ARM_FEATURE_CRYPTO)
+#define SHA256_ARMV8 1
+#include <arm_neon.h>
+#elif (defined __x86_64__ || defined __i386__) && defined __GNUC__
+#define SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+static const uint32_t K[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define ROTR(x, n)   (((x) >> (n)) | ((x) << (32 - (n))))
+#define CH(x, y, z)  (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+#define BSIG0(x)     (ROTR((x), 2) ^ ROTR((x), 13) ^ ROTR((x), 22))
+#define BSIG1(x)     (ROTR((x), 6) ^ ROTR((x), 11) ^ ROTR((x), 25))
+#define SSIG0(x)     (ROTR((x), 7) ^ ROTR((x), 18) ^ ((x) >> 3))
+#define SSIG1(x)     (ROTR((x), 17) ^ ROTR((x), 19) ^ ((x) >> 10))
+
+/* SHA-256 block transformation in plain C */
+static void
+SHA256TransformC(uint32_t state[8], const unsigned char *data, unsigned int blocks)
+{
+  uint32_t w[64];
+  uint32_t a, b, c, d, e, f, g, h, t1, t2;
+  int i;
+
+  while (blocks--) {
+    for (i = 0; i < 16; i++) {
+      w[i] = ((uint32_t)data[4 * i] << 24) | ((uint32_t)data[4 * i + 1] << 16) | ((uint32_t)data[4 * i + 2] << 8) | data[4 * i + 3];
+    }
+    for (i = 16; i < 64; i++) {
+      w[i] = SSIG1(w[i - 2]) + w[i - 7] + SSIG0(w[i - 15]) + w[i - 16];
+    }
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (i = 0; i < 64; i++) {
+      t1 = h + BSIG1(e) + CH(e, f, g) + K[i] + w[i];
+      t2 = BSIG0(a) + MAJ(a, b, c);
+      h = g;
+      g = f;
+      f = e;
+      e = d + t1;
+      d = c;
+      c = b;
+      b = a;
+      a = t1 + t2;
+    }
+
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+    state[5] += f;
+    state[6] += g;
+    state[7] += h;
+
+    data += SHA256_BLOCK_LENGTH_BYTES;
+  }
+}
+
+#ifdef SHA256_ARMV8
+/* SHA-256 block transformation with the ARMv8 SHA2 instructions */
+static void
+SHA256TransformARMv8(uint32_t state[8], const unsigned char *data, unsigned int blocks)
+{
+  uint32x4_t abcd = vld1q_u32(&state[0]);
+  uint32x4_t efgh = vld1q_u32(&state[4]);
+
+  while (blocks--) {
+    uint32x4_t abcd_save = abcd;
+    uint32x4_t efgh_save = efgh;
+    uint32x4_t msg[4];
+    int i;
+
+    for (i = 0; i < 4; i++) {
+      msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(&data[16 * i])));
+    }
+
+    for (i = 0; i < 16; i++) {
+      uint32x4_t wk = vaddq_u32(msg[i & 3], vld1q_u32(&K[4 * i]));
+      uint32x4_t abcd_prev = abcd;
+
+      if (i < 12) {
+        msg[i & 3] = vsha256su1q_u32(vsha256su0q_u32(msg[i & 3], msg[(i + 1) & 3]), msg[(i + 2) & 3], msg[(i + 3) & 3]);
+      }
+      abcd = vsha256hq_u32(abcd, efgh, wk);
+      efgh = vsha256h2q_u32(efgh, abcd_prev, wk);
+    }
+
+    abcd = vaddq_u32(abcd, abcd_save);
+    efgh = vaddq_u32(efgh, efgh_save);
+
+    data += SHA256_BLOCK_LENGTH_BYTES;
+  }
+
+  vst1q_u32(&state[0], abcd);
+  vst1q_u32(&state[4], efgh);
+}
+#endif /* SHA256_ARMV8 */
+
+#ifdef SHA256_X86
+/* SHA-256 block transformation with the x86 SHA extensions */
+__attribute__ ((target("sha,sse4.1,ssse3")))
+static void
+SHA256TransformX86(uint32_t state[8], const unsigned char *data, unsigned int blocks)
+{
+  const __m128i shuffle = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+  __m128i tmp, abef, cdgh;
+
+  /* the SHA instructions work on the ABEF and CDGH halves of the state */
+  tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(const void *)&state[0]), 0xB1);
+  cdgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)(const void *)&state[4]), 0x1B);
+  abef = _mm_alignr_epi8(tmp, cdgh, 8);
+  cdgh = _mm_blend_epi16(cdgh, tmp, 0xF0);
+
+  while (blocks--) {
+    __m128i abef_save = abef;
+    __m128i cdgh_save = cdgh;
+    __m128i msg[4];
+    int i;
+
+    for (i = 0; i < 4; i++) {
+      msg[i] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(const void *)&data[16 * i]), shuffle);
+    }
+
+    for (i = 0; i < 16; i++) {
+      __m128i wk = _mm_add_epi32(msg[i & 3], _mm_loadu_si128((const __m128i *)(const void *)&K[4 * i]));
+
+      cdgh = _mm_sha256rnds2_epu32(cdgh, abef, wk);
+      abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(wk, 0x0E));
+
+      if (i < 12) {
+        msg[i & 3] = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(msg[i & 3], msg[(i + 1) & 3]),
+                                                        _mm_alignr_epi8(msg[(i + 3) & 3], msg[(i + 2) & 3], 4)),
+                                          msg[(i + 3) & 3]);
+      }
+    }
+
+    abef = _mm_add_epi32(abef, abef_save);
+    cdgh = _mm_add_epi32(cdgh, cdgh_save);
+
+    data += SHA256_BLOCK_LENGTH_BYTES;
+  }
+
+  tmp = _mm_shuffle_epi32(abef, 0x1B);
+  cdgh = _mm_shuffle_epi32(cdgh, 0xB1);
+  _mm_storeu_si128((__m128i *)(void *)&state[0], _mm_blend_epi16(tmp, cdgh, 0xF0));
+  _mm_storeu_si128((__m128i *)(void *)&state[4], _mm_alignr_epi8(cdgh, tmp, 8));
+}
+#endif /* SHA256_X86 */
+
+typedef void (*sha256_transform_func) (uint32_t state[8], const unsigned char *data, unsigned int blocks);
+
+static sha256_transform_func SHA256Transform = NULL;
+
+static const char *sha256_implementation = "C";
+
+/* Select the fastest block transformation for this CPU */
+static void
+SHA256SelectTransform(void)
+{
+  SHA256Transform = &SHA256TransformC;
+
+#if defined SHA256_ARMV8
+  SHA256Transform = &SHA256TransformARMv8;
+  sha256_implementation = "ARMv8 SHA2";
+#elif defined SHA256_X86
+  {
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_1) && (ecx & bit_SSSE3)
+        && __get_cpuid_max(0, NULL) >= 7) {
+      __cpuid_count(7, 0, eax, ebx, ecx, edx);
+      if (ebx & (1 << 29)) {
+        SHA256Transform = &SHA256TransformX86;
+        sha256_implementation = "x86 SHA";
+      }
+    }
+  }
+#endif /* SHA256_X86 */
+}
+
+/* Return a description of the block transformation that is used */
+const char *
+SHA256Implementation(void)
+{
+  if (!SHA256Transform) {
+    SHA256SelectTransform();
+  }
+  return sha256_implementation;
+}
+
+/* SHA-256 initialization. Begins a SHA-256 operation, writing a new context.
+ */
+void
+SHA256Init(SHA256_CONTEXT * context)
+{
+  static const uint32_t initial[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+
+  if (!SHA256Transform) {
+    SHA256SelectTransform();
+  }
+
+  memcpy(context->state, initial, sizeof(context->state));
+  context->count = 0;
+}
+
+/* SHA-256 block update operation. Continues a SHA-256 message-digest
+  operation, processing another message block, and updating the
+  context.
+ */
+void
+SHA256Update(SHA256_CONTEXT * context, const unsigned char *input, unsigned int inputLen)
+{
+  unsigned int index = context->count % SHA256_BLOCK_LENGTH_BYTES;
+
+  context->count += inputLen;
+
+  /* complete a partially filled buffer */
+  if (index) {
+    unsigned int partLen = SHA256_BLOCK_LENGTH_BYTES - index;
+
+    if (inputLen < partLen) {
+      memcpy(&context->buffer[index], input, inputLen);
+      return;
+    }
+
+    memcpy(&context->buffer[index], input, partLen);
+    SHA256Transform(context->state, context->buffer, 1);
+    input += partLen;
+    inputLen -= partLen;
+  }
+
+  /* transform all complete blocks straight from the input */
+  if (inputLen >= SHA256_BLOCK_LENGTH_BYTES) {
+    SHA256Transform(context->state, input, inputLen / SHA256_BLOCK_LENGTH_BYTES);
+    input += inputLen - (inputLen % SHA256_BLOCK_LENGTH_BYTES);
+    inputLen %= SHA256_BLOCK_LENGTH_BYTES;
+  }
+
+  /* buffer the remaining input */
+  memcpy(context->buffer, input, inputLen);
+}
+
+/* SHA-256 finalization. Ends a SHA-256 message-digest operation, writing the
+  the message digest.
+ */
+void
+SHA256Final(unsigned char digest[SHA256_DIGEST_LENGTH_BYTES], SHA256_CONTEXT * context)
+{
+  unsigned int index = context->count % SHA256_BLOCK_LENGTH_BYTES;
+  uint64_t bits = context->count << 3;
+  int i;
+
+  /* pad with 0x80, zeroes and the message length in bits */
+  context->buffer[index++] = 0x80;
+  if (index > SHA256_BLOCK_LENGTH_BYTES - 8) {
+    memset(&context->buffer[index], 0, SHA256_BLOCK_LENGTH_BYTES - index);
+    SHA256Transform(context->state, context->buffer, 1);
+    index = 0;
+  }
+  memset(&context->buffer[index], 0, SHA256_BLOCK_LENGTH_BYTES - 8 - index);
+  for (i = 0; i < 8; i++) {
+    context->buffer[SHA256_BLOCK_LENGTH_BYTES - 1 - i] = (unsigned char)(bits >> (8 * i));
+  }
+  SHA256Transform(context->state, context->buffer, 1);
+
+  for (i = 0; i < 8; i++) {
+    digest[4 * i] = (unsigned char)(context->state[i] >> 24);
+    digest[4 * i + 1] = (unsigned char)(context->state[i] >> 16);
+    digest[4 * i + 2] = (unsigned char)(context->state[i] >> 8);
+    digest[4 * i + 3] = (unsigned char)context->state[i];
+  }
+
+  /* Zeroize sensitive information.
+   */
+  memset(context, 0, sizeof(*context));
+}
+
+/* HMAC-SHA256 key setup. Absorbs the padded key into the inner and outer
+  contexts once, so that every MAC only hashes the message and the inner
+  digest.
+ */
+void
+HMACSHA256Init(HMAC_SHA256_KEY * hmac, const unsigned char *key, unsigned int keyLen)
+{
+  unsigned char keyBlock[SHA256_BLOCK_LENGTH_BYTES];
+  unsigned char pad[SHA256_BLOCK_LENGTH_BYTES];
+  unsigned int i;
+
+  memset(keyBlock, 0, sizeof(keyBlock));
+  if (keyLen > SHA256_BLOCK_LENGTH_BYTES) {
+    SHA256_CONTEXT context;
+
+    SHA256Init(&context);
+    SHA256Update(&context, key, keyLen);
+    SHA256Final(keyBlock, &context);
+  } else {
+    memcpy(keyBlock, key, keyLen);
+  }
+
+  for (i = 0; i < SHA256_BLOCK_LENGTH_BYTES; i++) {
+    pad[i] = keyBlock[i] ^ 0x36;
+  }
+  SHA256Init(&hmac->inner);
+  SHA256Update(&hmac->inner, pad, SHA256_BLOCK_LENGTH_BYTES);
+
+  for (i = 0; i < SHA256_BLOCK_LENGTH_BYTES; i++) {
+    pad[i] = keyBlock[i] ^ 0x5c;
+  }
+  SHA256Init(&hmac->outer);
+  SHA256Update(&hmac->outer, pad, SHA256_BLOCK_LENGTH_BYTES);
+
+  memset(keyBlock, 0, sizeof(keyBlock));
+  memset(pad, 0, sizeof(pad));
+}
+
+/* HMAC-SHA256 of a message with a prepared key
+ */
+void
+HMACSHA256(const HMAC_SHA256_KEY * hmac, const unsigned char *input, unsigned int inputLen,
+           unsigned char digest[SHA256_DIGEST_LENGTH_BYTES])
+{
+  SHA256_CONTEXT context;
+  unsigned char inner[SHA256_DIGEST_LENGTH_BYTES];
+
+  context = hmac->inner;
+  SHA256Update(&context, input, inputLen);
+  SHA256Final(inner, &context);
+
+  context = hmac->outer;
+  SHA256Update(&context, inner, sizeof(inner));
+  SHA256Final(digest, &context);
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,84 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#ifndef _SHA256_H_
+#define _SHA256_H_
+
+#include <stdint.h>
+
+#define SHA256_DIGEST_LENGTH_BYTES 32
+#define SHA256_BLOCK_LENGTH_BYTES  64
+
+/* SHA-256 context. */
+typedef struct {
+  uint32_t state[8];                   /* state (ABCDEFGH) */
+  uint64_t count;                      /* number of bytes, modulo 2^64 */
+  unsigned char buffer[SHA256_BLOCK_LENGTH_BYTES]; /* input buffer */
+} SHA256_CONTEXT;
+
+/* HMAC-SHA256 key: the states after absorbing the inner and outer padded key */
+typedef struct {
+  SHA256_CONTEXT inner;
+  SHA256_CONTEXT outer;
+} HMAC_SHA256_KEY;
+
+void SHA256Init(SHA256_CONTEXT *);
+void SHA256Update(SHA256_CONTEXT *, const unsigned char *, unsigned int);
+void SHA256Final(unsigned char[SHA256_DIGEST_LENGTH_BYTES], SHA256_CONTEXT *);
+
+void HMACSHA256Init(HMAC_SHA256_KEY *, const unsigned char *, unsigned int);
+void HMACSHA256(const HMAC_SHA256_KEY *, const unsigned char *, unsigned int, unsigned char[SHA256_DIGEST_LENGTH_BYTES]);
+
+const char *SHA256Implementation(void);
+
+#endif /* _SHA256_H_ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
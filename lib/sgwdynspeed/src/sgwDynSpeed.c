@@ -55,6 +55,7 @@
 #include "scheduler.h"
 #include "log.h"
 #include "gateway.h"
+#include "file_watch.h"
 
 /* System includes */
 
@@ -108,6 +109,18 @@ static void smartgw_read_speed_file(void *context __attribute__ ((unused))) {
 	return;
 }
 
+/**
+ * Watch callback that reads the smart gateway speed file after it was written,
+ * renamed into place or removed
+ */
+static void smartgw_speed_file_changed(const char * path __attribute__ ((unused)), void *data __attribute__ ((unused))) {
+	forgetSpeedFileStat();
+	readSpeedFile(getSpeedFile());
+}
+
+/** The watch on the speed file, NULL when polling */
+static struct file_watch * smartgw_speed_file_watch = NULL;
+
 /** The timer cookie, used to trace back the originator in debug */
 static struct olsr_cookie_info *smartgw_speed_file_timer_cookie = NULL;
 
@@ -138,6 +151,14 @@ static struct timer_entry * smartgw_speed_file_timer = NULL;
 	if (speedFile) {
 		readSpeedFile(speedFile);
 
+		if (smartgw_speed_file_watch == NULL) {
+			smartgw_speed_file_watch = olsr_file_watch_add(speedFile, &smartgw_speed_file_changed, NULL);
+		}
+		if (smartgw_speed_file_watch != NULL) {
+			return true;
+		}
+
+		/* fall back to polling */
 		if (smartgw_speed_file_timer_cookie == NULL) {
 			smartgw_speed_file_timer_cookie = olsr_alloc_cookie("smartgw speed file", OLSR_COOKIE_TYPE_TIMER);
 			if (smartgw_speed_file_timer_cookie == NULL) {
@@ -162,6 +183,10 @@ static struct timer_entry * smartgw_speed_file_timer = NULL;
   * stop the plugin, free resources
   */
 void stopSgwDynSpeed(void) {
+	if (smartgw_speed_file_watch != NULL) {
+		olsr_file_watch_remove(smartgw_speed_file_watch);
+		smartgw_speed_file_watch = NULL;
+	}
 	if (smartgw_speed_file_timer != NULL) {
 		olsr_stop_timer(smartgw_speed_file_timer);
 		smartgw_speed_file_timer = NULL;
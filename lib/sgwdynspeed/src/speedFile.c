@@ -57,7 +57,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <stdlib.h>
-#include <regex.h>
+#include <ctype.h>
 #include <errno.h>
 #include <sys/stat.h>
 #include <stdio.h>
@@ -69,22 +69,6 @@
 /** the maximal length of a line that is read from the file */
 #define LINE_LENGTH 256
 
-/** regular expression describing a comment */
-static const char * regexCommentString = "^([[:space:]]*|[[:space:]#]+.*)$";
-
-/** regular expression describing a key/value pair */
-static const char * regexNameValueString =
-		"^[[:space:]]*([^[:space:]]+)[[:space:]]*=[[:space:]]*(.*?)[[:space:]]*$";
-
-/** the number of matches in regexNameValueString */
-static const size_t regexNameValuematchCount = 3;
-
-/** the compiled regular expression describing a comment */
-static regex_t regexComment;
-
-/** the compiled regular expression describing a key/value pair */
-static regex_t regexNameValue;
-
 /** true when the plugin has been started */
 static bool started = false;
 
@@ -137,38 +121,74 @@ static bool readUL(const char * valueName, const char * value, unsigned long * v
 }
 
 /**
- * Strip EOL characters from a string
+ * Determine whether a line is a comment: an empty line, or a line that starts
+ * with whitespace or a '#'
  *
- * @param str the string to strip
- * @param endindex the index of the \0 string terminator (end-of-string/strlen)
+ * @param str the line
+ * @return true when the line is a comment
  */
-static void stripEols(char * str, regoff_t endindex) {
-  regoff_t len = endindex;
-  while ((len > 0) && ((str[len - 1] == '\n') || (str[len - 1] == '\r'))) {
-    len--;
-  }
-  str[len] = '\0';
+static bool isCommentLine(const char * str) {
+	return (*str == '\0') || (*str == '#') || isspace((unsigned char) *str);
 }
 
 /**
- * Initialises the speedFile reader.
- * @return true upon success, false otherwise
+ * Scan a name=value line. The name and the value are terminated in place;
+ * whitespace around them and EOL characters are stripped.
+ *
+ * @param str the line
+ * @param name a pointer to the location where to store the name
+ * @param value a pointer to the location where to store the value
+ * @return true when the line has a valid syntax
  */
-bool startSpeedFile(void) {
-	if (started) {
-		return true;
+static bool scanNameValue(char * str, char ** name, char ** value) {
+	char * p = str;
+	char * nameEnd;
+	size_t len;
+
+	while (isspace((unsigned char) *p)) {
+		p++;
 	}
 
-	if (regcomp(&regexComment, regexCommentString, REG_EXTENDED | REG_ICASE)) {
-		sgwDynSpeedError(false, "Could not compile regex \"%s\"", regexCommentString);
+	*name = p;
+	while ((*p != '\0') && (*p != '=') && !isspace((unsigned char) *p)) {
+		p++;
+	}
+	if (p == *name) {
 		return false;
 	}
+	nameEnd = p;
 
-	if (regcomp(&regexNameValue, regexNameValueString, REG_EXTENDED | REG_ICASE)) {
-		sgwDynSpeedError(false, "Could not compile regex \"%s\"", regexNameValueString);
-		regfree(&regexComment);
+	while (isspace((unsigned char) *p)) {
+		p++;
+	}
+	if (*p != '=') {
 		return false;
 	}
+	p++;
+
+	while (isspace((unsigned char) *p)) {
+		p++;
+	}
+
+	len = strlen(p);
+	while ((len > 0) && isspace((unsigned char) p[len - 1])) {
+		len--;
+	}
+	p[len] = '\0';
+
+	*nameEnd = '\0';
+	*value = p;
+	return true;
+}
+
+/**
+ * Initialises the speedFile reader.
+ * @return true upon success, false otherwise
+ */
+bool startSpeedFile(void) {
+	if (started) {
+		return true;
+	}
 
 	memset(&cachedStat, 0, sizeof(cachedStat));
 
@@ -180,38 +200,15 @@ bool startSpeedFile(void) {
  * Cleans up the speedFile reader.
  */
 void stopSpeedFile(void) {
-	if (started) {
-		regfree(&regexNameValue);
-		regfree(&regexComment);
-		started = false;
-	}
+	started = false;
 }
 
 /**
- * Performs a regex match
- * @param regex the compiled regex to match against
- * @param line the line to match
- * @param nmatch the number of matches to produce
- * @param pmatch the array with match information
- * @return true upon success, false otherwise
+ * Forget the cached stat result so that the next readSpeedFile reads the file
+ * even when its modification time did not change.
  */
-static bool regexMatch(regex_t * regex, char * line, size_t nmatch, regmatch_t pmatch[]) {
-	int result = regexec(regex, line, nmatch, pmatch, 0);
-	if (!result) {
-		return true;
-	}
-
-	if (result == REG_NOMATCH) {
-		return false;
-	}
-
-	{
-		char msgbuf[256];
-		regerror(result, regex, msgbuf, sizeof(msgbuf));
-		sgwDynSpeedError(false, "Regex match failed: %s", msgbuf);
-	}
-
-	return false;
+void forgetSpeedFileStat(void) {
+	memset(&cachedStat, 0, sizeof(cachedStat));
 }
 
 /** the buffer in which to store a line read from the file */
@@ -272,28 +269,18 @@ void readSpeedFile(char * fileName) {
 	memcpy(&cachedStat.timeStamp, mtim, sizeof(cachedStat.timeStamp));
 
 	while (fgets(line, LINE_LENGTH, fp)) {
-		regmatch_t pmatch[regexNameValuematchCount];
-
 		lineNumber++;
 
-		if (regexMatch(&regexComment, line, 0, NULL)) {
+		if (isCommentLine(line)) {
 			continue;
 		}
 
-		if (!regexMatch(&regexNameValue, line, regexNameValuematchCount, pmatch)) {
+		if (!scanNameValue(line, &name, &value)) {
 			sgwDynSpeedError(false, "Gateway speed file \"%s\", line %d uses invalid syntax: ignored (%s)", fileName, lineNumber,
 					line);
 			continue;
 		}
 
-		stripEols(line, pmatch[2].rm_eo);
-
-		/* determine name/value */
-		name = &line[pmatch[1].rm_so];
-		line[pmatch[1].rm_eo] = '\0';
-		value = &line[pmatch[2].rm_so];
-		line[pmatch[2].rm_eo] = '\0';
-
 		if (!strncasecmp(SPEED_UPLINK_NAME, name, sizeof(line))) {
 			if (!readUL(SPEED_UPLINK_NAME, value, &uplink)) {
 				sgwDynSpeedError(false, "Gateway speed file \"%s\", line %d: %s value \"%s\" is not a valid number: ignored",
@@ -55,6 +55,7 @@
 
 bool startSpeedFile(void);
 void stopSpeedFile(void);
+void forgetSpeedFileStat(void);
 void readSpeedFile(char * fileName);
 
 #endif /* SPEEDFILE_H */
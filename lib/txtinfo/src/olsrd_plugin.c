@@ -99,6 +99,7 @@ int olsrd_plugin_init(void) {
   memset(&functions, 0, sizeof(functions));
 
   functions.supportsCompositeCommands = true;
+  functions.snapshot_commands = SIW_NEIGHBORS | SIW_LINKS | SIW_ROUTES | SIW_HNA | SIW_MID | SIW_TOPOLOGY | SIW_2HOP;
   functions.supported_commands_mask = get_supported_commands_mask;
   functions.is_command = isCommand;
   functions.cache_timeout = cache_timeout_generic;
@@ -116,6 +117,7 @@ int olsrd_plugin_init(void) {
   functions.olsrd_conf = ipc_print_olsrd_conf;
   functions.interfaces = ipc_print_interfaces;
   functions.twohop = ipc_print_twohop;
+  functions.metrics = ipc_print_metrics;
 
   return info_plugin_init(PLUGIN_NAME, &functions, &config);
 }
@@ -127,6 +129,18 @@ void olsr_plugin_exit(void) {
   info_plugin_exit();
 }
 
+/**
+ * reconfiguration - restore the parameter defaults, olsrd_plugin_init is called again
+ */
+int olsrd_plugin_reconfigure(void) {
+  info_plugin_reconfigure();
+
+  info_plugin_config_init(&config, 2006);
+  config.http_headers = false;
+  vtime = false;
+  return 0;
+}
+
 int olsrd_plugin_interface_version(void) {
   return PLUGIN_INTERFACE_VERSION;
 }
@@ -59,10 +59,13 @@
 #include "olsrd_plugin.h"
 #include "info/info_types.h"
 #include "info/http_headers.h"
+#include "info/olsrd_info.h"
+#include "olsr_snapshot.h"
+#include "olsr_metrics.h"
 #include "gateway_default_handler.h"
 
 unsigned long long get_supported_commands_mask(void) {
-  return (SIW_ALL | SIW_OLSRD_CONF) & ~(SIW_CONFIG | SIW_PLUGINS);
+  return ((SIW_ALL | SIW_OLSRD_CONF) & ~(SIW_CONFIG | SIW_PLUGINS)) | SIW_METRICS;
 }
 
 bool isCommand(const char *str, unsigned long long siw) {
@@ -132,6 +135,10 @@ bool isCommand(const char *str, unsigned long long siw) {
       cmd = "/neighbours";
       break;
 
+    case SIW_METRICS:
+      cmd = "/metrics";
+      break;
+
     default:
       return false;
   }
@@ -155,10 +162,9 @@ void output_error(struct autobuf *abuf, unsigned int status, const char * req __
 }
 
 static void ipc_print_neighbors_internal(struct autobuf *abuf, bool list_2hop) {
+  struct olsr_snapshot *snapshot = info_snapshot(OLSR_SNAPSHOT_NEIGHBORS);
   struct ipaddr_str neighAddrBuf;
-  struct neighbor_entry *neigh;
-  struct neighbor_2_list_entry *list_2;
-  int thop_cnt;
+  uint32_t i, j;
 
   const char * field;
   if (list_2hop) {
@@ -171,30 +177,25 @@ static void ipc_print_neighbors_internal(struct autobuf *abuf, bool list_2hop) {
   abuf_appendf(abuf, "IP address\tSYM\tMPR\tMPRS\tWill.\t%s\n", field);
 
   /* Neighbors */
-  OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
+  for (i = 0; i < snapshot->neighbor_count; i++) {
+    struct olsr_snapshot_neighbor *neigh = &snapshot->neighbors[i];
+
     abuf_appendf(abuf, "%s\t%s\t%s\t%s\t%d",
       olsr_ip_to_string(&neighAddrBuf, &neigh->neighbor_main_addr),
       (neigh->status == SYM) ? "YES" : "NO",
       neigh->is_mpr ? "YES" : "NO",
-      olsr_lookup_mprs_set(&neigh->neighbor_main_addr) ? "YES" : "NO",
+      neigh->is_mpr_selector ? "YES" : "NO",
       neigh->willingness);
-    thop_cnt = 0;
 
-    for (list_2 = neigh->neighbor_2_list.next; list_2 != &neigh->neighbor_2_list; list_2 = list_2->next) {
-      if (list_2hop) {
-        if (list_2->neighbor_2) {
-          abuf_appendf(abuf, "\t%s", olsr_ip_to_string(&neighAddrBuf, &list_2->neighbor_2->neighbor_2_addr));
-        }
-      } else {
-        thop_cnt++;
+    if (list_2hop) {
+      for (j = 0; j < neigh->two_hop_count; j++) {
+        abuf_appendf(abuf, "\t%s", olsr_ip_to_string(&neighAddrBuf, &snapshot->two_hop[neigh->two_hop_first + j]));
       }
-    }
-
-    if (!list_2hop) {
-      abuf_appendf(abuf, "\t%d", thop_cnt);
+    } else {
+      abuf_appendf(abuf, "\t%d", (int) neigh->two_hop_count);
     }
     abuf_puts(abuf, "\n");
-  } OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
+  }
   abuf_puts(abuf, "\n");
 }
 
@@ -203,7 +204,8 @@ void ipc_print_neighbors(struct autobuf *abuf) {
 }
 
 void ipc_print_links(struct autobuf *abuf) {
-  struct link_entry *my_link;
+  struct olsr_snapshot *snapshot = info_snapshot(OLSR_SNAPSHOT_LINKS);
+  uint32_t i;
 
   const char * field;
   if (vtime) {
@@ -216,16 +218,16 @@ void ipc_print_links(struct autobuf *abuf) {
   abuf_appendf(abuf, "Local IP\tRemote IP\t%s\tLQ\tNLQ\tCost\n", field);
 
   /* Link set */
-  OLSR_FOR_ALL_LINK_ENTRIES(my_link) {
+  for (i = 0; i < snapshot->link_count; i++) {
+    struct olsr_snapshot_link *my_link = &snapshot->links[i];
     struct ipaddr_str localAddr;
     struct ipaddr_str remoteAddr;
-    struct lqtextbuffer lqbuffer;
     struct lqtextbuffer costbuffer;
     unsigned int diffI = 0;
     unsigned int diffF = 0;
 
     if (vtime) {
-      unsigned int diff = my_link->link_timer ? (unsigned int) (my_link->link_timer->timer_clock - now_times) : 0;
+      unsigned int diff = olsr_getTimeLeft(my_link->link_timer);
       diffI = diff / 1000;
       diffF = diff % 1000;
     }
@@ -235,39 +237,40 @@ void ipc_print_links(struct autobuf *abuf) {
       olsr_ip_to_string(&remoteAddr, &my_link->neighbor_iface_addr),
       diffI,
       diffF,
-      get_link_entry_text(my_link, '\t', &lqbuffer),
+      my_link->lq.buf,
       get_linkcost_text(my_link->linkcost, false, &costbuffer));
-  } OLSR_FOR_ALL_LINK_ENTRIES_END(my_link);
+  }
   abuf_puts(abuf, "\n");
 }
 
 void ipc_print_routes(struct autobuf *abuf) {
-  struct rt_entry *rt;
+  struct olsr_snapshot *snapshot = info_snapshot(OLSR_SNAPSHOT_ROUTES);
+  uint32_t i;
 
   abuf_puts(abuf, "Table: Routes\n");
   abuf_puts(abuf, "Destination\tGateway IP\tMetric\tETX\tInterface\n");
 
   /* Walk the route table */
-  OLSR_FOR_ALL_RT_ENTRIES(rt) {
+  for (i = 0; i < snapshot->route_count; i++) {
+    struct olsr_snapshot_route *rt = &snapshot->routes[i];
     struct ipaddr_str dstAddr;
     struct ipaddr_str nexthopAddr;
     struct lqtextbuffer costbuffer;
 
-    if (rt->rt_best) {
-      abuf_appendf(abuf, "%s/%d\t%s\t%d\t%s\t%s\t\n",
-        olsr_ip_to_string(&dstAddr, &rt->rt_dst.prefix),
-        rt->rt_dst.prefix_len,
-        olsr_ip_to_string(&nexthopAddr, &rt->rt_best->rtp_nexthop.gateway),
-        rt->rt_best->rtp_metric.hops,
-        get_linkcost_text(rt->rt_best->rtp_metric.cost, true, &costbuffer),
-        if_ifwithindex_name(rt->rt_best->rtp_nexthop.iif_index));
-    }
-  } OLSR_FOR_ALL_RT_ENTRIES_END(rt);
+    abuf_appendf(abuf, "%s/%d\t%s\t%d\t%s\t%s\t\n",
+      olsr_ip_to_string(&dstAddr, &rt->rt_dst.prefix),
+      rt->rt_dst.prefix_len,
+      olsr_ip_to_string(&nexthopAddr, &rt->gateway),
+      rt->hops,
+      get_linkcost_text(rt->cost, true, &costbuffer),
+      rt->if_name);
+  }
   abuf_puts(abuf, "\n");
 }
 
 void ipc_print_topology(struct autobuf *abuf) {
-  struct tc_entry *tc;
+  struct olsr_snapshot *snapshot = info_snapshot(OLSR_SNAPSHOT_TOPOLOGY);
+  uint32_t i, j;
 
   const char * field;
   if (vtime) {
@@ -280,38 +283,37 @@ void ipc_print_topology(struct autobuf *abuf) {
   abuf_appendf(abuf, "Dest. IP\tLast hop IP\tLQ\tNLQ\tCost%s\n", field);
 
   /* Topology */
-  OLSR_FOR_ALL_TC_ENTRIES(tc) {
-    struct tc_edge_entry *tc_edge;
-    OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
-      if (tc_edge->edge_inv) {
-        struct ipaddr_str dstAddr;
-        struct ipaddr_str lastHopAddr;
-        struct lqtextbuffer lqbuffer;
-        struct lqtextbuffer costbuffer;
-
-        abuf_appendf(abuf, "%s\t%s\t%s\t%s",
-          olsr_ip_to_string(&dstAddr, &tc_edge->T_dest_addr),
-          olsr_ip_to_string(&lastHopAddr, &tc->addr),
-          get_tc_edge_entry_text(tc_edge, '\t', &lqbuffer),
-          get_linkcost_text(tc_edge->cost, false, &costbuffer));
-
-        if (vtime) {
-          unsigned int diff = (unsigned int) (tc->validity_timer ? (tc->validity_timer->timer_clock - now_times) : 0);
-          abuf_appendf(abuf, "\t%u.%03u", diff / 1000, diff % 1000);
-        }
+  for (i = 0; i < snapshot->tc_count; i++) {
+    struct olsr_snapshot_tc *tc = &snapshot->tcs[i];
+
+    for (j = 0; j < tc->edge_count; j++) {
+      struct olsr_snapshot_edge *tc_edge = &snapshot->edges[tc->edge_first + j];
+      struct ipaddr_str dstAddr;
+      struct ipaddr_str lastHopAddr;
+      struct lqtextbuffer costbuffer;
 
-        abuf_puts(abuf, "\n");
+      abuf_appendf(abuf, "%s\t%s\t%s\t%s",
+        olsr_ip_to_string(&dstAddr, &tc_edge->T_dest_addr),
+        olsr_ip_to_string(&lastHopAddr, &tc->addr),
+        tc_edge->lq.buf,
+        get_linkcost_text(tc_edge->cost, false, &costbuffer));
+
+      if (vtime) {
+        unsigned int diff = olsr_getTimeLeft(tc->validity_timer);
+        abuf_appendf(abuf, "\t%u.%03u", diff / 1000, diff % 1000);
       }
-    } OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
-  } OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+
+      abuf_puts(abuf, "\n");
+    }
+  }
   abuf_puts(abuf, "\n");
 }
 
 void ipc_print_hna(struct autobuf *abuf) {
-  struct ip_prefix_list *hna;
-  struct hna_entry *tmp_hna;
+  struct olsr_snapshot *snapshot = info_snapshot(OLSR_SNAPSHOT_HNA);
   struct ipaddr_str prefixbuf;
   struct ipaddr_str gwaddrbuf;
+  uint32_t i;
 
   const char * field;
   if (vtime) {
@@ -323,42 +325,27 @@ void ipc_print_hna(struct autobuf *abuf) {
   abuf_puts(abuf, "Table: HNA\n");
   abuf_appendf(abuf, "Destination\tGateway%s\n", field);
 
-  /* Announced HNA entries */
-  for (hna = olsr_cnf->hna_entries; hna != NULL ; hna = hna->next) {
+  /* Announced HNA entries come first, they have no validity time */
+  for (i = 0; i < snapshot->hna_count; i++) {
+    struct olsr_snapshot_hna *hna = &snapshot->hnas[i];
+
     abuf_appendf(abuf, "%s/%d\t%s",
       olsr_ip_to_string(&prefixbuf, &hna->net.prefix),
       hna->net.prefix_len,
-      olsr_ip_to_string(&gwaddrbuf, &olsr_cnf->main_addr));
-
-      if (vtime) {
-        abuf_appendf(abuf, "\t%u.%03u", 0, 0);
-      }
-      abuf_puts(abuf, "\n");
-  }
+      olsr_ip_to_string(&gwaddrbuf, &hna->gateway));
 
-  /* HNA entries */
-  OLSR_FOR_ALL_HNA_ENTRIES(tmp_hna) {
-    struct hna_net *tmp_net;
-
-    /* Check all networks */
-    for (tmp_net = tmp_hna->networks.next; tmp_net != &tmp_hna->networks; tmp_net = tmp_net->next) {
-      abuf_appendf(abuf, "%s/%d\t%s",
-        olsr_ip_to_string(&prefixbuf, &tmp_net->hna_prefix.prefix),
-        tmp_net->hna_prefix.prefix_len,
-        olsr_ip_to_string(&gwaddrbuf, &tmp_hna->A_gateway_addr));
-
-      if (vtime) {
-        unsigned int diff = tmp_net->hna_net_timer ? (unsigned int) (tmp_net->hna_net_timer->timer_clock - now_times) : 0;
-        abuf_appendf(abuf, "\t%u.%03u", diff / 1000, diff % 1000);
-      }
-      abuf_puts(abuf, "\n");
+    if (vtime) {
+      unsigned int diff = olsr_getTimeLeft(hna->hna_net_timer);
+      abuf_appendf(abuf, "\t%u.%03u", diff / 1000, diff % 1000);
     }
-  } OLSR_FOR_ALL_HNA_ENTRIES_END(tmp_hna);
+    abuf_puts(abuf, "\n");
+  }
   abuf_puts(abuf, "\n");
 }
 
 void ipc_print_mid(struct autobuf *abuf) {
-  int idx;
+  struct olsr_snapshot *snapshot = info_snapshot(OLSR_SNAPSHOT_MID);
+  uint32_t i, j;
 
   const char * field;
   if (vtime) {
@@ -371,31 +358,25 @@ void ipc_print_mid(struct autobuf *abuf) {
   abuf_appendf(abuf, "IP address\t(Alias%s)+\n", field);
 
   /* MID */
-  for (idx = 0; idx < HASHSIZE; idx++) {
-    struct mid_entry *entry = mid_set[idx].next;
-
-    while (entry && (entry != &mid_set[idx])) {
-      struct mid_address *alias = entry->aliases;
-      struct ipaddr_str ipAddr;
+  for (i = 0; i < snapshot->mid_count; i++) {
+    struct olsr_snapshot_mid *entry = &snapshot->mids[i];
+    struct ipaddr_str ipAddr;
 
-      abuf_puts(abuf, olsr_ip_to_string(&ipAddr, &entry->main_addr));
-      abuf_puts(abuf, "\t");
+    abuf_puts(abuf, olsr_ip_to_string(&ipAddr, &entry->main_addr));
+    abuf_puts(abuf, "\t");
 
-      while (alias) {
-        struct ipaddr_str buf2;
+    for (j = 0; j < entry->alias_count; j++) {
+      struct olsr_snapshot_alias *alias = &snapshot->aliases[entry->alias_first + j];
+      struct ipaddr_str buf2;
 
-        abuf_appendf(abuf, "\t%s", olsr_ip_to_string(&buf2, &alias->alias));
+      abuf_appendf(abuf, "\t%s", olsr_ip_to_string(&buf2, &alias->alias));
 
-        if (vtime) {
-          unsigned int diff = (unsigned int) (alias->vtime - now_times);
-          abuf_appendf(abuf, ":%u.%03u", diff / 1000, diff % 1000);
-        }
-
-        alias = alias->next_alias;
+      if (vtime) {
+        unsigned int diff = olsr_getTimeLeft(alias->vtime);
+        abuf_appendf(abuf, ":%u.%03u", diff / 1000, diff % 1000);
       }
-      entry = entry->next;
-      abuf_puts(abuf, "\n");
     }
+    abuf_puts(abuf, "\n");
   }
   abuf_puts(abuf, "\n");
 }
@@ -612,3 +593,90 @@ void ipc_print_interfaces(struct autobuf *abuf) {
 void ipc_print_twohop(struct autobuf *abuf) {
   ipc_print_neighbors_internal(abuf, true);
 }
+
+/* histogram bucket bounds of the Prometheus output: 2^10 ns (about 1 us) to 2^34 ns (about 17 s) */
+#define METRICS_LE_FIRST_EXP 10
+#define METRICS_LE_LAST_EXP  34
+#define METRICS_LE_STEP_EXP  2
+
+/**
+ * Print the labels of a metric, with an optional "le" label
+ */
+static void metrics_labels(struct autobuf *abuf, const struct olsr_metric *metric, const char *le) {
+  if (!metric->label_name && !le) {
+    return;
+  }
+
+  abuf_puts(abuf, "{");
+  if (metric->label_name) {
+    const char *c;
+
+    abuf_appendf(abuf, "%s=\"", metric->label_name);
+    for (c = metric->label; c && *c; c++) {
+      if (*c == '\\' || *c == '"') {
+        abuf_appendf(abuf, "\\%c", *c);
+      } else if (*c == '\n') {
+        abuf_puts(abuf, "\\n");
+      } else {
+        abuf_appendf(abuf, "%c", *c);
+      }
+    }
+    abuf_puts(abuf, "\"");
+  }
+  if (le) {
+    abuf_appendf(abuf, "%sle=\"%s\"", metric->label_name ? "," : "", le);
+  }
+  abuf_puts(abuf, "}");
+}
+
+/**
+ * Print the metrics in the Prometheus text exposition format
+ */
+void ipc_print_metrics(struct autobuf *abuf) {
+  struct olsr_metric_values values;
+  struct olsr_metric *metric;
+  const char *family = NULL;
+
+  OLSR_FOR_ALL_METRICS(metric) {
+    bool latency = metric->type == OLSR_METRIC_LATENCY;
+    const char *suffix = latency ? "_seconds" : "_total";
+
+    /* the metrics of a family are adjacent */
+    if (!family || strcmp(family, metric->name)) {
+      family = metric->name;
+      abuf_appendf(abuf, "# HELP olsrd_%s%s %s\n", metric->name, suffix, metric->help);
+      abuf_appendf(abuf, "# TYPE olsrd_%s%s %s\n", metric->name, suffix, latency ? "histogram" : "counter");
+    }
+
+    olsr_metric_read(metric, &values);
+
+    if (!latency) {
+      abuf_appendf(abuf, "olsrd_%s_total", metric->name);
+      metrics_labels(abuf, metric, NULL);
+      abuf_appendf(abuf, " %llu\n", (unsigned long long) values.count);
+    } else {
+      /* the buckets are cumulative and must add up to the count */
+      uint64_t total = olsr_metric_count_below(&values, UINT64_MAX);
+      char le[32];
+      int exp;
+
+      for (exp = METRICS_LE_FIRST_EXP; exp <= METRICS_LE_LAST_EXP; exp += METRICS_LE_STEP_EXP) {
+        snprintf(le, sizeof(le), "%.10g", (double) ((uint64_t) 1 << exp) / 1e9);
+        abuf_appendf(abuf, "olsrd_%s_seconds_bucket", metric->name);
+        metrics_labels(abuf, metric, le);
+        abuf_appendf(abuf, " %llu\n", (unsigned long long) olsr_metric_count_below(&values, (uint64_t) 1 << exp));
+      }
+      abuf_appendf(abuf, "olsrd_%s_seconds_bucket", metric->name);
+      metrics_labels(abuf, metric, "+Inf");
+      abuf_appendf(abuf, " %llu\n", (unsigned long long) total);
+
+      abuf_appendf(abuf, "olsrd_%s_seconds_sum", metric->name);
+      metrics_labels(abuf, metric, NULL);
+      abuf_appendf(abuf, " %.9f\n", (double) values.sum / 1e9);
+
+      abuf_appendf(abuf, "olsrd_%s_seconds_count", metric->name);
+      metrics_labels(abuf, metric, NULL);
+      abuf_appendf(abuf, " %llu\n", (unsigned long long) total);
+    }
+  }
+}
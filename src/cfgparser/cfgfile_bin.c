@@ -0,0 +1,818 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Binary configuration files.
+ *
+ * A binary configuration file is the configuration as the parser left it
+ * after reading a text configuration file, compiled with
+ * 'olsrd_cfgparser -compile'. Loading it copies the structures out of a
+ * mapping of the file, neither the scanner nor the parser runs. The texts
+ * of the tokens are kept to rebuild the configuration checksum, so the
+ * checksum is exactly that of the text file.
+ *
+ * A binary configuration file replaces the configuration that was loaded
+ * before it, it can not be combined with other files through several -f
+ * options.
+ */
+
+#define YYSTYPE struct conf_token *
+
+#include "olsrd_conf.h"
+#include "olsrd_conf_checksum.h"
+#include "defs.h"
+#include "oparse.h"
+#include "egressTypes.h"
+#include "common/autobuf.h"
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif /* _WIN32 */
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif /* O_BINARY */
+
+#define CNF_BIN_MAGIC           "OLSRDCNF"
+#define CNF_BIN_MAGIC_LEN       (sizeof(CNF_BIN_MAGIC) - 1)
+#define CNF_BIN_VERSION         2
+
+/* the length of an absent string */
+#define CNF_BIN_NO_STRING       0xffffffff
+
+/* all items are padded to 4 bytes */
+#define CNF_BIN_SPACE(len)      (((len) + 3) & ~(size_t)3)
+
+/*
+ * On-disk format: a header, the token texts of the configuration checksum
+ * and the configuration structures. The structures are stored as they are
+ * in memory, with their pointers replaced by the items they point to, so a
+ * file only fits the olsrd build that compiled it: the layout fingerprint
+ * covers the structure sizes, the grammar and the byte order.
+ */
+struct cnf_bin_header {
+  char magic[CNF_BIN_MAGIC_LEN];
+  uint32_t version;
+  uint32_t layout;                     /* fingerprint of the structures */
+  uint32_t size;                       /* size of the whole file */
+  uint32_t checksum;                   /* of everything behind the header */
+  uint32_t count;                      /* number of token texts */
+};
+
+/* the string members of the configuration, in file order */
+static const size_t cnf_bin_strings[] = {
+  offsetof(struct olsrd_config, pidfile),
+  offsetof(struct olsrd_config, lq_algorithm),
+  offsetof(struct olsrd_config, lock_file),
+  offsetof(struct olsrd_config, state_file),
+  offsetof(struct olsrd_config, smart_gw_instance_id),
+  offsetof(struct olsrd_config, smart_gw_policyrouting_script),
+  offsetof(struct olsrd_config, smart_gw_egress_file),
+  offsetof(struct olsrd_config, smart_gw_status_file)
+};
+
+#define CNF_BIN_STRING(cnf, i)  (*(char **)((char *)(cnf) + cnf_bin_strings[i]))
+#define CNF_BIN_CSTRING(cnf, i) (*(char * const *)((const char *)(cnf) + cnf_bin_strings[i]))
+
+/* a bounds checked position in a mapped file */
+struct cnf_bin_reader {
+  const uint8_t *buf;
+  size_t len;
+  size_t pos;
+  bool error;
+};
+
+/* the token texts that are recorded while a text file is parsed */
+static struct autobuf *record_buf = NULL;
+static uint32_t record_count = 0;
+
+static uint32_t
+cnf_bin_layout(void)
+{
+  const uint32_t sizes[] = {
+    0x01020304,                        /* byte order */
+    sizeof(void *),
+    sizeof(struct olsrd_config),
+    sizeof(struct if_config_options),
+    sizeof(struct olsr_if),
+    sizeof(struct olsr_lq_mult),
+    sizeof(struct ip_prefix_list),
+    sizeof(struct plugin_entry),
+    sizeof(struct plugin_param),
+    sizeof(struct sgw_egress_if),
+    olsrd_cnf_grammar_fingerprint()
+  };
+
+  return olsrd_config_checksum_data(sizes, sizeof(sizes));
+}
+
+static void
+cnf_bin_put(struct autobuf *abuf, const void *data, size_t len)
+{
+  static const char pad[4] = { 0, 0, 0, 0 };
+
+  abuf_memcpy(abuf, data, len);
+  abuf_memcpy(abuf, pad, CNF_BIN_SPACE(len) - len);
+}
+
+static void
+cnf_bin_put_u32(struct autobuf *abuf, uint32_t value)
+{
+  cnf_bin_put(abuf, &value, sizeof(value));
+}
+
+static void
+cnf_bin_put_string(struct autobuf *abuf, const char *string)
+{
+  if (string == NULL) {
+    cnf_bin_put_u32(abuf, CNF_BIN_NO_STRING);
+    return;
+  }
+  cnf_bin_put_u32(abuf, (uint32_t)strlen(string));
+  cnf_bin_put(abuf, string, strlen(string));
+}
+
+/**
+ * The scanner of the parser: runs the flex scanner and records the texts
+ * of the tokens when a file is compiled.
+ */
+int
+yylex(void)
+{
+  int token;
+
+  /* the scanner does not set a value for comments, so yylval would still point to a token the parser freed */
+  yylval = NULL;
+  token = olsrd_cnf_scan();
+
+  /* the scanner adds the text of all tokens but comments to the checksum */
+  if (token != 0 && token != TOK_COMMENT && record_buf != NULL) {
+    const char *text = yyget_text();
+    uint32_t len = (uint32_t)strlen(text);
+
+    /* with the terminating zero, the checksum reads one byte beyond texts of 4n bytes */
+    cnf_bin_put_u32(record_buf, len);
+    cnf_bin_put(record_buf, text, len + 1);
+    record_count++;
+  }
+  return token;
+}
+
+static void
+cnf_bin_put_if_config(struct autobuf *abuf, const struct if_config_options *ifc)
+{
+  const struct olsr_lq_mult *mult;
+  uint32_t count = 0;
+
+  cnf_bin_put(abuf, ifc, sizeof(*ifc));
+  for (mult = ifc->lq_mult; mult != NULL; mult = mult->next) {
+    count++;
+  }
+  cnf_bin_put_u32(abuf, count);
+  for (mult = ifc->lq_mult; mult != NULL; mult = mult->next) {
+    cnf_bin_put(abuf, mult, sizeof(*mult));
+  }
+}
+
+static void
+cnf_bin_put_prefixes(struct autobuf *abuf, const struct ip_prefix_list *list)
+{
+  const struct ip_prefix_list *entry;
+  uint32_t count = 0;
+
+  for (entry = list; entry != NULL; entry = entry->next) {
+    count++;
+  }
+  cnf_bin_put_u32(abuf, count);
+  for (entry = list; entry != NULL; entry = entry->next) {
+    cnf_bin_put(abuf, &entry->net, sizeof(entry->net));
+  }
+}
+
+/* append the configuration structures to a binary configuration file */
+static void
+cnf_bin_put_cnf(struct autobuf *abuf, const struct olsrd_config *cnf)
+{
+  const struct olsr_if *in;
+  const struct plugin_entry *pe;
+  const struct plugin_param *pp;
+  const struct sgw_egress_if *egress;
+  uint32_t count;
+  size_t i;
+
+  cnf_bin_put(abuf, cnf, sizeof(*cnf));
+  for (i = 0; i < ARRAYSIZE(cnf_bin_strings); i++) {
+    cnf_bin_put_string(abuf, CNF_BIN_CSTRING(cnf, i));
+  }
+
+  cnf_bin_put_u32(abuf, cnf->interface_defaults != NULL);
+  if (cnf->interface_defaults != NULL) {
+    cnf_bin_put_if_config(abuf, cnf->interface_defaults);
+  }
+
+  for (count = 0, in = cnf->interfaces; in != NULL; in = in->next) {
+    count++;
+  }
+  cnf_bin_put_u32(abuf, count);
+  for (in = cnf->interfaces; in != NULL; in = in->next) {
+    cnf_bin_put_string(abuf, in->name);
+    cnf_bin_put(abuf, in, sizeof(*in));
+    cnf_bin_put_if_config(abuf, in->cnf);
+    /* the parser points the inverted configuration to the same multipliers */
+    cnf_bin_put(abuf, in->cnfi, sizeof(*in->cnfi));
+    cnf_bin_put_u32(abuf, in->cnfi->lq_mult == in->cnf->lq_mult);
+  }
+
+  cnf_bin_put_prefixes(abuf, cnf->hna_entries);
+  cnf_bin_put_prefixes(abuf, cnf->ipc_nets);
+
+  for (count = 0, pe = cnf->plugins; pe != NULL; pe = pe->next) {
+    count++;
+  }
+  cnf_bin_put_u32(abuf, count);
+  for (pe = cnf->plugins; pe != NULL; pe = pe->next) {
+    cnf_bin_put_string(abuf, pe->name);
+    for (count = 0, pp = pe->params; pp != NULL; pp = pp->next) {
+      count++;
+    }
+    cnf_bin_put_u32(abuf, count);
+    for (pp = pe->params; pp != NULL; pp = pp->next) {
+      cnf_bin_put_string(abuf, pp->key);
+      cnf_bin_put_string(abuf, pp->value);
+    }
+  }
+
+  for (count = 0, egress = cnf->smart_gw_egress_interfaces; egress != NULL; egress = egress->next) {
+    count++;
+  }
+  cnf_bin_put_u32(abuf, count);
+  for (egress = cnf->smart_gw_egress_interfaces; egress != NULL; egress = egress->next) {
+    cnf_bin_put(abuf, egress, sizeof(*egress));
+    cnf_bin_put_string(abuf, egress->name);
+  }
+}
+
+/* @return the next len bytes of the file, NULL when it is too short */
+static const void *
+cnf_bin_get(struct cnf_bin_reader *r, size_t len)
+{
+  const void *data;
+
+  if (r->error || CNF_BIN_SPACE(len) > r->len - r->pos) {
+    r->error = true;
+    return NULL;
+  }
+  data = r->buf + r->pos;
+  r->pos += CNF_BIN_SPACE(len);
+  return data;
+}
+
+static uint32_t
+cnf_bin_get_u32(struct cnf_bin_reader *r)
+{
+  const void *data = cnf_bin_get(r, sizeof(uint32_t));
+  uint32_t value = 0;
+
+  if (data != NULL) {
+    memcpy(&value, data, sizeof(value));
+  }
+  return value;
+}
+
+/* @return a copy of the next string, NULL when it is absent or on errors */
+static char *
+cnf_bin_get_string(struct cnf_bin_reader *r)
+{
+  uint32_t len = cnf_bin_get_u32(r);
+  const char *data;
+  char *string;
+
+  if (len == CNF_BIN_NO_STRING) {
+    return NULL;
+  }
+  data = cnf_bin_get(r, len);
+  if (data == NULL) {
+    return NULL;
+  }
+  string = malloc(len + 1);
+  if (string == NULL) {
+    r->error = true;
+    return NULL;
+  }
+  memcpy(string, data, len);
+  string[len] = '\0';
+  return string;
+}
+
+/* @return a copy of the next structure, NULL on errors */
+static void *
+cnf_bin_get_copy(struct cnf_bin_reader *r, size_t len)
+{
+  const void *data = cnf_bin_get(r, len);
+  void *copy;
+
+  if (data == NULL) {
+    return NULL;
+  }
+  copy = malloc(len);
+  if (copy == NULL) {
+    r->error = true;
+    return NULL;
+  }
+  memcpy(copy, data, len);
+  return copy;
+}
+
+static struct if_config_options *
+cnf_bin_get_if_config(struct cnf_bin_reader *r)
+{
+  struct if_config_options *ifc = cnf_bin_get_copy(r, sizeof(*ifc));
+  struct olsr_lq_mult **tail;
+  uint32_t count;
+
+  if (ifc == NULL) {
+    return NULL;
+  }
+  ifc->lq_mult = NULL;
+  tail = &ifc->lq_mult;
+  for (count = cnf_bin_get_u32(r); count > 0 && !r->error; count--) {
+    struct olsr_lq_mult *mult = cnf_bin_get_copy(r, sizeof(*mult));
+
+    if (mult != NULL) {
+      mult->next = NULL;
+      *tail = mult;
+      tail = &mult->next;
+    }
+  }
+  return ifc;
+}
+
+static void
+cnf_bin_get_prefixes(struct cnf_bin_reader *r, struct ip_prefix_list **list)
+{
+  uint32_t count;
+
+  for (count = cnf_bin_get_u32(r); count > 0 && !r->error; count--) {
+    const void *net = cnf_bin_get(r, sizeof(struct olsr_ip_prefix));
+    struct ip_prefix_list *entry;
+
+    if (net == NULL) {
+      break;
+    }
+    entry = malloc(sizeof(*entry));
+    if (entry == NULL) {
+      r->error = true;
+      break;
+    }
+    memcpy(&entry->net, net, sizeof(entry->net));
+    entry->next = NULL;
+    *list = entry;
+    list = &entry->next;
+  }
+}
+
+/**
+ * Read the configuration structures of a binary configuration file.
+ *
+ * @return the configuration, its configuration_file is NULL; NULL on errors
+ */
+static struct olsrd_config *
+cnf_bin_get_cnf(struct cnf_bin_reader *r)
+{
+  struct olsrd_config *cnf = cnf_bin_get_copy(r, sizeof(*cnf));
+  struct olsr_if **if_tail;
+  struct plugin_entry **pe_tail;
+  struct sgw_egress_if **egress_tail;
+  uint32_t count, params;
+  size_t i;
+
+  if (cnf == NULL) {
+    return NULL;
+  }
+
+  /* none of the pointers of the compiling process are valid here */
+  cnf->configuration_file = NULL;
+  for (i = 0; i < ARRAYSIZE(cnf_bin_strings); i++) {
+    CNF_BIN_STRING(cnf, i) = NULL;
+  }
+  cnf->plugins = NULL;
+  cnf->hna_entries = NULL;
+  cnf->ipc_nets = NULL;
+  cnf->interface_defaults = NULL;
+  cnf->interfaces = NULL;
+  cnf->smart_gw_egress_interfaces = NULL;
+  cnf->pud_position = NULL;
+
+  for (i = 0; i < ARRAYSIZE(cnf_bin_strings); i++) {
+    CNF_BIN_STRING(cnf, i) = cnf_bin_get_string(r);
+  }
+
+  if (cnf_bin_get_u32(r)) {
+    cnf->interface_defaults = cnf_bin_get_if_config(r);
+  }
+
+  if_tail = &cnf->interfaces;
+  for (count = cnf_bin_get_u32(r); count > 0 && !r->error; count--) {
+    char *name = cnf_bin_get_string(r);
+    struct olsr_if *in = cnf_bin_get_copy(r, sizeof(*in));
+
+    if (in == NULL) {
+      free(name);
+      break;
+    }
+    in->name = name;
+    in->interf = NULL;
+    in->next = NULL;
+    in->cnf = cnf_bin_get_if_config(r);
+    in->cnfi = cnf_bin_get_copy(r, sizeof(*in->cnfi));
+    *if_tail = in;
+    if_tail = &in->next;
+    if (cnf_bin_get_u32(r) && in->cnfi != NULL && in->cnf != NULL) {
+      in->cnfi->lq_mult = in->cnf->lq_mult;
+    }
+    if (in->name == NULL || in->cnf == NULL || in->cnfi == NULL) {
+      /* olsrd_free_cnf() needs all of them */
+      r->error = true;
+    }
+  }
+
+  cnf_bin_get_prefixes(r, &cnf->hna_entries);
+  cnf_bin_get_prefixes(r, &cnf->ipc_nets);
+
+  pe_tail = &cnf->plugins;
+  for (count = cnf_bin_get_u32(r); count > 0 && !r->error; count--) {
+    struct plugin_entry *pe = malloc(sizeof(*pe));
+    struct plugin_param **pp_tail;
+
+    if (pe == NULL) {
+      r->error = true;
+      break;
+    }
+    pe->name = cnf_bin_get_string(r);
+    pe->params = NULL;
+    pe->next = NULL;
+    *pe_tail = pe;
+    pe_tail = &pe->next;
+
+    pp_tail = &pe->params;
+    for (params = cnf_bin_get_u32(r); params > 0 && !r->error; params--) {
+      struct plugin_param *pp = malloc(sizeof(*pp));
+
+      if (pp == NULL) {
+        r->error = true;
+        break;
+      }
+      pp->key = cnf_bin_get_string(r);
+      pp->value = cnf_bin_get_string(r);
+      pp->next = NULL;
+      *pp_tail = pp;
+      pp_tail = &pp->next;
+    }
+  }
+
+  egress_tail = &cnf->smart_gw_egress_interfaces;
+  for (count = cnf_bin_get_u32(r); count > 0 && !r->error; count--) {
+    struct sgw_egress_if *egress = cnf_bin_get_copy(r, sizeof(*egress));
+
+    if (egress == NULL) {
+      break;
+    }
+    egress->next = NULL;
+    egress->name = cnf_bin_get_string(r);
+    *egress_tail = egress;
+    egress_tail = &egress->next;
+  }
+
+  if (r->pos != r->len) {
+    r->error = true;
+  }
+  if (r->error) {
+    olsrd_free_cnf(&cnf);
+  }
+  return cnf;
+}
+
+static bool
+cnf_bin_has_magic(int fd)
+{
+  char magic[CNF_BIN_MAGIC_LEN];
+
+  return read(fd, magic, sizeof(magic)) == (ssize_t)sizeof(magic) && memcmp(magic, CNF_BIN_MAGIC, sizeof(magic)) == 0;
+}
+
+/**
+ * Take over the configuration of a binary configuration file: add its
+ * token texts to the configuration checksum and replace the contents of
+ * cnf with its structures.
+ *
+ * @return a message describing the problem, NULL on success
+ */
+static const char *
+cnf_bin_apply(const uint8_t *buf, size_t len, struct olsrd_config *cnf)
+{
+  const struct cnf_bin_header *hdr = (const struct cnf_bin_header *)buf;
+  struct cnf_bin_reader r;
+  struct olsrd_config *loaded, *old;
+  uint32_t i;
+
+  if (hdr->version != CNF_BIN_VERSION || hdr->layout != cnf_bin_layout()) {
+    return "it was compiled by another version of olsrd_cfgparser, recompile it";
+  }
+  if (hdr->size != len) {
+    return "it is truncated";
+  }
+  if (hdr->checksum != olsrd_config_checksum_data(buf + sizeof(*hdr), len - sizeof(*hdr))) {
+    return "it is corrupt";
+  }
+
+  memset(&r, 0, sizeof(r));
+  r.buf = buf;
+  r.len = len;
+  r.pos = sizeof(*hdr);
+
+  /* the checksum covers the token texts only, check them before adding any */
+  for (i = 0; i < hdr->count && !r.error; i++) {
+    const char *text;
+    uint32_t text_len = cnf_bin_get_u32(&r);
+
+    text = text_len < len ? cnf_bin_get(&r, text_len + 1) : NULL;
+    if (text == NULL || text[text_len] != '\0') {
+      r.error = true;
+    }
+  }
+  if (r.error) {
+    return "it is corrupt";
+  }
+
+  loaded = cnf_bin_get_cnf(&r);
+  if (loaded == NULL) {
+    return "it is corrupt";
+  }
+
+  r.pos = sizeof(*hdr);
+  for (i = 0; i < hdr->count; i++) {
+    uint32_t text_len = cnf_bin_get_u32(&r);
+
+    olsrd_config_checksum_add(cnf_bin_get(&r, text_len + 1), text_len);
+  }
+
+  /* release what was loaded before, keep the name of the file */
+  old = malloc(sizeof(*old));
+  if (old != NULL) {
+    *old = *cnf;
+    old->configuration_file = NULL;
+    olsrd_free_cnf(&old);
+  }
+  loaded->configuration_file = cnf->configuration_file;
+  *cnf = *loaded;
+  free(loaded);
+  return NULL;
+}
+
+/**
+ * Load a binary configuration file into a configuration. Text files are
+ * left to the scanner.
+ *
+ * @param filename the configuration file
+ * @param cnf the configuration to replace
+ * @return 1 if a binary configuration file was loaded, 0 if it is a text
+ * file, -1 on errors
+ */
+int
+olsrd_cnf_bin_load(const char *filename, struct olsrd_config *cnf)
+{
+  const char *problem;
+  struct stat st;
+  uint8_t *buf;
+  size_t len;
+  int fd;
+
+  fd = open(filename, O_RDONLY | O_BINARY);
+  if (fd < 0) {
+    fprintf(stderr, "Cannot open configuration file '%s': %s.\n", filename, strerror(errno));
+    return -1;
+  }
+
+  if (!cnf_bin_has_magic(fd)) {
+    close(fd);
+    return 0;
+  }
+
+  if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(struct cnf_bin_header)) {
+    fprintf(stderr, "Binary configuration file '%s' is truncated.\n", filename);
+    close(fd);
+    return -1;
+  }
+  len = (size_t)st.st_size;
+
+#ifndef _WIN32
+  buf = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (buf == MAP_FAILED) {
+    fprintf(stderr, "Cannot map binary configuration file '%s': %s.\n", filename, strerror(errno));
+    return -1;
+  }
+#else /* _WIN32 */
+  {
+    size_t done = 0;
+
+    buf = malloc(len);
+    if (buf == NULL || lseek(fd, 0, SEEK_SET) < 0) {
+      free(buf);
+      close(fd);
+      return -1;
+    }
+    while (done < len) {
+      int n = read(fd, buf + done, len - done);
+      if (n <= 0) {
+        break;
+      }
+      done += (size_t)n;
+    }
+    close(fd);
+    if (done != len) {
+      fprintf(stderr, "Cannot read binary configuration file '%s'.\n", filename);
+      free(buf);
+      return -1;
+    }
+  }
+#endif /* _WIN32 */
+
+  problem = cnf_bin_apply(buf, len, cnf);
+
+#ifndef _WIN32
+  munmap(buf, len);
+#else /* _WIN32 */
+  free(buf);
+#endif /* _WIN32 */
+
+  if (problem != NULL) {
+    fprintf(stderr, "Cannot use binary configuration file '%s': %s.\n", filename, problem);
+    return -1;
+  }
+  return 1;
+}
+
+static int
+cnf_bin_write(const char *fname, const char *buf, size_t len)
+{
+  char tmp[FILENAME_MAX];
+  ssize_t written;
+  int fd;
+
+  snprintf(tmp, sizeof(tmp), "%s.tmp", fname);
+
+  fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (fd < 0) {
+    fprintf(stderr, "Could not open file %s for writing\n%s\n", tmp, strerror(errno));
+    return -1;
+  }
+
+  while (len > 0) {
+    written = write(fd, buf, len);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      fprintf(stderr, "Could not write file %s\n%s\n", tmp, strerror(errno));
+      close(fd);
+      unlink(tmp);
+      return -1;
+    }
+    buf += written;
+    len -= (size_t)written;
+  }
+
+  if (close(fd) < 0) {
+    unlink(tmp);
+    return -1;
+  }
+
+#ifdef _WIN32
+  /* rename does not replace an existing file */
+  unlink(fname);
+#endif /* _WIN32 */
+  if (rename(tmp, fname) < 0) {
+    fprintf(stderr, "Could not rename %s to %s\n%s\n", tmp, fname, strerror(errno));
+    unlink(tmp);
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * Compile a text configuration file into a binary configuration file.
+ * The text file is parsed into olsr_cnf on the way.
+ *
+ * @param conffile the text configuration file
+ * @param binfile the binary configuration file to write
+ * @return 0 on success, -1 on errors
+ */
+int
+olsrd_compile_cnf(const char *conffile, const char *binfile)
+{
+  struct cnf_bin_header hdr;
+  struct autobuf abuf;
+  int fd, rc;
+
+  fd = open(conffile, O_RDONLY | O_BINARY);
+  if (fd >= 0) {
+    bool binary = cnf_bin_has_magic(fd);
+
+    close(fd);
+    if (binary) {
+      fprintf(stderr, "'%s' is already a binary configuration file.\n", conffile);
+      return -1;
+    }
+  }
+
+  if (abuf_init(&abuf, AUTOBUFCHUNK) < 0) {
+    return -1;
+  }
+
+  /* room for the header */
+  memset(&hdr, 0, sizeof(hdr));
+  abuf_memcpy(&abuf, &hdr, sizeof(hdr));
+
+  record_buf = &abuf;
+  record_count = 0;
+  rc = olsrd_parse_cnf(conffile);
+  record_buf = NULL;
+
+  if (rc == 0) {
+    cnf_bin_put_cnf(&abuf, olsr_cnf);
+
+    memcpy(hdr.magic, CNF_BIN_MAGIC, sizeof(hdr.magic));
+    hdr.version = CNF_BIN_VERSION;
+    hdr.layout = cnf_bin_layout();
+    hdr.size = (uint32_t)abuf.len;
+    hdr.checksum = olsrd_config_checksum_data(abuf.buf + sizeof(hdr), abuf.len - sizeof(hdr));
+    hdr.count = record_count;
+    memcpy(abuf.buf, &hdr, sizeof(hdr));
+
+    printf("Writing the configuration of %u tokens to file \"%s\".... ", record_count, binfile);
+    rc = cnf_bin_write(binfile, abuf.buf, (size_t)abuf.len);
+    printf(rc == 0 ? "DONE\n" : "FAILED\n");
+  }
+
+  abuf_free(&abuf);
+  return rc;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
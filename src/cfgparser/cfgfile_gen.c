@@ -393,6 +393,49 @@ void olsrd_write_cnf_autobuf_uncached(struct autobuf *out, struct olsrd_config *
         cnf->lock_file);
     free(lockfile_default);
   }
+  abuf_puts(out,
+    "\n"
+    "# StateFile\n"
+    "# Checkpoint of the topology, MID, HNA and duplicate sets and of the\n"
+    "# installed routes. It is written periodically and on shutdown, and\n"
+    "# loaded on startup so that the topology is known right after a restart.\n"
+    "# (default is none)\n"
+    "\n");
+  abuf_appendf(out, "%sStateFile \"%s\"\n",
+      !cnf->state_file ? "# " : "",
+      cnf->state_file ? cnf->state_file : "/var/run/olsrd.state");
+  abuf_appendf(out,
+    "\n"
+    "# Interval to write the state file (in seconds), 0 writes it only on\n"
+    "# shutdown.\n"
+    "# (default is %.1f)\n"
+    "\n", (double)DEF_STATE_INTERVAL);
+  abuf_appendf(out, "%sStateInterval  %.1f\n",
+      cnf->state_interval == (float)DEF_STATE_INTERVAL ? "# " : "",
+      (double)cnf->state_interval);
+  abuf_appendf(out,
+    "\n"
+    "# Keep the routes in the kernel when olsrd shuts down (yes/no).\n"
+    "# On the next start the routes found in the kernel are adopted and\n"
+    "# only routes that differ are changed. Routes that are not confirmed\n"
+    "# within one HELLO validity time are removed.\n"
+    "# (default is %s)\n"
+    "\n", DEF_KEEP_ROUTES ? "yes" : "no");
+  abuf_appendf(out, "%sKeepRoutes     %s\n",
+      cnf->keep_routes == DEF_KEEP_ROUTES ? "# " : "",
+      cnf->keep_routes ? "yes" : "no");
+  abuf_appendf(out,
+    "\n"
+    "# Record latency histograms and counters of the hot paths (yes/no):\n"
+    "# the processing of received messages, the duplicate check, the\n"
+    "# routing table calculation, the timers, the packet output, the\n"
+    "# kernel routes and the socket handlers. The info plugins report\n"
+    "# them with the metrics command.\n"
+    "# (default is %s)\n"
+    "\n", DEF_METRICS ? "yes" : "no");
+  abuf_appendf(out, "%sMetrics        %s\n",
+      cnf->metrics == DEF_METRICS ? "# " : "",
+      cnf->metrics ? "yes" : "no");
   abuf_appendf(out,
     "\n"
     "# Polling rate for OLSR sockets in seconds (float).\n"
@@ -726,8 +769,10 @@ void olsrd_write_cnf_autobuf_uncached(struct autobuf *out, struct olsrd_config *
     "\n"
     "# Determines the policy routing script that is executed during startup and\n"
     "# shutdown of olsrd. The script is only executed when SmartGatewayUseCount\n"
-    "# is set to a value larger than 1. The script must setup policy routing\n"
-    "# rules such that multi-gateway mode works. A sample script is included.\n"
+    "# is set to a value larger than 1. olsrd sets up the ip rules of the\n"
+    "# multi-gateway mode itself, the script must setup the iptables connection\n"
+    "# marking that the fwmark rules rely on. olsrd does not start when the\n"
+    "# script fails. A sample script is included.\n"
     "# (default is <not set>)\n"
     "\n");
   abuf_appendf(out, "%sSmartGatewayPolicyRoutingScript %s%s%s\n",
@@ -784,7 +829,9 @@ void olsrd_write_cnf_autobuf_uncached(struct autobuf *out, struct olsrd_config *
   abuf_appendf(out,
     "\n"
     "# Determines the period (in milliseconds) on which the SmartGatewayEgressFile\n"
-    "# is checked for changes and processed if changed.\n"
+    "# is checked for changes and processed if changed. Only used when the\n"
+    "# directory of the file can't be watched for changes (inotify), otherwise the\n"
+    "# file is processed as soon as it is written or renamed into place.\n"
     "# (default is %u)\n"
     "\n", DEF_GW_EGRESS_FILE_PERIOD);
   abuf_appendf(out, "%sSmartGatewayEgressFilePeriod %u\n",
@@ -1094,6 +1141,33 @@ void olsrd_write_cnf_autobuf_uncached(struct autobuf *out, struct olsrd_config *
   abuf_appendf(out, "%sLinkQualityAging %.2f\n",
       cnf->lq_aging == (float)DEF_LQ_AGING ? "# " : "",
       (double)cnf->lq_aging);
+  abuf_appendf(out,
+    "\n"
+    "# Link quality smoothing (only for lq level 2)\n"
+    "# Filter used by etx_float and etx_fpm to smooth the\n"
+    "# received hellos into a link quality.\n"
+    "# - \"ewma\", exponential moving average with LinkQualityAging\n"
+    "# - \"window\", average over the last hellos, the window length\n"
+    "#   is derived from LinkQualityAging\n"
+    "# - \"kalman\", a kalman estimator, fast after link setup and\n"
+    "#   as smooth as \"ewma\" afterwards\n"
+    "# (default is \"%s\")\n"
+    "\n", LQ_SMOOTHING_TXT[DEF_LQ_SMOOTHING]);
+  abuf_appendf(out, "%sLinkQualitySmoothing \"%s\"\n",
+      cnf->lq_smoothing == DEF_LQ_SMOOTHING ? "# " : "",
+      LQ_SMOOTHING_TXT[cnf->lq_smoothing]);
+  abuf_appendf(out,
+    "\n"
+    "# Link quality relevant change (only for lq level 2)\n"
+    "# Minimal change of a link quality or link cost (in percent)\n"
+    "# that triggers a recalculation of the routing table.\n"
+    "# Smaller changes are ignored to prevent route flapping.\n"
+    "# (allowed values are between 0 and 100)\n"
+    "# (default is %u)\n"
+    "\n", DEF_LQ_RELEVANT_CHANGE);
+  abuf_appendf(out, "%sLinkQualityRelevantChange %u\n",
+      cnf->lq_relevant_change == DEF_LQ_RELEVANT_CHANGE ? "# " : "",
+      cnf->lq_relevant_change);
   abuf_appendf(out,
     "\n"
     "# Fisheye mechanism for TCs (0 meansoff, 1 means on)\n"
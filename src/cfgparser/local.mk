@@ -45,8 +45,8 @@
 C=$(if $(CFGDIR),$(CFGDIR)/)
 
 # add the variables as we may have others already there
-SRCS += $(foreach file,olsrd_conf olsrd_conf_checksum oparse oscan cfgfile_gen,$(C)$(file).c)
-OBJS += $(foreach file,olsrd_conf olsrd_conf_checksum oparse oscan cfgfile_gen,$(C)$(file).o)
+SRCS += $(foreach file,olsrd_conf olsrd_conf_checksum oparse oscan cfgfile_gen cfgfile_bin,$(C)$(file).c)
+OBJS += $(foreach file,olsrd_conf olsrd_conf_checksum oparse oscan cfgfile_gen cfgfile_bin,$(C)$(file).o)
 HDRS += $(foreach file,olsrd_conf olsrd_conf_checksum oparse,$(C)$(file).h)
 
 $(C)oscan.c: $(C)oscan.lex $(C)Makefile
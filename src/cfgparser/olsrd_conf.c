@@ -89,6 +89,12 @@ const char *FIB_METRIC_TXT[] = {
   "approx",
 };
 
+const char *LQ_SMOOTHING_TXT[] = {
+  "ewma",
+  "window",
+  "kalman",
+};
+
 const char *GW_UPLINK_TXT[] = {
   "none",
   "ipv4",
@@ -115,12 +121,21 @@ int
 main(int argc, char *argv[])
 {
   if (argc < 2) {
-    fprintf(stderr, "Usage: olsrd_cfgparser filename [-print]\n\n");
+    fprintf(stderr, "Usage: olsrd_cfgparser filename [-print | -compile binfile]\n\n");
     exit(EXIT_FAILURE);
   }
 
   olsr_cnf = olsrd_get_default_cnf(strdup(argv[1]));
 
+  if ((argc > 3) && (!strcmp(argv[2], "-compile"))) {
+    if (olsrd_compile_cnf(argv[1], argv[3]) < 0) {
+      printf("Failed compiling \"%s\"\n", argv[1]);
+      exit(EXIT_FAILURE);
+    }
+    printf("Configfile compiled OK\n");
+    return 0;
+  }
+
   if (olsrd_parse_cnf(argv[1]) == 0) {
     if ((argc > 2) && (!strcmp(argv[2], "-print"))) {
       olsrd_print_cnf(olsr_cnf);
@@ -243,10 +258,16 @@ int
 olsrd_parse_cnf(const char *filename)
 {
   struct olsr_if *in, *new_ifqueue;
-  int rc;
+  int binary, rc;
 
   fprintf(stderr, "Parsing file: \"%s\"\n", filename);
 
+  /* a binary configuration file holds the configuration as parsed below */
+  binary = olsrd_cnf_bin_load(filename, olsr_cnf);
+  if (binary != 0) {
+    return binary < 0 ? -1 : 0;
+  }
+
   yyin = fopen(filename, "r");
   if (yyin == NULL) {
     fprintf(stderr, "Cannot open configuration file '%s': %s.\n", filename, strerror(errno));
@@ -604,6 +625,12 @@ olsrd_sanity_check_cnf(struct olsrd_config *cnf)
     return -1;
   }
 
+  /* State checkpoint interval, 0 means only on shutdown */
+  if (cnf->state_interval != 0.0f && cnf->state_interval < (float)MIN_STATE_INTERVAL) {
+    fprintf(stderr, "State interval %0.2f is not allowed\n", (double)cnf->state_interval);
+    return -1;
+  }
+
   /* TC redundancy */
   if (cnf->tc_redundancy != 2) {
     fprintf(stderr, "Sorry, tc-redundancy 0/1 are not working on 0.5.6. "
@@ -640,6 +667,12 @@ olsrd_sanity_check_cnf(struct olsrd_config *cnf)
     return -1;
   }
 
+  /* Link cost change that triggers a route recalculation */
+  if (cnf->lq_level && cnf->lq_relevant_change > MAX_LQ_RELEVANT_CHANGE) {
+    fprintf(stderr, "LQ relevant change %d is not allowed\n", cnf->lq_relevant_change);
+    return -1;
+  }
+
   /* NAT threshold value */
   if (cnf->lq_level && (cnf->lq_nat_thresh < 0.1f || cnf->lq_nat_thresh > 1.0f)) {
     fprintf(stderr, "NAT threshold %f is not allowed\n", (double)cnf->lq_nat_thresh);
@@ -1018,6 +1051,9 @@ olsrd_free_cnf(struct olsrd_config **cnfVariableAddress)
   free(cnf->lock_file);
   cnf->lock_file = NULL;
 
+  free(cnf->state_file);
+  cnf->state_file = NULL;
+
   free(cnf->lq_algorithm);
   cnf->lq_algorithm = NULL;
 
@@ -1123,12 +1159,18 @@ set_default_cnf(struct olsrd_config *cnf, char * configuration_file)
   cnf->lq_fish = DEF_LQ_FISH;
   cnf->lq_aging = DEF_LQ_AGING;
   cnf->lq_algorithm = NULL;
+  cnf->lq_smoothing = DEF_LQ_SMOOTHING;
+  cnf->lq_relevant_change = DEF_LQ_RELEVANT_CHANGE;
 
   cnf->min_tc_vtime = 0.0;
 
   cnf->set_ip_forward = true;
 
   cnf->lock_file = NULL; /* derived config */
+  cnf->state_file = NULL;
+  cnf->state_interval = DEF_STATE_INTERVAL;
+  cnf->keep_routes = DEF_KEEP_ROUTES;
+  cnf->metrics = DEF_METRICS;
   cnf->use_niit = DEF_USE_NIIT;
 
   cnf->smart_gw_active = DEF_SMART_GW;
@@ -1275,6 +1317,12 @@ olsrd_print_cnf(struct olsrd_config *cnf)
 
   printf("NIC ChangPollrate: %0.2f\n", (double)cnf->nic_chgs_pollrate);
 
+  if (cnf->state_file) {
+    printf("State file       : %s (every %0.1f s)\n", cnf->state_file, (double)cnf->state_interval);
+  }
+  printf("Keep routes      : %s\n", cnf->keep_routes ? "yes" : "no");
+  printf("Metrics          : %s\n", cnf->metrics ? "yes" : "no");
+
   printf("TC redundancy    : %d\n", cnf->tc_redundancy);
 
   printf("MPR coverage     : %d\n", cnf->mpr_coverage);
@@ -1287,6 +1335,10 @@ olsrd_print_cnf(struct olsrd_config *cnf)
 
   printf("LQ algorithm name: %s\n", cnf->lq_algorithm ? cnf->lq_algorithm : "default");
 
+  printf("LQ smoothing     : %s\n", LQ_SMOOTHING_TXT[cnf->lq_smoothing]);
+
+  printf("LQ relevant chg  : %d%%\n", cnf->lq_relevant_change);
+
   printf("NAT threshold    : %f\n", (double)cnf->lq_nat_thresh);
 
   printf("Clear screen     : %s\n", cnf->clear_screen ? "yes" : "no");
@@ -65,6 +65,17 @@ struct conf_token {
 
 bool loadConfig(int *argc, char *argv[]);
 
+/* the flex scanner, the parser gets its tokens through yylex() in cfgfile_bin.c */
+int olsrd_cnf_scan(void);
+
+int yylex(void);
+
+char *yyget_text(void);
+
+uint32_t olsrd_cnf_grammar_fingerprint(void);
+
+int olsrd_cnf_bin_load(const char *filename, struct olsrd_config *cnf);
+
 void set_default_cnf(struct olsrd_config *, char * configuration_file);
 
 void ip_prefix_list_clear(struct ip_prefix_list **list);
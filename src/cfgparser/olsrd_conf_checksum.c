@@ -54,6 +54,7 @@
 
 static uint32_t configuration_checksum;
 static char configuration_checksum_str[(sizeof(configuration_checksum) * 2) + 1];
+static uint32_t configuration_checksum_saved;
 
 #define CLI_START     "*CLI START*"
 #define CLI_START_LEN (sizeof(CLI_START) - 1)
@@ -80,6 +81,16 @@ void olsrd_config_checksum_get(size_t *len, char ** str) {
   }
 }
 
+/* keep the checksum of the running configuration while a new one is parsed */
+void olsrd_config_checksum_save(void) {
+  configuration_checksum_saved = configuration_checksum;
+}
+
+void olsrd_config_checksum_restore(void) {
+  configuration_checksum = configuration_checksum_saved;
+  olsrd_config_checksum_final();
+}
+
 void olsrd_config_checksum_add_cli(int argc, char *argv[]) {
   int i = 1;
 
@@ -108,3 +119,14 @@ void olsrd_config_checksum_add(const char *str, size_t len) {
   configuration_checksum = hash_inc(str, len, configuration_checksum);
   configuration_checksum = hash_inc("\n", 1, configuration_checksum);
 }
+
+/* checksum a block of data the way the configuration is checksummed */
+uint32_t olsrd_config_checksum_data(const void *data, size_t len) {
+  const char *bytes = data;
+
+  /* hash_inc() reads one byte beyond blocks of 4n bytes */
+  if (len > 0 && (len & 3) == 0) {
+    return hash_inc(bytes + len - 1, 1, hash_inc(bytes, len - 1, 0));
+  }
+  return hash_inc(bytes, len, 0);
+}
@@ -66,4 +66,10 @@ void olsrd_config_checksum_final(void);
 
 void olsrd_config_checksum_get(size_t *len, char ** str);
 
+void olsrd_config_checksum_save(void);
+
+void olsrd_config_checksum_restore(void);
+
+uint32_t olsrd_config_checksum_data(const void *data, size_t len);
+
 #endif /* _OLSRD_CONF_CHECKSUM_H */
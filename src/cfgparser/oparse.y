@@ -53,6 +53,7 @@
 #include "olsr.h"
 #include "egressTypes.h"
 #include "gateway.h"
+#include "superfasthash.h"
 
 #include <stddef.h>
 #include <stdio.h>
@@ -170,6 +171,9 @@ static int add_ipv6_addr(YYSTYPE ipaddr_arg, YYSTYPE prefixlen_arg)
 
 %}
 
+/* yytname is the fingerprint of the grammar for binary configuration files */
+%token-table
+
 %token TOK_SLASH
 %token TOK_OPEN
 %token TOK_CLOSE
@@ -214,6 +218,8 @@ static int add_ipv6_addr(YYSTYPE ipaddr_arg, YYSTYPE prefixlen_arg)
 %token TOK_LQ_LEVEL
 %token TOK_LQ_FISH
 %token TOK_LQ_AGING
+%token TOK_LQ_SMOOTHING
+%token TOK_LQ_RELEVANT_CHANGE
 %token TOK_LQ_PLUGIN
 %token TOK_LQ_NAT_THRESH
 %token TOK_LQ_MULT
@@ -221,6 +227,10 @@ static int add_ipv6_addr(YYSTYPE ipaddr_arg, YYSTYPE prefixlen_arg)
 %token TOK_PLPARAM
 %token TOK_MIN_TC_VTIME
 %token TOK_LOCK_FILE
+%token TOK_STATE_FILE
+%token TOK_STATE_INTERVAL
+%token TOK_KEEP_ROUTES
+%token TOK_METRICS
 %token TOK_USE_NIIT
 %token TOK_SMART_GW
 %token TOK_SMART_GW_ALWAYS_REMOVE_SERVER_TUNNEL
@@ -317,10 +327,16 @@ stmt:       idebug
           | alq_fish
           | anat_thresh
           | alq_aging
+          | alq_smoothing
+          | alq_relevant_change
           | bclear_screen
           | vcomment
           | amin_tc_vtime
           | alock_file
+          | sstate_file
+          | fstate_interval
+          | bkeep_routes
+          | bmetrics
           | suse_niit
           | bsmart_gw
           | bsmart_gw_always_remove_server_tunnel
@@ -1289,6 +1305,37 @@ alq_aging: TOK_LQ_AGING TOK_FLOAT
 }
 ;
 
+alq_smoothing: TOK_LQ_SMOOTHING TOK_STRING
+{
+  int i;
+  PARSER_DEBUG_PRINTF("Link quality smoothing %s\n", $2->string);
+  for (i=0; i<LQS_CNT; i++) {
+    if (strcmp($2->string, LQ_SMOOTHING_TXT[i]) == 0) {
+      olsr_cnf->lq_smoothing = i;
+      break;
+    }
+  }
+  if (i == LQS_CNT) {
+    fprintf(stderr, "Bad LinkQualitySmoothing value: %s\n", $2->string);
+    YYABORT;
+  }
+  free($2->string);
+  free($2);
+}
+;
+
+alq_relevant_change: TOK_LQ_RELEVANT_CHANGE TOK_INTEGER
+{
+  PARSER_DEBUG_PRINTF("Link quality relevant change %d%%\n", $2->integer);
+  if ((int32_t)$2->integer < 0 || $2->integer > MAX_LQ_RELEVANT_CHANGE) {
+    fprintf(stderr, "Bad LinkQualityRelevantChange value: %d\n", $2->integer);
+    YYABORT;
+  }
+  olsr_cnf->lq_relevant_change = $2->integer;
+  free($2);
+}
+;
+
 amin_tc_vtime: TOK_MIN_TC_VTIME TOK_FLOAT
 {
   PARSER_DEBUG_PRINTF("Minimum TC validity time %f\n", (double)$2->floating);
@@ -1305,6 +1352,39 @@ alock_file: TOK_LOCK_FILE TOK_STRING
   free($2);
 }
 ;
+
+sstate_file: TOK_STATE_FILE TOK_STRING
+{
+  PARSER_DEBUG_PRINTF("State file %s\n", $2->string);
+  if (olsr_cnf->state_file) free(olsr_cnf->state_file);
+  olsr_cnf->state_file = $2->string;
+  free($2);
+}
+;
+
+fstate_interval: TOK_STATE_INTERVAL TOK_FLOAT
+{
+  PARSER_DEBUG_PRINTF("State interval %0.2f\n", (double)$2->floating);
+  olsr_cnf->state_interval = $2->floating;
+  free($2);
+}
+;
+
+bkeep_routes: TOK_KEEP_ROUTES TOK_BOOLEAN
+{
+  PARSER_DEBUG_PRINTF("Keep routes %s\n", $2->boolean ? "enabled" : "disabled");
+  olsr_cnf->keep_routes = $2->boolean;
+  free($2);
+}
+;
+
+bmetrics: TOK_METRICS TOK_BOOLEAN
+{
+  PARSER_DEBUG_PRINTF("Metrics %s\n", $2->boolean ? "enabled" : "disabled");
+  olsr_cnf->metrics = $2->boolean;
+  free($2);
+}
+;
 alq_plugin: TOK_LQ_PLUGIN TOK_STRING
 {
   if (olsr_cnf->lq_algorithm) free(olsr_cnf->lq_algorithm);
@@ -1785,3 +1865,18 @@ void yyerror (const char *string)
 {
   fprintf(stderr, "Config line %d: %s\n", current_line, string);
 }
+
+/**
+ * @return a fingerprint of the tokens of the grammar, binary configuration
+ * files hold what the rules of one grammar made of a text file
+ */
+uint32_t olsrd_cnf_grammar_fingerprint(void)
+{
+  uint32_t fingerprint = 0;
+  int i;
+
+  for (i = 0; i < YYNTOKENS; i++) {
+    fingerprint = hash_inc(yytname[i], strlen(yytname[i]), fingerprint);
+  }
+  return fingerprint;
+}
@@ -50,6 +50,7 @@
 #include "mid_set.h"
 #include "scheduler.h"
 #include "mantissa.h"
+#include "olsr_metrics.h"
 
 static void olsr_cleanup_duplicate_entry(void *unused);
 
@@ -89,6 +90,35 @@ olsr_create_duplicate_entry(void *ip, uint16_t seqnr)
   return entry;
 }
 
+/**
+ * Restore a duplicate entry from a state checkpoint.
+ *
+ * @param ip the originator
+ * @param seqnr the highest sequence number seen
+ * @param too_low_counter number of consecutive too low sequence numbers
+ * @param array bitmap of the sequence numbers below seqnr
+ * @param vtime remaining validity time
+ */
+void
+olsr_restore_duplicate_entry(void *ip, uint16_t seqnr, uint16_t too_low_counter, uint32_t array, olsr_reltime vtime)
+{
+  struct dup_entry *entry;
+
+  entry = (struct dup_entry *)avl_find(&duplicate_set, ip);
+  if (entry == NULL) {
+    entry = olsr_create_duplicate_entry(ip, seqnr);
+    if (entry == NULL) {
+      return;
+    }
+    avl_insert(&duplicate_set, &entry->avl, 0);
+  }
+
+  entry->seqnr = seqnr;
+  entry->too_low_counter = too_low_counter;
+  entry->array = array;
+  entry->valid_until = GET_TIMESTAMP(vtime);
+}
+
 static void
 olsr_cleanup_duplicate_entry(void __attribute__ ((unused)) * unused)
 {
@@ -116,8 +146,8 @@ int olsr_seqno_diff(uint16_t seqno1, uint16_t seqno2) {
   return diff;
 }
 
-int
-olsr_message_is_duplicate(union olsr_message *m)
+static int
+message_is_duplicate(union olsr_message *m)
 {
   struct dup_entry *entry;
   int diff;
@@ -196,6 +226,28 @@ olsr_message_is_duplicate(union olsr_message *m)
   return false;                 /* no duplicate */
 }
 
+int
+olsr_message_is_duplicate(union olsr_message *m)
+{
+  static struct olsr_metric *check_metric = NULL, *duplicates_metric = NULL;
+  uint64_t start = olsr_metrics_start();
+  int duplicate = message_is_duplicate(m);
+
+  if (start) {
+    if (!check_metric) {
+      check_metric = olsr_metric_get(OLSR_METRIC_LATENCY, "duplicate_check",
+          "Lookup of a message in the duplicate set", NULL, NULL);
+      duplicates_metric = olsr_metric_get(OLSR_METRIC_COUNTER, "duplicate_messages",
+          "Messages found in the duplicate set", NULL, NULL);
+    }
+    olsr_metrics_stop(check_metric, start);
+    if (duplicate) {
+      olsr_metric_add(duplicates_metric, 1);
+    }
+  }
+  return duplicate;
+}
+
 #ifndef NODEBUG
 void
 olsr_print_duplicate_table(void)
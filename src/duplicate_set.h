@@ -67,9 +67,12 @@ struct dup_entry {
 
 AVLNODE2STRUCT(duptree2dupentry, struct dup_entry, avl);
 
+extern struct avl_tree duplicate_set;
+
 void olsr_init_duplicate_set(void);
 void olsr_cleanup_duplicates(union olsr_ip_addr *orig);
 struct dup_entry *olsr_create_duplicate_entry(void *ip, uint16_t seqnr);
+void olsr_restore_duplicate_entry(void *ip, uint16_t seqnr, uint16_t too_low_counter, uint32_t array, olsr_reltime vtime);
 int olsr_seqno_diff(uint16_t seqno1, uint16_t seqno2);
 int olsr_message_is_duplicate(union olsr_message *m);
 #ifndef NODEBUG
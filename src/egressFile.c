@@ -56,11 +56,12 @@
 #include "scheduler.h"
 #include "ipcalc.h"
 #include "log.h"
+#include "file_watch.h"
 
 /* System includes */
 #include <unistd.h>
 #include <fcntl.h>
-#include <regex.h>
+#include <ctype.h>
 #include <sys/stat.h>
 #include <assert.h>
 #include <net/if.h>
@@ -68,46 +69,35 @@
 /** the maximum length of a line that is read from the file */
 #define LINE_LENGTH 256
 
-/** regular expression describing a comment */
-static const char * regexComment = "^([[:space:]]*|[[:space:]#]+.*)$";
-
 /**
- * regular expression describing an egress line.
+ * The fields of an egress line:
+ *
+ * <pre>
+ * interface=requireNetwork,requireGateway,uplink,downlink[,pathCosts[,network/prefixLength[,gateway]]]
+ * </pre>
  *
- * # interface=uplink (Kbps),downlink (Kbps),path cost,gateway
+ * The interface is mandatory and can NOT be empty. requireNetwork,
+ * requireGateway, uplink and downlink are mandatory and can be empty. The
+ * remaining fields are optional and can be empty.
  */
-static const char * regexEgress = "^[[:space:]]*" //
-        "([^[:space:]=]+)"                     /* 01: interface, mandatory, can NOT be empty */
-        "[[:space:]]*=[[:space:]]*"            /* --: field separator */
-        "([[:digit:]]*)"                       /* 02: requireNetwork, mandatory, can be empty */
-        "[[:space:]]*,[[:space:]]*"            /* --: field separator */
-        "([[:digit:]]*)"                       /* 03: requireGateway, mandatory, can be empty */
-        "[[:space:]]*,[[:space:]]*"            /* --: field separator */
-        "([[:digit:]]*)"                       /* 04: uplink, mandatory, can be empty */
-        "[[:space:]]*,[[:space:]]*"            /* --: field separator */
-        "([[:digit:]]*)"                       /* 05: downlink, mandatory, can be empty */
-        "("                                    /* 06: (the rest is optional) */
-        "[[:space:]]*,[[:space:]]*"            /* --: field separator */
-        "([[:digit:]]*)"                       /* 07: path cost, optional, can be empty */
-        "("                                    /* 08: (the rest is optional) */
-        "[[:space:]]*,[[:space:]]*"            /* --: field separator */
-        "(|([[:digit:]\\.:]+)/([[:digit:]]+))" /* 09: network, optional, can be empty, 09=ip/x 10=ip 11=x */
-        "("                                    /* 12: (the rest is optional) */
-        "[[:space:]]*,[[:space:]]*"            /* --: field separator */
-        "([[:digit:]\\.:]*)"                   /* 13: gateway, optional, can be empty */
-        ")?"                                   /* 12 */
-        ")?"                                   /* 08 */
-        ")?"                                   /* 06 */
-        "[[:space:]]*$";
-
-/** the number of matches in regexEgress */
-#define REGEX_EGRESS_LINE_MATCH_COUNT (1 /* 00 */ + 13)
-
-/** the compiled regular expression describing a comment */
-static regex_t compiledRegexComment;
-
-/** the compiled regular expression describing an egress line */
-static regex_t compiledRegexEgress;
+enum egress_field {
+  EGRESS_FIELD_IFACE,
+  EGRESS_FIELD_REQUIRE_NETWORK,
+  EGRESS_FIELD_REQUIRE_GATEWAY,
+  EGRESS_FIELD_UPLINK,
+  EGRESS_FIELD_DOWNLINK,
+  EGRESS_FIELD_PATH_COSTS,
+  EGRESS_FIELD_NETWORK,
+  EGRESS_FIELD_PREFIX_LENGTH,
+  EGRESS_FIELD_GATEWAY,
+  EGRESS_FIELD_COUNT
+};
+
+/** the location of a field in a scanned line, str is NULL when absent */
+struct egress_field_span {
+  char * str;
+  size_t len;
+};
 
 /** true when the file reader has been started */
 static bool started = false;
@@ -293,6 +283,146 @@ static void stripEols(char * str) {
   str[len] = '\0';
 }
 
+/**
+ * Determine whether a line is a comment: an empty line, or a line that starts
+ * with whitespace or a '#'
+ *
+ * @param str the line
+ * @return true when the line is a comment
+ */
+static bool isCommentLine(const char * str) {
+  return (*str == '\0') || (*str == '#') || isspace((unsigned char) *str);
+}
+
+/**
+ * Skip whitespace
+ *
+ * @param str the string
+ * @return a pointer to the first non-whitespace character
+ */
+static char * skipSpaces(char * str) {
+  while (isspace((unsigned char) *str)) {
+    str++;
+  }
+  return str;
+}
+
+/**
+ * Skip a field separator and its surrounding whitespace
+ *
+ * @param str the string
+ * @param separator the separator
+ * @return a pointer to the first character after the separator and its
+ * trailing whitespace, NULL when the separator is not present
+ */
+static char * skipSeparator(char * str, char separator) {
+  str = skipSpaces(str);
+  if (*str != separator) {
+    return NULL;
+  }
+  return skipSpaces(str + 1);
+}
+
+/**
+ * Scan a field of digits
+ *
+ * @param str the start of the field
+ * @param field the field to fill in
+ * @param ipChars true to also accept the characters of an IP address ('.'
+ * and ':')
+ * @return a pointer to the first character after the field
+ */
+static char * scanField(char * str, struct egress_field_span * field, bool ipChars) {
+  char * end = str;
+  while (isdigit((unsigned char) *end) || (ipChars && ((*end == '.') || (*end == ':')))) {
+    end++;
+  }
+  field->str = str;
+  field->len = end - str;
+  return end;
+}
+
+/**
+ * Scan an egress line into its fields. The fields are terminated in place when
+ * the line has a valid syntax.
+ *
+ * @param str the line, without EOL characters
+ * @param fields the fields to fill in
+ * @return true when the line has a valid syntax
+ */
+static bool scanEgressLine(char * str, struct egress_field_span fields[EGRESS_FIELD_COUNT]) {
+  char * p = skipSpaces(str);
+  char * next;
+  int i;
+
+  memset(fields, 0, sizeof(fields[0]) * EGRESS_FIELD_COUNT);
+
+  /* interface, mandatory, can NOT be empty */
+  fields[EGRESS_FIELD_IFACE].str = p;
+  while ((*p != '\0') && (*p != '=') && !isspace((unsigned char) *p)) {
+    p++;
+  }
+  fields[EGRESS_FIELD_IFACE].len = p - fields[EGRESS_FIELD_IFACE].str;
+  if (!fields[EGRESS_FIELD_IFACE].len) {
+    return false;
+  }
+
+  /* requireNetwork, requireGateway, uplink and downlink: mandatory, can be empty */
+  next = skipSeparator(p, '=');
+  for (i = EGRESS_FIELD_REQUIRE_NETWORK; i <= EGRESS_FIELD_DOWNLINK; i++) {
+    if (!next) {
+      return false;
+    }
+    p = scanField(next, &fields[i], false);
+    next = (i < EGRESS_FIELD_DOWNLINK) ? skipSeparator(p, ',') : NULL;
+  }
+
+  /* path costs: optional, can be empty */
+  next = skipSeparator(p, ',');
+  if (next) {
+    p = scanField(next, &fields[EGRESS_FIELD_PATH_COSTS], false);
+
+    /* network: optional, can be empty, ip/prefixLength when not empty */
+    next = skipSeparator(p, ',');
+    if (next) {
+      struct egress_field_span network;
+
+      p = scanField(next, &network, true);
+      if (network.len) {
+        struct egress_field_span prefixLength;
+
+        if (*p != '/') {
+          return false;
+        }
+        p = scanField(p + 1, &prefixLength, false);
+        if (!prefixLength.len) {
+          return false;
+        }
+        fields[EGRESS_FIELD_NETWORK] = network;
+        fields[EGRESS_FIELD_PREFIX_LENGTH] = prefixLength;
+      }
+
+      /* gateway: optional, can be empty */
+      next = skipSeparator(p, ',');
+      if (next) {
+        p = scanField(next, &fields[EGRESS_FIELD_GATEWAY], true);
+      }
+    }
+  }
+
+  if (*skipSpaces(p) != '\0') {
+    return false;
+  }
+
+  for (i = 0; i < EGRESS_FIELD_COUNT; i++) {
+    if (fields[i].str) {
+      fields[i].str[fields[i].len] = '\0';
+    }
+  }
+
+  return true;
+}
+
 /**
  * Find an egress interface in the configuration
  *
@@ -367,10 +497,13 @@ void egressBwClear(struct egress_if_bw * bw, bool up) {
 }
 
 /*
- * Timer
+ * Change Detection
  */
 
-/** the timer for polling the egress file for changes */
+/** the watch on the egress file, NULL when polling */
+static struct file_watch *egress_file_watch;
+
+/** the timer for polling the egress file for changes, when it can't be watched */
 static struct timer_entry *egress_file_timer;
 
 /**
@@ -384,6 +517,19 @@ static void egress_file_timer_callback(void *unused __attribute__ ((unused))) {
   }
 }
 
+/**
+ * Watch callback to read the egress file after it was written, renamed into
+ * place or removed. The file is always read since its modification time can
+ * be equal to that of the previous write.
+ *
+ * @param path unused
+ * @param data unused
+ */
+static void egress_file_watch_callback(const char * path __attribute__ ((unused)), void * data __attribute__ ((unused))) {
+  memset(&cachedStat.timeStamp, 0, sizeof(cachedStat.timeStamp));
+  egress_file_timer_callback(NULL);
+}
+
 /*
  * Life Cycle
  */
@@ -396,8 +542,6 @@ static void egress_file_timer_callback(void *unused __attribute__ ((unused))) {
  * - false otherwise
  */
 bool startEgressFile(void) {
-  int r;
-
   if (started) {
     return true;
   }
@@ -409,32 +553,16 @@ bool startEgressFile(void) {
   }
   *line = '\0';
 
-  r = regcomp(&compiledRegexComment, regexComment, REG_EXTENDED);
-  if (r) {
-    regerror(r, &compiledRegexComment, line, LINE_LENGTH);
-    egressFileError(false, __LINE__, "Could not compile regex \"%s\" (%d = %s)", regexComment, r, line);
-
-    free(line);
-    line = NULL;
-    return false;
-  }
-
-  r = regcomp(&compiledRegexEgress, regexEgress, REG_EXTENDED);
-  if (r) {
-    regerror(r, &compiledRegexEgress, line, LINE_LENGTH);
-    egressFileError(false, __LINE__, "Could not compile regex \"%s\" (%d = %s)", regexEgress, r, line);
-
-    regfree(&compiledRegexComment);
-    free(line);
-    line = NULL;
-    return false;
-  }
-
   memset(&cachedStat.timeStamp, 0, sizeof(cachedStat.timeStamp));
 
   readEgressFile(olsr_cnf->smart_gw_egress_file);
 
-  olsr_set_timer(&egress_file_timer, olsr_cnf->smart_gw_egress_file_period, 0, true, &egress_file_timer_callback, NULL, NULL);
+  egress_file_watch = olsr_file_watch_add(!olsr_cnf->smart_gw_egress_file ? DEF_GW_EGRESS_FILE : olsr_cnf->smart_gw_egress_file,
+      &egress_file_watch_callback, NULL);
+  if (!egress_file_watch) {
+    /* fall back to polling */
+    olsr_set_timer(&egress_file_timer, olsr_cnf->smart_gw_egress_file_period, 0, true, &egress_file_timer_callback, NULL, NULL);
+  }
 
   started = true;
   return true;
@@ -445,11 +573,11 @@ bool startEgressFile(void) {
  */
 void stopEgressFile(void) {
   if (started) {
+    olsr_file_watch_remove(egress_file_watch);
+    egress_file_watch = NULL;
     olsr_stop_timer(egress_file_timer);
     egress_file_timer = NULL;
 
-    regfree(&compiledRegexEgress);
-    regfree(&compiledRegexComment);
     free(line);
     line = NULL;
 
@@ -461,8 +589,8 @@ void stopEgressFile(void) {
  * File Reader
  */
 
-/** the buffer with regex matches */
-static regmatch_t pmatch[REGEX_EGRESS_LINE_MATCH_COUNT];
+/** the fields of the line that is being processed */
+static struct egress_field_span fields[EGRESS_FIELD_COUNT];
 
 static void readEgressFileClear(void) {
   struct sgw_egress_if * egress_if = olsr_cnf->smart_gw_egress_interfaces;
@@ -549,7 +677,9 @@ static bool readEgressFile(const char * fileName) {
 
     lineNumber++;
 
-    if (!regexec(&compiledRegexComment, line, 0, NULL, 0)) {
+    stripEols(line);
+
+    if (isCommentLine(line)) {
       /* the line is a comment */
       continue;
     }
@@ -557,20 +687,16 @@ static bool readEgressFile(const char * fileName) {
     memset(&network, 0, sizeof(network));
     memset(&gateway, 0, sizeof(gateway));
 
-    stripEols(line);
-
-    memset(pmatch, 0, sizeof(pmatch));
-    if (regexec(&compiledRegexEgress, line, REGEX_EGRESS_LINE_MATCH_COUNT, pmatch, 0)) {
+    if (!scanEgressLine(line, fields)) {
       egressFileError(false, __LINE__, "Egress speed file line %d uses invalid syntax: line is ignored (%s)", lineNumber, line);
       reportedErrorsLocal = true;
       continue;
     }
 
-    /* iface: mandatory presence, guaranteed through regex match */
+    /* iface: mandatory presence, guaranteed through scanEgressLine */
     {
-      regoff_t len = pmatch[1].rm_eo - pmatch[1].rm_so;
-      char * ifaceString = &line[pmatch[1].rm_so];
-      line[pmatch[1].rm_eo] = '\0';
+      size_t len = fields[EGRESS_FIELD_IFACE].len;
+      char * ifaceString = fields[EGRESS_FIELD_IFACE].str;
 
       if (len > IFNAMSIZ) {
         /* interface name is too long */
@@ -590,12 +716,11 @@ static bool readEgressFile(const char * fileName) {
     }
     assert(egress_if);
 
-    /* requireNetwork: mandatory presence, guaranteed through regex match */
+    /* requireNetwork: mandatory presence, guaranteed through scanEgressLine */
     {
-      regoff_t len = pmatch[2].rm_eo - pmatch[2].rm_so;
-      char * requireNetworkString = &line[pmatch[2].rm_so];
+      size_t len = fields[EGRESS_FIELD_REQUIRE_NETWORK].len;
+      char * requireNetworkString = fields[EGRESS_FIELD_REQUIRE_NETWORK].str;
       unsigned long long value = 1;
-      line[pmatch[2].rm_eo] = '\0';
 
       if ((len > 0) && !readULL(requireNetworkString, &value)) {
         egressFileError(false, __LINE__, "Egress speed file line %d: requireNetwork \"%s\" is not a valid number: line is ignored", lineNumber,
@@ -607,12 +732,11 @@ static bool readEgressFile(const char * fileName) {
       }
     }
 
-    /* requireGateway: mandatory presence, guaranteed through regex match */
+    /* requireGateway: mandatory presence, guaranteed through scanEgressLine */
     {
-      regoff_t len = pmatch[3].rm_eo - pmatch[3].rm_so;
-      char * requireGatewayString = &line[pmatch[3].rm_so];
+      size_t len = fields[EGRESS_FIELD_REQUIRE_GATEWAY].len;
+      char * requireGatewayString = fields[EGRESS_FIELD_REQUIRE_GATEWAY].str;
       unsigned long long value = 1;
-      line[pmatch[3].rm_eo] = '\0';
 
       if ((len > 0) && !readULL(requireGatewayString, &value)) {
         egressFileError(false, __LINE__, "Egress speed file line %d: requireGateway \"%s\" is not a valid number: line is ignored", lineNumber,
@@ -624,11 +748,10 @@ static bool readEgressFile(const char * fileName) {
       }
     }
 
-    /* uplink: mandatory presence, guaranteed through regex match */
+    /* uplink: mandatory presence, guaranteed through scanEgressLine */
     {
-      regoff_t len = pmatch[4].rm_eo - pmatch[4].rm_so;
-      char * uplinkString = &line[pmatch[4].rm_so];
-      line[pmatch[4].rm_eo] = '\0';
+      size_t len = fields[EGRESS_FIELD_UPLINK].len;
+      char * uplinkString = fields[EGRESS_FIELD_UPLINK].str;
 
       if ((len > 0) && !readULL(uplinkString, &uplink)) {
         egressFileError(false, __LINE__, "Egress speed file line %d: uplink bandwidth \"%s\" is not a valid number: line is ignored", lineNumber, uplinkString);
@@ -638,11 +761,10 @@ static bool readEgressFile(const char * fileName) {
     }
     uplink = MIN(uplink, MAX_SMARTGW_SPEED);
 
-    /* downlink: mandatory presence, guaranteed through regex match */
+    /* downlink: mandatory presence, guaranteed through scanEgressLine */
     {
-      regoff_t len = pmatch[5].rm_eo - pmatch[5].rm_so;
-      char * downlinkString = &line[pmatch[5].rm_so];
-      line[pmatch[5].rm_eo] = '\0';
+      size_t len = fields[EGRESS_FIELD_DOWNLINK].len;
+      char * downlinkString = fields[EGRESS_FIELD_DOWNLINK].str;
 
       if ((len > 0) && !readULL(downlinkString, &downlink)) {
         egressFileError(false, __LINE__, "Egress speed file line %d: downlink bandwidth \"%s\" is not a valid number: line is ignored", lineNumber,
@@ -654,10 +776,9 @@ static bool readEgressFile(const char * fileName) {
     downlink = MIN(downlink, MAX_SMARTGW_SPEED);
 
     /* path costs: optional presence */
-    if (pmatch[7].rm_so != -1) {
-      regoff_t len = pmatch[7].rm_eo - pmatch[7].rm_so;
-      char * pathCostsString = &line[pmatch[7].rm_so];
-      line[pmatch[7].rm_eo] = '\0';
+    if (fields[EGRESS_FIELD_PATH_COSTS].str) {
+      size_t len = fields[EGRESS_FIELD_PATH_COSTS].len;
+      char * pathCostsString = fields[EGRESS_FIELD_PATH_COSTS].str;
 
       if ((len > 0) && !readULL(pathCostsString, &pathCosts)) {
         egressFileError(false, __LINE__, "Egress speed file line %d: path costs \"%s\" is not a valid number: line is ignored", lineNumber, pathCostsString);
@@ -668,13 +789,11 @@ static bool readEgressFile(const char * fileName) {
     pathCosts = MIN(pathCosts, UINT32_MAX);
 
     /* network: optional presence */
-    if ((pmatch[9].rm_so != -1) && ((pmatch[9].rm_eo - pmatch[9].rm_so) > 0)) {
+    if (fields[EGRESS_FIELD_NETWORK].str) {
       /* network is present: guarantees IP and prefix presence */
       unsigned long long prefix_len;
-      char * networkString = &line[pmatch[10].rm_so];
-      char * prefixlenString = &line[pmatch[11].rm_so];
-      line[pmatch[10].rm_eo] = '\0';
-      line[pmatch[11].rm_eo] = '\0';
+      char * networkString = fields[EGRESS_FIELD_NETWORK].str;
+      char * prefixlenString = fields[EGRESS_FIELD_PREFIX_LENGTH].str;
 
       if (!readIPAddress(networkString, &network.prefix, &networkSet, &networkIpVersion)) {
         egressFileError(false, __LINE__, "Egress speed file line %d: network IP address \"%s\" is not a valid IP address: line is ignored", lineNumber,
@@ -701,10 +820,9 @@ static bool readEgressFile(const char * fileName) {
     }
 
     /* gateway: optional presence */
-    if (pmatch[13].rm_so != -1) {
-      regoff_t len = pmatch[13].rm_eo - pmatch[13].rm_so;
-      char * gatewayString = &line[pmatch[13].rm_so];
-      line[pmatch[13].rm_eo] = '\0';
+    if (fields[EGRESS_FIELD_GATEWAY].str) {
+      size_t len = fields[EGRESS_FIELD_GATEWAY].len;
+      char * gatewayString = fields[EGRESS_FIELD_GATEWAY].str;
 
       if ((len > 0) && !readIPAddress(gatewayString, &gateway, &gatewaySet, &gatewayIpVersion)) {
         egressFileError(false, __LINE__, "Egress speed file line %d: gateway IP address \"%s\" is not a valid IP address: line is ignored", lineNumber,
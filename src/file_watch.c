@@ -0,0 +1,381 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#ifdef __linux__
+
+#include "file_watch.h"
+
+/* Plugin includes */
+
+/* OLSRD includes */
+#include "olsr.h"
+#include "scheduler.h"
+#include "log.h"
+#include "common/string_handling.h"
+
+/* System includes */
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/inotify.h>
+
+/**
+ * The events that are watched on the directory of a watched file. Watching the
+ * directory (and not the file itself) also catches files that are atomically
+ * renamed into place, and files that do not exist yet.
+ */
+#define FILE_WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE)
+
+/**
+ * The interval (in milliseconds) in which a lost directory watch is added
+ * again. Until that succeeds the file is polled in the same interval.
+ */
+#define FILE_WATCH_RETRY_INTERVAL 1000
+
+/** a watched file */
+struct file_watch {
+  int wd; /* the inotify watch descriptor of the directory, -1 when lost */
+  const char * name; /* the file name part of path */
+  file_watch_func cb;
+  void * data;
+  bool pending; /* an event was received and the callback is not run yet */
+  struct file_watch * next;
+  char path[1]; /* the path of the file, allocated with the watch */
+};
+
+/** the inotify instance that is shared by all watches, -1 when closed */
+static int inotify_fd = -1;
+
+/** the list of watched files */
+static struct file_watch * watches = NULL;
+
+/** the timer that adds lost watches again, NULL when no watch is lost */
+static struct timer_entry * retry_timer = NULL;
+
+/**
+ * Get the directory of a file
+ *
+ * @param path the path of the file
+ * @param dir the buffer for the directory
+ * @param dirSize the size of the buffer
+ * @return the file name part of path, or NULL when path is not a file or its
+ * directory does not fit the buffer
+ */
+static const char * file_watch_dir(const char * path, char * dir, size_t dirSize) {
+  size_t pathLen = strlen(path);
+  const char * slash = strrchr(path, '/');
+
+  if (!pathLen || (slash == (path + pathLen - 1))) {
+    /* not a file */
+    return NULL;
+  }
+
+  if (!slash) {
+    strscpy(dir, ".", dirSize);
+    return path;
+  }
+
+  if (slash == path) {
+    strscpy(dir, "/", dirSize);
+  } else if ((size_t) (slash - path) < dirSize) {
+    memcpy(dir, path, slash - path);
+    dir[slash - path] = '\0';
+  } else {
+    return NULL;
+  }
+  return slash + 1;
+}
+
+/**
+ * Watch the directory of a file
+ *
+ * @param path the path of the file
+ * @return the inotify watch descriptor, or -1 on failure
+ */
+static int file_watch_add_dir(const char * path) {
+  char dir[PATH_MAX];
+
+  if (!file_watch_dir(path, dir, sizeof(dir))) {
+    return -1;
+  }
+  return inotify_add_watch(inotify_fd, dir, FILE_WATCH_EVENTS);
+}
+
+/**
+ * Run the callbacks of the files that have pending events
+ */
+static void file_watch_run_pending(void) {
+  struct file_watch * watch;
+
+  /* a callback can add or remove watches: restart the walk after each one */
+  restart: for (watch = watches; watch; watch = watch->next) {
+    if (watch->pending) {
+      watch->pending = false;
+      watch->cb(watch->path, watch->data);
+      goto restart;
+    }
+  }
+}
+
+static void file_watch_retry(void *unused);
+
+/**
+ * Add the lost watches again. The files of watches that are still lost are
+ * polled by the retry timer, which runs until all watches are back.
+ */
+static void file_watch_recover(void) {
+  struct file_watch * watch;
+  bool lost = false;
+
+  for (watch = watches; watch; watch = watch->next) {
+    if (watch->wd >= 0) {
+      continue;
+    }
+
+    watch->wd = file_watch_add_dir(watch->path);
+    if (watch->wd >= 0) {
+      olsr_syslog(OLSR_LOG_INFO, "Watching %s for changes again", watch->path);
+      /* the file may have changed while it was not watched */
+      watch->pending = true;
+    } else {
+      lost = true;
+    }
+  }
+
+  if (lost && !retry_timer) {
+    retry_timer = olsr_start_timer(FILE_WATCH_RETRY_INTERVAL, 0, OLSR_TIMER_PERIODIC, &file_watch_retry, NULL, NULL);
+  } else if (!lost && retry_timer) {
+    olsr_stop_timer(retry_timer);
+    retry_timer = NULL;
+  }
+}
+
+/**
+ * Timer callback that polls the files of lost watches and tries to add the
+ * watches again.
+ *
+ * @param unused unused
+ */
+static void file_watch_retry(void *unused __attribute__ ((unused))) {
+  struct file_watch * watch;
+
+  for (watch = watches; watch; watch = watch->next) {
+    if (watch->wd < 0) {
+      watch->pending = true;
+    }
+  }
+
+  file_watch_recover();
+  file_watch_run_pending();
+}
+
+/**
+ * Socket handler that reads the pending inotify events and invokes the
+ * callbacks of the files they refer to. Events are coalesced so that a
+ * callback runs at most once per invocation of this handler.
+ *
+ * @param fd the inotify file descriptor
+ * @param data unused
+ * @param flags unused
+ */
+static void file_watch_read(int fd, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused))) {
+  char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+  struct file_watch * watch;
+  ssize_t len;
+
+  while ((len = read(fd, buf, sizeof(buf))) > 0) {
+    char * ptr = buf;
+
+    while (ptr < (buf + len)) {
+      struct inotify_event * event = (struct inotify_event *) ptr;
+      ptr += sizeof(*event) + event->len;
+
+      for (watch = watches; watch; watch = watch->next) {
+        if (event->mask & IN_Q_OVERFLOW) {
+          /* events were dropped: assume every file changed */
+          watch->pending = true;
+          continue;
+        }
+
+        if ((watch->wd < 0) || (event->wd != watch->wd)) {
+          continue;
+        }
+
+        if (event->mask & IN_IGNORED) {
+          /* the directory was removed or unmounted: poll until it is back */
+          olsr_syslog(OLSR_LOG_ERR, "Lost the watch on the directory of %s, polling it for changes", watch->path);
+          watch->wd = -1;
+          watch->pending = true;
+        } else if (event->len && !strcmp(event->name, watch->name)) {
+          watch->pending = true;
+        }
+      }
+    }
+  }
+
+  if ((len < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK) && (errno != EINTR)) {
+    olsr_syslog(OLSR_LOG_ERR, "Could not read file change events: %s", strerror(errno));
+  }
+
+  file_watch_recover();
+  file_watch_run_pending();
+}
+
+/**
+ * Close the inotify instance when there are no more watches
+ */
+static void file_watch_close_unused(void) {
+  if (!watches && retry_timer) {
+    olsr_stop_timer(retry_timer);
+    retry_timer = NULL;
+  }
+  if (!watches && (inotify_fd >= 0)) {
+    remove_olsr_socket(inotify_fd, &file_watch_read, NULL);
+    close(inotify_fd);
+    inotify_fd = -1;
+  }
+}
+
+/**
+ * Start watching a file for changes. The callback is invoked from the main
+ * loop after the file was closed for writing, was renamed into place or was
+ * removed.
+ *
+ * @param path the path of the file to watch, the file does not need to exist
+ * but its directory does
+ * @param cb the callback
+ * @param data the data pointer that is passed to the callback
+ * @return the watch, or NULL when the file can not be watched, in which case
+ * the caller has to fall back to polling. When the directory is removed later
+ * on, the watch polls the file itself until the directory can be watched again.
+ */
+struct file_watch * olsr_file_watch_add(const char * path, file_watch_func cb, void * data) {
+  char dir[PATH_MAX];
+  const char * name;
+  struct file_watch * watch;
+  size_t pathLen;
+  int wd;
+
+  if (!path || !cb) {
+    return NULL;
+  }
+
+  name = file_watch_dir(path, dir, sizeof(dir));
+  if (!name) {
+    return NULL;
+  }
+  pathLen = strlen(path);
+
+  if (inotify_fd < 0) {
+    inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd < 0) {
+      olsr_syslog(OLSR_LOG_ERR, "Could not create an inotify instance: %s", strerror(errno));
+      return NULL;
+    }
+    add_olsr_socket(inotify_fd, &file_watch_read, NULL, NULL, SP_PR_READ);
+  }
+
+  /* watches on the same directory share the watch descriptor */
+  wd = inotify_add_watch(inotify_fd, dir, FILE_WATCH_EVENTS);
+  if (wd < 0) {
+    olsr_syslog(OLSR_LOG_ERR, "Could not watch %s for changes: %s", dir, strerror(errno));
+    file_watch_close_unused();
+    return NULL;
+  }
+
+  watch = olsr_malloc(sizeof(*watch) + pathLen, "file watch");
+  memcpy(watch->path, path, pathLen + 1);
+  watch->name = watch->path + (name - path);
+  watch->wd = wd;
+  watch->cb = cb;
+  watch->data = data;
+  watch->pending = false;
+  watch->next = watches;
+  watches = watch;
+
+  return watch;
+}
+
+/**
+ * Stop watching a file for changes
+ *
+ * @param watch the watch, as returned by olsr_file_watch_add (can be NULL)
+ */
+void olsr_file_watch_remove(struct file_watch * watch) {
+  struct file_watch ** prev = &watches;
+  struct file_watch * other;
+  bool shared = false;
+
+  if (!watch) {
+    return;
+  }
+
+  while (*prev && (*prev != watch)) {
+    prev = &(*prev)->next;
+  }
+  if (!*prev) {
+    return;
+  }
+  *prev = watch->next;
+
+  for (other = watches; other; other = other->next) {
+    if ((watch->wd >= 0) && (other->wd == watch->wd)) {
+      shared = true;
+      break;
+    }
+  }
+
+  if (!shared && (watch->wd >= 0)) {
+    inotify_rm_watch(inotify_fd, watch->wd);
+  }
+
+  free(watch);
+  file_watch_close_unused();
+}
+
+#endif /* __linux__ */
@@ -70,6 +70,8 @@
 #include <net/if.h>
 #include <sys/ioctl.h>
 #include <net/if.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 /*
  * Defines for the multi-gateway script
@@ -82,6 +84,36 @@
 #define SCRIPT_MODE_EGRESSIF  "egressif"
 #define SCRIPT_MODE_SGWTUN    "sgwtun"
 
+/* poll interval for a running multi-gateway script, in milliseconds */
+#define SCRIPT_POLL_INTERVAL  100
+
+/*
+ * A queued run of the multi-gateway script
+ */
+struct multiGwScriptRun {
+  struct list_node node;
+  const char * mode;
+  bool addMode;
+  char ifName[IFNAMSIZ];
+  uint32_t tableNr;
+  uint32_t ruleNr;
+  uint32_t bypassRuleNr;
+};
+
+LISTNODE2STRUCT(list2scriptrun, struct multiGwScriptRun, node);
+
+/** the queued multi-gateway script runs, they are run one at a time */
+static struct list_node multiGwScriptQueue;
+
+/** the pid of the running multi-gateway script, -1 when none is running */
+static pid_t multiGwScriptPid = -1;
+
+/** the timer that polls for the running multi-gateway script to exit */
+static struct timer_entry *multiGwScriptTimer = NULL;
+
+/** the number of multi-gateway script runs that failed since the last flush */
+static unsigned int multiGwScriptFailures = 0;
+
 /* ipv4 prefix 0.0.0.0/0 */
 static struct olsr_ip_prefix ipv4_slash_0_route;
 
@@ -346,7 +378,187 @@ static void set_unused_iptunnel_name(struct gateway_entry *gw) {
 }
 
 /**
- * Run the multi-gateway script/
+ * Start the multi-gateway script for a queued run.
+ *
+ * @param run the queued run
+ * @return the pid of the script, -1 on failure
+ */
+static pid_t multiGwScriptStart(struct multiGwScriptRun * run) {
+  pid_t pid = fork();
+
+  if (pid == 0) {
+    char ipVersion[5];
+    char mode[16];
+    char addMode[4];
+    char tableNr[12];
+    char ruleNr[12];
+    char bypassRuleNr[12];
+    char * argv[10];
+    int argc = 0;
+
+    strscpy(ipVersion, (olsr_cnf->ip_version == AF_INET) ? "ipv4" : "ipv6", sizeof(ipVersion));
+    strscpy(mode, run->mode, sizeof(mode));
+    strscpy(addMode, run->addMode ? "add" : "del", sizeof(addMode));
+
+    argv[argc++] = olsr_cnf->smart_gw_policyrouting_script;
+    argv[argc++] = olsr_cnf->smart_gw_instance_id;
+    argv[argc++] = ipVersion;
+    argv[argc++] = mode;
+    argv[argc++] = addMode;
+    if (run->ifName[0]) {
+      argv[argc++] = run->ifName;
+    }
+    if (run->tableNr) {
+      snprintf(tableNr, sizeof(tableNr), "%u", run->tableNr);
+      argv[argc++] = tableNr;
+    }
+    if (run->ruleNr) {
+      snprintf(ruleNr, sizeof(ruleNr), "%u", run->ruleNr);
+      argv[argc++] = ruleNr;
+    }
+    if (run->bypassRuleNr) {
+      snprintf(bypassRuleNr, sizeof(bypassRuleNr), "%u", run->bypassRuleNr);
+      argv[argc++] = bypassRuleNr;
+    }
+    argv[argc] = NULL;
+
+    execv(argv[0], argv);
+    _exit(127);
+  }
+
+  if (pid < 0) {
+    olsr_syslog(OLSR_LOG_ERR, "Could not start the multi-gateway script for %s %s: %s", run->mode, run->addMode ? "add" : "del",
+        strerror(errno));
+    multiGwScriptFailures++;
+  }
+
+  return pid;
+}
+
+/**
+ * Reap the running multi-gateway script.
+ *
+ * @param block true to wait for the script to exit
+ */
+static void multiGwScriptReap(bool block) {
+  int status;
+  pid_t pid;
+
+  if (multiGwScriptPid < 0) {
+    return;
+  }
+
+  do {
+    pid = waitpid(multiGwScriptPid, &status, block ? 0 : WNOHANG);
+  } while (pid < 0 && errno == EINTR);
+
+  if (!pid) {
+    return;
+  }
+
+  if (pid > 0 && (!WIFEXITED(status) || WEXITSTATUS(status))) {
+    olsr_syslog(OLSR_LOG_ERR, "The multi-gateway script failed (status %d)", status);
+    multiGwScriptFailures++;
+  }
+  multiGwScriptPid = -1;
+}
+
+/**
+ * Start the next queued multi-gateway script run when no script is running.
+ */
+static void multiGwScriptNext(void) {
+  while (multiGwScriptPid < 0 && !list_is_empty(&multiGwScriptQueue)) {
+    struct multiGwScriptRun * run = list2scriptrun(multiGwScriptQueue.next);
+
+    list_remove(&run->node);
+    multiGwScriptPid = multiGwScriptStart(run);
+    free(run);
+  }
+}
+
+/**
+ * Timer callback that polls for the running multi-gateway script to exit
+ * and starts the next queued run.
+ *
+ * @param context unused
+ */
+static void multiGwScriptPoll(void *context __attribute__ ((unused))) {
+  multiGwScriptTimer = NULL;
+
+  multiGwScriptReap(false);
+  multiGwScriptNext();
+
+  if (multiGwScriptPid >= 0) {
+    multiGwScriptTimer = olsr_start_timer(SCRIPT_POLL_INTERVAL, 0, OLSR_TIMER_ONESHOT, &multiGwScriptPoll, NULL, 0);
+  }
+}
+
+/**
+ * Queue a run of the multi-gateway script, when one is configured. The
+ * script is run asynchronously, runs are executed one at a time in the
+ * order in which they were queued.
+ *
+ * @param mode the mode (see SCRIPT_MODE_* defines)
+ * @param addMode true to add policy routing, false to remove it
+ * @param ifName the interface name (optional)
+ * @param tableNr the routing table number (optional)
+ * @param ruleNr the IP rule number/priority (optional)
+ * @param bypassRuleNr the bypass IP rule number/priority (optional)
+ */
+static void multiGwScriptQueueRun(const char * mode, bool addMode, const char * ifName, uint32_t tableNr, uint32_t ruleNr,
+    uint32_t bypassRuleNr) {
+  struct multiGwScriptRun * run;
+
+  if (!olsr_cnf->smart_gw_policyrouting_script) {
+    return;
+  }
+
+  run = olsr_malloc(sizeof(*run), "multiGwScriptRun");
+  list_node_init(&run->node);
+  run->mode = mode;
+  run->addMode = addMode;
+  strscpy(run->ifName, ifName ? ifName : "", sizeof(run->ifName));
+  run->tableNr = tableNr;
+  run->ruleNr = ruleNr;
+  run->bypassRuleNr = bypassRuleNr;
+  list_add_before(&multiGwScriptQueue, &run->node);
+
+  multiGwScriptNext();
+
+  if (multiGwScriptPid >= 0 && !multiGwScriptTimer) {
+    multiGwScriptTimer = olsr_start_timer(SCRIPT_POLL_INTERVAL, 0, OLSR_TIMER_ONESHOT, &multiGwScriptPoll, NULL, 0);
+  }
+}
+
+/**
+ * Run all queued multi-gateway script runs and wait for them to finish.
+ *
+ * @return true when none of the runs since the previous flush failed
+ */
+static bool multiGwScriptFlush(void) {
+  bool ok;
+
+  olsr_stop_timer(multiGwScriptTimer);
+  multiGwScriptTimer = NULL;
+
+  multiGwScriptReap(true);
+  multiGwScriptNext();
+  while (multiGwScriptPid >= 0) {
+    multiGwScriptReap(true);
+    multiGwScriptNext();
+  }
+
+  ok = !multiGwScriptFailures;
+  multiGwScriptFailures = 0;
+  return ok;
+}
+
+/**
+ * Setup or remove the multi-gateway policy routing.
+ *
+ * The ip rules are setup over netlink. The iptables connection marking
+ * is left to the multi-gateway script, which is queued with the same
+ * arguments when it is configured.
  *
  * @param mode the mode (see SCRIPT_MODE_* defines)
  * @param addMode true to add policy routing, false to remove it
@@ -356,9 +568,10 @@ static void set_unused_iptunnel_name(struct gateway_entry *gw) {
  * @param bypassRuleNr the bypass IP rule number/priority (optional)
  * @return true when successful
  */
-static bool multiGwRunScript(const char * mode, bool addMode, const char * ifName, uint32_t tableNr, uint32_t ruleNr, uint32_t bypassRuleNr) {
-  struct autobuf buf;
-  int r;
+static bool multiGwPolicyRouting(const char * mode, bool addMode, const char * ifName, uint32_t tableNr, uint32_t ruleNr, uint32_t bypassRuleNr) {
+  struct olsr_os_rule rules[2];
+  unsigned int count = 0;
+  unsigned int failed = 0;
 
   assert(!strcmp(mode, SCRIPT_MODE_CLEANUP) //
       || !strcmp(mode, SCRIPT_MODE_GENERIC) //
@@ -386,39 +599,43 @@ static bool multiGwRunScript(const char * mode, bool addMode, const char * ifNam
   assert(strcmp(mode, SCRIPT_MODE_SGWTUN) //
       || (!strcmp(mode, SCRIPT_MODE_SGWTUN) && ifName && tableNr && ruleNr && !bypassRuleNr));
 
-  abuf_init(&buf, AUTOBUFCHUNK);
-
-  abuf_appendf(&buf, "\"%s\"", olsr_cnf->smart_gw_policyrouting_script);
-
-  abuf_appendf(&buf, " \"%s\"", olsr_cnf->smart_gw_instance_id);
-
-  abuf_appendf(&buf, " \"%s\"", (olsr_cnf->ip_version == AF_INET) ? "ipv4" : "ipv6");
-
-  abuf_appendf(&buf, " \"%s\"", mode);
-
-  abuf_appendf(&buf, " \"%s\"", addMode ? "add" : "del");
+  memset(rules, 0, sizeof(rules));
 
-  if (ifName) {
-    abuf_appendf(&buf, " \"%s\"", ifName);
+  /* traffic marked for the table of the interface */
+  if (!strcmp(mode, SCRIPT_MODE_EGRESSIF) || !strcmp(mode, SCRIPT_MODE_SGWSRVTUN) || !strcmp(mode, SCRIPT_MODE_SGWTUN)) {
+    rules[count].priority = ruleNr;
+    rules[count].table = tableNr;
+    rules[count].fwmark = ruleNr;
+    count++;
   }
 
-  if (tableNr) {
-    abuf_appendf(&buf, " \"%u\"", tableNr);
+  /* traffic from the server tunnel uses its table */
+  if (!strcmp(mode, SCRIPT_MODE_SGWSRVTUN)) {
+    rules[count].priority = ruleNr;
+    rules[count].table = tableNr;
+    rules[count].if_name = ifName;
+    count++;
   }
 
-  if (ruleNr) {
-    abuf_appendf(&buf, " \"%u\"", ruleNr);
+  /* traffic from the interface bypasses the multi-gateway tables */
+  if (!strcmp(mode, SCRIPT_MODE_OLSRIF) || !strcmp(mode, SCRIPT_MODE_EGRESSIF)) {
+    rules[count].priority = bypassRuleNr;
+    rules[count].table = RT_TABLE_MAIN;
+    rules[count].if_name = ifName;
+    count++;
   }
 
-  if (bypassRuleNr) {
-    abuf_appendf(&buf, " \"%u\"", bypassRuleNr);
+  if (count) {
+    if (addMode) {
+      /* first remove any left-over rules */
+      (void) olsr_os_policy_rules(olsr_cnf->ip_version, rules, count, false);
+    }
+    failed = olsr_os_policy_rules(olsr_cnf->ip_version, rules, count, addMode);
   }
 
-  r = system(buf.buf);
-
-  abuf_free(&buf);
+  multiGwScriptQueueRun(mode, addMode, ifName, tableNr, ruleNr, bypassRuleNr);
 
-  return (r == 0);
+  return !failed;
 }
 
 /**
@@ -455,7 +672,7 @@ static void multiGwTunnelsCleanup(bool add) {
  * @return true when successful
  */
 static bool multiGwRulesCleanup(bool add) {
-  return multiGwRunScript(SCRIPT_MODE_CLEANUP, add, NULL, 0, 0, 0);
+  return multiGwPolicyRouting(SCRIPT_MODE_CLEANUP, add, NULL, 0, 0, 0);
 }
 
 /**
@@ -465,7 +682,7 @@ static bool multiGwRulesCleanup(bool add) {
  * @return true when successful
  */
 static bool multiGwRulesGeneric(bool add) {
-  return multiGwRunScript(SCRIPT_MODE_GENERIC, add, NULL, 0, 0, 0);
+  return multiGwPolicyRouting(SCRIPT_MODE_GENERIC, add, NULL, 0, 0, 0);
 }
 
 /**
@@ -480,7 +697,7 @@ static bool multiGwRulesOlsrInterfaces(bool add) {
   unsigned int i = 0;
 
   for (ifn = olsr_cnf->interfaces; ifn; ifn = ifn->next, i++) {
-    if (!multiGwRunScript( //
+    if (!multiGwPolicyRouting( //
         SCRIPT_MODE_OLSRIF,//
         add, //
         ifn->name, //
@@ -505,7 +722,7 @@ static bool multiGwRulesOlsrInterfaces(bool add) {
  * @return true when successful
  */
 static bool multiGwRulesSgwServerTunnel(bool add) {
-  return multiGwRunScript( //
+  return multiGwPolicyRouting( //
       SCRIPT_MODE_SGWSRVTUN,//
       add, //
       server_tunnel_name(), //
@@ -537,7 +754,7 @@ static bool multiGwRulesEgressInterfaces(bool add) {
 
   while (i < olsr_cnf->smart_gw_egress_interfaces_count) {
     egress_if = egress_ifs[i++];
-    if (!multiGwRunScript(SCRIPT_MODE_EGRESSIF, add, egress_if->name, egress_if->tableNr, egress_if->ruleNr, egress_if->bypassRuleNr)) {
+    if (!multiGwPolicyRouting(SCRIPT_MODE_EGRESSIF, add, egress_if->name, egress_if->tableNr, egress_if->ruleNr, egress_if->bypassRuleNr)) {
       ok = false;
       if (add) {
         return ok;
@@ -561,7 +778,7 @@ static bool multiGwRulesSgwTunnels(bool add) {
 
   while (++i <= count) {
     struct interfaceName * ifn = (olsr_cnf->ip_version == AF_INET) ? &sgwTunnel4InterfaceNames[count - i] : &sgwTunnel6InterfaceNames[count - i];
-    if (!multiGwRunScript(SCRIPT_MODE_SGWTUN, add, ifn->name, ifn->tableNr, ifn->ruleNr, ifn->bypassRuleNr)) {
+    if (!multiGwPolicyRouting(SCRIPT_MODE_SGWTUN, add, ifn->name, ifn->tableNr, ifn->ruleNr, ifn->bypassRuleNr)) {
       ok = false;
       if (add) {
         return ok;
@@ -839,6 +1056,8 @@ int olsr_init_gateways(void) {
 
   avl_init(&gateway_tree, avl_comp_default);
 
+  list_head_init(&multiGwScriptQueue);
+
   olsr_gw_list_init(&gw_list_ipv4, olsr_cnf->smart_gw_use_count);
   olsr_gw_list_init(&gw_list_ipv6, olsr_cnf->smart_gw_use_count);
 
@@ -954,6 +1173,9 @@ int olsr_startup_gateways(void) {
   ok = ok && multiGwRulesEgressInterfaces(true);
   ok = ok && multiGwRulesSgwServerTunnel(true);
   ok = ok && multiGwRulesGeneric(true);
+
+  /* the fwmark rules rely on the marking of the script, do not start without it */
+  ok = multiGwScriptFlush() && ok;
   if (!ok) {
     olsr_printf(0, "Could not setup multi-gateway iptables and ip rules\n");
     olsr_shutdown_gateways();
@@ -1036,6 +1258,9 @@ void olsr_shutdown_gateways(void) {
   (void)multiGwRulesSgwTunnels(false);
   (void)multiGwRulesOlsrInterfaces(false);
   (void)multiGwRulesCleanup(false);
+
+  /* the script must have removed its rules before olsrd exits */
+  (void)multiGwScriptFlush();
 }
 
 /**
@@ -73,6 +73,7 @@ generate_hello(void *p)
   struct hello_message hellopacket;
   struct interface_olsr *ifn = (struct interface_olsr *)p;
 
+  olsr_startup_phase("first HELLO");
   olsr_build_hello_packet(&hellopacket, ifn);
 
   if (queue_hello(&hellopacket, ifn))
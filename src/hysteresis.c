@@ -50,6 +50,7 @@
 #include "hysteresis.h"
 #include "defs.h"
 #include "olsr.h"
+#include "mpr.h"
 #include "net_olsr.h"
 #include "ipcalc.h"
 #include "scheduler.h"
@@ -78,14 +79,17 @@ olsr_process_hysteresis(struct link_entry *entry)
     if (entry->L_link_pending == 1) {
       struct ipaddr_str buf;
       OLSR_PRINTF(1, "HYST[%s] link set to NOT pending!\n", olsr_ip_to_string(&buf, &entry->neighbor_iface_addr));
+      olsr_mpr_dirty_links();
       changes_neighborhood = true;
     }
 
     /* Pending = false */
     entry->L_link_pending = 0;
 
-    if (!TIMED_OUT(entry->L_LOST_LINK_time))
+    if (!TIMED_OUT(entry->L_LOST_LINK_time)) {
+      olsr_mpr_dirty_links();
       changes_neighborhood = true;
+    }
 
     /* time = now -1 */
     entry->L_LOST_LINK_time = now_times - 1;
@@ -97,14 +101,17 @@ olsr_process_hysteresis(struct link_entry *entry)
     if (entry->L_link_pending == 0) {
       struct ipaddr_str buf;
       OLSR_PRINTF(1, "HYST[%s] link set to pending!\n", olsr_ip_to_string(&buf, &entry->neighbor_iface_addr));
+      olsr_mpr_dirty_links();
       changes_neighborhood = true;
     }
 
     /* Pending = true */
     entry->L_link_pending = 1;
 
-    if (TIMED_OUT(entry->L_LOST_LINK_time))
+    if (TIMED_OUT(entry->L_LOST_LINK_time)) {
+      olsr_mpr_dirty_links();
       changes_neighborhood = true;
+    }
 
     /* Timer = min (L_time, current time + NEIGHB_HOLD_TIME) */
     entry->L_LOST_LINK_time = MIN(GET_TIMESTAMP(NEIGHB_HOLD_TIME * MSEC_PER_SEC), entry->link_timer->timer_clock);
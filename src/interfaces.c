@@ -115,9 +115,18 @@ olsr_init_interfacedb(void)
     }
   }
 
-  /* Kick a periodic timer for the network interface update function */
-  olsr_start_timer((unsigned int)olsr_cnf->nic_chgs_pollrate * MSEC_PER_SEC, 5, OLSR_TIMER_PERIODIC, &check_interface_updates, NULL,
-                   interface_poll_timer_cookie);
+  /*
+   * Kick a periodic timer for the network interface update function,
+   * but only if the OS does not report interface changes by itself
+   * (the rtnetlink monitor socket on linux)
+   */
+#ifdef __linux__
+  if (olsr_cnf->rt_monitor_socket < 0)
+#endif /* __linux__ */
+  {
+    olsr_start_timer((unsigned int)olsr_cnf->nic_chgs_pollrate * MSEC_PER_SEC, 5, OLSR_TIMER_PERIODIC, &check_interface_updates, NULL,
+                     interface_poll_timer_cookie);
+  }
 
   return (ifnet == NULL) ? 0 : 1;
 }
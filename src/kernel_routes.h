@@ -64,6 +64,30 @@ int olsr_ioctl_del_route6(const struct rt_entry *rt);
     const struct olsr_ip_prefix *dst, bool set, bool del_similar, bool blackhole);
 
   int rtnetlink_register_socket(int);
+
+  /* a unicast route read from the kernel FIB */
+  struct olsr_os_route {
+    struct olsr_ip_prefix dst;
+    union olsr_ip_addr gateway;        /* destination if there is no gateway */
+    int if_index;
+    uint32_t metric;
+    uint32_t table;
+    uint8_t protocol;
+  };
+
+  typedef void (*olsr_os_route_cb) (const struct olsr_os_route *, void *);
+
+  int olsr_os_dump_routes(int family, olsr_os_route_cb cb, void *context);
+
+  /* a policy rule, see olsr_os_policy_rules() */
+  struct olsr_os_rule {
+    uint32_t priority;
+    uint32_t table;
+    uint32_t fwmark;                   /* 0 to match any fwmark */
+    const char *if_name;               /* NULL to match any input interface */
+  };
+
+  unsigned int olsr_os_policy_rules(int family, const struct olsr_os_rule *rules, unsigned int count, bool set);
 #endif /* __linux__ */
 
 void olsr_os_niit_4to6_route(const struct olsr_ip_prefix *dst_v4, bool set);
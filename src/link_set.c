@@ -67,6 +67,9 @@ struct list_node link_entry_head;
 
 bool link_changes = false; /* is set if changes occur in MPRS set */
 
+/* dense table of the lookup keys of all link entries */
+struct link_table link_table;
+
 void
 signal_link_changes(bool val)
 {                               /* XXX ugly */
@@ -80,6 +83,112 @@ static struct link_entry *add_link_entry(const union olsr_ip_addr *, const union
 static int get_neighbor_status(const union olsr_ip_addr *);
 static void olsr_expire_link_sym_timer(void *context);
 
+/**
+ * Get the key of an address in the link table: the address
+ * itself for IPv4, the folded address for IPv6.
+ *
+ * @param addr the address
+ * @return the key
+ */
+static uint32_t
+link_table_key(const union olsr_ip_addr *addr)
+{
+  uint32_t words[4];
+
+  if (olsr_cnf->ip_version == AF_INET) {
+    return addr->v4.s_addr;
+  }
+
+  memcpy(words, &addr->v6, sizeof(words));
+  return words[0] ^ words[1] ^ words[2] ^ words[3];
+}
+
+/**
+ * Append a link to the link table, after its neighbor is set.
+ *
+ * @param link the link entry
+ */
+static void
+link_table_add(struct link_entry *link)
+{
+  unsigned int idx;
+
+  if (link_table.count == link_table.size) {
+    link_table.size = link_table.size ? 2 * link_table.size : 32;
+    link_table.entry = olsr_realloc(link_table.entry, link_table.size * sizeof(*link_table.entry), "link table entries");
+    link_table.remote_key = olsr_realloc(link_table.remote_key, link_table.size * sizeof(*link_table.remote_key),
+                                         "link table remote keys");
+    link_table.neighbor_key = olsr_realloc(link_table.neighbor_key, link_table.size * sizeof(*link_table.neighbor_key),
+                                           "link table neighbor keys");
+  }
+
+  idx = link_table.count++;
+  link->link_index = idx;
+  link_table.entry[idx] = link;
+  link_table.remote_key[idx] = link_table_key(&link->neighbor_iface_addr);
+  link_table.neighbor_key[idx] = link_table_key(&link->neighbor->neighbor_main_addr);
+}
+
+/**
+ * Free the arrays of the link table.
+ */
+static void
+link_table_free(void)
+{
+  free(link_table.entry);
+  free(link_table.remote_key);
+  free(link_table.neighbor_key);
+  memset(&link_table, 0, sizeof(link_table));
+}
+
+/**
+ * Remove a link from the link table, keeping the order
+ * of the other links. The arrays are freed with the
+ * last link.
+ *
+ * @param link the link entry
+ */
+static void
+link_table_remove(struct link_entry *link)
+{
+  unsigned int idx = link->link_index;
+  unsigned int tail = link_table.count - idx - 1;
+
+  assert(link_table.entry[idx] == link);
+
+  memmove(&link_table.entry[idx], &link_table.entry[idx + 1], tail * sizeof(*link_table.entry));
+  memmove(&link_table.remote_key[idx], &link_table.remote_key[idx + 1], tail * sizeof(*link_table.remote_key));
+  memmove(&link_table.neighbor_key[idx], &link_table.neighbor_key[idx + 1], tail * sizeof(*link_table.neighbor_key));
+  link_table.count--;
+
+  if (link_table.count == 0) {
+    link_table_free();
+    return;
+  }
+
+  for (; idx < link_table.count; idx++) {
+    link_table.entry[idx]->link_index = idx;
+  }
+}
+
+/**
+ * Update the link table after the main address of
+ * a neighbor changed.
+ *
+ * @param neighbor the neighbor entry
+ */
+void
+olsr_update_link_table_neighbor(const struct neighbor_entry *neighbor)
+{
+  unsigned int idx;
+
+  for (idx = 0; idx < link_table.count; idx++) {
+    if (link_table.entry[idx]->neighbor == neighbor) {
+      link_table.neighbor_key[idx] = link_table_key(&neighbor->neighbor_main_addr);
+    }
+  }
+}
+
 void
 olsr_init_link_set(void)
 {
@@ -104,6 +213,7 @@ void olsr_reset_all_links(void) {
 
     link->neighbor->is_mpr = false;
     link->neighbor->status = NOT_SYM;
+    olsr_mpr_invalidate();
   } OLSR_FOR_ALL_LINK_ENTRIES_END(link)
 
 
@@ -223,6 +333,8 @@ get_best_link_to_neighbor(const union olsr_ip_addr *remote)
   int curr_metric = MAX_IF_METRIC;
   olsr_linkcost curr_lcost = LINK_COST_BROKEN;
   olsr_linkcost tmp_lc;
+  uint32_t key;
+  unsigned int idx;
 
   /* main address lookup */
   main_addr = mid_lookup_main_addr(remote);
@@ -236,10 +348,16 @@ get_best_link_to_neighbor(const union olsr_ip_addr *remote)
   good_link = NULL;
   backup_link = NULL;
 
+  key = link_table_key(main_addr);
+
   /* loop through all links that we have */
-  OLSR_FOR_ALL_LINK_ENTRIES(walker) {
+  for (idx = 0; idx < link_table.count; idx++) {
 
     /* if this is not a link to the neighour in question, skip */
+    if (link_table.neighbor_key[idx] != key)
+      continue;
+
+    walker = link_table.entry[idx];
     if (!ipequal(&walker->neighbor->neighbor_main_addr, main_addr))
       continue;
 
@@ -302,7 +420,6 @@ get_best_link_to_neighbor(const union olsr_ip_addr *remote)
       }
     }
   }
-  OLSR_FOR_ALL_LINK_ENTRIES_END(walker);
 
   /*
    * if we haven't found any symmetric links, try to return an asymmetric link.
@@ -394,13 +511,46 @@ olsr_delete_link_entry(struct link_entry *link)
   olsr_stop_timer(link->link_loss_timer);
   link->link_loss_timer = NULL;
   list_remove(&link->link_list);
+  link_table_remove(link);
 
   free(link->if_name);
   free(link);
 
+  olsr_mpr_dirty_links();
   changes_neighborhood = true;
 }
 
+/**
+ * Re-evaluate the link quality multipliers of all links, e.g. after
+ * the interface configuration has been reloaded.
+ */
+void
+olsr_update_link_multipliers(void)
+{
+  struct link_entry *link;
+
+  OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    set_loss_link_multiplier(link);
+  }
+  OLSR_FOR_ALL_LINK_ENTRIES_END(link);
+}
+
+/**
+ * Delete all link entries, on shutdown.
+ */
+void
+olsr_delete_all_link_entries(void)
+{
+  struct link_entry *link;
+
+  OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    olsr_delete_link_entry(link);
+  }
+  OLSR_FOR_ALL_LINK_ENTRIES_END(link);
+
+  link_table_free();
+}
+
 /**
  * Delete all link entries matching a given interface address.
  */
@@ -457,6 +607,7 @@ olsr_expire_link_sym_timer(void *context)
 
   link->prev_status = lookup_link_status(link);
   update_neighbor_status(link->neighbor, get_neighbor_status(&link->neighbor_iface_addr));
+  olsr_mpr_dirty_links();
   changes_neighborhood = true;
 }
 
@@ -624,6 +775,10 @@ add_link_entry(const union olsr_ip_addr *local, const union olsr_ip_addr *remote
   neighbor->linkcount++;
   new_link->neighbor = neighbor;
 
+  link_table_add(new_link);
+
+  olsr_mpr_dirty_links();
+
   return new_link;
 }
 
@@ -636,14 +791,14 @@ add_link_entry(const union olsr_ip_addr *local, const union olsr_ip_addr *remote
 int
 check_neighbor_link(const union olsr_ip_addr *int_addr)
 {
-  struct link_entry *link;
+  uint32_t key = link_table_key(int_addr);
+  unsigned int idx;
 
-  OLSR_FOR_ALL_LINK_ENTRIES(link) {
-    if (ipequal(int_addr, &link->neighbor_iface_addr)) {
-      return lookup_link_status(link);
+  for (idx = 0; idx < link_table.count; idx++) {
+    if (link_table.remote_key[idx] == key && ipequal(int_addr, &link_table.entry[idx]->neighbor_iface_addr)) {
+      return lookup_link_status(link_table.entry[idx]);
     }
   }
-  OLSR_FOR_ALL_LINK_ENTRIES_END(link);
 
   return UNSPEC_LINK;
 }
@@ -659,9 +814,17 @@ check_neighbor_link(const union olsr_ip_addr *int_addr)
 struct link_entry *
 lookup_link_entry(const union olsr_ip_addr *remote, const union olsr_ip_addr *remote_main, const struct interface_olsr *local)
 {
-  struct link_entry *link;
+  uint32_t key = link_table_key(remote);
+  unsigned int idx;
 
-  OLSR_FOR_ALL_LINK_ENTRIES(link) {
+  for (idx = 0; idx < link_table.count; idx++) {
+    struct link_entry *link;
+
+    if (link_table.remote_key[idx] != key) {
+      continue;
+    }
+
+    link = link_table.entry[idx];
     if (ipequal(remote, &link->neighbor_iface_addr)
         && (link->if_name ? !strcmp(link->if_name, local->int_name) : ipequal(&local->ip_addr, &link->local_iface_addr))) {
       /* check the remote-main address only if there is one given */
@@ -676,7 +839,6 @@ lookup_link_entry(const union olsr_ip_addr *remote, const union olsr_ip_addr *re
       return link;
     }
   }
-  OLSR_FOR_ALL_LINK_ENTRIES_END(link);
 
   return NULL;
 }
@@ -697,9 +859,11 @@ update_link_entry(const union olsr_ip_addr *local, const union olsr_ip_addr *rem
                   const struct interface_olsr *in_if)
 {
   struct link_entry *entry;
+  int link_status;
 
   /* Add if not registered */
   entry = add_link_entry(local, remote, &message->source_addr, message->vtime, message->htime, in_if);
+  link_status = lookup_link_status(entry);
 
   /* Update ASYM_time */
   entry->vtime = message->vtime;
@@ -735,6 +899,11 @@ update_link_entry(const union olsr_ip_addr *local, const union olsr_ip_addr *rem
   if (olsr_cnf->use_hysteresis)
     olsr_process_hysteresis(entry);
 
+  /* the best link to a neighbor prefers symmetric links */
+  if (lookup_link_status(entry) != link_status) {
+    olsr_mpr_dirty_links();
+  }
+
   /* Update neighbor */
   update_neighbor_status(entry->neighbor, get_neighbor_status(remote));
 
@@ -764,6 +933,7 @@ replace_neighbor_link_set(const struct neighbor_entry *old, struct neighbor_entr
 
     if (link->neighbor == old) {
       link->neighbor = new;
+      link_table.neighbor_key[link->link_index] = link_table_key(&new->neighbor_main_addr);
       retval++;
     }
   }
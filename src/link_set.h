@@ -95,9 +95,25 @@ struct link_entry {
   olsr_linkcost linkcost;
 
   struct list_node link_list;          /* double linked list of all link entries */
+  unsigned int link_index;             /* position in the link table */
   uint32_t linkquality[0];
 };
 
+/*
+ * The link table keeps the keys that the link lookups compare in dense
+ * arrays, so that a lookup scans packed memory and only touches the link
+ * entries that match. The arrays are in the order of the link list and
+ * are indexed by link_entry->link_index, which only changes when a link
+ * before it is deleted.
+ */
+struct link_table {
+  unsigned int count;                  /* number of links */
+  unsigned int size;                   /* allocated size of the arrays */
+  struct link_entry **entry;
+  uint32_t *remote_key;                /* key of neighbor_iface_addr */
+  uint32_t *neighbor_key;              /* key of neighbor->neighbor_main_addr */
+};
+
 /* INLINE to recast from link_list back to link_entry */
 LISTNODE2STRUCT(list2link, struct link_entry, link_list);
 
@@ -119,6 +135,7 @@ LISTNODE2STRUCT(list2link, struct link_entry, link_list);
 
 /* Externals */
 extern struct list_node link_entry_head;
+extern struct link_table link_table;
 extern bool link_changes;
 
 /* Function prototypes */
@@ -127,6 +144,8 @@ void olsr_set_link_timer(struct link_entry *, unsigned int);
 void olsr_init_link_set(void);
 void olsr_reset_all_links(void);
 void olsr_delete_link_entry_by_ip(const union olsr_ip_addr *);
+void olsr_delete_all_link_entries(void);
+void olsr_update_link_multipliers(void);
 void olsr_expire_link_hello_timer(void *);
 void signal_link_changes(bool);        /* XXX ugly */
 
@@ -139,6 +158,7 @@ struct link_entry *update_link_entry(const union olsr_ip_addr *, const union ols
 
 int check_neighbor_link(const union olsr_ip_addr *);
 int replace_neighbor_link_set(const struct neighbor_entry *, struct neighbor_entry *);
+void olsr_update_link_table_neighbor(const struct neighbor_entry *);
 int lookup_link_status(const struct link_entry *);
 void olsr_update_packet_loss_hello_int(struct link_entry *, olsr_reltime);
 void olsr_received_hello_handler(struct link_entry *entry);
@@ -50,10 +50,12 @@
 #include "log.h"
 #include "net_os.h"
 #include "ifnet.h"
+#include "olsr_metrics.h"
 
 #include <assert.h>
 #include <linux/types.h>
 #include <linux/rtnetlink.h>
+#include <linux/fib_rules.h>
 
 //ipip includes
 #include <netinet/in.h>
@@ -73,7 +75,7 @@
  * from /usr/include/linux/netlink.h and adapted for ARM
  */
 #define MY_NLMSG_NEXT(nlh,len)   ((len) -= NLMSG_ALIGN((nlh)->nlmsg_len), \
-          (struct nlmsghdr*)ARM_NOWARN_ALIGN((((char*)(nlh)) + NLMSG_ALIGN((nlh)->nlmsg_len)))
+          (struct nlmsghdr*)ARM_NOWARN_ALIGN((((char*)(nlh)) + NLMSG_ALIGN((nlh)->nlmsg_len))))
 
 
 static void rtnetlink_read(int sock, void *, unsigned int);
@@ -133,7 +135,7 @@ static void netlink_process_link(struct nlmsghdr *h)
   }
 
   oif = ifaceName ? olsrif_ifwithname(ifaceName) : NULL;
-  up = (getInterfaceLinkState(ifaceName) != LINKSTATE_DOWN) && ((ifi->ifi_flags & IFF_UP) != 0);
+  up = (h->nlmsg_type == RTM_NEWLINK) && (getInterfaceLinkState(ifaceName) != LINKSTATE_DOWN) && ((ifi->ifi_flags & IFF_UP) != 0);
 
   if (!iface && up) {
     if (oif) {
@@ -143,6 +145,9 @@ static void netlink_process_link(struct nlmsghdr *h)
   } else if (iface && !up) {
     /* try to take interface down, will trigger ifchange */
     olsr_remove_interface(iface->olsr_if);
+  } else if (iface && iface->olsr_if->cnf->autodetect_chg) {
+    /* interface is still up, but flags or mtu might have changed */
+    chk_if_changed(iface->olsr_if);
   }
 
   if (!iface && !oif) {
@@ -151,9 +156,41 @@ static void netlink_process_link(struct nlmsghdr *h)
   }
 }
 
+static void netlink_process_addr(struct nlmsghdr *h)
+{
+  struct ifaddrmsg *ifa = (struct ifaddrmsg *) NLMSG_DATA(h);
+  struct interface_olsr *iface;
+  struct olsr_if *oif;
+  char namebuffer[IF_NAMESIZE];
+
+  if (ifa->ifa_family != olsr_cnf->ip_version) {
+    /* we are not interested in addresses of the other ip version */
+    return;
+  }
+
+  iface = if_ifwithindex(ifa->ifa_index);
+  if (iface) {
+    /* only recheck the interface the address change belongs to */
+    if (iface->olsr_if->cnf->autodetect_chg) {
+      chk_if_changed(iface->olsr_if);
+    }
+    return;
+  }
+
+  if (h->nlmsg_type != RTM_NEWADDR || !if_indextoname(ifa->ifa_index, namebuffer)) {
+    return;
+  }
+
+  /* a configured but inactive interface might just have received its address */
+  oif = olsrif_ifwithname(namebuffer);
+  if (oif && !oif->configured && !oif->host_emul && oif->cnf->autodetect_chg) {
+    chk_if_up(oif, 3);
+  }
+}
+
 static void rtnetlink_read(int sock, void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
 {
-  int len, plen;
+  int len;
   struct iovec iov;
   struct sockaddr_nl nladdr;
   struct msghdr msg = {
@@ -167,31 +204,43 @@ static void rtnetlink_read(int sock, void *data __attribute__ ((unused)), unsign
   };
 
   char buffer[4096];
-  struct nlmsghdr *nlh = (struct nlmsghdr *)ARM_NOWARN_ALIGN(buffer);
+  struct nlmsghdr *nlh;
   int ret;
 
   iov.iov_base = (void *) buffer;
   iov.iov_len = sizeof(buffer);
 
   while ((ret = recvmsg(sock, &msg, MSG_DONTWAIT)) >= 0) {
-    /*check message*/
-    len = nlh->nlmsg_len;
-    plen = len - sizeof(nlh);
-    if (len > ret || plen < 0) {
-      OLSR_PRINTF(1,"Malformed netlink message: "
-             "len=%d left=%d plen=%d\n",
-              len, ret, plen);
-      return;
+    len = ret;
+    for (nlh = (struct nlmsghdr *)ARM_NOWARN_ALIGN(buffer); len > 0 && NLMSG_OK(nlh, (unsigned int)len); nlh = MY_NLMSG_NEXT(nlh, len)) {
+      OLSR_PRINTF(3, "Netlink message received: type 0x%x\n", nlh->nlmsg_type);
+
+      switch (nlh->nlmsg_type) {
+        case RTM_NEWLINK:
+        case RTM_DELLINK:
+          /* handle ifup/ifdown */
+          netlink_process_link(nlh);
+          break;
+        case RTM_NEWADDR:
+        case RTM_DELADDR:
+          /* handle address changes */
+          netlink_process_addr(nlh);
+          break;
+        default:
+          break;
+      }
     }
 
-    OLSR_PRINTF(3, "Netlink message received: type 0x%x\n", nlh->nlmsg_type);
-    if ((nlh->nlmsg_type == RTM_NEWLINK) || ( nlh->nlmsg_type == RTM_DELLINK)) {
-      /* handle ifup/ifdown */
-      netlink_process_link(nlh);
+    if (len > 0) {
+      OLSR_PRINTF(1,"Malformed netlink message: %d bytes left\n", len);
     }
   }
 
-  if (errno != EAGAIN) {
+  if (errno == ENOBUFS) {
+    /* kernel dropped notifications, so we have to check all interfaces */
+    OLSR_PRINTF(1,"netlink monitor overrun, checking all interfaces\n");
+    check_interface_updates(NULL);
+  } else if (errno != EAGAIN) {
     OLSR_PRINTF(1,"netlink listen error %u - %s\n",errno,strerror(errno));
   }
 }
@@ -272,6 +321,131 @@ olsr_netlink_send(struct nlmsghdr *nl_hdr)
   return -l_err->error;
 }
 
+/**
+ * Read the unicast routes of the kernel FIB with a RTM_GETROUTE dump
+ * on a separate netlink socket.
+ *
+ * @param family AF_INET or AF_INET6
+ * @param cb callback for each route
+ * @param context passed to the callback
+ * @return 0 on success, -1 on error
+ */
+int
+olsr_os_dump_routes(int family, olsr_os_route_cb cb, void *context)
+{
+  struct {
+    struct nlmsghdr n;
+    struct rtmsg r;
+  } req;
+  char rcvbuf[8192];
+  struct sockaddr_nl nladdr;
+  int sock, ret = -1;
+  bool done = false;
+
+  sock = socket(AF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+  if (sock < 0) {
+    olsr_syslog(OLSR_LOG_ERR, "Cannot open netlink socket for route dump (%d: %s)", errno, strerror(errno));
+    return -1;
+  }
+
+  memset(&req, 0, sizeof(req));
+  req.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+  req.n.nlmsg_type = RTM_GETROUTE;
+  req.n.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+  req.n.nlmsg_seq = 1;
+  req.r.rtm_family = family;
+
+  memset(&nladdr, 0, sizeof(nladdr));
+  nladdr.nl_family = AF_NETLINK;
+
+  if (sendto(sock, &req, req.n.nlmsg_len, 0, (struct sockaddr *)&nladdr, sizeof(nladdr)) < 0) {
+    olsr_syslog(OLSR_LOG_ERR, "Cannot send route dump request (%d: %s)", errno, strerror(errno));
+    close(sock);
+    return -1;
+  }
+
+  while (!done) {
+    struct nlmsghdr *h;
+    int len = recv(sock, rcvbuf, sizeof(rcvbuf), 0);
+
+    if (len < 0 && errno == EINTR) {
+      continue;
+    }
+    if (len <= 0) {
+      olsr_syslog(OLSR_LOG_ERR, "Error while reading route dump (%d: %s)", errno, strerror(errno));
+      break;
+    }
+
+    for (h = (struct nlmsghdr *)ARM_NOWARN_ALIGN(rcvbuf); NLMSG_OK(h, (unsigned int)len); h = MY_NLMSG_NEXT(h, len)) {
+      struct rtmsg *rtm;
+      struct rtattr *rta;
+      struct olsr_os_route route;
+      int rta_len;
+      bool has_dst = false, has_gw = false;
+
+      if (h->nlmsg_type == NLMSG_DONE) {
+        done = true;
+        ret = 0;
+        break;
+      }
+      if (h->nlmsg_type == NLMSG_ERROR) {
+        done = true;
+        break;
+      }
+      if (h->nlmsg_type != RTM_NEWROUTE) {
+        continue;
+      }
+
+      rtm = (struct rtmsg *)NLMSG_DATA(h);
+      if (rtm->rtm_family != family || rtm->rtm_type != RTN_UNICAST || (rtm->rtm_flags & RTM_F_CLONED) != 0) {
+        continue;
+      }
+
+      memset(&route, 0, sizeof(route));
+      route.dst.prefix_len = rtm->rtm_dst_len;
+      route.table = rtm->rtm_table;
+      route.protocol = rtm->rtm_protocol;
+      route.if_index = -1;
+
+      rta_len = RTM_PAYLOAD(h);
+      for (rta = RTM_RTA(rtm); RTA_OK(rta, rta_len); rta = RTA_NEXT(rta, rta_len)) {
+        switch (rta->rta_type) {
+        case RTA_DST:
+          memcpy(&route.dst.prefix, RTA_DATA(rta), family == AF_INET ? sizeof(struct in_addr) : sizeof(struct in6_addr));
+          has_dst = true;
+          break;
+        case RTA_GATEWAY:
+          memcpy(&route.gateway, RTA_DATA(rta), family == AF_INET ? sizeof(struct in_addr) : sizeof(struct in6_addr));
+          has_gw = true;
+          break;
+        case RTA_OIF:
+          memcpy(&route.if_index, RTA_DATA(rta), sizeof(route.if_index));
+          break;
+        case RTA_PRIORITY:
+          memcpy(&route.metric, RTA_DATA(rta), sizeof(route.metric));
+          break;
+        case RTA_TABLE:
+          memcpy(&route.table, RTA_DATA(rta), sizeof(route.table));
+          break;
+        default:
+          break;
+        }
+      }
+
+      if (!has_dst && route.dst.prefix_len != 0) {
+        continue;
+      }
+      if (!has_gw) {
+        route.gateway = route.dst.prefix;
+      }
+      cb(&route, context);
+    }
+  }
+
+  close(sock);
+  return ret;
+}
+
 int olsr_os_policy_rule(int family, int rttable, uint32_t priority, const char *if_name, bool set) {
   struct olsr_rtreq req;
   int err;
@@ -304,6 +478,143 @@ int olsr_os_policy_rule(int family, int rttable, uint32_t priority, const char *
   return err;
 }
 
+/* number of rule messages sent in a single netlink datagram */
+#define OLSR_RULE_BATCH 32
+
+/* room for a rule message with all attributes */
+#define OLSR_RULE_MSG_SIZE NLMSG_ALIGN(NLMSG_LENGTH(sizeof(struct fib_rule_hdr)) + 3 * RTA_SPACE(sizeof(uint32_t)) + RTA_SPACE(IFNAMSIZ))
+
+/**
+ * Send a batch of rule messages in one datagram and collect the acks.
+ *
+ * @param buf the rule messages
+ * @param len the length of the rule messages
+ * @param rules the rules of the messages, the sequence number of a
+ *   message is the index of its rule
+ * @param count the number of messages
+ * @param set true for added rules, false for deleted ones
+ * @return the number of rules that failed
+ */
+static unsigned int
+olsr_os_send_rule_batch(char *buf, size_t len, const struct olsr_os_rule *rules, unsigned int count, bool set)
+{
+  char rcvbuf[4096];
+  struct sockaddr_nl nladdr;
+  struct iovec iov;
+  struct msghdr msg;
+  unsigned int acked = 0, failed = 0;
+
+  memset(&nladdr, 0, sizeof(nladdr));
+  memset(&msg, 0, sizeof(msg));
+  nladdr.nl_family = AF_NETLINK;
+
+  msg.msg_name = &nladdr;
+  msg.msg_namelen = sizeof(nladdr);
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+
+  iov.iov_base = buf;
+  iov.iov_len = len;
+  if (sendmsg(olsr_cnf->rtnl_s, &msg, 0) <= 0) {
+    olsr_syslog(OLSR_LOG_ERR, "Cannot send data to netlink socket (%d: %s)", errno, strerror(errno));
+    return count;
+  }
+
+  while (acked < count) {
+    struct nlmsghdr *h;
+    int ret;
+
+    iov.iov_base = rcvbuf;
+    iov.iov_len = sizeof(rcvbuf);
+    ret = recvmsg(olsr_cnf->rtnl_s, &msg, 0);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ret <= 0) {
+      olsr_syslog(OLSR_LOG_ERR, "Error while reading answer to netlink message (%d: %s)", errno, strerror(errno));
+      return failed + count - acked;
+    }
+
+    for (h = (struct nlmsghdr *)ARM_NOWARN_ALIGN(rcvbuf); NLMSG_OK(h, (unsigned int)ret); h = MY_NLMSG_NEXT(h, ret)) {
+      struct nlmsgerr *l_err;
+
+      if (h->nlmsg_type != NLMSG_ERROR || h->nlmsg_len < NLMSG_LENGTH(sizeof(struct nlmsgerr))) {
+        continue;
+      }
+      acked++;
+
+      l_err = (struct nlmsgerr *)NLMSG_DATA(h);
+      if (!l_err->error || (set && l_err->error == -EEXIST) || (!set && l_err->error == -ENOENT)) {
+        continue;
+      }
+
+      failed++;
+      if (h->nlmsg_seq < count) {
+        const struct olsr_os_rule *rule = &rules[h->nlmsg_seq];
+        olsr_syslog(OLSR_LOG_ERR, "Error on %s policy rule %u (table %u, fwmark %u, iif %s): %s",
+            set ? "inserting" : "deleting", rule->priority, rule->table, rule->fwmark,
+            rule->if_name ? rule->if_name : "any", strerror(-l_err->error));
+      }
+    }
+  }
+  return failed;
+}
+
+/**
+ * Add or delete a set of policy rules. The rules are sent to the kernel
+ * in batches, a single datagram carries up to OLSR_RULE_BATCH rules.
+ * Adding an existing rule or deleting a missing one is not an error.
+ *
+ * @param family AF_INET or AF_INET6
+ * @param rules the rules
+ * @param count the number of rules
+ * @param set true to add the rules, false to delete them
+ * @return the number of rules that failed
+ */
+unsigned int
+olsr_os_policy_rules(int family, const struct olsr_os_rule *rules, unsigned int count, bool set)
+{
+  char buf[OLSR_RULE_BATCH * OLSR_RULE_MSG_SIZE];
+  unsigned int failed = 0;
+
+  while (count > 0) {
+    unsigned int batch = count < OLSR_RULE_BATCH ? count : OLSR_RULE_BATCH;
+    size_t len = 0;
+    unsigned int i;
+
+    memset(buf, 0, sizeof(buf));
+    for (i = 0; i < batch; i++) {
+      const struct olsr_os_rule *rule = &rules[i];
+      struct nlmsghdr *n = (struct nlmsghdr *)ARM_NOWARN_ALIGN(buf + len);
+      struct fib_rule_hdr *frh = NLMSG_DATA(n);
+
+      n->nlmsg_len = NLMSG_LENGTH(sizeof(struct fib_rule_hdr));
+      n->nlmsg_type = set ? RTM_NEWRULE : RTM_DELRULE;
+      n->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK | (set ? NLM_F_CREATE | NLM_F_EXCL : 0);
+      n->nlmsg_seq = i;
+
+      frh->family = family;
+      frh->action = FR_ACT_TO_TBL;
+      frh->table = rule->table < 256 ? rule->table : RT_TABLE_UNSPEC;
+
+      olsr_netlink_addreq(n, OLSR_RULE_MSG_SIZE, FRA_PRIORITY, &rule->priority, sizeof(rule->priority));
+      olsr_netlink_addreq(n, OLSR_RULE_MSG_SIZE, FRA_TABLE, &rule->table, sizeof(rule->table));
+      if (rule->fwmark) {
+        olsr_netlink_addreq(n, OLSR_RULE_MSG_SIZE, FRA_FWMARK, &rule->fwmark, sizeof(rule->fwmark));
+      }
+      if (rule->if_name) {
+        olsr_netlink_addreq(n, OLSR_RULE_MSG_SIZE, FRA_IIFNAME, rule->if_name, strlen(rule->if_name) + 1);
+      }
+      len += NLMSG_ALIGN(n->nlmsg_len);
+    }
+
+    failed += olsr_os_send_rule_batch(buf, len, rules, batch, set);
+    rules += batch;
+    count -= batch;
+  }
+  return failed;
+}
+
 static int
 olsr_add_ip(int ifindex, union olsr_ip_addr *ip, const char *l, bool create)
 {
@@ -499,6 +810,9 @@ void olsr_os_inetgw_tunnel_route(uint32_t if_idx, bool ipv4, bool set, uint8_t t
   }
 }
 
+/* latency of setting and removing a route, registered on first use */
+static struct olsr_metric *rt_entry_metrics[2];
+
 static int olsr_os_process_rt_entry(unsigned char af_family, const struct rt_entry *rt, bool set) {
   int metric;
   uint32_t table;
@@ -506,6 +820,7 @@ static int olsr_os_process_rt_entry(unsigned char af_family, const struct rt_ent
   union olsr_ip_addr *src;
   bool hostRoute;
   int err;
+  uint64_t start = olsr_metrics_start();
 
   /* calculate metric */
   if (FIBM_FLAT == olsr_cnf->fib_metric) {
@@ -605,6 +920,14 @@ static int olsr_os_process_rt_entry(unsigned char af_family, const struct rt_ent
     olsr_syslog(OLSR_LOG_ERR, ". %s (%d)", err == 0 ? "successful" : "failed", err);
   }
 
+  if (start) {
+    if (!rt_entry_metrics[set]) {
+      rt_entry_metrics[set] = olsr_metric_get(OLSR_METRIC_LATENCY, "kernel_route",
+          "Programming of a route over netlink", "operation", set ? "add" : "delete");
+    }
+    olsr_metrics_stop(rt_entry_metrics[set], start);
+  }
+
   return err;
 }
 
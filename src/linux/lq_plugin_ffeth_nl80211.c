@@ -50,6 +50,7 @@
 #include "tc_set.h"
 #include "link_set.h"
 #include "lq_plugin.h"
+#include "lq_smoothing.h"
 #include "olsr_spf.h"
 #include "lq_packet.h"
 #include "packet.h"
@@ -125,6 +126,7 @@ lq_ffeth_nl80211_handle_lqchange(void) {
   struct link_entry *link;
 
   bool triggered = false;
+  int pending = 0;
 
   OLSR_FOR_ALL_LINK_ENTRIES(link) {
     bool relevant = false;
@@ -136,25 +138,13 @@ lq_ffeth_nl80211_handle_lqchange(void) {
       lq->lq.valueLq, lq->lq.valueNlq);
 #endif
 
-    if (lq->smoothed_lq.valueLq < lq->lq.valueLq) {
-      if (lq->lq.valueLq >= 254 || lq->lq.valueLq - lq->smoothed_lq.valueLq > lq->smoothed_lq.valueLq/10) {
-        relevant = true;
-      }
+    if ((lq->smoothed_lq.valueLq < lq->lq.valueLq && lq->lq.valueLq >= 254)
+        || olsr_is_relevant_lq_change(lq->smoothed_lq.valueLq, lq->lq.valueLq)) {
+      relevant = true;
     }
-    else if (lq->smoothed_lq.valueLq > lq->lq.valueLq) {
-      if (lq->smoothed_lq.valueLq - lq->lq.valueLq > lq->smoothed_lq.valueLq/10) {
-        relevant = true;
-      }
-    }
-    if (lq->smoothed_lq.valueNlq < lq->lq.valueNlq) {
-      if (lq->lq.valueNlq >= 254 || lq->lq.valueNlq - lq->smoothed_lq.valueNlq > lq->smoothed_lq.valueNlq/10) {
-        relevant = true;
-      }
-    }
-    else if (lq->smoothed_lq.valueNlq > lq->lq.valueNlq) {
-      if (lq->smoothed_lq.valueNlq - lq->lq.valueNlq > lq->smoothed_lq.valueNlq/10) {
-        relevant = true;
-      }
+    if ((lq->smoothed_lq.valueNlq < lq->lq.valueNlq && lq->lq.valueNlq >= 254)
+        || olsr_is_relevant_lq_change(lq->smoothed_lq.valueNlq, lq->lq.valueNlq)) {
+      relevant = true;
     }
 
     if (relevant) {
@@ -162,6 +152,11 @@ lq_ffeth_nl80211_handle_lqchange(void) {
       link->linkcost = lq_calc_cost_ffeth_nl80211(&lq->smoothed_lq);
       triggered = true;
     }
+    else if ((lq->smoothed_lq.valueLq != lq->lq.valueLq || lq->smoothed_lq.valueNlq != lq->lq.valueNlq)
+        && !(lq->smoothed_lq.valueLq >= 254 && lq->smoothed_lq.valueNlq >= 254)) {
+      /* will be updated by the second pass if any other link triggers */
+      pending++;
+    }
   } OLSR_FOR_ALL_LINK_ENTRIES_END(link)
 
   if (!triggered) {
@@ -169,6 +164,10 @@ lq_ffeth_nl80211_handle_lqchange(void) {
   }
 
   OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    if (pending == 0) {
+      break;
+    }
+
     lq = (struct lq_ffeth_hello *)link->linkquality;
 
     if (lq->smoothed_lq.valueLq >= 254 && lq->smoothed_lq.valueNlq >= 254) {
@@ -181,6 +180,7 @@ lq_ffeth_nl80211_handle_lqchange(void) {
 
     memcpy(&lq->smoothed_lq, &lq->lq, sizeof(struct lq_ffeth));
     link->linkcost = lq_calc_cost_ffeth_nl80211(&lq->smoothed_lq);
+    pending--;
   } OLSR_FOR_ALL_LINK_ENTRIES_END(link)
 
   olsr_relevant_linkcost_change();
@@ -193,6 +193,7 @@ lq_parser_ffeth_nl80211(struct olsr *olsr, struct interface_olsr *in_if, union o
   struct link_entry *lnk;
   struct lq_ffeth_hello *lq;
   uint32_t seq_diff;
+  uint16_t received, total;
 
   /* Find main address */
   main_addr = mid_lookup_main_addr(from_addr);
@@ -224,9 +225,16 @@ lq_parser_ffeth_nl80211(struct olsr *olsr, struct interface_olsr *in_if, union o
     seq_diff = 1;
   }
 
-  lq->received[lq->activePtr]++;
+  received = lq->received[lq->activePtr]++;
+  total = lq->total[lq->activePtr];
   lq->total[lq->activePtr] += seq_diff;
 
+  /* keep the window sums up to date */
+  if (lq->activePtr < lq->windowSize) {
+    lq->receivedSum += (uint32_t)lq->received[lq->activePtr] - received;
+    lq->totalSum += (uint32_t)lq->total[lq->activePtr] - total;
+  }
+
   lq->last_seq_nr = olsr->olsr_seqno;
   lq->missed_hellos = 0;
 }
@@ -243,19 +251,17 @@ lq_ffeth_nl80211_timer(void __attribute__ ((unused)) * context)
   OLSR_FOR_ALL_LINK_ENTRIES(link) {
     struct lq_ffeth_hello *tlq = (struct lq_ffeth_hello *)link->linkquality;
     fpm ratio;
-    int i, received, total;
-
-    received = 0;
-    total = 0;
+    int received, total;
 
     /* enlarge window if still in quickstart phase */
     if (tlq->windowSize < LQ_FFETH_WINDOW) {
+      tlq->receivedSum += tlq->received[tlq->windowSize];
+      tlq->totalSum += tlq->total[tlq->windowSize];
       tlq->windowSize++;
     }
-    for (i = 0; i < tlq->windowSize; i++) {
-      received += tlq->received[i];
-      total += tlq->total[i];
-    }
+
+    received = (int)tlq->receivedSum;
+    total = (int)tlq->totalSum;
 
     /* calculate link quality */
     if (total == 0) {
@@ -296,6 +302,10 @@ lq_ffeth_nl80211_timer(void __attribute__ ((unused)) * context)
 
     // shift buffer
     tlq->activePtr = (tlq->activePtr + 1) % LQ_FFETH_WINDOW;
+    if (tlq->activePtr < tlq->windowSize) {
+      tlq->receivedSum -= tlq->received[tlq->activePtr];
+      tlq->totalSum -= tlq->total[tlq->activePtr];
+    }
     tlq->total[tlq->activePtr] = 0;
     tlq->received[tlq->activePtr] = 0;
 
@@ -490,6 +500,13 @@ lq_clear_ffeth_nl80211_hello(void *target)
   for (i = 0; i < LQ_FFETH_WINDOW; i++) {
     local->total[i] = 3;
   }
+
+  local->receivedSum = 0;
+  local->totalSum = 0;
+  for (i = 0; i < local->windowSize; i++) {
+    local->receivedSum += local->received[i];
+    local->totalSum += local->total[i];
+  }
 }
 
 static const char *
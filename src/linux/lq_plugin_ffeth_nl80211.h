@@ -79,6 +79,9 @@ struct lq_ffeth_hello {
   uint16_t missed_hellos;
   bool perfect_eth;
   uint16_t received[LQ_FFETH_WINDOW], total[LQ_FFETH_WINDOW];
+
+  /* sum of received[] and total[] over the current window */
+  uint32_t receivedSum, totalSum;
 };
 
 extern struct lq_handler lq_etx_ffeth_nl80211_handler;
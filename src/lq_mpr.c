@@ -50,123 +50,139 @@
 #include "lq_mpr.h"
 #include "scheduler.h"
 #include "lq_plugin.h"
-
-void
-olsr_calculate_lq_mpr(void)
+#include "mpr.h"
+
+/**
+ *Redo the MPR selection for a single 2 hop neighbor: select
+ *the (up to mpr_coverage) 1 hop neighbors with the best total
+ *link costs, as far as they are better than a direct link to
+ *the 2 hop neighbor. The choices of the previous selection are
+ *withdrawn first.
+ *
+ *@param neigh2 the 2 hop neighbor
+ */
+static void
+olsr_select_lq_mpr(struct neighbor_2_entry *neigh2)
 {
-  struct neighbor_2_entry *neigh2;
   struct neighbor_list_entry *walker;
-  int i, k;
   struct neighbor_entry *neigh;
   olsr_linkcost best, best_1hop;
-  bool mpr_changes = false;
+  int k;
 
-  OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
-
-    /* Memorize previous MPR status. */
+  for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next) {
+    olsr_mpr_forget_choice(walker);
+    walker->mpr_path_linkcost = walker->path_linkcost;
+  }
 
-    neigh->was_mpr = neigh->is_mpr;
+  best_1hop = LINK_COST_BROKEN;
 
-    /* Clear current MPR status. */
+  /* check whether this 2-hop neighbour is also a neighbour */
 
-    neigh->is_mpr = false;
+  neigh = olsr_lookup_neighbor_table(&neigh2->neighbor_2_addr);
 
-    /* In this pass we are only interested in WILL_ALWAYS neighbours */
+  /* a direct link makes the selection depend on the links */
 
-    if (neigh->status == NOT_SYM || neigh->willingness != WILL_ALWAYS) {
-      continue;
-    }
+  olsr_mpr_set_direct(neigh2, neigh != NULL && neigh->status == SYM);
 
-    neigh->is_mpr = true;
+  /* if it's a neighbour and also symmetric, then examine
+     the link quality */
 
-    if (neigh->is_mpr != neigh->was_mpr) {
-      mpr_changes = true;
-    }
+  if (neigh != NULL && neigh->status == SYM) {
+    /* if the direct link is better than the best route via
+     * an MPR, then prefer the direct link and do not select
+     * an MPR for this 2-hop neighbour */
 
-  }
-  OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
+    /* determine the link quality of the direct link */
 
-  for (i = 0; i < HASHSIZE; i++) {
-    /* loop through all 2-hop neighbours */
+    struct link_entry *lnk = get_best_link_to_neighbor(&neigh->neighbor_main_addr);
 
-    for (neigh2 = two_hop_neighbortable[i].next; neigh2 != &two_hop_neighbortable[i]; neigh2 = neigh2->next) {
-      best_1hop = LINK_COST_BROKEN;
+    if (!lnk)
+      return;
 
-      /* check whether this 2-hop neighbour is also a neighbour */
+    best_1hop = lnk->linkcost;
 
-      neigh = olsr_lookup_neighbor_table(&neigh2->neighbor_2_addr);
+    /* see wether we find a better route via an MPR */
 
-      /* if it's a neighbour and also symmetric, then examine
-         the link quality */
+    for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
+      if (walker->path_linkcost < best_1hop)
+        break;
 
-      if (neigh != NULL && neigh->status == SYM) {
-        /* if the direct link is better than the best route via
-         * an MPR, then prefer the direct link and do not select
-         * an MPR for this 2-hop neighbour */
+    /* we've reached the end of the list, so we haven't found
+     * a better route via an MPR - so, skip MPR selection for
+     * this 1-hop neighbor */
 
-        /* determine the link quality of the direct link */
+    if (walker == &neigh2->neighbor_2_nblist)
+      return;
+  }
 
-        struct link_entry *lnk = get_best_link_to_neighbor(&neigh->neighbor_main_addr);
+  /* find the connecting 1-hop neighbours with the
+   * best total link qualities */
 
-        if (!lnk)
-          continue;
+  for (k = 0; k < olsr_cnf->mpr_coverage; k++) {
+    struct neighbor_list_entry *selected = NULL;
 
-        best_1hop = lnk->linkcost;
+    /* look for the best 1-hop neighbour that we haven't
+     * yet selected */
 
-        /* see wether we find a better route via an MPR */
+    best = LINK_COST_BROKEN;
 
-        for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
-          if (walker->path_linkcost < best_1hop)
-            break;
+    for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
+      if (walker->neighbor->status == SYM && !walker->mpr_selected && walker->path_linkcost < best) {
+        selected = walker;
+        best = walker->path_linkcost;
+      }
 
-        /* we've reached the end of the list, so we haven't found
-         * a better route via an MPR - so, skip MPR selection for
-         * this 1-hop neighbor */
+    /* Found a 1-hop neighbor that we haven't previously selected.
+     * Use it as MPR only when the 2-hop path through it is better than
+     * any existing 1-hop path. */
+    if ((selected != NULL) && (best < best_1hop)) {
+      selected->mpr_selected = true;
+      selected->neighbor->mpr_selected_count++;
+    }
 
-        if (walker == &neigh2->neighbor_2_nblist)
-          continue;
-      }
+    /* no neighbour found => the requested MPR coverage cannot
+     * be satisfied => stop */
 
-      /* find the connecting 1-hop neighbours with the
-       * best total link qualities */
+    else
+      break;
+  }
+}
 
-      /* mark all 1-hop neighbours as not selected */
+/**
+ *Update the LQ MPR set. The selection is made per 2 hop
+ *neighbor, so it is only redone for the 2 hop neighbors that
+ *are affected by the changes since the previous calculation;
+ *the selections of the other 2 hop neighbors still hold.
+ */
+void
+olsr_calculate_lq_mpr(void)
+{
+  struct neighbor_2_entry *neigh2;
+  struct neighbor_entry *neigh;
+  bool mpr_changes = false;
 
-      for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
-        walker->neighbor->skip = false;
+  olsr_mpr_begin_update();
 
-      for (k = 0; k < olsr_cnf->mpr_coverage; k++) {
-        /* look for the best 1-hop neighbour that we haven't
-         * yet selected */
+  while ((neigh2 = olsr_mpr_next_dirty()) != NULL) {
+    olsr_select_lq_mpr(neigh2);
+  }
 
-        neigh = NULL;
-        best = LINK_COST_BROKEN;
+  OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
 
-        for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
-          if (walker->neighbor->status == SYM && !walker->neighbor->skip && walker->path_linkcost < best) {
-            neigh = walker->neighbor;
-            best = walker->path_linkcost;
-          }
+    /* Memorize previous MPR status. */
 
-        /* Found a 1-hop neighbor that we haven't previously selected.
-         * Use it as MPR only when the 2-hop path through it is better than
-         * any existing 1-hop path. */
-        if ((neigh != NULL) && (best < best_1hop)) {
-          neigh->is_mpr = true;
-          neigh->skip = true;
+    neigh->was_mpr = neigh->is_mpr;
 
-          if (neigh->is_mpr != neigh->was_mpr)
-            mpr_changes = true;
-        }
+    /* WILL_ALWAYS neighbours are always MPR, others when
+       selected for at least one 2-hop neighbour */
 
-        /* no neighbour found => the requested MPR coverage cannot
-         * be satisfied => stop */
+    neigh->is_mpr = (neigh->status != NOT_SYM && neigh->willingness == WILL_ALWAYS) || (neigh->mpr_selected_count > 0);
 
-        else
-          break;
-      }
+    if (neigh->is_mpr && !neigh->was_mpr) {
+      mpr_changes = true;
     }
   }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
 
   if (mpr_changes && olsr_cnf->tc_redundancy > 0)
     signal_link_changes(true);
@@ -657,6 +657,8 @@ olsr_output_lq_hello(void *para)
   if (outif == NULL) {
     return;
   }
+  olsr_startup_phase("first HELLO");
+
   // create LQ_HELLO in internal format
   create_lq_hello(&lq_hello, outif);
 
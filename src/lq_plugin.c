@@ -50,6 +50,7 @@
 #include "packet.h"
 #include "olsr.h"
 #include "two_hop_neighbor_table.h"
+#include "mpr.h"
 #include "common/avl.h"
 
 #include "lq_plugin_default_float.h"
@@ -216,6 +217,23 @@ olsr_serialize_tc_lq_pair(unsigned char *buff, struct tc_mpr_addr *neigh)
   return active_lq_handler->serialize_tc_lq(buff, neigh->linkquality);
 }
 
+/**
+ * olsr_serialize_tc_edge_lq
+ *
+ * this function converts the lq information of a tc_edge_entry
+ * into binary package format
+ *
+ * @param buff pointer to binary buffer to write into
+ * @param edge pointer to tc_edge_entry
+ * @return number of bytes that have been written
+ */
+int
+olsr_serialize_tc_edge_lq(unsigned char *buff, struct tc_edge_entry *edge)
+{
+  assert((const char *)edge + sizeof(*edge) >= (const char *)edge->linkquality);
+  return active_lq_handler->serialize_tc_lq(buff, edge->linkquality);
+}
+
 /**
  * olsr_deserialize_tc_lq_pair
  *
@@ -399,6 +417,31 @@ void olsr_clear_hello_lq(struct link_entry *link) {
   active_lq_handler->clear_hello(link->linkquality);
 }
 
+/**
+ * olsr_clear_hello_neighbor_lq
+ *
+ * this function resets the linkquality value of a hello_neighbor
+ *
+ * @param target pointer to hello_neighbor
+ */
+void
+olsr_clear_hello_neighbor_lq(struct hello_neighbor *target)
+{
+  assert((const char *)target + sizeof(*target) >= (const char *)target->linkquality);
+  active_lq_handler->clear_hello(target->linkquality);
+}
+
+/**
+ * olsr_sizeof_hello_neighbor
+ *
+ * @return size of a hello_neighbor inclusive linkquality data
+ */
+size_t
+olsr_sizeof_hello_neighbor(void)
+{
+  return sizeof(struct hello_neighbor) + active_lq_handler->hello_lq_size;
+}
+
 /**
  * olsr_clear_tc_lq
  *
@@ -514,6 +557,7 @@ size_t olsr_sizeof_tc_lqdata(void) {
  * value changed in a relevant way.
  */
 void olsr_relevant_linkcost_change(void) {
+  olsr_mpr_dirty_links();
   changes_neighborhood = true;
   changes_topology = true;
 
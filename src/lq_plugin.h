@@ -124,6 +124,7 @@ int olsr_serialize_hello_lq_pair(unsigned char *buff, struct lq_hello_neighbor *
 void olsr_deserialize_hello_lq_pair(const uint8_t ** curr, struct hello_neighbor *neigh);
 int olsr_serialize_tc_lq_pair(unsigned char *buff, struct tc_mpr_addr *neigh);
 void olsr_deserialize_tc_lq_pair(const uint8_t ** curr, struct tc_edge_entry *edge);
+int olsr_serialize_tc_edge_lq(unsigned char *buff, struct tc_edge_entry *edge);
 
 void olsr_update_packet_loss_worker(struct link_entry *entry, bool lost);
 void olsr_memorize_foreign_hello_lq(struct link_entry *local, struct hello_neighbor *foreign);
@@ -138,6 +139,7 @@ void olsr_copy_hello_lq(struct lq_hello_neighbor *target, struct link_entry *sou
 void olsr_copylq_link_entry_2_tc_mpr_addr(struct tc_mpr_addr *target, struct link_entry *source);
 void olsr_copylq_link_entry_2_tc_edge_entry(struct tc_edge_entry *target, struct link_entry *source);
 void olsr_clear_tc_lq(struct tc_mpr_addr *target);
+void olsr_clear_hello_neighbor_lq(struct hello_neighbor *target);
 
 struct hello_neighbor *olsr_malloc_hello_neighbor(const char *id);
 struct tc_mpr_addr *olsr_malloc_tc_mpr_addr(const char *id);
@@ -146,6 +148,7 @@ struct link_entry *olsr_malloc_link_entry(const char *id);
 
 size_t olsr_sizeof_hello_lqdata(void);
 size_t olsr_sizeof_tc_lqdata(void);
+size_t olsr_sizeof_hello_neighbor(void);
 
 void olsr_relevant_linkcost_change(void);
 
@@ -46,6 +46,7 @@
 #include "tc_set.h"
 #include "link_set.h"
 #include "lq_plugin.h"
+#include "lq_smoothing.h"
 #include "olsr_spf.h"
 #include "lq_packet.h"
 #include "packet.h"
@@ -114,30 +115,19 @@ default_lq_ff_handle_lqchange(void) {
   struct link_entry *link;
 
   bool triggered = false;
+  int pending = 0;
 
   OLSR_FOR_ALL_LINK_ENTRIES(link) {
     bool relevant = false;
     lq = (struct default_lq_ff_hello *)link->linkquality;
 
-    if (lq->smoothed_lq.valueLq < lq->lq.valueLq) {
-      if (lq->lq.valueLq == 255 || lq->lq.valueLq - lq->smoothed_lq.valueLq > lq->smoothed_lq.valueLq/10) {
-        relevant = true;
-      }
+    if ((lq->smoothed_lq.valueLq < lq->lq.valueLq && lq->lq.valueLq == 255)
+        || olsr_is_relevant_lq_change(lq->smoothed_lq.valueLq, lq->lq.valueLq)) {
+      relevant = true;
     }
-    else if (lq->smoothed_lq.valueLq > lq->lq.valueLq) {
-      if (lq->smoothed_lq.valueLq - lq->lq.valueLq > lq->smoothed_lq.valueLq/10) {
-        relevant = true;
-      }
-    }
-    if (lq->smoothed_lq.valueNlq < lq->lq.valueNlq) {
-      if (lq->lq.valueNlq == 255 || lq->lq.valueNlq - lq->smoothed_lq.valueNlq > lq->smoothed_lq.valueNlq/10) {
-        relevant = true;
-      }
-    }
-    else if (lq->smoothed_lq.valueNlq > lq->lq.valueNlq) {
-      if (lq->smoothed_lq.valueNlq - lq->lq.valueNlq > lq->smoothed_lq.valueNlq/10) {
-        relevant = true;
-      }
+    if ((lq->smoothed_lq.valueNlq < lq->lq.valueNlq && lq->lq.valueNlq == 255)
+        || olsr_is_relevant_lq_change(lq->smoothed_lq.valueNlq, lq->lq.valueNlq)) {
+      relevant = true;
     }
 
     if (relevant) {
@@ -145,6 +135,11 @@ default_lq_ff_handle_lqchange(void) {
       link->linkcost = default_lq_calc_cost_ff(&lq->smoothed_lq);
       triggered = true;
     }
+    else if ((lq->smoothed_lq.valueLq != lq->lq.valueLq || lq->smoothed_lq.valueNlq != lq->lq.valueNlq)
+        && !(lq->smoothed_lq.valueLq == 255 && lq->smoothed_lq.valueNlq == 255)) {
+      /* will be updated by the second pass if any other link triggers */
+      pending++;
+    }
   } OLSR_FOR_ALL_LINK_ENTRIES_END(link)
 
   if (!triggered) {
@@ -152,6 +147,10 @@ default_lq_ff_handle_lqchange(void) {
   }
 
   OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    if (pending == 0) {
+      break;
+    }
+
     lq = (struct default_lq_ff_hello *)link->linkquality;
 
     if (lq->smoothed_lq.valueLq == 255 && lq->smoothed_lq.valueNlq == 255) {
@@ -164,6 +163,7 @@ default_lq_ff_handle_lqchange(void) {
 
     memcpy(&lq->smoothed_lq, &lq->lq, sizeof(struct default_lq_ff));
     link->linkcost = default_lq_calc_cost_ff(&lq->smoothed_lq);
+    pending--;
   } OLSR_FOR_ALL_LINK_ENTRIES_END(link)
 
   olsr_relevant_linkcost_change();
@@ -176,6 +176,7 @@ default_lq_parser_ff(struct olsr *olsr, struct interface_olsr *in_if, union olsr
   struct link_entry *lnk;
   struct default_lq_ff_hello *lq;
   uint32_t seq_diff;
+  uint16_t received, total;
 
   /* Find main address */
   main_addr = mid_lookup_main_addr(from_addr);
@@ -207,9 +208,16 @@ default_lq_parser_ff(struct olsr *olsr, struct interface_olsr *in_if, union olsr
     seq_diff = 1;
   }
 
-  lq->received[lq->activePtr]++;
+  received = lq->received[lq->activePtr]++;
+  total = lq->total[lq->activePtr];
   lq->total[lq->activePtr] += seq_diff;
 
+  /* keep the window sums up to date */
+  if (lq->activePtr < lq->windowSize) {
+    lq->receivedSum += (uint32_t)lq->received[lq->activePtr] - received;
+    lq->totalSum += (uint32_t)lq->total[lq->activePtr] - total;
+  }
+
   lq->last_seq_nr = olsr->olsr_seqno;
   lq->missed_hellos = 0;
 }
@@ -222,19 +230,17 @@ default_lq_ff_timer(void __attribute__ ((unused)) * context)
   OLSR_FOR_ALL_LINK_ENTRIES(link) {
     struct default_lq_ff_hello *tlq = (struct default_lq_ff_hello *)link->linkquality;
     fpm ratio;
-    int i, received, total;
-
-    received = 0;
-    total = 0;
+    int received, total;
 
     /* enlarge window if still in quickstart phase */
     if (tlq->windowSize < LQ_FF_WINDOW) {
+      tlq->receivedSum += tlq->received[tlq->windowSize];
+      tlq->totalSum += tlq->total[tlq->windowSize];
       tlq->windowSize++;
     }
-    for (i = 0; i < tlq->windowSize; i++) {
-      received += tlq->received[i];
-      total += tlq->total[i];
-    }
+
+    received = (int)tlq->receivedSum;
+    total = (int)tlq->totalSum;
 
     /* calculate link quality */
     if (total == 0) {
@@ -266,6 +272,10 @@ default_lq_ff_timer(void __attribute__ ((unused)) * context)
 
     // shift buffer
     tlq->activePtr = (tlq->activePtr + 1) % LQ_FF_WINDOW;
+    if (tlq->activePtr < tlq->windowSize) {
+      tlq->receivedSum -= tlq->received[tlq->activePtr];
+      tlq->totalSum -= tlq->total[tlq->activePtr];
+    }
     tlq->total[tlq->activePtr] = 0;
     tlq->received[tlq->activePtr] = 0;
   } OLSR_FOR_ALL_LINK_ENTRIES_END(link);
@@ -404,6 +414,13 @@ default_lq_clear_ff_hello(void *target)
   for (i = 0; i < LQ_FF_WINDOW; i++) {
     local->total[i] = 3;
   }
+
+  local->receivedSum = 0;
+  local->totalSum = 0;
+  for (i = 0; i < local->windowSize; i++) {
+    local->receivedSum += local->received[i];
+    local->totalSum += local->total[i];
+  }
 }
 
 static const char *
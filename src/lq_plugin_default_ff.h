@@ -69,6 +69,9 @@ struct default_lq_ff_hello {
   uint16_t last_seq_nr;
   uint16_t missed_hellos;
   uint16_t received[LQ_FF_WINDOW], total[LQ_FF_WINDOW];
+
+  /* sum of received[] and total[] over the current window */
+  uint32_t receivedSum, totalSum;
 };
 
 extern struct lq_handler lq_etx_ff_handler;
@@ -46,6 +46,7 @@
 #include "tc_set.h"
 #include "link_set.h"
 #include "lq_plugin.h"
+#include "lq_smoothing.h"
 #include "olsr_spf.h"
 #include "lq_packet.h"
 #include "packet.h"
@@ -116,30 +117,19 @@ default_lq_ffeth_handle_lqchange(void) {
   struct link_entry *link;
 
   bool triggered = false;
+  int pending = 0;
 
   OLSR_FOR_ALL_LINK_ENTRIES(link) {
     bool relevant = false;
     lq = (struct default_lq_ffeth_hello *)link->linkquality;
 
-    if (lq->smoothed_lq.valueLq < lq->lq.valueLq) {
-      if (lq->lq.valueLq >= 254 || lq->lq.valueLq - lq->smoothed_lq.valueLq > lq->smoothed_lq.valueLq/10) {
-        relevant = true;
-      }
+    if ((lq->smoothed_lq.valueLq < lq->lq.valueLq && lq->lq.valueLq >= 254)
+        || olsr_is_relevant_lq_change(lq->smoothed_lq.valueLq, lq->lq.valueLq)) {
+      relevant = true;
     }
-    else if (lq->smoothed_lq.valueLq > lq->lq.valueLq) {
-      if (lq->smoothed_lq.valueLq - lq->lq.valueLq > lq->smoothed_lq.valueLq/10) {
-        relevant = true;
-      }
-    }
-    if (lq->smoothed_lq.valueNlq < lq->lq.valueNlq) {
-      if (lq->lq.valueNlq >= 254 || lq->lq.valueNlq - lq->smoothed_lq.valueNlq > lq->smoothed_lq.valueNlq/10) {
-        relevant = true;
-      }
-    }
-    else if (lq->smoothed_lq.valueNlq > lq->lq.valueNlq) {
-      if (lq->smoothed_lq.valueNlq - lq->lq.valueNlq > lq->smoothed_lq.valueNlq/10) {
-        relevant = true;
-      }
+    if ((lq->smoothed_lq.valueNlq < lq->lq.valueNlq && lq->lq.valueNlq >= 254)
+        || olsr_is_relevant_lq_change(lq->smoothed_lq.valueNlq, lq->lq.valueNlq)) {
+      relevant = true;
     }
 
     if (relevant) {
@@ -147,6 +137,11 @@ default_lq_ffeth_handle_lqchange(void) {
       link->linkcost = default_lq_calc_cost_ffeth(&lq->smoothed_lq);
       triggered = true;
     }
+    else if ((lq->smoothed_lq.valueLq != lq->lq.valueLq || lq->smoothed_lq.valueNlq != lq->lq.valueNlq)
+        && !(lq->smoothed_lq.valueLq >= 254 && lq->smoothed_lq.valueNlq >= 254)) {
+      /* will be updated by the second pass if any other link triggers */
+      pending++;
+    }
   } OLSR_FOR_ALL_LINK_ENTRIES_END(link)
 
   if (!triggered) {
@@ -154,6 +149,10 @@ default_lq_ffeth_handle_lqchange(void) {
   }
 
   OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    if (pending == 0) {
+      break;
+    }
+
     lq = (struct default_lq_ffeth_hello *)link->linkquality;
 
     if (lq->smoothed_lq.valueLq >= 254 && lq->smoothed_lq.valueNlq >= 254) {
@@ -166,6 +165,7 @@ default_lq_ffeth_handle_lqchange(void) {
 
     memcpy(&lq->smoothed_lq, &lq->lq, sizeof(struct default_lq_ffeth));
     link->linkcost = default_lq_calc_cost_ffeth(&lq->smoothed_lq);
+    pending--;
   } OLSR_FOR_ALL_LINK_ENTRIES_END(link)
 
   olsr_relevant_linkcost_change();
@@ -178,6 +178,7 @@ default_lq_parser_ffeth(struct olsr *olsr, struct interface_olsr *in_if, union o
   struct link_entry *lnk;
   struct default_lq_ffeth_hello *lq;
   uint32_t seq_diff;
+  uint16_t received, total;
 
   /* Find main address */
   main_addr = mid_lookup_main_addr(from_addr);
@@ -209,9 +210,16 @@ default_lq_parser_ffeth(struct olsr *olsr, struct interface_olsr *in_if, union o
     seq_diff = 1;
   }
 
-  lq->received[lq->activePtr]++;
+  received = lq->received[lq->activePtr]++;
+  total = lq->total[lq->activePtr];
   lq->total[lq->activePtr] += seq_diff;
 
+  /* keep the window sums up to date */
+  if (lq->activePtr < lq->windowSize) {
+    lq->receivedSum += (uint32_t)lq->received[lq->activePtr] - received;
+    lq->totalSum += (uint32_t)lq->total[lq->activePtr] - total;
+  }
+
   lq->last_seq_nr = olsr->olsr_seqno;
   lq->missed_hellos = 0;
 }
@@ -224,19 +232,17 @@ default_lq_ffeth_timer(void __attribute__ ((unused)) * context)
   OLSR_FOR_ALL_LINK_ENTRIES(link) {
     struct default_lq_ffeth_hello *tlq = (struct default_lq_ffeth_hello *)link->linkquality;
     fpm ratio;
-    int i, received, total;
-
-    received = 0;
-    total = 0;
+    int received, total;
 
     /* enlarge window if still in quickstart phase */
     if (tlq->windowSize < LQ_FFETH_WINDOW) {
+      tlq->receivedSum += tlq->received[tlq->windowSize];
+      tlq->totalSum += tlq->total[tlq->windowSize];
       tlq->windowSize++;
     }
-    for (i = 0; i < tlq->windowSize; i++) {
-      received += tlq->received[i];
-      total += tlq->total[i];
-    }
+
+    received = (int)tlq->receivedSum;
+    total = (int)tlq->totalSum;
 
     /* calculate link quality */
     if (total == 0) {
@@ -285,6 +291,10 @@ default_lq_ffeth_timer(void __attribute__ ((unused)) * context)
 
     // shift buffer
     tlq->activePtr = (tlq->activePtr + 1) % LQ_FFETH_WINDOW;
+    if (tlq->activePtr < tlq->windowSize) {
+      tlq->receivedSum -= tlq->received[tlq->activePtr];
+      tlq->totalSum -= tlq->total[tlq->activePtr];
+    }
     tlq->total[tlq->activePtr] = 0;
     tlq->received[tlq->activePtr] = 0;
   } OLSR_FOR_ALL_LINK_ENTRIES_END(link);
@@ -443,6 +453,13 @@ default_lq_clear_ffeth_hello(void *target)
   for (i = 0; i < LQ_FFETH_WINDOW; i++) {
     local->total[i] = 3;
   }
+
+  local->receivedSum = 0;
+  local->totalSum = 0;
+  for (i = 0; i < local->windowSize; i++) {
+    local->receivedSum += local->received[i];
+    local->totalSum += local->total[i];
+  }
 }
 
 static const char *
@@ -61,6 +61,7 @@ static int default_lq_serialize_tc_lq_pair_float(unsigned char *buff, void *lq);
 static void default_lq_deserialize_tc_lq_pair_float(const uint8_t ** curr, void *lq);
 static void default_lq_copy_link2tc_float(void *target, void *source);
 static void default_lq_clear_float(void *target);
+static void default_lq_clear_float_hello(void *target);
 static const char *default_lq_print_float(void *ptr, char separator, struct lqtextbuffer *buffer);
 static double default_lq_get_cost_scaled(olsr_linkcost cost);
 
@@ -76,7 +77,7 @@ struct lq_handler lq_etx_float_handler = {
   &default_lq_memorize_foreign_hello_float,
   &default_lq_copy_link2tc_float,
   &default_lq_copy_link2tc_float,
-  &default_lq_clear_float,
+  &default_lq_clear_float_hello,
   &default_lq_clear_float,
 
   &default_lq_serialize_hello_lq_pair_float,
@@ -88,7 +89,7 @@ struct lq_handler lq_etx_float_handler = {
   &default_lq_print_float,
   &default_lq_get_cost_scaled,
 
-  sizeof(struct default_lq_float),
+  sizeof(struct default_lq_float_hello),
   sizeof(struct default_lq_float),
   4,
   4
@@ -97,7 +98,7 @@ struct lq_handler lq_etx_float_handler = {
 static void
 default_lq_initialize_float(void)
 {
-  return;
+  olsr_lq_smoothing_init();
 }
 
 static olsr_linkcost
@@ -177,20 +178,20 @@ default_lq_deserialize_tc_lq_pair_float(const uint8_t ** curr, void *ptr)
 static void
 default_lq_packet_loss_worker_float(struct link_entry *link, void *ptr, bool lost)
 {
-  struct default_lq_float *tlq = ptr;
-  float alpha = olsr_cnf->lq_aging;
+  struct default_lq_float_hello *tlq = ptr;
+  uint32_t value;
+  olsr_linkcost cost;
 
-  if (tlq->quickstart < LQ_QUICKSTART_STEPS) {
-    alpha = LQ_QUICKSTART_AGING;        /* fast enough to get the LQ value within 6 Hellos up to 0.9 */
-    tlq->quickstart++;
-  }
-  // exponential moving average
-  tlq->lq *= (1 - alpha);
-  if (lost == 0) {
-    tlq->lq += (alpha * link->loss_link_multiplier / 65536);
+  value = olsr_lq_smoothing_add(&tlq->smoothing,
+      lost ? 0 : (uint32_t)((uint64_t)link->loss_link_multiplier * LQ_SMOOTHING_ONE / LINK_LOSS_MULTIPLIER));
+  tlq->lq.lq = (float)value / LQ_SMOOTHING_ONE;
+
+  /* only trigger a route recalculation for relevant cost changes */
+  cost = default_lq_calc_cost_float(&tlq->lq);
+  if (olsr_is_relevant_lq_change(link->linkcost, cost)) {
+    link->linkcost = cost;
+    olsr_relevant_linkcost_change();
   }
-  link->linkcost = default_lq_calc_cost_float(ptr);
-  olsr_relevant_linkcost_change();
 }
 
 static void
@@ -218,6 +219,15 @@ default_lq_clear_float(void *target)
   memset(target, 0, sizeof(struct default_lq_float));
 }
 
+static void
+default_lq_clear_float_hello(void *target)
+{
+  struct default_lq_float_hello *local = target;
+
+  default_lq_clear_float(&local->lq);
+  olsr_lq_smoothing_clear(&local->smoothing);
+}
+
 static const char *
 default_lq_print_float(void *ptr, char separator, struct lqtextbuffer *buffer)
 {
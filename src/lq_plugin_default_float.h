@@ -48,6 +48,7 @@
 
 #include "olsr_types.h"
 #include "lq_plugin.h"
+#include "lq_smoothing.h"
 
 #define LQ_ALGORITHM_ETX_FLOAT_NAME "etx_float"
 
@@ -55,7 +56,11 @@
 
 struct default_lq_float {
   float lq, nlq;
-  uint16_t quickstart;
+};
+
+struct default_lq_float_hello {
+  struct default_lq_float lq;
+  struct lq_smoothing smoothing;
 };
 
 extern struct lq_handler lq_etx_float_handler;
@@ -62,6 +62,7 @@ static int default_lq_serialize_tc_lq_pair_fpm(unsigned char *buff, void *lq);
 static void default_lq_deserialize_tc_lq_pair_fpm(const uint8_t ** curr, void *lq);
 static void default_lq_copy_link2tc_fpm(void *target, void *source);
 static void default_lq_clear_fpm(void *target);
+static void default_lq_clear_fpm_hello(void *target);
 static const char *default_lq_print_fpm(void *ptr, char separator, struct lqtextbuffer *buffer);
 static double default_lq_get_cost_scaled(olsr_linkcost cost);
 
@@ -77,7 +78,7 @@ struct lq_handler lq_etx_fpm_handler = {
   &default_lq_memorize_foreign_hello_fpm,
   &default_lq_copy_link2tc_fpm,
   &default_lq_copy_link2tc_fpm,
-  &default_lq_clear_fpm,
+  &default_lq_clear_fpm_hello,
   &default_lq_clear_fpm,
 
   &default_lq_serialize_hello_lq_pair_fpm,
@@ -89,23 +90,16 @@ struct lq_handler lq_etx_fpm_handler = {
   &default_lq_print_fpm,
   &default_lq_get_cost_scaled,
 
-  sizeof(struct default_lq_fpm),
+  sizeof(struct default_lq_fpm_hello),
   sizeof(struct default_lq_fpm),
   4,
   4
 };
 
-uint32_t aging_factor_new, aging_factor_old;
-uint32_t aging_quickstart_new, aging_quickstart_old;
-
 static void
 default_lq_initialize_fpm(void)
 {
-  aging_factor_new = (uint32_t) (olsr_cnf->lq_aging * LQ_FPM_INTERNAL_MULTIPLIER);
-  aging_factor_old = LQ_FPM_INTERNAL_MULTIPLIER - aging_factor_new;
-
-  aging_quickstart_new = (uint32_t) (LQ_QUICKSTART_AGING * LQ_FPM_INTERNAL_MULTIPLIER);
-  aging_quickstart_old = LQ_FPM_INTERNAL_MULTIPLIER - aging_quickstart_new;
+  olsr_lq_smoothing_init();
 }
 
 static olsr_linkcost
@@ -174,34 +168,22 @@ default_lq_deserialize_tc_lq_pair_fpm(const uint8_t ** curr, void *ptr)
 }
 
 static void
-default_lq_packet_loss_worker_fpm(struct link_entry *link __attribute__ ((unused)), void *ptr, bool lost)
+default_lq_packet_loss_worker_fpm(struct link_entry *link, void *ptr, bool lost)
 {
-  struct default_lq_fpm *tlq = ptr;
-  uint32_t alpha_old = aging_factor_old;
-  uint32_t alpha_new = aging_factor_new;
-
+  struct default_lq_fpm_hello *tlq = ptr;
   uint32_t value;
+  olsr_linkcost cost;
 
-  if (tlq->quickstart < LQ_QUICKSTART_STEPS) {
-    alpha_new = aging_quickstart_new;
-    alpha_old = aging_quickstart_old;
-    tlq->quickstart++;
-  }
-  // exponential moving average
-  value = (uint32_t) (tlq->valueLq) * LQ_FPM_INTERNAL_MULTIPLIER / 255;
-
-  value = (value * alpha_old + LQ_FPM_INTERNAL_MULTIPLIER - 1) / LQ_FPM_INTERNAL_MULTIPLIER;
-
-  if (!lost) {
-    uint32_t ratio;
+  value = olsr_lq_smoothing_add(&tlq->smoothing,
+      lost ? 0 : (uint32_t)((uint64_t)link->loss_link_multiplier * LQ_SMOOTHING_ONE / LINK_LOSS_MULTIPLIER));
+  tlq->lq.valueLq = (uint8_t)((value * 255 + LQ_SMOOTHING_ONE - 1) / LQ_SMOOTHING_ONE);
 
-    ratio = (alpha_new * link->loss_link_multiplier + LINK_LOSS_MULTIPLIER - 1) / LINK_LOSS_MULTIPLIER;
-    value += ratio;
+  /* only trigger a route recalculation for relevant cost changes */
+  cost = default_lq_calc_cost_fpm(&tlq->lq);
+  if (olsr_is_relevant_lq_change(link->linkcost, cost)) {
+    link->linkcost = cost;
+    olsr_relevant_linkcost_change();
   }
-  tlq->valueLq = (value * 255 + LQ_FPM_INTERNAL_MULTIPLIER - 1) / LQ_FPM_INTERNAL_MULTIPLIER;
-
-  link->linkcost = default_lq_calc_cost_fpm(ptr);
-  olsr_relevant_linkcost_change();
 }
 
 static void
@@ -229,6 +211,15 @@ default_lq_clear_fpm(void *target)
   memset(target, 0, sizeof(struct default_lq_fpm));
 }
 
+static void
+default_lq_clear_fpm_hello(void *target)
+{
+  struct default_lq_fpm_hello *local = target;
+
+  default_lq_clear_fpm(&local->lq);
+  olsr_lq_smoothing_clear(&local->smoothing);
+}
+
 static const char *
 default_lq_print_fpm(void *ptr, char separator, struct lqtextbuffer *buffer)
 {
@@ -48,6 +48,7 @@
 
 #include "olsr_types.h"
 #include "lq_plugin.h"
+#include "lq_smoothing.h"
 
 /* use only 1<<16 - 1 to allow the multiplication of two
  * upscaled numbers between 0 and 1 */
@@ -59,7 +60,11 @@
 struct default_lq_fpm {
   uint8_t valueLq;
   uint8_t valueNlq;
-  uint16_t quickstart;
+};
+
+struct default_lq_fpm_hello {
+  struct default_lq_fpm lq;
+  struct lq_smoothing smoothing;
 };
 
 extern struct lq_handler lq_etx_fpm_handler;
@@ -0,0 +1,186 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#include "lq_smoothing.h"
+#include "lq_plugin.h"
+#include "defs.h"
+
+/* weight of a new sample for the ewma, scaled by LQ_SMOOTHING_ONE */
+static uint32_t ewma_weight, ewma_quickstart_weight;
+
+/* number of samples averaged by the window */
+static uint32_t window_length;
+
+/* process and measurement noise of the kalman estimator */
+static uint32_t kalman_q, kalman_r;
+
+/**
+ * Derive the parameters of all smoothing algorithms from the
+ * configured link quality aging. Has to be called by the LQ plugin
+ * before the first sample is added.
+ */
+void
+olsr_lq_smoothing_init(void)
+{
+  float aging = olsr_cnf->lq_aging;
+
+  ewma_weight = (uint32_t)(aging * LQ_SMOOTHING_ONE);
+  ewma_quickstart_weight = (uint32_t)(LQ_QUICKSTART_AGING * LQ_SMOOTHING_ONE);
+
+  /* a window of 2/aging - 1 samples has the same mean sample age as the ewma */
+  window_length = (uint32_t)(2.0f / aging - 0.5f);
+  if (window_length < 1) {
+    window_length = 1;
+  } else if (window_length > LQ_SMOOTHING_WINDOW) {
+    window_length = LQ_SMOOTHING_WINDOW;
+  }
+
+  /* variance of a single sample of a link with 50% loss */
+  kalman_r = LQ_SMOOTHING_ONE / 4;
+
+  /* choose the process noise so that the stationary kalman gain equals the ewma weight */
+  if (aging >= 1.0f) {
+    kalman_q = LQ_SMOOTHING_ONE;
+  } else {
+    kalman_q = (uint32_t)((float)kalman_r * aging * aging / (1.0f - aging));
+  }
+  if (kalman_q == 0) {
+    kalman_q = 1;
+  }
+}
+
+/**
+ * Reset the smoothing state of a link
+ *
+ * @param s pointer to smoothing state
+ */
+void
+olsr_lq_smoothing_clear(struct lq_smoothing *s)
+{
+  memset(s, 0, sizeof(*s));
+
+  /* we know nothing about a new link */
+  s->error = LQ_SMOOTHING_ONE;
+}
+
+/**
+ * Add a new sample to the smoothing state of a link
+ * with the algorithm selected by LinkQualitySmoothing.
+ *
+ * @param s pointer to smoothing state
+ * @param sample new link quality sample, between 0 and LQ_SMOOTHING_ONE
+ * @return new smoothed link quality, between 0 and LQ_SMOOTHING_ONE
+ */
+uint32_t
+olsr_lq_smoothing_add(struct lq_smoothing *s, uint32_t sample)
+{
+  uint32_t weight, p, gain;
+  int32_t diff;
+
+  if (sample > LQ_SMOOTHING_ONE) {
+    sample = LQ_SMOOTHING_ONE;
+  }
+
+  switch (olsr_cnf->lq_smoothing) {
+    case LQS_WINDOW:
+      if (s->count >= window_length) {
+        s->window_sum -= s->window[s->window_ptr];
+      } else {
+        s->count++;
+      }
+      s->window[s->window_ptr] = (uint16_t)sample;
+      s->window_sum += sample;
+      s->window_ptr = (uint8_t)((s->window_ptr + 1) % window_length);
+
+      s->value = s->window_sum / s->count;
+      break;
+
+    case LQS_KALMAN:
+      p = s->error + kalman_q;
+      gain = (uint32_t)((uint64_t)p * LQ_SMOOTHING_ONE / (p + kalman_r));
+
+      diff = (int32_t)sample - (int32_t)s->value;
+      s->value = (uint32_t)((int32_t)s->value + (int32_t)((int64_t)diff * gain / LQ_SMOOTHING_ONE));
+      s->error = (uint32_t)((uint64_t)p * (LQ_SMOOTHING_ONE - gain) / LQ_SMOOTHING_ONE);
+      break;
+
+    default:
+      weight = ewma_weight;
+      if (s->count < LQ_QUICKSTART_STEPS) {
+        /* fast enough to get the LQ value within 6 Hellos up to 0.9 */
+        weight = ewma_quickstart_weight;
+        s->count++;
+      }
+
+      s->value = (uint32_t)(((uint64_t)s->value * (LQ_SMOOTHING_ONE - weight) + (uint64_t)sample * weight) / LQ_SMOOTHING_ONE);
+      break;
+  }
+  return s->value;
+}
+
+/**
+ * Decide if the change between the last reported link quality (or link cost)
+ * and the current one is big enough to recalculate the routes.
+ *
+ * @param reported value that is currently used for routing
+ * @param current newly calculated value
+ * @return true if the difference is bigger than LinkQualityRelevantChange percent
+ *   of the reported value
+ */
+bool
+olsr_is_relevant_lq_change(uint32_t reported, uint32_t current)
+{
+  uint32_t diff = reported > current ? reported - current : current - reported;
+
+  return diff > 0 && (uint64_t)diff * 100 > (uint64_t)reported * olsr_cnf->lq_relevant_change;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,92 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#ifndef LQ_SMOOTHING_H_
+#define LQ_SMOOTHING_H_
+
+#include "olsr_types.h"
+
+/* fixed point representation of a link quality of 1.0 */
+#define LQ_SMOOTHING_ONE 65535
+
+/* maximum number of samples of the "window" smoothing */
+#define LQ_SMOOTHING_WINDOW 32
+
+/*
+ * Per link state of the smoothing engine. It is embedded into the
+ * link quality data of a LQ plugin, so no memory has to be allocated
+ * while processing packets.
+ */
+struct lq_smoothing {
+  /* current estimate, between 0 and LQ_SMOOTHING_ONE */
+  uint32_t value;
+
+  /* estimate error variance (kalman) */
+  uint32_t error;
+
+  /* sum of window[] (window) */
+  uint32_t window_sum;
+  uint16_t window[LQ_SMOOTHING_WINDOW];
+  uint8_t window_ptr;
+
+  /* number of samples seen (saturated) */
+  uint8_t count;
+};
+
+void olsr_lq_smoothing_init(void);
+void olsr_lq_smoothing_clear(struct lq_smoothing *s);
+uint32_t olsr_lq_smoothing_add(struct lq_smoothing *s, uint32_t sample);
+
+bool olsr_is_relevant_lq_change(uint32_t reported, uint32_t current);
+
+#endif /* LQ_SMOOTHING_H_ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -65,6 +65,7 @@
 #include "net_os.h"
 #include "build_msg.h"
 #include "net_olsr.h"
+#include "link_set.h"
 #include "mid_set.h"
 #include "mpr_selector_set.h"
 #include "gateway.h"
@@ -73,6 +74,10 @@
 #include "pid_file.h"
 #include "lock_file.h"
 #include "cli.h"
+#include "olsr_snapshot.h"
+#include "olsr_reconfigure.h"
+#include "olsr_state.h"
+#include "olsr_metrics.h"
 
 #if defined(__GLIBC__) && defined(__linux__) && !defined(__ANDROID__) && !defined(__UCLIBC__)
   #define OLSR_HAVE_EXECINFO_H
@@ -100,8 +105,6 @@ void DisableIcmpRedirects(void);
 
 struct timer_entry * heartBeatTimer = NULL;
 
-static char **olsr_argv = NULL;
-
 struct olsr_cookie_info *def_timer_ci = NULL;
 
 static void printStacktrace(const char * message) {
@@ -125,44 +128,13 @@ static void printStacktrace(const char * message) {
 
 #ifndef _WIN32
 /**
- * Reconfigure olsrd. Currently kind of a hack...
+ * Reconfigure olsrd: the configuration file is reloaded and applied
+ * in place by the scheduler loop, see olsr_reconfigure.c
  *
  *@param signo the signal that triggered this callback
  */
-__attribute__ ((noreturn))
 static void olsr_reconfigure(int signo __attribute__ ((unused))) {
-#ifndef _WIN32
-  int errNr = errno;
-#endif
-  /* if we are started with -nofork, we do not want to go into the
-   * background here. So we can simply stop on -HUP
-   */
-  olsr_syslog(OLSR_LOG_INFO, "sot: olsr_reconfigure()\n");
-  if (!olsr_cnf->no_fork) {
-    if (!fork()) {
-      int i;
-      sigset_t sigs;
-
-      /* New process, wait a bit to let the old process exit */
-      sleep(3);
-      sigemptyset(&sigs);
-      sigaddset(&sigs, SIGHUP);
-      sigprocmask(SIG_UNBLOCK, &sigs, NULL);
-      for (i = sysconf(_SC_OPEN_MAX); --i > STDERR_FILENO;) {
-        close(i);
-      }
-      printf("Restarting %s", olsr_argv[0]);
-      olsr_syslog(OLSR_LOG_INFO, "Restarting %s", olsr_argv[0]);
-      execv(olsr_argv[0], olsr_argv);
-      olsr_syslog(OLSR_LOG_ERR, "execv(%s) failed: %s", olsr_argv[0], strerror(errno));
-    } else {
-      olsr_syslog(OLSR_LOG_INFO, "RECONFIGURING");
-    }
-  }
-#ifndef _WIN32
-  errno = errNr;
-#endif
-  olsr_exit(NULL, EXIT_SUCCESS);
+  olsr_reconfigure_request();
 }
 #endif /* _WIN32 */
 
@@ -222,6 +194,9 @@ static void olsr_shutdown(int signo __attribute__ ((unused)))
   /* instruct the scheduler to stop */
   olsr_scheduler_stop();
 
+  /* checkpoint the state before it is torn down */
+  olsr_state_save();
+
 #ifdef __linux__
   if (olsr_cnf->smart_gw_active) {
     olsr_shutdown_gateways();
@@ -241,13 +216,17 @@ static void olsr_shutdown(int signo __attribute__ ((unused)))
   /* send first shutdown message burst */
   olsr_shutdown_messages();
 
-  /* delete all routes */
-  olsr_delete_all_kernel_routes();
+  /* delete all routes, unless they are reconciled on the next start */
+  if (!olsr_cnf->keep_routes) {
+    olsr_delete_all_kernel_routes();
+  }
 
   /* send second shutdown message burst */
   olsr_shutdown_messages();
 
   /* now try to cleanup the rest of the mess */
+  olsr_delete_all_link_entries();
+
   olsr_delete_all_tc_entries();
 
   olsr_delete_all_mid_entries();
@@ -300,6 +279,9 @@ static void olsr_shutdown(int signo __attribute__ ((unused)))
   /* Closing plug-ins */
   olsr_close_plugins();
 
+  /* all snapshot readers are gone now */
+  olsr_snapshot_cleanup();
+
   /* Reset network settings */
   net_os_restore_ifoptions();
 
@@ -418,6 +400,7 @@ void get_argc_argv(int *argc, char ***argv) {
 
 int main(int argc, char *argv[]) {
   int argcLocal = argc;
+  bool fib_marked;
 
   /* save argc and argv */
   {
@@ -430,6 +413,8 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  olsr_startup_phase("start");
+
   /* Open syslog */
   olsr_openlog("olsrd");
 
@@ -454,9 +439,6 @@ int main(int argc, char *argv[]) {
   /* Init widely used statics */
   memset(&all_zero, 0, sizeof(union olsr_ip_addr));
 
-  /* store the arguments for restart */
-  olsr_argv = argv;
-
   /*
    * Start
    */
@@ -497,6 +479,7 @@ int main(int argc, char *argv[]) {
   if (!loadConfig(&argcLocal, argv)) {
     olsr_exit(NULL, EXIT_FAILURE);
   }
+  olsr_startup_phase("configuration");
 
   /* Process CLI Arguments */
   {
@@ -532,6 +515,7 @@ int main(int argc, char *argv[]) {
     snprintf(buf2, sizeof(buf2), "%s: Bad configuration", __func__);
     olsr_exit(buf2, EXIT_FAILURE);
   }
+  olsr_startup_phase("sanity check");
 
   /* Setup derived configuration */
   set_derived_cnf(olsr_cnf);
@@ -571,7 +555,8 @@ int main(int argc, char *argv[]) {
     olsr_syslog(OLSR_LOG_INFO, "rtnetlink could not be set to nonblocking");
   }
 
-  if ((olsr_cnf->rt_monitor_socket = rtnetlink_register_socket(RTMGRP_LINK)) < 0) {
+  if ((olsr_cnf->rt_monitor_socket = rtnetlink_register_socket(RTMGRP_LINK
+      | (olsr_cnf->ip_version == AF_INET ? RTMGRP_IPV4_IFADDR : RTMGRP_IPV6_IFADDR))) < 0) {
     char buf2[1024];
     snprintf(buf2, sizeof(buf2), "rtmonitor socket: %s", strerror(errno));
     olsr_exit(buf2, EXIT_FAILURE);
@@ -638,6 +623,11 @@ int main(int argc, char *argv[]) {
   }
   
   
+  /* record the latency histograms of the hot paths */
+  if (olsr_cnf->metrics) {
+    olsr_metrics_enable();
+  }
+
   /* initialise net */
   init_net();
 
@@ -654,6 +644,8 @@ int main(int argc, char *argv[]) {
     }
   }
 
+  olsr_startup_phase("interfaces");
+
   /* initialise the IPC socket */
   if ((olsr_cnf->ipc_connections > 0) && ipc_init()) {
     olsr_exit("ipc_init failure", EXIT_FAILURE);
@@ -670,6 +662,7 @@ int main(int argc, char *argv[]) {
 #endif /* __linux__ */
 
   olsr_do_startup_sleep();
+  olsr_startup_phase("startup sleep");
 
   /* start heartbeat that is showing on stdout */
 #if !defined WINCE
@@ -703,6 +696,16 @@ int main(int argc, char *argv[]) {
 
   /* Load plugins */
   olsr_load_plugins();
+  olsr_startup_phase("plugins");
+
+  /* adopt the routes a previous run left in the kernel */
+  fib_marked = olsr_mark_kernel_routes();
+
+  /* restore the state of the last run, its routes only if the kernel could not be read */
+  olsr_state_init(olsr_cnf->keep_routes && !fib_marked);
+
+  /* remove the adopted routes that are not confirmed in time */
+  olsr_start_kernel_route_sweep();
 
   /* print the main address */
   {
@@ -773,6 +776,7 @@ int main(int argc, char *argv[]) {
 #endif /* _WIN32 */
 
   /* Starting scheduler */
+  olsr_startup_phase("scheduler");
   olsr_scheduler();
 
   /* We'll only get here when olsr_shutdown has stopped the scheduler */
@@ -52,6 +52,7 @@
 #include "rebuild_packet.h"
 #include "scheduler.h"
 #include "neighbor_table.h"
+#include "mpr.h"
 #include "link_set.h"
 #include "tc_set.h"
 #include "packet.h"             /* struct mid_alias */
@@ -226,6 +227,7 @@ insert_mid_tuple(union olsr_ip_addr *m_addr, struct mid_address *alias, olsr_rel
 
       olsr_delete_two_hop_neighbor_table(tmp_2_neighbor);
 
+      olsr_mpr_invalidate();
       changes_neighborhood = true;
     }
 
@@ -243,6 +245,7 @@ insert_mid_tuple(union olsr_ip_addr *m_addr, struct mid_address *alias, olsr_rel
       /* Delete */
       free(tmp_neigh);
 
+      olsr_mpr_invalidate();
       changes_neighborhood = true;
     }
     tmp_adr = tmp_adr->next_alias;
@@ -315,6 +318,7 @@ insert_mid_alias(union olsr_ip_addr *main_add, const union olsr_ip_addr *alias,
   /*
    *Recalculate topology
    */
+  olsr_mpr_invalidate();
   changes_neighborhood = true;
   changes_topology = true;
 }
@@ -481,6 +485,7 @@ olsr_prune_aliases(struct mid_message *message)
       /*
        *Recalculate topology
        */
+      olsr_mpr_invalidate();
       changes_neighborhood = true;
       changes_topology = true;
     } else {
@@ -51,6 +51,7 @@
 #include "neighbor_table.h"
 #include "scheduler.h"
 #include "net_olsr.h"
+#include "common/list.h"
 
 /* Begin:
  * Prototypes for internal functions
@@ -72,28 +73,224 @@ static int olsr_check_mpr_changes(void);
 
 static int olsr_chosen_mpr(struct neighbor_entry *, uint16_t *);
 
-static struct neighbor_2_list_entry *olsr_find_2_hop_neighbors_with_1_link(int);
+static void olsr_choose_2_hop_neighbors_with_1_link(int, uint16_t *);
 
 /* End:
  * Prototypes for internal functions
  */
 
+/*
+ * MPR change tracking
+ *
+ * The tables record here what changed since the last MPR calculation, so
+ * that the LQ MPR selection only has to be redone for the 2 hop neighbors
+ * that are affected, and so that the RFC MPR selection can be skipped when
+ * nothing relevant changed.
+ */
+
+/** the 2 hop neighbors for which the MPR selection has to be redone */
+static struct list_node mpr_dirty_list = { &mpr_dirty_list, &mpr_dirty_list };
+
+/** the 2 hop neighbors that are also symmetric 1 hop neighbors */
+static struct list_node mpr_direct_list = { &mpr_direct_list, &mpr_direct_list };
+
+/** true when the MPR selection has to be redone for all 2 hop neighbors */
+static bool mpr_dirty_all = true;
+
+/** true when the links changed: affects the 2 hop neighbors on mpr_direct_list */
+static bool mpr_dirty_links = false;
+
+/** true when 1 hop neighbors changed their status or willingness, or 2 hop neighbors were removed */
+static bool mpr_dirty_neighbors = false;
+
+LISTNODE2STRUCT(list2dirty, struct neighbor_2_entry, mpr_dirty_node);
+LISTNODE2STRUCT(list2direct, struct neighbor_2_entry, mpr_direct_node);
+
+/**
+ *Redo the MPR selection for all 2 hop neighbors,
+ *for changes that can not be tracked in detail
+ */
+void
+olsr_mpr_invalidate(void)
+{
+  mpr_dirty_all = true;
+}
+
+/**
+ *Queue a 2 hop neighbor for MPR reselection
+ *
+ *@param two_hop_neighbor the 2 hop neighbor
+ */
+void
+olsr_mpr_dirty_two_hop(struct neighbor_2_entry *two_hop_neighbor)
+{
+  if (!list_node_on_list(&two_hop_neighbor->mpr_dirty_node)) {
+    list_add_before(&mpr_dirty_list, &two_hop_neighbor->mpr_dirty_node);
+  }
+}
+
+/**
+ *Queue all 2 hop neighbors that depend on a 1 hop
+ *neighbor for MPR reselection, after its status or
+ *willingness changed
+ *
+ *@param neighbor the 1 hop neighbor
+ */
+void
+olsr_mpr_dirty_neighbor(struct neighbor_entry *neighbor)
+{
+  struct neighbor_2_list_entry *two_hop_list;
+  struct neighbor_2_entry *two_hop_neighbor;
+
+  mpr_dirty_neighbors = true;
+
+  for (two_hop_list = neighbor->neighbor_2_list.next; two_hop_list != &neighbor->neighbor_2_list; two_hop_list = two_hop_list->next) {
+    olsr_mpr_dirty_two_hop(two_hop_list->neighbor_2);
+  }
+
+  /* the neighbor can also be a 2 hop neighbor itself */
+  two_hop_neighbor = olsr_lookup_two_hop_neighbor_table(&neighbor->neighbor_main_addr);
+  if (two_hop_neighbor) {
+    olsr_mpr_dirty_two_hop(two_hop_neighbor);
+  }
+}
+
+/**
+ *Record that links were added, removed or changed
+ *their cost or status
+ */
+void
+olsr_mpr_dirty_links(void)
+{
+  mpr_dirty_links = true;
+}
+
+/**
+ *Remove a 2 hop neighbor from the change tracking,
+ *before it is freed
+ *
+ *@param two_hop_neighbor the 2 hop neighbor
+ */
+void
+olsr_mpr_forget_two_hop(struct neighbor_2_entry *two_hop_neighbor)
+{
+  mpr_dirty_neighbors = true;
+
+  if (list_node_on_list(&two_hop_neighbor->mpr_dirty_node)) {
+    list_remove(&two_hop_neighbor->mpr_dirty_node);
+  }
+  if (list_node_on_list(&two_hop_neighbor->mpr_direct_node)) {
+    list_remove(&two_hop_neighbor->mpr_direct_node);
+  }
+}
+
 /**
- *Find all 2 hop neighbors with 1 link
+ *Withdraw the LQ MPR choice that a 2 hop neighbor made
+ *through a 1 hop neighbor, before the link between
+ *them is freed
+ *
+ *@param entry the 1 hop neighbor entry of the 2 hop neighbor
+ */
+void
+olsr_mpr_forget_choice(struct neighbor_list_entry *entry)
+{
+  if (entry->mpr_selected) {
+    entry->mpr_selected = false;
+    entry->neighbor->mpr_selected_count--;
+  }
+}
+
+/**
+ *Start an MPR calculation: queue the 2 hop neighbors
+ *that are affected by untracked changes and by link
+ *changes, and reset the change flags.
+ *
+ *@return true when anything changed since the previous
+ *calculation
+ */
+bool
+olsr_mpr_begin_update(void)
+{
+  bool changed = mpr_dirty_all || mpr_dirty_links || mpr_dirty_neighbors || !list_is_empty(&mpr_dirty_list);
+
+  if (mpr_dirty_all) {
+    int idx;
+
+    for (idx = 0; idx < HASHSIZE; idx++) {
+      struct neighbor_2_entry *neighbor_2;
+      for (neighbor_2 = two_hop_neighbortable[idx].next; neighbor_2 != &two_hop_neighbortable[idx]; neighbor_2 = neighbor_2->next) {
+        olsr_mpr_dirty_two_hop(neighbor_2);
+      }
+    }
+  } else if (mpr_dirty_links) {
+    struct list_node *node;
+
+    for (node = mpr_direct_list.next; node != &mpr_direct_list; node = node->next) {
+      olsr_mpr_dirty_two_hop(list2direct(node));
+    }
+  }
+
+  mpr_dirty_all = false;
+  mpr_dirty_links = false;
+  mpr_dirty_neighbors = false;
+
+  return changed;
+}
+
+/**
+ *Take the next 2 hop neighbor from the queue of
+ *2 hop neighbors for which the MPR selection has to
+ *be redone
+ *
+ *@return the 2 hop neighbor, NULL when the queue is empty
+ */
+struct neighbor_2_entry *
+olsr_mpr_next_dirty(void)
+{
+  struct neighbor_2_entry *two_hop_neighbor;
+
+  if (list_is_empty(&mpr_dirty_list)) {
+    return NULL;
+  }
+
+  two_hop_neighbor = list2dirty(mpr_dirty_list.next);
+  list_remove(&two_hop_neighbor->mpr_dirty_node);
+  return two_hop_neighbor;
+}
+
+/**
+ *Record whether a 2 hop neighbor is also a symmetric
+ *1 hop neighbor, in which case its MPR selection depends
+ *on the links to it
+ *
+ *@param two_hop_neighbor the 2 hop neighbor
+ *@param direct true when it is a symmetric 1 hop neighbor
+ */
+void
+olsr_mpr_set_direct(struct neighbor_2_entry *two_hop_neighbor, bool direct)
+{
+  if (direct != (list_node_on_list(&two_hop_neighbor->mpr_direct_node) != 0)) {
+    if (direct) {
+      list_add_before(&mpr_direct_list, &two_hop_neighbor->mpr_direct_node);
+    } else {
+      list_remove(&two_hop_neighbor->mpr_direct_node);
+    }
+  }
+}
+
+/**
+ *Choose the neighbors of all 2 hop neighbors with 1 link
  *connecting them to us trough neighbors
  *with a given willingness.
  *
  *@param willingness the willigness of the neighbors
- *
- *@return a linked list of allocated neighbor_2_list_entry structures
+ *@param two_hop_covered_count the number of covered 2 hop neighbors
  */
-static struct neighbor_2_list_entry *
-olsr_find_2_hop_neighbors_with_1_link(int willingness)
+static void
+olsr_choose_2_hop_neighbors_with_1_link(int willingness, uint16_t * two_hop_covered_count)
 {
 
   uint8_t idx;
-  struct neighbor_2_list_entry *two_hop_list_tmp = NULL;
-  struct neighbor_2_list_entry *two_hop_list = NULL;
   struct neighbor_entry *dup_neighbor;
   struct neighbor_2_entry *two_hop_neighbor = NULL;
 
@@ -115,26 +312,21 @@ olsr_find_2_hop_neighbors_with_1_link(int willingness)
       }
 
       if (two_hop_neighbor->neighbor_2_pointer == 1) {
-        if ((two_hop_neighbor->neighbor_2_nblist.next->neighbor->willingness == willingness)
-            && (two_hop_neighbor->neighbor_2_nblist.next->neighbor->status == SYM)) {
-          two_hop_list_tmp = olsr_malloc(sizeof(struct neighbor_2_list_entry), "MPR two hop list");
+        struct neighbor_entry *one_hop_neighbor = two_hop_neighbor->neighbor_2_nblist.next->neighbor;
 
+        /*
+         * whether a 2 hop neighbor qualifies does not depend on the
+         * MPRs that are chosen here, so choose right away
+         */
+        if ((one_hop_neighbor->willingness == willingness) && (one_hop_neighbor->status == SYM) && !one_hop_neighbor->is_mpr) {
           //OLSR_PRINTF(1, "ONE LINK ADDING %s\n", olsr_ip_to_string(&buf, &two_hop_neighbor->neighbor_2_addr));
-
-          /* Only queue one way here */
-          two_hop_list_tmp->neighbor_2 = two_hop_neighbor;
-
-          two_hop_list_tmp->next = two_hop_list;
-
-          two_hop_list = two_hop_list_tmp;
+          olsr_chosen_mpr(one_hop_neighbor, two_hop_covered_count);
         }
       }
 
     }
 
   }
-
-  return (two_hop_list_tmp);
 }
 
 /**
@@ -397,6 +589,15 @@ olsr_calculate_mpr(void)
   uint16_t two_hop_count;
   int i;
 
+  if (!olsr_mpr_begin_update()) {
+    /* nothing changed that is relevant to the MPR selection */
+    return;
+  }
+
+  /* the greedy selection is global: it is always redone as a whole */
+  while (olsr_mpr_next_dirty() != NULL) {
+  }
+
   OLSR_PRINTF(3, "\n**RECALCULATING MPR**\n\n");
 
   olsr_clear_mprs();
@@ -409,17 +610,8 @@ olsr_calculate_mpr(void)
 
   for (i = WILL_ALWAYS - 1; i > WILL_NEVER; i--) {
     struct neighbor_entry *mprs;
-    struct neighbor_2_list_entry *two_hop_list = olsr_find_2_hop_neighbors_with_1_link(i);
-
-    while (two_hop_list != NULL) {
-      struct neighbor_2_list_entry *tmp;
-      //printf("CHOSEN FROM 1 LINK\n");
-      if (!two_hop_list->neighbor_2->neighbor_2_nblist.next->neighbor->is_mpr)
-        olsr_chosen_mpr(two_hop_list->neighbor_2->neighbor_2_nblist.next->neighbor, &two_hop_covered_count);
-      tmp = two_hop_list;
-      two_hop_list = two_hop_list->next;;
-      free(tmp);
-    }
+
+    olsr_choose_2_hop_neighbors_with_1_link(i, &two_hop_covered_count);
 
     if (two_hop_covered_count >= two_hop_count) {
       i = WILL_NEVER;
@@ -46,8 +46,24 @@
 #ifndef _OLSR_MPR
 #define _OLSR_MPR
 
+#include <stdbool.h>
+
+struct neighbor_entry;
+struct neighbor_2_entry;
+struct neighbor_list_entry;
+
 void olsr_calculate_mpr(void);
 
+void olsr_mpr_invalidate(void);
+void olsr_mpr_dirty_two_hop(struct neighbor_2_entry *);
+void olsr_mpr_dirty_neighbor(struct neighbor_entry *);
+void olsr_mpr_dirty_links(void);
+void olsr_mpr_forget_two_hop(struct neighbor_2_entry *);
+void olsr_mpr_forget_choice(struct neighbor_list_entry *);
+bool olsr_mpr_begin_update(void);
+struct neighbor_2_entry *olsr_mpr_next_dirty(void);
+void olsr_mpr_set_direct(struct neighbor_2_entry *, bool);
+
 #ifndef NODEBUG
 void olsr_print_mpr_set(void);
 #else
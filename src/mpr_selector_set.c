@@ -83,6 +83,12 @@ increase_local_ansn(void)
   ansn++;
 }
 
+void
+set_local_ansn(uint16_t new_ansn)
+{
+  ansn = new_ansn;
+}
+
 #if 0
 
 /**
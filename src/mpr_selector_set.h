@@ -65,6 +65,8 @@ uint16_t get_local_ansn(void);
 
 void increase_local_ansn(void);
 
+void set_local_ansn(uint16_t);
+
 void olsr_init_mprs_set(void);
 
 struct mpr_selector *olsr_add_mpr_selector(const union olsr_ip_addr *, olsr_reltime);
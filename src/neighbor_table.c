@@ -79,6 +79,7 @@ olsr_del_nbr2_list(struct neighbor_2_list_entry *nbr2_list)
   nbr2 = nbr2_list->neighbor_2;
 
   if (nbr2->neighbor_2_pointer < 1) {
+    olsr_mpr_forget_two_hop(nbr2);
     DEQUEUE_ELEM(nbr2);
     free(nbr2);
   }
@@ -156,6 +157,9 @@ olsr_lookup_my_neighbors(const struct neighbor_entry *neighbor, const union olsr
 void
 olsr_update_neighbor_main_addr(struct neighbor_entry *entry, const union olsr_ip_addr *new_main_addr)
 {
+  /* the MPR selection depends on the main addresses */
+  olsr_mpr_invalidate();
+
   /*remove from old pos*/
   DEQUEUE_ELEM(entry);
 
@@ -165,6 +169,9 @@ olsr_update_neighbor_main_addr(struct neighbor_entry *entry, const union olsr_ip
   /*insert it again*/
   QUEUE_ELEM(neighbortable[olsr_ip_hashing(new_main_addr)], entry);
 
+  /*the links are looked up by the main addr as well*/
+  olsr_update_link_table_neighbor(entry);
+
 }
 
 /**
@@ -203,6 +210,8 @@ olsr_delete_neighbor_table(const union olsr_ip_addr *neighbor_addr)
   if (entry == &neighbortable[hash])
     return 0;
 
+  olsr_mpr_dirty_neighbor(entry);
+
   two_hop_list = entry->neighbor_2_list.next;
 
   while (two_hop_list != &entry->neighbor_2_list) {
@@ -320,6 +329,8 @@ olsr_lookup_neighbor_table_alias(const union olsr_ip_addr *dst)
 int
 update_neighbor_status(struct neighbor_entry *entry, int lnk)
 {
+  uint8_t old_status = entry->status;
+
   /*
    * Update neighbor entry
    */
@@ -352,6 +363,10 @@ update_neighbor_status(struct neighbor_entry *entry, int lnk)
     /* remove neighbor from routing list */
   }
 
+  if (entry->status != old_status) {
+    olsr_mpr_dirty_neighbor(entry);
+  }
+
   return entry->status;
 }
 
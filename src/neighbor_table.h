@@ -68,6 +68,7 @@ struct neighbor_entry {
   bool was_mpr;                        /* Used to detect changes in MPR */
   bool skip;
   int neighbor_2_nocov;
+  int mpr_selected_count;              /* number of 2 hop neighbors that select this neighbor as LQ MPR */
   int linkcount;
   int node_count;
   struct neighbor_2_list_entry neighbor_2_list;
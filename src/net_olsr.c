@@ -50,6 +50,7 @@
 #include "net_os.h"
 #include "link_set.h"
 #include "lq_packet.h"
+#include "olsr_metrics.h"
 
 #include <stdlib.h>
 #include <assert.h>
@@ -74,6 +75,9 @@ struct ptf {
 
 static struct ptf *ptf_list;
 
+/* latency of net_output() and bytes sent, registered on first use */
+static struct olsr_metric *output_metric = NULL, *output_bytes_metric = NULL;
+
 static struct deny_address_entry *deny_entries;
 
 static const char *const deny_ipv4_defaults[] = {
@@ -343,10 +347,13 @@ net_output(struct interface_olsr *ifp)
   struct ptf *tmp_ptf_list;
   union olsr_packet *outmsg;
   int retval;
+  uint64_t start;
 
   if (!ifp->netbuf.pending)
     return 0;
 
+  start = olsr_metrics_start();
+
   ifp->netbuf.pending += OLSR_HEADERSIZE;
 
   retval = ifp->netbuf.pending;
@@ -408,6 +415,17 @@ net_output(struct interface_olsr *ifp)
     }
   }
 
+  if (start) {
+    if (!output_metric) {
+      output_metric = olsr_metric_get(OLSR_METRIC_LATENCY, "net_output",
+          "Transmissions of a packet, including the packet transform functions", NULL, NULL);
+      output_bytes_metric = olsr_metric_get(OLSR_METRIC_COUNTER, "net_output_bytes",
+          "Bytes of the packets passed to the socket", NULL, NULL);
+    }
+    olsr_metric_add(output_bytes_metric, (uint64_t)ifp->netbuf.pending);
+    olsr_metrics_stop(output_metric, start);
+  }
+
   ifp->netbuf.pending = 0;
 
   /*
@@ -71,14 +71,17 @@
 #include "gateway.h"
 #include "duplicate_handler.h"
 #include "olsr_random.h"
+#include "olsr_snapshot.h"
 
 #include <stdarg.h>
 #include <signal.h>
 #include <unistd.h>
+#include <time.h>
 
 bool changes_topology;
 bool changes_neighborhood;
 bool changes_hna;
+bool changes_tc_edges;
 bool changes_force;
 
 /*COLLECT startup sleeps caused by warnings*/
@@ -112,6 +115,84 @@ void olsr_do_startup_sleep(void)
 #endif /* OLSR_COLLECT_STARTUP_SLEEP */
 }
 
+/*
+ * Startup timing: the time since olsrd was started at which the startup
+ * phases were reached, reported when the first route is set up.
+ */
+
+#define STARTUP_PHASES_MAX 16
+
+struct startup_phase {
+  const char *name;
+  uint32_t msec;
+};
+
+static struct timespec startup_time;
+static struct startup_phase startup_phases[STARTUP_PHASES_MAX];
+static unsigned int startup_phases_count = 0;
+static bool startup_reported = false;
+
+/**
+ * Record that a startup phase was reached. Only the first time a phase is
+ * reached is recorded, the first phase marks the start of olsrd.
+ *
+ * @param name the name of the phase, a string constant
+ */
+void olsr_startup_phase(const char *name)
+{
+  struct timespec now;
+  unsigned int i;
+
+  if (startup_reported || startup_phases_count == STARTUP_PHASES_MAX) {
+    return;
+  }
+  for (i = 0; i < startup_phases_count; i++) {
+    if (strcmp(startup_phases[i].name, name) == 0) {
+      return;
+    }
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if (startup_phases_count == 0) {
+    startup_time = now;
+  }
+
+  startup_phases[startup_phases_count].name = name;
+  startup_phases[startup_phases_count].msec = (uint32_t)((now.tv_sec - startup_time.tv_sec) * 1000
+      + (now.tv_nsec - startup_time.tv_nsec) / 1000000);
+  startup_phases_count++;
+}
+
+/**
+ * Record that the first route was set up and report the startup timing,
+ * once.
+ */
+void olsr_startup_first_route(void)
+{
+  char buf[STARTUP_PHASES_MAX * 32];
+  size_t len = 0;
+  unsigned int i;
+
+  if (startup_reported || startup_phases_count == 0) {
+    return;
+  }
+  olsr_startup_phase("first route");
+  startup_reported = true;
+
+  buf[0] = '\0';
+  for (i = 0; i < startup_phases_count && len < sizeof(buf); i++) {
+    int n = snprintf(buf + len, sizeof(buf) - len, "%s%s %u ms", i ? ", " : "",
+                     startup_phases[i].name, startup_phases[i].msec);
+    if (n < 0) {
+      break;
+    }
+    len += (size_t)n;
+  }
+
+  OLSR_PRINTF(1, "Startup timing: %s\n", buf);
+  olsr_syslog(OLSR_LOG_INFO, "Startup timing: %s", buf);
+}
+
 /**
  * Process changes functions
  */
@@ -146,6 +227,26 @@ get_msg_seqno(void)
   return message_seqno++;
 }
 
+/**
+ * Get the message sequence number without incrementing it
+ *
+ *@return the seqno
+ */
+uint16_t
+peek_msg_seqno(void)
+{
+  return message_seqno;
+}
+
+/**
+ * Set the message sequence number, used for a warm restart
+ */
+void
+set_msg_seqno(uint16_t seqno)
+{
+  message_seqno = seqno;
+}
+
 bool
 olsr_is_bad_duplicate_msg_seqno(uint16_t seqno) {
   int32_t diff = (int32_t) seqno - (int32_t) message_seqno;
@@ -193,9 +294,11 @@ olsr_process_changes(void)
     OLSR_PRINTF(3, "CHANGES IN TOPOLOGY\n");
   if (changes_hna)
     OLSR_PRINTF(3, "CHANGES IN HNA\n");
+  if (changes_tc_edges)
+    OLSR_PRINTF(3, "CHANGES IN TC EDGES\n");
 #endif /* DEBUG */
 
-  if (!changes_neighborhood && !changes_topology && !changes_hna)
+  if (!changes_neighborhood && !changes_topology && !changes_hna && !changes_tc_edges)
     return;
 
   if (olsr_cnf->debug_level > 0 && olsr_cnf->clear_screen && isatty(1)) {
@@ -211,9 +314,19 @@ olsr_process_changes(void)
     }
   }
 
-  /* calculate the routing table */
-  if (changes_neighborhood || changes_topology || changes_hna) {
+  /*
+   * Calculate the routing table. Changed TC edges alone only need SPF
+   * if one of them may be part of a shortest path.
+   */
+  if (changes_neighborhood || changes_topology || changes_hna || olsr_spf_tc_edge_changes_relevant()) {
     olsr_calculate_routing_table(false);
+  } else {
+    olsr_clear_tc_edge_changes();
+  }
+
+  /* the topology changed for everybody else */
+  if (changes_tc_edges) {
+    changes_topology = true;
   }
 
   if (olsr_cnf->debug_level > 0) {
@@ -242,9 +355,13 @@ olsr_process_changes(void)
     tmp_pc_list->function(changes_neighborhood, changes_topology, changes_hna);
   }
 
+  /* publish the new state for consumers outside of the main loop */
+  olsr_snapshot_publish();
+
   changes_neighborhood = false;
   changes_topology = false;
   changes_hna = false;
+  changes_tc_edges = false;
   changes_force = false;
 }
 
@@ -259,6 +376,7 @@ olsr_init_tables(void)
   changes_topology = false;
   changes_neighborhood = false;
   changes_hna = false;
+  changes_tc_edges = false;
 
   /* Set avl tree comparator */
   if (olsr_cnf->ipsize == 4) {
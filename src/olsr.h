@@ -52,6 +52,7 @@
 extern bool changes_topology;
 extern bool changes_neighborhood;
 extern bool changes_hna;
+extern bool changes_tc_edges;
 extern bool changes_force;
 
 extern union olsr_ip_addr all_zero;
@@ -60,6 +61,8 @@ void get_argc_argv(int *argc, char **argv[]);
 
 void olsr_startup_sleep(int);
 void olsr_do_startup_sleep(void);
+void olsr_startup_phase(const char *);
+void olsr_startup_first_route(void);
 
 void register_pcf(int (*)(int, int, int));
 
@@ -69,6 +72,10 @@ void init_msg_seqno(void);
 
 uint16_t get_msg_seqno(void);
 
+uint16_t peek_msg_seqno(void);
+
+void set_msg_seqno(uint16_t);
+
 bool olsr_is_bad_duplicate_msg_seqno(uint16_t seqno);
 
 int olsr_forward_message(union olsr_message *, struct interface_olsr *, union olsr_ip_addr *);
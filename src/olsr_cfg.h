@@ -78,7 +78,12 @@
 #define DEF_LQ_FISH          1
 #define DEF_LQ_NAT_THRESH    1.0
 #define DEF_LQ_AGING         0.05
+#define DEF_LQ_SMOOTHING     LQS_EWMA
+#define DEF_LQ_RELEVANT_CHANGE 10
 #define DEF_CLEAR_SCREEN     true
+#define DEF_STATE_INTERVAL   60.0
+#define DEF_KEEP_ROUTES      false
+#define DEF_METRICS          false
 #define DEF_OLSRPORT         698
 #define DEF_RTPROTO          0 /* 0 means OS-specific default */
 #define DEF_RT_NONE          -1
@@ -138,6 +143,7 @@
 #define MIN_POLLRATE         0.01
 #define MAX_NICCHGPOLLRT     100.0
 #define MIN_NICCHGPOLLRT     1.0
+#define MIN_STATE_INTERVAL   1.0
 #define MAX_DEBUGLVL         9
 #define MIN_DEBUGLVL         0
 #define MAX_TOS              252
@@ -154,6 +160,7 @@
 #define MIN_LQ_LEVEL         0
 #define MAX_LQ_AGING         1.0
 #define MIN_LQ_AGING         0.01
+#define MAX_LQ_RELEVANT_CHANGE 100
 
 #define MIN_SMARTGW_USE_COUNT_MIN  1
 #define MAX_SMARTGW_USE_COUNT_MAX  64
@@ -196,6 +203,13 @@ typedef enum {
   FIBM_CNT
 } olsr_fib_metric_options;
 
+typedef enum {
+  LQS_EWMA,
+  LQS_WINDOW,
+  LQS_KALMAN,
+  LQS_CNT
+} olsr_lq_smoothing_options;
+
 enum olsr_if_mode {
   IF_MODE_MESH,
   IF_MODE_ETHER,
@@ -315,12 +329,18 @@ struct olsrd_config {
   uint8_t lq_fish;
   float lq_aging;
   char *lq_algorithm;
+  olsr_lq_smoothing_options lq_smoothing;
+  uint8_t lq_relevant_change;
 
   float min_tc_vtime;
 
   bool set_ip_forward;
 
   char *lock_file;
+  char *state_file;
+  float state_interval;
+  bool keep_routes;
+  bool metrics;
   bool use_niit;
 
   bool smart_gw_active;
@@ -393,6 +413,7 @@ extern "C" {
 
   extern const char *GW_UPLINK_TXT[];
   extern const char *FIB_METRIC_TXT[];
+  extern const char *LQ_SMOOTHING_TXT[];
   extern const char *OLSR_IF_MODE[];
 
 /*
@@ -441,6 +462,8 @@ extern "C" {
 
   int olsrd_write_cnf(struct olsrd_config *, const char *);
 
+  int olsrd_compile_cnf(const char *conffile, const char *binfile);
+
   struct if_config_options *get_default_if_config(void);
 
   struct olsrd_config *olsrd_get_default_cnf(char * configuration_file);
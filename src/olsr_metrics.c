@@ -0,0 +1,316 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#include "olsr_metrics.h"
+#include "olsr.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __MACH__
+#include "mach/clock_gettime.h"
+#endif /* __MACH__ */
+
+/* head of the registry, metrics are never removed */
+struct olsr_metric *olsr_metrics = NULL;
+
+/* number of consumers, samples are only recorded while there is one */
+unsigned int olsr_metrics_users = 0;
+
+static char *
+metric_strdup(const char *str, const char *description)
+{
+  char *copy;
+
+  if (!str) {
+    return NULL;
+  }
+  copy = olsr_malloc(strlen(str) + 1, description);
+  strcpy(copy, str);
+  return copy;
+}
+
+static bool
+metric_str_equal(const char *str1, const char *str2)
+{
+  if (!str1 || !str2) {
+    return str1 == str2;
+  }
+  return strcmp(str1, str2) == 0;
+}
+
+/**
+ * @return the bucket of a latency
+ */
+static unsigned int
+metric_bucket(uint64_t nsec)
+{
+  unsigned int exp;
+
+  if (nsec < OLSR_METRIC_SUB_BUCKETS) {
+    return (unsigned int)nsec;
+  }
+  if (nsec >> (OLSR_METRIC_MAX_EXP + 1)) {
+    return OLSR_METRIC_BUCKETS - 1;
+  }
+
+  exp = 63 - (unsigned int)__builtin_clzll(nsec);
+  return ((exp - OLSR_METRIC_SUB_BITS + 1) << OLSR_METRIC_SUB_BITS)
+      | (unsigned int)((nsec >> (exp - OLSR_METRIC_SUB_BITS)) & (OLSR_METRIC_SUB_BUCKETS - 1));
+}
+
+/**
+ * @return the smallest latency of a bucket in nanoseconds
+ */
+uint64_t
+olsr_metric_bucket_lower(unsigned int bucket)
+{
+  unsigned int group = bucket >> OLSR_METRIC_SUB_BITS;
+
+  if (group == 0) {
+    return bucket;
+  }
+  return (uint64_t)(OLSR_METRIC_SUB_BUCKETS | (bucket & (OLSR_METRIC_SUB_BUCKETS - 1))) << (group - 1);
+}
+
+/**
+ * @return the smallest latency above a bucket in nanoseconds
+ */
+uint64_t
+olsr_metric_bucket_upper(unsigned int bucket)
+{
+  unsigned int group = bucket >> OLSR_METRIC_SUB_BITS;
+
+  if (group == 0) {
+    return bucket + 1;
+  }
+  return olsr_metric_bucket_lower(bucket) + ((uint64_t)1 << (group - 1));
+}
+
+/**
+ * Register a consumer of the metrics, samples are recorded from now on.
+ */
+void
+olsr_metrics_enable(void)
+{
+  __atomic_store_n(&olsr_metrics_users, olsr_metrics_users + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Unregister a consumer of the metrics. The values are kept, but no more
+ * samples are recorded when the last consumer is gone.
+ */
+void
+olsr_metrics_disable(void)
+{
+  if (olsr_metrics_users) {
+    __atomic_store_n(&olsr_metrics_users, olsr_metrics_users - 1, __ATOMIC_RELAXED);
+  }
+}
+
+/**
+ * Look up a metric, register it when it does not exist yet. The strings
+ * are copied.
+ *
+ * @param type counter or latency histogram
+ * @param name the name of the family of the metric
+ * @param help a description of the family
+ * @param label_name the name of the label of the family, or NULL
+ * @param label the value of the label, or NULL
+ * @return the metric
+ */
+struct olsr_metric *
+olsr_metric_get(enum olsr_metric_type type, const char *name, const char *help, const char *label_name, const char *label)
+{
+  struct olsr_metric *metric, *last = NULL, *family = NULL;
+
+  for (metric = olsr_metrics; metric; metric = metric->next) {
+    if (strcmp(metric->name, name) == 0) {
+      if (metric_str_equal(metric->label, label)) {
+        return metric;
+      }
+      family = metric;
+    }
+    last = metric;
+  }
+
+  metric = olsr_malloc(sizeof(*metric), "metric");
+  metric->name = metric_strdup(name, "metric name");
+  metric->help = metric_strdup(help, "metric help");
+  metric->label_name = metric_strdup(label_name, "metric label name");
+  metric->label = metric_strdup(label, "metric label");
+  metric->type = type;
+  if (type == OLSR_METRIC_LATENCY) {
+    metric->buckets = olsr_malloc(OLSR_METRIC_BUCKETS * sizeof(*metric->buckets), "metric buckets");
+  }
+
+  /* keep families together, readers may walk the registry concurrently */
+  if (!family) {
+    family = last;
+  }
+  if (family) {
+    metric->next = family->next;
+    __atomic_store_n(&family->next, metric, __ATOMIC_RELEASE);
+  } else {
+    __atomic_store_n(&olsr_metrics, metric, __ATOMIC_RELEASE);
+  }
+  return metric;
+}
+
+/**
+ * @return a monotonic time in nanoseconds, never 0
+ */
+uint64_t
+olsr_metrics_clock(void)
+{
+  struct timespec ts;
+  uint64_t nsec;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  nsec = (uint64_t)ts.tv_sec * 1000000000 + (uint64_t)ts.tv_nsec;
+  return nsec ? nsec : 1;
+}
+
+/**
+ * Record a latency sample
+ *
+ * @param metric the latency metric
+ * @param nsec the latency in nanoseconds
+ */
+void
+olsr_metric_record(struct olsr_metric *metric, uint64_t nsec)
+{
+  unsigned int bucket = metric_bucket(nsec);
+
+  __atomic_store_n(&metric->buckets[bucket], metric->buckets[bucket] + 1, __ATOMIC_RELAXED);
+  __atomic_store_n(&metric->sum, metric->sum + nsec, __ATOMIC_RELAXED);
+  if (nsec > metric->max) {
+    __atomic_store_n(&metric->max, nsec, __ATOMIC_RELAXED);
+  }
+  __atomic_store_n(&metric->count, metric->count + 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Copy the values of a metric. A sample that is recorded concurrently may
+ * be partially visible in the copy.
+ *
+ * @param metric the metric
+ * @param values the copy
+ */
+void
+olsr_metric_read(const struct olsr_metric *metric, struct olsr_metric_values *values)
+{
+  unsigned int i;
+
+  values->count = __atomic_load_n(&metric->count, __ATOMIC_RELAXED);
+  values->sum = __atomic_load_n(&metric->sum, __ATOMIC_RELAXED);
+  values->max = __atomic_load_n(&metric->max, __ATOMIC_RELAXED);
+  for (i = 0; i < OLSR_METRIC_BUCKETS; i++) {
+    values->buckets[i] = metric->buckets ? __atomic_load_n(&metric->buckets[i], __ATOMIC_RELAXED) : 0;
+  }
+}
+
+/**
+ * @param values the values of a latency metric
+ * @param quantile the quantile, between 0 and 1
+ * @return the latency in nanoseconds below which the quantile of the
+ * samples lies, 0 without samples
+ */
+uint64_t
+olsr_metric_quantile(const struct olsr_metric_values *values, double quantile)
+{
+  uint64_t total = 0, rank, seen = 0;
+  unsigned int i;
+
+  for (i = 0; i < OLSR_METRIC_BUCKETS; i++) {
+    total += values->buckets[i];
+  }
+  if (!total) {
+    return 0;
+  }
+
+  rank = (uint64_t)(quantile * (double)total + 0.5);
+  if (rank < 1) {
+    rank = 1;
+  } else if (rank > total) {
+    rank = total;
+  }
+
+  for (i = 0; i < OLSR_METRIC_BUCKETS; i++) {
+    seen += values->buckets[i];
+    if (seen >= rank) {
+      /* the middle of the bucket, but never more than the maximum */
+      uint64_t nsec = (olsr_metric_bucket_lower(i) + olsr_metric_bucket_upper(i) - 1) / 2;
+      return (values->max && nsec > values->max) ? values->max : nsec;
+    }
+  }
+  return values->max;
+}
+
+/**
+ * @param values the values of a latency metric
+ * @param nsec a latency in nanoseconds, a power of two is exact
+ * @return the number of samples below the latency
+ */
+uint64_t
+olsr_metric_count_below(const struct olsr_metric_values *values, uint64_t nsec)
+{
+  uint64_t count = 0;
+  unsigned int i;
+
+  for (i = 0; i < OLSR_METRIC_BUCKETS && olsr_metric_bucket_upper(i) <= nsec; i++) {
+    count += values->buckets[i];
+  }
+  return count;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,173 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#ifndef OLSR_METRICS_H_
+#define OLSR_METRICS_H_
+
+#include "olsr_types.h"
+#include "defs.h"
+
+/*
+ * Registry of counters and latency histograms of the hot paths of olsrd.
+ *
+ * Samples are only recorded while at least one consumer has enabled the
+ * registry, when it is disabled a sample costs a test of a global. All
+ * samples are recorded on the main thread, a metric has a single writer
+ * and is updated with relaxed atomic stores, so that it can be read from
+ * any thread without locks.
+ *
+ * Latencies are kept in nanoseconds in log-linear (HDR style) buckets:
+ * every power of two is split into OLSR_METRIC_SUB_BUCKETS buckets, which
+ * bounds the relative error of a quantile to 1 / OLSR_METRIC_SUB_BUCKETS.
+ */
+
+#define OLSR_METRIC_SUB_BITS     3
+#define OLSR_METRIC_SUB_BUCKETS  (1 << OLSR_METRIC_SUB_BITS)
+
+/* samples are capped at 2^(OLSR_METRIC_MAX_EXP + 1) - 1 ns, about 18 minutes */
+#define OLSR_METRIC_MAX_EXP      39
+#define OLSR_METRIC_BUCKETS      ((OLSR_METRIC_MAX_EXP - OLSR_METRIC_SUB_BITS + 2) << OLSR_METRIC_SUB_BITS)
+
+enum olsr_metric_type {
+  OLSR_METRIC_COUNTER,
+  OLSR_METRIC_LATENCY
+};
+
+struct olsr_metric {
+  /* name of the family, e.g. "parse_message" */
+  char *name;
+  char *help;
+
+  /* the label that tells the metrics of a family apart, or NULL */
+  char *label_name;
+  char *label;
+
+  enum olsr_metric_type type;
+
+  /* number of samples or value of the counter */
+  uint64_t count;
+
+  /* sum and maximum of the samples in nanoseconds */
+  uint64_t sum;
+  uint64_t max;
+
+  /* OLSR_METRIC_BUCKETS bucket counts, latencies only */
+  uint64_t *buckets;
+
+  /* the metrics of a family are adjacent in the registry */
+  struct olsr_metric *next;
+};
+
+/* copy of the values of a metric, see olsr_metric_read() */
+struct olsr_metric_values {
+  uint64_t count;
+  uint64_t sum;
+  uint64_t max;
+  uint64_t buckets[OLSR_METRIC_BUCKETS];
+};
+
+extern struct olsr_metric *olsr_metrics;
+extern unsigned int olsr_metrics_users;
+
+#define OLSR_FOR_ALL_METRICS(metric) \
+  for (metric = __atomic_load_n(&olsr_metrics, __ATOMIC_ACQUIRE); metric; \
+       metric = __atomic_load_n(&metric->next, __ATOMIC_ACQUIRE))
+
+/* main thread */
+void olsr_metrics_enable(void);
+void olsr_metrics_disable(void);
+struct olsr_metric *olsr_metric_get(enum olsr_metric_type type, const char *name, const char *help,
+    const char *label_name, const char *label);
+uint64_t olsr_metrics_clock(void);
+void olsr_metric_record(struct olsr_metric *metric, uint64_t nsec);
+
+/* any thread */
+void olsr_metric_read(const struct olsr_metric *metric, struct olsr_metric_values *values);
+uint64_t olsr_metric_quantile(const struct olsr_metric_values *values, double quantile);
+uint64_t olsr_metric_count_below(const struct olsr_metric_values *values, uint64_t nsec);
+uint64_t olsr_metric_bucket_lower(unsigned int bucket);
+uint64_t olsr_metric_bucket_upper(unsigned int bucket);
+
+/**
+ * @return the start time of a latency sample, 0 when the registry is
+ * disabled
+ */
+static INLINE uint64_t olsr_metrics_start(void) {
+  return olsr_metrics_users ? olsr_metrics_clock() : 0;
+}
+
+/**
+ * Record the latency since olsr_metrics_start()
+ *
+ * @param metric the latency metric
+ * @param start the return value of olsr_metrics_start()
+ */
+static INLINE void olsr_metrics_stop(struct olsr_metric *metric, uint64_t start) {
+  if (start) {
+    olsr_metric_record(metric, olsr_metrics_clock() - start);
+  }
+}
+
+/**
+ * Add to a counter
+ *
+ * @param metric the counter
+ * @param n the value to add
+ */
+static INLINE void olsr_metric_add(struct olsr_metric *metric, uint64_t n) {
+  if (olsr_metrics_users) {
+    __atomic_store_n(&metric->count, metric->count + n, __ATOMIC_RELAXED);
+  }
+}
+
+#endif /* OLSR_METRICS_H_ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,661 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#include "olsr_reconfigure.h"
+#include "defs.h"
+#include "olsr.h"
+#include "log.h"
+#include "cli.h"
+#include "ifnet.h"
+#include "interfaces.h"
+#include "link_set.h"
+#include "mantissa.h"
+#include "mpr.h"
+#include "net_os.h"
+#include "olsr_metrics.h"
+#include "olsr_niit.h"
+#include "plugin_loader.h"
+#include "scheduler.h"
+#include "cfgparser/olsrd_conf.h"
+#include "cfgparser/olsrd_conf_checksum.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t reconfigure_pending = 0;
+
+/**
+ * Request a reload of the configuration file. Only sets a flag, the
+ * reload itself is done from the scheduler loop.
+ */
+void
+olsr_reconfigure_request(void)
+{
+  reconfigure_pending = 1;
+}
+
+static bool
+reconfigure_str_changed(const char *a, const char *b)
+{
+  if (a == NULL || b == NULL) {
+    return a != b;
+  }
+  return strcmp(a, b) != 0;
+}
+
+/**
+ * Parse the configuration file and the command line into a new
+ * configuration, the same way main() does at startup.
+ *
+ * @return the new configuration, or NULL when it could not be loaded
+ */
+static struct olsrd_config *
+reconfigure_load(void)
+{
+  struct olsrd_config *running = olsr_cnf;
+  struct olsrd_config *cnf;
+  struct stat statbuf;
+  char **argv = NULL;
+  char **args;
+  int argc = 0;
+  int argc_cli = 0;
+  int rc;
+  int i;
+
+  if (stat(running->configuration_file, &statbuf) < 0) {
+    olsr_syslog(OLSR_LOG_ERR, "Could not find config file %s: %s", running->configuration_file, strerror(errno));
+    return NULL;
+  }
+
+  cnf = olsrd_get_default_cnf(strdup(running->configuration_file));
+  if (cnf == NULL) {
+    return NULL;
+  }
+
+  /* the command line without the -f configFile arguments, like loadConfig() leaves it */
+  get_argc_argv(&argc, &argv);
+  args = olsr_malloc(sizeof(char *) * (argc + 1), "reconfigure arguments");
+  for (i = 0; i < argc; i++) {
+    if (i > 0 && i < (argc - 1) && strcmp(argv[i], "-f") == 0) {
+      i++;
+      continue;
+    }
+    args[argc_cli++] = argv[i];
+  }
+  args[argc_cli] = NULL;
+
+  olsrd_config_checksum_save();
+  olsrd_config_checksum_init();
+  olsrd_config_checksum_add_cli(argc, argv);
+  olsrd_config_checksum_add(OLSRD_CONFIG_START, OLSRD_CONFIG_START_LEN);
+
+  /* the parser and the command line processing work on olsr_cnf */
+  olsr_cnf = cnf;
+
+  rc = olsrd_parse_cnf(cnf->configuration_file);
+  if (rc == 0) {
+    struct if_config_options *default_ifcnf = get_default_if_config();
+    char *error = NULL;
+
+    if (default_ifcnf == NULL || olsr_process_arguments(argc_cli, args, cnf, default_ifcnf, &error) != 0) {
+      olsr_syslog(OLSR_LOG_ERR, "Reconfiguration: %s", error ? error : "bad command line");
+      rc = -1;
+    } else {
+      struct olsr_if *in;
+
+      for (in = cnf->interfaces; in != NULL; in = in->next) {
+        if (in->cnf == NULL) {
+          in->cnf = olsr_malloc(sizeof(struct if_config_options), "Set default config");
+          *in->cnf = *default_ifcnf;
+        }
+      }
+    }
+    free(default_ifcnf);
+  }
+
+  olsrd_config_checksum_add(OLSRD_CONFIG_END, OLSRD_CONFIG_END_LEN);
+  olsrd_config_checksum_final();
+
+  if (rc == 0 && olsrd_sanity_check_cnf(cnf) < 0) {
+    rc = -1;
+  }
+  if (rc == 0) {
+    set_derived_cnf(cnf);
+  }
+
+  olsr_cnf = running;
+  free(args);
+
+  if (rc != 0) {
+    olsrd_config_checksum_restore();
+    olsrd_free_cnf(&cnf);
+    return NULL;
+  }
+  return cnf;
+}
+
+/**
+ * Count (and log) the settings that can only be changed by a restart.
+ * These keep their running value until olsrd restarts.
+ */
+static int
+reconfigure_check_restart(const struct olsrd_config *cnf)
+{
+  int restart = 0;
+
+#define RECONFIGURE_RESTART(changed, name) \
+  if (changed) { \
+    olsr_syslog(OLSR_LOG_INFO, "Reconfiguration: %s changed, a restart is needed to apply it", name); \
+    restart++; \
+  }
+
+  RECONFIGURE_RESTART(cnf->ip_version != olsr_cnf->ip_version, "IpVersion");
+  RECONFIGURE_RESTART(cnf->olsrport != olsr_cnf->olsrport, "OlsrPort");
+  RECONFIGURE_RESTART(cnf->host_emul != olsr_cnf->host_emul, "host emulation");
+  RECONFIGURE_RESTART(cnf->tos != olsr_cnf->tos, "TosValue");
+  RECONFIGURE_RESTART(cnf->rt_proto != olsr_cnf->rt_proto, "RtProto");
+  RECONFIGURE_RESTART(cnf->rt_table != olsr_cnf->rt_table
+      || cnf->rt_table_default != olsr_cnf->rt_table_default
+      || cnf->rt_table_tunnel != olsr_cnf->rt_table_tunnel
+      || cnf->rt_table_pri != olsr_cnf->rt_table_pri
+      || cnf->rt_table_tunnel_pri != olsr_cnf->rt_table_tunnel_pri
+      || cnf->rt_table_defaultolsr_pri != olsr_cnf->rt_table_defaultolsr_pri
+      || cnf->rt_table_default_pri != olsr_cnf->rt_table_default_pri, "routing table setup");
+  RECONFIGURE_RESTART(cnf->fib_metric != olsr_cnf->fib_metric
+      || cnf->fib_metric_default != olsr_cnf->fib_metric_default, "FIB metric");
+  RECONFIGURE_RESTART(cnf->ipc_connections != olsr_cnf->ipc_connections, "IpcConnect MaxConnections");
+  RECONFIGURE_RESTART(cnf->willingness_auto != olsr_cnf->willingness_auto
+      || cnf->will_int != olsr_cnf->will_int, "automatic Willingness");
+  RECONFIGURE_RESTART(cnf->nic_chgs_pollrate != olsr_cnf->nic_chgs_pollrate, "NicChgsPollInt");
+  RECONFIGURE_RESTART(cnf->lq_level != olsr_cnf->lq_level, "LinkQualityLevel");
+  RECONFIGURE_RESTART(reconfigure_str_changed(cnf->lq_algorithm, olsr_cnf->lq_algorithm), "LinkQualityAlgorithm");
+  RECONFIGURE_RESTART(cnf->lq_smoothing != olsr_cnf->lq_smoothing, "LinkQualitySmoothing");
+  /* the smoothing state of the existing links depends on it */
+  RECONFIGURE_RESTART(cnf->lq_aging != olsr_cnf->lq_aging, "LinkQualityAging");
+  RECONFIGURE_RESTART(cnf->set_ip_forward != olsr_cnf->set_ip_forward, "SetIpForward");
+  RECONFIGURE_RESTART(reconfigure_str_changed(cnf->lock_file, olsr_cnf->lock_file), "LockFile");
+  RECONFIGURE_RESTART(reconfigure_str_changed(cnf->pidfile, olsr_cnf->pidfile), "Pidfile");
+  RECONFIGURE_RESTART(reconfigure_str_changed(cnf->state_file, olsr_cnf->state_file), "StateFile");
+  RECONFIGURE_RESTART(cnf->state_interval != olsr_cnf->state_interval, "StateInterval");
+  RECONFIGURE_RESTART(cnf->use_niit != olsr_cnf->use_niit, "UseNiit");
+  RECONFIGURE_RESTART(cnf->use_src_ip_routes != olsr_cnf->use_src_ip_routes
+      || memcmp(&cnf->main_addr, &olsr_cnf->main_addr, sizeof(cnf->main_addr)) != 0
+      || memcmp(&cnf->unicast_src_ip, &olsr_cnf->unicast_src_ip, sizeof(cnf->unicast_src_ip)) != 0, "MainIp / SrcIpRoutes");
+  RECONFIGURE_RESTART(cnf->smart_gw_active != olsr_cnf->smart_gw_active
+      || cnf->smart_gw_allow_nat != olsr_cnf->smart_gw_allow_nat
+      || cnf->smart_gw_uplink_nat != olsr_cnf->smart_gw_uplink_nat
+      || cnf->smart_gw_type != olsr_cnf->smart_gw_type
+      || cnf->smart_gw_uplink != olsr_cnf->smart_gw_uplink
+      || cnf->smart_gw_downlink != olsr_cnf->smart_gw_downlink
+      || cnf->smart_gw_period != olsr_cnf->smart_gw_period
+      || memcmp(&cnf->smart_gw_prefix, &olsr_cnf->smart_gw_prefix, sizeof(cnf->smart_gw_prefix)) != 0, "smart gateway");
+
+#undef RECONFIGURE_RESTART
+
+  return restart;
+}
+
+/**
+ * Apply the global settings that are read at runtime
+ *
+ * @return true when the MPR selection has to be redone
+ */
+static bool
+reconfigure_globals(struct olsrd_config *cnf)
+{
+  bool neighborhood = false;
+  struct ip_prefix_list *ipc_nets;
+
+  olsr_cnf->debug_level = cnf->debug_level;
+  olsr_cnf->allow_no_interfaces = cnf->allow_no_interfaces;
+  olsr_cnf->clear_screen = cnf->clear_screen;
+  olsr_cnf->keep_routes = cnf->keep_routes;
+
+  if (olsr_cnf->metrics != cnf->metrics) {
+    if (cnf->metrics) {
+      olsr_metrics_enable();
+    } else {
+      olsr_metrics_disable();
+    }
+    olsr_cnf->metrics = cnf->metrics;
+  }
+  olsr_cnf->pollrate = cnf->pollrate;
+  olsr_cnf->use_hysteresis = cnf->use_hysteresis;
+  olsr_cnf->hysteresis_param = cnf->hysteresis_param;
+  olsr_cnf->lq_fish = cnf->lq_fish;
+  olsr_cnf->lq_relevant_change = cnf->lq_relevant_change;
+  olsr_cnf->min_tc_vtime = cnf->min_tc_vtime;
+  olsr_cnf->lq_nat_thresh = cnf->lq_nat_thresh;
+
+  if (!olsr_cnf->willingness_auto && !cnf->willingness_auto && olsr_cnf->willingness != cnf->willingness) {
+    olsr_cnf->willingness = cnf->willingness;
+    neighborhood = true;
+  }
+  if (olsr_cnf->tc_redundancy != cnf->tc_redundancy || olsr_cnf->mpr_coverage != cnf->mpr_coverage) {
+    olsr_cnf->tc_redundancy = cnf->tc_redundancy;
+    olsr_cnf->mpr_coverage = cnf->mpr_coverage;
+    neighborhood = true;
+  }
+
+  /* the old list is freed with the new configuration */
+  ipc_nets = olsr_cnf->ipc_nets;
+  olsr_cnf->ipc_nets = cnf->ipc_nets;
+  cnf->ipc_nets = ipc_nets;
+
+  return neighborhood;
+}
+
+/**
+ * Bring the local HNA entries in line with the new configuration. They
+ * are announced with the next HNA message.
+ */
+static void
+reconfigure_hna(struct olsrd_config *cnf)
+{
+  struct ip_prefix_list *h, *next;
+  bool changed = false;
+
+  for (h = olsr_cnf->hna_entries; h != NULL; h = h->next) {
+    if (!ip_prefix_list_find(cnf->hna_entries, &h->net.prefix, h->net.prefix_len)) {
+      changed = true;
+      break;
+    }
+  }
+  for (h = cnf->hna_entries; h != NULL && !changed; h = h->next) {
+    if (!ip_prefix_list_find(olsr_cnf->hna_entries, &h->net.prefix, h->net.prefix_len)) {
+      changed = true;
+    }
+  }
+  if (!changed) {
+    return;
+  }
+
+#ifdef __linux__
+  if (olsr_cnf->use_niit) {
+    olsr_cleanup_niit_routes();
+  }
+#endif /* __linux__ */
+
+  for (h = olsr_cnf->hna_entries; h != NULL; h = next) {
+    next = h->next;
+    if (!ip_prefix_list_find(cnf->hna_entries, &h->net.prefix, h->net.prefix_len)) {
+      ip_prefix_list_remove(&olsr_cnf->hna_entries, &h->net.prefix, h->net.prefix_len);
+    }
+  }
+  for (h = cnf->hna_entries; h != NULL; h = h->next) {
+    if (!ip_prefix_list_find(olsr_cnf->hna_entries, &h->net.prefix, h->net.prefix_len)) {
+      ip_prefix_list_add(&olsr_cnf->hna_entries, &h->net.prefix, h->net.prefix_len);
+    }
+  }
+
+#ifdef __linux__
+  if (olsr_cnf->use_niit) {
+    olsr_setup_niit_routes();
+  }
+#endif /* __linux__ */
+
+  olsr_syslog(OLSR_LOG_INFO, "Reconfiguration: HNA entries updated");
+}
+
+static void
+reconfigure_free_if(struct olsr_if *in)
+{
+  struct olsr_lq_mult *mult, *next_mult;
+
+  for (mult = in->cnf->lq_mult; mult != NULL; mult = next_mult) {
+    next_mult = mult->next;
+    free(mult);
+  }
+  free(in->cnf);
+  free(in->cnfi);
+  free(in->name);
+  free(in);
+}
+
+static bool
+reconfigure_lq_mult_changed(const struct olsr_lq_mult *a, const struct olsr_lq_mult *b)
+{
+  while (a && b) {
+    if (a->value != b->value || memcmp(&a->addr, &b->addr, sizeof(a->addr)) != 0) {
+      return true;
+    }
+    a = a->next;
+    b = b->next;
+  }
+  return a != b;
+}
+
+/**
+ * Settings that are bound to the sockets of an interface, the interface
+ * has to be reopened to change them.
+ */
+static bool
+reconfigure_if_needs_reopen(const struct if_config_options *a, const struct if_config_options *b)
+{
+  return a->mode != b->mode
+      || memcmp(&a->ipv4_multicast, &b->ipv4_multicast, sizeof(a->ipv4_multicast)) != 0
+      || memcmp(&a->ipv6_multicast, &b->ipv6_multicast, sizeof(a->ipv6_multicast)) != 0
+      || memcmp(&a->ipv4_src, &b->ipv4_src, sizeof(a->ipv4_src)) != 0
+      || memcmp(&a->ipv6_src, &b->ipv6_src, sizeof(a->ipv6_src)) != 0;
+}
+
+static bool
+reconfigure_msg_params_changed(const struct olsr_msg_params *a, const struct olsr_msg_params *b)
+{
+  return a->emission_interval != b->emission_interval || a->validity_time != b->validity_time;
+}
+
+static bool
+reconfigure_if_changed(const struct if_config_options *a, const struct if_config_options *b)
+{
+  return reconfigure_if_needs_reopen(a, b)
+      || a->weight.value != b->weight.value
+      || a->weight.fixed != b->weight.fixed
+      || reconfigure_msg_params_changed(&a->hello_params, &b->hello_params)
+      || reconfigure_msg_params_changed(&a->tc_params, &b->tc_params)
+      || reconfigure_msg_params_changed(&a->mid_params, &b->mid_params)
+      || reconfigure_msg_params_changed(&a->hna_params, &b->hna_params)
+      || a->autodetect_chg != b->autodetect_chg
+      || reconfigure_lq_mult_changed(a->lq_mult, b->lq_mult);
+}
+
+static void
+reconfigure_msg_timer(struct timer_entry *timer, const struct olsr_msg_params *prev, const struct olsr_msg_params *params,
+    uint8_t jitter)
+{
+  if (prev->emission_interval != params->emission_interval) {
+    olsr_change_timer(timer, (unsigned int)(params->emission_interval * MSEC_PER_SEC), jitter, OLSR_TIMER_PERIODIC);
+  }
+}
+
+/**
+ * Apply new message intervals, validity times and the weight to a
+ * running interface
+ */
+static void
+reconfigure_if_params(struct olsr_if *iface, const struct if_config_options *prev)
+{
+  struct interface_olsr *ifp = iface->interf;
+  const struct if_config_options *cnf = iface->cnf;
+
+  reconfigure_msg_timer(ifp->hello_gen_timer, &prev->hello_params, &cnf->hello_params, HELLO_JITTER);
+  reconfigure_msg_timer(ifp->tc_gen_timer, &prev->tc_params, &cnf->tc_params, TC_JITTER);
+  reconfigure_msg_timer(ifp->mid_gen_timer, &prev->mid_params, &cnf->mid_params, MID_JITTER);
+  reconfigure_msg_timer(ifp->hna_gen_timer, &prev->hna_params, &cnf->hna_params, HNA_JITTER);
+
+  /* Recalculate max topology hold time */
+  if (olsr_cnf->max_tc_vtime < cnf->tc_params.emission_interval) {
+    olsr_cnf->max_tc_vtime = cnf->tc_params.emission_interval;
+  }
+
+  ifp->hello_etime = (olsr_reltime) (cnf->hello_params.emission_interval * MSEC_PER_SEC);
+  ifp->valtimes.hello = reltime_to_me(cnf->hello_params.validity_time * MSEC_PER_SEC);
+  ifp->valtimes.tc = reltime_to_me(cnf->tc_params.validity_time * MSEC_PER_SEC);
+  ifp->valtimes.mid = reltime_to_me(cnf->mid_params.validity_time * MSEC_PER_SEC);
+  ifp->valtimes.hna = reltime_to_me(cnf->hna_params.validity_time * MSEC_PER_SEC);
+  ifp->valtimes.hna_reltime = me_to_reltime(ifp->valtimes.hna);
+
+  if (cnf->weight.fixed) {
+    ifp->int_metric = cnf->weight.value;
+  } else if (prev->weight.fixed) {
+    ifp->int_metric = calculate_if_metric(ifp->int_name);
+  }
+}
+
+/**
+ * Add, remove and update interfaces
+ *
+ * @return true when the link quality multipliers have to be re-evaluated
+ */
+static bool
+reconfigure_interfaces(struct olsrd_config *cnf)
+{
+  struct olsr_if **prev_next, *in, *new_in, **new_prev_next;
+  bool allow_no_interfaces = olsr_cnf->allow_no_interfaces;
+  bool lq_mult = false;
+
+  /* removing or reopening the last interface must not shut olsrd down */
+  olsr_cnf->allow_no_interfaces = true;
+
+  prev_next = &olsr_cnf->interfaces;
+  while ((in = *prev_next) != NULL) {
+    if (in->host_emul) {
+      prev_next = &in->next;
+      continue;
+    }
+
+    for (new_in = cnf->interfaces; new_in != NULL; new_in = new_in->next) {
+      if (strcmp(in->name, new_in->name) == 0) {
+        break;
+      }
+    }
+
+    if (new_in == NULL) {
+      olsr_syslog(OLSR_LOG_INFO, "Reconfiguration: removing interface %s", in->name);
+      if (in->configured) {
+        olsr_remove_interface(in);
+      }
+      *prev_next = in->next;
+      reconfigure_free_if(in);
+      continue;
+    }
+
+    if (reconfigure_if_changed(in->cnf, new_in->cnf)) {
+      struct if_config_options *prev = in->cnf;
+      struct if_config_options *prev_i = in->cnfi;
+
+      /* the previous options are freed with the new configuration */
+      in->cnf = new_in->cnf;
+      in->cnfi = new_in->cnfi;
+      new_in->cnf = prev;
+      new_in->cnfi = prev_i;
+
+      if (in->configured && reconfigure_if_needs_reopen(prev, in->cnf)) {
+        olsr_syslog(OLSR_LOG_INFO, "Reconfiguration: reopening interface %s", in->name);
+        olsr_remove_interface(in);
+        chk_if_up(in, 1);
+      } else if (in->configured) {
+        OLSR_PRINTF(1, "Reconfiguration: updating interface %s\n", in->name);
+        reconfigure_if_params(in, prev);
+      }
+      if (reconfigure_lq_mult_changed(prev->lq_mult, in->cnf->lq_mult)) {
+        lq_mult = true;
+      }
+    }
+
+    prev_next = &in->next;
+  }
+
+  /* whatever is left in the new configuration are new interfaces, append them */
+  new_prev_next = &cnf->interfaces;
+  while ((new_in = *new_prev_next) != NULL) {
+    for (in = olsr_cnf->interfaces; in != NULL; in = in->next) {
+      if (strcmp(in->name, new_in->name) == 0) {
+        break;
+      }
+    }
+    if (in != NULL || new_in->host_emul) {
+      new_prev_next = &new_in->next;
+      continue;
+    }
+
+    *new_prev_next = new_in->next;
+    new_in->next = NULL;
+    new_in->configured = false;
+    new_in->interf = NULL;
+    *prev_next = new_in;
+    prev_next = &new_in->next;
+
+    olsr_syslog(OLSR_LOG_INFO, "Reconfiguration: adding interface %s", new_in->name);
+    chk_if_up(new_in, 1);
+  }
+
+  olsr_cnf->allow_no_interfaces = allow_no_interfaces;
+  if (ifnet == NULL && !olsr_cnf->allow_no_interfaces) {
+    olsr_syslog(OLSR_LOG_ERR, "Reconfiguration: no active interfaces left");
+  }
+
+  return lq_mult;
+}
+
+/**
+ * Restart olsrd to apply settings that can not be changed at runtime:
+ * a child waits for this process to exit and executes olsrd again with
+ * the same arguments, as SIGHUP always did before live reconfiguration.
+ * With -nofork olsrd keeps running with the old values of these settings.
+ *
+ * @param restart the number of settings that need a restart
+ */
+static void
+reconfigure_restart(int restart)
+{
+#ifndef _WIN32
+  int argc;
+  char **argv;
+
+  if (olsr_cnf->no_fork) {
+    olsr_syslog(OLSR_LOG_ERR, "Configuration reloaded, %d setting(s) NOT applied: they need a restart, which -nofork prevents",
+                restart);
+    return;
+  }
+
+  get_argc_argv(&argc, &argv);
+  if (!fork()) {
+    int i;
+    sigset_t sigs;
+
+    /* New process, wait a bit to let the old process exit */
+    sleep(3);
+    sigemptyset(&sigs);
+    sigaddset(&sigs, SIGHUP);
+    sigprocmask(SIG_UNBLOCK, &sigs, NULL);
+    for (i = sysconf(_SC_OPEN_MAX); --i > STDERR_FILENO;) {
+      close(i);
+    }
+    olsr_syslog(OLSR_LOG_INFO, "Restarting %s", argv[0]);
+    execv(argv[0], argv);
+    olsr_syslog(OLSR_LOG_ERR, "execv(%s) failed: %s", argv[0], strerror(errno));
+    _exit(EXIT_FAILURE);
+  }
+
+  olsr_syslog(OLSR_LOG_INFO, "Configuration reloaded, %d setting(s) need a restart, restarting", restart);
+  olsr_exit(NULL, EXIT_SUCCESS);
+#else /* _WIN32 */
+  olsr_syslog(OLSR_LOG_ERR, "Configuration reloaded, %d setting(s) NOT applied: they need a restart", restart);
+#endif /* _WIN32 */
+}
+
+/**
+ * Reload the configuration and apply it in place, restart when that is
+ * not possible
+ */
+static void
+olsr_reconfigure(void)
+{
+  struct olsrd_config *cnf;
+  int restart;
+
+  olsr_syslog(OLSR_LOG_INFO, "Reloading configuration %s", olsr_cnf->configuration_file);
+
+  cnf = reconfigure_load();
+  if (cnf == NULL) {
+    olsr_syslog(OLSR_LOG_ERR, "Reloading the configuration failed, keeping the running configuration");
+    return;
+  }
+
+  restart = reconfigure_check_restart(cnf);
+
+  if (reconfigure_globals(cnf)) {
+    olsr_mpr_invalidate();
+    changes_neighborhood = true;
+  }
+  reconfigure_hna(cnf);
+  if (reconfigure_interfaces(cnf)) {
+    olsr_update_link_multipliers();
+  }
+  restart += olsr_reconfigure_plugins(cnf->plugins);
+
+  olsrd_free_cnf(&cnf);
+
+  /* regenerate the configuration dump */
+  olsrd_cfgfile_cleanup();
+  olsrd_cfgfile_init();
+
+  if (olsr_cnf->debug_level > 1) {
+    olsrd_print_cnf(olsr_cnf);
+  }
+
+  if (restart) {
+    reconfigure_restart(restart);
+  } else {
+    olsr_syslog(OLSR_LOG_INFO, "Configuration reloaded");
+  }
+}
+
+/**
+ * Perform a reload that was requested by olsr_reconfigure_request()
+ */
+void
+olsr_reconfigure_check(void)
+{
+  if (!reconfigure_pending) {
+    return;
+  }
+  reconfigure_pending = 0;
+
+  olsr_reconfigure();
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
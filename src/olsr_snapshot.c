@@ -0,0 +1,616 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#include "olsr_snapshot.h"
+#include "defs.h"
+#include "olsr.h"
+#include "scheduler.h"
+#include "link_set.h"
+#include "neighbor_table.h"
+#include "two_hop_neighbor_table.h"
+#include "mpr_selector_set.h"
+#include "tc_set.h"
+#include "routing_table.h"
+#include "hna_set.h"
+#include "mid_set.h"
+#include "interfaces.h"
+#include "common/string_handling.h"
+
+#include <stdlib.h>
+
+/* number of consumers that enabled the snapshot */
+static unsigned int snapshot_users = 0;
+
+/* version of the last published snapshot */
+static uint32_t snapshot_version = 0;
+
+/* currently published snapshot, swapped atomically */
+static struct olsr_snapshot *snapshot_current = NULL;
+
+/*
+ * number of readers between loading snapshot_current and taking their
+ * reference, retired snapshots must not be freed while it is not zero
+ */
+static uint32_t snapshot_acquiring = 0;
+
+/* replaced snapshots that are still referenced by readers */
+static struct olsr_snapshot *snapshot_retired = NULL;
+
+/* republishes the snapshot while the routing state is quiet */
+static struct timer_entry *snapshot_refresh_timer = NULL;
+static struct olsr_cookie_info *snapshot_timer_cookie = NULL;
+
+/* set by every publication, cleared by the refresh timer */
+static bool snapshot_fresh = false;
+
+static void *
+snapshot_alloc(uint32_t count, size_t size, const char *id)
+{
+  if (count == 0) {
+    return NULL;
+  }
+  return olsr_malloc(count * size, id);
+}
+
+static uint32_t
+snapshot_timer(const struct timer_entry *timer)
+{
+  return timer ? timer->timer_clock : 0;
+}
+
+static void
+snapshot_free(struct olsr_snapshot *snapshot)
+{
+  free(snapshot->links);
+  free(snapshot->neighbors);
+  free(snapshot->two_hop);
+  free(snapshot->tcs);
+  free(snapshot->edges);
+  free(snapshot->routes);
+  free(snapshot->hnas);
+  free(snapshot->mids);
+  free(snapshot->aliases);
+  free(snapshot);
+}
+
+static void
+snapshot_copy_links(struct olsr_snapshot *snapshot)
+{
+  struct link_entry *link;
+  uint32_t count = 0;
+
+  OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    count++;
+  } OLSR_FOR_ALL_LINK_ENTRIES_END(link);
+
+  snapshot->links = snapshot_alloc(count, sizeof(*snapshot->links), "snapshot links");
+
+  OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    struct olsr_snapshot_link *s = &snapshot->links[snapshot->link_count++];
+    struct lqtextbuffer lqbuffer;
+
+    s->local_iface_addr = link->local_iface_addr;
+    s->neighbor_iface_addr = link->neighbor_iface_addr;
+    if (link->inter && link->inter->int_name) {
+      strscpy(s->olsr_if_name, link->inter->int_name, sizeof(s->olsr_if_name));
+    }
+    if (link->if_name) {
+      strscpy(s->if_name, link->if_name, sizeof(s->if_name));
+    }
+    s->link_timer = snapshot_timer(link->link_timer);
+    s->link_sym_timer = snapshot_timer(link->link_sym_timer);
+    s->ASYM_time = link->ASYM_time;
+    s->vtime = link->vtime;
+    s->status = lookup_link_status(link);
+    s->prev_status = link->prev_status;
+    s->L_link_quality = link->L_link_quality;
+    s->L_link_pending = link->L_link_pending != 0;
+    s->L_LOST_LINK_time = link->L_LOST_LINK_time;
+    s->link_hello_timer = snapshot_timer(link->link_hello_timer);
+    s->last_htime = link->last_htime;
+    s->olsr_seqno_valid = link->olsr_seqno_valid;
+    s->olsr_seqno = link->olsr_seqno;
+    s->loss_helloint = link->loss_helloint;
+    s->link_loss_timer = snapshot_timer(link->link_loss_timer);
+    s->loss_link_multiplier = link->loss_link_multiplier;
+    s->linkcost = link->linkcost;
+    strscpy(s->lq.buf, get_link_entry_text(link, '\t', &lqbuffer), sizeof(s->lq.buf));
+  } OLSR_FOR_ALL_LINK_ENTRIES_END(link);
+}
+
+static void
+snapshot_copy_neighbors(struct olsr_snapshot *snapshot)
+{
+  struct neighbor_entry *neigh;
+  struct neighbor_2_list_entry *list_2;
+  uint32_t count = 0, two_hop = 0;
+
+  OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
+    count++;
+    for (list_2 = neigh->neighbor_2_list.next; list_2 != &neigh->neighbor_2_list; list_2 = list_2->next) {
+      if (list_2->neighbor_2) {
+        two_hop++;
+      }
+    }
+  } OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
+
+  snapshot->neighbors = snapshot_alloc(count, sizeof(*snapshot->neighbors), "snapshot neighbors");
+  snapshot->two_hop = snapshot_alloc(two_hop, sizeof(*snapshot->two_hop), "snapshot 2-hop neighbors");
+
+  OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
+    struct olsr_snapshot_neighbor *s = &snapshot->neighbors[snapshot->neighbor_count++];
+
+    s->neighbor_main_addr = neigh->neighbor_main_addr;
+    s->status = neigh->status;
+    s->willingness = neigh->willingness;
+    s->is_mpr = neigh->is_mpr;
+    s->was_mpr = neigh->was_mpr;
+    s->is_mpr_selector = olsr_lookup_mprs_set(&neigh->neighbor_main_addr) != NULL;
+    s->skip = neigh->skip;
+    s->neighbor_2_nocov = neigh->neighbor_2_nocov;
+    s->linkcount = neigh->linkcount;
+
+    s->two_hop_first = snapshot->two_hop_count;
+    for (list_2 = neigh->neighbor_2_list.next; list_2 != &neigh->neighbor_2_list; list_2 = list_2->next) {
+      if (list_2->neighbor_2) {
+        snapshot->two_hop[snapshot->two_hop_count++] = list_2->neighbor_2->neighbor_2_addr;
+      }
+    }
+    s->two_hop_count = snapshot->two_hop_count - s->two_hop_first;
+  } OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
+}
+
+static void
+snapshot_copy_topology(struct olsr_snapshot *snapshot)
+{
+  struct tc_entry *tc;
+  struct tc_edge_entry *tc_edge;
+  uint32_t count = 0, edges = 0;
+
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    count++;
+    OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
+      if (tc_edge->edge_inv) {
+        edges++;
+      }
+    } OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
+  } OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+
+  snapshot->tcs = snapshot_alloc(count, sizeof(*snapshot->tcs), "snapshot tc entries");
+  snapshot->edges = snapshot_alloc(edges, sizeof(*snapshot->edges), "snapshot tc edges");
+
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    struct olsr_snapshot_tc *s = &snapshot->tcs[snapshot->tc_count++];
+
+    s->addr = tc->addr;
+    s->path_cost = tc->path_cost;
+    s->validity_timer = snapshot_timer(tc->validity_timer);
+    s->refcount = tc->refcount;
+    s->msg_seq = tc->msg_seq;
+    s->msg_hops = tc->msg_hops;
+    s->hops = tc->hops;
+    s->ansn = tc->ansn;
+    s->ignored = tc->ignored;
+    s->err_seq = tc->err_seq;
+    s->err_seq_valid = tc->err_seq_valid;
+
+    s->edge_first = snapshot->edge_count;
+    OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
+      if (tc_edge->edge_inv) {
+        struct olsr_snapshot_edge *e = &snapshot->edges[snapshot->edge_count++];
+        struct lqtextbuffer lqbuffer;
+
+        e->T_dest_addr = tc_edge->T_dest_addr;
+        e->cost = tc_edge->cost;
+        e->ansn = tc_edge->ansn;
+        strscpy(e->lq.buf, get_tc_edge_entry_text(tc_edge, '\t', &lqbuffer), sizeof(e->lq.buf));
+      }
+    } OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
+    s->edge_count = snapshot->edge_count - s->edge_first;
+  } OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+}
+
+static void
+snapshot_copy_routes(struct olsr_snapshot *snapshot)
+{
+  struct rt_entry *rt;
+  uint32_t count = 0;
+
+  OLSR_FOR_ALL_RT_ENTRIES(rt) {
+    if (rt->rt_best) {
+      count++;
+    }
+  } OLSR_FOR_ALL_RT_ENTRIES_END(rt);
+
+  snapshot->routes = snapshot_alloc(count, sizeof(*snapshot->routes), "snapshot routes");
+
+  OLSR_FOR_ALL_RT_ENTRIES(rt) {
+    if (rt->rt_best) {
+      struct olsr_snapshot_route *s = &snapshot->routes[snapshot->route_count++];
+      const char *if_name = if_ifwithindex_name(rt->rt_best->rtp_nexthop.iif_index);
+
+      s->rt_dst = rt->rt_dst;
+      s->gateway = rt->rt_best->rtp_nexthop.gateway;
+      s->iif_index = rt->rt_best->rtp_nexthop.iif_index;
+      if (if_name) {
+        strscpy(s->if_name, if_name, sizeof(s->if_name));
+      }
+      s->cost = rt->rt_best->rtp_metric.cost;
+      s->hops = rt->rt_best->rtp_metric.hops;
+    }
+  } OLSR_FOR_ALL_RT_ENTRIES_END(rt);
+}
+
+static void
+snapshot_copy_hna(struct olsr_snapshot *snapshot)
+{
+  struct ip_prefix_list *local;
+  struct hna_entry *hna;
+  struct hna_net *net;
+  uint32_t count = 0;
+
+  for (local = olsr_cnf->hna_entries; local != NULL; local = local->next) {
+    count++;
+  }
+  OLSR_FOR_ALL_HNA_ENTRIES(hna) {
+    for (net = hna->networks.next; net != &hna->networks; net = net->next) {
+      count++;
+    }
+  } OLSR_FOR_ALL_HNA_ENTRIES_END(hna);
+
+  snapshot->hnas = snapshot_alloc(count, sizeof(*snapshot->hnas), "snapshot hna");
+
+  for (local = olsr_cnf->hna_entries; local != NULL; local = local->next) {
+    struct olsr_snapshot_hna *s = &snapshot->hnas[snapshot->hna_count++];
+
+    s->gateway = olsr_cnf->main_addr;
+    s->net = local->net;
+  }
+  OLSR_FOR_ALL_HNA_ENTRIES(hna) {
+    for (net = hna->networks.next; net != &hna->networks; net = net->next) {
+      struct olsr_snapshot_hna *s = &snapshot->hnas[snapshot->hna_count++];
+
+      s->gateway = hna->A_gateway_addr;
+      s->net = net->hna_prefix;
+      s->hna_net_timer = snapshot_timer(net->hna_net_timer);
+    }
+  } OLSR_FOR_ALL_HNA_ENTRIES_END(hna);
+}
+
+static void
+snapshot_copy_mid(struct olsr_snapshot *snapshot)
+{
+  struct mid_entry *entry;
+  struct mid_address *alias;
+  uint32_t count = 0, aliases = 0;
+  int idx;
+
+  for (idx = 0; idx < HASHSIZE; idx++) {
+    for (entry = mid_set[idx].next; entry != &mid_set[idx]; entry = entry->next) {
+      count++;
+      for (alias = entry->aliases; alias; alias = alias->next_alias) {
+        aliases++;
+      }
+    }
+  }
+
+  snapshot->mids = snapshot_alloc(count, sizeof(*snapshot->mids), "snapshot mid");
+  snapshot->aliases = snapshot_alloc(aliases, sizeof(*snapshot->aliases), "snapshot mid aliases");
+
+  for (idx = 0; idx < HASHSIZE; idx++) {
+    for (entry = mid_set[idx].next; entry != &mid_set[idx]; entry = entry->next) {
+      struct olsr_snapshot_mid *s = &snapshot->mids[snapshot->mid_count++];
+
+      s->main_addr = entry->main_addr;
+      s->mid_timer = snapshot_timer(entry->mid_timer);
+
+      s->alias_first = snapshot->alias_count;
+      for (alias = entry->aliases; alias; alias = alias->next_alias) {
+        struct olsr_snapshot_alias *a = &snapshot->aliases[snapshot->alias_count++];
+
+        a->alias = alias->alias;
+        a->vtime = alias->vtime;
+      }
+      s->alias_count = snapshot->alias_count - s->alias_first;
+    }
+  }
+}
+
+/**
+ * Free all retired snapshots that are not referenced anymore.
+ */
+static void
+snapshot_collect(void)
+{
+  struct olsr_snapshot **ptr = &snapshot_retired;
+
+  /*
+   * A reader that loaded a retired pointer has not necessarily taken
+   * its reference yet, so nothing can be freed while a reader is
+   * between both steps. Readers that start later see the new pointer.
+   */
+  if (__atomic_load_n(&snapshot_acquiring, __ATOMIC_SEQ_CST) != 0) {
+    return;
+  }
+
+  while (*ptr) {
+    struct olsr_snapshot *snapshot = *ptr;
+
+    if (__atomic_load_n(&snapshot->refcount, __ATOMIC_SEQ_CST) == 0) {
+      *ptr = snapshot->next_retired;
+      snapshot_free(snapshot);
+    } else {
+      ptr = &snapshot->next_retired;
+    }
+  }
+}
+
+/**
+ * Replace the current snapshot and retire the old one.
+ *
+ * @param snapshot new snapshot, may be NULL
+ */
+static void
+snapshot_replace(struct olsr_snapshot *snapshot)
+{
+  struct olsr_snapshot *old;
+
+  old = __atomic_exchange_n(&snapshot_current, snapshot, __ATOMIC_SEQ_CST);
+  if (old) {
+    /* drop the reference of the publisher */
+    __atomic_sub_fetch(&old->refcount, 1, __ATOMIC_SEQ_CST);
+    old->next_retired = snapshot_retired;
+    snapshot_retired = old;
+  }
+
+  snapshot_collect();
+}
+
+/**
+ * Copy the live routing state into a new snapshot.
+ *
+ * @return snapshot with a single reference
+ */
+static struct olsr_snapshot *
+snapshot_build(unsigned int sections)
+{
+  struct olsr_snapshot *snapshot;
+
+  snapshot = olsr_malloc(sizeof(*snapshot), "snapshot");
+  snapshot->refcount = 1;
+  snapshot->timestamp = now_times;
+
+  olsr_snapshot_add(snapshot, sections);
+  return snapshot;
+}
+
+/**
+ * Periodic timer callback. Link qualities and timers change without
+ * triggering olsr_process_changes(), so republish the snapshot if
+ * nothing else did during the last interval.
+ *
+ * @param context unused
+ */
+static void
+snapshot_refresh(void *context __attribute__ ((unused)))
+{
+  if (!snapshot_fresh) {
+    olsr_snapshot_publish();
+  }
+  snapshot_fresh = false;
+}
+
+/**
+ * Build a new snapshot of the routing state and publish it, if at
+ * least one consumer has enabled snapshots. Also frees retired
+ * snapshots that are not used anymore.
+ */
+void
+olsr_snapshot_publish(void)
+{
+  struct olsr_snapshot *snapshot;
+
+  if (snapshot_users == 0) {
+    return;
+  }
+
+  snapshot = snapshot_build(OLSR_SNAPSHOT_ALL);
+  snapshot->version = ++snapshot_version;
+
+  snapshot_replace(snapshot);
+  snapshot_fresh = true;
+
+  OLSR_PRINTF(3, "Published snapshot %u (%u links, %u tc, %u routes)\n",
+      snapshot->version, snapshot->link_count, snapshot->tc_count, snapshot->route_count);
+}
+
+/**
+ * Create a private snapshot of the current routing state, for main
+ * thread consumers that want to share code with snapshot readers.
+ * It is not published and must be freed with olsr_snapshot_destroy().
+ *
+ * @param sections OLSR_SNAPSHOT_* parts to copy
+ * @return new snapshot
+ */
+struct olsr_snapshot *
+olsr_snapshot_create(unsigned int sections)
+{
+  return snapshot_build(sections);
+}
+
+/**
+ * Copy more parts of the current routing state into a snapshot that is
+ * being built or into a private one. Parts it already has are kept.
+ *
+ * @param snapshot snapshot that is not published yet, or a private one
+ * @param sections OLSR_SNAPSHOT_* parts to copy
+ */
+void
+olsr_snapshot_add(struct olsr_snapshot *snapshot, unsigned int sections)
+{
+  sections &= ~snapshot->sections;
+
+  if (sections & OLSR_SNAPSHOT_LINKS) {
+    snapshot_copy_links(snapshot);
+  }
+  if (sections & OLSR_SNAPSHOT_NEIGHBORS) {
+    snapshot_copy_neighbors(snapshot);
+  }
+  if (sections & OLSR_SNAPSHOT_TOPOLOGY) {
+    snapshot_copy_topology(snapshot);
+  }
+  if (sections & OLSR_SNAPSHOT_ROUTES) {
+    snapshot_copy_routes(snapshot);
+  }
+  if (sections & OLSR_SNAPSHOT_HNA) {
+    snapshot_copy_hna(snapshot);
+  }
+  if (sections & OLSR_SNAPSHOT_MID) {
+    snapshot_copy_mid(snapshot);
+  }
+  snapshot->sections |= sections;
+}
+
+/**
+ * Free a snapshot created by olsr_snapshot_create().
+ *
+ * @param snapshot private snapshot, may be NULL
+ */
+void
+olsr_snapshot_destroy(struct olsr_snapshot *snapshot)
+{
+  if (snapshot) {
+    snapshot_free(snapshot);
+  }
+}
+
+/**
+ * Register a consumer of snapshots. The first consumer triggers an
+ * immediate snapshot, so olsr_snapshot_acquire() does not return NULL,
+ * and starts the refresh timer.
+ */
+void
+olsr_snapshot_enable(void)
+{
+  if (snapshot_users++ == 0) {
+    if (!snapshot_timer_cookie) {
+      snapshot_timer_cookie = olsr_alloc_cookie("Snapshot refresh", OLSR_COOKIE_TYPE_TIMER);
+    }
+    snapshot_refresh_timer = olsr_start_timer(SNAPSHOT_REFRESH_INTERVAL, 0, OLSR_TIMER_PERIODIC,
+        &snapshot_refresh, NULL, snapshot_timer_cookie);
+    olsr_snapshot_publish();
+  }
+}
+
+/**
+ * Unregister a consumer of snapshots. The current snapshot is withdrawn
+ * when the last consumer is gone.
+ */
+void
+olsr_snapshot_disable(void)
+{
+  if (snapshot_users == 0) {
+    return;
+  }
+  if (--snapshot_users == 0) {
+    olsr_stop_timer(snapshot_refresh_timer);
+    snapshot_refresh_timer = NULL;
+    snapshot_replace(NULL);
+  }
+}
+
+/**
+ * Withdraw the current snapshot and free all unreferenced snapshots.
+ * Must be called after all reader threads have been stopped.
+ */
+void
+olsr_snapshot_cleanup(void)
+{
+  snapshot_users = 0;
+  olsr_stop_timer(snapshot_refresh_timer);
+  snapshot_refresh_timer = NULL;
+  snapshot_replace(NULL);
+}
+
+/**
+ * Get a reference to the current snapshot. Can be called from any thread.
+ *
+ * @return current snapshot or NULL if none has been published,
+ *   must be released with olsr_snapshot_release()
+ */
+struct olsr_snapshot *
+olsr_snapshot_acquire(void)
+{
+  struct olsr_snapshot *snapshot;
+
+  __atomic_add_fetch(&snapshot_acquiring, 1, __ATOMIC_SEQ_CST);
+  snapshot = __atomic_load_n(&snapshot_current, __ATOMIC_SEQ_CST);
+  if (snapshot) {
+    __atomic_add_fetch(&snapshot->refcount, 1, __ATOMIC_SEQ_CST);
+  }
+  __atomic_sub_fetch(&snapshot_acquiring, 1, __ATOMIC_SEQ_CST);
+  return snapshot;
+}
+
+/**
+ * Drop a reference to a snapshot. Can be called from any thread,
+ * the memory itself is freed by the main thread.
+ *
+ * @param snapshot snapshot returned by olsr_snapshot_acquire(), may be NULL
+ */
+void
+olsr_snapshot_release(struct olsr_snapshot *snapshot)
+{
+  if (snapshot) {
+    __atomic_sub_fetch(&snapshot->refcount, 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,229 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+#ifndef OLSR_SNAPSHOT_H_
+#define OLSR_SNAPSHOT_H_
+
+#include "olsr_types.h"
+#include "lq_plugin.h"
+
+#include <net/if.h>
+
+/*
+ * Immutable copy of the routing state (links, neighbors, topology,
+ * routes, HNA and MID), published after olsr_process_changes() and at
+ * least every SNAPSHOT_REFRESH_INTERVAL, so link qualities and expiring
+ * entries show up even if the topology does not change.
+ *
+ * A snapshot is only built while at least one consumer has enabled it.
+ * Readers acquire the current snapshot, use it without any lock (it is
+ * never modified after publication) and release it afterwards. Acquire
+ * and release are lock-free and may be called from any thread, all
+ * other functions must be called from the main thread. Snapshots are
+ * freed on the main thread once no reader references them anymore.
+ *
+ * Timer values are absolute (timer_clock), readers compute the remaining
+ * time with olsr_getTimeLeft(), they may already have expired. Link costs are unscaled olsr_linkcost values.
+ */
+
+/* maximum age of the published snapshot in milliseconds */
+#define SNAPSHOT_REFRESH_INTERVAL 1000
+
+/* parts of the routing state, private snapshots may hold only some */
+#define OLSR_SNAPSHOT_LINKS       0x01
+#define OLSR_SNAPSHOT_NEIGHBORS   0x02    /* with the 2-hop neighbors */
+#define OLSR_SNAPSHOT_TOPOLOGY    0x04
+#define OLSR_SNAPSHOT_ROUTES      0x08
+#define OLSR_SNAPSHOT_HNA         0x10
+#define OLSR_SNAPSHOT_MID         0x20
+#define OLSR_SNAPSHOT_ALL         0x3f
+
+struct olsr_snapshot_link {
+  union olsr_ip_addr local_iface_addr;
+  union olsr_ip_addr neighbor_iface_addr;
+  char olsr_if_name[IFNAMSIZ];
+  char if_name[IFNAMSIZ];
+  uint32_t link_timer;
+  uint32_t link_sym_timer;
+  uint32_t ASYM_time;
+  olsr_reltime vtime;
+  uint8_t status;
+  uint8_t prev_status;
+  float L_link_quality;
+  bool L_link_pending;
+  uint32_t L_LOST_LINK_time;
+  uint32_t link_hello_timer;
+  olsr_reltime last_htime;
+  bool olsr_seqno_valid;
+  uint16_t olsr_seqno;
+  olsr_reltime loss_helloint;
+  uint32_t link_loss_timer;
+  uint32_t loss_link_multiplier;
+  olsr_linkcost linkcost;
+  struct lqtextbuffer lq;   /* "<lq>\t<nlq>" */
+};
+
+struct olsr_snapshot_neighbor {
+  union olsr_ip_addr neighbor_main_addr;
+  uint8_t status;
+  uint8_t willingness;
+  bool is_mpr;
+  bool was_mpr;
+  bool is_mpr_selector;
+  bool skip;
+  int neighbor_2_nocov;
+  int linkcount;
+
+  /* slice of olsr_snapshot->two_hop */
+  uint32_t two_hop_first;
+  uint32_t two_hop_count;
+};
+
+struct olsr_snapshot_tc {
+  union olsr_ip_addr addr;
+  olsr_linkcost path_cost;
+  uint32_t validity_timer;
+  uint32_t refcount;
+  uint16_t msg_seq;
+  uint8_t msg_hops;
+  uint8_t hops;
+  uint16_t ansn;
+  uint16_t ignored;
+  uint16_t err_seq;
+  bool err_seq_valid;
+
+  /* slice of olsr_snapshot->edges */
+  uint32_t edge_first;
+  uint32_t edge_count;
+};
+
+/* only edges with a known inverse edge are part of the snapshot */
+struct olsr_snapshot_edge {
+  union olsr_ip_addr T_dest_addr;
+  olsr_linkcost cost;
+  uint16_t ansn;
+  struct lqtextbuffer lq;   /* "<lq>\t<nlq>" */
+};
+
+/* only routes with a best path are part of the snapshot */
+struct olsr_snapshot_route {
+  struct olsr_ip_prefix rt_dst;
+  union olsr_ip_addr gateway;
+  int iif_index;
+  char if_name[IFNAMSIZ];
+  olsr_linkcost cost;
+  uint32_t hops;
+};
+
+struct olsr_snapshot_hna {
+  union olsr_ip_addr gateway;
+  struct olsr_ip_prefix net;
+  uint32_t hna_net_timer;   /* 0 for our own announcements */
+};
+
+struct olsr_snapshot_mid {
+  union olsr_ip_addr main_addr;
+  uint32_t mid_timer;
+
+  /* slice of olsr_snapshot->aliases */
+  uint32_t alias_first;
+  uint32_t alias_count;
+};
+
+struct olsr_snapshot_alias {
+  union olsr_ip_addr alias;
+  uint32_t vtime;
+};
+
+struct olsr_snapshot {
+  /* references held by readers and by the publisher */
+  uint32_t refcount;
+
+  /* incremented for every published snapshot, 0 for private ones */
+  uint32_t version;
+
+  /* now_times at the time of publication */
+  uint32_t timestamp;
+
+  /* OLSR_SNAPSHOT_* parts that were copied, all for published ones */
+  unsigned int sections;
+
+  struct olsr_snapshot *next_retired;
+
+  uint32_t link_count, neighbor_count, two_hop_count, tc_count, edge_count;
+  uint32_t route_count, hna_count, mid_count, alias_count;
+
+  struct olsr_snapshot_link *links;
+  struct olsr_snapshot_neighbor *neighbors;
+  union olsr_ip_addr *two_hop;
+  struct olsr_snapshot_tc *tcs;
+  struct olsr_snapshot_edge *edges;
+  struct olsr_snapshot_route *routes;
+  struct olsr_snapshot_hna *hnas;
+  struct olsr_snapshot_mid *mids;
+  struct olsr_snapshot_alias *aliases;
+};
+
+/* main thread */
+void olsr_snapshot_enable(void);
+void olsr_snapshot_disable(void);
+void olsr_snapshot_publish(void);
+void olsr_snapshot_cleanup(void);
+struct olsr_snapshot *olsr_snapshot_create(unsigned int sections);
+void olsr_snapshot_add(struct olsr_snapshot *snapshot, unsigned int sections);
+void olsr_snapshot_destroy(struct olsr_snapshot *snapshot);
+
+/* any thread */
+struct olsr_snapshot *olsr_snapshot_acquire(void);
+void olsr_snapshot_release(struct olsr_snapshot *snapshot);
+
+#endif /* OLSR_SNAPSHOT_H_ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -72,6 +72,7 @@
 #include "net_olsr.h"
 #include "lq_plugin.h"
 #include "gateway.h"
+#include "olsr_metrics.h"
 
 #ifdef SPF_PROFILING
 #include <time.h>
@@ -308,6 +309,80 @@ olsr_spf_run_full(struct avl_tree *cand_tree, struct list_node *path_list, int *
   }
 }
 
+/*
+ * Check if relaxing the edge from tc to dest with the given cost could
+ * change the result of the last SPF run. That is the case if the path
+ * over the edge is at most as expensive as the path SPF found to dest.
+ * Ties count, because they decide about the next hop.
+ */
+static bool
+olsr_spf_edge_relevant(const struct tc_entry *tc, const struct tc_entry *dest, olsr_linkcost cost)
+{
+  if (tc->path_cost >= ROUTE_COST_BROKEN || cost >= LINK_COST_BROKEN) {
+    return false;
+  }
+  return tc->path_cost + cost <= dest->path_cost;
+}
+
+/**
+ * Check if the TC edges that changed since the last SPF run can change
+ * its result.
+ *
+ * An edge that was not part of any shortest path before the change
+ * and is not cheaper than the known paths after the change leaves all
+ * shortest paths as they are. This covers the edge itself and its
+ * inverse edge, which SPF only uses while both exist.
+ *
+ * @return true if SPF has to run
+ */
+bool
+olsr_spf_tc_edge_changes_relevant(void)
+{
+  const struct tc_edge_change *changes;
+  unsigned int count, i;
+
+  changes = olsr_get_tc_edge_changes(&count);
+  if (count == 0) {
+    return false;
+  }
+
+  /* no SPF result to compare with */
+  if (!tc_myself || tc_myself->path_cost != ZERO_ROUTE_COST) {
+    return true;
+  }
+
+  for (i = 0; i < count; i++) {
+    union olsr_ip_addr originator = changes[i].originator, dest_addr = changes[i].dest;
+    struct tc_entry *tc, *dest;
+    struct tc_edge_entry *tc_edge, *tc_edge_inv;
+
+    tc = olsr_lookup_tc_entry(&originator);
+    dest = olsr_lookup_tc_entry(&dest_addr);
+    if (!tc || !dest) {
+      return true;
+    }
+
+    tc_edge = olsr_lookup_tc_edge(tc, &dest_addr);
+    tc_edge_inv = olsr_lookup_tc_edge(dest, &originator);
+
+    /* the edge before the change */
+    if (olsr_spf_edge_relevant(tc, dest, changes[i].old_cost)) {
+      return true;
+    }
+
+    /* the edge after the change */
+    if (tc_edge && tc_edge_inv && olsr_spf_edge_relevant(tc, dest, tc_edge->cost)) {
+      return true;
+    }
+
+    /* the inverse edge was enabled or disabled by the change */
+    if (changes[i].type != TC_EDGE_CHANGED && tc_edge_inv && olsr_spf_edge_relevant(dest, tc, tc_edge_inv->cost)) {
+      return true;
+    }
+  }
+  return false;
+}
+
 /**
  * Callback for the SPF backoff timer.
  */
@@ -317,6 +392,43 @@ olsr_expire_spf_backoff(void *context __attribute__ ((unused)))
   spf_backoff_timer = NULL;
 }
 
+enum spf_phase {
+  SPF_PHASE_INIT,
+  SPF_PHASE_DIJKSTRA,
+  SPF_PHASE_RIB,
+  SPF_PHASE_KERNEL,
+  SPF_PHASES
+};
+
+static const char *const spf_phase_names[SPF_PHASES] = { "init", "dijkstra", "rib", "kernel" };
+
+static struct olsr_metric *spf_phase_metrics[SPF_PHASES];
+
+/**
+ * Record the latency of a phase of the route calculation.
+ *
+ * @param phase the phase that ends now
+ * @param start the start of the phase, 0 when metrics are disabled
+ * @return the start of the next phase
+ */
+static uint64_t
+olsr_spf_phase_done(enum spf_phase phase, uint64_t start)
+{
+  uint64_t now;
+
+  if (!start) {
+    return 0;
+  }
+  if (!spf_phase_metrics[phase]) {
+    spf_phase_metrics[phase] = olsr_metric_get(OLSR_METRIC_LATENCY, "route_calculation",
+        "Phases of the calculation of the routing table", "phase", spf_phase_names[phase]);
+  }
+
+  now = olsr_metrics_clock();
+  olsr_metric_record(spf_phase_metrics[phase], now - start);
+  return now;
+}
+
 #ifdef SPF_PROFILING
 static void timer_sub(struct timespec * end, struct timespec * start, struct timespec * t) {
   t->tv_sec = end->tv_sec - start->tv_sec;
@@ -344,6 +456,7 @@ olsr_calculate_routing_table(bool force)
   struct neighbor_entry *neigh;
   struct link_entry *link;
   int path_count = 0;
+  uint64_t phase_start;
 
   /* We are done if our backoff timer is running */
   if (!force) {
@@ -355,9 +468,13 @@ olsr_calculate_routing_table(bool force)
     spf_backoff_timer = olsr_start_timer(1000, 5, OLSR_TIMER_ONESHOT, &olsr_expire_spf_backoff, NULL, 0);
   }
 
+  /* this run consumes all recorded edge changes */
+  olsr_clear_tc_edge_changes();
+
 #ifdef SPF_PROFILING
   clock_gettime(CLOCK_MONOTONIC, &t1);
 #endif /* SPF_PROFILING */
+  phase_start = olsr_metrics_start();
 
   /*
    * Prepare the candidate tree and result list.
@@ -453,6 +570,7 @@ olsr_calculate_routing_table(bool force)
 #ifdef SPF_PROFILING
   clock_gettime(CLOCK_MONOTONIC, &t2);
 #endif /* SPF_PROFILING */
+  phase_start = olsr_spf_phase_done(SPF_PHASE_INIT, phase_start);
 
   /*
    * Run the SPF calculation.
@@ -464,6 +582,7 @@ olsr_calculate_routing_table(bool force)
 #ifdef SPF_PROFILING
   clock_gettime(CLOCK_MONOTONIC, &t3);
 #endif /* SPF_PROFILING */
+  phase_start = olsr_spf_phase_done(SPF_PHASE_DIJKSTRA, phase_start);
 
   /*
    * In the path list we have all the reachable nodes in our topology.
@@ -526,6 +645,7 @@ olsr_calculate_routing_table(bool force)
 #ifdef SPF_PROFILING
   clock_gettime(CLOCK_MONOTONIC, &t4);
 #endif /* SPF_PROFILING */
+  phase_start = olsr_spf_phase_done(SPF_PHASE_RIB, phase_start);
 
   /* move the route changes into the kernel */
 
@@ -534,6 +654,7 @@ olsr_calculate_routing_table(bool force)
 #ifdef SPF_PROFILING
   clock_gettime(CLOCK_MONOTONIC, &t5);
 #endif /* SPF_PROFILING */
+  olsr_spf_phase_done(SPF_PHASE_KERNEL, phase_start);
 
 #ifdef SPF_PROFILING
   timer_sub(&t2, &t1, &spf_init);
@@ -47,6 +47,7 @@
 #define _OLSR_SPF_H
 
 void olsr_calculate_routing_table(bool force);
+bool olsr_spf_tc_edge_changes_relevant(void);
 
 #endif /* _OLSR_SPF_H */
 
@@ -0,0 +1,759 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#include "olsr_state.h"
+#include "defs.h"
+#include "olsr.h"
+#include "log.h"
+#include "ipcalc.h"
+#include "scheduler.h"
+#include "olsr_cookie.h"
+#include "tc_set.h"
+#include "mid_set.h"
+#include "hna_set.h"
+#include "duplicate_set.h"
+#include "mpr_selector_set.h"
+#include "routing_table.h"
+#include "interfaces.h"
+#include "lq_plugin.h"
+#include "common/string_handling.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <net/if.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif /* _WIN32 */
+
+#ifndef O_BINARY
+#define O_BINARY 0
+#endif /* O_BINARY */
+
+#define STATE_MAGIC             0x4f4c5354      /* "OLST" */
+#define STATE_VERSION           2
+
+/* maximum size of the TC link quality in message format */
+#define STATE_LQ_MAX            64
+
+/* jump over sequence numbers we may have used after the last checkpoint */
+#define STATE_SEQNO_MARGIN      1024
+#define STATE_ANSN_MARGIN       16
+
+#define STATE_TIMER_JITTER      5       /* percent */
+
+enum state_section {
+  STATE_TC,
+  STATE_EDGE,
+  STATE_MID,
+  STATE_HNA,
+  STATE_DUP,
+  STATE_ROUTE,
+  STATE_SECTIONS
+};
+
+/*
+ * On-disk format: a header followed by one array of fixed size records
+ * per section. All records are naturally aligned, so the file can be
+ * used directly from a mapping. Validity times are the remaining time
+ * in milliseconds at the moment the checkpoint was taken. The edge
+ * records end with the link quality in TC message format, their size
+ * depends on the link quality plugin.
+ */
+struct state_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;                       /* size of the whole file */
+  uint32_t checksum;                   /* of everything behind the header */
+  uint32_t saved_sec;                  /* wall clock time of the checkpoint */
+  uint32_t saved_msec;
+  union olsr_ip_addr main_addr;
+  char lq_algorithm[32];
+  uint32_t count[STATE_SECTIONS];
+  uint32_t offset[STATE_SECTIONS];
+  uint16_t msg_seqno;
+  uint16_t ansn;
+  uint8_t ip_version;                  /* 4 or 6 */
+  uint8_t lq_level;
+  uint8_t record_size[STATE_SECTIONS];
+};
+
+struct state_tc {
+  union olsr_ip_addr addr;
+  uint32_t vtime;
+  uint32_t edge_first;
+  uint32_t edge_count;
+  uint16_t msg_seq;
+  uint16_t ansn;
+  uint8_t msg_hops;
+  uint8_t pad[3];
+};
+
+struct state_edge {
+  union olsr_ip_addr addr;
+  uint16_t ansn;
+  uint8_t lq_len;
+  uint8_t pad;
+  uint8_t lq[0];
+};
+
+struct state_mid {
+  union olsr_ip_addr main_addr;
+  union olsr_ip_addr alias;
+  uint32_t vtime;
+};
+
+struct state_hna {
+  union olsr_ip_addr gateway;
+  union olsr_ip_addr net;
+  uint32_t vtime;
+  uint8_t prefix_len;
+  uint8_t pad[3];
+};
+
+struct state_dup {
+  union olsr_ip_addr ip;
+  uint32_t array;
+  uint32_t vtime;
+  uint16_t seqnr;
+  uint16_t too_low_counter;
+};
+
+struct state_route {
+  union olsr_ip_addr dst;
+  union olsr_ip_addr gateway;
+  char if_name[IFNAMSIZ];
+  uint32_t cost;
+  uint32_t hops;
+  uint8_t prefix_len;
+  uint8_t pad[3];
+};
+
+static const size_t state_fixed_record_size[STATE_SECTIONS] = {
+  sizeof(struct state_tc),
+  0,
+  sizeof(struct state_mid),
+  sizeof(struct state_hna),
+  sizeof(struct state_dup),
+  sizeof(struct state_route)
+};
+
+static struct timer_entry *state_save_timer = NULL;
+static struct olsr_cookie_info *state_timer_cookie = NULL;
+
+/* FNV-1a, only used to detect truncated or damaged files */
+static uint32_t
+state_checksum(const uint8_t *data, size_t len)
+{
+  uint32_t hash = 2166136261u;
+
+  while (len--) {
+    hash ^= *data++;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t
+state_remaining(const struct timer_entry *timer)
+{
+  int32_t due;
+
+  if (timer == NULL) {
+    return 0;
+  }
+  due = olsr_getTimeDue(timer->timer_clock);
+  return due > 0 ? (uint32_t)due : 0;
+}
+
+/* @return the size of the records of a section, 0 if the link quality does not fit */
+static size_t
+state_record_size(int section)
+{
+  size_t lq_size;
+
+  if (section != STATE_EDGE) {
+    return state_fixed_record_size[section];
+  }
+  lq_size = olsr_sizeof_tc_lqdata();
+  if (lq_size > STATE_LQ_MAX) {
+    return 0;
+  }
+  return sizeof(struct state_edge) + ((lq_size + 3) & ~(size_t)3);
+}
+
+static const char *
+state_lq_algorithm(void)
+{
+  return olsr_cnf->lq_algorithm ? olsr_cnf->lq_algorithm : DEF_LQ_ALGORITHM;
+}
+
+static void
+state_count(uint32_t *count)
+{
+  struct tc_entry *tc;
+  struct hna_entry *hna;
+  struct rt_entry *rt;
+  int idx;
+
+  memset(count, 0, sizeof(uint32_t) * STATE_SECTIONS);
+
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    if (tc == tc_myself || tc->validity_timer == NULL) {
+      continue;
+    }
+    count[STATE_TC]++;
+    count[STATE_EDGE] += tc->edge_tree.count;
+  } OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+
+  for (idx = 0; idx < HASHSIZE; idx++) {
+    struct mid_entry *entry;
+    struct mid_address *alias;
+
+    for (entry = mid_set[idx].next; entry != &mid_set[idx]; entry = entry->next) {
+      for (alias = entry->aliases; alias; alias = alias->next_alias) {
+        count[STATE_MID]++;
+      }
+    }
+  }
+
+  OLSR_FOR_ALL_HNA_ENTRIES(hna) {
+    struct hna_net *net;
+
+    for (net = hna->networks.next; net != &hna->networks; net = net->next) {
+      count[STATE_HNA]++;
+    }
+  } OLSR_FOR_ALL_HNA_ENTRIES_END(hna);
+
+  count[STATE_DUP] = duplicate_set.count;
+
+  OLSR_FOR_ALL_RT_ENTRIES(rt) {
+    if (rt->rt_nexthop.iif_index > -1) {
+      count[STATE_ROUTE]++;
+    }
+  } OLSR_FOR_ALL_RT_ENTRIES_END(rt);
+
+  count[STATE_ROUTE] += held_routingtree.count;
+}
+
+static void
+state_fill_route(struct state_route *r, const struct rt_entry *rt)
+{
+  r->dst = rt->rt_dst.prefix;
+  r->prefix_len = rt->rt_dst.prefix_len;
+  r->gateway = rt->rt_nexthop.gateway;
+  strscpy(r->if_name, if_ifwithindex_name(rt->rt_nexthop.iif_index), sizeof(r->if_name));
+  r->cost = rt->rt_metric.cost;
+  r->hops = rt->rt_metric.hops;
+}
+
+/* @return false if the link quality of an edge does not fit into its record */
+static bool
+state_fill(uint8_t *buf, const struct state_header *hdr)
+{
+  struct state_tc *tcs = (struct state_tc *)(buf + hdr->offset[STATE_TC]);
+  uint8_t *edges = buf + hdr->offset[STATE_EDGE];
+  size_t lq_space = hdr->record_size[STATE_EDGE] - sizeof(struct state_edge);
+  struct state_mid *mids = (struct state_mid *)(buf + hdr->offset[STATE_MID]);
+  struct state_hna *hnas = (struct state_hna *)(buf + hdr->offset[STATE_HNA]);
+  struct state_dup *dups = (struct state_dup *)(buf + hdr->offset[STATE_DUP]);
+  struct state_route *routes = (struct state_route *)(buf + hdr->offset[STATE_ROUTE]);
+  uint32_t edge_count = 0;
+  struct tc_entry *tc;
+  struct tc_edge_entry *tc_edge;
+  struct hna_entry *hna;
+  struct dup_entry *dup;
+  struct rt_entry *rt;
+  struct avl_node *node;
+  int idx;
+
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    if (tc == tc_myself || tc->validity_timer == NULL) {
+      continue;
+    }
+    tcs->addr = tc->addr;
+    tcs->vtime = state_remaining(tc->validity_timer);
+    tcs->msg_seq = tc->msg_seq;
+    tcs->ansn = tc->ansn;
+    tcs->msg_hops = tc->msg_hops;
+    tcs->edge_first = edge_count;
+
+    OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
+      struct state_edge *edge = (struct state_edge *)edges;
+      uint8_t lq[STATE_LQ_MAX];
+      int len;
+
+      edge->addr = tc_edge->T_dest_addr;
+      edge->ansn = tc_edge->ansn;
+      len = olsr_serialize_tc_edge_lq(lq, tc_edge);
+      if (len < 0 || (size_t)len > lq_space) {
+        OLSR_PRINTF(1, "State: the link quality of %s takes %d bytes, not %u\n",
+                    olsr_tc_edge_to_string(tc_edge), len, (unsigned int)olsr_sizeof_tc_lqdata());
+        return false;
+      }
+      edge->lq_len = (uint8_t)len;
+      memcpy(edge->lq, lq, (size_t)len);
+      edges += hdr->record_size[STATE_EDGE];
+      edge_count++;
+    } OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
+
+    tcs->edge_count = edge_count - tcs->edge_first;
+    tcs++;
+  } OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+
+  for (idx = 0; idx < HASHSIZE; idx++) {
+    struct mid_entry *entry;
+    struct mid_address *alias;
+
+    for (entry = mid_set[idx].next; entry != &mid_set[idx]; entry = entry->next) {
+      for (alias = entry->aliases; alias; alias = alias->next_alias) {
+        mids->main_addr = entry->main_addr;
+        mids->alias = alias->alias;
+        mids->vtime = state_remaining(entry->mid_timer);
+        mids++;
+      }
+    }
+  }
+
+  OLSR_FOR_ALL_HNA_ENTRIES(hna) {
+    struct hna_net *net;
+
+    for (net = hna->networks.next; net != &hna->networks; net = net->next) {
+      hnas->gateway = hna->A_gateway_addr;
+      hnas->net = net->hna_prefix.prefix;
+      hnas->prefix_len = net->hna_prefix.prefix_len;
+      hnas->vtime = state_remaining(net->hna_net_timer);
+      hnas++;
+    }
+  } OLSR_FOR_ALL_HNA_ENTRIES_END(hna);
+
+  OLSR_FOR_ALL_DUP_ENTRIES(dup) {
+    int32_t due = olsr_getTimeDue(dup->valid_until);
+
+    dups->ip = dup->ip;
+    dups->seqnr = dup->seqnr;
+    dups->too_low_counter = dup->too_low_counter;
+    dups->array = dup->array;
+    dups->vtime = due > 0 ? (uint32_t)due : 0;
+    dups++;
+  } OLSR_FOR_ALL_DUP_ENTRIES_END(dup);
+
+  OLSR_FOR_ALL_RT_ENTRIES(rt) {
+    if (rt->rt_nexthop.iif_index > -1) {
+      state_fill_route(routes++, rt);
+    }
+  } OLSR_FOR_ALL_RT_ENTRIES_END(rt);
+
+  for (node = avl_walk_first(&held_routingtree); node; node = avl_walk_next(node)) {
+    state_fill_route(routes++, rt_tree2rt(node));
+  }
+  return true;
+}
+
+static bool
+state_write(const char *file, const uint8_t *buf, size_t len)
+{
+  char tmp[FILENAME_MAX];
+  ssize_t written;
+  int fd;
+
+  snprintf(tmp, sizeof(tmp), "%s.tmp", file);
+
+  fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_BINARY, S_IRUSR | S_IWUSR);
+  if (fd < 0) {
+    return false;
+  }
+
+  while (len > 0) {
+    written = write(fd, buf, len);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      close(fd);
+      unlink(tmp);
+      return false;
+    }
+    buf += written;
+    len -= (size_t)written;
+  }
+
+  if (close(fd) < 0) {
+    unlink(tmp);
+    return false;
+  }
+
+#ifdef _WIN32
+  /* rename does not replace an existing file */
+  unlink(file);
+#endif /* _WIN32 */
+  if (rename(tmp, file) < 0) {
+    unlink(tmp);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Write the current state into the state file.
+ */
+void
+olsr_state_save(void)
+{
+  struct state_header hdr;
+  struct timeval now;
+  uint8_t *buf;
+  size_t size;
+  int i;
+
+  if (olsr_cnf->state_file == NULL) {
+    return;
+  }
+
+  memset(&hdr, 0, sizeof(hdr));
+  hdr.magic = STATE_MAGIC;
+  hdr.version = STATE_VERSION;
+  hdr.main_addr = olsr_cnf->main_addr;
+  strscpy(hdr.lq_algorithm, state_lq_algorithm(), sizeof(hdr.lq_algorithm));
+  hdr.msg_seqno = peek_msg_seqno();
+  hdr.ansn = get_local_ansn();
+  hdr.ip_version = olsr_cnf->ip_version == AF_INET ? 4 : 6;
+  hdr.lq_level = olsr_cnf->lq_level;
+
+  gettimeofday(&now, NULL);
+  hdr.saved_sec = (uint32_t)now.tv_sec;
+  hdr.saved_msec = (uint32_t)(now.tv_usec / 1000);
+
+  state_count(hdr.count);
+
+  size = sizeof(hdr);
+  for (i = 0; i < STATE_SECTIONS; i++) {
+    size_t record_size = state_record_size(i);
+
+    if (record_size == 0) {
+      olsr_syslog(OLSR_LOG_ERR, "Cannot write state file %s: the TC link quality of %s is too large",
+                  olsr_cnf->state_file, state_lq_algorithm());
+      OLSR_PRINTF(1, "State: the TC link quality of %s is too large, no checkpoint\n", state_lq_algorithm());
+      return;
+    }
+    hdr.record_size[i] = (uint8_t)record_size;
+    hdr.offset[i] = (uint32_t)size;
+    size += hdr.count[i] * record_size;
+  }
+  hdr.size = (uint32_t)size;
+
+  buf = olsr_malloc(size, "state checkpoint");
+  if (!state_fill(buf, &hdr)) {
+    olsr_syslog(OLSR_LOG_ERR, "Cannot write state file %s: the TC link quality does not fit", olsr_cnf->state_file);
+    free(buf);
+    return;
+  }
+
+  hdr.checksum = state_checksum(buf + sizeof(hdr), size - sizeof(hdr));
+  memcpy(buf, &hdr, sizeof(hdr));
+
+  if (state_write(olsr_cnf->state_file, buf, size)) {
+    OLSR_PRINTF(3, "State: saved %u nodes, %u edges, %u routes to %s\n",
+                hdr.count[STATE_TC], hdr.count[STATE_EDGE], hdr.count[STATE_ROUTE], olsr_cnf->state_file);
+  } else {
+    olsr_syslog(OLSR_LOG_ERR, "Cannot write state file %s: %s", olsr_cnf->state_file, strerror(errno));
+    OLSR_PRINTF(1, "State: cannot write %s: %s\n", olsr_cnf->state_file, strerror(errno));
+  }
+  free(buf);
+}
+
+static void
+olsr_state_save_timer(void *context __attribute__ ((unused)))
+{
+  olsr_state_save();
+}
+
+static bool
+state_validate(const uint8_t *buf, size_t len)
+{
+  const struct state_header *hdr = (const struct state_header *)buf;
+  int i;
+
+  if (len < sizeof(*hdr) || hdr->magic != STATE_MAGIC || hdr->version != STATE_VERSION || hdr->size != len) {
+    return false;
+  }
+
+  for (i = 0; i < STATE_SECTIONS; i++) {
+    size_t record_size = state_record_size(i);
+
+    if (record_size == 0 || hdr->record_size[i] != record_size || hdr->offset[i] < sizeof(*hdr) || hdr->offset[i] > len
+        || hdr->count[i] > (len - hdr->offset[i]) / record_size || (hdr->offset[i] & 3) != 0) {
+      return false;
+    }
+  }
+
+  return hdr->checksum == state_checksum(buf + sizeof(*hdr), len - sizeof(*hdr));
+}
+
+/* remaining validity of a checkpointed entry, 0 if it has expired */
+static olsr_reltime
+state_vtime(uint32_t vtime, uint32_t elapsed)
+{
+  return vtime > elapsed ? vtime - elapsed : 0;
+}
+
+static void
+state_restore(const uint8_t *buf, bool restore_routes)
+{
+  const struct state_header *hdr = (const struct state_header *)buf;
+  const struct state_tc *tcs = (const struct state_tc *)(buf + hdr->offset[STATE_TC]);
+  const uint8_t *edges = buf + hdr->offset[STATE_EDGE];
+  const struct state_mid *mids = (const struct state_mid *)(buf + hdr->offset[STATE_MID]);
+  const struct state_hna *hnas = (const struct state_hna *)(buf + hdr->offset[STATE_HNA]);
+  const struct state_dup *dups = (const struct state_dup *)(buf + hdr->offset[STATE_DUP]);
+  const struct state_route *routes = (const struct state_route *)(buf + hdr->offset[STATE_ROUTE]);
+  struct timeval now;
+  uint32_t elapsed, i, j, restored = 0;
+  int64_t diff;
+
+  gettimeofday(&now, NULL);
+  diff = ((int64_t)now.tv_sec - hdr->saved_sec) * MSEC_PER_SEC + (now.tv_usec / 1000) - hdr->saved_msec;
+  elapsed = diff < 0 ? 0 : (diff > 0xffffffff ? 0xffffffff : (uint32_t)diff);
+
+  OLSR_PRINTF(1, "State: restoring checkpoint taken %u.%03u s ago\n", elapsed / MSEC_PER_SEC, elapsed % MSEC_PER_SEC);
+
+  /* never reuse sequence numbers the neighbors may still remember */
+  set_msg_seqno(hdr->msg_seqno + STATE_SEQNO_MARGIN);
+  set_local_ansn(hdr->ansn + STATE_ANSN_MARGIN);
+
+  for (i = 0; i < hdr->count[STATE_TC]; i++) {
+    struct tc_entry *tc;
+    union olsr_ip_addr addr = tcs[i].addr;
+    olsr_reltime vtime = state_vtime(tcs[i].vtime, elapsed);
+
+    if (vtime == 0 || tcs[i].edge_first > hdr->count[STATE_EDGE]
+        || tcs[i].edge_count > hdr->count[STATE_EDGE] - tcs[i].edge_first) {
+      continue;
+    }
+
+    tc = olsr_restore_tc_entry(&addr, tcs[i].msg_seq, tcs[i].ansn, tcs[i].msg_hops, vtime);
+    if (tc == NULL) {
+      continue;
+    }
+    restored++;
+
+    for (j = tcs[i].edge_first; j < tcs[i].edge_first + tcs[i].edge_count; j++) {
+      const struct state_edge *edge = (const struct state_edge *)(edges + j * hdr->record_size[STATE_EDGE]);
+      union olsr_ip_addr dst = edge->addr;
+      uint8_t lq[STATE_LQ_MAX];
+
+      /* the lq deserializer reads the full message format */
+      if (edge->lq_len != olsr_sizeof_tc_lqdata()) {
+        continue;
+      }
+      memcpy(lq, edge->lq, edge->lq_len);
+      olsr_restore_tc_edge(tc, &dst, edge->ansn, lq);
+    }
+  }
+
+  for (i = 0; i < hdr->count[STATE_MID]; i++) {
+    union olsr_ip_addr main_addr = mids[i].main_addr;
+    olsr_reltime vtime = state_vtime(mids[i].vtime, elapsed);
+
+    if (vtime > 0) {
+      insert_mid_alias(&main_addr, &mids[i].alias, vtime);
+    }
+  }
+
+  for (i = 0; i < hdr->count[STATE_HNA]; i++) {
+    olsr_reltime vtime = state_vtime(hnas[i].vtime, elapsed);
+
+    if (vtime > 0 && hnas[i].prefix_len <= olsr_cnf->maxplen) {
+      olsr_update_hna_entry(&hnas[i].gateway, &hnas[i].net, hnas[i].prefix_len, vtime);
+    }
+  }
+
+  for (i = 0; i < hdr->count[STATE_DUP]; i++) {
+    union olsr_ip_addr ip = dups[i].ip;
+    olsr_reltime vtime = state_vtime(dups[i].vtime, elapsed);
+
+    if (vtime > 0) {
+      olsr_restore_duplicate_entry(&ip, dups[i].seqnr, dups[i].too_low_counter, dups[i].array, vtime);
+    }
+  }
+
+  for (i = 0; restore_routes && i < hdr->count[STATE_ROUTE]; i++) {
+    struct olsr_ip_prefix prefix;
+    struct rt_nexthop nexthop;
+    struct rt_metric metric;
+    struct interface_olsr *ifn;
+    char if_name[IFNAMSIZ];
+
+    /* the interface may be gone, the kernel removed its routes then */
+    strscpy(if_name, routes[i].if_name, sizeof(if_name));
+    ifn = if_ifwithname(if_name);
+    if (ifn == NULL || routes[i].prefix_len > olsr_cnf->maxplen) {
+      continue;
+    }
+
+    memset(&prefix, 0, sizeof(prefix));
+    prefix.prefix = routes[i].dst;
+    prefix.prefix_len = routes[i].prefix_len;
+    nexthop.gateway = routes[i].gateway;
+    nexthop.iif_index = ifn->if_index;
+    metric.cost = routes[i].cost;
+    metric.hops = routes[i].hops;
+
+    olsr_hold_kernel_route(&prefix, &nexthop, &metric);
+  }
+
+  OLSR_PRINTF(1, "State: restored %u nodes, %u kernel routes\n", restored, held_routingtree.count);
+
+  changes_topology = true;
+  changes_hna = true;
+}
+
+static void
+state_load(bool restore_routes)
+{
+  const char *file = olsr_cnf->state_file;
+  const struct state_header *hdr;
+  struct stat st;
+  uint8_t *buf;
+  size_t len;
+  int fd;
+
+  fd = open(file, O_RDONLY | O_BINARY);
+  if (fd < 0) {
+    if (errno != ENOENT) {
+      OLSR_PRINTF(1, "State: cannot open %s: %s\n", file, strerror(errno));
+    }
+    return;
+  }
+
+  if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(struct state_header)) {
+    close(fd);
+    return;
+  }
+  len = (size_t)st.st_size;
+
+#ifndef _WIN32
+  buf = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (buf == MAP_FAILED) {
+    OLSR_PRINTF(1, "State: cannot map %s: %s\n", file, strerror(errno));
+    return;
+  }
+#else /* _WIN32 */
+  {
+    size_t done = 0;
+
+    buf = olsr_malloc(len, "state checkpoint");
+    while (done < len) {
+      int n = read(fd, buf + done, len - done);
+      if (n <= 0) {
+        break;
+      }
+      done += (size_t)n;
+    }
+    close(fd);
+    if (done != len) {
+      free(buf);
+      return;
+    }
+  }
+#endif /* _WIN32 */
+
+  hdr = (const struct state_header *)buf;
+  if (!state_validate(buf, len)) {
+    olsr_syslog(OLSR_LOG_ERR, "Ignoring invalid state file %s", file);
+    OLSR_PRINTF(1, "State: ignoring invalid file %s\n", file);
+  } else if (hdr->ip_version != (olsr_cnf->ip_version == AF_INET ? 4 : 6)
+             || !ipequal(&hdr->main_addr, &olsr_cnf->main_addr)
+             || hdr->lq_level != olsr_cnf->lq_level
+             || strncasecmp(hdr->lq_algorithm, state_lq_algorithm(), sizeof(hdr->lq_algorithm)) != 0) {
+    OLSR_PRINTF(1, "State: %s was written by a different setup, ignoring it\n", file);
+  } else {
+    state_restore(buf, restore_routes);
+  }
+
+#ifndef _WIN32
+  munmap(buf, len);
+#else /* _WIN32 */
+  free(buf);
+#endif /* _WIN32 */
+}
+
+/**
+ * Restore the state file and start the periodic checkpoint timer.
+ *
+ * @param restore_routes hold the checkpointed kernel routes for
+ *   reconciliation, only correct if they were kept on shutdown and
+ *   the kernel FIB could not be read
+ */
+void
+olsr_state_init(bool restore_routes)
+{
+  if (olsr_cnf->state_file == NULL) {
+    return;
+  }
+
+  state_timer_cookie = olsr_alloc_cookie("State Checkpoint", OLSR_COOKIE_TYPE_TIMER);
+
+  state_load(restore_routes);
+
+  if (olsr_cnf->state_interval > 0) {
+    olsr_set_timer(&state_save_timer, (unsigned int)(olsr_cnf->state_interval * MSEC_PER_SEC), STATE_TIMER_JITTER,
+                   OLSR_TIMER_PERIODIC, &olsr_state_save_timer, NULL, state_timer_cookie);
+  }
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -100,6 +100,15 @@ struct olsrd_plugin_parameters {
  */
 void olsrd_get_plugin_parameters(const struct olsrd_plugin_parameters **params, int *size);
 
+/**
+ * Optional: called when the plugin parameters were changed in a reloaded
+ * configuration. The plugin undoes what olsrd_plugin_init did and restores
+ * its parameter defaults; olsrd then passes the new parameters and calls
+ * olsrd_plugin_init again. Return 0 on success.
+ * Plugins without this function need a restart of olsrd for new parameters.
+ */
+int olsrd_plugin_reconfigure(void);
+
 #endif /* _OLSRD_PLUGIN */
 
 /*
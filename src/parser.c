@@ -57,6 +57,8 @@
 #include "log.h"
 #include "net_olsr.h"
 #include "duplicate_handler.h"
+#include "olsr_metrics.h"
+#include "lq_packet.h"
 
 #ifdef _WIN32
 #undef EWOULDBLOCK
@@ -83,6 +85,46 @@ struct packetparser_function_entry *packetparser_functions;
 static uint32_t inbuf_aligned[MAXMESSAGESIZE/sizeof(uint32_t) + 1];
 static char *inbuf = (char *)inbuf_aligned;
 
+/* processing latency per message type, registered on first use */
+static struct olsr_metric *parse_metrics[256];
+
+static struct olsr_metric *
+parse_metric(uint8_t type)
+{
+  if (!parse_metrics[type]) {
+    char buf[8];
+    const char *label;
+
+    switch (type) {
+    case HELLO_MESSAGE:
+      label = "hello";
+      break;
+    case TC_MESSAGE:
+      label = "tc";
+      break;
+    case MID_MESSAGE:
+      label = "mid";
+      break;
+    case HNA_MESSAGE:
+      label = "hna";
+      break;
+    case LQ_HELLO_MESSAGE:
+      label = "lq_hello";
+      break;
+    case LQ_TC_MESSAGE:
+      label = "lq_tc";
+      break;
+    default:
+      snprintf(buf, sizeof(buf), "%u", type);
+      label = buf;
+      break;
+    }
+    parse_metrics[type] = olsr_metric_get(OLSR_METRIC_LATENCY, "parse_message",
+        "Processing of a received message by the parse functions, including forwarding", "type", label);
+  }
+  return parse_metrics[type];
+}
+
 /**
  *Initialize the parser.
  *
@@ -311,6 +353,8 @@ parse_packet(struct olsr *olsr, int size, struct interface_olsr *in_if, union ol
   for (; count > 0; m = (union olsr_message *)((char *)m + (msgsize))) {
     bool forward = true;
     bool validated;
+    uint8_t msgtype;
+    uint64_t start;
 
     /* minimum message size is 8 + ipsize */
     if (count < 8 + olsr_cnf->ipsize)
@@ -388,6 +432,9 @@ parse_packet(struct olsr *olsr, int size, struct interface_olsr *in_if, union ol
       continue;
     }
 
+    msgtype = m->v4.olsr_msgtype;
+    start = olsr_metrics_start();
+
     entry = parse_functions;
     while (entry) {
       /* Should be the same for IPv4 and IPv6 */
@@ -403,6 +450,10 @@ parse_packet(struct olsr *olsr, int size, struct interface_olsr *in_if, union ol
     if (forward) {
       olsr_forward_message(m, in_if, from_addr);
     }
+
+    if (start) {
+      olsr_metrics_stop(parse_metric(msgtype), start);
+    }
   }                             /* for olsr_msg */
 }
 
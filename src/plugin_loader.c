@@ -48,6 +48,7 @@
 #include "plugin_util.h"
 #include "defs.h"
 #include "olsr.h"
+#include "log.h"
 
 #include <dlfcn.h>
 
@@ -120,6 +121,7 @@ olsr_load_dl(char *libname, struct plugin_param *params)
     free(plugin);
     errno = save_errno;
   } else {
+    plugin->name = libname;
     plugin->params = params;
 
     /* Initialize the plugin */
@@ -219,6 +221,9 @@ olsr_add_dl(struct olsr_plugin *plugin)
   get_plugin_parameters = dlsym(plugin->dlhandle, "olsrd_get_plugin_parameters");
   if (get_plugin_parameters != NULL) {
     (*get_plugin_parameters) (&plugin->plugin_parameters, &plugin->plugin_parameters_size);
+
+    /* Fetch the (optional) reconfigure function */
+    plugin->plugin_reconfigure = dlsym(plugin->dlhandle, "olsrd_plugin_reconfigure");
   } else {
 #if defined SUPPORT_OLD_PLUGIN_VERSIONS && SUPPORT_OLD_PLUGIN_VERSIONS
     /* Fetch the parameter function */
@@ -234,6 +239,7 @@ olsr_add_dl(struct olsr_plugin *plugin)
 
     plugin->plugin_parameters = NULL;
     plugin->plugin_parameters_size = 0;
+    plugin->plugin_reconfigure = NULL;
 #else /* defined SUPPORT_OLD_PLUGIN_VERSIONS && SUPPORT_OLD_PLUGIN_VERSIONS */
     OLSR_PRINTF(0, "Old plugin interfaces are not supported\n");
     return -1;
@@ -309,6 +315,103 @@ init_olsr_plugin(struct olsr_plugin *entry)
   return rv;
 }
 
+/**
+ * Compare two plugin parameter lists
+ *
+ *@return true when both lists hold the same parameters in the same order
+ */
+static bool
+plugin_params_equal(const struct plugin_param *a, const struct plugin_param *b)
+{
+  while (a && b) {
+    if (strcmp(a->key, b->key) != 0 || strcmp(a->value, b->value) != 0) {
+      return false;
+    }
+    a = a->next;
+    b = b->next;
+  }
+  return a == b;
+}
+
+/**
+ *Hand changed parameters to the loaded plugins. A plugin that exports
+ *olsrd_plugin_reconfigure is asked to undo its init function and restore
+ *its parameter defaults, after which it is sent the new parameters and
+ *initialized again. Other plugins keep running with their old parameters.
+ *
+ *@param plugins the plugin list of the new configuration. Parameter lists
+ *that are handed to a plugin are swapped with the ones in olsr_cnf.
+ *
+ *@return the number of plugins that need a restart of olsrd
+ */
+int
+olsr_reconfigure_plugins(struct plugin_entry *plugins)
+{
+  struct olsr_plugin *plugin;
+  struct plugin_entry *entry, *new_entry;
+  int restart = 0;
+
+  for (new_entry = plugins; new_entry != NULL; new_entry = new_entry->next) {
+    for (plugin = olsr_plugins; plugin != NULL; plugin = plugin->next) {
+      if (strcmp(plugin->name, new_entry->name) == 0) {
+        break;
+      }
+    }
+    if (plugin == NULL) {
+      olsr_syslog(OLSR_LOG_INFO, "Plugin %s was added, a restart is needed to load it", new_entry->name);
+      restart++;
+    }
+  }
+
+  for (plugin = olsr_plugins; plugin != NULL; plugin = plugin->next) {
+    struct plugin_param *params;
+
+    for (new_entry = plugins; new_entry != NULL; new_entry = new_entry->next) {
+      if (strcmp(plugin->name, new_entry->name) == 0) {
+        break;
+      }
+    }
+    if (new_entry == NULL) {
+      olsr_syslog(OLSR_LOG_INFO, "Plugin %s was removed, a restart is needed to unload it", plugin->name);
+      restart++;
+      continue;
+    }
+
+    if (plugin_params_equal(plugin->params, new_entry->params)) {
+      continue;
+    }
+
+    if (plugin->plugin_reconfigure == NULL) {
+      olsr_syslog(OLSR_LOG_INFO, "Plugin %s can not be reconfigured, a restart is needed to change its parameters",
+                  plugin->name);
+      restart++;
+      continue;
+    }
+
+    entry = olsr_cnf->plugins;
+    while (entry != NULL && entry->name != plugin->name) {
+      entry = entry->next;
+    }
+    if (entry == NULL || plugin->plugin_reconfigure() != 0) {
+      olsr_syslog(OLSR_LOG_ERR, "Plugin %s failed to reconfigure", plugin->name);
+      restart++;
+      continue;
+    }
+
+    params = entry->params;
+    entry->params = new_entry->params;
+    new_entry->params = params;
+    plugin->params = entry->params;
+
+    OLSR_PRINTF(0, "---------- RECONFIGURING LIBRARY %s ----------\n", plugin->name);
+    if (init_olsr_plugin(plugin) != 0) {
+      olsr_syslog(OLSR_LOG_ERR, "Plugin %s rejected its new parameters", plugin->name);
+    }
+  }
+
+  return restart;
+}
+
 /**
  *Close all loaded plugins
  */
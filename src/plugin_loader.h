@@ -65,10 +65,16 @@ typedef int (*register_param_func) (char *, char *);
 /* version 5 */
 typedef void (*get_plugin_parameters_func) (const struct olsrd_plugin_parameters ** params, unsigned int *size);
 
+/* optional: undo plugin_init and restore the parameter defaults */
+typedef int (*plugin_reconfigure_func) (void);
+
 struct olsr_plugin {
   /* The handle */
   void *dlhandle;
 
+  /* The library name, owned by the plugin entry of the configuration */
+  char *name;
+
   struct plugin_param *params;
   int plugin_interface_version;
 
@@ -81,6 +87,7 @@ struct olsr_plugin {
   /* version 5 */
   const struct olsrd_plugin_parameters *plugin_parameters;
   unsigned int plugin_parameters_size;
+  plugin_reconfigure_func plugin_reconfigure;
 
   struct olsr_plugin *next;
 };
@@ -89,6 +96,8 @@ void olsr_load_plugins(void);
 
 void olsr_close_plugins(void);
 
+int olsr_reconfigure_plugins(struct plugin_entry *);
+
 int olsr_plugin_io(int, void *, size_t);
 
 #endif /* OLSR_PLUGIN */
@@ -51,6 +51,7 @@
 #include "two_hop_neighbor_table.h"
 #include "tc_set.h"
 #include "mpr_selector_set.h"
+#include "mpr.h"
 #include "mid_set.h"
 #include "olsr.h"
 #include "parser.h"
@@ -69,6 +70,8 @@ static void linking_this_2_entries(struct neighbor_entry *, struct neighbor_2_en
 
 static bool lookup_mpr_status(const struct hello_message *, const struct interface_olsr *);
 
+static void olsr_process_hello(struct hello_message *, struct interface_olsr *, const union olsr_ip_addr *);
+
 /**
  *Processes an list of neighbors from an incoming HELLO message.
  *@param neighbor the neighbor who sent the message.
@@ -174,8 +177,11 @@ process_message_neighbors(struct neighbor_entry *neighbor, const struct hello_me
     olsr_linkcost first_hop_pathcost;
     struct link_entry *lnk = get_best_link_to_neighbor(&neighbor->neighbor_main_addr);
 
-    if (!lnk)
+    if (!lnk) {
+      /* the path link costs were reset in the first pass */
+      olsr_mpr_dirty_neighbor(neighbor);
       return;
+    }
 
     /* calculate first hop path quality */
     first_hop_pathcost = lnk->linkcost;
@@ -239,6 +245,11 @@ process_message_neighbors(struct neighbor_entry *neighbor, const struct hello_me
               changes_neighborhood = true;
               changes_topology = true;
             }
+
+            /* only reselect MPRs when the path link cost really changed */
+            if (walker->path_linkcost != walker->mpr_path_linkcost) {
+              olsr_mpr_dirty_two_hop(two_hop_neighbor);
+            }
           }
         }
       }
@@ -284,6 +295,8 @@ linking_this_2_entries(struct neighbor_entry *neighbor, struct neighbor_2_entry
 
   /*increment the pointer counter */
   two_hop_neighbor->neighbor_2_pointer++;
+
+  olsr_mpr_dirty_two_hop(two_hop_neighbor);
 }
 
 /**
@@ -315,20 +328,118 @@ lookup_mpr_status(const struct hello_message *message, const struct interface_ol
   return false;
 }
 
-static int
-deserialize_hello(struct hello_message *hello, const void *ser)
+/*
+ * The neighbors of the HELLO message that is processed right now are
+ * decoded into an arena that is reused for every message, instead of
+ * allocating every neighbor. A hello_neighbor has a variable size
+ * (link quality data), so the arena is a byte array.
+ */
+static uint8_t *hello_arena = NULL;
+static size_t hello_arena_entries = 0;
+static size_t hello_entry_size = 0;
+
+/* open addressing hash of the non UNSPEC_LINK neighbor addresses */
+static uint32_t *hello_cull_hash = NULL;
+static uint32_t hello_cull_mask = 0;
+
+#define HELLO_ARENA_ENTRY(idx) ((struct hello_neighbor *)ARM_NOWARN_ALIGN(hello_arena + (idx) * hello_entry_size))
+
+/* make room for the maximum number of neighbors a message can carry */
+static void
+hello_arena_reserve(size_t entries)
+{
+  uint32_t hash_size;
+
+  if (hello_entry_size == 0) {
+    hello_entry_size = (olsr_sizeof_hello_neighbor() + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+  }
+  if (entries <= hello_arena_entries) {
+    return;
+  }
+
+  hello_arena = olsr_realloc(hello_arena, entries * hello_entry_size, "HELLO deserialization");
+  hello_arena_entries = entries;
+
+  for (hash_size = 16; hash_size < 2 * entries; hash_size <<= 1);
+  hello_cull_hash = olsr_realloc(hello_cull_hash, hash_size * sizeof(*hello_cull_hash), "HELLO deserialization");
+  hello_cull_mask = hash_size - 1;
+}
+
+static uint32_t
+hello_cull_slot(const union olsr_ip_addr *addr)
+{
+  uint32_t h;
+
+  if (olsr_cnf->ip_version == AF_INET) {
+    h = addr->v4.s_addr;
+  } else {
+    uint32_t w[4];
+
+    memcpy(w, &addr->v6, sizeof(w));
+    h = w[0] ^ w[1] ^ w[2] ^ w[3];
+  }
+  h ^= h >> 16;
+  h *= 0x45d9f3b;
+  h ^= h >> 16;
+  return h & hello_cull_mask;
+}
+
+static void
+hello_cull_add(uint32_t idx)
+{
+  const union olsr_ip_addr *addr = &HELLO_ARENA_ENTRY(idx)->address;
+  uint32_t slot;
+
+  for (slot = hello_cull_slot(addr); hello_cull_hash[slot] != 0; slot = (slot + 1) & hello_cull_mask) {
+    if (ipequal(&HELLO_ARENA_ENTRY(hello_cull_hash[slot] - 1)->address, addr)) {
+      return;
+    }
+  }
+  hello_cull_hash[slot] = idx + 1;
+}
+
+static bool
+hello_cull_contains(const union olsr_ip_addr *addr)
+{
+  uint32_t slot;
+
+  for (slot = hello_cull_slot(addr); hello_cull_hash[slot] != 0; slot = (slot + 1) & hello_cull_mask) {
+    if (ipequal(&HELLO_ARENA_ENTRY(hello_cull_hash[slot] - 1)->address, addr)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * Decode a HELLO message in a single pass over the link blocks.
+ *
+ * The neighbor list has the same order as if the blocks were processed
+ * in HELLO_LINK_ORDER_ARRAY order and every neighbor was prepended:
+ * every link type has its own chain, the chains are joined at the end.
+ * UNSPEC_LINK neighbors that are also listed with another link type
+ * are dropped.
+ *
+ * The neighbors live in the HELLO arena, they are only valid until the
+ * next message is decoded and must not be freed.
+ *
+ * @param hello the decoded message
+ * @param ser the HELLO or LQ_HELLO message
+ * @return 0 on success, 1 if the message is no HELLO
+ */
+int
+olsr_deserialize_hello(struct hello_message *hello, const void *ser)
 {
   static const int LINK_ORDER[] = HELLO_LINK_ORDER_ARRAY;
   const unsigned char *curr, *limit;
   uint8_t type;
   uint16_t size;
-  struct ipaddr_str buf;
-  const unsigned char *curr_saved;
-  unsigned int idx;
-  struct hello_neighbor *neigh_unspec_first_prev = NULL;
-  struct hello_neighbor *neigh_unspec_first = NULL;
-
-  assert(LINK_ORDER[0] == UNSPEC_LINK);
+  struct hello_neighbor *chain_head[4], *chain_tail[4];
+  struct hello_neighbor **next_ptr;
+  uint8_t chain_of_link[4];
+  uint32_t count = 0;
+  size_t entry_size;
+  int idx;
 
   memset (hello, 0, sizeof(*hello));
 
@@ -353,76 +464,95 @@ deserialize_hello(struct hello_message *hello, const void *ser)
   hello->neighbors = NULL;
 
   limit = ((const unsigned char *)ser) + size;
+  if (curr >= limit) {
+    return 0;
+  }
 
-  curr_saved = curr;
+  /* an entry must fit completely, including its link quality */
+  entry_size = olsr_cnf->ipsize;
+  if (type == LQ_HELLO_MESSAGE) {
+    entry_size += olsr_sizeof_hello_lqdata();
+  }
 
-  for (idx = 0; idx < (sizeof(LINK_ORDER) / sizeof(LINK_ORDER[0])); idx++) {
-    curr = curr_saved;
+  hello_arena_reserve((size_t)(limit - curr) / entry_size + 1);
+  memset(hello_cull_hash, 0, (hello_cull_mask + 1) * sizeof(*hello_cull_hash));
 
-    while (curr < limit) {
-      const unsigned char *limit2 = curr;
-      uint8_t link_code;
-      uint16_t size2;
+  for (idx = 0; idx < 4; idx++) {
+    chain_head[idx] = NULL;
+    chain_tail[idx] = NULL;
+    chain_of_link[LINK_ORDER[idx]] = idx;
+  }
 
-      pkt_get_u8(&curr, &link_code);
-      pkt_ignore_u8(&curr);
-      pkt_get_u16(&curr, &size2);
+  while (curr + 4 <= limit) {
+    const unsigned char *limit2 = curr;
+    struct hello_neighbor **chain;
+    uint8_t link_code, link;
+    uint16_t size2;
 
-      limit2 += size2;
+    pkt_get_u8(&curr, &link_code);
+    pkt_ignore_u8(&curr);
+    pkt_get_u16(&curr, &size2);
 
-      if (EXTRACT_LINK(link_code) != LINK_ORDER[idx]) {
-        curr = limit2;
-        continue;
-      }
-
-      while (curr < limit2) {
-        struct hello_neighbor *neigh = olsr_malloc_hello_neighbor("HELLO deserialization");
-        pkt_get_ipaddress(&curr, &neigh->address);
-        if (type == LQ_HELLO_MESSAGE) {
-          olsr_deserialize_hello_lq_pair(&curr, neigh);
-        }
-        neigh->link = EXTRACT_LINK(link_code);
-        neigh->status = EXTRACT_STATUS(link_code);
-
-        neigh->next = hello->neighbors;
-        hello->neighbors = neigh;
+    if (size2 < 4) {
+      /* broken link block, its end can not be found */
+      break;
+    }
 
-        if (neigh->link == UNSPEC_LINK) {
-          neigh_unspec_first = neigh;
-        } else if (!neigh_unspec_first_prev) {
-          neigh_unspec_first_prev = neigh;
-        }
-      }
+    limit2 += size2;
+    if (limit2 > limit) {
+      limit2 = limit;
     }
-  }
 
-  if (neigh_unspec_first_prev && neigh_unspec_first) {
-    struct hello_neighbor *neigh;
-    for (neigh = hello->neighbors; neigh && (neigh != neigh_unspec_first); neigh = neigh->next) {
-      struct hello_neighbor *neigh_cull;
-      struct hello_neighbor *neigh_cull_prev;
-      struct hello_neighbor *neigh_cull_next;
+    link = EXTRACT_LINK(link_code);
+    chain = &chain_head[chain_of_link[link]];
 
-      for (neigh_cull_prev = neigh_unspec_first_prev, neigh_cull = neigh_unspec_first;
-           neigh_cull;
-           neigh_cull = neigh_cull_next) {
-        neigh_cull_next = neigh_cull->next;
+    while (curr + entry_size <= limit2 && count < hello_arena_entries) {
+      struct hello_neighbor *neigh = HELLO_ARENA_ENTRY(count);
 
-        if (!ipequal(&neigh_cull->address, &neigh->address)) {
-          neigh_cull_prev = neigh_cull;
-          continue;
-        }
+      olsr_clear_hello_neighbor_lq(neigh);
+      pkt_get_ipaddress(&curr, &neigh->address);
+      if (type == LQ_HELLO_MESSAGE) {
+        olsr_deserialize_hello_lq_pair(&curr, neigh);
+      }
+      neigh->link = link;
+      neigh->status = EXTRACT_STATUS(link_code);
 
-        if (neigh_cull == neigh_unspec_first) {
-          neigh_unspec_first = neigh_cull_next;
-        }
+      neigh->next = *chain;
+      if (*chain == NULL) {
+        chain_tail[chain_of_link[link]] = neigh;
+      }
+      *chain = neigh;
 
-        neigh_cull_prev->next = neigh_cull_next;
-        free(neigh_cull);
+      if (link != UNSPEC_LINK) {
+        hello_cull_add(count);
       }
+      count++;
+    }
+    curr = limit2;
+  }
+
+  /* drop UNSPEC_LINK neighbors that are listed with a real link type */
+  next_ptr = &chain_head[chain_of_link[UNSPEC_LINK]];
+  chain_tail[chain_of_link[UNSPEC_LINK]] = NULL;
+  while (*next_ptr) {
+    if (hello_cull_contains(&(*next_ptr)->address)) {
+      *next_ptr = (*next_ptr)->next;
+    } else {
+      chain_tail[chain_of_link[UNSPEC_LINK]] = *next_ptr;
+      next_ptr = &(*next_ptr)->next;
     }
   }
 
+  /* join the chains, the last link type of LINK_ORDER comes first */
+  next_ptr = &hello->neighbors;
+  for (idx = 3; idx >= 0; idx--) {
+    if (chain_head[idx]) {
+      *next_ptr = chain_head[idx];
+      next_ptr = &chain_tail[idx]->next;
+    }
+  }
+  *next_ptr = NULL;
+
   return 0;
 }
 
@@ -434,10 +564,12 @@ olsr_input_hello(union olsr_message * ser, struct interface_olsr * inif, union o
   if (ser == NULL) {
     return false;
   }
-  if (deserialize_hello(&hello, ser) != 0) {
+  if (olsr_deserialize_hello(&hello, ser) != 0) {
     return false;
   }
-  olsr_hello_tap(&hello, inif, from);
+
+  /* the neighbors live in the HELLO arena, do not free them */
+  olsr_process_hello(&hello, inif, from);
 
   /* Do not forward hello messages */
   return false;
@@ -461,8 +593,18 @@ olsr_init_package_process(void)
   olsr_parser_add_function(&olsr_input_hna, HNA_MESSAGE);
 }
 
+/**
+ * Process a HELLO message and free its neighbor list afterwards.
+ */
 void
 olsr_hello_tap(struct hello_message *message, struct interface_olsr *in_if, const union olsr_ip_addr *from_addr)
+{
+  olsr_process_hello(message, in_if, from_addr);
+  olsr_free_hello_packet(message);
+}
+
+static void
+olsr_process_hello(struct hello_message *message, struct interface_olsr *in_if, const union olsr_ip_addr *from_addr)
 {
   struct neighbor_entry *neighbor;
 
@@ -538,6 +680,7 @@ olsr_hello_tap(struct hello_message *message, struct interface_olsr *in_if, cons
      *If willingness changed - recalculate
      */
     neighbor->willingness = message->willingness;
+    olsr_mpr_dirty_neighbor(neighbor);
     changes_neighborhood = true;
     changes_topology = true;
   }
@@ -548,10 +691,6 @@ olsr_hello_tap(struct hello_message *message, struct interface_olsr *in_if, cons
 
   /* Process changes immediately in case of MPR updates */
   olsr_process_changes();
-
-  olsr_free_hello_packet(message);
-
-  return;
 }
 
 /*
@@ -50,6 +50,8 @@
 #include "packet.h"
 #include "neighbor_table.h"
 
+int olsr_deserialize_hello(struct hello_message *, const void *);
+
 bool olsr_input_hello(union olsr_message *, struct interface_olsr *, union olsr_ip_addr *);
 
 void olsr_init_package_process(void);
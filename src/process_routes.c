@@ -53,6 +53,12 @@
 #include "tc_set.h"
 #include "olsr_cookie.h"
 #include "olsr_niit.h"
+#include "interfaces.h"
+#include "scheduler.h"
+
+#ifdef __linux__
+#include <linux/rtnetlink.h>
+#endif /* __linux__ */
 
 #ifdef _WIN32
 char *StrError(unsigned int ErrNo);
@@ -62,6 +68,9 @@ char *StrError(unsigned int ErrNo);
 
 static struct list_node chg_kernel_list;
 
+/* sweeps the kernel routes of a previous run that were not adopted */
+static struct timer_entry *held_routes_timer = NULL;
+
 /**
  *
  * Calculate the kernel route flags.
@@ -123,6 +132,7 @@ olsr_delete_all_kernel_routes(void)
   olsr_bump_routingtree_version();
   olsr_update_rib_routes();
   olsr_update_kernel_routes();
+  olsr_delete_held_kernel_routes();
 }
 
 /**
@@ -221,6 +231,8 @@ olsr_add_kernel_route(struct rt_entry *rt)
       rt->rt_nexthop = rt->rt_best->rtp_nexthop;
       rt->rt_metric = rt->rt_best->rtp_metric;
 
+      olsr_startup_first_route();
+
 #ifdef __linux__
       /* call NIIT handler */
       if (olsr_cnf->use_niit) {
@@ -362,6 +374,156 @@ olsr_update_rib_routes(void)
   OLSR_FOR_ALL_RT_ENTRIES_END(rt);
 }
 
+/**
+ * Remove all kernel routes restored from a state checkpoint
+ * that have not been adopted by the RIB.
+ */
+void
+olsr_delete_held_kernel_routes(void)
+{
+  struct avl_node *rt_tree_node, *next_rt_tree_node;
+  struct rt_entry *rt;
+
+  for (rt_tree_node = avl_walk_first(&held_routingtree); rt_tree_node; rt_tree_node = next_rt_tree_node) {
+    next_rt_tree_node = avl_walk_next(rt_tree_node);
+    rt = rt_tree2rt(rt_tree_node);
+
+    OLSR_PRINTF(3, "KERN: dropping stale %s\n", olsr_rt_to_string(rt));
+
+    olsr_delete_kernel_route(rt);
+    avl_delete(&held_routingtree, rt_tree_node);
+    olsr_cookie_free(rt_mem_cookie, rt);
+  }
+}
+
+/*
+ * Routes of a previous run that have not been confirmed by the routing
+ * calculation within the grace time are stale.
+ */
+static void
+olsr_expire_held_kernel_routes(void *context __attribute__ ((unused)))
+{
+  held_routes_timer = NULL;
+
+  if (held_routingtree.count) {
+    OLSR_PRINTF(1, "KERN: removing %u unconfirmed routes\n", held_routingtree.count);
+  }
+  olsr_delete_held_kernel_routes();
+}
+
+/**
+ * Start the grace time after which the held kernel routes that have
+ * not been adopted by the RIB are removed. The neighbors get one HELLO
+ * validity time to show up again.
+ */
+void
+olsr_start_kernel_route_sweep(void)
+{
+  struct olsr_if *ifs;
+  float grace = 0;
+
+  if (!held_routingtree.count) {
+    return;
+  }
+
+  for (ifs = olsr_cnf->interfaces; ifs; ifs = ifs->next) {
+    if (ifs->cnf && ifs->cnf->hello_params.validity_time > grace) {
+      grace = ifs->cnf->hello_params.validity_time;
+    }
+  }
+  if (grace <= 0) {
+    grace = NEIGHB_HOLD_TIME;
+  }
+
+  OLSR_PRINTF(1, "KERN: holding %u routes of the previous run for %.1f s\n", held_routingtree.count, (double)grace);
+
+  olsr_set_timer(&held_routes_timer, (unsigned int)(grace * MSEC_PER_SEC), 0, OLSR_TIMER_ONESHOT,
+                 &olsr_expire_held_kernel_routes, NULL, 0);
+}
+
+#ifdef __linux__
+static bool
+olsr_is_own_table(uint8_t table)
+{
+  return table != RT_TABLE_UNSPEC && table != RT_TABLE_DEFAULT && table != RT_TABLE_MAIN && table != RT_TABLE_LOCAL;
+}
+
+/*
+ * Routes in the kernel can only be reconciled if they can be told apart
+ * from routes of other sources: olsrd either uses its own protocol
+ * number or its own routing tables.
+ */
+static bool
+olsr_kernel_routes_owned(void)
+{
+  if (olsr_cnf->host_emul) {
+    return false;
+  }
+  if (olsr_cnf->rt_proto > RTPROT_STATIC) {
+    return true;
+  }
+  return olsr_is_own_table(olsr_cnf->rt_table) && olsr_is_own_table(olsr_cnf->rt_table_default);
+}
+
+static bool
+olsr_is_own_kernel_route(const struct olsr_os_route *route)
+{
+  return route->protocol == olsr_cnf->rt_proto
+      && (route->table == olsr_cnf->rt_table || route->table == olsr_cnf->rt_table_default)
+      && route->dst.prefix_len <= olsr_cnf->maxplen
+      && if_ifwithindex(route->if_index) != NULL;
+}
+
+/* convert a kernel route into the nexthop and metric olsrd would have stored */
+static void
+olsr_kernel_route_to_rt(const struct olsr_os_route *route, struct rt_nexthop *nexthop, struct rt_metric *metric)
+{
+  nexthop->gateway = route->gateway;
+  nexthop->iif_index = route->if_index;
+
+  metric->cost = 0;
+  metric->hops = 0;
+  if (FIBM_FLAT != olsr_cnf->fib_metric) {
+    metric->hops = route->metric;
+    if (olsr_cnf->smart_gw_active && is_prefix_inetgw(&route->dst) && metric->hops >= 2) {
+      metric->hops -= 2;
+    }
+  }
+}
+
+static void
+olsr_mark_kernel_route(const struct olsr_os_route *route, void *context __attribute__ ((unused)))
+{
+  struct rt_nexthop nexthop;
+  struct rt_metric metric;
+
+  if (olsr_is_own_kernel_route(route)) {
+    olsr_kernel_route_to_rt(route, &nexthop, &metric);
+    olsr_hold_kernel_route(&route->dst, &nexthop, &metric);
+  }
+}
+#endif /* __linux__ */
+
+/**
+ * Mark the routes a previous run left in the kernel (after a graceful
+ * restart with KeepRoutes or after a crash). They are adopted by the
+ * first RIB entry for the same prefix, so only routes that differ are
+ * changed, and swept after olsr_start_kernel_route_sweep() otherwise.
+ *
+ * @return true if the kernel FIB could be read
+ */
+bool
+olsr_mark_kernel_routes(void)
+{
+#ifdef __linux__
+  if (olsr_kernel_routes_owned()
+      && olsr_os_dump_routes(olsr_cnf->ip_version, &olsr_mark_kernel_route, NULL) == 0) {
+    return true;
+  }
+#endif /* __linux__ */
+  return false;
+}
+
 void
 olsr_delete_interface_routes(int if_index) {
   struct rt_entry *rt;
@@ -426,10 +588,203 @@ olsr_update_kernel_routes(void)
 #endif /* defined DEBUG && DEBUG */
 }
 
+#ifdef __linux__
+struct kernel_route_list {
+  struct olsr_os_route *routes;
+  size_t count;
+  size_t size;
+};
+
+static void
+olsr_collect_kernel_route(const struct olsr_os_route *route, void *context)
+{
+  struct kernel_route_list *list = context;
+
+  if (!olsr_is_own_kernel_route(route)) {
+    return;
+  }
+
+  if (list->count == list->size) {
+    list->size = list->size ? list->size * 2 : 64;
+    list->routes = olsr_realloc(list->routes, list->size * sizeof(*list->routes), "kernel route list");
+  }
+  list->routes[list->count++] = *route;
+}
+
+/* order kernel routes by prefix, so duplicates are adjacent */
+static int
+olsr_cmp_kernel_route(const void *p1, const void *p2)
+{
+  const struct olsr_os_route *r1 = p1;
+  const struct olsr_os_route *r2 = p2;
+
+  return avl_comp_prefix_default(&r1->dst, &r2->dst);
+}
+
+static int
+olsr_find_kernel_route(const void *key, const void *p)
+{
+  const struct olsr_os_route *r = p;
+
+  return avl_comp_prefix_default(key, &r->dst);
+}
+
+/* check if a kernel route is the one the RIB entry wants */
+static bool
+olsr_kernel_route_matches(const struct rt_entry *rt, const struct rt_nexthop *nexthop, const struct rt_metric *metric)
+{
+  return !olsr_nh_change(&rt->rt_best->rtp_nexthop, nexthop)
+      && (FIBM_CORRECT != olsr_cnf->fib_metric || !olsr_hopcount_change(&rt->rt_best->rtp_metric, metric));
+}
+
+static void
+olsr_delete_unwanted_kernel_route(const struct olsr_os_route *route)
+{
+  struct rt_entry stale;
+
+  memset(&stale, 0, sizeof(stale));
+  stale.rt_dst = route->dst;
+  olsr_kernel_route_to_rt(route, &stale.rt_nexthop, &stale.rt_metric);
+  olsr_delete_kernel_route(&stale);
+}
+
+/**
+ * Reconcile the kernel FIB with the RIB. Only kernel routes that differ
+ * from the RIB are rewritten and RIB routes missing in the kernel are
+ * added. Kernel routes without a RIB entry (or whose RIB entry has no
+ * best path) are removed, unless they are held after a restart, and so
+ * are all but one kernel route for the same prefix.
+ *
+ * @param routes olsrd's routes in the kernel, reordered by this function
+ * @param count number of routes
+ */
+void
+olsr_reconcile_kernel_route_list(struct olsr_os_route *routes, size_t count)
+{
+  struct rt_entry *rt;
+  size_t i, j, first, unique = 0;
+  unsigned int changed = 0, removed = 0, added = 0;
+
+  qsort(routes, count, sizeof(*routes), &olsr_cmp_kernel_route);
+
+  /* keep at most one kernel route per prefix, the one the RIB wants if any */
+  for (first = 0; first < count; first = i) {
+    struct avl_node *node;
+    size_t keep = first;
+
+    for (i = first + 1; i < count && olsr_cmp_kernel_route(&routes[first], &routes[i]) == 0; i++) {
+    }
+
+    rt = NULL;
+    node = avl_find(&routingtree, &routes[first].dst);
+    if (node) {
+      rt = rt_tree2rt(node);
+      if (!rt->rt_best) {
+        /* nothing to route there anymore */
+        rt->rt_nexthop.iif_index = -1;
+        rt = NULL;
+      }
+    }
+
+    if (!rt && !avl_find(&held_routingtree, &routes[first].dst)) {
+      for (j = first; j < i; j++) {
+        olsr_delete_unwanted_kernel_route(&routes[j]);
+        removed++;
+      }
+      continue;
+    }
+
+    for (j = first; rt && j < i; j++) {
+      struct rt_nexthop nexthop;
+      struct rt_metric metric;
+
+      olsr_kernel_route_to_rt(&routes[j], &nexthop, &metric);
+      if (olsr_kernel_route_matches(rt, &nexthop, &metric)) {
+        keep = j;
+        break;
+      }
+    }
+
+    for (; first < i; first++) {
+      if (first != keep) {
+        olsr_delete_unwanted_kernel_route(&routes[first]);
+        removed++;
+      }
+    }
+    routes[unique++] = routes[keep];
+  }
+
+  /* rewrite the routes that differ, add the missing ones */
+  OLSR_FOR_ALL_RT_ENTRIES(rt) {
+    struct olsr_os_route *route;
+
+    if (!rt->rt_best) {
+      continue;
+    }
+
+    route = bsearch(&rt->rt_dst, routes, unique, sizeof(*routes), &olsr_find_kernel_route);
+    if (!route) {
+      rt->rt_nexthop.iif_index = -1;
+      olsr_enqueue_rt(&chg_kernel_list, rt);
+      added++;
+      continue;
+    }
+
+    /* remember what is really installed, then check against the RIB */
+    olsr_kernel_route_to_rt(route, &rt->rt_nexthop, &rt->rt_metric);
+    if (!olsr_kernel_route_matches(rt, &rt->rt_nexthop, &rt->rt_metric)) {
+      olsr_enqueue_rt(&chg_kernel_list, rt);
+      changed++;
+    } else {
+      /* an adopted route is in place just like one olsrd added */
+      olsr_startup_first_route();
+    }
+  } OLSR_FOR_ALL_RT_ENTRIES_END(rt)
+
+  OLSR_PRINTF(1, "KERN: reconciled %u kernel routes, %u changed, %u added, %u removed\n",
+              (unsigned int)count, changed, added, removed);
+
+  olsr_chg_kernel_routes(&chg_kernel_list);
+}
+
+/*
+ * Read olsrd's routes from the kernel and reconcile them with the RIB.
+ *
+ * @return false if the kernel routes cannot be read or told apart from
+ *   routes of other sources
+ */
+static bool
+olsr_reconcile_kernel_routes(void)
+{
+  struct kernel_route_list list;
+
+  if (!olsr_kernel_routes_owned()) {
+    return false;
+  }
+
+  memset(&list, 0, sizeof(list));
+  if (olsr_os_dump_routes(olsr_cnf->ip_version, &olsr_collect_kernel_route, &list) != 0) {
+    free(list.routes);
+    return false;
+  }
+
+  olsr_reconcile_kernel_route_list(list.routes, list.count);
+  free(list.routes);
+  return true;
+}
+#endif /* __linux__ */
+
 void
 olsr_force_kernelroutes_refresh(void) {
   struct rt_entry *rt;
 
+#ifdef __linux__
+  /* only touch the routes that differ from the kernel */
+  if (olsr_reconcile_kernel_routes()) {
+    return;
+  }
+#endif /* __linux__ */
+
   /* enqueue all existing routes for a rewrite */
   OLSR_FOR_ALL_RT_ENTRIES(rt) {
     olsr_enqueue_rt(&chg_kernel_list, rt);
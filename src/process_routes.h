@@ -47,6 +47,7 @@
 #define _OLSR_PROCESS_RT
 
 #include "routing_table.h"
+#include "kernel_routes.h"
 #include <sys/ioctl.h>
 
 typedef int (*export_route_function) (const struct rt_entry *);
@@ -60,10 +61,17 @@ void olsr_init_export_route(void);
 void olsr_update_rib_routes(void);
 void olsr_update_kernel_routes(void);
 void olsr_delete_all_kernel_routes(void);
+void olsr_delete_held_kernel_routes(void);
+bool olsr_mark_kernel_routes(void);
+void olsr_start_kernel_route_sweep(void);
 uint8_t olsr_rt_flags(const struct rt_entry *, int add);
 void olsr_delete_interface_routes(int if_index);
 void olsr_force_kernelroutes_refresh(void);
 
+#ifdef __linux__
+void olsr_reconcile_kernel_route_list(struct olsr_os_route *routes, size_t count);
+#endif /* __linux__ */
+
 #endif /* _OLSR_PROCESS_RT */
 
 /*
@@ -74,6 +74,13 @@ static struct rt_path *current_inetgw = NULL;
 /* Root of our RIB */
 struct avl_tree routingtree;
 
+/*
+ * Kernel routes restored from a state checkpoint that have not been
+ * adopted by a RIB entry yet. The entries have no rt_path subtree,
+ * only rt_nexthop and rt_metric describe what is installed.
+ */
+struct avl_tree held_routingtree;
+
 /*
  * Keep a version number for detecting outdated elements
  * in the per rt_entry rt_path subtree.
@@ -174,6 +181,7 @@ olsr_init_routing_table(void)
 
   /* the routing tree */
   avl_init(&routingtree, avl_comp_prefix_default);
+  avl_init(&held_routingtree, avl_comp_prefix_default);
   routingtree_version = 0;
 
   /*
@@ -186,6 +194,42 @@ olsr_init_routing_table(void)
   olsr_cookie_set_memory_size(rtp_mem_cookie, sizeof(struct rt_path));
 }
 
+/**
+ * Remember a route that is still installed in the kernel from a
+ * previous run. It is adopted by the first RIB entry for the same
+ * prefix or removed by olsr_delete_held_kernel_routes().
+ *
+ * @param prefix the destination of the route
+ * @param nexthop the installed nexthop
+ * @param metric the installed metric
+ * @return a pointer to the held route or NULL
+ */
+struct rt_entry *
+olsr_hold_kernel_route(const struct olsr_ip_prefix *prefix, const struct rt_nexthop *nexthop, const struct rt_metric *metric)
+{
+  struct rt_entry *rt;
+
+  if (avl_find(&routingtree, prefix) || avl_find(&held_routingtree, prefix)) {
+    return NULL;
+  }
+
+  rt = olsr_cookie_malloc(rt_mem_cookie);
+  if (!rt) {
+    return NULL;
+  }
+
+  memset(rt, 0, sizeof(*rt));
+  rt->rt_dst = *prefix;
+  rt->rt_nexthop = *nexthop;
+  rt->rt_metric = *metric;
+  avl_init(&rt->rt_path_tree, avl_comp_default);
+
+  rt->rt_tree_node.key = &rt->rt_dst;
+  avl_insert(&held_routingtree, &rt->rt_tree_node, AVL_DUP_NO);
+
+  return rt;
+}
+
 /**
  * Look up a maxplen entry (= /32 or /128) in the routing table.
  *
@@ -235,6 +279,8 @@ static struct rt_entry *
 olsr_alloc_rt_entry(struct olsr_ip_prefix *prefix)
 {
   struct rt_entry *rt = olsr_cookie_malloc(rt_mem_cookie);
+  struct avl_node *held_node;
+
   if (!rt) {
     return NULL;
   }
@@ -244,6 +290,21 @@ olsr_alloc_rt_entry(struct olsr_ip_prefix *prefix)
   /* Mark this entry as fresh (see process_routes.c:512) */
   rt->rt_nexthop.iif_index = -1;
 
+  /*
+   * Adopt a kernel route that survived a restart, such that only
+   * a changed nexthop or metric results in a kernel operation.
+   */
+  held_node = avl_find(&held_routingtree, prefix);
+  if (held_node) {
+    struct rt_entry *held = rt_tree2rt(held_node);
+
+    rt->rt_nexthop = held->rt_nexthop;
+    rt->rt_metric = held->rt_metric;
+
+    avl_delete(&held_routingtree, held_node);
+    olsr_cookie_free(rt_mem_cookie, held);
+  }
+
   /* set key and backpointer prior to tree insertion */
   rt->rt_dst = *prefix;
 
@@ -191,6 +191,7 @@ union olsr_kernel_route {
 };
 
 extern struct avl_tree routingtree;
+extern struct avl_tree held_routingtree;
 extern unsigned int routingtree_version;
 extern struct olsr_cookie_info *rt_mem_cookie;
 
@@ -225,6 +226,7 @@ void olsr_update_rt_path(struct rt_path *, struct tc_entry *, struct link_entry
 void olsr_delete_rt_path(struct rt_path *);
 
 struct rt_entry *olsr_lookup_routing_table(const union olsr_ip_addr *);
+struct rt_entry *olsr_hold_kernel_route(const struct olsr_ip_prefix *, const struct rt_nexthop *, const struct rt_metric *);
 
 #endif /* _OLSR_ROUTING_TABLE */
 
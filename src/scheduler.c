@@ -43,6 +43,10 @@
  *
  */
 
+#ifdef __linux__
+#define _GNU_SOURCE 1                  /* dladdr() */
+#endif /* __linux__ */
+
 #include "scheduler.h"
 #include "log.h"
 #include "link_set.h"
@@ -51,13 +55,19 @@
 #include "net_os.h"
 #include "mpr_selector_set.h"
 #include "olsr_random.h"
+#include "olsr_reconfigure.h"
+#include "olsr_metrics.h"
 #include "common/avl.h"
+#include "common/string_handling.h"
 
 #include <sys/times.h>
 
 #include <unistd.h>
 #include <assert.h>
 #include <time.h>
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif /* _WIN32 */
 
 #ifdef __MACH__
 #include "mach/clock_gettime.h"
@@ -82,6 +92,9 @@ static struct olsr_cookie_info *timer_mem_cookie = NULL;
 /* Head of all OLSR used sockets */
 static struct list_node socket_head = { &socket_head, &socket_head };
 
+/* latency of a timer walk, registered on first use */
+static struct olsr_metric *walk_timers_metric = NULL;
+
 /* Prototypes */
 static void walk_timers(uint32_t *);
 static void walk_timers_cleanup(void);
@@ -206,6 +219,23 @@ olsr_getTimeDue(uint32_t s)
   return -(int32_t) (diff);
 }
 
+/**
+ * Returns the number of milliseconds until the timestamp will happen,
+ * 0 for an unset (0) or already expired timestamp
+ */
+
+uint32_t
+olsr_getTimeLeft(uint32_t s)
+{
+  int32_t due;
+
+  if (s == 0) {
+    return 0;
+  }
+  due = olsr_getTimeDue(s);
+  return due > 0 ? (uint32_t) due : 0;
+}
+
 bool
 olsr_isTimedOut(uint32_t s)
 {
@@ -325,6 +355,37 @@ olsr_flush_sockets(void)
   } OLSR_FOR_ALL_SOCKETS_END(entry);
 }
 
+/**
+ * @return the latency metric of the handlers of a socket, shared by all
+ * sockets of the same plugin (or of olsrd itself)
+ */
+static struct olsr_metric *
+socket_metric(struct olsr_socket_entry *entry, socket_handler_func handler)
+{
+  if (!entry->metric) {
+    char owner[64] = "olsrd";
+#ifndef _WIN32
+    Dl_info info;
+
+    if (dladdr((void *)handler, &info) && info.dli_fname) {
+      const char *file = strrchr(info.dli_fname, '/');
+      char *suffix;
+
+      strscpy(owner, file ? file + 1 : info.dli_fname, sizeof(owner));
+      suffix = strstr(owner, ".so");
+      if (suffix && suffix != owner) {
+        *suffix = '\0';
+      }
+    }
+#else /* _WIN32 */
+    (void)handler;
+#endif /* _WIN32 */
+    entry->metric = olsr_metric_get(OLSR_METRIC_LATENCY, "socket_callback",
+        "Socket handlers, per plugin or olsrd itself", "owner", owner);
+  }
+  return entry->metric;
+}
+
 static void
 poll_sockets(void)
 {
@@ -391,7 +452,13 @@ poll_sockets(void)
       flags |= SP_PR_WRITE;
     }
     if (flags != 0) {
-      entry->process_pollrate(entry->fd, entry->data, flags);
+      socket_handler_func handler = entry->process_pollrate;
+      uint64_t start = olsr_metrics_start();
+
+      handler(entry->fd, entry->data, flags);
+      if (start) {
+        olsr_metrics_stop(socket_metric(entry, handler), start);
+      }
     }
   }
   OLSR_FOR_ALL_SOCKETS_END(entry);
@@ -480,7 +547,13 @@ handle_fds(uint32_t next_interval)
         flags |= SP_IMM_WRITE;
       }
       if (flags != 0) {
-        entry->process_immediate(entry->fd, entry->data, flags);
+        socket_handler_func handler = entry->process_immediate;
+        uint64_t start = olsr_metrics_start();
+
+        handler(entry->fd, entry->data, flags);
+        if (start) {
+          olsr_metrics_stop(socket_metric(entry, handler), start);
+        }
       }
     }
     OLSR_FOR_ALL_SOCKETS_END(entry);
@@ -563,6 +636,9 @@ void olsr_scheduler(void)
       break;
     }
 
+    /* Apply a configuration reload requested by SIGHUP */
+    olsr_reconfigure_check();
+
     /* Update */
     olsr_process_changes();
 
@@ -663,6 +739,7 @@ walk_timers(uint32_t * last_run)
 {
   unsigned int total_timers_walked = 0, total_timers_fired = 0;
   unsigned int wheel_slot_walks = 0;
+  uint64_t start = olsr_metrics_start();
 
   /*
    * Check the required wheel slots since the last time a timer walk was invoked,
@@ -753,6 +830,14 @@ walk_timers(uint32_t * last_run)
    * reset the last timer run.
    */
   *last_run = now_times;
+
+  if (start) {
+    if (!walk_timers_metric) {
+      walk_timers_metric = olsr_metric_get(OLSR_METRIC_LATENCY, "walk_timers",
+          "Walks of the timer wheel, including the timer callbacks", NULL, NULL);
+    }
+    olsr_metrics_stop(walk_timers_metric, start);
+  }
 }
 
 static void walk_timers_cleanup(void) {
@@ -143,6 +143,7 @@ struct olsr_socket_entry {
   socket_handler_func process_pollrate;
   void *data;
   unsigned int flags;
+  struct olsr_metric *metric;          /* latency of the handlers, registered on first use */
   struct list_node socket_node;
 };
 
@@ -162,6 +163,7 @@ LISTNODE2STRUCT(list2socket, struct olsr_socket_entry, socket_node);
 uint32_t olsr_times(void);
 uint32_t olsr_getTimestamp (uint32_t s);
 int32_t olsr_getTimeDue (uint32_t s);
+uint32_t olsr_getTimeLeft (uint32_t s);
 bool olsr_isTimedOut (uint32_t s);
 
 void add_olsr_socket (int fd, socket_handler_func pf_pr, socket_handler_func pf_imm, void *data, unsigned int flags);
@@ -70,6 +70,15 @@ struct olsr_cookie_info *tc_validity_timer_cookie = NULL;
 struct olsr_cookie_info *tc_edge_mem_cookie = NULL;
 struct olsr_cookie_info *tc_mem_cookie = NULL;
 
+/* Edges changed since the last SPF run */
+static struct tc_edge_change *tc_edge_changes = NULL;
+static unsigned int tc_edge_change_count = 0;
+static unsigned int tc_edge_change_size = 0;
+
+/* Scratch list of edges that may be revoked by the TC being processed */
+static struct tc_edge_entry **tc_edge_revoked = NULL;
+static unsigned int tc_edge_revoked_size = 0;
+
 /*
  * Sven-Ola 2007-Dec: These four constants include an assumption
  * on how long a typical olsrd mesh memorizes (TC) messages in the
@@ -94,6 +103,59 @@ struct olsr_cookie_info *tc_mem_cookie = NULL;
 /* Enlarges the value window for upcoming ansn/seqno to be accepted */
 #define TC_SEQNO_WINDOW_MULT 8
 
+/**
+ * Record a change of an edge for the next SPF run.
+ * Edges of our own TC entry are maintained by SPF itself
+ * and are not recorded.
+ *
+ * @param tc_edge the changed edge
+ * @param type the kind of change
+ * @param old_cost the cost of the edge before the change
+ */
+static void
+olsr_record_tc_edge_change(struct tc_edge_entry *tc_edge, enum tc_edge_change_type type, olsr_linkcost old_cost)
+{
+  struct tc_edge_change *change;
+
+  if (tc_edge->tc == tc_myself) {
+    return;
+  }
+
+  if (tc_edge_change_count == tc_edge_change_size) {
+    tc_edge_change_size = tc_edge_change_size ? 2 * tc_edge_change_size : 32;
+    tc_edge_changes = olsr_realloc(tc_edge_changes, tc_edge_change_size * sizeof(*tc_edge_changes), "TC edge changes");
+  }
+
+  change = &tc_edge_changes[tc_edge_change_count++];
+  change->originator = tc_edge->tc->addr;
+  change->dest = tc_edge->T_dest_addr;
+  change->old_cost = old_cost;
+  change->type = type;
+}
+
+/**
+ * Get the edges that were added, changed or deleted since
+ * the last SPF run.
+ *
+ * @param count pointer to the number of returned changes
+ * @return the array of changes
+ */
+const struct tc_edge_change *
+olsr_get_tc_edge_changes(unsigned int *count)
+{
+  *count = tc_edge_change_count;
+  return tc_edge_changes;
+}
+
+/**
+ * Forget the recorded edge changes, called after each SPF run.
+ */
+void
+olsr_clear_tc_edge_changes(void)
+{
+  tc_edge_change_count = 0;
+}
+
 static bool
 olsr_seq_inrange_low(int beg, int end, uint16_t seq)
 {
@@ -217,6 +279,15 @@ void olsr_delete_all_tc_entries(void) {
   OLSR_FOR_ALL_TC_ENTRIES(tc) {
     olsr_delete_tc_entry(tc);
   } OLSR_FOR_ALL_TC_ENTRIES_END(tc)
+
+  free(tc_edge_changes);
+  tc_edge_changes = NULL;
+  tc_edge_change_count = 0;
+  tc_edge_change_size = 0;
+
+  free(tc_edge_revoked);
+  tc_edge_revoked = NULL;
+  tc_edge_revoked_size = 0;
 }
 
 /**
@@ -399,7 +470,7 @@ olsr_expire_tc_edge_gc(void *context)
   tc->edge_gc_timer = NULL;
 
   if (olsr_delete_outdated_tc_edges(tc)) {
-    changes_topology = true;
+    changes_tc_edges = true;
   }
 }
 
@@ -491,6 +562,7 @@ olsr_add_tc_edge_entry(struct tc_entry *tc, union olsr_ip_addr *addr, uint16_t a
    * Update the etx.
    */
   olsr_calc_tc_edge_entry_etx(tc_edge);
+  olsr_record_tc_edge_change(tc_edge, TC_EDGE_ADDED, LINK_COST_BROKEN);
 
 #ifdef DEBUG
   OLSR_PRINTF(1, "TC: add edge entry %s\n", olsr_tc_edge_to_string(tc_edge));
@@ -514,6 +586,8 @@ olsr_delete_tc_edge_entry(struct tc_edge_entry *tc_edge)
   OLSR_PRINTF(1, "TC: del edge entry %s\n", olsr_tc_edge_to_string(tc_edge));
 #endif /* DEBUG */
 
+  olsr_record_tc_edge_change(tc_edge, TC_EDGE_DELETED, tc_edge->cost);
+
   tc = tc_edge->tc;
   avl_delete(&tc->edge_tree, &tc_edge->edge_node);
   olsr_unlock_tc_entry(tc);
@@ -552,77 +626,22 @@ olsr_delete_outdated_tc_edges(struct tc_entry *tc)
   return retval;
 }
 
-/**
- * Delete all destinations that are inside the borders but
- * not updated in the last tc.
- *
- * @param tc the entry to delete edges from
- * @param ansn the advertised neighbor set sequence number
- * @param lower_border the lower border
- * @param upper_border the upper border
- * @return 1 if any destinations were deleted 0 if not
- */
-static int
-olsr_delete_revoked_tc_edges(struct tc_entry *tc, uint16_t ansn, union olsr_ip_addr *lower_border, union olsr_ip_addr *upper_border)
-{
-  struct tc_edge_entry *tc_edge;
-  int retval = 0;
-
-  bool passedLowerBorder = false;
-
-  OLSR_FOR_ALL_TC_EDGE_ENTRIES(tc, tc_edge) {
-    if (!passedLowerBorder) {
-      if (avl_comp_default(lower_border, &tc_edge->T_dest_addr) <= 0) {
-        passedLowerBorder = true;
-      } else {
-        continue;
-      }
-    }
-
-    if (passedLowerBorder) {
-      if (avl_comp_default(upper_border, &tc_edge->T_dest_addr) <= 0) {
-        break;
-      }
-    }
-
-    if (SEQNO_GREATER_THAN(ansn, tc_edge->ansn)) {
-      olsr_delete_tc_edge_entry(tc_edge);
-      retval = 1;
-    }
-  }
-  OLSR_FOR_ALL_TC_EDGE_ENTRIES_END(tc, tc_edge);
-
-  if (retval)
-    changes_topology = true;
-  return retval;
-}
-
 /**
  * Update an edge registered on an entry.
- * Creates new edge-entries if not registered.
+ * Creates a new edge-entry if not registered.
  * Bases update on a received TC message
  *
  * @param tc the TC entry to check
  * @param ansn the ansn of the edge
- * @param curr pointer to the packet
+ * @param curr pointer to the packet, positioned behind the neighbor address
  * @param neighbor the neighbor of the edge
- * @return 1 if entries are added 0 if not
+ * @param tc_edge the registered edge or NULL if not registered
  */
-static int
-olsr_tc_update_edge(struct tc_entry *tc, uint16_t ansn, const unsigned char **curr, union olsr_ip_addr *neighbor)
+static void
+olsr_tc_update_edge(struct tc_entry *tc, uint16_t ansn, const unsigned char **curr, union olsr_ip_addr *neighbor,
+                    struct tc_edge_entry *tc_edge)
 {
-  struct tc_edge_entry *tc_edge;
-  int edge_change;
-
-  edge_change = 0;
-
-  /*
-   * Fetch the per-edge data
-   */
-  pkt_get_ipaddress(curr, neighbor);
-
-  /* First check if we know this edge */
-  tc_edge = olsr_lookup_tc_edge(tc, neighbor);
+  olsr_linkcost old_cost;
 
   if (!tc_edge) {
 
@@ -631,43 +650,106 @@ olsr_tc_update_edge(struct tc_entry *tc, uint16_t ansn, const unsigned char **cu
      * Check if the address is allowed.
      */
     if (!olsr_validate_address(neighbor)) {
-      return 0;
+      return;
     }
 
     tc_edge = olsr_add_tc_edge_entry(tc, neighbor, ansn);
 
     olsr_deserialize_tc_lq_pair(curr, tc_edge);
-    edge_change = 1;
-
-  } else {
+    olsr_calc_tc_edge_entry_etx(tc_edge);
+    return;
+  }
 
-    /*
-     * We know this edge - Update entry.
-     */
-    tc_edge->ansn = ansn;
+  /*
+   * We know this edge - Update entry.
+   */
+  tc_edge->ansn = ansn;
+  old_cost = tc_edge->cost;
 
-    /*
-     * Update link quality if configured.
-     */
-    if (olsr_cnf->lq_level > 0) {
-      olsr_deserialize_tc_lq_pair(curr, tc_edge);
-    }
+  /*
+   * Update link quality if configured.
+   */
+  if (olsr_cnf->lq_level > 0) {
+    olsr_deserialize_tc_lq_pair(curr, tc_edge);
+  }
 
-    /*
-     * Update the etx.
-     */
-    if (olsr_calc_tc_edge_entry_etx(tc_edge)) {
-      edge_change = 1;
-    }
+  /*
+   * Update the etx. Only a change that SPF can notice is recorded,
+   * a broken edge stays broken regardless of its exact cost.
+   */
+  olsr_calc_tc_edge_entry_etx(tc_edge);
+  if (tc_edge->cost != old_cost && (tc_edge->cost < LINK_COST_BROKEN || old_cost < LINK_COST_BROKEN)) {
+    olsr_record_tc_edge_change(tc_edge, TC_EDGE_CHANGED, old_cost);
 #if defined DEBUG && DEBUG
-    if (edge_change) {
-      OLSR_PRINTF(1, "TC:   chg edge entry %s\n", olsr_tc_edge_to_string(tc_edge));
-    }
+    OLSR_PRINTF(1, "TC:   chg edge entry %s\n", olsr_tc_edge_to_string(tc_edge));
 #endif /* defined DEBUG && DEBUG */
+  }
+}
+
+/**
+ * Restore a TC entry from a state checkpoint.
+ *
+ * @param adr the originator of the TC entry
+ * @param msg_seq the sequence number of the last TC message
+ * @param ansn the ANSN of the last TC message
+ * @param msg_hops the hopcount of the last TC message
+ * @param vtime the remaining validity time
+ * @return a pointer to the restored entry or NULL
+ */
+struct tc_entry *
+olsr_restore_tc_entry(union olsr_ip_addr *adr, uint16_t msg_seq, uint16_t ansn, uint8_t msg_hops, olsr_reltime vtime)
+{
+  struct tc_entry *tc;
+
+  if (ipequal(adr, &olsr_cnf->main_addr) || !olsr_validate_address(adr)) {
+    return NULL;
+  }
+
+  tc = olsr_locate_tc_entry(adr);
+  if (!tc) {
+    return NULL;
+  }
+
+  tc->msg_seq = msg_seq;
+  tc->ansn = ansn;
+  tc->msg_hops = msg_hops;
+
+  olsr_set_timer(&tc->validity_timer, vtime, OLSR_TC_VTIME_JITTER, OLSR_TIMER_ONESHOT, &olsr_expire_tc_entry, tc,
+                 tc_validity_timer_cookie);
+  return tc;
+}
+
+/**
+ * Restore an edge of a TC entry from a state checkpoint.
+ *
+ * @param tc the TC entry
+ * @param addr the destination of the edge
+ * @param ansn the ANSN of the edge
+ * @param lq the link quality in TC message format
+ * @return a pointer to the restored edge or NULL
+ */
+struct tc_edge_entry *
+olsr_restore_tc_edge(struct tc_entry *tc, union olsr_ip_addr *addr, uint16_t ansn, const uint8_t *lq)
+{
+  struct tc_edge_entry *tc_edge;
 
+  tc_edge = olsr_lookup_tc_edge(tc, addr);
+  if (!tc_edge) {
+    if (!olsr_validate_address(addr)) {
+      return NULL;
+    }
+    tc_edge = olsr_add_tc_edge_entry(tc, addr, ansn);
+    if (!tc_edge) {
+      return NULL;
+    }
   }
 
-  return edge_change;
+  tc_edge->ansn = ansn;
+  if (olsr_cnf->lq_level > 0) {
+    olsr_deserialize_tc_lq_pair(&lq, tc_edge);
+  }
+  olsr_calc_tc_edge_entry_etx(tc_edge);
+  return tc_edge;
 }
 
 /**
@@ -761,6 +843,134 @@ olsr_calculate_tc_border(uint8_t lower_border, union olsr_ip_addr *lower_border_
   return 1;
 }
 
+/*
+ * Queue an edge that was not advertised in the TC being processed
+ * for revocation.
+ */
+static void
+olsr_tc_queue_revoked_edge(struct tc_edge_entry *tc_edge, unsigned int *count)
+{
+  if (*count == tc_edge_revoked_size) {
+    tc_edge_revoked_size = tc_edge_revoked_size ? 2 * tc_edge_revoked_size : 32;
+    tc_edge_revoked = olsr_realloc(tc_edge_revoked, tc_edge_revoked_size * sizeof(*tc_edge_revoked), "TC revoked edges");
+  }
+  tc_edge_revoked[(*count)++] = tc_edge;
+}
+
+/*
+ * Merge the neighbor set of a TC message into the edge tree of its tc entry.
+ *
+ * create_lq_tc() sends the neighbors sorted by address, so a single
+ * walk along the edge tree finds the registered edges, inserts the
+ * new ones and collects the edges that are no longer advertised.
+ * Neighbors that are out of order are looked up in the tree instead.
+ * The collected edges are deleted if they are within the borders of
+ * the message and did not get the new ANSN.
+ *
+ * @param tc the tc entry of the originator
+ * @param ansn the ANSN of the message
+ * @param curr pointer to the first neighbor in the message
+ * @param limit end of the message
+ * @param lower_border lower border flag of the message
+ * @param upper_border upper border flag of the message
+ * @return true if the borders were set and edges outside the message revoked
+ */
+static bool
+olsr_tc_merge_edges(struct tc_entry *tc, uint16_t ansn, const unsigned char *curr, const unsigned char *limit,
+                    uint8_t lower_border, uint8_t upper_border)
+{
+  union olsr_ip_addr neighbor, merged, lower_border_ip, upper_border_ip;
+  struct avl_node *edge_node;
+  struct tc_edge_entry *tc_edge;
+  bool emptyTC, merging, revoke;
+  unsigned int revoked, i;
+  int diff;
+
+  edge_node = avl_walk_first(&tc->edge_tree);
+  emptyTC = curr >= limit;
+  merging = false;
+  revoke = lower_border != 0 || upper_border != 0;
+  revoked = 0;
+  diff = 0;
+
+  while (curr < limit) {
+    pkt_get_ipaddress(&curr, &neighbor);
+
+    if (!merging) {
+      /* first neighbor of the message */
+      lower_border_ip = neighbor;
+      merging = true;
+    } else if (avl_comp_default(&neighbor, &merged) <= 0) {
+
+      /*
+       * Out of order, the walk is already past this neighbor.
+       */
+      upper_border_ip = neighbor;
+      olsr_tc_update_edge(tc, ansn, &curr, &neighbor, olsr_lookup_tc_edge(tc, &neighbor));
+      continue;
+    }
+    merged = neighbor;
+    upper_border_ip = neighbor;
+
+    /*
+     * Skip the edges in front of this neighbor, they are not advertised.
+     */
+    while (edge_node && (diff = avl_comp_default(edge_node->key, &neighbor)) < 0) {
+      tc_edge = edge_tree2tc_edge(edge_node);
+      if (revoke && SEQNO_GREATER_THAN(ansn, tc_edge->ansn)) {
+        olsr_tc_queue_revoked_edge(tc_edge, &revoked);
+      }
+      edge_node = avl_walk_next(edge_node);
+    }
+
+    tc_edge = NULL;
+    if (edge_node && diff == 0) {
+      tc_edge = edge_tree2tc_edge(edge_node);
+      edge_node = avl_walk_next(edge_node);
+    }
+    olsr_tc_update_edge(tc, ansn, &curr, &neighbor, tc_edge);
+  }
+
+  /*
+   * Calculate real border IPs.
+   */
+  if (!emptyTC) {
+    if (!revoke || !olsr_calculate_tc_border(lower_border, &lower_border_ip, upper_border, &upper_border_ip)) {
+      return false;
+    }
+  } else if (lower_border == 0xff && upper_border == 0xff) {
+    /* handle empty TC with border flags 0xff */
+    memset(&lower_border_ip, 0x00, sizeof(lower_border_ip));
+    memset(&upper_border_ip, 0xff, sizeof(upper_border_ip));
+  } else {
+    return false;
+  }
+
+  /*
+   * Collect the remaining edges up to the upper border.
+   */
+  for (; edge_node && avl_comp_default(&upper_border_ip, edge_node->key) > 0; edge_node = avl_walk_next(edge_node)) {
+    tc_edge = edge_tree2tc_edge(edge_node);
+    if (SEQNO_GREATER_THAN(ansn, tc_edge->ansn)) {
+      olsr_tc_queue_revoked_edge(tc_edge, &revoked);
+    }
+  }
+
+  /*
+   * Delete all old tc edges within borders. The ANSN is checked again
+   * as an out of order neighbor may have refreshed a collected edge.
+   */
+  for (i = 0; i < revoked; i++) {
+    tc_edge = tc_edge_revoked[i];
+    if (avl_comp_default(&lower_border_ip, &tc_edge->T_dest_addr) <= 0
+        && avl_comp_default(&upper_border_ip, &tc_edge->T_dest_addr) > 0
+        && SEQNO_GREATER_THAN(ansn, tc_edge->ansn)) {
+      olsr_delete_tc_edge_entry(tc_edge);
+    }
+  }
+  return true;
+}
+
 /*
  * Process an incoming TC or TC_LQ message.
  *
@@ -781,10 +991,8 @@ olsr_input_tc(union olsr_message * msg, struct interface_olsr * input_if __attri
   union olsr_ip_addr originator;
   const unsigned char *limit, *curr;
   struct tc_entry *tc;
-  bool emptyTC;
-
-  union olsr_ip_addr lower_border_ip, upper_border_ip;
-  int borderSet = 0;
+  bool emptyTC, borderSet;
+  unsigned int changes;
 
   curr = (void *)msg;
   if (!msg) {
@@ -879,28 +1087,15 @@ olsr_input_tc(union olsr_message * msg, struct interface_olsr * input_if __attri
   OLSR_PRINTF(1, "Processing TC from %s, seq 0x%04x\n", olsr_ip_to_string(&buf, &originator), tc->msg_seq);
 
   /*
-   * Now walk the edge advertisements contained in the packet.
+   * Now merge the edge advertisements contained in the packet.
+   * Only trigger SPF if an edge was added, revoked or changed its cost.
    */
-
   limit = (unsigned char *)msg + size;
-  borderSet = 0;
   emptyTC = curr >= limit;
-  while (curr < limit) {
-    if (olsr_tc_update_edge(tc, ansn, &curr, &upper_border_ip)) {
-      changes_topology = true;
-    }
-
-    if (!borderSet) {
-      borderSet = 1;
-      memcpy(&lower_border_ip, &upper_border_ip, sizeof(lower_border_ip));
-    }
-  }
-
-  /*
-   * Calculate real border IPs.
-   */
-  if (borderSet) {
-    borderSet = olsr_calculate_tc_border(lower_border, &lower_border_ip, upper_border, &upper_border_ip);
+  changes = tc_edge_change_count;
+  borderSet = olsr_tc_merge_edges(tc, ansn, curr, limit, lower_border, upper_border);
+  if (tc_edge_change_count != changes) {
+    changes_tc_edges = true;
   }
 
   /*
@@ -909,20 +1104,7 @@ olsr_input_tc(union olsr_message * msg, struct interface_olsr * input_if __attri
   olsr_set_timer(&tc->validity_timer, vtime, OLSR_TC_VTIME_JITTER, OLSR_TIMER_ONESHOT, &olsr_expire_tc_entry, tc,
                  tc_validity_timer_cookie);
 
-  if (emptyTC && lower_border == 0xff && upper_border == 0xff) {
-    /* handle empty TC with border flags 0xff */
-    memset(&lower_border_ip, 0x00, sizeof(lower_border_ip));
-    memset(&upper_border_ip, 0xff, sizeof(upper_border_ip));
-    borderSet = 1;
-  }
-
-  if (borderSet) {
-
-    /*
-     * Delete all old tc edges within borders.
-     */
-    olsr_delete_revoked_tc_edges(tc, ansn, &lower_border_ip, &upper_border_ip);
-  } else {
+  if (!borderSet) {
 
     /*
      * Kick the the edge garbage collection timer. In the meantime hopefully
@@ -71,6 +71,23 @@ struct tc_edge_entry {
 
 AVLNODE2STRUCT(edge_tree2tc_edge, struct tc_edge_entry, edge_node);
 
+enum tc_edge_change_type {
+  TC_EDGE_ADDED,
+  TC_EDGE_CHANGED,
+  TC_EDGE_DELETED
+};
+
+/*
+ * An edge of the link state database that was added, changed
+ * or deleted since the last SPF run.
+ */
+struct tc_edge_change {
+  union olsr_ip_addr originator;       /* address of the owning tc entry */
+  union olsr_ip_addr dest;             /* destination of the edge */
+  olsr_linkcost old_cost;              /* cost before the change, LINK_COST_BROKEN if added */
+  enum tc_edge_change_type type;
+};
+
 struct tc_entry {
   struct avl_node vertex_node;         /* node keyed by ip address */
   union olsr_ip_addr addr;             /* vertex_node key */
@@ -172,6 +189,14 @@ void olsr_delete_tc_entry(struct tc_entry *);
 void olsr_delete_tc_edge_entry(struct tc_edge_entry *);
 bool olsr_calc_tc_edge_entry_etx(struct tc_edge_entry *);
 void olsr_set_tc_edge_timer(struct tc_edge_entry *, unsigned int);
+
+/* edge changes since the last SPF run */
+const struct tc_edge_change *olsr_get_tc_edge_changes(unsigned int *);
+void olsr_clear_tc_edge_changes(void);
+
+/* state checkpoint restore */
+struct tc_entry *olsr_restore_tc_entry(union olsr_ip_addr *, uint16_t, uint16_t, uint8_t, olsr_reltime);
+struct tc_edge_entry *olsr_restore_tc_edge(struct tc_entry *, union olsr_ip_addr *, uint16_t, const uint8_t *);
 // static bool olsr_etx_significant_change(float, float);
 
 #endif /* _OLSR_TOP_SET */
@@ -48,6 +48,7 @@
 #include "defs.h"
 #include "mid_set.h"
 #include "neighbor_table.h"
+#include "mpr.h"
 #include "net_olsr.h"
 #include "scheduler.h"
 
@@ -86,6 +87,9 @@ olsr_delete_neighbor_pointer(struct neighbor_2_entry *two_hop_entry, struct neig
       struct neighbor_list_entry *entry_to_delete = entry;
       entry = entry->next;
 
+      olsr_mpr_forget_choice(entry_to_delete);
+      olsr_mpr_dirty_two_hop(two_hop_entry);
+
       /* dequeue */
       DEQUEUE_ELEM(entry_to_delete);
 
@@ -117,10 +121,13 @@ olsr_delete_two_hop_neighbor_table(struct neighbor_2_entry *two_hop_neighbor)
 
     olsr_delete_neighbor_2_pointer(one_hop_entry, two_hop_neighbor);
     one_hop_list = one_hop_list->next;
+    olsr_mpr_forget_choice(entry_to_delete);
     /* no need to dequeue */
     free(entry_to_delete);
   }
 
+  olsr_mpr_forget_two_hop(two_hop_neighbor);
+
   /* dequeue */
   DEQUEUE_ELEM(two_hop_neighbor);
   free(two_hop_neighbor);
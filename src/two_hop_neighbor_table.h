@@ -50,6 +50,7 @@
 #include "hashing.h"
 #include "lq_plugin.h"
 #include "olsr_types.h"
+#include "common/list.h"
 
 #define	NB2S_COVERED 	0x1     /* node has been covered by a MPR */
 
@@ -58,6 +59,8 @@ struct neighbor_list_entry {
   olsr_linkcost second_hop_linkcost;
   olsr_linkcost path_linkcost;
   olsr_linkcost saved_path_linkcost;
+  olsr_linkcost mpr_path_linkcost;     /* path_linkcost seen by the last LQ MPR selection */
+  bool mpr_selected;                   /* neighbor is selected as LQ MPR for this 2 hop neighbor */
   struct neighbor_list_entry *next;
   struct neighbor_list_entry *prev;
 };
@@ -67,6 +70,8 @@ struct neighbor_2_entry {
   uint8_t mpr_covered_count;           /*used in mpr calculation */
   uint8_t processed;                   /*used in mpr calculation */
   int16_t neighbor_2_pointer;          /* Neighbor count */
+  struct list_node mpr_dirty_node;     /* queued for MPR reselection */
+  struct list_node mpr_direct_node;    /* also a symmetric neighbor, used in LQ MPR selection */
   struct neighbor_list_entry neighbor_2_nblist;
   struct neighbor_2_entry *prev;
   struct neighbor_2_entry *next;
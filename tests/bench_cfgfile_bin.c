@@ -0,0 +1,303 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Benchmark of loading a binary configuration file against parsing its
+ * text: microseconds per olsrd_parse_cnf() of a configuration with many
+ * interfaces, link quality multipliers, HNAs, IPC nets and plugin
+ * parameters. The scanner is replaced by a generated list of tokens, so
+ * the text numbers leave out the cost of flex and are a lower bound.
+ *
+ * usage: bench_cfgfile_bin [loads]
+ */
+
+#define YYSTYPE struct conf_token *
+
+#include "harness.h"
+#include "olsr_cfg.h"
+#include "cfgparser/olsrd_conf.h"
+#include "cfgparser/olsrd_conf_checksum.h"
+#include "cfgparser/oparse.h"
+#include "common/string_handling.h"
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+
+#define BENCH_INTERFACES 32
+#define BENCH_LQ_MULTS 4
+#define BENCH_HNAS 256
+#define BENCH_PLUGINS 4
+#define BENCH_PLUGIN_PARAMS 16
+
+enum stub_kind {
+  STUB_KEYWORD,
+  STUB_INTEGER,
+  STUB_FLOAT,
+  STUB_STRING,
+  STUB_WORD
+};
+
+struct stub_token {
+  int token;
+  enum stub_kind kind;
+  char text[32];
+};
+
+static struct stub_token *script;
+static unsigned int script_len;
+static unsigned int script_pos;
+
+static void
+add(int token, enum stub_kind kind, const char *text)
+{
+  struct stub_token *t;
+
+  script = realloc(script, (script_len + 1) * sizeof(*script));
+  t = &script[script_len++];
+  t->token = token;
+  t->kind = kind;
+  strscpy(t->text, text, sizeof(t->text));
+}
+
+static void
+build_script(void)
+{
+  char text[32];
+  int i, j;
+
+  add(TOK_DEBUGLEVEL, STUB_KEYWORD, "DebugLevel");
+  add(TOK_INTEGER, STUB_INTEGER, "0");
+  add(TOK_LOCK_FILE, STUB_KEYWORD, "LockFile");
+  add(TOK_STRING, STUB_STRING, "\"/var/run/olsrd.lock\"");
+
+  add(TOK_HNA4, STUB_KEYWORD, "Hna4");
+  add(TOK_OPEN, STUB_KEYWORD, "{");
+  for (i = 0; i < BENCH_HNAS; i++) {
+    snprintf(text, sizeof(text), "10.%d.%d.0", i / 256, i % 256);
+    add(TOK_IPV4_ADDR, STUB_WORD, text);
+    add(TOK_IPV4_ADDR, STUB_WORD, "255.255.255.0");
+  }
+  add(TOK_CLOSE, STUB_KEYWORD, "}");
+
+  add(TOK_IPCCON, STUB_KEYWORD, "IpcConnect");
+  add(TOK_OPEN, STUB_KEYWORD, "{");
+  for (i = 0; i < 16; i++) {
+    snprintf(text, sizeof(text), "192.168.%d.0", i);
+    add(TOK_NETLABEL, STUB_KEYWORD, "Net");
+    add(TOK_IPV4_ADDR, STUB_WORD, text);
+    add(TOK_IPV4_ADDR, STUB_WORD, "255.255.255.0");
+  }
+  add(TOK_CLOSE, STUB_KEYWORD, "}");
+
+  for (i = 0; i < BENCH_INTERFACES; i++) {
+    add(TOK_INTERFACE, STUB_KEYWORD, "Interface");
+    snprintf(text, sizeof(text), "\"wlan%d\"", i);
+    add(TOK_STRING, STUB_STRING, text);
+    add(TOK_OPEN, STUB_KEYWORD, "{");
+    add(TOK_HELLOINT, STUB_KEYWORD, "HelloInterval");
+    add(TOK_FLOAT, STUB_FLOAT, "3.0");
+    add(TOK_TCINT, STUB_KEYWORD, "TcInterval");
+    add(TOK_FLOAT, STUB_FLOAT, "4.0");
+    for (j = 0; j < BENCH_LQ_MULTS; j++) {
+      snprintf(text, sizeof(text), "172.16.%d.%d", i, j + 1);
+      add(TOK_LQ_MULT, STUB_KEYWORD, "LinkQualityMult");
+      add(TOK_IPV4_ADDR, STUB_WORD, text);
+      add(TOK_FLOAT, STUB_FLOAT, "0.5");
+    }
+    add(TOK_CLOSE, STUB_KEYWORD, "}");
+  }
+
+  for (i = 0; i < BENCH_PLUGINS; i++) {
+    add(TOK_PLUGIN, STUB_KEYWORD, "LoadPlugin");
+    snprintf(text, sizeof(text), "\"olsrd_plugin%d.so.0.1\"", i);
+    add(TOK_STRING, STUB_STRING, text);
+    add(TOK_OPEN, STUB_KEYWORD, "{");
+    for (j = 0; j < BENCH_PLUGIN_PARAMS; j++) {
+      add(TOK_PLPARAM, STUB_KEYWORD, "PlParam");
+      snprintf(text, sizeof(text), "\"Key%d\"", j);
+      add(TOK_STRING, STUB_STRING, text);
+      snprintf(text, sizeof(text), "\"value %d\"", j);
+      add(TOK_STRING, STUB_STRING, text);
+    }
+    add(TOK_CLOSE, STUB_KEYWORD, "}");
+  }
+}
+
+int
+olsrd_cnf_scan(void)
+{
+  const struct stub_token *t;
+  struct conf_token *value = NULL;
+
+  if (script_pos >= script_len) {
+    return 0;
+  }
+  t = &script[script_pos++];
+
+  olsrd_config_checksum_add(t->text, strlen(t->text));
+  if (t->kind != STUB_KEYWORD) {
+    value = calloc(1, sizeof(*value));
+    if (value == NULL) {
+      return 0;
+    }
+    if (t->kind == STUB_INTEGER) {
+      value->integer = strtol(t->text, NULL, 0);
+    } else if (t->kind == STUB_FLOAT) {
+      sscanf(t->text, "%f", &value->floating);
+    } else if (t->kind == STUB_STRING) {
+      value->string = strndup(t->text + 1, strlen(t->text) - 2);
+    } else {
+      value->string = strdup(t->text);
+    }
+  }
+  yylval = value;
+  return t->token;
+}
+
+char *
+yyget_text(void)
+{
+  return script_pos > 0 ? script[script_pos - 1].text : NULL;
+}
+
+/* parse a configuration file into a fresh olsr_cnf and free it again */
+static uint64_t
+bench_parse(const char *filename, long loads)
+{
+  int saved_stdout = dup(STDOUT_FILENO), saved_stderr = dup(STDERR_FILENO);
+  int null_fd = open("/dev/null", O_WRONLY);
+  uint64_t start;
+  long i;
+
+  /* the parser reports every setting it reads */
+  fflush(stdout);
+  dup2(null_fd, STDOUT_FILENO);
+  dup2(null_fd, STDERR_FILENO);
+  start = harness_clock_ns();
+  for (i = 0; i < loads; i++) {
+    olsr_cnf = olsrd_get_default_cnf(strdup(filename));
+    olsrd_config_checksum_init();
+    script_pos = 0;
+    CHECK(olsrd_parse_cnf(filename) == 0);
+    olsrd_free_cnf(&olsr_cnf);
+  }
+  fflush(stdout);
+  start = harness_clock_ns() - start;
+  dup2(saved_stdout, STDOUT_FILENO);
+  dup2(saved_stderr, STDERR_FILENO);
+  close(saved_stdout);
+  close(saved_stderr);
+  close(null_fd);
+  return start / (uint64_t)loads;
+}
+
+int
+main(int argc, char **argv)
+{
+  long loads = argc > 1 ? atol(argv[1]) : 2000;
+  char dir[] = "/tmp/olsrd_test_XXXXXX";
+  char conffile[sizeof(dir) + 16], binfile[sizeof(dir) + 16];
+  uint64_t text_ns, binary_ns;
+  FILE *f;
+
+  if (loads < 1) {
+    fprintf(stderr, "usage: %s [loads]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  build_script();
+  CHECK(mkdtemp(dir) != NULL);
+  snprintf(conffile, sizeof(conffile), "%s/olsrd.conf", dir);
+  snprintf(binfile, sizeof(binfile), "%s/olsrd.bin", dir);
+
+  /* the text is never read, olsrd_parse_cnf() only opens it */
+  f = fopen(conffile, "w");
+  CHECK(f != NULL);
+  if (f != NULL) {
+    fclose(f);
+  }
+
+  olsr_cnf = olsrd_get_default_cnf(strdup(conffile));
+  olsrd_config_checksum_init();
+  CHECK(olsrd_compile_cnf(conffile, binfile) == 0);
+  olsrd_free_cnf(&olsr_cnf);
+  fflush(stdout);
+
+  text_ns = bench_parse(conffile, loads);
+  binary_ns = bench_parse(binfile, loads);
+
+  printf("%u tokens: text %.1f us, binary %.1f us per load (%.1fx)\n", script_len, text_ns / 1000.0, binary_ns / 1000.0,
+         (double)text_ns / (double)(binary_ns ? binary_ns : 1));
+
+  unlink(binfile);
+  unlink(conffile);
+  rmdir(dir);
+  free(script);
+
+  return harness_result("bench_cfgfile_bin");
+}
+
+#else /* __linux__ */
+
+int
+main(void)
+{
+  printf("bench_cfgfile_bin: skipped\n");
+  return 0;
+}
+
+#endif /* __linux__ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
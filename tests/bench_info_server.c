@@ -0,0 +1,389 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Benchmark of the info plugin server modes: requests per second and
+ * jitter of the olsrd main loop while concurrent clients fetch the
+ * topology from txtinfo.
+ *
+ * Each mode runs in its own process with the real scheduler loop. The
+ * jitter is the deviation of the interval of a 10 ms periodic timer.
+ *
+ * usage: bench_info_server [clients [seconds [nodes]]]
+ */
+
+#include "harness.h"
+#include "olsr.h"
+#include "scheduler.h"
+#include "tc_set.h"
+#include "info/olsrd_info.h"
+#include "../lib/txtinfo/src/olsrd_txtinfo.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+#define BENCH_PORT 29006
+#define BENCH_TICK 10               /* ms between two jitter samples */
+#define BENCH_MAX_SAMPLES 100000
+
+struct bench_mode {
+  const char *name;
+  int threads;
+  bool keep_alive;
+};
+
+static const struct bench_mode bench_modes[] = {
+  { "main loop", 0, false },
+  { "2 threads", 2, false },
+  { "2 threads, keep-alive", 2, true }
+};
+
+/* parameters of txtinfo, normally in its olsrd_plugin.c */
+info_plugin_config_t config;
+bool vtime = false;
+
+static info_plugin_functions_t bench_functions;
+
+static const struct bench_mode *bench_mode;
+static volatile bool bench_running;
+static unsigned long bench_requests;
+static unsigned long bench_errors;
+
+static uint64_t bench_tick_last;
+static uint64_t bench_tick_count;
+static uint32_t bench_jitter[BENCH_MAX_SAMPLES];   /* microseconds */
+
+/* build a topology with symmetric edges, every node has about 6 neighbors */
+static void
+bench_topology(int nodes)
+{
+  static const uint8_t lq[4] = { 255, 230, 0, 0 };
+  int i, j;
+
+  for (i = 0; i < nodes; i++) {
+    union olsr_ip_addr addr;
+    struct tc_entry *tc;
+
+    addr.v4.s_addr = htonl(0x0a000000 + 2 + i);
+    tc = olsr_restore_tc_entry(&addr, 1, 1, 3, 600 * MSEC_PER_SEC);
+    for (j = 1; j <= 3; j++) {
+      union olsr_ip_addr up, down;
+
+      up.v4.s_addr = htonl(0x0a000000 + 2 + (i + j * j) % nodes);
+      down.v4.s_addr = htonl(0x0a000000 + 2 + (i + nodes - (j * j) % nodes) % nodes);
+      olsr_restore_tc_edge(tc, &up, 1, lq);
+      olsr_restore_tc_edge(tc, &down, 1, lq);
+    }
+  }
+}
+
+static int
+bench_connect(void)
+{
+  struct sockaddr_in sin;
+  struct timeval tv = { 1, 0 };
+  struct timeval tv_connect = { 3, 0 };
+  int fd;
+
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  /* bounds connect(), a SYN dropped on a full accept queue is retried after a second */
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv_connect, sizeof(tv_connect));
+
+  memset(&sin, 0, sizeof(sin));
+  sin.sin_family = AF_INET;
+  sin.sin_port = htons(BENCH_PORT);
+  sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (connect(fd, (struct sockaddr *) &sin, sizeof(sin))) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+/**
+ * Read one response.
+ *
+ * @return true if a complete response was read
+ */
+static bool
+bench_read_response(int fd, bool keep_alive)
+{
+  char buf[16384];
+  size_t have = 0;
+  ssize_t r;
+  char *end;
+  long length;
+
+  for (;;) {
+    r = recv(fd, buf + have, sizeof(buf) - 1 - have, 0);
+    if (r <= 0) {
+      /* without keep-alive the response ends with the connection */
+      return !keep_alive && r == 0 && have > 0;
+    }
+    have += (size_t) r;
+    buf[have] = 0;
+
+    end = strstr(buf, "\r\n\r\n");
+    if (end || have == sizeof(buf) - 1) {
+      break;
+    }
+  }
+  if (!end) {
+    return false;
+  }
+
+  if (!keep_alive) {
+    while ((r = recv(fd, buf, sizeof(buf), 0)) > 0) {
+    }
+    return r == 0;
+  }
+
+  /* skip the body */
+  end = strstr(buf, "Content-Length:");
+  if (!end) {
+    return false;
+  }
+  length = strtol(end + 15, NULL, 10) - (long) (have - (size_t) (strstr(buf, "\r\n\r\n") + 4 - buf));
+  while (length > 0) {
+    r = recv(fd, buf, length < (long) sizeof(buf) ? (size_t) length : sizeof(buf), 0);
+    if (r <= 0) {
+      return false;
+    }
+    length -= r;
+  }
+  return length == 0;
+}
+
+static void *
+bench_client(void *arg __attribute__ ((unused)))
+{
+  static const char req_close[] = "GET /topology HTTP/1.0\r\n\r\n";
+  static const char req_keep[] = "GET /topology HTTP/1.1\r\nHost: localhost\r\n\r\n";
+  int fd = -1;
+
+  while (bench_running) {
+    bool ok;
+
+    if (fd < 0) {
+      fd = bench_connect();
+      if (fd < 0) {
+        if (!bench_running) {
+          break;
+        }
+        __atomic_add_fetch(&bench_errors, 1, __ATOMIC_RELAXED);
+        usleep(1000);
+        continue;
+      }
+    }
+
+    if (bench_mode->keep_alive) {
+      ok = send(fd, req_keep, sizeof(req_keep) - 1, MSG_NOSIGNAL) > 0 && bench_read_response(fd, true);
+    } else {
+      ok = send(fd, req_close, sizeof(req_close) - 1, MSG_NOSIGNAL) > 0 && bench_read_response(fd, false);
+    }
+
+    if (!bench_running) {
+      break;
+    }
+    __atomic_add_fetch(ok ? &bench_requests : &bench_errors, 1, __ATOMIC_RELAXED);
+
+    if (!ok || !bench_mode->keep_alive) {
+      close(fd);
+      fd = -1;
+    }
+  }
+
+  if (fd >= 0) {
+    close(fd);
+  }
+  return NULL;
+}
+
+/* periodic timer, records the deviation of its interval */
+static void
+bench_tick(void *context __attribute__ ((unused)))
+{
+  uint64_t now, interval, tick = BENCH_TICK * 1000000ULL;
+
+  now = harness_clock_ns();
+  interval = now - bench_tick_last;
+  bench_tick_last = now;
+  if (bench_tick_count < BENCH_MAX_SAMPLES) {
+    bench_jitter[bench_tick_count] = (uint32_t) ((interval > tick ? interval - tick : tick - interval) / 1000);
+  }
+  bench_tick_count++;
+}
+
+static void
+bench_stop(void *context __attribute__ ((unused)))
+{
+  olsr_scheduler_stop();
+}
+
+static int
+bench_cmp_u32(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+
+  return x < y ? -1 : x > y;
+}
+
+static int
+bench_run(const struct bench_mode *mode, int clients, int seconds, int nodes)
+{
+  pthread_t threads[64];
+  uint64_t start, elapsed;
+  unsigned long samples;
+  int i;
+
+  bench_mode = mode;
+
+  harness_init(AF_INET);
+  olsr_cnf->debug_level = 0;
+  olsr_cnf->pollrate = 0.001f;
+  olsr_cnf->main_addr.v4.s_addr = htonl(0x0a000001);
+  harness_init_tables(NULL);
+  bench_topology(nodes);
+
+  info_plugin_config_init(&config, BENCH_PORT);
+  config.threads = mode->threads;
+
+  memset(&bench_functions, 0, sizeof(bench_functions));
+  bench_functions.supportsCompositeCommands = true;
+  bench_functions.snapshot_commands = SIW_NEIGHBORS | SIW_LINKS | SIW_ROUTES | SIW_HNA | SIW_MID | SIW_TOPOLOGY | SIW_2HOP;
+  bench_functions.supported_commands_mask = get_supported_commands_mask;
+  bench_functions.is_command = isCommand;
+  bench_functions.cache_timeout = cache_timeout_generic;
+  bench_functions.output_error = output_error;
+  bench_functions.topology = ipc_print_topology;
+
+  if (!info_plugin_init("BENCH", &bench_functions, &config)) {
+    fprintf(stderr, "%s: cannot start the info server\n", mode->name);
+    return EXIT_FAILURE;
+  }
+
+  /* publish the topology before the clients start */
+  olsr_process_changes();
+
+  bench_running = true;
+  for (i = 0; i < clients; i++) {
+    pthread_create(&threads[i], NULL, bench_client, NULL);
+  }
+
+  start = harness_clock_ns();
+  bench_tick_last = start;
+  olsr_start_timer(BENCH_TICK, 0, OLSR_TIMER_PERIODIC, &bench_tick, NULL, NULL);
+  olsr_start_timer(seconds * MSEC_PER_SEC, 0, OLSR_TIMER_ONESHOT, &bench_stop, NULL, NULL);
+  olsr_scheduler();
+  elapsed = harness_clock_ns() - start;
+
+  bench_running = false;
+  for (i = 0; i < clients; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  info_plugin_exit();
+
+  samples = bench_tick_count < BENCH_MAX_SAMPLES ? bench_tick_count : BENCH_MAX_SAMPLES;
+  if (!samples) {
+    fprintf(stderr, "%s: the main loop did not run\n", mode->name);
+    return EXIT_FAILURE;
+  }
+  qsort(bench_jitter, samples, sizeof(*bench_jitter), bench_cmp_u32);
+
+  printf("%-22s %9.0f req/s %6lu errors   main loop jitter p50 %6.2f ms  p99 %6.2f ms  max %6.2f ms\n",
+      mode->name, (double) bench_requests * 1e9 / (double) elapsed, bench_errors,
+      bench_jitter[samples / 2] / 1000.0, bench_jitter[samples * 99 / 100] / 1000.0, bench_jitter[samples - 1] / 1000.0);
+  return bench_requests ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int
+main(int argc, char **argv)
+{
+  int clients = argc > 1 ? atoi(argv[1]) : 8;
+  int seconds = argc > 2 ? atoi(argv[2]) : 2;
+  int nodes = argc > 3 ? atoi(argv[3]) : 300;
+  int result = EXIT_SUCCESS;
+  unsigned int i;
+
+  if (clients < 1 || clients > 64 || seconds < 1 || nodes < 8) {
+    fprintf(stderr, "usage: %s [clients (1-64) [seconds [nodes (>= 8)]]]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  printf("%d clients, %d s per mode, %d nodes\n", clients, seconds, nodes);
+  fflush(stdout);
+
+  for (i = 0; i < ARRAYSIZE(bench_modes); i++) {
+    int status;
+    pid_t pid;
+
+    /* every mode gets a fresh daemon state */
+    pid = fork();
+    if (pid == 0) {
+      exit(bench_run(&bench_modes[i], clients, seconds, nodes));
+    }
+    if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status)) {
+      result = EXIT_FAILURE;
+    }
+  }
+  return result;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
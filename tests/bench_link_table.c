@@ -0,0 +1,308 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Benchmark of the link lookups with 500 links: the link table scans
+ * of lookup_link_entry(), check_neighbor_link() and
+ * get_best_link_to_neighbor() against walks of the link list, as they
+ * were done before the link table.
+ *
+ * The links are created by HELLOs from 125 neighbors on 4 interfaces.
+ *
+ * usage: bench_link_table [rounds]
+ */
+
+#include "harness.h"
+#include "olsr.h"
+#include "interfaces.h"
+#include "link_set.h"
+#include "lq_packet.h"
+#include "lq_plugin.h"
+#include "mid_set.h"
+#include "neighbor_table.h"
+#include "process_package.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_INTERFACES 4
+#define BENCH_NEIGHBORS 125
+
+static struct interface_olsr bench_ifs[BENCH_INTERFACES];
+static char bench_if_names[BENCH_INTERFACES][8] = { "eth0", "eth1", "eth2", "eth3" };
+
+/* remote interface addresses of the links and main addresses of the neighbors */
+static union olsr_ip_addr bench_remote[BENCH_INTERFACES * BENCH_NEIGHBORS];
+static union olsr_ip_addr bench_main[BENCH_NEIGHBORS];
+
+/* lookup_link_entry() as a walk of the link list */
+static struct link_entry *
+list_lookup_link_entry(const union olsr_ip_addr *remote, const struct interface_olsr *local)
+{
+  struct link_entry *link;
+
+  OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    if (ipequal(remote, &link->neighbor_iface_addr)
+        && (link->if_name ? !strcmp(link->if_name, local->int_name) : ipequal(&local->ip_addr, &link->local_iface_addr))) {
+      return link;
+    }
+  }
+  OLSR_FOR_ALL_LINK_ENTRIES_END(link);
+
+  return NULL;
+}
+
+/* check_neighbor_link() as a walk of the link list */
+static int
+list_check_neighbor_link(const union olsr_ip_addr *int_addr)
+{
+  struct link_entry *link;
+
+  OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    if (ipequal(int_addr, &link->neighbor_iface_addr)) {
+      return lookup_link_status(link);
+    }
+  }
+  OLSR_FOR_ALL_LINK_ENTRIES_END(link);
+
+  return UNSPEC_LINK;
+}
+
+/* the LQ case of get_best_link_to_neighbor() as a walk of the link list */
+static struct link_entry *
+list_get_best_link_to_neighbor(const union olsr_ip_addr *remote)
+{
+  const union olsr_ip_addr *main_addr;
+  struct link_entry *walker, *good_link = NULL, *backup_link = NULL;
+  olsr_linkcost curr_lcost = LINK_COST_BROKEN;
+
+  main_addr = mid_lookup_main_addr(remote);
+  if (!main_addr) {
+    main_addr = remote;
+  }
+
+  OLSR_FOR_ALL_LINK_ENTRIES(walker) {
+    if (!ipequal(&walker->neighbor->neighbor_main_addr, main_addr))
+      continue;
+
+    if ((walker->linkcost < curr_lcost) || ((walker->linkcost == curr_lcost) && ipequal(&walker->local_iface_addr, remote))) {
+      curr_lcost = walker->linkcost;
+      if (lookup_link_status(walker) == SYM_LINK) {
+        good_link = walker;
+      } else {
+        backup_link = walker;
+      }
+    }
+  }
+  OLSR_FOR_ALL_LINK_ENTRIES_END(walker);
+
+  return good_link ? good_link : backup_link;
+}
+
+/* a HELLO from a neighbor on an interface, which lists the interface as symmetric */
+static void
+bench_hello(int neighbor, int ifi)
+{
+  uint8_t msg[64];
+  unsigned int entry_size = 4 + olsr_cnf->ipsize + olsr_sizeof_hello_lqdata();
+  unsigned int size = 16 + entry_size;
+
+  memset(msg, 0, sizeof(msg));
+  msg[0] = LQ_HELLO_MESSAGE;
+  msg[1] = 0xe8;
+  msg[2] = size >> 8;
+  msg[3] = size & 0xff;
+  memcpy(msg + 4, &bench_main[neighbor], olsr_cnf->ipsize);
+  msg[8] = 1;
+  msg[14] = 0x86;
+  msg[15] = WILL_DEFAULT;
+  msg[16] = CREATE_LINK_CODE(SYM_NEIGH, SYM_LINK);
+  msg[19] = entry_size;
+  memcpy(msg + 20, &bench_ifs[ifi].ip_addr, olsr_cnf->ipsize);
+  msg[24] = 128 + rand() % 128;
+  msg[25] = 128 + rand() % 128;
+
+  olsr_input_hello((union olsr_message *)msg, &bench_ifs[ifi], &bench_remote[ifi * BENCH_NEIGHBORS + neighbor]);
+}
+
+static void
+bench_setup(void)
+{
+  int i, n;
+
+  harness_init(AF_INET);
+  olsr_cnf->use_hysteresis = false;
+  olsr_cnf->main_addr.v4.s_addr = htonl(0x0a010001);
+  harness_init_tables(NULL);
+
+  memset(bench_ifs, 0, sizeof(bench_ifs));
+  for (i = 0; i < BENCH_INTERFACES; i++) {
+    bench_ifs[i].ip_addr.v4.s_addr = htonl(0x0a010001 + (i << 16));
+    bench_ifs[i].int_name = bench_if_names[i];
+    bench_ifs[i].mode = IF_MODE_MESH;
+    bench_ifs[i].int_next = i + 1 < BENCH_INTERFACES ? &bench_ifs[i + 1] : NULL;
+  }
+  ifnet = &bench_ifs[0];
+
+  memset(bench_main, 0, sizeof(bench_main));
+  memset(bench_remote, 0, sizeof(bench_remote));
+  for (n = 0; n < BENCH_NEIGHBORS; n++) {
+    bench_main[n].v4.s_addr = htonl(0x0a000002 + n);
+    for (i = 0; i < BENCH_INTERFACES; i++) {
+      bench_remote[i * BENCH_NEIGHBORS + n].v4.s_addr = htonl(0x0a010002 + (i << 16) + n);
+    }
+  }
+
+  srand(1);
+  for (i = 0; i < BENCH_INTERFACES; i++) {
+    for (n = 0; n < BENCH_NEIGHBORS; n++) {
+      bench_hello(n, i);
+    }
+  }
+}
+
+static void
+bench_report(const char *name, uint64_t list_ns, uint64_t table_ns, unsigned long calls)
+{
+  printf("  %-26s %6.0f -> %6.0f ns per call\n", name, (double)list_ns / calls, (double)table_ns / calls);
+}
+
+int
+main(int argc, char **argv)
+{
+  int rounds = argc > 1 ? atoi(argv[1]) : 200;
+  uint64_t start, list_ns, table_ns;
+  unsigned long calls;
+  int r, i, n;
+
+  if (rounds < 1) {
+    fprintf(stderr, "usage: %s [rounds]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  bench_setup();
+  CHECK(link_table.count == BENCH_INTERFACES * BENCH_NEIGHBORS);
+
+  /* both ways find the same links */
+  for (i = 0; i < BENCH_INTERFACES; i++) {
+    for (n = 0; n < BENCH_NEIGHBORS; n++) {
+      const union olsr_ip_addr *remote = &bench_remote[i * BENCH_NEIGHBORS + n];
+
+      CHECK(lookup_link_entry(remote, NULL, &bench_ifs[i]) == list_lookup_link_entry(remote, &bench_ifs[i]));
+      CHECK(lookup_link_entry(remote, NULL, &bench_ifs[i]) != NULL);
+      CHECK(check_neighbor_link(remote) == list_check_neighbor_link(remote));
+    }
+  }
+  for (n = 0; n < BENCH_NEIGHBORS; n++) {
+    CHECK(get_best_link_to_neighbor(&bench_main[n]) == list_get_best_link_to_neighbor(&bench_main[n]));
+  }
+
+  printf("%u links on %d interfaces, %d rounds, before (list walk) -> after (link table):\n", link_table.count,
+         BENCH_INTERFACES, rounds);
+
+  calls = (unsigned long)rounds * BENCH_INTERFACES * BENCH_NEIGHBORS;
+  start = harness_clock_ns();
+  for (r = 0; r < rounds; r++) {
+    for (i = 0; i < BENCH_INTERFACES * BENCH_NEIGHBORS; i++) {
+      list_lookup_link_entry(&bench_remote[i], &bench_ifs[i / BENCH_NEIGHBORS]);
+    }
+  }
+  list_ns = harness_clock_ns() - start;
+  start = harness_clock_ns();
+  for (r = 0; r < rounds; r++) {
+    for (i = 0; i < BENCH_INTERFACES * BENCH_NEIGHBORS; i++) {
+      lookup_link_entry(&bench_remote[i], NULL, &bench_ifs[i / BENCH_NEIGHBORS]);
+    }
+  }
+  table_ns = harness_clock_ns() - start;
+  bench_report("lookup_link_entry", list_ns, table_ns, calls);
+
+  start = harness_clock_ns();
+  for (r = 0; r < rounds; r++) {
+    for (i = 0; i < BENCH_INTERFACES * BENCH_NEIGHBORS; i++) {
+      list_check_neighbor_link(&bench_remote[i]);
+    }
+  }
+  list_ns = harness_clock_ns() - start;
+  start = harness_clock_ns();
+  for (r = 0; r < rounds; r++) {
+    for (i = 0; i < BENCH_INTERFACES * BENCH_NEIGHBORS; i++) {
+      check_neighbor_link(&bench_remote[i]);
+    }
+  }
+  table_ns = harness_clock_ns() - start;
+  bench_report("check_neighbor_link", list_ns, table_ns, calls);
+
+  calls = (unsigned long)rounds * BENCH_INTERFACES * BENCH_NEIGHBORS;
+  start = harness_clock_ns();
+  for (r = 0; r < rounds * BENCH_INTERFACES; r++) {
+    for (n = 0; n < BENCH_NEIGHBORS; n++) {
+      list_get_best_link_to_neighbor(&bench_main[n]);
+    }
+  }
+  list_ns = harness_clock_ns() - start;
+  start = harness_clock_ns();
+  for (r = 0; r < rounds * BENCH_INTERFACES; r++) {
+    for (n = 0; n < BENCH_NEIGHBORS; n++) {
+      get_best_link_to_neighbor(&bench_main[n]);
+    }
+  }
+  table_ns = harness_clock_ns() - start;
+  bench_report("get_best_link_to_neighbor", list_ns, table_ns, calls);
+
+  /* the table is freed with the last link */
+  olsr_delete_all_link_entries();
+  CHECK(link_table.count == 0 && link_table.entry == NULL);
+
+  return harness_result("bench_link_table");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,147 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Benchmark of the cost of the metrics: a bare latency sample and the
+ * instrumented duplicate check of every received message, with the
+ * registry disabled (no consumer) and enabled (txtinfo /metrics).
+ *
+ * usage: bench_metrics [rounds]
+ */
+
+#include "harness.h"
+#include "olsr.h"
+#include "olsr_metrics.h"
+#include "duplicate_set.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#define BENCH_ORIGINATORS 200
+
+static union olsr_message bench_messages[BENCH_ORIGINATORS];
+static volatile uint64_t bench_sink;
+
+/* nanoseconds per empty olsr_metrics_start()/olsr_metrics_stop() pair */
+static double
+bench_sample(struct olsr_metric *metric, unsigned int rounds)
+{
+  uint64_t start = harness_clock_ns();
+  unsigned int i;
+
+  for (i = 0; i < rounds; i++) {
+    uint64_t sample = olsr_metrics_start();
+
+    olsr_metrics_stop(metric, sample);
+    bench_sink += sample;
+  }
+  return (double) (harness_clock_ns() - start) / rounds;
+}
+
+/* nanoseconds per olsr_message_is_duplicate() of a new message */
+static double
+bench_duplicate(unsigned int rounds)
+{
+  uint64_t start = harness_clock_ns();
+  unsigned int i;
+
+  for (i = 0; i < rounds; i++) {
+    union olsr_message *m = &bench_messages[i % BENCH_ORIGINATORS];
+
+    m->v4.seqno = htons((uint16_t) (ntohs(m->v4.seqno) + 1));
+    bench_sink += (uint64_t) olsr_message_is_duplicate(m);
+  }
+  return (double) (harness_clock_ns() - start) / rounds;
+}
+
+int
+main(int argc, char **argv)
+{
+  unsigned int rounds = argc > 1 ? (unsigned int) atoi(argv[1]) : 2000000;
+  struct olsr_metric *metric;
+  double sample_off, sample_on, dup_off, dup_on;
+  unsigned int i;
+
+  if (rounds < BENCH_ORIGINATORS) {
+    fprintf(stderr, "usage: %s [rounds (>= %d)]\n", argv[0], BENCH_ORIGINATORS);
+    return EXIT_FAILURE;
+  }
+
+  harness_init(AF_INET);
+  olsr_cnf->debug_level = 0;
+  olsr_cnf->main_addr.v4.s_addr = htonl(0x0a000001);
+  harness_init_tables(NULL);
+
+  memset(bench_messages, 0, sizeof(bench_messages));
+  for (i = 0; i < BENCH_ORIGINATORS; i++) {
+    bench_messages[i].v4.originator = htonl(0x0a000002 + i);
+  }
+  metric = olsr_metric_get(OLSR_METRIC_LATENCY, "bench", "bench", NULL, NULL);
+
+  /* warm up the duplicate set and the caches */
+  bench_duplicate(rounds / 10);
+
+  sample_off = bench_sample(metric, rounds);
+  dup_off = bench_duplicate(rounds);
+
+  olsr_metrics_enable();
+  sample_on = bench_sample(metric, rounds);
+  dup_on = bench_duplicate(rounds);
+  olsr_metrics_disable();
+
+  printf("%u rounds, %d originators\n", rounds, BENCH_ORIGINATORS);
+  printf("latency sample    disabled %6.1f ns   enabled %6.1f ns\n", sample_off, sample_on);
+  printf("duplicate check   disabled %6.1f ns   enabled %6.1f ns  (+%.0f%%)\n",
+      dup_off, dup_on, (dup_on - dup_off) * 100 / dup_off);
+  return EXIT_SUCCESS;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,178 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Benchmark of the de-duplication list of the pud plugin with 10000
+ * entries: the hashed lookup of isInDeDupList() against a scan of the
+ * ring from the newest to the oldest entry, as it was done before the
+ * hash index.
+ *
+ * 500 originators send position updates, a quarter of them are
+ * duplicates.
+ *
+ * usage: bench_pud_dedup [messages] [depth]
+ */
+
+#include "harness.h"
+#include "olsr.h"
+#include "../lib/pud/src/dedup.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_ORIGINATORS 500
+
+/* isInDeDupList() as a scan of the ring */
+static bool
+ring_isInDeDupList(DeDupList * deDupList, union olsr_message *olsrMessage)
+{
+  unsigned long long index = deDupList->newestEntryIndex;
+  unsigned long long count = deDupList->entriesCount;
+
+  while (count > 0) {
+    DeDupEntry *entry = &deDupList->entries[index];
+
+    if (entry->seqno == olsrMessage->v4.seqno
+        && memcmp(&entry->originator.v4, &olsrMessage->v4.originator, sizeof(entry->originator.v4)) == 0) {
+      return true;
+    }
+    index = (index + 1) % deDupList->entriesMaxCount;
+    count--;
+  }
+  return false;
+}
+
+/* the next message of a random originator, the same seqno again in a quarter of the cases */
+static void
+bench_message(union olsr_message *msg, uint16_t *seqno)
+{
+  int originator = rand() % BENCH_ORIGINATORS;
+
+  if (rand() % 4) {
+    seqno[originator]++;
+  }
+  msg->v4.originator = htonl(0x0a000000 + originator);
+  msg->v4.seqno = htons(seqno[originator]);
+}
+
+/* run the messages through a list, return the number of duplicates */
+static long
+bench_run(unsigned long long depth, long messages, bool ring, bool compare)
+{
+  static uint16_t seqno[BENCH_ORIGINATORS];
+  union olsr_message msg;
+  DeDupList list;
+  long i, duplicates = 0;
+
+  memset(&list, 0, sizeof(list));
+  memset(&msg, 0, sizeof(msg));
+  memset(seqno, 0, sizeof(seqno));
+  CHECK(initDeDupList(&list, depth));
+  srand(1);
+
+  for (i = 0; i < messages; i++) {
+    bool found;
+
+    bench_message(&msg, seqno);
+    found = ring ? ring_isInDeDupList(&list, &msg) : isInDeDupList(&list, &msg);
+    if (compare) {
+      CHECK(found == ring_isInDeDupList(&list, &msg));
+    }
+    if (found) {
+      duplicates++;
+    } else {
+      addToDeDup(&list, &msg);
+    }
+  }
+
+  destroyDeDupList(&list);
+  return duplicates;
+}
+
+int
+main(int argc, char **argv)
+{
+  static const unsigned long long depths[] = { 1, 100, 10000 };
+  long messages = argc > 1 ? atol(argv[1]) : 50000;
+  unsigned long long depth = argc > 2 ? strtoull(argv[2], NULL, 10) : 10000;
+  uint64_t start, ring_ns, hash_ns;
+  long ring_dups, hash_dups;
+  unsigned int i;
+
+  if (messages < 1 || depth < 1) {
+    fprintf(stderr, "usage: %s [messages] [depth]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  harness_init(AF_INET);
+
+  /* both lookups find the same duplicates */
+  for (i = 0; i < sizeof(depths) / sizeof(depths[0]); i++) {
+    bench_run(depths[i], 20000, false, true);
+  }
+
+  start = harness_clock_ns();
+  ring_dups = bench_run(depth, messages, true, false);
+  ring_ns = harness_clock_ns() - start;
+  start = harness_clock_ns();
+  hash_dups = bench_run(depth, messages, false, false);
+  hash_ns = harness_clock_ns() - start;
+  CHECK(ring_dups == hash_dups);
+
+  printf("%ld messages from %d originators, %ld duplicates, depth %llu, before (ring scan) -> after (hash index):\n",
+         messages, BENCH_ORIGINATORS, hash_dups, depth);
+  printf("  %-26s %9.0f -> %6.0f ns per message\n", "isInDeDupList+addToDeDup", (double)ring_ns / messages,
+         (double)hash_ns / messages);
+
+  return harness_result("bench_pud_dedup");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,212 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Benchmark of the packet validation of the secure plugin: signed
+ * 400 byte packets per second that validate_packet() accepts, with the
+ * legacy digest and with HMAC-SHA256. Also checks that tampered packets
+ * and packets signed with the other algorithm are rejected, and that
+ * timed out timestamp entries are deleted by lookups and by the sweep.
+ *
+ * olsrd_secure.c is included to reach its static functions.
+ *
+ * usage: bench_secure [packets]
+ */
+
+#include "harness.h"
+#include "../lib/secure/src/olsrd_secure.c"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_PACKET_SIZE 400
+
+static char bench_dir[] = "/tmp/olsrd_test_XXXXXX";
+
+/* a packet signed by ourselves, and a validated timestamp entry for us */
+static int
+bench_packet(uint8_t *packet)
+{
+  int size = BENCH_PACKET_SIZE;
+
+  memset(packet, 0x5a, BENCH_PACKET_SIZE);
+  ((struct olsr *)packet)->olsr_packlen = htons(size);
+  add_signature(packet, &size);
+  return size;
+}
+
+static void
+bench_validate(const char *name, long packets)
+{
+  uint8_t packet[BENCH_PACKET_SIZE + sizeof(struct s_olsrmsg)], work[sizeof(packet)];
+  uint64_t start, ns;
+  long i, valid = 0;
+  int size, work_size;
+
+  size = bench_packet(packet);
+  start = harness_clock_ns();
+  for (i = 0; i < packets; i++) {
+    memcpy(work, packet, size);
+    work_size = size;
+    valid += validate_packet(NULL, (const char *)work, &work_size);
+  }
+  ns = harness_clock_ns() - start;
+  CHECK(valid == packets);
+
+  printf("  %-12s %8.0f packets/s validated\n", name, packets * 1e9 / ns);
+}
+
+static void
+check_rejected(void)
+{
+  uint8_t packet[BENCH_PACKET_SIZE + sizeof(struct s_olsrmsg)];
+  int size, work_size;
+
+  use_hmac_sha256 = true;
+  size = bench_packet(packet);
+
+  work_size = size;
+  packet[50] ^= 1;
+  CHECK(validate_packet(NULL, (const char *)packet, &work_size) == 0);
+  packet[50] ^= 1;
+
+  work_size = size;
+  use_hmac_sha256 = false;
+  CHECK(validate_packet(NULL, (const char *)packet, &work_size) == 0);
+
+  work_size = size;
+  use_hmac_sha256 = true;
+  CHECK(validate_packet(NULL, (const char *)packet, &work_size) == 1);
+}
+
+static void
+check_expiry(void)
+{
+  union olsr_ip_addr addr;
+  struct stamp *entry;
+  int i, count = 0;
+
+  memset(&addr, 0, sizeof(addr));
+  for (i = 0; i < 5000; i++) {
+    addr.v4.s_addr = htonl(0x0b000000 + i);
+    entry = add_timestamp_entry(&addr);
+    entry->valtime = entry->conftime = GET_TIMESTAMP(0) - 1;
+  }
+
+  addr.v4.s_addr = htonl(0x0b000000);
+  CHECK(lookup_timestamp_entry(&addr) == NULL);
+
+  /* a full sweep of all buckets */
+  for (i = 0; i < HASHSIZE / TIMESTAMP_SWEEP_BUCKETS; i++) {
+    timeout_timestamps(NULL);
+  }
+  for (i = 0; i < HASHSIZE; i++) {
+    for (entry = timestamps[i].next; entry != &timestamps[i]; entry = entry->next) {
+      count++;
+    }
+  }
+  CHECK(count == 1);
+  CHECK(lookup_timestamp_entry(&olsr_cnf->main_addr) != NULL);
+}
+
+int
+main(int argc, char **argv)
+{
+  long packets = argc > 1 ? atol(argv[1]) : 300000;
+  struct stamp *entry;
+  FILE *f;
+  int i;
+
+  if (packets < 1) {
+    fprintf(stderr, "usage: %s [packets]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  harness_init(AF_INET);
+  olsr_cnf->debug_level = 0;
+  olsr_cnf->main_addr.v4.s_addr = htonl(0x0a000001);
+
+  CHECK(mkdtemp(bench_dir) != NULL);
+  snprintf(keyfile, sizeof(keyfile), "%s/key", bench_dir);
+  f = fopen(keyfile, "w");
+  CHECK(f != NULL);
+  if (f == NULL) {
+    return harness_result("bench_secure");
+  }
+  srand(1);
+  for (i = 0; i < KEYLENGTH; i++) {
+    fputc(rand(), f);
+  }
+  fclose(f);
+
+  secure_plugin_init();
+  unlink(keyfile);
+  rmdir(bench_dir);
+  gettimeofday(&now, NULL);
+
+  entry = add_timestamp_entry(&olsr_cnf->main_addr);
+  entry->validated = 1;
+  entry->valtime = GET_TIMESTAMP(3600 * MSEC_PER_SEC);
+
+  printf("%d byte packets, %ld packets, SHA-256 transform %s:\n", BENCH_PACKET_SIZE, packets, SHA256Implementation());
+  use_hmac_sha256 = false;
+  bench_validate("legacy", packets);
+  use_hmac_sha256 = true;
+  bench_validate("hmac-sha256", packets);
+
+  check_rejected();
+  check_expiry();
+
+  secure_plugin_exit();
+  return harness_result("bench_secure");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,171 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+#include "harness.h"
+#include "olsr.h"
+#include "olsr_cfg.h"
+#include "olsr_cookie.h"
+#include "scheduler.h"
+#include "process_routes.h"
+#include "cfgparser/olsrd_conf.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+unsigned int harness_failures = 0;
+
+/* symbols of src/main.c */
+struct olsr_cookie_info *def_timer_ci = NULL;
+
+void
+get_argc_argv(int *argc, char ***argv)
+{
+  if (argc) {
+    *argc = 0;
+  }
+  if (argv) {
+    *argv = NULL;
+  }
+}
+
+/* symbols of the generated scanner, a test may provide its own scanner */
+FILE *yyin = NULL;
+
+int __attribute__ ((weak))
+olsrd_cnf_scan(void)
+{
+  return 0;
+}
+
+char * __attribute__ ((weak))
+yyget_text(void)
+{
+  return NULL;
+}
+
+/* the kernel is never touched by a test */
+static int
+harness_export_route(const struct rt_entry *rt __attribute__ ((unused)))
+{
+  return 0;
+}
+
+/**
+ * Set up the default configuration and the scheduler.
+ *
+ * @param ip_version AF_INET or AF_INET6
+ */
+void
+harness_init(int ip_version)
+{
+  olsr_cnf = olsrd_get_default_cnf(strdup("test"));
+  olsr_cnf->ip_version = ip_version;
+  if (ip_version == AF_INET6) {
+    olsr_cnf->ipsize = sizeof(struct in6_addr);
+    olsr_cnf->maxplen = 128;
+  }
+
+  olsr_init_timers();
+  def_timer_ci = olsr_alloc_cookie("Default Timer Cookie", OLSR_COOKIE_TYPE_TIMER);
+}
+
+/**
+ * Set up the routing tables, after harness_init(). Routes are not
+ * exported to the kernel.
+ *
+ * @param lq_algorithm name of the link quality plugin, NULL for the default
+ */
+void
+harness_init_tables(const char *lq_algorithm)
+{
+  if (lq_algorithm) {
+    olsr_cnf->lq_algorithm = strdup(lq_algorithm);
+  }
+  olsr_init_export_route();
+  olsr_addroute_function = harness_export_route;
+  olsr_addroute6_function = harness_export_route;
+  olsr_delroute_function = harness_export_route;
+  olsr_delroute6_function = harness_export_route;
+
+  olsr_init_tables();
+}
+
+/**
+ * @return monotonic time in nanoseconds
+ */
+uint64_t
+harness_clock_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Report the result of a test.
+ *
+ * @param name name of the test
+ * @return exit code of the test
+ */
+int
+harness_result(const char *name)
+{
+  if (harness_failures) {
+    fprintf(stderr, "%s: %u check(s) failed\n", name, harness_failures);
+    return EXIT_FAILURE;
+  }
+  printf("%s: ok\n", name);
+  return EXIT_SUCCESS;
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
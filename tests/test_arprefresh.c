@@ -0,0 +1,345 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Test of the arprefresh plugin: the table of senders keeps one entry
+ * per address and interface with the latest MAC address, and a flush
+ * writes every entry once to the kernel in batches of well formed
+ * RTM_NEWNEIGH messages.
+ *
+ * olsrd_arprefresh.c is included to reach its static functions. The
+ * netlink socket is replaced by sendmsg() and recvmsg() functions that
+ * capture the batches and acknowledge every message.
+ */
+
+/* recvmmsg(), the plugin is built with -D_GNU_SOURCE */
+#define _GNU_SOURCE
+
+#include "harness.h"
+
+#ifdef __linux__
+
+#include <sys/socket.h>
+
+static ssize_t test_sendmsg(int fd, const struct msghdr *msg, int flags);
+static ssize_t test_recvmsg(int fd, struct msghdr *msg, int flags);
+
+#define sendmsg test_sendmsg
+#define recvmsg test_recvmsg
+#include "../lib/arprefresh/src/olsrd_arprefresh.c"
+#undef sendmsg
+#undef recvmsg
+
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#define SENDERS 200
+#define MAX_BATCHES 64
+
+/* the captured netlink datagrams */
+static char test_batches[MAX_BATCHES][ARPREFRESH_NL_BATCH * ARPREFRESH_NL_MSG_SIZE];
+static size_t test_batch_len[MAX_BATCHES];
+static unsigned int test_batch_count;
+
+/* the messages of the last datagram that are still to be acknowledged */
+static unsigned int test_unacked;
+static uint32_t test_unacked_seq[ARPREFRESH_NL_BATCH];
+
+/* make the socket fail */
+static bool test_fail;
+
+static ssize_t
+test_sendmsg(int fd __attribute__ ((unused)), const struct msghdr *msg, int flags __attribute__ ((unused)))
+{
+  const struct sockaddr_nl *nladdr = msg->msg_name;
+  size_t len = msg->msg_iov[0].iov_len;
+  struct nlmsghdr *h;
+  int left = (int) len;
+
+  CHECK(msg->msg_namelen == sizeof(*nladdr) && nladdr->nl_family == AF_NETLINK && nladdr->nl_pid == 0);
+  CHECK(msg->msg_iovlen == 1);
+  CHECK(test_unacked == 0);
+  if (test_fail) {
+    errno = ENOBUFS;
+    return -1;
+  }
+  if (test_batch_count >= MAX_BATCHES || len > sizeof(test_batches[0])) {
+    CHECK(false);
+    errno = EMSGSIZE;
+    return -1;
+  }
+
+  memcpy(test_batches[test_batch_count], msg->msg_iov[0].iov_base, len);
+  test_batch_len[test_batch_count++] = len;
+
+  for (h = (struct nlmsghdr *) msg->msg_iov[0].iov_base; NLMSG_OK(h, (unsigned int) left); h = NLMSG_NEXT(h, left)) {
+    test_unacked_seq[test_unacked++] = h->nlmsg_seq;
+  }
+  return (ssize_t) len;
+}
+
+/* acknowledge the messages in two parts, the plugin has to wait for all of them */
+static ssize_t
+test_recvmsg(int fd __attribute__ ((unused)), struct msghdr *msg, int flags __attribute__ ((unused)))
+{
+  char *buf = msg->msg_iov[0].iov_base;
+  unsigned int i, n = test_unacked > 1 ? test_unacked / 2 : test_unacked;
+  size_t len = 0;
+
+  CHECK(test_unacked > 0);
+  for (i = 0; i < n && len + NLMSG_SPACE(sizeof(struct nlmsgerr)) <= msg->msg_iov[0].iov_len; i++) {
+    struct nlmsghdr *h = (struct nlmsghdr *) (buf + len);
+    struct nlmsgerr *err = NLMSG_DATA(h);
+
+    memset(h, 0, NLMSG_SPACE(sizeof(*err)));
+    h->nlmsg_len = NLMSG_LENGTH(sizeof(*err));
+    h->nlmsg_type = NLMSG_ERROR;
+    h->nlmsg_seq = test_unacked_seq[i];
+    len += NLMSG_SPACE(sizeof(*err));
+  }
+  memmove(test_unacked_seq, test_unacked_seq + i, (test_unacked - i) * sizeof(*test_unacked_seq));
+  test_unacked -= i;
+  return (ssize_t) len;
+}
+
+/* the constructor of the plugin logs, the configuration must exist before it runs */
+static void __attribute__ ((constructor(101)))
+test_init(void)
+{
+  harness_init(AF_INET);
+  olsr_cnf->debug_level = 0;
+}
+
+static void
+sender(arprefresh_buf *buf, unsigned int idx, unsigned int version)
+{
+  memset(buf, 0, sizeof(*buf));
+  buf->ip.saddr = htonl(0x0a000100 + idx);
+  buf->eth.h_source[0] = 0x02;
+  buf->eth.h_source[3] = (unsigned char) (idx >> 8);
+  buf->eth.h_source[4] = (unsigned char) idx;
+  buf->eth.h_source[5] = (unsigned char) version;
+}
+
+/**
+ * Check the captured datagrams
+ *
+ * @param seen the number of times each sender was written, indexed by
+ * the address and interface
+ * @return the number of messages
+ */
+static unsigned int
+check_batches(unsigned int seen[2][SENDERS], unsigned int version)
+{
+  unsigned int b, messages = 0;
+
+  for (b = 0; b < test_batch_count; b++) {
+    int left = (int) test_batch_len[b];
+    struct nlmsghdr *h;
+    unsigned int count = 0;
+
+    for (h = (struct nlmsghdr *) test_batches[b]; NLMSG_OK(h, (unsigned int) left); h = NLMSG_NEXT(h, left)) {
+      struct ndmsg *ndm = NLMSG_DATA(h);
+      struct rtattr *rta = (struct rtattr *) ((char *) ndm + NLMSG_ALIGN(sizeof(*ndm)));
+      int attrlen = (int) (h->nlmsg_len - NLMSG_LENGTH(sizeof(*ndm)));
+      const uint32_t *dst = NULL;
+      const unsigned char *lladdr = NULL;
+      unsigned int idx;
+
+      /* the last attribute is not padded */
+      CHECK(h->nlmsg_len == NLMSG_LENGTH(sizeof(*ndm)) + RTA_SPACE(sizeof(*dst)) + RTA_LENGTH(ETH_ALEN));
+      CHECK(NLMSG_ALIGN(h->nlmsg_len) == ARPREFRESH_NL_MSG_SIZE);
+      CHECK(h->nlmsg_type == RTM_NEWNEIGH);
+      CHECK(h->nlmsg_flags == (NLM_F_REQUEST | NLM_F_ACK | NLM_F_CREATE | NLM_F_REPLACE));
+      CHECK(h->nlmsg_seq == count);
+      CHECK(ndm->ndm_family == AF_INET);
+      CHECK(ndm->ndm_state == NUD_STALE);
+      CHECK(ndm->ndm_flags == 0 && ndm->ndm_type == 0);
+
+      for (; RTA_OK(rta, attrlen); rta = RTA_NEXT(rta, attrlen)) {
+        if (rta->rta_type == NDA_DST && RTA_PAYLOAD(rta) == sizeof(*dst)) {
+          dst = RTA_DATA(rta);
+        } else if (rta->rta_type == NDA_LLADDR && RTA_PAYLOAD(rta) == ETH_ALEN) {
+          lladdr = RTA_DATA(rta);
+        } else {
+          CHECK(false);
+        }
+      }
+      CHECK(attrlen <= 0 && attrlen > -(int) RTA_ALIGNTO);
+      CHECK(dst && lladdr);
+      if (!dst || !lladdr) {
+        continue;
+      }
+
+      idx = ntohl(*dst) - 0x0a000100;
+      CHECK(idx < SENDERS && (ndm->ndm_ifindex == 1 || ndm->ndm_ifindex == 2));
+      if (idx >= SENDERS || (ndm->ndm_ifindex != 1 && ndm->ndm_ifindex != 2)) {
+        continue;
+      }
+      seen[ndm->ndm_ifindex - 1][idx]++;
+
+      /* the latest MAC address of the sender */
+      CHECK(lladdr[0] == 0x02 && lladdr[3] == (idx >> 8) && lladdr[4] == (idx & 0xff));
+      CHECK(lladdr[5] == version);
+      count++;
+    }
+    CHECK(left == 0);
+
+    /* only the last datagram is not full */
+    CHECK(count == ARPREFRESH_NL_BATCH || b == test_batch_count - 1);
+    messages += count;
+  }
+  return messages;
+}
+
+static void
+reset_capture(void)
+{
+  test_batch_count = 0;
+  test_unacked = 0;
+}
+
+int
+main(void)
+{
+  static unsigned int seen[2][SENDERS];
+  arprefresh_buf buf;
+  unsigned int i, v;
+
+  /* every sender is seen 5 times on interface 1, the even ones also on interface 2 */
+  for (v = 1; v <= 5; v++) {
+    for (i = 0; i < SENDERS; i++) {
+      sender(&buf, i, v);
+      arprefresh_remember(1, &buf);
+      if (!(i & 1)) {
+        arprefresh_remember(2, &buf);
+      }
+    }
+  }
+  CHECK(test_batch_count == 0);
+  CHECK(arprefresh_count == SENDERS + SENDERS / 2);
+
+  /* every table entry is a sender, once */
+  memset(seen, 0, sizeof(seen));
+  for (i = 0; i < ARPREFRESH_TABLE_SIZE; i++) {
+    const struct arprefresh_entry *entry = &arprefresh_table[i];
+
+    if (entry->ifindex) {
+      unsigned int idx = ntohl(entry->addr) - 0x0a000100;
+
+      CHECK(idx < SENDERS && entry->mac[5] == 5);
+      if (idx < SENDERS) {
+        seen[entry->ifindex - 1][idx]++;
+      }
+    }
+  }
+  for (i = 0; i < SENDERS; i++) {
+    CHECK(seen[0][i] == 1);
+    CHECK(seen[1][i] == !(i & 1));
+  }
+
+  /* the flush writes every sender once and empties the table */
+  arprefresh_flush();
+  CHECK(test_unacked == 0);
+  CHECK(test_batch_count == (SENDERS + SENDERS / 2 + ARPREFRESH_NL_BATCH - 1) / ARPREFRESH_NL_BATCH);
+  memset(seen, 0, sizeof(seen));
+  CHECK(check_batches(seen, 5) == SENDERS + SENDERS / 2);
+  for (i = 0; i < SENDERS; i++) {
+    CHECK(seen[0][i] == 1);
+    CHECK(seen[1][i] == !(i & 1));
+  }
+  CHECK(arprefresh_count == 0);
+  for (i = 0; i < ARPREFRESH_TABLE_SIZE; i++) {
+    CHECK(arprefresh_table[i].ifindex == 0);
+  }
+
+  /* an empty table is not written */
+  reset_capture();
+  arprefresh_flush();
+  CHECK(test_batch_count == 0);
+
+  /* a full table is written before more senders are added */
+  for (i = 0; i < ARPREFRESH_TABLE_FLUSH; i++) {
+    sender(&buf, i % SENDERS, 7);
+    arprefresh_remember(1 + i / SENDERS, &buf);
+  }
+  CHECK(arprefresh_count == 0);
+  CHECK(test_batch_count == ARPREFRESH_TABLE_FLUSH / ARPREFRESH_NL_BATCH);
+  memset(seen, 0, sizeof(seen));
+  CHECK(check_batches(seen, 7) == ARPREFRESH_TABLE_FLUSH);
+
+  /* a failing socket stops the flush, but the table is emptied */
+  reset_capture();
+  for (i = 0; i < SENDERS; i++) {
+    sender(&buf, i, 9);
+    arprefresh_remember(1, &buf);
+  }
+  test_fail = true;
+  arprefresh_flush();
+  test_fail = false;
+  CHECK(test_batch_count == 0);
+  CHECK(arprefresh_count == 0);
+
+  return harness_result("test_arprefresh");
+}
+
+#else /* __linux__ */
+
+int
+main(void)
+{
+  printf("test_arprefresh: skipped\n");
+  return 0;
+}
+
+#endif /* __linux__ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,296 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Test of the binary configuration files: a configuration compiled by
+ * olsrd_compile_cnf() loads into the same configuration, as written by
+ * olsrd_write_cnf_autobuf_uncached(), and the same checksum as its text.
+ * The scanner is replaced by a list of
+ * tokens, comments leave yylval alone like the rule in oscan.lex does.
+ * Run it with SANITIZE_ADDRESS=1 to catch stale token values.
+ */
+
+#define YYSTYPE struct conf_token *
+
+#include "harness.h"
+#include "olsr_cfg.h"
+#include "cfgparser/olsrd_conf.h"
+#include "cfgparser/olsrd_conf_checksum.h"
+#include "cfgparser/oparse.h"
+#include "common/autobuf.h"
+#include "common/string_handling.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+
+enum stub_kind {
+  STUB_KEYWORD,
+  STUB_COMMENT,
+  STUB_INTEGER,
+  STUB_FLOAT,
+  STUB_STRING,
+  STUB_WORD
+};
+
+struct stub_token {
+  int token;
+  enum stub_kind kind;
+  const char *text;
+};
+
+static const struct stub_token script[] = {
+  { TOK_COMMENT, STUB_COMMENT, "# a comment first\n" },
+  { TOK_DEBUGLEVEL, STUB_KEYWORD, "DebugLevel" },
+  { TOK_INTEGER, STUB_INTEGER, "2" },
+  { TOK_COMMENT, STUB_COMMENT, "# after an integer\n" },
+  { TOK_POLLRATE, STUB_KEYWORD, "Pollrate" },
+  { TOK_FLOAT, STUB_FLOAT, "0.1" },
+  { TOK_LOCK_FILE, STUB_KEYWORD, "LockFile" },
+  { TOK_STRING, STUB_STRING, "\"/var/run/olsrd.lock\"" },
+  { TOK_HNA4, STUB_KEYWORD, "Hna4" },
+  { TOK_OPEN, STUB_KEYWORD, "{" },
+  { TOK_IPV4_ADDR, STUB_WORD, "10.1.0.0" },
+  { TOK_IPV4_ADDR, STUB_WORD, "255.255.0.0" },
+  { TOK_IPV4_ADDR, STUB_WORD, "10.2.3.0" },
+  { TOK_IPV4_ADDR, STUB_WORD, "255.255.255.0" },
+  { TOK_CLOSE, STUB_KEYWORD, "}" },
+  { TOK_IPCCON, STUB_KEYWORD, "IpcConnect" },
+  { TOK_OPEN, STUB_KEYWORD, "{" },
+  { TOK_NETLABEL, STUB_KEYWORD, "Net" },
+  { TOK_IPV4_ADDR, STUB_WORD, "192.168.1.0" },
+  { TOK_IPV4_ADDR, STUB_WORD, "255.255.255.0" },
+  { TOK_CLOSE, STUB_KEYWORD, "}" },
+  { TOK_INTERFACE_DEFAULTS, STUB_KEYWORD, "InterfaceDefaults" },
+  { TOK_OPEN, STUB_KEYWORD, "{" },
+  { TOK_LQ_MULT, STUB_KEYWORD, "LinkQualityMult" },
+  { TOK_DEFAULT, STUB_KEYWORD, "default" },
+  { TOK_FLOAT, STUB_FLOAT, "0.8" },
+  { TOK_CLOSE, STUB_KEYWORD, "}" },
+  { TOK_INTERFACE, STUB_KEYWORD, "Interface" },
+  { TOK_STRING, STUB_STRING, "\"eth0\"" },
+  { TOK_STRING, STUB_STRING, "\"eth1\"" },
+  { TOK_OPEN, STUB_KEYWORD, "{" },
+  { TOK_COMMENT, STUB_COMMENT, "# after a string\n" },
+  { TOK_HELLOINT, STUB_KEYWORD, "HelloInterval" },
+  { TOK_FLOAT, STUB_FLOAT, "3.0" },
+  { TOK_COMMENT, STUB_COMMENT, "# after a float\n" },
+  { TOK_LQ_MULT, STUB_KEYWORD, "LinkQualityMult" },
+  { TOK_IPV4_ADDR, STUB_WORD, "172.16.0.1" },
+  { TOK_FLOAT, STUB_FLOAT, "0.5" },
+  { TOK_CLOSE, STUB_KEYWORD, "}" },
+  { TOK_INTERFACE, STUB_KEYWORD, "Interface" },
+  { TOK_STRING, STUB_STRING, "\"wlan0\"" },
+  { TOK_OPEN, STUB_KEYWORD, "{" },
+  { TOK_TCINT, STUB_KEYWORD, "TcInterval" },
+  { TOK_FLOAT, STUB_FLOAT, "4.0" },
+  { TOK_CLOSE, STUB_KEYWORD, "}" },
+  { TOK_PLUGIN, STUB_KEYWORD, "LoadPlugin" },
+  { TOK_STRING, STUB_STRING, "\"olsrd_txtinfo.so.1.1\"" },
+  { TOK_OPEN, STUB_KEYWORD, "{" },
+  { TOK_PLPARAM, STUB_KEYWORD, "PlParam" },
+  { TOK_STRING, STUB_STRING, "\"port\"" },
+  { TOK_STRING, STUB_STRING, "\"2006\"" },
+  { TOK_PLPARAM, STUB_KEYWORD, "PlParam" },
+  { TOK_STRING, STUB_STRING, "\"accept\"" },
+  { TOK_STRING, STUB_STRING, "\"0.0.0.0\"" },
+  { TOK_CLOSE, STUB_KEYWORD, "}" },
+  { TOK_COMMENT, STUB_COMMENT, "# at the end\n" }
+};
+
+static unsigned int script_pos;
+static char script_text[64];
+
+int
+olsrd_cnf_scan(void)
+{
+  const struct stub_token *t;
+  struct conf_token *value = NULL;
+
+  if (script_pos >= sizeof(script) / sizeof(script[0])) {
+    return 0;
+  }
+  t = &script[script_pos++];
+
+  strscpy(script_text, t->text, sizeof(script_text));
+  if (t->kind == STUB_COMMENT) {
+    current_line++;
+    return t->token;
+  }
+
+  olsrd_config_checksum_add(t->text, strlen(t->text));
+  if (t->kind != STUB_KEYWORD) {
+    value = calloc(1, sizeof(*value));
+    if (value == NULL) {
+      return 0;
+    }
+    if (t->kind == STUB_INTEGER) {
+      value->integer = strtol(t->text, NULL, 0);
+    } else if (t->kind == STUB_FLOAT) {
+      sscanf(t->text, "%f", &value->floating);
+    } else if (t->kind == STUB_STRING) {
+      value->string = strndup(t->text + 1, strlen(t->text) - 2);
+    } else {
+      value->string = strdup(t->text);
+    }
+  }
+  yylval = value;
+  return t->token;
+}
+
+char *
+yyget_text(void)
+{
+  return script_text;
+}
+
+struct parsed_cnf {
+  struct olsrd_config *cnf;
+  char checksum[16];
+};
+
+static int
+parse(const char *filename, const char *binfile, struct parsed_cnf *parsed)
+{
+  char *checksum;
+  int rc;
+
+  olsr_cnf = olsrd_get_default_cnf(strdup(filename));
+  olsrd_config_checksum_init();
+  script_pos = 0;
+  rc = binfile != NULL ? olsrd_compile_cnf(filename, binfile) : olsrd_parse_cnf(filename);
+  olsrd_config_checksum_final();
+  olsrd_config_checksum_get(NULL, &checksum);
+
+  parsed->cnf = olsr_cnf;
+  strscpy(parsed->checksum, checksum, sizeof(parsed->checksum));
+  return rc;
+}
+
+static void
+check_same(const struct parsed_cnf *a, const struct parsed_cnf *b)
+{
+  struct autobuf abuf_a, abuf_b;
+
+  CHECK(strcmp(a->checksum, b->checksum) == 0); 
+
+  /* the address printers follow the IP version of olsr_cnf */
+  abuf_init(&abuf_a, 0);
+  abuf_init(&abuf_b, 0);
+  olsr_cnf = a->cnf;
+  olsrd_write_cnf_autobuf_uncached(&abuf_a, a->cnf);
+  olsr_cnf = b->cnf;
+  olsrd_write_cnf_autobuf_uncached(&abuf_b, b->cnf);
+  CHECK(abuf_a.len == abuf_b.len && memcmp(abuf_a.buf, abuf_b.buf, abuf_a.len) == 0);
+  abuf_free(&abuf_a);
+  abuf_free(&abuf_b);
+}
+
+int
+main(void)
+{
+  char dir[] = "/tmp/olsrd_test_XXXXXX";
+  char conffile[sizeof(dir) + 16], binfile[sizeof(dir) + 16];
+  struct parsed_cnf text, compiled, binary;
+  FILE *f;
+
+  CHECK(mkdtemp(dir) != NULL);
+  snprintf(conffile, sizeof(conffile), "%s/olsrd.conf", dir);
+  snprintf(binfile, sizeof(binfile), "%s/olsrd.bin", dir);
+
+  /* the text is never read, olsrd_parse_cnf() only opens it */
+  f = fopen(conffile, "w");
+  CHECK(f != NULL);
+  if (f != NULL) {
+    fclose(f);
+  }
+
+  CHECK(parse(conffile, NULL, &text) == 0);
+  CHECK(text.cnf->debug_level == 2);
+  CHECK(text.cnf->interfaces != NULL);
+  CHECK(text.cnf->hna_entries != NULL);
+  CHECK(text.cnf->plugins != NULL && text.cnf->plugins->params != NULL);
+
+  CHECK(parse(conffile, binfile, &compiled) == 0);
+  check_same(&text, &compiled);
+
+  /* the scanner is not used for a binary configuration */
+  CHECK(parse(binfile, NULL, &binary) == 0);
+  CHECK(script_pos == 0);
+  check_same(&text, &binary);
+  CHECK(binary.cnf->interfaces != NULL && binary.cnf->interfaces->cnfi->lq_mult == binary.cnf->interfaces->cnf->lq_mult);
+
+  olsrd_free_cnf(&text.cnf);
+  olsrd_free_cnf(&compiled.cnf);
+  olsrd_free_cnf(&binary.cnf);
+  olsr_cnf = NULL;
+
+  unlink(binfile);
+  unlink(conffile);
+  rmdir(dir);
+
+  return harness_result("test_cfgfile_bin");
+}
+
+#else /* __linux__ */
+
+int
+main(void)
+{
+  printf("test_cfgfile_bin: skipped\n");
+  return 0;
+}
+
+#endif /* __linux__ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,443 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Test of the delta frames of the dot_draw plugin: the delta frames,
+ * applied one after the other to the first complete graph, must give
+ * the same graph as a complete dump of the tables after every frame.
+ *
+ * olsrd_dot_draw.c is included to reach its static functions. A "+ "
+ * edge replaces all the statements sent before for that edge (the
+ * edge and the shapes that follow it), a "- " edge drops them. Several
+ * edges may shape the same node, so the graphs are compared by their
+ * edge statements and the set of node statements.
+ */
+
+#include "harness.h"
+
+#include "../lib/dot_draw/src/olsrd_dot_draw.c"
+
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+/* defined by olsrd_plugin.c, not linked into the test */
+union olsr_ip_addr ipc_accept_ip;
+union olsr_ip_addr ipc_listen_ip;
+int ipc_port;
+int dot_frame_interval;
+bool dot_delta;
+
+#define NODES 12
+#define NETS 4
+#define FRAMES 2000
+#define MAX_EDGES 512
+
+/* the dot statements of one edge */
+struct graph_edge {
+  char id[96];
+  char text[256];
+};
+
+struct graph {
+  struct graph_edge edges[MAX_EDGES];
+  unsigned int count;
+};
+
+static struct graph model, reference;
+
+static void
+node_addr(union olsr_ip_addr *addr, int idx)
+{
+  memset(addr, 0, sizeof(*addr));
+  addr->v4.s_addr = htonl(0x0a000001 + idx);
+}
+
+static void
+net_addr(union olsr_ip_addr *addr, int idx)
+{
+  memset(addr, 0, sizeof(*addr));
+  addr->v4.s_addr = htonl(0xc0a80000 + (idx << 8));
+}
+
+/* the edge of a statement, "from" -> "to" without the attributes */
+static bool
+edge_id(const char *line, char *id, size_t size)
+{
+  size_t len = strcspn(line, "[;\n");
+  const char *arrow = strstr(line, " -> ");
+
+  if (arrow == NULL || arrow > line + len) {
+    return false;
+  }
+  CHECK(len < size);
+  memcpy(id, line, len);
+  id[len] = 0;
+  return true;
+}
+
+static struct graph_edge *
+graph_find(struct graph *graph, const char *id)
+{
+  unsigned int i;
+
+  for (i = 0; i < graph->count; i++) {
+    if (strcmp(graph->edges[i].id, id) == 0) {
+      return &graph->edges[i];
+    }
+  }
+  return NULL;
+}
+
+static void
+graph_remove(struct graph *graph, const char *id)
+{
+  struct graph_edge *edge = graph_find(graph, id);
+
+  CHECK(edge != NULL);
+  if (edge) {
+    *edge = graph->edges[--graph->count];
+  }
+}
+
+/* start a new edge, or replace all statements of a known one */
+static struct graph_edge *
+graph_set(struct graph *graph, const char *id)
+{
+  struct graph_edge *edge = graph_find(graph, id);
+
+  if (!edge) {
+    CHECK(graph->count < MAX_EDGES);
+    edge = &graph->edges[graph->count++];
+    strscpy(edge->id, id, sizeof(edge->id));
+  }
+  edge->text[0] = 0;
+  return edge;
+}
+
+static void
+graph_append(struct graph_edge *edge, const char *line, size_t len)
+{
+  size_t used = strlen(edge->text);
+
+  CHECK(used + len < sizeof(edge->text));
+  memcpy(edge->text + used, line, len);
+  edge->text[used + len] = 0;
+}
+
+/* apply the lines of a frame between header and trailer to the graph */
+static void
+graph_apply(struct graph *graph, const char *frame, const char *header, const char *trailer, bool delta)
+{
+  struct graph_edge *edge = NULL;
+  const char *line, *end;
+  char id[96];
+
+  CHECK(strncmp(frame, header, strlen(header)) == 0);
+  line = frame + strlen(header);
+
+  while (*line && strcmp(line, trailer) != 0) {
+    end = strchr(line, '\n');
+    CHECK(end != NULL);
+    if (!end) {
+      return;
+    }
+    end++;
+
+    if (delta && strncmp(line, "- ", 2) == 0) {
+      CHECK(edge_id(line + 2, id, sizeof(id)));
+      graph_remove(graph, id);
+      edge = NULL;
+    } else {
+      if (delta) {
+        CHECK(strncmp(line, "+ ", 2) == 0);
+        line += 2;
+      }
+      if (edge_id(line, id, sizeof(id))) {
+        edge = graph_set(graph, id);
+      }
+      /* the shape of a node belongs to the edge before it */
+      CHECK(edge != NULL);
+      if (edge) {
+        graph_append(edge, line, (size_t)(end - line));
+      }
+    }
+    line = end;
+  }
+  CHECK(strcmp(line, trailer) == 0);
+}
+
+/* a complete dump of the tables, without touching the graph of the plugin */
+static void
+full_dump(struct graph *graph)
+{
+  struct avl_tree saved = edge_tree;
+  struct avl_node *node, *next;
+
+  avl_init(&edge_tree, &edge_comp);
+  abuf_pull(&outbuffer, outbuffer.len);
+  dotdraw_render(true);
+
+  graph->count = 0;
+  graph_apply(graph, outbuffer.buf, "digraph topology\n{\n", "}\n\n", false);
+  abuf_pull(&outbuffer, outbuffer.len);
+
+  for (node = avl_walk_first(&edge_tree); node; node = next) {
+    next = avl_walk_next(node);
+    avl_delete(&edge_tree, node);
+    free(node2edge(node));
+  }
+  edge_tree = saved;
+}
+
+/* a node statement, the same node may be shaped by several edges */
+static bool
+graph_has_node(struct graph *graph, const char *line, size_t len)
+{
+  char needle[128];
+  unsigned int i;
+
+  CHECK(len + 2 < sizeof(needle));
+  snprintf(needle, sizeof(needle), "\n%.*s", (int)len, line);
+  for (i = 0; i < graph->count; i++) {
+    if (strstr(graph->edges[i].text, needle)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/* all edge statements of a are in b, and all node statements */
+static bool
+graph_contains(struct graph *a, struct graph *b)
+{
+  unsigned int i;
+
+  for (i = 0; i < a->count; i++) {
+    struct graph_edge *edge = graph_find(b, a->edges[i].id);
+    const char *line = strchr(a->edges[i].text, '\n') + 1;
+    const char *end;
+
+    if (!edge || strncmp(edge->text, a->edges[i].text, (size_t)(line - a->edges[i].text)) != 0) {
+      return false;
+    }
+    for (; *line; line = end) {
+      end = strchr(line, '\n') + 1;
+      if (!graph_has_node(b, line, (size_t)(end - line))) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static bool
+graph_equal(struct graph *a, struct graph *b)
+{
+  return a->count == b->count && graph_contains(a, b) && graph_contains(b, a);
+}
+
+static void
+mutate_neighbor(void)
+{
+  union olsr_ip_addr addr;
+  struct neighbor_entry *neighbor;
+
+  node_addr(&addr, 1 + random() % (NODES - 1));
+  neighbor = olsr_lookup_neighbor_table(&addr);
+
+  if (!neighbor) {
+    neighbor = olsr_insert_neighbor_table(&addr);
+  } else if (random() % 4 == 0) {
+    olsr_delete_neighbor_table(&addr);
+    return;
+  }
+
+  if (random() % 2) {
+    neighbor->status = neighbor->status == SYM ? NOT_SYM : SYM;
+  } else {
+    neighbor->is_mpr = !neighbor->is_mpr;
+  }
+}
+
+static void
+mutate_topology(void)
+{
+  union olsr_ip_addr from, to;
+  struct tc_entry *tc;
+  struct tc_edge_entry *tc_edge;
+  uint8_t lq[4];
+  int a = 1 + random() % (NODES - 1), b = random() % NODES;
+
+  if (a == b) {
+    return;
+  }
+  node_addr(&from, a);
+  node_addr(&to, b);
+
+  tc = olsr_lookup_tc_entry(&from);
+  tc_edge = tc ? olsr_lookup_tc_edge(tc, &to) : NULL;
+  if (tc_edge && random() % 3 == 0) {
+    olsr_delete_tc_edge_entry(tc_edge);
+    return;
+  }
+  if (!tc) {
+    tc = olsr_restore_tc_entry(&from, 1, 1, 3, 600 * MSEC_PER_SEC);
+  }
+
+  /* a new edge or a new cost */
+  memset(lq, 0, sizeof(lq));
+  lq[0] = (uint8_t)(64 + random() % 192);
+  lq[1] = (uint8_t)(64 + random() % 192);
+  olsr_restore_tc_edge(tc, &to, 1, lq);
+}
+
+static void
+mutate_hna(void)
+{
+  union olsr_ip_addr gw, net;
+  int n = random() % NETS;
+
+  net_addr(&net, n);
+  if (random() % 4 == 0) {
+    if (ip_prefix_list_remove(&olsr_cnf->hna_entries, &net, 24) == 0) {
+      ip_prefix_list_add(&olsr_cnf->hna_entries, &net, 24);
+    }
+    return;
+  }
+
+  node_addr(&gw, 1 + random() % (NODES - 1));
+  if (random() % 3 == 0) {
+    olsr_cleanup_hna(&gw);
+  } else {
+    olsr_update_hna_entry(&gw, &net, (uint8_t)(16 + random() % 9), 600 * MSEC_PER_SEC);
+  }
+}
+
+int
+main(void)
+{
+  unsigned int frames = 0, empty = 0, removed = 0, shapes = 0;
+  int i, j;
+
+  harness_init(AF_INET);
+  node_addr(&olsr_cnf->main_addr, 0);
+  harness_init_tables("etx_float");
+
+  avl_init(&edge_tree, &edge_comp);
+  abuf_init(&outbuffer, AUTOBUFCHUNK);
+  srandom(42);
+
+  /* the first frame is always complete */
+  dot_delta = true;
+  dotdraw_render(true);
+  graph_apply(&model, outbuffer.buf, "digraph topology\n{\n", "}\n\n", false);
+  abuf_pull(&outbuffer, outbuffer.len);
+
+  for (i = 0; i < FRAMES; i++) {
+    int changes = random() % 6;
+
+    for (j = 0; j < changes; j++) {
+      switch (random() % 3) {
+      case 0:
+        mutate_neighbor();
+        break;
+      case 1:
+        mutate_topology();
+        break;
+      default:
+        mutate_hna();
+        break;
+      }
+    }
+
+    dotdraw_render(false);
+    if (outbuffer.len == 0) {
+      empty++;
+    } else {
+      frames++;
+      removed += strstr(outbuffer.buf, "\n- ") != NULL;
+      shapes += strstr(outbuffer.buf, "[shape=") != NULL;
+      graph_apply(&model, outbuffer.buf, "delta\n", "end\n\n", true);
+      abuf_pull(&outbuffer, outbuffer.len);
+    }
+
+    full_dump(&reference);
+    CHECK(graph_equal(&model, &reference));
+
+    /* nothing changed, nothing sent */
+    dotdraw_render(false);
+    CHECK(outbuffer.len == 0);
+  }
+  CHECK(frames > FRAMES / 2 && empty > 0 && removed > 0 && shapes > 0);
+
+  /* without delta a changed graph is sent complete */
+  dot_delta = false;
+  for (i = 0; i < 50; i++) {
+    mutate_topology();
+    mutate_hna();
+    dotdraw_render(false);
+    if (outbuffer.len == 0) {
+      continue;
+    }
+    model.count = 0;
+    graph_apply(&model, outbuffer.buf, "digraph topology\n{\n", "}\n\n", false);
+    abuf_pull(&outbuffer, outbuffer.len);
+    full_dump(&reference);
+    CHECK(graph_equal(&model, &reference));
+    dotdraw_render(false);
+    CHECK(outbuffer.len == 0);
+  }
+
+  printf("%u delta frames, %u without changes, %u edges at the end\n", frames, empty, model.count);
+  return harness_result("dot_draw_delta");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
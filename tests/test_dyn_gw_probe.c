@@ -0,0 +1,339 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Test of the ICMP prober of the dyn_gw plugin: a target goes up after
+ * the configured number of replies in a row and down after the number
+ * of lost probes in a row, and only a reply from the address of the
+ * target with the sequence number of its outstanding probe counts.
+ *
+ * probe.c is included to reach its static functions. The ICMP socket
+ * is replaced by sendto() and recvfrom() functions that capture the
+ * probes and hand out the replies the test queued, both for the Linux
+ * ping socket and for a raw socket that includes the IP header.
+ */
+
+#include "harness.h"
+
+#include <sys/types.h>
+#include <sys/socket.h>
+
+static ssize_t test_sendto(int fd, const void *buf, size_t len, int flags, const struct sockaddr *to, socklen_t tolen);
+static ssize_t test_recvfrom(int fd, void *buf, size_t len, int flags, struct sockaddr *from, socklen_t * fromlen);
+
+#define sendto test_sendto
+#define recvfrom test_recvfrom
+#include "../lib/dyn_gw/src/probe.c"
+#undef sendto
+#undef recvfrom
+
+#include <stdlib.h>
+#include <string.h>
+
+#define TARGETS 4
+#define INTERVALS 5000
+#define MAX_PACKETS 32
+
+struct packet {
+  struct in_addr addr;
+  uint8_t data[64];
+  size_t len;
+};
+
+/* the probes sent in the current interval */
+static struct packet sent[MAX_PACKETS];
+static unsigned int sent_count;
+
+/* the replies that are received next */
+static struct packet queue[MAX_PACKETS];
+static unsigned int queue_count, queue_next;
+
+static unsigned int changes;
+
+static ssize_t
+test_sendto(int fd __attribute__ ((unused)), const void *buf, size_t len, int flags __attribute__ ((unused)),
+            const struct sockaddr *to, socklen_t tolen)
+{
+  CHECK(tolen == sizeof(struct sockaddr_in) && len <= sizeof(sent[0].data));
+  CHECK(sent_count < MAX_PACKETS);
+  if (sent_count < MAX_PACKETS && len <= sizeof(sent[0].data)) {
+    sent[sent_count].addr = ((const struct sockaddr_in *)(const void *)to)->sin_addr;
+    memcpy(sent[sent_count].data, buf, len);
+    sent[sent_count++].len = len;
+  }
+  return (ssize_t) len;
+}
+
+static ssize_t
+test_recvfrom(int fd __attribute__ ((unused)), void *buf, size_t len, int flags __attribute__ ((unused)),
+              struct sockaddr *from, socklen_t * fromlen)
+{
+  struct sockaddr_in *sin = (struct sockaddr_in *)(void *)from;
+  struct packet *reply;
+
+  if (queue_next == queue_count) {
+    queue_next = queue_count = 0;
+    errno = EAGAIN;
+    return -1;
+  }
+  reply = &queue[queue_next++];
+
+  CHECK(*fromlen >= sizeof(*sin) && len >= reply->len);
+  memset(sin, 0, sizeof(*sin));
+  sin->sin_family = AF_INET;
+  sin->sin_addr = reply->addr;
+  *fromlen = sizeof(*sin);
+  memcpy(buf, reply->data, reply->len);
+  return (ssize_t) reply->len;
+}
+
+static void
+target_changed(struct probe_target *target __attribute__ ((unused)))
+{
+  changes++;
+}
+
+/* the probe sent to a target in this interval */
+static struct packet *
+sent_to(const struct probe_target *target)
+{
+  unsigned int i;
+
+  for (i = 0; i < sent_count; i++) {
+    if (sent[i].addr.s_addr == target->addr.s_addr) {
+      return &sent[i];
+    }
+  }
+  return NULL;
+}
+
+/* queue an echo reply, with the IP header on a raw socket */
+static void
+queue_reply(struct in_addr addr, uint8_t type, uint16_t id, uint16_t seq, size_t truncate)
+{
+  struct packet *reply;
+  struct probe_echo echo;
+  size_t offset = 0;
+
+  CHECK(queue_count < MAX_PACKETS);
+  if (queue_count == MAX_PACKETS) {
+    return;
+  }
+  reply = &queue[queue_count++];
+  memset(reply, 0, sizeof(*reply));
+  reply->addr = addr;
+
+  if (probe_raw) {
+    /* a header with options now and then */
+    offset = random() % 2 ? 20 : 24;
+    reply->data[0] = (uint8_t)(0x40 | (offset / 4));
+  }
+
+  memset(&echo, 0, sizeof(echo));
+  echo.type = type;
+  echo.id = htons(id);
+  echo.seq = htons(seq);
+  memcpy(reply->data + offset, &echo, sizeof(echo));
+  reply->len = offset + sizeof(echo) + PROBE_PAYLOAD_SIZE - truncate;
+}
+
+/* queue a reply that must not match the outstanding probe of the target */
+static void
+queue_bogus_reply(const struct probe_target *target, const struct probe_target *other)
+{
+  uint16_t seq = target->seq;
+
+  switch (random() % 6) {
+  case 0:
+    /* a late reply to an earlier probe */
+    queue_reply(target->addr, ICMP_TYPE_ECHO_REPLY, probe_id, (uint16_t)(seq - 1 - random() % 3), 0);
+    break;
+  case 1:
+    /* the sequence number of this target, from another host */
+    queue_reply(other->addr, ICMP_TYPE_ECHO_REPLY, probe_id, seq, 0);
+    break;
+  case 2:
+    /* our own request */
+    queue_reply(target->addr, ICMP_TYPE_ECHO_REQUEST, probe_id, seq, 0);
+    break;
+  case 3:
+    /* too short for an echo header */
+    queue_reply(target->addr, ICMP_TYPE_ECHO_REPLY, probe_id, seq, PROBE_PAYLOAD_SIZE + 1);
+    break;
+  default:
+    if (probe_raw) {
+      /* the reply to another process */
+      queue_reply(target->addr, ICMP_TYPE_ECHO_REPLY, (uint16_t)(probe_id + 1), seq, 0);
+    } else {
+      /* a sequence number from the future */
+      queue_reply(target->addr, ICMP_TYPE_ECHO_REPLY, probe_id, (uint16_t)(seq + 1), 0);
+    }
+    break;
+  }
+}
+
+static void
+run(bool raw, unsigned int replies, unsigned int losses)
+{
+  static const char *const addresses[TARGETS] = { "192.0.2.1", "192.0.2.2", "198.51.100.7", "203.0.113.9" };
+  struct probe_target *targets[TARGETS];
+  bool answered[TARGETS], up[TARGETS];
+  unsigned int replies_in_row[TARGETS], losses_in_row[TARGETS], received[TARGETS];
+  unsigned int expected_changes = 0, ups = 0, downs = 0;
+  int i, t;
+
+  probe_raw = raw;
+  probe_id = 0x4242;
+  probe_replies = replies;
+  probe_losses = losses;
+  probe_change = target_changed;
+  changes = 0;
+
+  for (t = 0; t < TARGETS; t++) {
+    targets[t] = probe_add_target(addresses[t]);
+    CHECK(targets[t] != NULL);
+    answered[t] = up[t] = false;
+    replies_in_row[t] = losses_in_row[t] = received[t] = 0;
+  }
+  CHECK(probe_add_target("192.0.2") == NULL);
+
+  for (i = 0; i < INTERVALS; i++) {
+    sent_count = 0;
+    probe_interval(NULL);
+
+    /* the probes lost in the last interval are accounted now */
+    for (t = 0; t < TARGETS; t++) {
+      if (i > 0 && !answered[t]) {
+        replies_in_row[t] = 0;
+        if (++losses_in_row[t] >= losses && up[t]) {
+          up[t] = false;
+          expected_changes++;
+          downs++;
+        }
+      }
+      CHECK(targets[t]->up == up[t]);
+    }
+
+    /* every target got exactly one well formed probe */
+    CHECK(sent_count == TARGETS);
+    for (t = 0; t < TARGETS; t++) {
+      struct packet *probe = sent_to(targets[t]);
+      const struct probe_echo *echo;
+
+      CHECK(probe != NULL);
+      if (!probe) {
+        return;
+      }
+      echo = (const struct probe_echo *)(const void *)probe->data;
+      CHECK(echo->type == ICMP_TYPE_ECHO_REQUEST && ntohs(echo->id) == probe_id);
+      CHECK(ntohs(echo->seq) == targets[t]->seq && targets[t]->outstanding);
+      CHECK(probe_checksum(probe->data, probe->len) == 0);
+    }
+
+    /* answer some probes, in any order and among replies that do not match */
+    for (t = 0; t < TARGETS; t++) {
+      const struct probe_target *target = targets[t];
+
+      /* long runs of replies and of losses, so the target goes up and down */
+      answered[t] = random() % 8 < ((i / 40 + t) % 2 ? 7 : 1);
+      if (random() % 4 == 0) {
+        queue_bogus_reply(target, targets[(t + 1) % TARGETS]);
+      }
+      if (answered[t]) {
+        queue_reply(target->addr, ICMP_TYPE_ECHO_REPLY, probe_id, target->seq, 0);
+        if (random() % 4 == 0) {
+          /* a duplicate */
+          queue_reply(target->addr, ICMP_TYPE_ECHO_REPLY, probe_id, target->seq, 0);
+        }
+      }
+    }
+    probe_receive(0, NULL, 0);
+    CHECK(queue_count == 0);
+
+    for (t = 0; t < TARGETS; t++) {
+      if (answered[t]) {
+        received[t]++;
+        losses_in_row[t] = 0;
+        if (++replies_in_row[t] >= replies && !up[t]) {
+          up[t] = true;
+          expected_changes++;
+          ups++;
+        }
+      }
+      CHECK(targets[t]->up == up[t]);
+      CHECK(targets[t]->outstanding == !answered[t]);
+      CHECK(targets[t]->replies_in_row == replies_in_row[t]);
+      CHECK(targets[t]->received == received[t]);
+      CHECK(targets[t]->sent == (unsigned long)i + 1);
+    }
+  }
+  CHECK(changes == expected_changes);
+  CHECK(ups > 20 && downs > 20);
+
+  printf("%s socket, up after %u, down after %u: %u up, %u down\n", raw ? "raw" : "ping", replies, losses, ups, downs);
+  probe_stop();
+}
+
+int
+main(void)
+{
+  harness_init(AF_INET);
+  olsr_cnf->debug_level = 0;
+  srandom(42);
+
+  run(false, 1, 1);
+  run(false, 3, 2);
+  run(true, 2, 4);
+  run(true, 5, 3);
+
+  return harness_result("dyn_gw_probe");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,172 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Test of the file watches: a watched file is reported when it is
+ * written or removed, and the watch comes back after its directory
+ * was removed and created again.
+ */
+
+#include "harness.h"
+#include "olsr.h"
+#include "scheduler.h"
+#include "file_watch.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#ifdef __linux__
+
+/* longer than the retry interval of lost watches */
+#define STEP_INTERVAL 1200
+
+static char base[] = "/tmp/olsrd_test_XXXXXX";
+static char dir[sizeof(base) + 16];
+static char file[sizeof(dir) + 16];
+
+static unsigned int calls;
+static unsigned int step;
+
+static void
+file_changed(const char *path, void *data __attribute__ ((unused)))
+{
+  CHECK(strcmp(path, file) == 0);
+  calls++;
+}
+
+static void
+write_file(void)
+{
+  FILE *fp = fopen(file, "w");
+
+  CHECK(fp != NULL);
+  if (fp) {
+    fputs("test\n", fp);
+    fclose(fp);
+  }
+}
+
+static void
+test_step(void *context __attribute__ ((unused)))
+{
+  switch (step++) {
+  case 0:
+    write_file();
+    break;
+  case 1:
+    CHECK(calls == 1);
+    calls = 0;
+    /* the watch on the directory is lost */
+    CHECK(unlink(file) == 0);
+    CHECK(rmdir(dir) == 0);
+    break;
+  case 2:
+    /* the removal and at least one poll */
+    CHECK(calls >= 2);
+    CHECK(mkdir(dir, 0700) == 0);
+    break;
+  case 3:
+    /* the watch is back */
+    calls = 0;
+    write_file();
+    break;
+  case 4:
+    CHECK(calls == 1);
+    calls = 0;
+    break;
+  default:
+    /* no more polling */
+    CHECK(calls == 0);
+    olsr_scheduler_stop();
+    break;
+  }
+}
+
+int
+main(void)
+{
+  struct file_watch *watch;
+
+  harness_init(AF_INET);
+
+  CHECK(mkdtemp(base) != NULL);
+  snprintf(dir, sizeof(dir), "%s/watched", base);
+  snprintf(file, sizeof(file), "%s/file", dir);
+  CHECK(mkdir(dir, 0700) == 0);
+
+  watch = olsr_file_watch_add(file, &file_changed, NULL);
+  CHECK(watch != NULL);
+
+  olsr_start_timer(STEP_INTERVAL, 0, OLSR_TIMER_PERIODIC, &test_step, NULL, NULL);
+  olsr_scheduler();
+
+  olsr_file_watch_remove(watch);
+  unlink(file);
+  rmdir(dir);
+  rmdir(base);
+
+  return harness_result("test_file_watch");
+}
+
+#else /* __linux__ */
+
+int
+main(void)
+{
+  printf("test_file_watch: skipped, files are only watched on Linux\n");
+  return EXIT_SUCCESS;
+}
+
+#endif /* __linux__ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
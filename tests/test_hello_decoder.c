@@ -0,0 +1,378 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Test of olsr_deserialize_hello(): random well formed HELLO and
+ * LQ_HELLO messages must decode to the same neighbor list as with the
+ * decoder before the single pass rewrite, and truncated or corrupted
+ * messages must never be read beyond their end.
+ */
+
+#include "harness.h"
+#include "olsr.h"
+#include "ipcalc.h"
+#include "lq_packet.h"
+#include "lq_plugin.h"
+#include "process_package.h"
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define ITERATIONS 20000
+#define MAX_BLOCKS 6
+#define MAX_BLOCK_ENTRIES 5
+
+/* the decoder before the single pass rewrite, as reference */
+static int
+old_deserialize_hello(struct hello_message *hello, const void *ser)
+{
+  static const int LINK_ORDER[] = HELLO_LINK_ORDER_ARRAY;
+  const unsigned char *curr, *limit;
+  uint8_t type;
+  uint16_t size;
+  const unsigned char *curr_saved;
+  unsigned int idx;
+  struct hello_neighbor *neigh_unspec_first_prev = NULL;
+  struct hello_neighbor *neigh_unspec_first = NULL;
+
+  assert(LINK_ORDER[0] == UNSPEC_LINK);
+
+  memset (hello, 0, sizeof(*hello));
+
+  curr = ser;
+  pkt_get_u8(&curr, &type);
+  if (type != HELLO_MESSAGE && type != LQ_HELLO_MESSAGE) {
+    /* No need to do anything more */
+    return 1;
+  }
+  pkt_get_reltime(&curr, &hello->vtime);
+  pkt_get_u16(&curr, &size);
+  pkt_get_ipaddress(&curr, &hello->source_addr);
+
+  pkt_get_u8(&curr, &hello->ttl);
+  pkt_get_u8(&curr, &hello->hop_count);
+  pkt_get_u16(&curr, &hello->packet_seq_number);
+  pkt_ignore_u16(&curr);
+
+  pkt_get_reltime(&curr, &hello->htime);
+  pkt_get_u8(&curr, &hello->willingness);
+
+  hello->neighbors = NULL;
+
+  limit = ((const unsigned char *)ser) + size;
+
+  curr_saved = curr;
+
+  for (idx = 0; idx < (sizeof(LINK_ORDER) / sizeof(LINK_ORDER[0])); idx++) {
+    curr = curr_saved;
+
+    while (curr < limit) {
+      const unsigned char *limit2 = curr;
+      uint8_t link_code;
+      uint16_t size2;
+
+      pkt_get_u8(&curr, &link_code);
+      pkt_ignore_u8(&curr);
+      pkt_get_u16(&curr, &size2);
+
+      limit2 += size2;
+
+      if (EXTRACT_LINK(link_code) != LINK_ORDER[idx]) {
+        curr = limit2;
+        continue;
+      }
+
+      while (curr < limit2) {
+        struct hello_neighbor *neigh = olsr_malloc_hello_neighbor("old HELLO deserialization");
+        pkt_get_ipaddress(&curr, &neigh->address);
+        if (type == LQ_HELLO_MESSAGE) {
+          olsr_deserialize_hello_lq_pair(&curr, neigh);
+        }
+        neigh->link = EXTRACT_LINK(link_code);
+        neigh->status = EXTRACT_STATUS(link_code);
+
+        neigh->next = hello->neighbors;
+        hello->neighbors = neigh;
+
+        if (neigh->link == UNSPEC_LINK) {
+          neigh_unspec_first = neigh;
+        } else if (!neigh_unspec_first_prev) {
+          neigh_unspec_first_prev = neigh;
+        }
+      }
+    }
+  }
+
+  if (neigh_unspec_first_prev && neigh_unspec_first) {
+    struct hello_neighbor *neigh;
+    for (neigh = hello->neighbors; neigh && (neigh != neigh_unspec_first); neigh = neigh->next) {
+      struct hello_neighbor *neigh_cull;
+      struct hello_neighbor *neigh_cull_prev;
+      struct hello_neighbor *neigh_cull_next;
+
+      for (neigh_cull_prev = neigh_unspec_first_prev, neigh_cull = neigh_unspec_first;
+           neigh_cull;
+           neigh_cull = neigh_cull_next) {
+        neigh_cull_next = neigh_cull->next;
+
+        if (!ipequal(&neigh_cull->address, &neigh->address)) {
+          neigh_cull_prev = neigh_cull;
+          continue;
+        }
+
+        if (neigh_cull == neigh_unspec_first) {
+          neigh_unspec_first = neigh_cull_next;
+        }
+
+        neigh_cull_prev->next = neigh_cull_next;
+        free(neigh_cull);
+      }
+    }
+  }
+
+  return 0;
+}
+
+static unsigned int
+hello_header_size(void)
+{
+  return 12 + olsr_cnf->ipsize;
+}
+
+/* write a random message into buf, return its size */
+static unsigned int
+build_hello(uint8_t *buf, bool lq)
+{
+  unsigned int entry_size = olsr_cnf->ipsize + (lq ? olsr_sizeof_hello_lqdata() : 0);
+  unsigned int p, i, blocks;
+
+  memset(buf, 0, hello_header_size());
+  buf[0] = lq ? LQ_HELLO_MESSAGE : HELLO_MESSAGE;
+  buf[1] = rand();
+  for (p = 4; p < hello_header_size(); p++) {
+    buf[p] = rand();
+  }
+
+  blocks = rand() % (MAX_BLOCKS + 1);
+  for (i = 0; i < blocks; i++) {
+    unsigned int entries = rand() % (MAX_BLOCK_ENTRIES + 1), size2 = 4 + entries * entry_size, j;
+
+    buf[p] = CREATE_LINK_CODE(rand() % 3, rand() % 4);
+    buf[p + 1] = 0;
+    buf[p + 2] = size2 >> 8;
+    buf[p + 3] = size2 & 0xff;
+    p += 4;
+    for (j = 0; j < entries; j++) {
+      unsigned int k;
+
+      for (k = 0; k < entry_size; k++) {
+        buf[p + k] = rand();
+      }
+      if (rand() % 2) {
+        /* few distinct addresses, so that UNSPEC_LINK entries are culled */
+        memset(buf + p, 0, olsr_cnf->ipsize);
+        buf[p + olsr_cnf->ipsize - 1] = rand() % 4;
+      }
+      p += entry_size;
+    }
+  }
+
+  buf[2] = p >> 8;
+  buf[3] = p & 0xff;
+  return p;
+}
+
+/* the link quality is compared as sent, the plugin leaves parts of it uninitialized */
+static bool
+same_neighbor(struct hello_neighbor *a, struct hello_neighbor *b)
+{
+  unsigned char lq_a[32], lq_b[32];
+  int len_a, len_b;
+
+  assert(olsr_sizeof_hello_lqdata() <= sizeof(lq_a));
+  len_a = active_lq_handler->serialize_hello_lq(lq_a, a->linkquality);
+  len_b = active_lq_handler->serialize_hello_lq(lq_b, b->linkquality);
+
+  return a->link == b->link && a->status == b->status && ipequal(&a->address, &b->address)
+    && len_a == len_b && memcmp(lq_a, lq_b, len_a) == 0;
+}
+
+static void
+test_equivalence(bool lq)
+{
+  uint8_t buf[MAX_BLOCKS * (4 + MAX_BLOCK_ENTRIES * 32) + 64];
+  int i;
+
+  for (i = 0; i < ITERATIONS; i++) {
+    struct hello_message old_hello, new_hello;
+    struct hello_neighbor *o, *n;
+
+    build_hello(buf, lq);
+    CHECK(old_deserialize_hello(&old_hello, buf) == 0);
+    CHECK(olsr_deserialize_hello(&new_hello, buf) == 0);
+
+    CHECK(old_hello.vtime == new_hello.vtime);
+    CHECK(old_hello.htime == new_hello.htime);
+    CHECK(old_hello.willingness == new_hello.willingness);
+    CHECK(old_hello.ttl == new_hello.ttl);
+    CHECK(old_hello.hop_count == new_hello.hop_count);
+    CHECK(old_hello.packet_seq_number == new_hello.packet_seq_number);
+    CHECK(ipequal(&old_hello.source_addr, &new_hello.source_addr));
+
+    for (o = old_hello.neighbors, n = new_hello.neighbors; o && n; o = o->next, n = n->next) {
+      CHECK(same_neighbor(o, n));
+    }
+    CHECK(o == NULL && n == NULL);
+
+    olsr_free_hello_packet(&old_hello);
+  }
+}
+
+/*
+ * Decode truncated and corrupted messages that end right before a
+ * PROT_NONE page, any read beyond the message end faults.
+ */
+static void
+test_bounds(bool lq)
+{
+  long page_size = sysconf(_SC_PAGESIZE);
+  uint8_t buf[MAX_BLOCKS * (4 + MAX_BLOCK_ENTRIES * 32) + 64];
+  uint8_t *pages;
+  int i;
+
+  pages = mmap(NULL, 2 * page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  assert(pages != MAP_FAILED);
+  CHECK(mprotect(pages + page_size, page_size, PROT_NONE) == 0);
+
+  for (i = 0; i < ITERATIONS; i++) {
+    struct hello_message hello;
+    struct hello_neighbor *neigh;
+    unsigned int size, count = 0, j;
+    uint8_t *msg;
+
+    size = build_hello(buf, lq);
+    if (size > hello_header_size()) {
+      size = hello_header_size() + rand() % (size - hello_header_size() + 1);
+    }
+    for (j = rand() % 4; j > 0; j--) {
+      /* corrupt the link blocks, the message size stays valid */
+      if (size > hello_header_size()) {
+        buf[hello_header_size() + rand() % (size - hello_header_size())] = rand();
+      }
+    }
+    buf[2] = size >> 8;
+    buf[3] = size & 0xff;
+
+    msg = pages + page_size - size;
+    memcpy(msg, buf, size);
+    CHECK(olsr_deserialize_hello(&hello, msg) == 0);
+
+    for (neigh = hello.neighbors; neigh; neigh = neigh->next) {
+      count++;
+    }
+    CHECK(count <= (size - hello_header_size()) / olsr_cnf->ipsize);
+  }
+
+  /* a block whose last LQ_HELLO entry lacks its link quality */
+  if (lq) {
+    struct hello_message hello;
+    unsigned int size, size2 = 4 + olsr_cnf->ipsize;
+    uint8_t *msg;
+
+    build_hello(buf, true);
+    size = hello_header_size();
+    buf[size] = CREATE_LINK_CODE(SYM_NEIGH, SYM_LINK);
+    buf[size + 1] = 0;
+    buf[size + 2] = size2 >> 8;
+    buf[size + 3] = size2 & 0xff;
+    memset(buf + size + 4, 1, olsr_cnf->ipsize);
+    size += size2;
+    buf[2] = size >> 8;
+    buf[3] = size & 0xff;
+
+    msg = pages + page_size - size;
+    memcpy(msg, buf, size);
+    CHECK(olsr_deserialize_hello(&hello, msg) == 0);
+    CHECK(hello.neighbors == NULL);
+  }
+
+  munmap(pages, 2 * page_size);
+}
+
+int
+main(void)
+{
+  int v6;
+
+  harness_init(AF_INET);
+  harness_init_tables(NULL);
+  srand(1);
+
+  for (v6 = 0; v6 < 2; v6++) {
+    if (v6) {
+      /* the decoder only depends on the address size */
+      olsr_cnf->ip_version = AF_INET6;
+      olsr_cnf->ipsize = sizeof(struct in6_addr);
+      olsr_cnf->maxplen = 128;
+    }
+    test_equivalence(false);
+    test_equivalence(true);
+    test_bounds(false);
+    test_bounds(true);
+  }
+
+  return harness_result("test_hello_decoder");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,437 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Test of the window sums of the etx_ff and etx_ffeth LQ plugins: the
+ * running sums kept by the packet parser and the timer give the same
+ * link qualities, bit for bit, as summing the whole received[] and
+ * total[] window on every timer tick, as the plugins did before.
+ *
+ * The plugins are included to reach their static functions, and their
+ * handlers are renamed so they do not clash with the ones linked into
+ * the daemon objects. The links are created by HELLOs while the handler
+ * under test is the active one.
+ */
+
+#include "harness.h"
+
+#define lq_etx_ff_handler test_lq_etx_ff_handler
+#include "../src/lq_plugin_default_ff.c"
+#undef lq_etx_ff_handler
+
+#define lq_etx_ffeth_handler test_lq_etx_ffeth_handler
+#define default_lq_get_cost_scaled default_lq_get_cost_scaled_ffeth
+#include "../src/lq_plugin_default_ffeth.c"
+#undef lq_etx_ffeth_handler
+#undef default_lq_get_cost_scaled
+
+#include "link_set.h"
+#include "interfaces.h"
+#include "lq_packet.h"
+#include "process_package.h"
+#include "fpm.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#define LINKS 16
+#define TICKS 3000
+#define WINDOW 32
+
+/* the hello data of a link, the same fields in both plugins */
+struct window {
+  uint8_t *windowSize, *activePtr;
+  uint16_t *last_seq_nr, *missed_hellos;
+  uint16_t *received, *total;
+  uint32_t *receivedSum, *totalSum;
+  uint8_t *lq, *nlq, *smoothed_lq, *smoothed_nlq;
+  bool *perfect_eth;
+};
+
+#define WINDOW_OF(w, hello) do { \
+  (w)->windowSize = &(hello)->windowSize; \
+  (w)->activePtr = &(hello)->activePtr; \
+  (w)->last_seq_nr = &(hello)->last_seq_nr; \
+  (w)->missed_hellos = &(hello)->missed_hellos; \
+  (w)->received = (hello)->received; \
+  (w)->total = (hello)->total; \
+  (w)->receivedSum = &(hello)->receivedSum; \
+  (w)->totalSum = &(hello)->totalSum; \
+  (w)->lq = &(hello)->lq.valueLq; \
+  (w)->nlq = &(hello)->lq.valueNlq; \
+  (w)->smoothed_lq = &(hello)->smoothed_lq.valueLq; \
+  (w)->smoothed_nlq = &(hello)->smoothed_lq.valueNlq; \
+} while (0)
+
+/* the window as the timer of the plugins used it before */
+struct old_window {
+  uint8_t windowSize, activePtr;
+  uint16_t received[WINDOW], total[WINDOW];
+  uint16_t missed_hellos;
+  uint8_t lq;
+  bool perfect_eth;
+};
+
+struct plugin {
+  const char *name;
+  struct lq_handler *handler;
+  packetparser_function *parser;
+  void (*timer) (void *);
+  void (*window) (struct link_entry *, struct window *);
+  bool ethernet_booster;
+  uint8_t settled;              /* the second pass of handle_lqchange() skips links with both LQs at or above it */
+};
+
+static void
+ff_window(struct link_entry *link, struct window *w)
+{
+  struct default_lq_ff_hello *hello = (struct default_lq_ff_hello *)link->linkquality;
+
+  WINDOW_OF(w, hello);
+  w->perfect_eth = NULL;
+}
+
+static void
+ffeth_window(struct link_entry *link, struct window *w)
+{
+  struct default_lq_ffeth_hello *hello = (struct default_lq_ffeth_hello *)link->linkquality;
+
+  WINDOW_OF(w, hello);
+  w->perfect_eth = &hello->perfect_eth;
+}
+
+static const struct plugin plugins[] = {
+  { "etx_ff", &test_lq_etx_ff_handler, &default_lq_parser_ff, &default_lq_ff_timer, &ff_window, false, 255 },
+  { "etx_ffeth", &test_lq_etx_ffeth_handler, &default_lq_parser_ffeth, &default_lq_ffeth_timer, &ffeth_window, true, 254 },
+};
+
+static struct interface_olsr ifs[2];
+static char if_names[2][8] = { "mesh0", "eth0" };
+static union olsr_ip_addr remote[LINKS];
+static uint16_t seqno[LINKS];
+
+/* a HELLO from a neighbor, which lists the interface as symmetric */
+static void
+hello(int n)
+{
+  struct interface_olsr *in_if = &ifs[n % 2];
+  uint8_t msg[64];
+  unsigned int entry_size = 4 + olsr_cnf->ipsize + olsr_sizeof_hello_lqdata();
+  unsigned int size = 16 + entry_size;
+
+  memset(msg, 0, sizeof(msg));
+  msg[0] = LQ_HELLO_MESSAGE;
+  msg[1] = 0xe8;
+  msg[2] = size >> 8;
+  msg[3] = size & 0xff;
+  memcpy(msg + 4, &remote[n], olsr_cnf->ipsize);
+  msg[8] = 1;
+  msg[14] = 0x86;
+  msg[15] = WILL_DEFAULT;
+  msg[16] = CREATE_LINK_CODE(SYM_NEIGH, SYM_LINK);
+  msg[19] = entry_size;
+  memcpy(msg + 20, &in_if->ip_addr, olsr_cnf->ipsize);
+  msg[24] = 255;
+  msg[25] = 255;
+
+  olsr_input_hello((union olsr_message *)msg, in_if, &remote[n]);
+}
+
+static struct link_entry *
+link_of(int n)
+{
+  return lookup_link_entry(&remote[n], NULL, &ifs[n % 2]);
+}
+
+/* the sums must always cover exactly the active window */
+static bool
+sums_match(const struct window *w)
+{
+  uint32_t received = 0, total = 0;
+  int i;
+
+  for (i = 0; i < *w->windowSize; i++) {
+    received += w->received[i];
+    total += w->total[i];
+  }
+  return received == *w->receivedSum && total == *w->totalSum;
+}
+
+static void
+old_window_save(struct old_window *old, const struct window *w)
+{
+  old->windowSize = *w->windowSize;
+  old->activePtr = *w->activePtr;
+  memcpy(old->received, w->received, sizeof(old->received));
+  memcpy(old->total, w->total, sizeof(old->total));
+  old->missed_hellos = *w->missed_hellos;
+  old->lq = *w->lq;
+  old->perfect_eth = w->perfect_eth ? *w->perfect_eth : false;
+}
+
+/* one tick of the timer as it was, with the sums over the whole window */
+static void
+old_timer(const struct plugin *plugin, const struct link_entry *link, struct old_window *old)
+{
+  fpm ratio;
+  int i, received = 0, total = 0;
+
+  if (old->windowSize < WINDOW) {
+    old->windowSize++;
+  }
+  for (i = 0; i < old->windowSize; i++) {
+    received += old->received[i];
+    total += old->total[i];
+  }
+
+  if (total == 0) {
+    old->lq = 0;
+  } else {
+    ratio = fpmidiv(itofpm(link->loss_link_multiplier), LINK_LOSS_MULTIPLIER);
+    if (old->missed_hellos > 1) {
+      uint32_t interval = old->missed_hellos * link->loss_helloint / 1000;
+
+      if (interval > WINDOW) {
+        received = 0;
+      } else {
+        received = (received * (WINDOW - interval)) / WINDOW;
+      }
+    }
+    ratio = fpmmuli(ratio, received);
+    ratio = fpmidiv(ratio, total);
+    ratio = fpmmuli(ratio, 255);
+    old->lq = (uint8_t) (fpmtoi(ratio));
+  }
+
+  if (plugin->ethernet_booster) {
+    if (link->inter->mode == IF_MODE_ETHER) {
+      if (old->lq > (uint8_t) (0.95 * 255)) {
+        old->perfect_eth = true;
+      } else if (old->lq > (uint8_t) (0.90 * 255)) {
+        old->perfect_eth = false;
+      }
+      if (old->perfect_eth) {
+        old->lq = 255;
+      }
+    } else if (old->lq > 0) {
+      old->lq--;
+    }
+  }
+
+  old->activePtr = (old->activePtr + 1) % WINDOW;
+  old->total[old->activePtr] = 0;
+  old->received[old->activePtr] = 0;
+}
+
+/* the packets of one second from a neighbor */
+static unsigned int overflows;
+
+static void
+packets(const struct plugin *plugin, int n, int tick)
+{
+  struct link_entry *link = link_of(n);
+  struct window w;
+  struct olsr olsr;
+  int count, i;
+
+  plugin->window(link, &w);
+  memset(&olsr, 0, sizeof(olsr));
+
+  /* good and bad phases, now and then a burst that overflows a slot */
+  if ((tick / 100) % 4 == 0 && n % 2 != 0) {
+    count = random() % 2;
+  } else if (random() % 500 == 0) {
+    count = 300;
+  } else {
+    count = 1;
+  }
+
+  for (i = 0; i < count; i++) {
+    uint16_t total = w.total[*w.activePtr];
+    long r = random() % 200;
+
+    if (count > 1) {
+      seqno[n] += (uint16_t)(200 + random() % 57);
+    } else if (r < 180) {
+      seqno[n]++;
+    } else if (r < 196) {
+      /* lost packets */
+      seqno[n] += (uint16_t)(2 + random() % 8);
+    } else if (r < 198) {
+      /* a restart of the neighbor */
+      seqno[n] += (uint16_t)(300 + random() % 30000);
+    }
+    /* else a duplicate */
+
+    olsr.olsr_seqno = seqno[n];
+    plugin->parser(&olsr, &ifs[n % 2], &remote[n]);
+    CHECK(*w.last_seq_nr == seqno[n]);
+    CHECK(sums_match(&w));
+    overflows += w.total[*w.activePtr] < total;
+  }
+
+  /* lost HELLOs */
+  if ((tick / 100) % 4 == 0 && n % 2 != 0) {
+    olsr_update_packet_loss_worker(link, true);
+  }
+}
+
+static void
+run(const struct plugin *plugin)
+{
+  struct old_window old[LINKS];
+  unsigned int triggered = 0, changes = 0;
+  int n, tick;
+
+  /* links that belong to the handler under test */
+  active_lq_handler = plugin->handler;
+  for (n = 0; n < LINKS; n++) {
+    hello(n);
+    CHECK(link_of(n) != NULL);
+    seqno[n] = (uint16_t)random();
+  }
+
+  for (tick = 0; tick < TICKS; tick++) {
+    uint8_t smoothed[LINKS][2];
+    bool any_changed = false;
+
+    for (n = 0; n < LINKS; n++) {
+      packets(plugin, n, tick);
+    }
+
+    for (n = 0; n < LINKS; n++) {
+      struct link_entry *link = link_of(n);
+      struct window w;
+
+      plugin->window(link, &w);
+      old_window_save(&old[n], &w);
+      old_timer(plugin, link, &old[n]);
+      smoothed[n][0] = *w.smoothed_lq;
+      smoothed[n][1] = *w.smoothed_nlq;
+    }
+
+    plugin->timer(NULL);
+
+    for (n = 0; n < LINKS; n++) {
+      struct link_entry *link = link_of(n);
+      struct window w;
+
+      plugin->window(link, &w);
+      CHECK(*w.lq == old[n].lq);
+      CHECK(*w.windowSize == old[n].windowSize && *w.activePtr == old[n].activePtr);
+      CHECK(memcmp(w.received, old[n].received, sizeof(old[n].received)) == 0);
+      CHECK(memcmp(w.total, old[n].total, sizeof(old[n].total)) == 0);
+      CHECK(!w.perfect_eth || *w.perfect_eth == old[n].perfect_eth);
+      CHECK(sums_match(&w));
+      CHECK(link->linkcost == plugin->handler->calc_hello_cost(link->linkquality));
+
+      if (smoothed[n][0] != *w.smoothed_lq || smoothed[n][1] != *w.smoothed_nlq) {
+        any_changed = true;
+        changes++;
+      }
+    }
+
+    /* when any link triggered, the second pass updated all links that are not settled */
+    if (any_changed) {
+      triggered++;
+      for (n = 0; n < LINKS; n++) {
+        struct window w;
+
+        plugin->window(link_of(n), &w);
+        CHECK((*w.smoothed_lq >= plugin->settled && *w.smoothed_nlq >= plugin->settled)
+              || (*w.smoothed_lq == *w.lq && *w.smoothed_nlq == *w.nlq));
+      }
+    }
+  }
+  CHECK(triggered > 0 && triggered < TICKS && overflows > 0);
+
+  printf("%s: %d ticks, %u with a relevant change, %u smoothed changes, %u overflowed slots\n", plugin->name, TICKS,
+         triggered, changes, overflows);
+
+  olsr_delete_all_link_entries();
+  overflows = 0;
+}
+
+int
+main(void)
+{
+  unsigned int i;
+  int n;
+
+  harness_init(AF_INET);
+  olsr_cnf->use_hysteresis = false;
+  olsr_cnf->main_addr.v4.s_addr = htonl(0x0a010001);
+  harness_init_tables(NULL);
+  srandom(42);
+
+  memset(ifs, 0, sizeof(ifs));
+  for (i = 0; i < ARRAYSIZE(ifs); i++) {
+    ifs[i].ip_addr.v4.s_addr = htonl(0x0a010001 + (i << 16));
+    ifs[i].int_name = if_names[i];
+    ifs[i].mode = i ? IF_MODE_ETHER : IF_MODE_MESH;
+    ifs[i].int_next = i + 1 < ARRAYSIZE(ifs) ? &ifs[i + 1] : NULL;
+  }
+  ifnet = &ifs[0];
+
+  memset(remote, 0, sizeof(remote));
+  for (n = 0; n < LINKS; n++) {
+    remote[n].v4.s_addr = htonl(0x0a010002 + ((n % 2) << 16) + n);
+  }
+
+  for (i = 0; i < ARRAYSIZE(plugins); i++) {
+    run(&plugins[i]);
+  }
+
+  ifnet = NULL;
+  return harness_result("lq_ff_window");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,202 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Test of LinkQualityRelevantChange: the parser rejects values outside
+ * of 0..100, and a noisy link triggers far fewer route recalculations
+ * with the default threshold than the unconditional recalculation that
+ * etx_float did on every HELLO before. The scanner is replaced by a
+ * single option.
+ */
+
+#define YYSTYPE struct conf_token *
+
+#include "harness.h"
+#include "olsr.h"
+#include "olsr_cfg.h"
+#include "link_set.h"
+#include "lq_plugin.h"
+#include "lq_plugin_default_float.h"
+#include "cfgparser/olsrd_conf.h"
+#include "cfgparser/oparse.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+
+#define HELLOS 2000
+#define LOSS_PERCENT 20
+
+/* the value of the option, NULL for an empty file */
+static const char *option_value;
+static unsigned int option_pos;
+
+int
+olsrd_cnf_scan(void)
+{
+  struct conf_token *value;
+
+  if (option_value == NULL || option_pos > 1) {
+    return 0;
+  }
+  if (option_pos++ == 0) {
+    yylval = NULL;
+    return TOK_LQ_RELEVANT_CHANGE;
+  }
+
+  value = calloc(1, sizeof(*value));
+  if (value == NULL) {
+    return 0;
+  }
+  value->integer = atoi(option_value);
+  yylval = value;
+  return TOK_INTEGER;
+}
+
+static int
+parse_option(const char *file, const char *value)
+{
+  option_value = value;
+  option_pos = 0;
+  return olsrd_parse_cnf(file);
+}
+
+/* @return number of route recalculations for HELLOS hellos on a lossy link */
+static unsigned int
+count_spf_runs(olsr_lq_smoothing_options smoothing, uint8_t relevant_change)
+{
+  struct link_entry *link;
+  struct default_lq_float_hello *lq;
+  unsigned int i, runs = 0;
+
+  olsr_cnf->lq_smoothing = smoothing;
+  olsr_cnf->lq_relevant_change = relevant_change;
+
+  link = olsr_malloc_link_entry("test link");
+  link->loss_link_multiplier = LINK_LOSS_MULTIPLIER;
+  link->linkcost = LINK_COST_BROKEN;
+  lq = (struct default_lq_float_hello *)link->linkquality;
+  lq->lq.nlq = 1.0f;
+
+  srand(1);
+  changes_neighborhood = false;
+  for (i = 0; i < HELLOS; i++) {
+    olsr_update_packet_loss_worker(link, rand() % 100 < LOSS_PERCENT);
+
+    /* olsr_process_changes() runs SPF once per poll interval if anything changed */
+    if (changes_neighborhood) {
+      runs++;
+      changes_neighborhood = false;
+      changes_topology = false;
+    }
+  }
+
+  free(link);
+  return runs;
+}
+
+int
+main(void)
+{
+  static const char *names[LQS_CNT] = { "ewma", "window", "kalman" };
+  char dir[] = "/tmp/olsrd_test_XXXXXX";
+  char file[sizeof(dir) + 16];
+  unsigned int every_change, relevant;
+  int i;
+  FILE *f;
+
+  harness_init(AF_INET);
+  harness_init_tables(LQ_ALGORITHM_ETX_FLOAT_NAME);
+  olsr_lq_smoothing_init();
+
+  /* the text is never read, olsrd_parse_cnf() only opens it */
+  CHECK(mkdtemp(dir) != NULL);
+  snprintf(file, sizeof(file), "%s/olsrd.conf", dir);
+  f = fopen(file, "w");
+  CHECK(f != NULL);
+  if (f != NULL) {
+    fclose(f);
+  }
+
+  CHECK(parse_option(file, "-1") < 0);
+  CHECK(parse_option(file, "101") < 0);
+  CHECK(parse_option(file, "0") == 0 && olsr_cnf->lq_relevant_change == 0);
+  CHECK(parse_option(file, "100") == 0 && olsr_cnf->lq_relevant_change == 100);
+
+  unlink(file);
+  rmdir(dir);
+
+  for (i = 0; i < LQS_CNT; i++) {
+    every_change = count_spf_runs(i, 0);
+    relevant = count_spf_runs(i, DEF_LQ_RELEVANT_CHANGE);
+
+    printf("%s: %u hellos with %u%% loss, %u SPF runs on every change, %u with LinkQualityRelevantChange %u\n",
+           names[i], HELLOS, LOSS_PERCENT, every_change, relevant, DEF_LQ_RELEVANT_CHANGE);
+    CHECK(relevant > 0);
+    CHECK(relevant * 4 < every_change);
+  }
+
+  return harness_result("test_lq_relevant_change");
+}
+
+#else /* __linux__ */
+
+int
+main(void)
+{
+  printf("test_lq_relevant_change: skipped\n");
+  return EXIT_SUCCESS;
+}
+
+#endif /* __linux__ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
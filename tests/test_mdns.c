@@ -0,0 +1,494 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Test of the relaying of the mdns plugin:
+ * - the captured packets that are aggregated into one OLSR message come
+ *   out of the receiving node as the same packets, in the same order
+ * - a packet with the same source and UDP content is relayed once per
+ *   duplicate window
+ * - the IP header checksum updated for the new TTL (RFC 1624) equals the
+ *   checksum computed over the whole header
+ *
+ * mdns.c is included to reach its static functions. The OLSR output
+ * buffer and the packet socket are replaced by functions that capture
+ * the OLSR messages and the forwarded packets.
+ */
+
+#include "harness.h"
+
+#ifdef __linux__
+
+#include <sys/socket.h>
+
+#include "interfaces.h"
+
+static int test_net_outbuffer_push(struct interface_olsr *ifp, const void *data, const uint16_t size);
+static int test_net_output(struct interface_olsr *ifp);
+static int test_check_neighbor_link(const union olsr_ip_addr *addr);
+static ssize_t test_sendto(int fd, const void *buf, size_t len, int flags, const struct sockaddr *to, socklen_t tolen);
+
+#define net_outbuffer_push test_net_outbuffer_push
+#define net_output test_net_output
+#define check_neighbor_link test_check_neighbor_link
+#define sendto test_sendto
+#include "../lib/mdns/src/mdns.c"
+#undef net_outbuffer_push
+#undef net_output
+#undef check_neighbor_link
+#undef sendto
+
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#define MAX_PACKETS 64
+#define MAX_PACKET_SIZE 1500
+#define ROUNDS 2000
+#define POOL 16
+#define EVENTS 20000
+#define CHECKSUMS 1000000
+
+struct packet {
+  unsigned char data[MAX_PACKET_SIZE + 64];
+  int len;
+};
+
+/* the OLSR messages sent */
+static struct packet messages[MAX_PACKETS];
+static int message_count;
+
+/* the packets forwarded to the non-OLSR interface */
+static struct packet forwarded[MAX_PACKETS];
+static int forwarded_count;
+
+static struct interface_olsr olsr_if;
+static struct TBmfInterface bmf_if;
+
+static int
+test_net_outbuffer_push(struct interface_olsr *ifp, const void *data, const uint16_t size)
+{
+  CHECK(ifp == &olsr_if && message_count < MAX_PACKETS && size <= sizeof(messages[0].data));
+  if (message_count < MAX_PACKETS && size <= sizeof(messages[0].data)) {
+    memcpy(messages[message_count].data, data, size);
+    messages[message_count++].len = size;
+  }
+  return size;
+}
+
+static int
+test_net_output(struct interface_olsr *ifp __attribute__ ((unused)))
+{
+  return 0;
+}
+
+static int
+test_check_neighbor_link(const union olsr_ip_addr *addr __attribute__ ((unused)))
+{
+  return SYM_LINK;
+}
+
+static ssize_t
+test_sendto(int fd, const void *buf, size_t len, int flags __attribute__ ((unused)),
+            const struct sockaddr *to __attribute__ ((unused)), socklen_t tolen __attribute__ ((unused)))
+{
+  CHECK(fd == bmf_if.capturingSkfd && forwarded_count < MAX_PACKETS && len <= sizeof(forwarded[0].data));
+  if (forwarded_count < MAX_PACKETS && len <= sizeof(forwarded[0].data)) {
+    memcpy(forwarded[forwarded_count].data, buf, len);
+    forwarded[forwarded_count++].len = (int)len;
+  }
+  return (ssize_t) len;
+}
+
+/* Internet checksum (RFC 1071) over the whole header */
+static uint16_t
+header_checksum(const unsigned char *header, int len)
+{
+  uint32_t sum = 0;
+  int i;
+
+  for (i = 0; i < len; i += 2) {
+    uint16_t word;
+
+    memcpy(&word, header + i, sizeof(word));
+    sum += word;
+  }
+  while (sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return (uint16_t)~sum;
+}
+
+static void
+set_header_checksum(struct ip *ip)
+{
+  ip->ip_sum = 0;
+  ip->ip_sum = header_checksum((unsigned char *)ip, ip->ip_hl * 4);
+}
+
+/* an mDNS packet from the given source with some content, IPv4 or IPv6 */
+static void
+make_packet(struct packet *packet, bool ipv6, int source, unsigned int content, int payload)
+{
+  struct udphdr *udp;
+  int offset, i;
+
+  memset(packet, 0, sizeof(*packet));
+  if (ipv6) {
+    struct ip6_hdr *ip6 = (struct ip6_hdr *)(void *)packet->data;
+
+    offset = 40;
+    ip6->ip6_flow = htonl(0x60000000);
+    ip6->ip6_plen = htons((uint16_t)(sizeof(*udp) + payload));
+    ip6->ip6_nxt = IPPROTO_UDP;
+    ip6->ip6_hops = 255;
+    ip6->ip6_src.s6_addr[0] = 0xfe;
+    ip6->ip6_src.s6_addr[1] = 0x80;
+    ip6->ip6_src.s6_addr[15] = (uint8_t)source;
+    inet_pton(AF_INET6, "ff02::fb", &ip6->ip6_dst);
+  } else {
+    struct ip *ip = (struct ip *)(void *)packet->data;
+
+    offset = 20;
+    ip->ip_v = 4;
+    ip->ip_hl = 5;
+    ip->ip_len = htons((uint16_t)(offset + sizeof(*udp) + payload));
+    ip->ip_id = (uint16_t)random();
+    ip->ip_ttl = (uint8_t)(2 + random() % 254);
+    ip->ip_p = IPPROTO_UDP;
+    ip->ip_src.s_addr = htonl(0x0a000000 + source);
+    ip->ip_dst.s_addr = htonl(0xe00000fb);
+    set_header_checksum(ip);
+  }
+
+  udp = (struct udphdr *)(void *)(packet->data + offset);
+  udp->source = htons(5353);
+  udp->dest = htons(5353);
+  udp->len = htons((uint16_t)(sizeof(*udp) + payload));
+  for (i = 0; i < payload; i++) {
+    packet->data[offset + sizeof(*udp) + i] = (unsigned char)(content * 31 + i);
+  }
+  packet->len = offset + (int)sizeof(*udp) + payload;
+}
+
+/* the packet as it leaves the receiving node: TTL 1 and a valid checksum */
+static bool
+packet_forwarded_as(const struct packet *sent, const struct packet *received)
+{
+  struct packet expected = *sent;
+
+  if ((expected.data[0] & 0xf0) == 0x40) {
+    struct ip *ip = (struct ip *)(void *)expected.data;
+
+    ip->ip_ttl = 1;
+    set_header_checksum(ip);
+  } else {
+    ((struct ip6_hdr *)(void *)expected.data)->ip6_hops = 1;
+  }
+  return received->len == expected.len && memcmp(received->data, expected.data, (size_t)expected.len) == 0;
+}
+
+/* hand the OLSR messages sent so far to the parser of the receiving node */
+static void
+receive_messages(void)
+{
+  union olsr_ip_addr neighbor;
+  int i;
+
+  neighbor.v4.s_addr = htonl(0x0a000063);
+  for (i = 0; i < message_count; i++) {
+    union olsr_message *m = (union olsr_message *)(void *)messages[i].data;
+
+    CHECK(ntohs(m->v4.olsr_msgsize) == messages[i].len && messages[i].len % 4 == 0);
+    /* the message of another node */
+    m->v4.originator = neighbor.v4.s_addr;
+    CHECK(olsr_parser(m, NULL, &neighbor));
+  }
+}
+
+static void
+test_aggregation(void)
+{
+  static struct packet sent[MAX_PACKETS];
+  int round, i, aggregated = 0, single = 0, split = 0;
+
+  my_AggregationInterval = 100;
+  my_DuplicateWindow = 0;
+
+  for (round = 0; round < ROUNDS; round++) {
+    int count = 1 + random() % 12;
+    bool large = random() % 16 == 0;
+
+    message_count = forwarded_count = 0;
+    for (i = 0; i < count; i++) {
+      int payload = large && i == count / 2 ? MDNS_AGGREGATION_MAX : random() % 300;
+
+      make_packet(&sent[i], random() % 4 == 0, 1 + random() % 200, (unsigned int)random(), payload);
+      BmfPacketCaptured(sent[i].data, sent[i].len);
+    }
+    /* the timer of the plugin fires */
+    CHECK(AggregationTimer != NULL || AggregatedCount == 0);
+    FlushAggregatedPackets();
+    CHECK(AggregationTimer == NULL && AggregatedCount == 0 && AggregatedLength == 0);
+
+    for (i = 0; i < message_count; i++) {
+      union olsr_message *m = (union olsr_message *)(void *)messages[i].data;
+
+      CHECK(ntohs(m->v4.olsr_msgsize) - olsr_mdns_header_size() <= (large ? 2 * MDNS_AGGREGATION_MAX : MDNS_AGGREGATION_MAX));
+      if (m->v4.olsr_msgtype == MESSAGE_TYPE_AGGREGATED) {
+        aggregated++;
+      } else {
+        CHECK(m->v4.olsr_msgtype == MESSAGE_TYPE);
+        single++;
+      }
+    }
+    CHECK(message_count <= count);
+    split += message_count > 1;
+
+    receive_messages();
+    CHECK(forwarded_count == count);
+    for (i = 0; i < count && i < forwarded_count; i++) {
+      CHECK(packet_forwarded_as(&sent[i], &forwarded[i]));
+    }
+  }
+  CHECK(aggregated > 0 && single > 0 && split > 0);
+
+  /* a truncated aggregated message only gives the complete packets */
+  message_count = forwarded_count = 0;
+  for (i = 0; i < 3; i++) {
+    make_packet(&sent[i], false, 1 + i, (unsigned int)i, 50 + i);
+    BmfPacketCaptured(sent[i].data, sent[i].len);
+  }
+  FlushAggregatedPackets();
+  CHECK(message_count == 1);
+  if (message_count == 1) {
+    union olsr_message *m = (union olsr_message *)(void *)messages[0].data;
+
+    messages[0].len -= 8;
+    m->v4.olsr_msgsize = htons((uint16_t)messages[0].len);
+    receive_messages();
+    CHECK(forwarded_count == 2);
+  }
+
+  printf("%d aggregated and %d single messages, %d rounds in more than one message\n", aggregated, single, split);
+}
+
+static void
+test_duplicate_window(void)
+{
+  static struct packet pool[POOL];
+  uint32_t last[POOL];
+  bool relayed_before[POOL];
+  int i, relayed = 0, expected = 0;
+
+  my_AggregationInterval = 0;
+  my_DuplicateWindow = 1000;
+  memset(DuplicateCache, 0, sizeof(DuplicateCache));
+
+  /* distinct packets in distinct slots of the cache */
+  for (i = 0; i < POOL; i++) {
+    bool collision;
+
+    do {
+      struct udphdr *udp;
+      uint32_t hash;
+      int j;
+
+      make_packet(&pool[i], i % 2 != 0, 1 + i % 5, (unsigned int)random(), 20 + random() % 100);
+      udp = (struct udphdr *)(void *)(pool[i].data + GetIpHeaderLength(pool[i].data));
+      if (i % 2) {
+        hash = content_hash(2166136261U, (unsigned char *)&((struct ip6_hdr *)(void *)pool[i].data)->ip6_src, 16);
+      } else {
+        hash = content_hash(2166136261U, (unsigned char *)&((struct ip *)(void *)pool[i].data)->ip_src, 4);
+      }
+      hash = content_hash(hash, (unsigned char *)udp, pool[i].len - (int)((unsigned char *)udp - pool[i].data));
+      last[i] = hash & (DUPLICATE_CACHE_SIZE - 1);
+
+      collision = false;
+      for (j = 0; j < i; j++) {
+        collision |= last[j] == last[i];
+      }
+    } while (collision);
+    relayed_before[i] = false;
+  }
+
+  now_times = 1000000;
+  for (i = 0; i < EVENTS; i++) {
+    int k = random() % POOL;
+    struct packet copy = pool[k];
+
+    now_times += (uint32_t)(random() % 40);
+
+    /* the IP header is not part of the content */
+    if ((copy.data[0] & 0xf0) == 0x40) {
+      struct ip *ip = (struct ip *)(void *)copy.data;
+
+      ip->ip_id = (uint16_t)random();
+      ip->ip_ttl = (uint8_t)(2 + random() % 254);
+      set_header_checksum(ip);
+    }
+
+    message_count = 0;
+    BmfPacketCaptured(copy.data, copy.len);
+    CHECK(message_count <= 1);
+    relayed += message_count;
+
+    if (!relayed_before[k] || now_times - last[k] >= (uint32_t) my_DuplicateWindow) {
+      relayed_before[k] = true;
+      last[k] = now_times;
+      expected++;
+      CHECK(message_count == 1);
+    } else {
+      CHECK(message_count == 0);
+    }
+  }
+  CHECK(relayed == expected && relayed < EVENTS / 2);
+
+  /* without a window every packet is relayed */
+  my_DuplicateWindow = 0;
+  message_count = 0;
+  for (i = 0; i < 10; i++) {
+    BmfPacketCaptured(pool[0].data, pool[0].len);
+  }
+  CHECK(message_count == 10);
+
+  printf("%d of %d packets relayed with a window of 1000 ms\n", relayed, EVENTS);
+}
+
+static void
+test_checksum_update(void)
+{
+  unsigned char header[24];
+  struct ip *ip = (struct ip *)(void *)header;
+  int i, ttl;
+
+  for (i = 0; i < CHECKSUMS; i++) {
+    uint16_t oldWord, newWord, updated;
+    size_t j;
+
+    for (j = 0; j < sizeof(header); j++) {
+      header[j] = (unsigned char)random();
+    }
+    ip->ip_v = 4;
+    ip->ip_hl = random() % 2 ? 5 : 6;
+    /* all ones and all zeroes in the words around the changed one */
+    if (i % 8 == 0) {
+      memset(header + 4, i % 16 ? 0xff : 0, 4);
+    }
+    set_header_checksum(ip);
+
+    memcpy(&oldWord, &ip->ip_ttl, sizeof(oldWord));
+    ip->ip_ttl = i % 4 ? 1 : (uint8_t)random();
+    memcpy(&newWord, &ip->ip_ttl, sizeof(newWord));
+
+    updated = ip_checksum_update(ip->ip_sum, oldWord, newWord);
+    set_header_checksum(ip);
+    CHECK(updated == ip->ip_sum);
+    if (updated != ip->ip_sum) {
+      return;
+    }
+  }
+
+  /* every TTL and protocol of one header */
+  memset(header, 0, sizeof(header));
+  ip->ip_v = 4;
+  ip->ip_hl = 5;
+  for (ttl = 0; ttl < 65536; ttl++) {
+    uint16_t oldWord = (uint16_t)ttl, newWord, updated;
+
+    memcpy(&ip->ip_ttl, &oldWord, sizeof(oldWord));
+    set_header_checksum(ip);
+    ip->ip_ttl = 1;
+    memcpy(&newWord, &ip->ip_ttl, sizeof(newWord));
+
+    updated = ip_checksum_update(ip->ip_sum, oldWord, newWord);
+    set_header_checksum(ip);
+    CHECK(updated == ip->ip_sum);
+  }
+}
+
+int
+main(void)
+{
+  harness_init(AF_INET);
+  olsr_cnf->debug_level = 0;
+  olsr_cnf->main_addr.v4.s_addr = htonl(0x0a000001);
+  harness_init_tables(NULL);
+  srandom(42);
+
+  /* one OLSR interface to send on and one non-OLSR interface to forward to */
+  ifnet = &olsr_if;
+  bmf_if.capturingSkfd = 42;
+  bmf_if.isActive = 1;
+  strscpy(bmf_if.ifName, "lan0", sizeof(bmf_if.ifName));
+  BmfInterfaces = &bmf_if;
+  my_TTL_Check = true;
+
+  test_aggregation();
+  test_duplicate_window();
+  test_checksum_update();
+
+  ifnet = NULL;
+  BmfInterfaces = NULL;
+  return harness_result("mdns");
+}
+
+#else /* __linux__ */
+
+int
+main(void)
+{
+  printf("mdns: skipped\n");
+  return 0;
+}
+
+#endif /* __linux__ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,396 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Test of the metrics registry: the bucket boundaries, the quantiles and
+ * the cumulative Prometheus buckets of txtinfo against the exact values
+ * of the recorded samples, and the HTTP headers of /metrics when the
+ * plugin does not add them to other commands.
+ */
+
+#include "harness.h"
+#include "olsr.h"
+#include "olsr_metrics.h"
+#include "scheduler.h"
+#include "common/autobuf.h"
+#include "info/olsrd_info.h"
+#include "../lib/txtinfo/src/olsrd_txtinfo.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define TEST_PORT 29007
+#define SAMPLES 100000
+
+/* parameters of txtinfo, normally in its olsrd_plugin.c */
+info_plugin_config_t config;
+bool vtime = false;
+
+static info_plugin_functions_t test_functions;
+
+/**
+ * @return the bucket that a single sample is recorded in
+ */
+static unsigned int
+bucket_of(uint64_t nsec)
+{
+  static struct olsr_metric *metric;
+  static struct olsr_metric_values values;
+  unsigned int i, bucket = OLSR_METRIC_BUCKETS;
+
+  if (!metric) {
+    metric = olsr_metric_get(OLSR_METRIC_LATENCY, "bucket_of", "scratch", NULL, NULL);
+  }
+  memset(metric->buckets, 0, OLSR_METRIC_BUCKETS * sizeof(*metric->buckets));
+  olsr_metric_record(metric, nsec);
+  olsr_metric_read(metric, &values);
+  for (i = 0; i < OLSR_METRIC_BUCKETS; i++) {
+    if (values.buckets[i]) {
+      CHECK(bucket == OLSR_METRIC_BUCKETS && values.buckets[i] == 1);
+      bucket = i;
+    }
+  }
+  return bucket;
+}
+
+static void
+test_buckets(void)
+{
+  uint64_t nsec;
+  unsigned int i, bucket;
+  int exp;
+
+  /* the buckets are contiguous, start at 0 and are at most 1/8 wide */
+  CHECK(olsr_metric_bucket_lower(0) == 0);
+  for (i = 0; i < OLSR_METRIC_BUCKETS; i++) {
+    uint64_t lower = olsr_metric_bucket_lower(i), upper = olsr_metric_bucket_upper(i);
+
+    CHECK(lower < upper);
+    CHECK(!i || lower == olsr_metric_bucket_upper(i - 1));
+    CHECK(lower < OLSR_METRIC_SUB_BUCKETS || (upper - lower) * OLSR_METRIC_SUB_BUCKETS <= lower);
+  }
+  CHECK(olsr_metric_bucket_upper(OLSR_METRIC_BUCKETS - 1) == (uint64_t) 1 << (OLSR_METRIC_MAX_EXP + 1));
+
+  /* every sample lands in the bucket that contains it */
+  for (nsec = 0; nsec < 4096; nsec++) {
+    bucket = bucket_of(nsec);
+    CHECK(olsr_metric_bucket_lower(bucket) <= nsec && nsec < olsr_metric_bucket_upper(bucket));
+  }
+  for (exp = 12; exp <= OLSR_METRIC_MAX_EXP; exp++) {
+    uint64_t base = (uint64_t) 1 << exp;
+    uint64_t probes[5] = { base - 1, base, base + 1, base + base / 3, 2 * base - 1 };
+
+    for (i = 0; i < 5; i++) {
+      bucket = bucket_of(probes[i]);
+      CHECK(olsr_metric_bucket_lower(bucket) <= probes[i] && probes[i] < olsr_metric_bucket_upper(bucket));
+    }
+  }
+
+  /* larger samples are capped into the last bucket */
+  CHECK(bucket_of((uint64_t) 1 << (OLSR_METRIC_MAX_EXP + 1)) == OLSR_METRIC_BUCKETS - 1);
+  CHECK(bucket_of(UINT64_MAX) == OLSR_METRIC_BUCKETS - 1);
+}
+
+static void
+test_quantiles(void)
+{
+  static const double quantiles[] = { 0.01, 0.5, 0.9, 0.99, 0.999, 1.0 };
+  static struct olsr_metric_values values;
+  struct olsr_metric *metric;
+  uint64_t nsec;
+  unsigned int i;
+  int exp;
+
+  metric = olsr_metric_get(OLSR_METRIC_LATENCY, "quantiles", "uniform samples", NULL, NULL);
+  olsr_metric_read(metric, &values);
+  CHECK(olsr_metric_quantile(&values, 0.5) == 0);
+
+  /* one sample of every latency from 1 to SAMPLES ns */
+  for (nsec = 1; nsec <= SAMPLES; nsec++) {
+    olsr_metric_record(metric, nsec);
+  }
+  olsr_metric_read(metric, &values);
+  CHECK(values.count == SAMPLES);
+  CHECK(values.sum == (uint64_t) SAMPLES * (SAMPLES + 1) / 2);
+  CHECK(values.max == SAMPLES);
+
+  /* within the relative error of a bucket, and never above the maximum */
+  for (i = 0; i < ARRAYSIZE(quantiles); i++) {
+    uint64_t quantile = olsr_metric_quantile(&values, quantiles[i]);
+    double exact = quantiles[i] * SAMPLES;
+    double estimate = (double) quantile;
+
+    CHECK(estimate <= (double) values.max);
+    CHECK(estimate >= exact - exact / OLSR_METRIC_SUB_BUCKETS - 1);
+    CHECK(estimate <= exact + exact / OLSR_METRIC_SUB_BUCKETS + 1);
+  }
+
+  /* powers of two are bucket boundaries, the counts below them are exact */
+  for (exp = 0; exp <= 20; exp++) {
+    uint64_t limit = (uint64_t) 1 << exp;
+
+    CHECK(olsr_metric_count_below(&values, limit) == (limit > SAMPLES ? SAMPLES : limit - 1));
+  }
+  CHECK(olsr_metric_count_below(&values, UINT64_MAX) == SAMPLES);
+
+  /* a single sample is reported as itself */
+  metric = olsr_metric_get(OLSR_METRIC_LATENCY, "quantiles", "uniform samples", "case", "single");
+  olsr_metric_record(metric, 1000);
+  olsr_metric_read(metric, &values);
+  CHECK(olsr_metric_quantile(&values, 0.5) <= 1000);
+  CHECK(olsr_metric_quantile(&values, 0.5) * OLSR_METRIC_SUB_BUCKETS >= 1000 * (OLSR_METRIC_SUB_BUCKETS - 1));
+  CHECK(olsr_metric_quantile(&values, 1.0) <= 1000);
+}
+
+/**
+ * Check the histogram of a latency metric in the Prometheus output
+ *
+ * @param text the output of ipc_print_metrics()
+ * @param prefix the bucket series up to the value of "le"
+ * @param count_series the count series up to its value
+ * @param samples the recorded samples
+ * @param count the number of samples
+ */
+static void
+check_histogram(const char *text, const char *prefix, const char *count_series, const uint64_t *samples, unsigned int count)
+{
+  const char *line;
+  double last_le = -1;
+  unsigned long long last = 0;
+  unsigned int buckets = 0;
+  bool inf = false;
+
+  for (line = text; (line = strstr(line, prefix)) != NULL; line++) {
+    char le[32];
+    unsigned long long value;
+    unsigned int i, exact = 0;
+
+    if (sscanf(line + strlen(prefix), "%31[^\"]\"} %llu", le, &value) != 2) {
+      CHECK(false);
+      continue;
+    }
+    buckets++;
+
+    /* cumulative and in increasing order of le, +Inf comes last */
+    CHECK(!inf);
+    CHECK(value >= last);
+    last = value;
+    if (!strcmp(le, "+Inf")) {
+      inf = true;
+      CHECK(value == count);
+      continue;
+    }
+    CHECK(atof(le) > last_le);
+    last_le = atof(le);
+
+    /* the bounds are powers of two nanoseconds, the samples below them are counted exactly */
+    for (i = 0; i < count; i++) {
+      exact += (double) samples[i] < last_le * 1e9 - 0.5;
+    }
+    CHECK(value == exact);
+  }
+  CHECK(inf);
+  CHECK(buckets > 2);
+
+  /* the count agrees with the +Inf bucket */
+  line = strstr(text, count_series);
+  CHECK(line && strtoull(line + strlen(count_series), NULL, 10) == count);
+}
+
+static void
+test_prometheus(void)
+{
+  static const uint64_t samples[] = { 0, 1, 999, 1000, 1024, 65535, 65536, 1000000, 123456789, 2000000000 };
+  struct olsr_metric *metric;
+  struct autobuf abuf;
+  const char *line;
+  unsigned int i;
+
+  metric = olsr_metric_get(OLSR_METRIC_LATENCY, "prom", "a histogram", NULL, NULL);
+  for (i = 0; i < ARRAYSIZE(samples); i++) {
+    olsr_metric_record(metric, samples[i]);
+  }
+  metric = olsr_metric_get(OLSR_METRIC_LATENCY, "prom_labelled", "a family", "type", "a\"b\\c");
+  for (i = 0; i < 3; i++) {
+    olsr_metric_record(metric, samples[i * 3]);
+  }
+  metric = olsr_metric_get(OLSR_METRIC_COUNTER, "prom_counter", "a counter", NULL, NULL);
+  olsr_metrics_enable();
+  olsr_metric_add(metric, 42);
+  olsr_metrics_disable();
+
+  abuf_init(&abuf, 0);
+  ipc_print_metrics(&abuf);
+
+  check_histogram(abuf.buf, "olsrd_prom_seconds_bucket{le=\"", "\nolsrd_prom_seconds_count ",
+      samples, ARRAYSIZE(samples));
+  {
+    uint64_t labelled[3] = { samples[0], samples[3], samples[6] };
+
+    check_histogram(abuf.buf, "olsrd_prom_labelled_seconds_bucket{type=\"a\\\"b\\\\c\",le=\"",
+        "\nolsrd_prom_labelled_seconds_count{type=\"a\\\"b\\\\c\"} ", labelled, 3);
+  }
+
+  CHECK(strstr(abuf.buf, "# TYPE olsrd_prom_seconds histogram\n") != NULL);
+  CHECK(strstr(abuf.buf, "# TYPE olsrd_prom_counter_total counter\n") != NULL);
+  CHECK(strstr(abuf.buf, "\nolsrd_prom_counter_total 42\n") != NULL);
+  CHECK(strstr(abuf.buf, "\nolsrd_prom_seconds_sum 2.124590884\n") != NULL);
+
+  /* one HELP and TYPE per family, its metrics follow */
+  line = strstr(abuf.buf, "# TYPE olsrd_quantiles_seconds ");
+  CHECK(line && !strstr(line + 1, "# TYPE olsrd_quantiles_seconds "));
+  CHECK(line && strstr(line, "olsrd_quantiles_seconds_count{case=\"single\"} 1\n") != NULL);
+
+  abuf_free(&abuf);
+}
+
+static void
+test_stop(void *context __attribute__ ((unused)))
+{
+  olsr_scheduler_stop();
+}
+
+/**
+ * Send a raw request to the info server and read the response
+ */
+static void
+request(const char *req, char *response, size_t size)
+{
+  struct sockaddr_in sin;
+  struct timeval tv = { 1, 0 };
+  size_t have = 0;
+  ssize_t r;
+  int fd;
+
+  response[0] = '\0';
+  fd = socket(AF_INET, SOCK_STREAM, 0);
+  CHECK(fd >= 0);
+  if (fd < 0) {
+    return;
+  }
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+  memset(&sin, 0, sizeof(sin));
+  sin.sin_family = AF_INET;
+  sin.sin_port = htons(TEST_PORT);
+  sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  CHECK(!connect(fd, (struct sockaddr *) &sin, sizeof(sin)));
+  CHECK(send(fd, req, strlen(req), MSG_NOSIGNAL) == (ssize_t) strlen(req));
+
+  /* the main loop accepts, answers and closes the connection */
+  olsr_start_timer(200, 0, OLSR_TIMER_ONESHOT, &test_stop, NULL, NULL);
+  olsr_scheduler();
+
+  while (have < size - 1 && (r = recv(fd, response + have, size - 1 - have, 0)) > 0) {
+    have += (size_t) r;
+  }
+  response[have] = '\0';
+  close(fd);
+}
+
+static void
+test_headers(void)
+{
+  static char response[65536];
+
+  info_plugin_config_init(&config, TEST_PORT);
+  config.http_headers = false;
+
+  memset(&test_functions, 0, sizeof(test_functions));
+  test_functions.supportsCompositeCommands = true;
+  test_functions.supported_commands_mask = get_supported_commands_mask;
+  test_functions.is_command = isCommand;
+  test_functions.output_error = output_error;
+  test_functions.version = ipc_print_version;
+  test_functions.metrics = ipc_print_metrics;
+
+  if (!info_plugin_init("TEST", &test_functions, &config)) {
+    CHECK(false);
+    return;
+  }
+
+  /* Prometheus sends a HTTP request */
+  request("GET /metrics HTTP/1.1\r\nHost: localhost\r\nAccept: text/plain\r\n\r\n", response, sizeof(response));
+  CHECK(!strncmp(response, "HTTP/1.", 7) && strstr(response, " 200 ") != NULL);
+  CHECK(strstr(response, "\r\n\r\n# HELP olsrd_") != NULL);
+
+  /* without the httpheaders parameter /metrics still gets headers */
+  request("/metrics\n", response, sizeof(response));
+  CHECK(!strncmp(response, "HTTP/1.", 7));
+  CHECK(strstr(response, "olsrd_prom_counter_total 42\n") != NULL);
+
+  /* other plain commands do not */
+  request("/version\n", response, sizeof(response));
+  CHECK(response[0] && strncmp(response, "HTTP/1.", 7));
+
+  info_plugin_exit();
+}
+
+int
+main(void)
+{
+  harness_init(AF_INET);
+  olsr_cnf->debug_level = 0;
+  olsr_cnf->pollrate = 0.001f;
+  olsr_cnf->main_addr.v4.s_addr = htonl(0x0a000001);
+  harness_init_tables(NULL);
+
+  test_buckets();
+  test_quantiles();
+  test_prometheus();
+  test_headers();
+
+  return harness_result("test_metrics");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,392 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Randomized test of the incremental MPR selection: HELLOs, link
+ * losses and expiries are fed through the real processing code, and
+ * the selected MPRs are compared with a full recalculation and, for
+ * the LQ selection, with the algorithm before the incremental one.
+ */
+
+#include "harness.h"
+#include "olsr.h"
+#include "interfaces.h"
+#include "link_set.h"
+#include "lq_mpr.h"
+#include "lq_packet.h"
+#include "lq_plugin.h"
+#include "mpr.h"
+#include "neighbor_table.h"
+#include "process_package.h"
+#include "two_hop_neighbor_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define ITERATIONS 10000
+
+/* number of 1 hop and of 2 hop only neighbors */
+#define NEIGHBORS 14
+#define TWO_HOPS 24
+
+#define MAX_NEIGHBORS 256
+
+struct mpr_config {
+  const char *lq_algorithm;
+  int lq_level;
+  int mpr_coverage;
+};
+
+static const struct mpr_config configs[] = {
+  { "etx_float", 2, 1 },
+  { "etx_float", 2, 3 },
+  { "etx_fpm", 2, 1 },
+  { "etx_fpm", 2, 2 },
+  { "etx_float", 0, 1 },
+  { "etx_float", 0, 2 },
+};
+
+static struct interface_olsr ifs[2];
+static char if_names[2][8] = { "eth0", "eth1" };
+static uint8_t hello_seq[NEIGHBORS];
+
+static uint32_t
+node_addr(int idx)
+{
+  return idx < NEIGHBORS ? 0x0a000002 + idx : 0x0a000100 + (idx - NEIGHBORS);
+}
+
+/*
+ * The LQ MPR selection before it was made incremental: every 2 hop
+ * neighbor selects the mpr_coverage best 1 hop neighbors that are
+ * better than a direct link to it.
+ */
+static void
+old_calculate_lq_mpr(void)
+{
+  struct neighbor_2_entry *neigh2;
+  struct neighbor_list_entry *walker;
+  int i, k;
+  struct neighbor_entry *neigh;
+  olsr_linkcost best, best_1hop;
+
+  OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
+    neigh->is_mpr = neigh->status != NOT_SYM && neigh->willingness == WILL_ALWAYS;
+  }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
+
+  for (i = 0; i < HASHSIZE; i++) {
+    for (neigh2 = two_hop_neighbortable[i].next; neigh2 != &two_hop_neighbortable[i]; neigh2 = neigh2->next) {
+      best_1hop = LINK_COST_BROKEN;
+
+      neigh = olsr_lookup_neighbor_table(&neigh2->neighbor_2_addr);
+      if (neigh != NULL && neigh->status == SYM) {
+        struct link_entry *lnk = get_best_link_to_neighbor(&neigh->neighbor_main_addr);
+
+        if (!lnk)
+          continue;
+
+        best_1hop = lnk->linkcost;
+        for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
+          if (walker->path_linkcost < best_1hop)
+            break;
+
+        if (walker == &neigh2->neighbor_2_nblist)
+          continue;
+      }
+
+      for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
+        walker->neighbor->skip = false;
+
+      for (k = 0; k < olsr_cnf->mpr_coverage; k++) {
+        neigh = NULL;
+        best = LINK_COST_BROKEN;
+
+        for (walker = neigh2->neighbor_2_nblist.next; walker != &neigh2->neighbor_2_nblist; walker = walker->next)
+          if (walker->neighbor->status == SYM && !walker->neighbor->skip && walker->path_linkcost < best) {
+            neigh = walker->neighbor;
+            best = walker->path_linkcost;
+          }
+
+        if ((neigh != NULL) && (best < best_1hop)) {
+          neigh->is_mpr = true;
+          neigh->skip = true;
+        } else
+          break;
+      }
+    }
+  }
+}
+
+/* a HELLO from a random neighbor, with random links */
+static void
+input_hello(void)
+{
+  static const int link_types[3] = { SYM_LINK, ASYM_LINK, LOST_LINK };
+  unsigned char msg[1500], *p = msg;
+  int from = rand() % NEIGHBORS, ifi = rand() % 4 == 0, i;
+  int entry_size = 4 + olsr_cnf->ipsize + (olsr_cnf->lq_level ? olsr_sizeof_hello_lqdata() : 0);
+  union olsr_ip_addr src;
+  uint32_t addr;
+
+  memset(msg, 0, 16);
+  p[0] = olsr_cnf->lq_level ? LQ_HELLO_MESSAGE : HELLO_MESSAGE;
+  p[1] = 0xe8;
+  addr = htonl(node_addr(from));
+  memcpy(p + 4, &addr, 4);
+  p[8] = 1;
+  p[11] = hello_seq[from]++;
+  p[14] = 0x86;
+  p[15] = rand() % 10 ? WILL_DEFAULT : (rand() % 2 ? WILL_ALWAYS : WILL_NEVER + rand() % 2 * WILL_LOW);
+  p += 16;
+
+  /* our own interface, usually */
+  if (rand() % 8) {
+    memset(p, 0, entry_size);
+    p[0] = CREATE_LINK_CODE(rand() % 5 ? SYM_NEIGH : MPR_NEIGH, rand() % 6 ? SYM_LINK : ASYM_LINK);
+    p[3] = entry_size;
+    memcpy(p + 4, &ifs[ifi].ip_addr, 4);
+    if (olsr_cnf->lq_level) {
+      p[8] = 128 + rand() % 128;
+      p[9] = 128 + rand() % 128;
+    }
+    p += entry_size;
+  }
+
+  for (i = 0; i < NEIGHBORS + TWO_HOPS; i++) {
+    int link_type, neigh_type;
+
+    if (i == from || rand() % 3) {
+      continue;
+    }
+    link_type = link_types[rand() % 3];
+    neigh_type = (link_type == LOST_LINK || rand() % 4) ? SYM_NEIGH : (rand() % 2 ? MPR_NEIGH : NOT_NEIGH);
+
+    memset(p, 0, entry_size);
+    p[0] = CREATE_LINK_CODE(neigh_type, link_type);
+    p[3] = entry_size;
+    addr = htonl(node_addr(i));
+    memcpy(p + 4, &addr, 4);
+    if (olsr_cnf->lq_level) {
+      p[8] = rand() % 4 ? 255 : 64 + rand() % 192;
+      p[9] = rand() % 4 ? 255 : 64 + rand() % 192;
+    }
+    p += entry_size;
+  }
+  msg[2] = (p - msg) >> 8;
+  msg[3] = (p - msg) & 0xff;
+
+  memset(&src, 0, sizeof(src));
+  src.v4.s_addr = htonl(node_addr(from));
+  now_times += 100;
+  olsr_input_hello((union olsr_message *)msg, &ifs[ifi], &src);
+}
+
+/* expire the first 2 hop neighbor of a random neighbor */
+static void
+expire_two_hop(void)
+{
+  struct neighbor_entry *neigh;
+  int pick = rand() % NEIGHBORS, idx = 0;
+
+  OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
+    if (idx++ == pick && neigh->neighbor_2_list.next != &neigh->neighbor_2_list) {
+      struct neighbor_2_list_entry *entry = neigh->neighbor_2_list.next;
+
+      olsr_stop_timer(entry->nbr2_list_timer);
+      olsr_expire_nbr2_list(entry);
+    }
+  }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
+}
+
+/* lose some packets on a random link */
+static void
+lose_packets(void)
+{
+  struct link_entry *link;
+  int pick = rand() % 8, idx = 0;
+
+  OLSR_FOR_ALL_LINK_ENTRIES(link) {
+    if (idx++ == pick) {
+      int lost;
+
+      for (lost = rand() % 20; lost > 0; lost--) {
+        olsr_update_packet_loss_worker(link, true);
+      }
+      break;
+    }
+  }
+  OLSR_FOR_ALL_LINK_ENTRIES_END(link);
+}
+
+/* compare the incremental selection with the full ones */
+static void
+check_mprs(void)
+{
+  struct neighbor_entry *nbrs[MAX_NEIGHBORS], *neigh;
+  bool incremental[MAX_NEIGHBORS], was_mpr[MAX_NEIGHBORS];
+  int count = 0, i;
+
+  changes_neighborhood = true;
+  olsr_process_changes();
+
+  OLSR_FOR_ALL_NBR_ENTRIES(neigh) {
+    if (count < MAX_NEIGHBORS) {
+      nbrs[count] = neigh;
+      incremental[count] = neigh->is_mpr;
+      was_mpr[count] = neigh->was_mpr;
+      count++;
+    }
+  }
+  OLSR_FOR_ALL_NBR_ENTRIES_END(neigh);
+
+  if (olsr_cnf->lq_level > 0) {
+    old_calculate_lq_mpr();
+    for (i = 0; i < count; i++) {
+      CHECK(nbrs[i]->is_mpr == incremental[i]);
+      nbrs[i]->is_mpr = incremental[i];
+      nbrs[i]->was_mpr = was_mpr[i];
+    }
+  }
+
+  olsr_mpr_invalidate();
+  if (olsr_cnf->lq_level > 0) {
+    olsr_calculate_lq_mpr();
+  } else {
+    olsr_calculate_mpr();
+  }
+  for (i = 0; i < count; i++) {
+    CHECK(nbrs[i]->is_mpr == incremental[i]);
+  }
+}
+
+static int
+run_config(const struct mpr_config *config)
+{
+  int iter, checks = 0;
+
+  harness_init(AF_INET);
+  olsr_cnf->lq_level = config->lq_level;
+  olsr_cnf->mpr_coverage = config->mpr_coverage;
+  olsr_cnf->use_hysteresis = false;
+  olsr_cnf->main_addr.v4.s_addr = htonl(0x0a000001);
+  harness_init_tables(config->lq_algorithm);
+
+  memset(ifs, 0, sizeof(ifs));
+  ifs[0].ip_addr.v4.s_addr = htonl(0x0a000001);
+  ifs[0].int_name = if_names[0];
+  ifs[0].mode = IF_MODE_MESH;
+  ifs[1].ip_addr.v4.s_addr = htonl(0x0b000001);
+  ifs[1].int_name = if_names[1];
+  ifs[1].mode = IF_MODE_MESH;
+  ifs[0].int_next = &ifs[1];
+  ifnet = &ifs[0];
+
+  srand(config->mpr_coverage);
+  for (iter = 0; iter < ITERATIONS; iter++) {
+    int op = rand() % 100;
+
+    if (op < 80) {
+      input_hello();
+    } else if (op < 85) {
+      if (rand() % 4 == 0) {
+        olsr_delete_link_entry_by_ip(&ifs[1].ip_addr);
+      }
+    } else if (op < 90) {
+      if (rand() % 8 == 0) {
+        olsr_delete_link_entry_by_ip(&ifs[0].ip_addr);
+      }
+    } else if (op < 95) {
+      expire_two_hop();
+    } else if (olsr_cnf->lq_level > 0) {
+      lose_packets();
+    }
+
+    if (rand() % 4 == 0) {
+      olsr_process_changes();
+    }
+    if (rand() % 3 == 0) {
+      check_mprs();
+      checks++;
+    }
+  }
+
+  CHECK(checks > 0);
+  if (harness_failures) {
+    fprintf(stderr, "test_mpr: %s, LinkQualityLevel %d, MprCoverage %d failed\n", config->lq_algorithm, config->lq_level,
+            config->mpr_coverage);
+  }
+  return harness_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+int
+main(void)
+{
+  unsigned int i;
+
+  /* every configuration starts with fresh tables */
+  for (i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+    pid_t pid = fork();
+    int status;
+
+    if (pid == 0) {
+      exit(run_config(&configs[i]));
+    }
+    CHECK(pid > 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+  }
+
+  return harness_result("test_mpr");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
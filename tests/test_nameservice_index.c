@@ -0,0 +1,284 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Test of the host name index of the nameservice plugin: random names
+ * are received from a few originators, expire, and get MID aliases.
+ * After each step the incrementally updated index must hold exactly
+ * the names (with the suffix) and MID aliases of the databases.
+ *
+ * nameservice.c is included to reach its static functions.
+ */
+
+#include "harness.h"
+#include "../lib/nameservice/src/nameservice.c"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define ORIGINATORS 12
+#define NAMES 10
+#define ITERATIONS 20000
+#define MAX_TUPLES 4096
+
+#define ORIG_ADDR(o) (0x0a000001 + (o))
+#define NAME_ADDR(o, k) (0x0a010000 + ((o) << 8) + (k))
+#define ALIAS_ADDR(o, k) (0x0a020000 + ((o) << 8) + (k))
+
+struct index_tuple {
+  char name[MID_MAXLEN + MAX_NAME + MAX_SUFFIX + 1];
+  union olsr_ip_addr ip;
+  union olsr_ip_addr originator;
+  int mid;
+};
+
+static struct index_tuple expected[MAX_TUPLES];
+
+static int
+tuple_comp(const void *a, const void *b)
+{
+  const struct index_tuple *t1 = a, *t2 = b;
+  int cmp = strcasecmp(t1->name, t2->name);
+
+  if (cmp == 0) {
+    cmp = memcmp(&t1->ip, &t2->ip, olsr_cnf->ipsize);
+  }
+  if (cmp == 0) {
+    cmp = memcmp(&t1->originator, &t2->originator, olsr_cnf->ipsize);
+  }
+  return cmp;
+}
+
+static void
+make_ip(union olsr_ip_addr *ip, uint32_t addr)
+{
+  memset(ip, 0, sizeof(*ip));
+  ip->v4.s_addr = htonl(addr);
+}
+
+static struct db_entry *
+find_db(const union olsr_ip_addr *originator)
+{
+  struct list_node *list_head, *list_node;
+
+  list_head = &name_list[olsr_ip_hashing(originator)];
+  for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
+    if (ipequal(&list2db(list_node)->originator, originator)) {
+      return list2db(list_node);
+    }
+  }
+  return NULL;
+}
+
+static void
+receive_name(int orig, int k, bool own_addr)
+{
+  char buf[sizeof(struct name) + MAX_NAME + 4];
+  struct name *from_packet = (struct name *)buf;
+  union olsr_ip_addr originator;
+
+  make_ip(&originator, ORIG_ADDR(orig));
+  memset(buf, 0, sizeof(buf));
+  from_packet->type = htons(NAME_HOST);
+  snprintf(buf + sizeof(struct name), MAX_NAME, "host%d", k);
+  from_packet->len = htons(strlen(buf + sizeof(struct name)));
+  if (own_addr) {
+    from_packet->ip = originator;
+  } else {
+    make_ip(&from_packet->ip, NAME_ADDR(orig, k));
+  }
+
+  insert_new_name_in_list(&originator, name_list, from_packet, &name_table_changed, 3600 * MSEC_PER_SEC);
+}
+
+/* the index as the hosts file was rendered from before */
+static int
+build_expected(void)
+{
+  struct list_node *list_head, *list_node;
+  struct name_entry *name;
+  struct mid_address *alias;
+  int hash, count = 0, i, j;
+
+  for (hash = 0; hash < HASHSIZE; hash++) {
+    list_head = &name_list[hash];
+    for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
+      struct db_entry *db = list2db(list_node);
+
+      for (name = db->names; name != NULL; name = name->next) {
+        int mid_num = 0;
+
+        alias = NULL;
+        do {
+          struct index_tuple *t = &expected[count++];
+
+          if (mid_num == 0) {
+            snprintf(t->name, sizeof(t->name), "%s%s", name->name, my_suffix);
+            t->ip = name->ip;
+          } else {
+            char mid_prefix[MID_MAXLEN];
+
+            sprintf(mid_prefix, MID_PREFIX, mid_num);
+            snprintf(t->name, sizeof(t->name), "%s%s%s", mid_prefix, name->name, my_suffix);
+            t->ip = alias->alias;
+          }
+          t->originator = db->originator;
+          t->mid = mid_num;
+
+          alias = mid_num == 0 ? mid_lookup_aliases(&name->ip) : alias->next_alias;
+          mid_num++;
+        } while (alias != NULL);
+      }
+    }
+  }
+
+  /* the index keeps one address per name, ip and originator */
+  qsort(expected, count, sizeof(expected[0]), tuple_comp);
+  for (i = j = 0; i < count; i++) {
+    if (j == 0 || tuple_comp(&expected[j - 1], &expected[i]) != 0) {
+      expected[j++] = expected[i];
+    }
+  }
+  return j;
+}
+
+static bool
+index_matches(void)
+{
+  struct avl_node *node;
+  struct name_index_entry *entry;
+  struct name_index_addr *addr;
+  int count = build_expected(), i = 0, owned = 0, hash;
+  struct list_node *list_head, *list_node;
+
+  for (node = avl_walk_first(&name_index); node; node = avl_walk_next(node)) {
+    entry = node2nameindex(node);
+    if (entry->addrs == NULL) {
+      return false;
+    }
+    for (addr = entry->addrs; addr; addr = addr->next, i++) {
+      if (i >= count || strcmp(entry->name, expected[i].name) != 0 || addr->entry != entry || !ipequal(&addr->ip, &expected[i].ip)
+          || !ipequal(&addr->originator, &expected[i].originator) || addr->mid != expected[i].mid) {
+        return false;
+      }
+    }
+  }
+
+  /* every address is on the chain of its originator */
+  for (hash = 0; hash < HASHSIZE; hash++) {
+    list_head = &name_list[hash];
+    for (list_node = list_head->next; list_node != list_head; list_node = list_node->next) {
+      struct db_entry *db = list2db(list_node);
+
+      for (addr = db->index; addr; addr = addr->owner_next, owned++) {
+        if (!ipequal(&addr->originator, &db->originator)) {
+          return false;
+        }
+      }
+    }
+  }
+  return i == count && owned == count;
+}
+
+int
+main(void)
+{
+  int iter, checks = 0;
+  union olsr_ip_addr originator, alias;
+  struct db_entry *db;
+
+  harness_init(AF_INET);
+  harness_init_tables(NULL);
+  make_ip(&olsr_cnf->main_addr, 0x0a0000fe);
+
+  name_constructor();
+  strscpy(my_suffix, ".olsr", sizeof(my_suffix));
+  name_lazy_init();
+
+  srand(1);
+  for (iter = 0; iter < ITERATIONS; iter++) {
+    int op = rand() % 100, orig = rand() % ORIGINATORS;
+
+    make_ip(&originator, ORIG_ADDR(orig));
+    if (op < 70) {
+      receive_name(orig, rand() % NAMES, rand() % 4 == 0);
+    } else if (op < 80) {
+      if ((db = find_db(&originator)) != NULL) {
+        olsr_stop_timer(db->db_timer);
+        olsr_namesvc_delete_db_entry(db);
+      }
+    } else if (op < 92) {
+      /* a new alias shows up with the next message of the node */
+      make_ip(&alias, ALIAS_ADDR(orig, rand() % 4));
+      insert_mid_alias(&originator, &alias, 3600 * MSEC_PER_SEC);
+      receive_name(orig, 0, true);
+    } else {
+      struct mid_entry *mid = mid_lookup_entry_bymain(&originator);
+
+      if (mid) {
+        olsr_delete_mid_entry(mid);
+        receive_name(orig, 0, true);
+      }
+    }
+
+    if (iter % 7 == 0 || op >= 70) {
+      CHECK(index_matches());
+      checks++;
+    }
+  }
+
+  free_all_list_entries(name_list);
+  CHECK(avl_walk_first(&name_index) == NULL);
+
+  printf("%d index checks\n", checks);
+  return harness_result("test_nameservice_index");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
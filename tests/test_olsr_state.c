@@ -0,0 +1,261 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Round trip of the state checkpoint, see olsr_state_save() and
+ * olsr_state_init(): the topology with the link quality of its edges,
+ * the duplicate set, our sequence numbers and the held kernel routes
+ * are restored as they were saved. A link quality that does not fit
+ * into the edge records leaves no checkpoint.
+ */
+
+#include "harness.h"
+#include "olsr.h"
+#include "olsr_state.h"
+#include "interfaces.h"
+#include "tc_set.h"
+#include "duplicate_set.h"
+#include "mpr_selector_set.h"
+#include "lq_plugin.h"
+#include "routing_table.h"
+#include "process_routes.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+
+#define ME 0x0a000001
+#define NODE 0x0a000002
+#define EDGE1 0x0a000003
+#define EDGE2 0x0a000004
+#define DUP 0x0a000005
+#define HELD 0x0a000106
+
+static struct interface_olsr iface;
+
+static union olsr_ip_addr *
+addr4(union olsr_ip_addr *addr, uint32_t ip)
+{
+  memset(addr, 0, sizeof(*addr));
+  addr->v4.s_addr = htonl(ip);
+  return addr;
+}
+
+/* the link quality of an edge in TC message format */
+static void
+check_edge(struct tc_entry *tc, uint32_t dst, uint16_t ansn, uint8_t lq, uint8_t nlq)
+{
+  struct tc_edge_entry *tc_edge;
+  union olsr_ip_addr addr;
+  uint8_t buf[8];
+
+  tc_edge = olsr_lookup_tc_edge(tc, addr4(&addr, dst));
+  CHECK(tc_edge != NULL);
+  if (tc_edge == NULL) {
+    return;
+  }
+  CHECK(tc_edge->ansn == ansn);
+  CHECK(olsr_serialize_tc_edge_lq(buf, tc_edge) == 4);
+  CHECK(buf[0] == lq && buf[1] == nlq);
+}
+
+/* drop everything the checkpoint holds */
+static void
+clear_state(void)
+{
+  struct tc_entry *tc;
+  struct dup_entry *dup;
+
+  OLSR_FOR_ALL_TC_ENTRIES(tc) {
+    if (tc != tc_myself) {
+      olsr_delete_tc_entry(tc);
+    }
+  } OLSR_FOR_ALL_TC_ENTRIES_END(tc);
+
+  OLSR_FOR_ALL_DUP_ENTRIES(dup) {
+    avl_delete(&duplicate_set, &dup->avl);
+    free(dup);
+  } OLSR_FOR_ALL_DUP_ENTRIES_END(dup);
+
+  olsr_delete_held_kernel_routes();
+
+  set_msg_seqno(0);
+  set_local_ansn(0);
+}
+
+int
+main(void)
+{
+  static const uint8_t lq1[4] = { 0x80, 0xc0, 0, 0 };
+  static const uint8_t lq2[4] = { 0xff, 0x40, 0, 0 };
+  char dir[] = "/tmp/olsrd_test_XXXXXX";
+  char file[sizeof(dir) + 16];
+  union olsr_ip_addr addr, dst;
+  struct olsr_ip_prefix held;
+  struct rt_nexthop nexthop;
+  struct rt_metric metric;
+  struct tc_entry *tc;
+  struct dup_entry *dup;
+  struct avl_node *node;
+  size_t lq_size;
+
+  CHECK(mkdtemp(dir) != NULL);
+  snprintf(file, sizeof(file), "%s/olsrd.state", dir);
+
+  harness_init(AF_INET);
+  olsr_cnf->main_addr.v4.s_addr = htonl(ME);
+  olsr_cnf->state_file = strdup(file);
+  olsr_cnf->state_interval = 0;
+  harness_init_tables(NULL);
+
+  /* held routes are checkpointed with the name of their interface */
+  memset(&iface, 0, sizeof(iface));
+  iface.if_index = 7;
+  iface.int_name = strdup("eth0");
+  ifnet = &iface;
+
+  tc = olsr_restore_tc_entry(addr4(&addr, NODE), 100, 7, 2, 30000);
+  CHECK(tc != NULL);
+  CHECK(olsr_restore_tc_edge(tc, addr4(&dst, EDGE1), 7, lq1) != NULL);
+  CHECK(olsr_restore_tc_edge(tc, addr4(&dst, EDGE2), 6, lq2) != NULL);
+
+  olsr_restore_duplicate_entry(addr4(&addr, DUP), 500, 3, 0x12345678, 20000);
+
+  set_msg_seqno(1000);
+  set_local_ansn(50);
+
+  memset(&held, 0, sizeof(held));
+  held.prefix.v4.s_addr = htonl(HELD);
+  held.prefix_len = 32;
+  memset(&nexthop, 0, sizeof(nexthop));
+  nexthop.gateway.v4.s_addr = htonl(NODE);
+  nexthop.iif_index = iface.if_index;
+  metric.cost = 5;
+  metric.hops = 2;
+  CHECK(olsr_hold_kernel_route(&held, &nexthop, &metric) != NULL);
+
+  /* a link quality that does not fit leaves no checkpoint */
+  lq_size = active_lq_handler->tc_lqdata_size;
+  active_lq_handler->tc_lqdata_size = 0;
+  olsr_state_save();
+  CHECK(access(file, F_OK) < 0);
+  active_lq_handler->tc_lqdata_size = 1024;
+  olsr_state_save();
+  CHECK(access(file, F_OK) < 0);
+  active_lq_handler->tc_lqdata_size = lq_size;
+
+  olsr_state_save();
+  CHECK(access(file, F_OK) == 0);
+
+  clear_state();
+  CHECK(olsr_lookup_tc_entry(addr4(&addr, NODE)) == NULL);
+  CHECK(duplicate_set.count == 0);
+  CHECK(held_routingtree.count == 0);
+
+  olsr_state_init(true);
+
+  /* the topology with the link quality of the edges */
+  tc = olsr_lookup_tc_entry(addr4(&addr, NODE));
+  CHECK(tc != NULL);
+  if (tc != NULL) {
+    CHECK(tc->msg_seq == 100);
+    CHECK(tc->ansn == 7);
+    CHECK(tc->msg_hops == 2);
+    CHECK(tc->validity_timer != NULL);
+    CHECK(tc->edge_tree.count == 2);
+    check_edge(tc, EDGE1, 7, lq1[0], lq1[1]);
+    check_edge(tc, EDGE2, 6, lq2[0], lq2[1]);
+  }
+
+  /* the duplicate set */
+  dup = (struct dup_entry *)avl_find(&duplicate_set, addr4(&addr, DUP));
+  CHECK(dup != NULL);
+  if (dup != NULL) {
+    CHECK(dup->seqnr == 500);
+    CHECK(dup->too_low_counter == 3);
+    CHECK(dup->array == 0x12345678);
+  }
+
+  /* sequence numbers jump over what may have been sent after the checkpoint */
+  CHECK(peek_msg_seqno() == 1000 + 1024);
+  CHECK(get_local_ansn() == 50 + 16);
+
+  /* the held kernel route */
+  node = avl_find(&held_routingtree, &held);
+  CHECK(node != NULL);
+  if (node != NULL) {
+    struct rt_entry *rt = rt_tree2rt(node);
+
+    CHECK(rt->rt_nexthop.gateway.v4.s_addr == htonl(NODE));
+    CHECK(rt->rt_nexthop.iif_index == iface.if_index);
+    CHECK(rt->rt_metric.cost == 5);
+    CHECK(rt->rt_metric.hops == 2);
+  }
+
+  unlink(file);
+  rmdir(dir);
+
+  return harness_result("test_olsr_state");
+}
+
+#else /* __linux__ */
+
+int
+main(void)
+{
+  printf("test_olsr_state: skipped\n");
+  return EXIT_SUCCESS;
+}
+
+#endif /* __linux__ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
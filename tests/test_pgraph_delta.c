@@ -0,0 +1,295 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Test of the delta frames of the pgraph plugin: the "add link" and
+ * "del link" lines of the delta frames, applied one after the other to
+ * the first complete frame, must give the same links as a complete
+ * frame of the tables after every delta frame.
+ *
+ * olsrd_pgraph.c is included to reach its static functions.
+ */
+
+#include "harness.h"
+
+#include "../lib/pgraph/src/olsrd_pgraph.c"
+
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+
+#define NODES 12
+#define FRAMES 2000
+#define MAX_LINKS (NODES * NODES)
+
+struct link_set {
+  char links[MAX_LINKS][40];
+  unsigned int count;
+};
+
+static struct link_set model, reference;
+
+/* the constructor of the plugin needs the configuration */
+static void __attribute__ ((constructor(101)))
+test_init(void)
+{
+  harness_init(AF_INET);
+  olsr_cnf->debug_level = 0;
+}
+
+static void
+node_addr(union olsr_ip_addr *addr, int idx)
+{
+  memset(addr, 0, sizeof(*addr));
+  addr->v4.s_addr = htonl(0x0a000001 + idx);
+}
+
+static int
+link_find(struct link_set *set, const char *link, size_t len)
+{
+  unsigned int i;
+
+  for (i = 0; i < set->count; i++) {
+    if (strlen(set->links[i]) == len && strncmp(set->links[i], link, len) == 0) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+/* apply the lines of a frame to the set of links */
+static void
+link_apply(struct link_set *set, const char *frame)
+{
+  const char *line = frame, *end;
+
+  while (strncmp(line, " end ", 5) != 0) {
+    size_t len;
+    int i;
+
+    end = strchr(line, '\n');
+    CHECK(end != NULL);
+    if (!end) {
+      return;
+    }
+    len = (size_t)(end - line) - 9;
+    i = link_find(set, line + 9, len);
+
+    if (strncmp(line, "add link ", 9) == 0) {
+      CHECK(i < 0);
+      CHECK(set->count < MAX_LINKS && len < sizeof(set->links[0]));
+      memcpy(set->links[set->count], line + 9, len);
+      set->links[set->count++][len] = 0;
+    } else {
+      CHECK(strncmp(line, "del link ", 9) == 0);
+      CHECK(i >= 0);
+      if (i >= 0) {
+        strscpy(set->links[i], set->links[--set->count], sizeof(set->links[0]));
+      }
+    }
+    line = end + 1;
+  }
+  CHECK(strcmp(line, " end ") == 0);
+}
+
+/* a complete frame of the tables, without touching the links of the plugin */
+static void
+full_frame(struct link_set *set)
+{
+  struct avl_tree saved = link_tree;
+  struct avl_node *node, *next;
+
+  avl_init(&link_tree, &link_comp);
+  abuf_pull(&outbuffer, outbuffer.len);
+  ipc_render(true);
+
+  set->count = 0;
+  link_apply(set, outbuffer.buf);
+  abuf_pull(&outbuffer, outbuffer.len);
+
+  for (node = avl_walk_first(&link_tree); node; node = next) {
+    next = avl_walk_next(node);
+    avl_delete(&link_tree, node);
+    free(node2link(node));
+  }
+  link_tree = saved;
+}
+
+static bool
+link_equal(struct link_set *a, struct link_set *b)
+{
+  unsigned int i;
+
+  if (a->count != b->count) {
+    return false;
+  }
+  for (i = 0; i < a->count; i++) {
+    if (link_find(b, a->links[i], strlen(a->links[i])) < 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void
+mutate_neighbor(void)
+{
+  union olsr_ip_addr addr;
+
+  node_addr(&addr, 1 + random() % (NODES - 1));
+  if (olsr_lookup_neighbor_table(&addr)) {
+    olsr_delete_neighbor_table(&addr);
+  } else {
+    olsr_insert_neighbor_table(&addr);
+  }
+}
+
+static void
+mutate_topology(void)
+{
+  union olsr_ip_addr from, to;
+  struct tc_entry *tc;
+  struct tc_edge_entry *tc_edge;
+  uint8_t lq[4];
+  int a = 1 + random() % (NODES - 1), b = random() % NODES;
+
+  if (a == b) {
+    return;
+  }
+  node_addr(&from, a);
+  node_addr(&to, b);
+
+  tc = olsr_lookup_tc_entry(&from);
+  tc_edge = tc ? olsr_lookup_tc_edge(tc, &to) : NULL;
+  if (tc_edge) {
+    olsr_delete_tc_edge_entry(tc_edge);
+    return;
+  }
+  if (!tc) {
+    tc = olsr_restore_tc_entry(&from, 1, 1, 3, 600 * MSEC_PER_SEC);
+  }
+
+  memset(lq, 0, sizeof(lq));
+  lq[0] = (uint8_t)(64 + random() % 192);
+  lq[1] = lq[0];
+  olsr_restore_tc_edge(tc, &to, 1, lq);
+}
+
+int
+main(void)
+{
+  unsigned int frames = 0, empty = 0, removed = 0;
+  int i, j;
+
+  node_addr(&olsr_cnf->main_addr, 0);
+  harness_init_tables("etx_float");
+
+  avl_init(&link_tree, &link_comp);
+  abuf_init(&outbuffer, AUTOBUFCHUNK);
+  srandom(42);
+
+  /* the first frame is always complete */
+  delta = true;
+  ipc_render(true);
+  link_apply(&model, outbuffer.buf);
+  abuf_pull(&outbuffer, outbuffer.len);
+
+  for (i = 0; i < FRAMES; i++) {
+    int changes = random() % 4;
+
+    for (j = 0; j < changes; j++) {
+      if (random() % 3 == 0) {
+        mutate_neighbor();
+      } else {
+        mutate_topology();
+      }
+    }
+
+    ipc_render(false);
+    if (outbuffer.len == 0) {
+      empty++;
+    } else {
+      frames++;
+      removed += strstr(outbuffer.buf, "del link ") != NULL;
+      link_apply(&model, outbuffer.buf);
+      abuf_pull(&outbuffer, outbuffer.len);
+    }
+
+    full_frame(&reference);
+    CHECK(link_equal(&model, &reference));
+
+    /* nothing changed, nothing sent */
+    ipc_render(false);
+    CHECK(outbuffer.len == 0);
+  }
+  CHECK(frames > FRAMES / 2 && empty > 0 && removed > 0);
+
+  /* without delta a changed graph is sent complete */
+  delta = false;
+  for (i = 0; i < 50; i++) {
+    mutate_topology();
+    ipc_render(false);
+    if (outbuffer.len == 0) {
+      continue;
+    }
+    model.count = 0;
+    link_apply(&model, outbuffer.buf);
+    abuf_pull(&outbuffer, outbuffer.len);
+    full_frame(&reference);
+    CHECK(link_equal(&model, &reference));
+    ipc_render(false);
+    CHECK(outbuffer.len == 0);
+  }
+
+  printf("%u delta frames, %u without changes, %u links at the end\n", frames, empty, model.count);
+  return harness_result("pgraph_delta");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,310 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+/*
+ * Test of the position update cache of the pud plugin: random position
+ * updates, many of them repeated or changed below the resolution of the
+ * wire format, are converted with gpsToOlsr() and compared with a
+ * conversion without the cache. Except for the sequence number, the
+ * messages must be identical, and every update that gives the same wire
+ * format as the one before must be served from the cache.
+ *
+ * gpsConversion.c is included to reach the cache. The conversion does not
+ * use gpsd, its client header (which needs libgps) is replaced by the one
+ * type that configuration.h refers to.
+ */
+
+#include "harness.h"
+
+/* stands in for gpsdclient.h */
+#define _PUD_GPSD_GPSDCLIENT_H_
+typedef struct _GpsDaemon {
+  int unused;
+} GpsDaemon;
+
+#include "../lib/pud/src/gpsConversion.c"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ITERATIONS 200000
+
+/* the parts of the configuration of the plugin that the conversion uses */
+static unsigned char test_ttl = 64;
+static NodeIdType test_node_id_type = PUD_NODEIDTYPE_DNS;
+static nodeIdBinaryType test_node_id;
+static unsigned int test_node_id_calls;
+
+unsigned char
+getOlsrTtl(void)
+{
+  return test_ttl;
+}
+
+NodeIdType
+getNodeIdTypeNumber(void)
+{
+  return test_node_id_type;
+}
+
+/* only called when a message is converted, so it counts the cache misses */
+nodeIdBinaryType *
+getNodeIdBinary(void)
+{
+  test_node_id_calls++;
+  return &test_node_id;
+}
+
+unsigned char *
+getTxNmeaMessagePrefix(void)
+{
+  static unsigned char prefix[] = "NBSX";
+
+  return prefix;
+}
+
+void
+pudError(bool useErrno __attribute__ ((unused)), const char *format __attribute__ ((unused)), ...)
+{
+}
+
+static double
+random_range(double low, double high)
+{
+  long r = random();
+
+  return low + (high - low) * ((double) r / RAND_MAX);
+}
+
+static void
+random_position(NmeaInfo *info)
+{
+  static const uint32_t fields[] = { NMEALIB_PRESENT_LAT, NMEALIB_PRESENT_LON, NMEALIB_PRESENT_ELV,
+      NMEALIB_PRESENT_SPEED, NMEALIB_PRESENT_TRACK, NMEALIB_PRESENT_HDOP };
+  unsigned int i;
+
+  memset(info, 0, sizeof(*info));
+  info->present = NMEALIB_PRESENT_UTCTIME;
+  for (i = 0; i < ARRAYSIZE(fields); i++) {
+    if (random() % 8) {
+      info->present |= fields[i];
+    }
+  }
+  if (!(random() % 16)) {
+    info->present |= PUD_PRESENT_GATEWAY;
+  }
+  info->utc.hour = (unsigned int) (random() % 24);
+  info->utc.min = (unsigned int) (random() % 60);
+  info->utc.sec = (unsigned int) (random() % 60);
+  info->latitude = random_range(-90, 90);
+  info->longitude = random_range(-180, 180);
+  info->elevation = random_range(-400, 9000);
+  info->speed = random_range(0, 900);
+  info->track = random_range(0, 360);
+  info->hdop = random_range(0, 60);
+}
+
+/* change the position below the resolution of the wire format */
+static void
+jitter_position(NmeaInfo *info)
+{
+  switch (random() % 5) {
+    case 0:
+      info->latitude = nextafter(info->latitude, 100);
+      break;
+    case 1:
+      info->longitude *= 1 + 1e-13;
+      break;
+    case 2:
+      info->elevation += 1e-9;
+      break;
+    case 3:
+      /* a field that is not present is sent as 0, whatever its value */
+      info->present &= ~NMEALIB_PRESENT_SPEED;
+      info->speed = random_range(0, 900);
+      break;
+    default:
+      info->latitude = (info->latitude == 0.0) ? -0.0 : info->latitude;
+      info->track = nextafter(info->track, 0);
+      break;
+  }
+}
+
+/**
+ * Clear the sequence number of a message
+ */
+static void
+clear_seqno(union olsr_message *msg)
+{
+  if (olsr_cnf->ip_version == AF_INET) {
+    msg->v4.seqno = 0;
+  } else {
+    msg->v6.seqno = 0;
+  }
+}
+
+static void
+run(int ip_version, unsigned int *hits, unsigned int *same_wire)
+{
+  static union {
+    union olsr_message msg;
+    unsigned char buf[512];
+  } cached, reference, previous;
+  unsigned int previous_size = 0, previous_space = 0;
+  NmeaInfo info;
+  int i;
+
+  olsr_cnf->ip_version = ip_version;
+  olsr_cnf->ipsize = (ip_version == AF_INET) ? sizeof(struct in_addr) : sizeof(struct in6_addr);
+  memset(&olsr_cnf->main_addr, 0, sizeof(olsr_cnf->main_addr));
+  olsr_cnf->main_addr.v4.s_addr = htonl(0x0a000001);
+  positionUpdateCache.valid = false;
+
+  random_position(&info);
+  for (i = 0; i < ITERATIONS; i++) {
+    unsigned int size = 512, cached_size, reference_size, calls;
+    bool hit;
+    unsigned long long validity = 60;
+    __typeof__(positionUpdateCache) saved;
+
+    switch (random() % 10) {
+      case 0:
+      case 1:
+      case 2:
+      case 3:
+        /* a stationary node sends the same position */
+        break;
+      case 4:
+      case 5:
+        jitter_position(&info);
+        break;
+      case 6:
+        info.utc.sec = (info.utc.sec + 1) % 60;
+        break;
+      case 7:
+        info.present ^= 1u << (8 + random() % 5);
+        break;
+      case 8:
+        random_position(&info);
+        break;
+      default:
+        /* the rest of the message changes */
+        switch (random() % 4) {
+          case 0:
+            olsr_cnf->main_addr.v4.s_addr = htonl(0x0a000001 + (uint32_t) (random() % 2));
+            break;
+          case 1:
+            test_ttl = (unsigned char) (random() % 2 ? 64 : 1);
+            break;
+          case 2:
+            validity = (random() % 2) ? 60 : 3600;
+            break;
+          default:
+            /* the DNS node id is truncated to the space for the message */
+            size = 80;
+            break;
+        }
+        break;
+    }
+
+    calls = test_node_id_calls;
+    cached_size = gpsToOlsr(&info, &cached.msg, size, validity);
+    hit = (test_node_id_calls == calls);
+    if (hit) {
+      (*hits)++;
+    }
+
+    /* the same conversion without the cache, which is left untouched */
+    saved = positionUpdateCache;
+    positionUpdateCache.valid = false;
+    reference_size = gpsToOlsr(&info, &reference.msg, size, validity);
+    positionUpdateCache = saved;
+
+    clear_seqno(&cached.msg);
+    clear_seqno(&reference.msg);
+    CHECK(cached_size > 0 && cached_size == reference_size);
+    CHECK(!memcmp(cached.buf, reference.buf, reference_size));
+
+    /* the same wire format as the previous message is never converted again */
+    if (size == previous_space && reference_size == previous_size && !memcmp(previous.buf, reference.buf, reference_size)) {
+      (*same_wire)++;
+      CHECK(hit);
+    }
+    previous = reference;
+    previous_size = reference_size;
+    previous_space = size;
+  }
+}
+
+int
+main(void)
+{
+  unsigned int hits = 0, same_wire = 0;
+  const char *name = "node-with-a-rather-long-name.olsr.example.org";
+
+  harness_init(AF_INET);
+  srandom(45);
+
+  memset(&test_node_id, 0, sizeof(test_node_id));
+  test_node_id.length = strlen(name);
+  memcpy(test_node_id.buffer.stringValue, name, test_node_id.length);
+  test_node_id.set = true;
+
+  run(AF_INET, &hits, &same_wire);
+  run(AF_INET6, &hits, &same_wire);
+
+  printf("%d updates, %u with an unchanged wire format, %u cache hits\n", 2 * ITERATIONS, same_wire, hits);
+  CHECK(hits == same_wire);
+
+  return harness_result("test_pud_position_cache");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,410 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Test of the route export of the quagga plugin against a slow zebra on
+ * a unix socket with small socket buffers. Random route changes are
+ * exported while zebra reads a few bytes at a time, which fills the
+ * output ring and overflows the route queue. Once everything is sent,
+ * zebra must have the routing table of olsrd, and nothing after the
+ * plugin is unloaded.
+ */
+
+#include "harness.h"
+#include "olsr.h"
+#include "scheduler.h"
+#include "routing_table.h"
+#include "common/string_handling.h"
+#include "../lib/quagga/src/common.h"
+#include "../lib/quagga/src/quagga.h"
+#include "../lib/quagga/src/packet.h"
+#include "../lib/quagga/src/client.h"
+#include "../lib/quagga/src/export.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#ifdef __linux__
+
+#define ROUTES 3000
+#define BURSTS 600
+#define STEP_INTERVAL 5
+
+/* the routing table of olsrd */
+static struct rt_entry routes[ROUTES];
+static struct rt_path paths[ROUTES];
+static bool in_table[ROUTES];
+
+/* the routing table of zebra */
+struct zebra_route {
+  bool have;
+  uint32_t gateway;                    /* or the complement of the interface index */
+  uint32_t metric;
+};
+
+static struct zebra_route zebra_table[ROUTES];
+static int zebra_fd = -1;
+static unsigned char zebra_buf[1 << 16];
+static size_t zebra_len;
+static unsigned long zebra_messages;
+static bool zebra_bad;
+
+static unsigned int bursts;
+static size_t zebra_budget;
+static unsigned int idle_steps;
+
+/* apply the complete messages in the buffer */
+static void
+zebra_parse(void)
+{
+  size_t pos = 0;
+
+  while (zebra_len - pos >= 3) {
+    const unsigned char *msg = zebra_buf + pos, *p;
+    uint16_t len = (msg[0] << 8) | msg[1];
+    uint32_t prefix = 0, gateway = 0, metric = 0;
+    unsigned int idx, plen;
+
+    if (zebra_len - pos < len) {
+      break;
+    }
+    pos += len;
+    zebra_messages++;
+    if (msg[2] != ZEBRA_IPV4_ROUTE_ADD && msg[2] != ZEBRA_IPV4_ROUTE_DELETE) {
+      continue;
+    }
+
+    /* type, flags and message, the prefix, one next hop and the metric */
+    p = msg + 6;
+    plen = *p++;
+    memcpy(&prefix, p, (plen + 7) / 8);
+    p += (plen + 7) / 8;
+    idx = ntohl(prefix) & 0xffff;
+    if (plen != 32 || idx >= ROUTES || *p++ != 1) {
+      zebra_bad = true;
+      continue;
+    }
+    if (*p++ == ZEBRA_NEXTHOP_IPV4) {
+      memcpy(&gateway, p, sizeof(gateway));
+    } else {
+      memcpy(&gateway, p, sizeof(gateway));
+      gateway = ~ntohl(gateway);
+    }
+    p += sizeof(gateway);
+    memcpy(&metric, p, sizeof(metric));
+
+    if (msg[2] == ZEBRA_IPV4_ROUTE_ADD) {
+      zebra_table[idx].have = true;
+      zebra_table[idx].gateway = gateway;
+      zebra_table[idx].metric = ntohl(metric);
+    } else {
+      /* a route zebra does not have is never deleted */
+      if (!zebra_table[idx].have || zebra_table[idx].gateway != gateway) {
+        zebra_bad = true;
+      }
+      zebra_table[idx].have = false;
+    }
+  }
+
+  memmove(zebra_buf, zebra_buf + pos, zebra_len - pos);
+  zebra_len -= pos;
+}
+
+static ssize_t
+zebra_receive(size_t max)
+{
+  ssize_t n;
+
+  if (max > sizeof(zebra_buf) - zebra_len) {
+    max = sizeof(zebra_buf) - zebra_len;
+  }
+  n = read(zebra_fd, zebra_buf + zebra_len, max);
+  if (n > 0) {
+    zebra_len += n;
+    zebra_parse();
+  }
+  return n;
+}
+
+/* a slow zebra, reads less than olsrd sends while routes change */
+static void
+zebra_ready(int fd __attribute__ ((unused)), void *data __attribute__ ((unused)), unsigned int flags __attribute__ ((unused)))
+{
+  ssize_t n;
+
+  n = zebra_receive(bursts < BURSTS ? zebra_budget : sizeof(zebra_buf));
+  if (n > 0) {
+    idle_steps = 0;
+    if (bursts < BURSTS) {
+      zebra_budget -= n;
+    }
+  }
+  if (zebra_budget == 0) {
+    disable_olsr_socket(zebra_fd, NULL, &zebra_ready, SP_IMM_READ);
+  }
+}
+
+/* zebra reads until olsrd closes the socket */
+static void *
+zebra_thread(void *arg __attribute__ ((unused)))
+{
+  while (zebra_receive(sizeof(zebra_buf)) > 0);
+  return NULL;
+}
+
+static void
+set_route(int i)
+{
+  uint32_t gateway = rand() % 4 ? htonl(0xc0a80000 + rand() % 8) : routes[i].rt_dst.prefix.v4.s_addr;
+
+  paths[i].rtp_nexthop.gateway.v4.s_addr = gateway;
+  paths[i].rtp_nexthop.iif_index = 3;
+  paths[i].rtp_metric.hops = rand() % 4;
+}
+
+/* a burst of route changes per step, then wait until zebra has everything */
+static void
+test_step(void *context __attribute__ ((unused)))
+{
+  int count, i;
+
+  if (bursts >= BURSTS) {
+    if (!zexport_pending() && ++idle_steps > 3) {
+      olsr_scheduler_stop();
+    }
+    return;
+  }
+  bursts++;
+
+  /* zebra reads a few hundred bytes per step */
+  zebra_budget = bursts < BURSTS ? (size_t)(rand() % 800) + 1 : sizeof(zebra_buf);
+  enable_olsr_socket(zebra_fd, NULL, &zebra_ready, SP_IMM_READ);
+
+  for (count = rand() % 50 + 1; count > 0; count--) {
+    i = rand() % ROUTES;
+    if (!in_table[i] || rand() % 3 == 0) {
+      if (!in_table[i]) {
+        avl_insert(&routingtree, &routes[i].rt_tree_node, AVL_DUP_NO);
+        in_table[i] = true;
+      }
+      set_route(i);
+      zebra_addroute(&routes[i]);
+      routes[i].rt_nexthop = paths[i].rtp_nexthop;
+    } else {
+      zebra_delroute(&routes[i]);
+      avl_delete(&routingtree, &routes[i].rt_tree_node);
+      in_table[i] = false;
+    }
+  }
+}
+
+static void
+check_tables(void)
+{
+  int i;
+
+  CHECK(!zebra_bad);
+  for (i = 0; i < ROUTES; i++) {
+    uint32_t gateway = paths[i].rtp_nexthop.gateway.v4.s_addr;
+
+    CHECK(zebra_table[i].have == in_table[i]);
+    if (!in_table[i] || !zebra_table[i].have) {
+      continue;
+    }
+    if (gateway == routes[i].rt_dst.prefix.v4.s_addr) {
+      /* a direct route goes through the interface */
+      gateway = ~paths[i].rtp_nexthop.iif_index;
+    }
+    CHECK(zebra_table[i].gateway == gateway);
+    CHECK(zebra_table[i].metric == paths[i].rtp_metric.hops);
+  }
+}
+
+int
+main(void)
+{
+  char dir[] = "/tmp/olsrd_test_XXXXXX";
+  struct sockaddr_un addr;
+  pthread_t thread;
+  int listen_fd, size = 4096, i, n;
+
+  harness_init(AF_INET);
+  olsr_cnf->pollrate = 0.001;
+  harness_init_tables(NULL);
+  srand(1);
+
+  CHECK(mkdtemp(dir) != NULL);
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  snprintf(addr.sun_path, sizeof(addr.sun_path), "%s/zserv.api", dir);
+  listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  CHECK(listen_fd >= 0);
+  CHECK(bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) == 0);
+  CHECK(listen(listen_fd, 1) == 0);
+
+  zebra_init();
+  free(zebra.sockpath);
+  zebra.sockpath = strdup(addr.sun_path);
+  zebra.options = OPTION_EXPORT;
+  zebra.queue_limit = 200;
+  zexport_init();
+  zclient_reconnect();
+  CHECK(zebra.status & STATUS_CONNECTED);
+
+  zebra_fd = accept(listen_fd, NULL, NULL);
+  CHECK(zebra_fd >= 0);
+  setsockopt(zebra_fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+  setsockopt(zebra.sock, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+  fcntl(zebra_fd, F_SETFL, fcntl(zebra_fd, F_GETFL) | O_NONBLOCK);
+  add_olsr_socket(zebra_fd, NULL, &zebra_ready, NULL, SP_IMM_READ);
+
+  for (i = 0; i < ROUTES; i++) {
+    routes[i].rt_dst.prefix.v4.s_addr = htonl(0x0a000000 + i);
+    routes[i].rt_dst.prefix_len = 32;
+    routes[i].rt_tree_node.key = &routes[i].rt_dst;
+    routes[i].rt_best = &paths[i];
+  }
+
+  olsr_start_timer(STEP_INTERVAL, 0, OLSR_TIMER_PERIODIC, &test_step, NULL, NULL);
+  olsr_scheduler();
+  remove_olsr_socket(zebra_fd, NULL, &zebra_ready);
+
+  printf("%lu messages, %lu routes sent, %lu coalesced, %lu overflows, %lu resyncs, queued max %u, latency max %u ms\n",
+         zebra_messages, zexport_stats.sent, zexport_stats.coalesced, zexport_stats.overflows, zexport_stats.resyncs,
+         zexport_stats.queued_max, zexport_stats.latency_max);
+  check_tables();
+
+  /* the queue overflowed and was resynced, changes were merged */
+  CHECK(zexport_stats.overflows > 0);
+  CHECK(zexport_stats.resyncs > zexport_stats.overflows);
+  CHECK(zexport_stats.coalesced > 0);
+
+  /* unloading deletes all routes from zebra, blocking */
+  fcntl(zebra_fd, F_SETFL, fcntl(zebra_fd, F_GETFL) & ~O_NONBLOCK);
+  CHECK(pthread_create(&thread, NULL, &zebra_thread, NULL) == 0);
+  zebra_fini();
+  shutdown(zebra.sock, SHUT_WR);
+  pthread_join(thread, NULL);
+
+  for (i = 0, n = 0; i < ROUTES; i++) {
+    n += zebra_table[i].have;
+  }
+  CHECK(n == 0);
+  CHECK(!zebra_bad);
+
+  /* a resync after reconnecting skips routes without a best path */
+  for (i = 0; !in_table[i]; i++);
+  routes[i].rt_best = NULL;
+  close(zebra_fd);
+  zebra_len = 0;
+  zclient_reconnect();
+  CHECK(zebra.status & STATUS_CONNECTED);
+  zebra_fd = accept(listen_fd, NULL, NULL);
+  CHECK(zebra_fd >= 0);
+  CHECK(pthread_create(&thread, NULL, &zebra_thread, NULL) == 0);
+  zclient_flush();
+  CHECK(zebra.status & STATUS_CONNECTED);
+  shutdown(zebra.sock, SHUT_WR);
+  pthread_join(thread, NULL);
+
+  for (i = 0; i < ROUTES; i++) {
+    CHECK(zebra_table[i].have == (in_table[i] && routes[i].rt_best));
+  }
+  CHECK(!zebra_bad);
+
+  /* a full output buffer delays control messages, zebra not reading drops the connection */
+  close(zebra_fd);
+  zclient_reconnect();
+  CHECK(zebra.status & STATUS_CONNECTED);
+  zebra_fd = accept(listen_fd, NULL, NULL);
+  CHECK(zebra_fd >= 0);
+  setsockopt(zebra.sock, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+  {
+    unsigned char buf[ZEBRA_MAX_PACKET_SIZ];
+    uint16_t len = zpacket_redistribute(buf, ZEBRA_HELLO, ZEBRA_ROUTE_OLSR);
+    uint64_t start;
+
+    for (n = 0; zclient_write(buf, len) == 0 && n < (1 << 16); n++);
+    CHECK(n < (1 << 16));
+
+    start = harness_clock_ns();
+    zebra_hello(ZEBRA_HELLO);
+    CHECK(!(zebra.status & STATUS_CONNECTED));
+    CHECK(harness_clock_ns() - start < 3000000000ULL);
+  }
+
+  close(zebra_fd);
+  close(listen_fd);
+  unlink(addr.sun_path);
+  rmdir(dir);
+
+  return harness_result("test_quagga_export");
+}
+
+#else /* __linux__ */
+
+int
+main(void)
+{
+  printf("test_quagga_export: skipped\n");
+  return 0;
+}
+
+#endif /* __linux__ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
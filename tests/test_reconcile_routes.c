@@ -0,0 +1,263 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Test of the reconciliation of the kernel FIB with the RIB, see
+ * olsr_reconcile_kernel_route_list().
+ */
+
+#include "harness.h"
+#include "olsr.h"
+#include "interfaces.h"
+#include "link_set.h"
+#include "tc_set.h"
+#include "routing_table.h"
+#include "process_routes.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+
+#define MAX_OPS 32
+
+struct route_op {
+  char op;                    /* 'a'dd or 'd'elete */
+  uint32_t dst;
+  uint32_t gateway;
+};
+
+static struct route_op ops[MAX_OPS];
+static unsigned int op_count;
+
+static struct interface_olsr iface;
+
+static int
+record_add(const struct rt_entry *rt)
+{
+  if (op_count < MAX_OPS) {
+    ops[op_count].op = 'a';
+    ops[op_count].dst = ntohl(rt->rt_dst.prefix.v4.s_addr);
+    ops[op_count].gateway = ntohl(rt->rt_best->rtp_nexthop.gateway.v4.s_addr);
+  }
+  op_count++;
+  return 0;
+}
+
+static int
+record_del(const struct rt_entry *rt)
+{
+  if (op_count < MAX_OPS) {
+    ops[op_count].op = 'd';
+    ops[op_count].dst = ntohl(rt->rt_dst.prefix.v4.s_addr);
+    ops[op_count].gateway = ntohl(rt->rt_nexthop.gateway.v4.s_addr);
+  }
+  op_count++;
+  return 0;
+}
+
+/* count the recorded operations */
+static unsigned int
+count_ops(char op, uint32_t dst, uint32_t gateway)
+{
+  unsigned int i, n = 0;
+
+  for (i = 0; i < op_count && i < MAX_OPS; i++) {
+    if (ops[i].op == op && ops[i].dst == dst && ops[i].gateway == gateway) {
+      n++;
+    }
+  }
+  return n;
+}
+
+/* add a /32 RIB route via gateway */
+static struct rt_entry *
+add_rib_route(uint32_t dst, uint32_t gateway)
+{
+  struct link_entry link;
+  union olsr_ip_addr addr;
+  struct tc_entry *tc;
+  struct rt_path *rtp;
+  struct rt_entry *rt;
+
+  memset(&link, 0, sizeof(link));
+  link.neighbor_iface_addr.v4.s_addr = htonl(gateway);
+  link.inter = &iface;
+
+  addr.v4.s_addr = htonl(dst);
+  tc = olsr_locate_tc_entry(&addr);
+  tc->path_cost = 1;
+  tc->hops = 1;
+
+  rtp = olsr_insert_routing_table(&addr, 32, &addr, OLSR_RT_ORIGIN_INT);
+  olsr_insert_rt_path(rtp, tc, &link);
+
+  rt = rtp->rtp_rt;
+  olsr_rt_best(rt);
+  return rt;
+}
+
+static void
+kernel_route(struct olsr_os_route *route, uint32_t dst, uint32_t gateway, uint32_t metric)
+{
+  memset(route, 0, sizeof(*route));
+  route->dst.prefix.v4.s_addr = htonl(dst);
+  route->dst.prefix_len = 32;
+  route->gateway.v4.s_addr = htonl(gateway);
+  route->if_index = iface.if_index;
+  route->metric = metric;
+  route->table = olsr_cnf->rt_table;
+  route->protocol = olsr_cnf->rt_proto;
+}
+
+#define A 0x0a000101      /* in the kernel as in the RIB, twice */
+#define B 0x0a000102      /* in the kernel with another gateway */
+#define C 0x0a000103      /* missing in the kernel */
+#define D 0x0a000104      /* only in the kernel */
+#define E 0x0a000105      /* in the RIB without a best path */
+#define H 0x0a000106      /* held after a restart */
+#define GW1 0x0a000001
+#define GW2 0x0a000002
+
+int
+main(void)
+{
+  struct olsr_os_route kernel[6];
+  struct olsr_ip_prefix held;
+  struct rt_nexthop nexthop;
+  struct rt_metric metric;
+  struct rt_entry *rt_e;
+
+  harness_init(AF_INET);
+  olsr_cnf->main_addr.v4.s_addr = htonl(0x0a000000);
+  olsr_cnf->rt_proto = 100;
+  harness_init_tables(NULL);
+  olsr_addroute_function = record_add;
+  olsr_delroute_function = record_del;
+
+  memset(&iface, 0, sizeof(iface));
+  iface.if_index = 7;
+
+  add_rib_route(A, GW1);
+  add_rib_route(B, GW1);
+  add_rib_route(C, GW1);
+  rt_e = add_rib_route(E, GW1);
+  rt_e->rt_best = NULL;
+
+  memset(&held, 0, sizeof(held));
+  held.prefix.v4.s_addr = htonl(H);
+  held.prefix_len = 32;
+  memset(&nexthop, 0, sizeof(nexthop));
+  nexthop.gateway.v4.s_addr = htonl(GW1);
+  nexthop.iif_index = iface.if_index;
+  memset(&metric, 0, sizeof(metric));
+  CHECK(olsr_hold_kernel_route(&held, &nexthop, &metric) != NULL);
+
+  /* the duplicate of A comes first, the dump is not ordered */
+  kernel_route(&kernel[0], A, GW2, 5);
+  kernel_route(&kernel[1], D, GW1, 2);
+  kernel_route(&kernel[2], A, GW1, 2);
+  kernel_route(&kernel[3], B, GW2, 2);
+  kernel_route(&kernel[4], E, GW1, 2);
+  kernel_route(&kernel[5], H, GW1, 2);
+
+  op_count = 0;
+  olsr_reconcile_kernel_route_list(kernel, ARRAYSIZE(kernel));
+
+  /* A: the duplicate is removed, the matching route is kept */
+  CHECK(count_ops('d', A, GW2) == 1);
+  CHECK(count_ops('d', A, GW1) == 0);
+  CHECK(count_ops('a', A, GW1) == 0);
+
+  /* B: rewritten */
+  CHECK(count_ops('d', B, GW2) == 1);
+  CHECK(count_ops('a', B, GW1) == 1);
+
+  /* C: added */
+  CHECK(count_ops('a', C, GW1) == 1);
+
+  /* D: removed */
+  CHECK(count_ops('d', D, GW1) == 1);
+
+  /* E: no best path, removed and not added */
+  CHECK(count_ops('d', E, GW1) == 1);
+  CHECK(rt_e->rt_nexthop.iif_index == -1);
+
+  /* H: held for adoption */
+  CHECK(count_ops('d', H, GW1) == 0);
+
+  CHECK(op_count == 6);
+
+  /* a second run against the fixed kernel table changes nothing */
+  kernel_route(&kernel[0], A, GW1, 2);
+  kernel_route(&kernel[1], B, GW1, 2);
+  kernel_route(&kernel[2], C, GW1, 2);
+  kernel_route(&kernel[3], H, GW1, 2);
+
+  op_count = 0;
+  olsr_reconcile_kernel_route_list(kernel, 4);
+  CHECK(op_count == 0);
+
+  return harness_result("test_reconcile_routes");
+}
+
+#else /* __linux__ */
+
+int
+main(void)
+{
+  printf("test_reconcile_routes: skipped, the kernel FIB is only read on Linux\n");
+  return EXIT_SUCCESS;
+}
+
+#endif /* __linux__ */
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
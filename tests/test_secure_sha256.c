@@ -0,0 +1,220 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Test of SHA-256 and HMAC-SHA256 of the secure plugin against the
+ * FIPS 180-2 and RFC 4231 test vectors, with the plain C block
+ * transform and with the one the CPU selects. Built with
+ * USE_OPENSSL=1, random messages and keys are also compared with
+ * OpenSSL.
+ *
+ * sha256.c is included to reach its static block transforms.
+ */
+
+#include "harness.h"
+#include "../lib/secure/src/sha256.c"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef USE_OPENSSL
+#include <openssl/evp.h>
+#include <openssl/hmac.h>
+#include <openssl/sha.h>
+
+#define RANDOM_ROUNDS 20000
+#endif /* USE_OPENSSL */
+
+struct sha256_vector {
+  const char *message;
+  unsigned int repeat;
+  const char *digest;
+};
+
+struct hmac_vector {
+  unsigned char key_byte;              /* the key is this byte repeated, or the string below */
+  unsigned int key_len;
+  const char *key;
+  const char *message;
+  const char *mac;
+};
+
+static const struct sha256_vector sha256_vectors[] = {
+  { "", 1, "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855" },
+  { "abc", 1, "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad" },
+  { "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", 1,
+    "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1" },
+  { "a", 1000000, "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0" }
+};
+
+/* RFC 4231 test cases 1, 2 and 6 */
+static const struct hmac_vector hmac_vectors[] = {
+  { 0x0b, 20, NULL, "Hi There", "b0344c61d8db38535ca8afceaf0bf12b881dc200c9833da726e9376c2e32cff7" },
+  { 0, 4, "Jefe", "what do ya want for nothing?", "5bdcc146bf60754e6a042426089575c75a003f089d2739839dec58b964ec3843" },
+  { 0xaa, 131, NULL, "Test Using Larger Than Block-Size Key - Hash Key First",
+    "60e431591ee0b67f0d8a26aacbf5b77f8e0bc6213728c5140546040f0ee37f54" }
+};
+
+static bool
+same_digest(const unsigned char *digest, const char *hex)
+{
+  char text[2 * SHA256_DIGEST_LENGTH_BYTES + 1];
+  int i;
+
+  for (i = 0; i < SHA256_DIGEST_LENGTH_BYTES; i++) {
+    snprintf(&text[2 * i], 3, "%02x", digest[i]);
+  }
+  return strcmp(text, hex) == 0;
+}
+
+static void
+check_vectors(void)
+{
+  unsigned char digest[SHA256_DIGEST_LENGTH_BYTES], key[256];
+  SHA256_CONTEXT context;
+  HMAC_SHA256_KEY hmac;
+  unsigned int i, j;
+
+  for (i = 0; i < sizeof(sha256_vectors) / sizeof(sha256_vectors[0]); i++) {
+    const struct sha256_vector *v = &sha256_vectors[i];
+
+    SHA256Init(&context);
+    for (j = 0; j < v->repeat; j++) {
+      SHA256Update(&context, (const unsigned char *)v->message, strlen(v->message));
+    }
+    SHA256Final(digest, &context);
+    CHECK(same_digest(digest, v->digest));
+  }
+
+  for (i = 0; i < sizeof(hmac_vectors) / sizeof(hmac_vectors[0]); i++) {
+    const struct hmac_vector *v = &hmac_vectors[i];
+
+    if (v->key != NULL) {
+      memcpy(key, v->key, v->key_len);
+    } else {
+      memset(key, v->key_byte, v->key_len);
+    }
+    HMACSHA256Init(&hmac, key, v->key_len);
+    HMACSHA256(&hmac, (const unsigned char *)v->message, strlen(v->message), digest);
+    CHECK(same_digest(digest, v->mac));
+  }
+}
+
+#ifdef USE_OPENSSL
+/* random messages, hashed in random pieces, and random keys */
+static void
+check_openssl(void)
+{
+  unsigned char message[1024], key[160], digest[SHA256_DIGEST_LENGTH_BYTES], expected[SHA256_DIGEST_LENGTH_BYTES];
+  SHA256_CONTEXT context;
+  HMAC_SHA256_KEY hmac;
+  unsigned int expected_len;
+  int round;
+
+  srand(1);
+  for (round = 0; round < RANDOM_ROUNDS; round++) {
+    unsigned int len = rand() % sizeof(message), key_len = rand() % sizeof(key) + 1, done, i;
+
+    for (i = 0; i < len; i++) {
+      message[i] = rand();
+    }
+    for (i = 0; i < key_len; i++) {
+      key[i] = rand();
+    }
+
+    SHA256Init(&context);
+    for (done = 0; done < len; done += i) {
+      i = rand() % (len - done + 1);
+      SHA256Update(&context, message + done, i);
+    }
+    SHA256Final(digest, &context);
+    SHA256(message, len, expected);
+    CHECK(memcmp(digest, expected, sizeof(digest)) == 0);
+
+    HMACSHA256Init(&hmac, key, key_len);
+    HMACSHA256(&hmac, message, len, digest);
+    HMAC(EVP_sha256(), key, key_len, message, len, expected, &expected_len);
+    CHECK(expected_len == sizeof(digest) && memcmp(digest, expected, sizeof(digest)) == 0);
+  }
+}
+#endif /* USE_OPENSSL */
+
+static void
+check_transform(sha256_transform_func transform, const char *name)
+{
+  SHA256Transform = transform;
+  check_vectors();
+#ifdef USE_OPENSSL
+  check_openssl();
+  printf("%s transform: test vectors and %d random messages and keys match OpenSSL\n", name, RANDOM_ROUNDS);
+#else /* USE_OPENSSL */
+  printf("%s transform: test vectors match\n", name);
+#endif /* USE_OPENSSL */
+}
+
+int
+main(void)
+{
+  sha256_transform_func selected;
+  const char *name;
+
+  name = SHA256Implementation();
+  selected = SHA256Transform;
+
+  check_transform(&SHA256TransformC, "C");
+  if (selected != &SHA256TransformC) {
+    check_transform(selected, name);
+  }
+
+  return harness_result("test_secure_sha256");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */
@@ -0,0 +1,291 @@
+/*
+ * The olsr.org Optimized Link-State Routing daemon (olsrd)
+ *
+ * (c) by the OLSR project
+ *
+ * See our Git repository to find out who worked on this file
+ * and thus is a copyright holder on it.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * * Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * * Neither the name of olsr.org, olsrd nor the names of its
+ *   contributors may be used to endorse or promote products derived
+ *   from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Visit http://www.olsr.org for more information.
+ *
+ * If you find this software useful feel free to make a donation
+ * to the project. For more information see the website or contact
+ * the copyright holders.
+ *
+ */
+
+
+/*
+ * Test of olsr_spf_tc_edge_changes_relevant(): random TC changes are
+ * applied to a small mesh, SPF is run after each one. Whenever the
+ * changes were considered irrelevant, SPF must not change any path.
+ */
+
+#include "harness.h"
+#include "olsr.h"
+#include "olsr_spf.h"
+#include "interfaces.h"
+#include "link_set.h"
+#include "lq_packet.h"
+#include "lq_plugin.h"
+#include "process_package.h"
+#include "tc_set.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define NODES 24
+#define ITERATIONS 4000
+
+/* addresses of ourselves (index 0) and of the other nodes */
+#define NODE_ADDR(idx) (0x0a000001 + (idx))
+
+/* the only 1-hop neighbor */
+#define NEIGHBOR 1
+
+struct node_path {
+  olsr_linkcost path_cost;
+  struct link_entry *next_hop;
+  unsigned int hops;
+};
+
+static struct interface_olsr iface;
+static char iface_name[] = "eth0";
+
+/* the neighbor set advertised by every node */
+static bool advertised[NODES + 1][NODES + 1];
+static uint8_t advertised_lq[NODES + 1][NODES + 1];
+static uint16_t tc_seq[NODES + 1];
+
+static void
+node_addr(union olsr_ip_addr *addr, int idx)
+{
+  memset(addr, 0, sizeof(*addr));
+  addr->v4.s_addr = htonl(NODE_ADDR(idx));
+}
+
+static uint8_t
+random_lq(void)
+{
+  static const uint8_t lq[] = { 255, 255, 240, 200, 128, 64, 0 };
+
+  return lq[rand() % (sizeof(lq) / sizeof(lq[0]))];
+}
+
+/* make the neighbor symmetric with a HELLO that lists our interface */
+static void
+input_hello(void)
+{
+  uint8_t msg[64];
+  union olsr_ip_addr from;
+  unsigned int size = 16 + 4 + olsr_cnf->ipsize + olsr_sizeof_hello_lqdata();
+  int i;
+
+  node_addr(&from, NEIGHBOR);
+  memset(msg, 0, sizeof(msg));
+  msg[0] = LQ_HELLO_MESSAGE;
+  msg[1] = 0xe8;
+  msg[2] = size >> 8;
+  msg[3] = size & 0xff;
+  memcpy(msg + 4, &from, olsr_cnf->ipsize);
+  msg[8] = 1;
+  msg[14] = 0x86;
+  msg[15] = WILL_DEFAULT;
+  msg[16] = CREATE_LINK_CODE(SYM_NEIGH, SYM_LINK);
+  msg[19] = size - 16;
+  memcpy(msg + 20, &iface.ip_addr, olsr_cnf->ipsize);
+  msg[24] = 255;
+  msg[25] = 255;
+
+  olsr_input_hello((union olsr_message *)msg, &iface, &from);
+
+  /* a link without received packets is broken */
+  for (i = 0; i < 32; i++) {
+    olsr_update_packet_loss_worker(lookup_link_entry(&from, NULL, &iface), false);
+  }
+}
+
+/* send the current neighbor set of a node as LQ_TC */
+static void
+input_tc(int idx)
+{
+  uint8_t msg[16 + (NODES + 1) * 8];
+  union olsr_ip_addr originator, from;
+  unsigned int size = 16;
+  int j;
+
+  node_addr(&originator, idx);
+  node_addr(&from, NEIGHBOR);
+  memset(msg, 0, sizeof(msg));
+  msg[0] = LQ_TC_MESSAGE;
+  msg[1] = 0xe8;
+  memcpy(msg + 4, &originator, olsr_cnf->ipsize);
+  msg[8] = 255;
+  msg[10] = tc_seq[idx] >> 8;
+  msg[11] = tc_seq[idx] & 0xff;
+  msg[12] = tc_seq[idx] >> 8;
+  msg[13] = tc_seq[idx] & 0xff;
+  tc_seq[idx]++;
+
+  for (j = 0; j <= NODES; j++) {
+    union olsr_ip_addr addr;
+
+    if (!advertised[idx][j]) {
+      continue;
+    }
+    node_addr(&addr, j);
+    memcpy(msg + size, &addr, olsr_cnf->ipsize);
+    msg[size + olsr_cnf->ipsize] = advertised_lq[idx][j];
+    msg[size + olsr_cnf->ipsize + 1] = advertised_lq[idx][j];
+    size += olsr_cnf->ipsize + olsr_sizeof_tc_lqdata();
+  }
+  msg[2] = size >> 8;
+  msg[3] = size & 0xff;
+
+  olsr_input_tc((union olsr_message *)msg, &iface, &from);
+}
+
+static void
+get_paths(struct node_path *paths)
+{
+  int i;
+
+  for (i = 0; i <= NODES; i++) {
+    union olsr_ip_addr addr;
+    struct tc_entry *tc;
+
+    node_addr(&addr, i);
+    tc = olsr_lookup_tc_entry(&addr);
+
+    paths[i].path_cost = tc ? tc->path_cost : ROUTE_COST_BROKEN;
+    paths[i].next_hop = tc ? tc->next_hop : NULL;
+    paths[i].hops = tc ? tc->hops : 0;
+  }
+}
+
+static void
+run_spf(void)
+{
+  olsr_calculate_routing_table(true);
+  changes_neighborhood = false;
+  changes_topology = false;
+  changes_hna = false;
+  changes_tc_edges = false;
+}
+
+int
+main(void)
+{
+  struct node_path before[NODES + 1], after[NODES + 1];
+  union olsr_ip_addr neighbor;
+  unsigned int skipped = 0, relevant = 0;
+  int i, j, iter;
+
+  harness_init(AF_INET);
+  node_addr(&olsr_cnf->main_addr, 0);
+  olsr_cnf->use_hysteresis = false;
+  harness_init_tables("etx_float");
+
+  memset(&iface, 0, sizeof(iface));
+  node_addr(&iface.ip_addr, 0);
+  iface.int_name = iface_name;
+  iface.mode = IF_MODE_MESH;
+  ifnet = &iface;
+
+  input_hello();
+  CHECK(check_neighbor_link(&iface.ip_addr) == UNSPEC_LINK);
+  node_addr(&neighbor, NEIGHBOR);
+  CHECK(check_neighbor_link(&neighbor) == SYM_LINK);
+
+  srand(1);
+  advertised[NEIGHBOR][0] = true;
+  advertised_lq[NEIGHBOR][0] = 255;
+  for (i = 1; i <= NODES; i++) {
+    for (j = 1; j <= NODES; j++) {
+      if (i != j && rand() % 6 == 0) {
+        advertised[i][j] = true;
+        advertised_lq[i][j] = random_lq();
+      }
+    }
+    input_tc(i);
+  }
+  run_spf();
+
+  for (iter = 0; iter < ITERATIONS; iter++) {
+    bool spf_needed;
+    int changes = rand() % 3;
+
+    i = 1 + rand() % NODES;
+    while (changes-- > 0) {
+      j = 1 + rand() % NODES;
+      if (j == i) {
+        continue;
+      }
+      if (advertised[i][j] && rand() % 3 == 0) {
+        advertised[i][j] = false;
+      } else {
+        advertised[i][j] = true;
+        advertised_lq[i][j] = random_lq();
+      }
+    }
+    input_tc(i);
+
+    spf_needed = changes_tc_edges && olsr_spf_tc_edge_changes_relevant();
+    get_paths(before);
+    run_spf();
+    get_paths(after);
+
+    if (spf_needed) {
+      relevant++;
+    } else {
+      skipped++;
+      for (j = 0; j <= NODES; j++) {
+        CHECK(before[j].path_cost == after[j].path_cost);
+        CHECK(before[j].next_hop == after[j].next_hop);
+        CHECK(before[j].hops == after[j].hops);
+      }
+    }
+  }
+
+  /* both decisions have been taken */
+  CHECK(skipped > 0);
+  CHECK(relevant > 0);
+
+  return harness_result("test_spf_skip");
+}
+
+/*
+ * Local Variables:
+ * c-basic-offset: 2
+ * indent-tabs-mode: nil
+ * End:
+ */